@@ -116,7 +116,7 @@ function copyreleasefiles {
   # bdj4se is only used for packaging
   # testing:
   #   aesed, check_all, chkprocess, chkfileshared, dmkmfromdb
-  #   tdbcompare, tdbsetval, testsuite, tmusicsetup, ttagdbchk
+  #   tdbcompare, tdbsetval, testsuite, tmusicsetup, tsrvbench, ttagdbchk
   #   dbustest, plisinklist, voltest, vsencdec, uitest
   # img/profile[1-9] may be left over from testing
   # 2024-1-16 do not ship the pli-mpv interface either.
@@ -143,6 +143,7 @@ function copyreleasefiles {
       ${stage}/bin/tdbsetval* \
       ${stage}/bin/testsuite* \
       ${stage}/bin/tmusicsetup* \
+      ${stage}/bin/tsrvbench* \
       ${stage}/bin/ttagdbchk* \
       ${stage}/bin/uitest* \
       ${stage}/bin/voltest* \
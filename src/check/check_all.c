@@ -67,9 +67,14 @@ main (int argc, char *argv [])
   }
   check_libcommon (sr);
   check_libbasic (sr);
+  check_libwebsrv (sr);
   check_libwebclient (sr);
   check_libaudiosrc (sr);
+  check_libaudioid (sr);
   check_libbdj4 (sr);
+#if BDJ4_CHK_GSTI
+  check_libpli (sr);
+#endif
   /* if the durations are needed */
   srunner_set_xml (sr, "tmp/check.xml");
   // srunner_set_log (sr, "tmp/check.log");
@@ -16,7 +16,10 @@ void check_libcommon (SRunner *sr);
 void check_libbasic (SRunner *sr);
 void check_libbdj4 (SRunner *sr);
 void check_libaudiosrc (SRunner *sr);
+void check_libaudioid (SRunner *sr);
+void check_libwebsrv (SRunner *sr);
 void check_libwebclient (SRunner *sr);
+void check_libpli (SRunner *sr);
 
 /* libcommon */
 Suite *     bdjmsg_suite (void);
@@ -53,6 +56,7 @@ Suite *     tmutil_suite (void);
 Suite *     vsencdec_suite (void);
 
 /* libbasic */
+Suite *     ascache_suite (void);
 Suite *     bdjopt_suite (void);
 Suite *     datafile_suite (void);
 Suite *     dirlist_suite (void);
@@ -68,7 +72,9 @@ Suite *     asconf_suite (void);
 Suite *     autosel_suite (void);
 Suite *     bdjvarsdf_suite (void);
 Suite *     bdjvarsdfload_suite (void);
+Suite *     bpmdetect_suite (void);
 Suite *     dancesel_suite (void);
+Suite *     dbmanifest_suite (void);
 Suite *     dispsel_suite (void);
 Suite *     dnctypes_suite (void);
 Suite *     dance_suite (void);
@@ -87,8 +93,10 @@ Suite *     samesong_suite (void);
 Suite *     sequence_suite (void);
 Suite *     song_suite (void);
 Suite *     songfav_suite (void);
+Suite *     songdb_suite (void);
 Suite *     songfilter_suite (void);
 Suite *     songlist_suite (void);
+Suite *     songlistidx_suite (void);
 Suite *     songutil_suite (void);
 Suite *     sortopt_suite (void);
 Suite *     status_suite (void);
@@ -98,7 +106,19 @@ Suite *     validate_suite (void);
 Suite *     volreg_suite (void);
 
 /* libaudiosrc */
+Suite *     asbdj4_suite (void);
 Suite *     audiosrc_suite (void);
+Suite *     rss_suite (void);
+
+/* libaudioid */
+Suite *     audioid_suite (void);
+Suite *     audioidcache_suite (void);
+
+/* libwebsrv */
+Suite *     websrv_suite (void);
 
 /* libwebclient */
 Suite *     webclient_suite (void);
+
+/* libpli */
+Suite *     gsti_suite (void);
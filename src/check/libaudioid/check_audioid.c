@@ -0,0 +1,589 @@
+/*
+ * Copyright 2023-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#if __has_include (<pthread.h>)
+# include <pthread.h>
+#endif
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "audioid.h"
+#include "audiosrc.h"
+#include "bdj4.h"
+#include "bdjopt.h"
+#include "bdjvars.h"
+#include "check_bdj.h"
+#include "dirop.h"
+#include "fileop.h"
+#include "log.h"
+#include "mdebug.h"
+#include "nlist.h"
+#include "song.h"
+#include "sysvars.h"
+#include "tagdef.h"
+#include "webresp.h"
+#include "websrv.h"
+
+#if _lib_pthread_create
+
+enum {
+  AUID_PORT = 32732,
+};
+
+#define AUID_DIR  "tmp/audioid-chk"
+#define AUID_NOFP_FN  "tmp/audioid-nofp.mp3"
+
+/* the responses are recorded from the services, and trimmed */
+
+#define AUID_ACOUSTID_RESULT(t,a) \
+    "<results><result>" \
+    "<id>9ff43b6a-4f16-427c-93c2-92307ca505e" a "</id>" \
+    "<score>0.962138</score>" \
+    "<recordings><recording>" \
+    "<id>b3015bab-1540-4d4e-9f30-14872a1525f" a "</id>" \
+    "<releases><release>" \
+    "<title>Album " t "</title>" \
+    "<date><year>2005</year><month>3</month></date>" \
+    "<medium_count>1</medium_count>" \
+    "<mediums><medium>" \
+    "<position>1</position><track_count>12</track_count>" \
+    "<tracks><track><position>3</position>" \
+    "<title>Title " t "</title>" \
+    "<artists><artist><name>Artist " t "</name></artist></artists>" \
+    "</track></tracks>" \
+    "</medium></mediums>" \
+    "</release></releases>" \
+    "</recording></recordings>" \
+    "</result></results>"
+
+/* the fingerprints are not necessarily returned in order */
+#define AUID_ACOUSTID_BATCH \
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
+    "<response><status>ok</status><fingerprints>" \
+    "<fingerprint><index>1</index>" \
+    AUID_ACOUSTID_RESULT("B","2") \
+    "</fingerprint>" \
+    "<fingerprint><index>0</index>" \
+    AUID_ACOUSTID_RESULT("A","1") \
+    "</fingerprint>" \
+    "<fingerprint><index>2</index><results></results></fingerprint>" \
+    "</fingerprints></response>\n"
+
+#define AUID_ACOUSTID_SINGLE \
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
+    "<response><status>ok</status>" \
+    AUID_ACOUSTID_RESULT("D","4") \
+    "</response>\n"
+
+#define AUID_ACOUSTID_ERROR \
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
+    "<response><status>error</status>" \
+    "<error><code>4</code><message>invalid API key</message></error>" \
+    "</response>\n"
+
+#define AUID_MB \
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
+    "<metadata xmlns=\"http://musicbrainz.org/ns/mmd-2.0#\">" \
+    "<recording id=\"b3015bab-1540-4d4e-9f30-14872a1525f1\">" \
+    "<title>Title MB</title><length>180400</length>" \
+    "<artist-credit><name-credit><artist id=\"1\">" \
+    "<name>Artist MB</name><sort-name>MB, Artist</sort-name>" \
+    "</artist></name-credit></artist-credit>" \
+    "<release-list count=\"1\"><release id=\"2\">" \
+    "<title>Album MB</title><date>2005-03-01</date>" \
+    "<medium-list count=\"1\"><medium><position>1</position>" \
+    "<track-list count=\"12\" offset=\"2\"><track id=\"3\">" \
+    "<position>3</position><title>Title MB</title><length>180400</length>" \
+    "</track></track-list></medium></medium-list>" \
+    "</release></release-list>" \
+    "</recording></metadata>\n"
+
+typedef struct {
+  const char  *fn;
+  const char  *fp;
+  int64_t     dur;
+} chkauidsong_t;
+
+static chkauidsong_t songs [] = {
+  { "tmp/audioid-a.mp3", "AQADtEmUSEkSJYmSJEmSHMl", 180400 },
+  { "tmp/audioid-b.mp3", "AQADtEmUSEkSJYmSJEmSHMm", 200000 },
+  { "tmp/audioid-c.mp3", "AQADtEmUSEkSJYmSJEmSHMn", 190000 },
+  { "tmp/audioid-d.mp3", "AQADtEmUSEkSJYmSJEmSHMo", 170000 },
+};
+enum {
+  songsz = sizeof (songs) / sizeof (chkauidsong_t),
+};
+
+typedef struct {
+  int     idx [5];
+  int     count;
+} chkauidbatch_t;
+
+static void checkAudioIdHandler (void *udata, const char *query, const char *uri);
+static void *checkAudioIdServer (void *arg);
+static audioidcache_t *checkAudioIdCache (void);
+static song_t *checkAudioIdSong (int idx);
+static audioid_resp_t *checkAudioIdRespAlloc (void);
+static void checkAudioIdRespFree (audioid_resp_t *resp);
+static bool checkAudioIdHasTitle (audioid_resp_t *resp, const char *title);
+static void checkAudioIdBatchCB (void *udata, int idx, const char *data, size_t len);
+
+static websrv_t         *gwebsrv = NULL;
+static _Atomic(bool)    gstop = false;
+static _Atomic(int)     gacoustidreq = 0;
+static _Atomic(int)     gmbreq = 0;
+static _Atomic(int)     gbusy = 0;
+static const char       *gacoustidresp = AUID_ACOUSTID_BATCH;
+static pthread_t        gthread;
+
+static void
+setup (void)
+{
+  FILE    *fh;
+  char    tbuff [200];
+
+  bdjoptInit ();
+  bdjoptSetStr (OPT_M_DIR_MUSIC, sysvarsGetStr (SV_BDJ4_DIR_DATATOP));
+  bdjoptSetStr (OPT_G_ACOUSTID_KEY, "chk-key");
+  snprintf (tbuff, sizeof (tbuff), "http://localhost:%d/v2/lookup", AUID_PORT);
+  bdjoptSetStr (OPT_URI_AUID_ACOUSTID, tbuff);
+  snprintf (tbuff, sizeof (tbuff), "http://localhost:%d/ws/2", AUID_PORT);
+  bdjoptSetStr (OPT_URI_AUID_MUSICBRAINZ, tbuff);
+  bdjvarsInit ();
+  audiosrcInit ();
+  audiosrcPostInit ();
+  audioidParseXMLInit ();
+
+  for (int i = 0; i < songsz; ++i) {
+    fh = fileopOpen (songs [i].fn, "w");
+    ck_assert_ptr_nonnull (fh);
+    fputs (songs [i].fp, fh);
+    mdextfclose (fh);
+    fclose (fh);
+  }
+
+  gstop = false;
+  gwebsrv = websrvInit (AUID_PORT, checkAudioIdHandler, NULL, WEBSRV_TLS_OFF);
+  pthread_create (&gthread, NULL, checkAudioIdServer, NULL);
+}
+
+static void
+teardown (void)
+{
+  gstop = true;
+  pthread_join (gthread, NULL);
+  websrvFree (gwebsrv);
+  gwebsrv = NULL;
+
+  for (int i = 0; i < songsz; ++i) {
+    fileopDelete (songs [i].fn);
+  }
+  diropDeleteDir (AUID_DIR, DIROP_ALL);
+
+  audioidParseXMLCleanup ();
+  audiosrcCleanup ();
+  bdjvarsCleanup ();
+  bdjoptCleanup ();
+}
+
+static void
+setupeach (void)
+{
+  diropDeleteDir (AUID_DIR, DIROP_ALL);
+  gacoustidreq = 0;
+  gmbreq = 0;
+  gbusy = 0;
+  gacoustidresp = AUID_ACOUSTID_BATCH;
+}
+
+START_TEST(audioid_xml_batch)
+{
+  chkauidbatch_t  batch;
+  int             count;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- audioid_xml_batch");
+  mdebugSubTag ("audioid_xml_batch");
+
+  batch.count = 0;
+  count = audioidParseXMLBatch (AUID_ACOUSTID_BATCH,
+      strlen (AUID_ACOUSTID_BATCH), checkAudioIdBatchCB, &batch);
+  ck_assert_int_eq (count, 3);
+  ck_assert_int_eq (batch.count, 3);
+  ck_assert_int_eq (batch.idx [0], 1);
+  ck_assert_int_eq (batch.idx [1], 0);
+  ck_assert_int_eq (batch.idx [2], 2);
+
+  /* a single lookup response is not split */
+  batch.count = 0;
+  count = audioidParseXMLBatch (AUID_ACOUSTID_SINGLE,
+      strlen (AUID_ACOUSTID_SINGLE), checkAudioIdBatchCB, &batch);
+  ck_assert_int_eq (count, 0);
+  ck_assert_int_eq (batch.count, 0);
+
+  count = audioidParseXMLBatch (AUID_ACOUSTID_ERROR,
+      strlen (AUID_ACOUSTID_ERROR), checkAudioIdBatchCB, &batch);
+  ck_assert_int_eq (count, -1);
+  ck_assert_int_eq (batch.count, 0);
+}
+END_TEST
+
+START_TEST(audioid_acoustid_batch)
+{
+  audioidcache_t    *cache;
+  audioidacoustid_t *acoustid;
+  audioid_resp_t    *resp;
+  song_t            *song;
+  int               count;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- audioid_acoustid_batch");
+  mdebugSubTag ("audioid_acoustid_batch");
+
+  cache = checkAudioIdCache ();
+  acoustid = acoustidInit (cache);
+
+  /* the current song and the two upcoming songs are sent together */
+  acoustidPrefetchAdd (acoustid, songs [1].fn, songs [1].dur);
+  acoustidPrefetchAdd (acoustid, songs [2].fn, songs [2].dur);
+
+  resp = checkAudioIdRespAlloc ();
+  song = checkAudioIdSong (0);
+  count = acoustidLookup (acoustid, song, resp);
+  ck_assert_int_gt (count, 0);
+  ck_assert_int_eq (gacoustidreq, 1);
+  ck_assert_int_eq (checkAudioIdHasTitle (resp, "Title A"), true);
+  ck_assert_int_eq (checkAudioIdHasTitle (resp, "Title B"), false);
+  songFree (song);
+  checkAudioIdRespFree (resp);
+
+  /* the prefetched songs are in the cache */
+  resp = checkAudioIdRespAlloc ();
+  song = checkAudioIdSong (1);
+  count = acoustidLookup (acoustid, song, resp);
+  ck_assert_int_gt (count, 0);
+  ck_assert_int_eq (gacoustidreq, 1);
+  ck_assert_int_eq (checkAudioIdHasTitle (resp, "Title B"), true);
+  songFree (song);
+  checkAudioIdRespFree (resp);
+
+  resp = checkAudioIdRespAlloc ();
+  song = checkAudioIdSong (2);
+  acoustidLookup (acoustid, song, resp);
+  ck_assert_int_eq (gacoustidreq, 1);
+  ck_assert_int_eq (checkAudioIdHasTitle (resp, "Title C"), false);
+  songFree (song);
+  checkAudioIdRespFree (resp);
+
+  acoustidFree (acoustid);
+
+  /* the cache is persistent */
+  acoustid = acoustidInit (cache);
+  resp = checkAudioIdRespAlloc ();
+  song = checkAudioIdSong (0);
+  count = acoustidLookup (acoustid, song, resp);
+  ck_assert_int_gt (count, 0);
+  ck_assert_int_eq (gacoustidreq, 1);
+  ck_assert_int_eq (checkAudioIdHasTitle (resp, "Title A"), true);
+  songFree (song);
+  checkAudioIdRespFree (resp);
+  acoustidFree (acoustid);
+
+  audioidCacheFree (cache);
+}
+END_TEST
+
+START_TEST(audioid_acoustid_prefetch)
+{
+  audioidcache_t    *cache;
+  audioidacoustid_t *acoustid;
+  audioid_resp_t    *resp;
+  song_t            *song;
+  FILE              *fh;
+  int               count;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- audioid_acoustid_prefetch");
+  mdebugSubTag ("audioid_acoustid_prefetch");
+
+  /* a song with no fingerprint */
+  fh = fileopOpen (AUID_NOFP_FN, "w");
+  ck_assert_ptr_nonnull (fh);
+  mdextfclose (fh);
+  fclose (fh);
+
+  cache = checkAudioIdCache ();
+  acoustid = acoustidInit (cache);
+
+  acoustidPrefetchAdd (acoustid, AUID_NOFP_FN, 160000);
+  acoustidPrefetchAdd (acoustid, songs [1].fn, songs [1].dur);
+
+  /* the song with no fingerprint is skipped, not fingerprinted */
+  resp = checkAudioIdRespAlloc ();
+  song = checkAudioIdSong (0);
+  count = acoustidLookup (acoustid, song, resp);
+  ck_assert_int_gt (count, 0);
+  ck_assert_int_eq (gacoustidreq, 1);
+  songFree (song);
+  checkAudioIdRespFree (resp);
+
+  resp = checkAudioIdRespAlloc ();
+  song = checkAudioIdSong (1);
+  acoustidLookup (acoustid, song, resp);
+  ck_assert_int_eq (gacoustidreq, 1);
+  ck_assert_int_eq (checkAudioIdHasTitle (resp, "Title B"), true);
+  songFree (song);
+  checkAudioIdRespFree (resp);
+
+  /* and is still waiting to be processed after the lookup */
+  ck_assert_int_eq (acoustidPrefetchProcess (acoustid), true);
+  ck_assert_int_eq (acoustidPrefetchProcess (acoustid), false);
+
+  acoustidFree (acoustid);
+  audioidCacheFree (cache);
+  fileopDelete (AUID_NOFP_FN);
+}
+END_TEST
+
+START_TEST(audioid_acoustid_retry)
+{
+  audioidcache_t    *cache;
+  audioidacoustid_t *acoustid;
+  audioid_resp_t    *resp;
+  song_t            *song;
+  int               count;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- audioid_acoustid_retry");
+  mdebugSubTag ("audioid_acoustid_retry");
+
+  cache = checkAudioIdCache ();
+  acoustid = acoustidInit (cache);
+
+  /* the service is busy, the request is retried */
+  gacoustidresp = AUID_ACOUSTID_SINGLE;
+  gbusy = 1;
+  resp = checkAudioIdRespAlloc ();
+  song = checkAudioIdSong (3);
+  count = acoustidLookup (acoustid, song, resp);
+  ck_assert_int_gt (count, 0);
+  ck_assert_int_eq (gacoustidreq, 2);
+  ck_assert_int_eq (checkAudioIdHasTitle (resp, "Title D"), true);
+  songFree (song);
+  checkAudioIdRespFree (resp);
+
+  /* an error response is not cached */
+  diropDeleteDir (AUID_DIR, DIROP_ALL);
+  audioidCacheFree (cache);
+  cache = checkAudioIdCache ();
+  acoustidFree (acoustid);
+  acoustid = acoustidInit (cache);
+  gacoustidresp = AUID_ACOUSTID_ERROR;
+  for (int i = 0; i < 2; ++i) {
+    resp = checkAudioIdRespAlloc ();
+    song = checkAudioIdSong (3);
+    acoustidLookup (acoustid, song, resp);
+    ck_assert_int_eq (gacoustidreq, 3 + i);
+    ck_assert_int_eq (checkAudioIdHasTitle (resp, "Title D"), false);
+    songFree (song);
+    checkAudioIdRespFree (resp);
+  }
+
+  acoustidFree (acoustid);
+  audioidCacheFree (cache);
+}
+END_TEST
+
+START_TEST(audioid_mb_cache)
+{
+  audioidcache_t    *cache;
+  audioidmb_t       *mb;
+  audioid_resp_t    *resp;
+  int               count;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- audioid_mb_cache");
+  mdebugSubTag ("audioid_mb_cache");
+
+  cache = checkAudioIdCache ();
+  mb = mbInit (cache);
+
+  for (int i = 0; i < 2; ++i) {
+    resp = checkAudioIdRespAlloc ();
+    count = mbRecordingIdLookup (mb,
+        "b3015bab-1540-4d4e-9f30-14872a1525f1", resp);
+    ck_assert_int_gt (count, 0);
+    ck_assert_int_eq (gmbreq, 1);
+    ck_assert_int_eq (checkAudioIdHasTitle (resp, "Title MB"), true);
+    checkAudioIdRespFree (resp);
+  }
+
+  mbFree (mb);
+  audioidCacheFree (cache);
+}
+END_TEST
+
+#endif
+
+Suite *
+audioid_suite (void)
+{
+  Suite     *s;
+  TCase     *tc;
+
+  s = suite_create ("audioid");
+  tc = tcase_create ("audioid");
+  tcase_set_tags (tc, "libaudioid");
+#if _lib_pthread_create
+  tcase_add_unchecked_fixture (tc, setup, teardown);
+  tcase_add_checked_fixture (tc, setupeach, NULL);
+  tcase_set_timeout (tc, 10.0);
+  tcase_add_test (tc, audioid_xml_batch);
+  tcase_add_test (tc, audioid_acoustid_batch);
+  tcase_add_test (tc, audioid_acoustid_prefetch);
+  tcase_add_test (tc, audioid_acoustid_retry);
+  tcase_add_test (tc, audioid_mb_cache);
+#endif
+  suite_add_tcase (s, tc);
+
+  return s;
+}
+
+#if _lib_pthread_create
+
+/* the recorded responses are served */
+static void
+checkAudioIdHandler (void *udata, const char *query, const char *uri)
+{
+  if (gbusy > 0) {
+    gbusy -= 1;
+    if (strncmp (uri, "/v2/", 4) == 0) {
+      gacoustidreq += 1;
+    } else {
+      gmbreq += 1;
+    }
+    websrvReply (gwebsrv, WEB_TOO_MANY_REQ, "", "busy");
+    return;
+  }
+
+  if (strcmp (uri, "/v2/lookup") == 0) {
+    gacoustidreq += 1;
+    websrvReply (gwebsrv, WEB_OK,
+        "Content-type: text/xml; charset=utf-8\r\n", gacoustidresp);
+    return;
+  }
+
+  if (strncmp (uri, "/ws/2/recording/", 16) == 0) {
+    gmbreq += 1;
+    websrvReply (gwebsrv, WEB_OK,
+        "Content-type: text/xml; charset=utf-8\r\n", AUID_MB);
+    return;
+  }
+
+  websrvReply (gwebsrv, WEB_NOT_FOUND, "", "");
+}
+
+/* the web server runs in its own thread, as the web client blocks */
+static void *
+checkAudioIdServer (void *arg)
+{
+  while (! gstop) {
+    websrvProcess (gwebsrv);
+  }
+  pthread_exit (NULL);
+  return NULL;
+}
+
+/* fpcalc is not available, the fingerprints are pre-loaded */
+static audioidcache_t *
+checkAudioIdCache (void)
+{
+  audioidcache_t  *cache;
+  char            ffn [BDJ4_PATH_MAX];
+  char            key [BDJ4_PATH_MAX];
+
+  cache = audioidCacheAlloc (AUID_DIR, AUDIOID_CACHE_AGE);
+  for (int i = 0; i < songsz; ++i) {
+    audiosrcFullPath (songs [i].fn, ffn, sizeof (ffn), NULL, 0);
+    audioidCacheFileKey (ffn, key, sizeof (key));
+    audioidCacheSet (cache, AUDIOID_CACHE_FP, key,
+        songs [i].fp, strlen (songs [i].fp));
+  }
+  return cache;
+}
+
+static song_t *
+checkAudioIdSong (int idx)
+{
+  song_t    *song;
+
+  song = songAlloc ();
+  songSetStr (song, TAG_URI, songs [idx].fn);
+  songSetNum (song, TAG_DURATION, songs [idx].dur);
+  return song;
+}
+
+static audioid_resp_t *
+checkAudioIdRespAlloc (void)
+{
+  audioid_resp_t  *resp;
+
+  resp = mdmalloc (sizeof (audioid_resp_t));
+  resp->joinphrase = NULL;
+  resp->respidx = 0;
+  resp->tagidx_add = -1;
+  resp->respdatalist = nlistAlloc ("chk-audioid-resp", LIST_ORDERED, NULL);
+  return resp;
+}
+
+static void
+checkAudioIdRespFree (audioid_resp_t *resp)
+{
+  dataFree (resp->joinphrase);
+  nlistFree (resp->respdatalist);
+  mdfree (resp);
+}
+
+static bool
+checkAudioIdHasTitle (audioid_resp_t *resp, const char *title)
+{
+  nlistidx_t  iteridx;
+  nlistidx_t  key;
+  const char  *tstr;
+
+  nlistStartIterator (resp->respdatalist, &iteridx);
+  while ((key = nlistIterateKey (resp->respdatalist, &iteridx)) >= 0) {
+    tstr = nlistGetStr (audioidGetResponseData (resp, key), TAG_TITLE);
+    if (tstr != NULL && strcmp (tstr, title) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void
+checkAudioIdBatchCB (void *udata, int idx, const char *data, size_t len)
+{
+  chkauidbatch_t  *batch = udata;
+
+  ck_assert_ptr_nonnull (strstr (data, "<response><status>ok</status>"));
+  if (batch->count < 5) {
+    batch->idx [batch->count] = idx;
+  }
+  batch->count += 1;
+}
+
+#endif
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
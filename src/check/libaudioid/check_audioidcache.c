@@ -0,0 +1,234 @@
+/*
+ * Copyright 2023-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "audioid.h"
+#include "bdj4.h"
+#include "check_bdj.h"
+#include "dirlist.h"
+#include "dirop.h"
+#include "fileop.h"
+#include "log.h"
+#include "mdebug.h"
+#include "slist.h"
+
+#define AIC_DIR   "tmp/audioid-cache"
+#define AIC_FN    "tmp/audioid-cache.dat"
+#define AIC_KEY_A "180 AQADtEmUSEkSJYmS"
+#define AIC_KEY_B "181 AQADtEmUSEkSJYmS"
+#define AIC_DATA_A  "<response><status>ok</status></response>"
+#define AIC_DATA_B  "<response><status>ok</status><results/></response>"
+
+enum {
+  AIC_AGE = 3600,
+};
+
+static int chkCacheCount (void);
+static void chkCacheAge (time_t tm);
+
+static void
+setup (void)
+{
+  diropDeleteDir (AIC_DIR, DIROP_ALL);
+  fileopDelete (AIC_FN);
+}
+
+static void
+teardown (void)
+{
+  diropDeleteDir (AIC_DIR, DIROP_ALL);
+  fileopDelete (AIC_FN);
+}
+
+START_TEST(audioidcache_alloc)
+{
+  audioidcache_t  *cache;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- audioidcache_alloc");
+  mdebugSubTag ("audioidcache_alloc");
+
+  cache = audioidCacheAlloc (AIC_DIR, AIC_AGE);
+  ck_assert_ptr_nonnull (cache);
+  ck_assert_int_eq (fileopIsDirectory (AIC_DIR), true);
+  ck_assert_int_eq (audioidCacheExists (cache, AUDIOID_CACHE_ACOUSTID, AIC_KEY_A), false);
+  audioidCacheFree (cache);
+
+  cache = audioidCacheAlloc (NULL, AIC_AGE);
+  ck_assert_ptr_null (cache);
+  /* a null cache is not an error */
+  ck_assert_ptr_null (audioidCacheGet (cache, AUDIOID_CACHE_MB, AIC_KEY_A, NULL));
+  ck_assert_int_eq (audioidCacheSet (cache, AUDIOID_CACHE_MB, AIC_KEY_A, "a", 1), false);
+}
+END_TEST
+
+START_TEST(audioidcache_set_get)
+{
+  audioidcache_t  *cache;
+  char            *data;
+  size_t          len;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- audioidcache_set_get");
+  mdebugSubTag ("audioidcache_set_get");
+
+  cache = audioidCacheAlloc (AIC_DIR, AIC_AGE);
+  ck_assert_int_eq (audioidCacheSet (cache, AUDIOID_CACHE_ACOUSTID,
+      AIC_KEY_A, AIC_DATA_A, strlen (AIC_DATA_A)), true);
+  ck_assert_int_eq (audioidCacheSet (cache, AUDIOID_CACHE_ACOUSTID,
+      AIC_KEY_B, AIC_DATA_B, strlen (AIC_DATA_B)), true);
+  ck_assert_int_eq (chkCacheCount (), 2);
+
+  data = audioidCacheGet (cache, AUDIOID_CACHE_ACOUSTID, AIC_KEY_A, &len);
+  ck_assert_ptr_nonnull (data);
+  ck_assert_int_eq (len, strlen (AIC_DATA_A));
+  ck_assert_str_eq (data, AIC_DATA_A);
+  mdfree (data);
+
+  data = audioidCacheGet (cache, AUDIOID_CACHE_ACOUSTID, AIC_KEY_B, &len);
+  ck_assert_ptr_nonnull (data);
+  ck_assert_str_eq (data, AIC_DATA_B);
+  mdfree (data);
+
+  /* the types are separate */
+  ck_assert_int_eq (audioidCacheExists (cache, AUDIOID_CACHE_ACR, AIC_KEY_A), false);
+  ck_assert_int_eq (audioidCacheExists (cache, AUDIOID_CACHE_MB, "abc"), false);
+
+  /* replace */
+  ck_assert_int_eq (audioidCacheSet (cache, AUDIOID_CACHE_ACOUSTID,
+      AIC_KEY_A, AIC_DATA_B, strlen (AIC_DATA_B)), true);
+  ck_assert_int_eq (chkCacheCount (), 2);
+  data = audioidCacheGet (cache, AUDIOID_CACHE_ACOUSTID, AIC_KEY_A, &len);
+  ck_assert_ptr_nonnull (data);
+  ck_assert_str_eq (data, AIC_DATA_B);
+  mdfree (data);
+
+  audioidCacheFree (cache);
+
+  /* persistent */
+  cache = audioidCacheAlloc (AIC_DIR, AIC_AGE);
+  ck_assert_int_eq (audioidCacheExists (cache, AUDIOID_CACHE_ACOUSTID, AIC_KEY_A), true);
+  ck_assert_int_eq (audioidCacheExists (cache, AUDIOID_CACHE_ACOUSTID, AIC_KEY_B), true);
+  audioidCacheFree (cache);
+}
+END_TEST
+
+START_TEST(audioidcache_expire)
+{
+  audioidcache_t  *cache;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- audioidcache_expire");
+  mdebugSubTag ("audioidcache_expire");
+
+  cache = audioidCacheAlloc (AIC_DIR, AIC_AGE);
+  audioidCacheSet (cache, AUDIOID_CACHE_MB, AIC_KEY_A, "a", 1);
+  audioidCacheSet (cache, AUDIOID_CACHE_MB, AIC_KEY_B, "b", 1);
+  ck_assert_int_eq (chkCacheCount (), 2);
+
+  /* an expired entry is not returned, and is removed */
+  chkCacheAge (time (NULL) - AIC_AGE * 2);
+  ck_assert_int_eq (audioidCacheExists (cache, AUDIOID_CACHE_MB, AIC_KEY_A), false);
+  ck_assert_int_eq (chkCacheCount (), 1);
+  audioidCacheFree (cache);
+
+  /* expired entries are removed when the cache is opened */
+  cache = audioidCacheAlloc (AIC_DIR, AIC_AGE);
+  ck_assert_int_eq (chkCacheCount (), 0);
+  ck_assert_int_eq (audioidCacheExists (cache, AUDIOID_CACHE_MB, AIC_KEY_B), false);
+  audioidCacheFree (cache);
+}
+END_TEST
+
+START_TEST(audioidcache_filekey)
+{
+  FILE    *fh;
+  char    keya [BDJ4_PATH_MAX];
+  char    keyb [BDJ4_PATH_MAX];
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- audioidcache_filekey");
+  mdebugSubTag ("audioidcache_filekey");
+
+  fh = fileopOpen (AIC_FN, "w");
+  fputs ("abc", fh);
+  mdextfclose (fh);
+  fclose (fh);
+
+  audioidCacheFileKey (AIC_FN, keya, sizeof (keya));
+  ck_assert_ptr_nonnull (strstr (keya, AIC_FN));
+  audioidCacheFileKey (AIC_FN, keyb, sizeof (keyb));
+  ck_assert_str_eq (keya, keyb);
+
+  /* a changed file has a different key */
+  fh = fileopOpen (AIC_FN, "w");
+  fputs ("abcdef", fh);
+  mdextfclose (fh);
+  fclose (fh);
+  audioidCacheFileKey (AIC_FN, keyb, sizeof (keyb));
+  ck_assert_str_ne (keya, keyb);
+}
+END_TEST
+
+Suite *
+audioidcache_suite (void)
+{
+  Suite     *s;
+  TCase     *tc;
+
+  s = suite_create ("audioidcache");
+  tc = tcase_create ("audioidcache");
+  tcase_set_tags (tc, "libaudioid");
+  tcase_add_checked_fixture (tc, setup, teardown);
+  tcase_add_test (tc, audioidcache_alloc);
+  tcase_add_test (tc, audioidcache_set_get);
+  tcase_add_test (tc, audioidcache_expire);
+  tcase_add_test (tc, audioidcache_filekey);
+  suite_add_tcase (s, tc);
+
+  return s;
+}
+
+static int
+chkCacheCount (void)
+{
+  slist_t   *filelist;
+  int       count;
+
+  filelist = dirlistBasicDirList (AIC_DIR, NULL);
+  count = slistGetCount (filelist);
+  slistFree (filelist);
+  return count;
+}
+
+static void
+chkCacheAge (time_t tm)
+{
+  slist_t     *filelist;
+  slistidx_t  iteridx;
+  const char  *fn;
+  char        tbuff [BDJ4_PATH_MAX];
+
+  filelist = dirlistBasicDirList (AIC_DIR, NULL);
+  slistStartIterator (filelist, &iteridx);
+  while ((fn = slistIterateKey (filelist, &iteridx)) != NULL) {
+    snprintf (tbuff, sizeof (tbuff), "%s/%s", AIC_DIR, fn);
+    fileopSetModTime (tbuff, tm);
+  }
+  slistFree (filelist);
+}
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2023-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <locale.h>
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "check_bdj.h"
+#include "mdebug.h"
+#include "log.h"
+
+void
+check_libaudioid (SRunner *sr)
+{
+  Suite   *s;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "==chk== libaudioid");
+
+  /* libaudioid:
+   *   audioidcache       complete 2026-10-18
+   *   audioid
+   *    xml batch         complete 2026-10-18
+   *    acoustid batch    complete 2026-10-18
+   *    acoustid retry    complete 2026-10-18
+   *    mb cache          complete 2026-10-18
+   *   acrcloud
+   *   audioidutil
+   */
+
+  s = audioidcache_suite ();
+  srunner_add_suite (sr, s);
+
+  s = audioid_suite ();
+  srunner_add_suite (sr, s);
+}
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
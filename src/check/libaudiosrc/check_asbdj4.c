@@ -0,0 +1,303 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+#if __has_include (<pthread.h>)
+# include <pthread.h>
+#endif
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "audiosrc.h"
+#include "bdj4.h"
+#include "bdjmsg.h"
+#include "bdjopt.h"
+#include "bdjstring.h"
+#include "bdjvars.h"
+#include "bdjvarsdfload.h"
+#include "check_bdj.h"
+#include "dirop.h"
+#include "filemanip.h"
+#include "fileop.h"
+#include "log.h"
+#include "mdebug.h"
+#include "musicdb.h"
+#include "song.h"
+#include "srvutil.h"
+#include "tagdef.h"
+#include "templateutil.h"
+#include "webclient.h"
+#include "websrv.h"
+
+/* the bdj4 audio source against a local server that sends the same */
+/* replies as bdj4server */
+
+#if _lib_pthread_create
+
+enum {
+  ASBDJ4_PORT = 32740,
+  /* more than one batch */
+  ASBDJ4_SONG_COUNT = 150,
+  ASBDJ4_BATCH_COUNT = 2,
+};
+
+#define ASBDJ4_DIR      "tmp/asbdj4"
+#define ASBDJ4_DB       "tmp/asbdj4-db.dat"
+#define ASBDJ4_CONF     "data/audiosrc.txt"
+#define ASBDJ4_CONF_BAK "tmp/asbdj4-audiosrc.txt"
+#define ASBDJ4_MISSING  "missing.mp3"
+#define ASBDJ4_PFX      "bdj4://localhost:32740/"
+
+static void checkAsbdj4Handler (void *udata, const char *query, const char *uri);
+static void *checkAsbdj4Server (void *arg);
+
+static websrv_t         *gwebsrv = NULL;
+static musicdb_t        *gmusicdb = NULL;
+static pthread_t        gthread;
+static _Atomic(bool)    gstop = false;
+static _Atomic(int)     gbatchcount = 0;
+static _Atomic(int)     gsinglecount = 0;
+
+static void
+setup (void)
+{
+  FILE      *fh;
+  musicdb_t *db;
+
+  templateFileCopy ("dancetypes.txt", "dancetypes.txt");
+  templateFileCopy ("dances.txt", "dances.txt");
+  templateFileCopy ("genres.txt", "genres.txt");
+  templateFileCopy ("levels.txt", "levels.txt");
+  templateFileCopy ("ratings.txt", "ratings.txt");
+  filemanipCopy ("test-templates/status.txt", "data/status.txt");
+
+  filemanipCopy (ASBDJ4_CONF, ASBDJ4_CONF_BAK);
+  fh = fileopOpen (ASBDJ4_CONF, "w");
+  fprintf (fh, "# asconf\n# version 2\n"
+      "version\n..1\ncount\n..1\n"
+      "KEY\n..0\nMODE\n..client\nNAME\n..Local\nPASS\n..bdj\n"
+      "PORT\n..%d\nTYPE\n..bdj4\nURI\n..localhost\nUSER\n..bdj\n",
+      ASBDJ4_PORT);
+  mdextfclose (fh);
+  fclose (fh);
+
+  bdjoptInit ();
+  bdjoptSetStr (OPT_M_DIR_MUSIC, ASBDJ4_DIR);
+  bdjvarsInit ();
+  bdjvarsdfloadInit ();
+  audiosrcInit ();
+
+  diropDeleteDir (ASBDJ4_DIR, DIROP_ALL);
+  fileopDelete (ASBDJ4_DB);
+  diropMakeDir (ASBDJ4_DIR);
+  db = dbOpen (ASBDJ4_DB);
+  for (int i = 0; i < ASBDJ4_SONG_COUNT; ++i) {
+    song_t    *song;
+    char      tmp [400];
+
+    snprintf (tmp, sizeof (tmp),
+        "URI\n..song %03d.mp3\n"
+        "ARTIST\n..artist%03d\n"
+        "DANCE\n..Waltz\n"
+        "DURATION\n..180000\n"
+        "TITLE\n..title%03d\n",
+        i, i, i);
+    song = songAlloc ();
+    songParse (song, tmp, i);
+    songSetNum (song, TAG_RRN, i + 1);
+
+    snprintf (tmp, sizeof (tmp), "%s/%s", ASBDJ4_DIR,
+        songGetStr (song, TAG_URI));
+    fh = fileopOpen (tmp, "w");
+    mdextfclose (fh);
+    fclose (fh);
+
+    dbWriteSong (db, song);
+    songFree (song);
+  }
+  dbClose (db);
+  gmusicdb = dbOpen (ASBDJ4_DB);
+
+  gstop = false;
+  gbatchcount = 0;
+  gsinglecount = 0;
+  gwebsrv = websrvInit (ASBDJ4_PORT, checkAsbdj4Handler, NULL, WEBSRV_TLS_ON);
+  pthread_create (&gthread, NULL, checkAsbdj4Server, NULL);
+}
+
+static void
+teardown (void)
+{
+  gstop = true;
+  pthread_join (gthread, NULL);
+  websrvFree (gwebsrv);
+  gwebsrv = NULL;
+
+  audiosrcCleanup ();
+  dbClose (gmusicdb);
+  gmusicdb = NULL;
+  filemanipMove (ASBDJ4_CONF_BAK, ASBDJ4_CONF);
+  diropDeleteDir (ASBDJ4_DIR, DIROP_ALL);
+  fileopDelete (ASBDJ4_DB);
+
+  bdjvarsdfloadCleanup ();
+  bdjvarsCleanup ();
+  bdjoptCleanup ();
+}
+
+START_TEST(asbdj4_batch)
+{
+  asiter_t    *asiter;
+  asiter_t    *tagiter;
+  const char  *songuri;
+  const char  *val;
+  char        tmp [200];
+  int         count;
+  int         found;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- asbdj4_batch");
+  mdebugSubTag ("asbdj4_batch");
+
+  /* fetching the playlist fetches the tags for all of its songs */
+  asiter = audiosrcStartIterator (AUDIOSRC_TYPE_BDJ4, AS_ITER_PL,
+      NULL, "test-pl", 0);
+  ck_assert_ptr_nonnull (asiter);
+  count = audiosrcIterCount (asiter);
+  ck_assert_int_eq (count, ASBDJ4_SONG_COUNT + 1);
+  ck_assert_int_eq (gbatchcount, ASBDJ4_BATCH_COUNT);
+  ck_assert_int_eq (gsinglecount, 0);
+
+  count = 0;
+  found = 0;
+  while ((songuri = audiosrcIterate (asiter)) != NULL) {
+    ck_assert_int_eq (strncmp (songuri, ASBDJ4_PFX, strlen (ASBDJ4_PFX)), 0);
+
+    if (strcmp (songuri + strlen (ASBDJ4_PFX), ASBDJ4_MISSING) == 0) {
+      ck_assert_int_eq (audiosrcExists (songuri), false);
+      ++count;
+      continue;
+    }
+
+    ck_assert_int_eq (audiosrcExists (songuri), true);
+
+    tagiter = audiosrcStartIterator (AUDIOSRC_TYPE_BDJ4, AS_ITER_TAGS,
+        NULL, songuri, 0);
+    ck_assert_ptr_nonnull (tagiter);
+    /* song nnn.mp3 has title nnn */
+    snprintf (tmp, sizeof (tmp), "title%.3s",
+        songuri + strlen (ASBDJ4_PFX) + strlen ("song "));
+    val = audiosrcIterateValue (tagiter, tagdefs [TAG_TITLE].tag);
+    ck_assert_ptr_nonnull (val);
+    ck_assert_str_eq (val, tmp);
+    audiosrcCleanIterator (tagiter);
+
+    ++found;
+    ++count;
+  }
+  ck_assert_int_eq (count, ASBDJ4_SONG_COUNT + 1);
+  ck_assert_int_eq (found, ASBDJ4_SONG_COUNT);
+
+  /* all of the song data came from the batch replies */
+  ck_assert_int_eq (gbatchcount, ASBDJ4_BATCH_COUNT);
+  ck_assert_int_eq (gsinglecount, 0);
+
+  audiosrcCleanIterator (asiter);
+}
+END_TEST
+
+#endif
+
+Suite *
+asbdj4_suite (void)
+{
+  Suite     *s;
+  TCase     *tc;
+
+  s = suite_create ("asbdj4");
+  tc = tcase_create ("asbdj4");
+  tcase_set_tags (tc, "libaudiosrc");
+  tcase_set_timeout (tc, 10.0);
+#if _lib_pthread_create
+  tcase_add_unchecked_fixture (tc, setup, teardown);
+  tcase_add_test (tc, asbdj4_batch);
+#endif
+  suite_add_tcase (s, tc);
+  return s;
+}
+
+#if _lib_pthread_create
+
+/* a stand-in for bdj4server */
+static void
+checkAsbdj4Handler (void *udata, const char *query, const char *uri)
+{
+  if (strcmp (uri, "/plget") == 0) {
+    char    *rbuff;
+    char    *rp;
+    char    *rend;
+    char    tmp [200];
+
+    rbuff = mdmalloc (BDJMSG_MAX);
+    rend = rbuff + BDJMSG_MAX;
+    rp = rbuff;
+    *rp = '\0';
+    for (int i = 0; i < ASBDJ4_SONG_COUNT; ++i) {
+      snprintf (tmp, sizeof (tmp), "song %03d.mp3%c", i, MSG_ARGS_RS);
+      rp = stpecpy (rp, rend, tmp);
+    }
+    snprintf (tmp, sizeof (tmp), "%s%c", ASBDJ4_MISSING, MSG_ARGS_RS);
+    rp = stpecpy (rp, rend, tmp);
+    websrvReply (gwebsrv, WEB_OK, "Content-type: text/plain\r\n", rbuff);
+    mdfree (rbuff);
+  } else if (strcmp (uri, "/songtagsbatch") == 0) {
+    char    *body;
+    char    *songlist;
+
+    gbatchcount += 1;
+    body = websrvGetBody (gwebsrv);
+    if (body == NULL) {
+      return;
+    }
+    songlist = body;
+    if (strncmp (songlist, "uri=", 4) == 0) {
+      songlist += 4;
+    }
+    srvutilSongTagsBatch (gwebsrv, gmusicdb, songlist);
+    mdfree (body);
+  } else if (strcmp (uri, "/songtags") == 0 ||
+      strcmp (uri, "/songexists") == 0) {
+    gsinglecount += 1;
+    websrvReply (gwebsrv, WEB_NOT_FOUND, "", "");
+  } else {
+    websrvReply (gwebsrv, WEB_NOT_FOUND, "", "");
+  }
+}
+
+/* the web server runs in its own thread, as the web client blocks */
+static void *
+checkAsbdj4Server (void *arg)
+{
+  while (! gstop) {
+    websrvProcess (gwebsrv);
+  }
+  pthread_exit (NULL);
+  return NULL;
+}
+
+#endif
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
@@ -39,10 +39,18 @@ check_libaudiosrc (SRunner *sr)
    *    prep            complete 2023-12-9
    *    iterate         complete 2023-12-9
    *    remove          complete 2023-12-9
+   *   rss                complete 2026-10-18
+   *   asbdj4             partial 2026-10-18 (song-tags batch only)
    */
 
   s = audiosrc_suite ();
   srunner_add_suite (sr, s);
+
+  s = rss_suite ();
+  srunner_add_suite (sr, s);
+
+  s = asbdj4_suite ();
+  srunner_add_suite (sr, s);
 }
 
 #pragma clang diagnostic pop
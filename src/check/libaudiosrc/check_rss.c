@@ -0,0 +1,380 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#if __has_include (<pthread.h>)
+# include <pthread.h>
+#endif
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "bdjopt.h"
+#include "bdjstring.h"
+#include "check_bdj.h"
+#include "expimp.h"
+#include "fileop.h"
+#include "ilist.h"
+#include "log.h"
+#include "mdebug.h"
+#include "nlist.h"
+#include "slist.h"
+#include "webclient.h"
+#include "websrv.h"
+
+#if _lib_pthread_create
+
+enum {
+  RSS_PORT = 32731,
+};
+
+#define RSS_HEAD \
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
+    "<rss version=\"2.0\" " \
+    "xmlns:itunes=\"http://www.itunes.com/dtds/podcast-1.0.dtd\">\n" \
+    "<channel>\n" \
+    "  <title>Test &amp; Podcast</title>\n" \
+    "  <link>https://example.com/podcast</link>\n" \
+    "  <lastBuildDate>Wed, 23 Apr 2025 17:00:00 +0000</lastBuildDate>\n" \
+    "  <image>\n" \
+    "    <url>https://example.com/image.jpg</url>\n" \
+    "    <title>not the podcast title</title>\n" \
+    "  </image>\n"
+#define RSS_TAIL \
+    "</channel>\n" \
+    "</rss>\n"
+#define RSS_ITEM(n,day) \
+    "  <item>\n" \
+    "    <title><![CDATA[Episode " #n "]]></title>\n" \
+    "    <guid isPermaLink=\"false\">guid-" #n "</guid>\n" \
+    "    <pubDate>" day " Apr 2025 17:00:00 +0000</pubDate>\n" \
+    "    <itunes:duration>12:3" #n "</itunes:duration>\n" \
+    "    <description>&lt;p&gt;the description&lt;/p&gt;</description>\n" \
+    "    <enclosure url=\"https://example.com/ep" #n ".mp3\" " \
+    "type=\"audio/mpeg\" length=\"1000\"/>\n" \
+    "  </item>\n"
+
+typedef struct {
+  const char  *fn;
+  const char  *data;
+} chkrssfeed_t;
+
+/* the feeds are normally ordered with the newest item first */
+static chkrssfeed_t feeds [] = {
+  { "tmp/rss-a.xml",
+    RSS_HEAD
+    RSS_ITEM(3,"Wed, 23")
+    RSS_ITEM(2,"Tue, 22")
+    RSS_ITEM(1,"Mon, 21")
+    RSS_TAIL },
+  { "tmp/rss-b.xml",
+    RSS_HEAD
+    RSS_ITEM(5,"Fri, 25")
+    RSS_ITEM(4,"Thu, 24")
+    RSS_ITEM(3,"Wed, 23")
+    RSS_ITEM(2,"Tue, 22")
+    RSS_ITEM(1,"Mon, 21")
+    RSS_TAIL },
+  { "tmp/rss-c.xml",
+    RSS_HEAD
+    RSS_ITEM(1,"Mon, 21")
+    RSS_ITEM(2,"Tue, 22")
+    RSS_ITEM(3,"Wed, 23")
+    RSS_ITEM(4,"Thu, 24")
+    RSS_TAIL },
+  { "tmp/rss-bad.xml",
+    RSS_HEAD
+    RSS_ITEM(1,"Mon, 21")
+    "<item></channel>\n" },
+};
+enum {
+  feedsz = sizeof (feeds) / sizeof (chkrssfeed_t),
+};
+
+static void checkRSSHandler (void *udata, const char *query, const char *uri);
+static void *checkRSSServer (void *arg);
+static void checkRSSURI (char *uri, size_t sz, const char *fn);
+static void checkRSSValidInit (rssvalid_t *valid);
+
+static websrv_t         *gwebsrv = NULL;
+static _Atomic(bool)    gstop = false;
+static pthread_t        gthread;
+
+static void
+setup (void)
+{
+  FILE    *fh;
+
+  bdjoptInit ();
+
+  for (int i = 0; i < feedsz; ++i) {
+    fh = fileopOpen (feeds [i].fn, "w");
+    ck_assert_ptr_nonnull (fh);
+    fputs (feeds [i].data, fh);
+    mdextfclose (fh);
+    fclose (fh);
+  }
+
+  gstop = false;
+  gwebsrv = websrvInit (RSS_PORT, checkRSSHandler, NULL, WEBSRV_TLS_OFF);
+  pthread_create (&gthread, NULL, checkRSSServer, NULL);
+}
+
+static void
+teardown (void)
+{
+  gstop = true;
+  pthread_join (gthread, NULL);
+  websrvFree (gwebsrv);
+  gwebsrv = NULL;
+
+  for (int i = 0; i < feedsz; ++i) {
+    unlink (feeds [i].fn);
+  }
+
+  bdjoptCleanup ();
+}
+
+START_TEST(rss_import)
+{
+  nlist_t     *rss;
+  ilist_t     *items;
+  slist_t     *itemidx;
+  char        uri [200];
+  char        tbuff [40];
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- rss_import");
+  mdebugSubTag ("rss_import");
+
+  checkRSSURI (uri, sizeof (uri), feeds [0].fn);
+  rss = rssImport (uri);
+  ck_assert_ptr_nonnull (rss);
+  ck_assert_str_eq (nlistGetStr (rss, RSS_TITLE), "Test & Podcast");
+  ck_assert_str_eq (nlistGetStr (rss, RSS_URI), "https://example.com/podcast");
+  ck_assert_str_eq (nlistGetStr (rss, RSS_IMAGE_URI),
+      "https://example.com/image.jpg");
+  ck_assert_int_eq (nlistGetNum (rss, RSS_BUILD_DATE), 1745427600);
+  ck_assert_int_eq (nlistGetNum (rss, RSS_COUNT), 3);
+
+  items = nlistGetList (rss, RSS_ITEMS);
+  ck_assert_int_eq (ilistGetCount (items), 3);
+  ck_assert_str_eq (ilistGetStr (items, 0, RSS_ITEM_TITLE), "Episode 3");
+  ck_assert_str_eq (ilistGetStr (items, 0, RSS_ITEM_URI),
+      "https://example.com/ep3.mp3");
+  ck_assert_str_eq (ilistGetStr (items, 0, RSS_ITEM_TYPE), "audio/mpeg");
+  ck_assert_str_eq (ilistGetStr (items, 0, RSS_ITEM_DURATION), "12:33");
+  snprintf (tbuff, sizeof (tbuff), "%d", 1745427600);
+  ck_assert_str_eq (ilistGetStr (items, 0, RSS_ITEM_DATE), tbuff);
+  ck_assert_str_eq (ilistGetStr (items, 2, RSS_ITEM_TITLE), "Episode 1");
+
+  itemidx = nlistGetList (rss, RSS_IDX);
+  ck_assert_int_eq (slistGetNum (itemidx, "https://example.com/ep1.mp3"), 2);
+  ck_assert_int_eq (slistGetNum (itemidx, "https://example.com/ep3.mp3"), 0);
+
+  nlistFree (rss);
+}
+END_TEST
+
+START_TEST(rss_conditional)
+{
+  nlist_t     *rss;
+  rssvalid_t  valid;
+  char        uri [200];
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- rss_conditional");
+  mdebugSubTag ("rss_conditional");
+
+  checkRSSURI (uri, sizeof (uri), feeds [0].fn);
+  checkRSSValidInit (&valid);
+  rss = rssImportUpdate (uri, &valid);
+  ck_assert_ptr_nonnull (rss);
+  ck_assert_int_eq (valid.webrc, WEB_OK);
+  ck_assert_int_gt (strlen (valid.etag), 0);
+  ck_assert_str_eq (valid.guid, "guid-3");
+  ck_assert_int_eq (nlistGetNum (rss, RSS_COUNT), 3);
+  nlistFree (rss);
+
+  /* the feed has not changed */
+  rss = rssImportUpdate (uri, &valid);
+  ck_assert_ptr_null (rss);
+  ck_assert_int_eq (valid.webrc, WEB_NOT_MODIFIED);
+  ck_assert_int_gt (strlen (valid.etag), 0);
+  ck_assert_str_eq (valid.guid, "guid-3");
+
+  /* a different etag */
+  stpecpy (valid.etag, valid.etag + sizeof (valid.etag), "\"abc\"");
+  *valid.guid = '\0';
+  rss = rssImportUpdate (uri, &valid);
+  ck_assert_ptr_nonnull (rss);
+  ck_assert_int_eq (valid.webrc, WEB_OK);
+  ck_assert_str_ne (valid.etag, "\"abc\"");
+  ck_assert_int_eq (nlistGetNum (rss, RSS_COUNT), 3);
+  nlistFree (rss);
+}
+END_TEST
+
+START_TEST(rss_incremental)
+{
+  nlist_t     *rss;
+  ilist_t     *items;
+  rssvalid_t  valid;
+  char        uri [200];
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- rss_incremental");
+  mdebugSubTag ("rss_incremental");
+
+  checkRSSURI (uri, sizeof (uri), feeds [0].fn);
+  checkRSSValidInit (&valid);
+  rss = rssImportUpdate (uri, &valid);
+  ck_assert_ptr_nonnull (rss);
+  ck_assert_str_eq (valid.guid, "guid-3");
+  nlistFree (rss);
+
+  /* the feed has two new items, the parse stops at the known item */
+  checkRSSURI (uri, sizeof (uri), feeds [1].fn);
+  *valid.etag = '\0';
+  rss = rssImportUpdate (uri, &valid);
+  ck_assert_ptr_nonnull (rss);
+  ck_assert_int_eq (valid.webrc, WEB_OK);
+  ck_assert_str_eq (valid.guid, "guid-5");
+  ck_assert_int_eq (nlistGetNum (rss, RSS_COUNT), 2);
+  ck_assert_str_eq (nlistGetStr (rss, RSS_TITLE), "Test & Podcast");
+  items = nlistGetList (rss, RSS_ITEMS);
+  ck_assert_str_eq (ilistGetStr (items, 0, RSS_ITEM_TITLE), "Episode 5");
+  ck_assert_str_eq (ilistGetStr (items, 1, RSS_ITEM_TITLE), "Episode 4");
+  nlistFree (rss);
+
+  /* no new items */
+  *valid.etag = '\0';
+  rss = rssImportUpdate (uri, &valid);
+  ck_assert_ptr_nonnull (rss);
+  ck_assert_int_eq (nlistGetNum (rss, RSS_COUNT), 0);
+  ck_assert_str_eq (valid.guid, "guid-5");
+  nlistFree (rss);
+}
+END_TEST
+
+START_TEST(rss_ascending)
+{
+  nlist_t     *rss;
+  rssvalid_t  valid;
+  char        uri [200];
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- rss_ascending");
+  mdebugSubTag ("rss_ascending");
+
+  /* the newest item is last, the new item is after the known item */
+  checkRSSURI (uri, sizeof (uri), feeds [2].fn);
+  checkRSSValidInit (&valid);
+  stpecpy (valid.guid, valid.guid + sizeof (valid.guid), "guid-3");
+  rss = rssImportUpdate (uri, &valid);
+  ck_assert_ptr_nonnull (rss);
+  ck_assert_int_eq (nlistGetNum (rss, RSS_COUNT), 4);
+  ck_assert_str_eq (valid.guid, "guid-4");
+  nlistFree (rss);
+}
+END_TEST
+
+START_TEST(rss_bad)
+{
+  nlist_t     *rss;
+  rssvalid_t  valid;
+  char        uri [200];
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- rss_bad");
+  mdebugSubTag ("rss_bad");
+
+  checkRSSURI (uri, sizeof (uri), feeds [3].fn);
+  checkRSSValidInit (&valid);
+  rss = rssImportUpdate (uri, &valid);
+  ck_assert_ptr_null (rss);
+  ck_assert_int_eq (valid.webrc, WEB_OK);
+  ck_assert_str_eq (valid.etag, "");
+
+  checkRSSURI (uri, sizeof (uri), "tmp/rss-none.xml");
+  rss = rssImportUpdate (uri, &valid);
+  ck_assert_ptr_null (rss);
+  ck_assert_int_eq (valid.webrc, WEB_NOT_FOUND);
+}
+END_TEST
+
+#endif
+
+Suite *
+rss_suite (void)
+{
+  Suite     *s;
+  TCase     *tc;
+
+  s = suite_create ("rss");
+  tc = tcase_create ("rss");
+  tcase_set_tags (tc, "libaudiosrc");
+#if _lib_pthread_create
+  tcase_add_unchecked_fixture (tc, setup, teardown);
+  tcase_set_timeout (tc, 4.0);
+  tcase_add_test (tc, rss_import);
+  tcase_add_test (tc, rss_conditional);
+  tcase_add_test (tc, rss_incremental);
+  tcase_add_test (tc, rss_ascending);
+  tcase_add_test (tc, rss_bad);
+#endif
+  suite_add_tcase (s, tc);
+
+  return s;
+}
+
+#if _lib_pthread_create
+
+/* the canned feeds are served from the tmp directory */
+static void
+checkRSSHandler (void *udata, const char *query, const char *uri)
+{
+  char    fn [200];
+
+  snprintf (fn, sizeof (fn), "tmp%s", uri);
+  websrvServeFile (gwebsrv, "", fn);
+}
+
+/* the web server runs in its own thread, as the web client blocks */
+static void *
+checkRSSServer (void *arg)
+{
+  while (! gstop) {
+    websrvProcess (gwebsrv);
+  }
+  pthread_exit (NULL);
+  return NULL;
+}
+
+static void
+checkRSSURI (char *uri, size_t sz, const char *fn)
+{
+  snprintf (uri, sz, "http://localhost:%d%s", RSS_PORT, fn + 3);
+}
+
+static void
+checkRSSValidInit (rssvalid_t *valid)
+{
+  *valid->etag = '\0';
+  *valid->lastmod = '\0';
+  *valid->guid = '\0';
+  valid->webrc = 0;
+}
+
+#endif
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
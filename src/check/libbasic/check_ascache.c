@@ -0,0 +1,353 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#if __has_include (<pthread.h>)
+# include <pthread.h>
+#endif
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "ascache.h"
+#include "check_bdj.h"
+#include "dirlist.h"
+#include "dirop.h"
+#include "fileop.h"
+#include "log.h"
+#include "mdebug.h"
+#include "slist.h"
+
+#define ASC_DIR   "tmp/ascache"
+#define ASC_FN_A  "tmp/ascache-a.dat"
+#define ASC_FN_B  "tmp/ascache-b.dat"
+#define ASC_FN_C  "tmp/ascache-c.dat"
+#define ASC_OUT   "tmp/ascache-out.dat"
+#define ASC_KEY_A "bdj4://localhost:9011/a.mp3"
+#define ASC_KEY_B "bdj4://localhost:9011/b.mp3"
+#define ASC_KEY_C "https://example.com/c.mp3"
+
+enum {
+  ASC_SZ = 1000,
+  ASC_MAX = 2500,
+  ASC_THREADS = 8,
+};
+
+static void chkWriteFile (const char *fn, char ch);
+static bool chkCompareFile (const char *fn, char ch);
+#if _lib_pthread_create
+static void *chkAllocThread (void *arg);
+#endif
+
+static void
+setup (void)
+{
+  diropDeleteDir (ASC_DIR, DIROP_ALL);
+  chkWriteFile (ASC_FN_A, 'a');
+  chkWriteFile (ASC_FN_B, 'b');
+  chkWriteFile (ASC_FN_C, 'c');
+  fileopDelete (ASC_OUT);
+}
+
+static void
+teardown (void)
+{
+  diropDeleteDir (ASC_DIR, DIROP_ALL);
+  fileopDelete (ASC_FN_A);
+  fileopDelete (ASC_FN_B);
+  fileopDelete (ASC_FN_C);
+  fileopDelete (ASC_OUT);
+}
+
+START_TEST(ascache_alloc)
+{
+  ascache_t   *ascache;
+  ascache_t   *ascacheb;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- ascache_alloc");
+  mdebugSubTag ("ascache_alloc");
+
+  ascache = ascacheAlloc (ASC_DIR, ASC_MAX);
+  ck_assert_ptr_nonnull (ascache);
+  ck_assert_int_eq (fileopIsDirectory (ASC_DIR), true);
+  ck_assert_int_eq (ascacheGetCount (ascache), 0);
+  ck_assert_int_eq (ascacheGetSize (ascache), 0);
+  ck_assert_int_eq (ascacheGetInfo (ascache, ASC_KEY_A, NULL), false);
+
+  /* the same directory shares the cache */
+  ascacheb = ascacheAlloc (ASC_DIR, ASC_MAX);
+  ck_assert_ptr_eq (ascache, ascacheb);
+  ascacheFree (ascacheb);
+  ck_assert_int_eq (ascacheGetCount (ascache), 0);
+  ascacheFree (ascache);
+}
+END_TEST
+
+#if _lib_pthread_create
+/* the audio sources allocate the shared cache from different threads */
+START_TEST(ascache_alloc_threads)
+{
+  pthread_t   threads [ASC_THREADS];
+  ascache_t   *ascache [ASC_THREADS];
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- ascache_alloc_threads");
+  mdebugSubTag ("ascache_alloc_threads");
+
+  for (int i = 0; i < ASC_THREADS; ++i) {
+    pthread_create (&threads [i], NULL, chkAllocThread, &ascache [i]);
+  }
+  for (int i = 0; i < ASC_THREADS; ++i) {
+    pthread_join (threads [i], NULL);
+  }
+
+  for (int i = 0; i < ASC_THREADS; ++i) {
+    ck_assert_ptr_nonnull (ascache [i]);
+    ck_assert_ptr_eq (ascache [i], ascache [0]);
+  }
+  for (int i = 0; i < ASC_THREADS; ++i) {
+    ascacheFree (ascache [i]);
+  }
+}
+END_TEST
+#endif
+
+START_TEST(ascache_add)
+{
+  ascache_t     *ascache;
+  ascacheinfo_t info;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- ascache_add");
+  mdebugSubTag ("ascache_add");
+
+  ascache = ascacheAlloc (ASC_DIR, ASC_MAX);
+  ck_assert_int_eq (ascacheAdd (ascache, ASC_KEY_A, ASC_FN_A, "\"abc\"", NULL), true);
+  ck_assert_int_eq (ascacheAdd (ascache, ASC_KEY_C, ASC_FN_C, "",
+      "Wed, 21 Oct 2015 07:28:00 GMT"), true);
+  /* the original file is not removed */
+  ck_assert_int_eq (fileopFileExists (ASC_FN_A), true);
+  ck_assert_int_eq (ascacheGetCount (ascache), 2);
+  ck_assert_int_eq (ascacheGetSize (ascache), ASC_SZ * 2);
+
+  ck_assert_int_eq (ascacheGetInfo (ascache, ASC_KEY_A, &info), true);
+  ck_assert_int_eq (info.size, ASC_SZ);
+  ck_assert_str_eq (info.etag, "\"abc\"");
+  ck_assert_str_eq (info.lastmod, "");
+
+  ck_assert_int_eq (ascacheCopy (ascache, ASC_KEY_A, ASC_OUT), true);
+  ck_assert_int_eq (chkCompareFile (ASC_OUT, 'a'), true);
+  ck_assert_int_eq (ascacheCopy (ascache, ASC_KEY_B, ASC_OUT), false);
+  ascacheFree (ascache);
+
+  /* the index is persistent */
+  ascache = ascacheAlloc (ASC_DIR, ASC_MAX);
+  ck_assert_int_eq (ascacheGetCount (ascache), 2);
+  ck_assert_int_eq (ascacheGetSize (ascache), ASC_SZ * 2);
+  ck_assert_int_eq (ascacheGetInfo (ascache, ASC_KEY_C, &info), true);
+  ck_assert_str_eq (info.etag, "");
+  ck_assert_str_eq (info.lastmod, "Wed, 21 Oct 2015 07:28:00 GMT");
+  ck_assert_int_eq (ascacheCopy (ascache, ASC_KEY_C, ASC_OUT), true);
+  ck_assert_int_eq (chkCompareFile (ASC_OUT, 'c'), true);
+
+  /* a changed file replaces the entry */
+  ck_assert_int_eq (ascacheAdd (ascache, ASC_KEY_C, ASC_FN_B, "\"def\"", NULL), true);
+  ck_assert_int_eq (ascacheGetCount (ascache), 2);
+  ck_assert_int_eq (ascacheGetSize (ascache), ASC_SZ * 2);
+  ck_assert_int_eq (ascacheCopy (ascache, ASC_KEY_C, ASC_OUT), true);
+  ck_assert_int_eq (chkCompareFile (ASC_OUT, 'b'), true);
+
+  ascacheRemove (ascache, ASC_KEY_A);
+  ck_assert_int_eq (ascacheGetCount (ascache), 1);
+  ck_assert_int_eq (ascacheGetSize (ascache), ASC_SZ);
+  ascacheFree (ascache);
+}
+END_TEST
+
+START_TEST(ascache_content)
+{
+  ascache_t     *ascache;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- ascache_content");
+  mdebugSubTag ("ascache_content");
+
+  /* the same content using a different key is only stored once */
+  ascache = ascacheAlloc (ASC_DIR, ASC_MAX);
+  ck_assert_int_eq (ascacheAdd (ascache, ASC_KEY_A, ASC_FN_A, NULL, NULL), true);
+  ck_assert_int_eq (ascacheAdd (ascache, ASC_KEY_B, ASC_FN_A, NULL, NULL), true);
+  ck_assert_int_eq (ascacheGetCount (ascache), 2);
+  ck_assert_int_eq (ascacheGetSize (ascache), ASC_SZ);
+
+  /* the shared file is kept */
+  ascacheRemove (ascache, ASC_KEY_A);
+  ck_assert_int_eq (ascacheGetSize (ascache), ASC_SZ);
+  ck_assert_int_eq (ascacheCopy (ascache, ASC_KEY_B, ASC_OUT), true);
+  ck_assert_int_eq (chkCompareFile (ASC_OUT, 'a'), true);
+  ascacheFree (ascache);
+}
+END_TEST
+
+START_TEST(ascache_evict)
+{
+  ascache_t     *ascache;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- ascache_evict");
+  mdebugSubTag ("ascache_evict");
+
+  ascache = ascacheAlloc (ASC_DIR, ASC_MAX);
+  ck_assert_int_eq (ascacheAdd (ascache, ASC_KEY_A, ASC_FN_A, NULL, NULL), true);
+  ck_assert_int_eq (ascacheAdd (ascache, ASC_KEY_B, ASC_FN_B, NULL, NULL), true);
+  /* a is now the most recently used */
+  ck_assert_int_eq (ascacheCopy (ascache, ASC_KEY_A, ASC_OUT), true);
+  ascacheFree (ascache);
+
+  /* the usage is persistent */
+  ascache = ascacheAlloc (ASC_DIR, ASC_MAX);
+  ck_assert_int_eq (ascacheAdd (ascache, ASC_KEY_C, ASC_FN_C, NULL, NULL), true);
+  ck_assert_int_eq (ascacheGetCount (ascache), 2);
+  ck_assert_int_le (ascacheGetSize (ascache), ASC_MAX);
+  ck_assert_int_eq (ascacheGetInfo (ascache, ASC_KEY_A, NULL), true);
+  ck_assert_int_eq (ascacheGetInfo (ascache, ASC_KEY_B, NULL), false);
+  ck_assert_int_eq (ascacheGetInfo (ascache, ASC_KEY_C, NULL), true);
+  ascacheFree (ascache);
+
+  /* a file larger than the cache is not added */
+  ascache = ascacheAlloc (ASC_DIR, ASC_SZ - 1);
+  ck_assert_int_eq (ascacheAdd (ascache, ASC_KEY_B, ASC_FN_B, NULL, NULL), false);
+  ascacheFree (ascache);
+}
+END_TEST
+
+START_TEST(ascache_clean)
+{
+  ascache_t     *ascache;
+  slist_t       *filelist;
+  slistidx_t    iteridx;
+  const char    *fn;
+  char          tmpfn [200];
+  char          tbuff [200];
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- ascache_clean");
+  mdebugSubTag ("ascache_clean");
+
+  ascache = ascacheAlloc (ASC_DIR, ASC_MAX);
+  ck_assert_int_eq (ascacheAdd (ascache, ASC_KEY_A, ASC_FN_A, NULL, NULL), true);
+  ck_assert_int_eq (ascacheAdd (ascache, ASC_KEY_B, ASC_FN_B, NULL, NULL), true);
+  ascacheFree (ascache);
+
+  /* a left-over temporary file is removed */
+  snprintf (tmpfn, sizeof (tmpfn), "%s/%s", ASC_DIR, "123.tmp");
+  chkWriteFile (tmpfn, 'x');
+  fileopSetModTime (tmpfn, time (NULL) - 7200);
+  ascache = ascacheAlloc (ASC_DIR, ASC_MAX);
+  ck_assert_int_eq (fileopFileExists (tmpfn), false);
+  ck_assert_int_eq (ascacheGetCount (ascache), 2);
+  ascacheFree (ascache);
+
+  /* an entry that is missing its file is removed */
+  filelist = dirlistBasicDirList (ASC_DIR, NULL);
+  slistStartIterator (filelist, &iteridx);
+  while ((fn = slistIterateKey (filelist, &iteridx)) != NULL) {
+    if (strncmp (fn, ASCACHE_INDEX_FN, strlen (ASCACHE_INDEX_FN)) == 0) {
+      continue;
+    }
+    snprintf (tbuff, sizeof (tbuff), "%s/%s", ASC_DIR, fn);
+    fileopDelete (tbuff);
+  }
+  slistFree (filelist);
+
+  ascache = ascacheAlloc (ASC_DIR, ASC_MAX);
+  ck_assert_int_eq (ascacheGetCount (ascache), 0);
+  ck_assert_int_eq (ascacheGetSize (ascache), 0);
+  ck_assert_int_eq (ascacheCopy (ascache, ASC_KEY_A, ASC_OUT), false);
+  ascacheFree (ascache);
+}
+END_TEST
+
+Suite *
+ascache_suite (void)
+{
+  Suite     *s;
+  TCase     *tc;
+
+  s = suite_create ("ascache");
+  tc = tcase_create ("ascache");
+  tcase_set_tags (tc, "libbasic");
+  tcase_add_checked_fixture (tc, setup, teardown);
+  tcase_add_test (tc, ascache_alloc);
+#if _lib_pthread_create
+  tcase_add_test (tc, ascache_alloc_threads);
+#endif
+  tcase_add_test (tc, ascache_add);
+  tcase_add_test (tc, ascache_content);
+  tcase_add_test (tc, ascache_evict);
+  tcase_add_test (tc, ascache_clean);
+  suite_add_tcase (s, tc);
+
+  return s;
+}
+
+static void
+chkWriteFile (const char *fn, char ch)
+{
+  FILE    *fh;
+  char    data [ASC_SZ];
+
+  memset (data, ch, sizeof (data));
+  fh = fileopOpen (fn, "wb");
+  ck_assert_ptr_nonnull (fh);
+  fwrite (data, sizeof (data), 1, fh);
+  mdextfclose (fh);
+  fclose (fh);
+}
+
+static bool
+chkCompareFile (const char *fn, char ch)
+{
+  FILE    *fh;
+  char    data [ASC_SZ];
+  bool    rc = true;
+
+  if (fileopSize (fn) != ASC_SZ) {
+    return false;
+  }
+  fh = fileopOpen (fn, "rb");
+  ck_assert_ptr_nonnull (fh);
+  if (fread (data, sizeof (data), 1, fh) != 1) {
+    rc = false;
+  }
+  mdextfclose (fh);
+  fclose (fh);
+  for (int i = 0; rc && i < ASC_SZ; ++i) {
+    if (data [i] != ch) {
+      rc = false;
+    }
+  }
+  return rc;
+}
+
+#if _lib_pthread_create
+static void *
+chkAllocThread (void *arg)
+{
+  ascache_t   **ascache = arg;
+
+  *ascache = ascacheAlloc (ASC_DIR, ASC_MAX);
+  pthread_exit (NULL);
+  return NULL;
+}
+#endif
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
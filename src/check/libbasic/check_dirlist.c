@@ -18,6 +18,7 @@
 
 #include <check.h>
 
+#include "bdj4.h"
 #include "check_bdj.h"
 #include "mdebug.h"
 #include "dirlist.h"
@@ -27,6 +28,7 @@
 #include "log.h"
 #include "slist.h"
 #include "sysvars.h"
+#include "tmutil.h"
 
 typedef struct {
   int       type;
@@ -157,6 +159,73 @@ START_TEST(dirlist_basic)
 }
 END_TEST
 
+static int
+chkDirlistWalk (int flags)
+{
+  dirwalk_t   *dirwalk;
+  dirwalkrc_t rc;
+  char        tbuff [BDJ4_PATH_MAX];
+  int         count = 0;
+
+  dirwalk = dirlistWalkStart ("tmp/abc", flags);
+  ck_assert_ptr_nonnull (dirwalk);
+  while ((rc = dirlistWalkNext (dirwalk, tbuff, sizeof (tbuff))) !=
+      DIRLIST_WALK_DONE) {
+    if (rc == DIRLIST_WALK_WAIT) {
+      mssleep (1);
+      continue;
+    }
+    ck_assert_int_eq (strncmp (tbuff, "tmp/abc/", 8), 0);
+    ++count;
+  }
+  ck_assert_int_eq (dirlistWalkCount (dirwalk), count);
+  dirlistWalkFree (dirwalk);
+
+  return count;
+}
+
+START_TEST(dirlist_walk)
+{
+  int       count;
+  int       tcount;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- dirlist_walk");
+  mdebugSubTag ("dirlist_walk");
+
+  count = chkDirlistWalk (DIRLIST_DIRS);
+  ck_assert_int_eq (count, dcount);
+
+  count = chkDirlistWalk (DIRLIST_DIRS | DIRLIST_LINKS);
+  tcount = dcount;
+  if (! isWindows ()) {
+    /* handle the directory link */
+    tcount -= 1;
+  }
+  ck_assert_int_eq (count, tcount);
+
+  count = chkDirlistWalk (DIRLIST_FILES);
+  ck_assert_int_eq (count, fcount);
+
+  count = chkDirlistWalk (DIRLIST_FILES | DIRLIST_LINKS);
+  tcount = fcount;
+  if (! isWindows ()) {
+    /* handle the directory link */
+    tcount -= 1;
+  }
+  ck_assert_int_eq (count, tcount);
+
+  /* the walk may be stopped before it is complete */
+  {
+    dirwalk_t   *dirwalk;
+
+    dirwalk = dirlistWalkStart ("tmp/abc", DIRLIST_FILES);
+    dirlistWalkFree (dirwalk);
+  }
+
+  ck_assert_ptr_null (dirlistWalkStart ("tmp/not-a-dir", DIRLIST_FILES));
+}
+END_TEST
+
 START_TEST(dirlist_recursive)
 {
   slist_t   *slist;
@@ -205,6 +274,7 @@ dirlist_suite (void)
   tcase_set_tags (tc, "libbasic");
   tcase_add_unchecked_fixture (tc, setup, teardown);
   tcase_add_test (tc, dirlist_basic);
+  tcase_add_test (tc, dirlist_walk);
   tcase_add_test (tc, dirlist_recursive);
   suite_add_tcase (s, tc);
   return s;
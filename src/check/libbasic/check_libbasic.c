@@ -42,6 +42,7 @@ check_libbasic (SRunner *sr)
    *  rafile      complete
    *  localeutil
    *  progstate   complete (no log checks)
+   *  ascache     complete 2026-10-18
    */
 
   logMsg (LOG_DBG, LOG_IMPORTANT, "==chk== libbasic");
@@ -85,6 +86,9 @@ check_libbasic (SRunner *sr)
 
   s = asconf_suite();
   srunner_add_suite (sr, s);
+
+  s = ascache_suite();
+  srunner_add_suite (sr, s);
 }
 
 #pragma clang diagnostic pop
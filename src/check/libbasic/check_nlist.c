@@ -1341,6 +1341,34 @@ START_TEST(nlist_set_null)
 }
 END_TEST
 
+START_TEST(nlist_delete)
+{
+  nlist_t        *list;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- nlist_delete");
+  mdebugSubTag ("nlist_delete");
+
+  list = nlistAlloc ("chk-ss", LIST_ORDERED, NULL);
+  nlistSetNum (list, 6, 0);
+  nlistSetNum (list, 26, 1);
+  nlistSetNum (list, 18, 2);
+  nlistSetNum (list, 11, 3);
+  nlistSetNum (list, 3, 4);
+  ck_assert_int_eq (nlistGetCount (list), 5);
+  nlistDelete (list, 11);
+  ck_assert_int_eq (nlistGetCount (list), 4);
+  ck_assert_int_eq (nlistGetNum (list, 11), LIST_VALUE_INVALID);
+  ck_assert_int_eq (nlistGetNum (list, 18), 2);
+  nlistDelete (list, 3);
+  ck_assert_int_eq (nlistGetCount (list), 3);
+  ck_assert_int_eq (nlistGetNum (list, 6), 0);
+  /* not in the list */
+  nlistDelete (list, 99);
+  ck_assert_int_eq (nlistGetCount (list), 3);
+  nlistFree (list);
+}
+END_TEST
+
 Suite *
 nlist_suite (void)
 {
@@ -1383,6 +1411,7 @@ nlist_suite (void)
   tcase_add_test (tc, nlist_byidx_bug_20220815);
   tcase_add_test (tc, nlist_prob_search);
   tcase_add_test (tc, nlist_set_null);
+  tcase_add_test (tc, nlist_delete);
   suite_add_tcase (s, tc);
   return s;
 }
@@ -0,0 +1,265 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "bdjopt.h"
+#include "bdjvars.h"
+#include "bdjvarsdfload.h"
+#include "bpmdetect.h"
+#include "check_bdj.h"
+#include "log.h"
+#include "mdebug.h"
+#include "templateutil.h"
+
+enum {
+  CLICK_SECONDS = 30,
+  CLICK_COUNT = CLICK_SECONDS * BPMDETECT_RATE,
+};
+
+static void makeClickTrack (int16_t *pcm, size_t count, double bpm, int noise);
+
+static void
+setup (void)
+{
+  templateFileCopy ("dancetypes.txt", "dancetypes.txt");
+  templateFileCopy ("dances.txt", "dances.txt");
+  templateFileCopy ("genres.txt", "genres.txt");
+  templateFileCopy ("levels.txt", "levels.txt");
+  templateFileCopy ("ratings.txt", "ratings.txt");
+
+  bdjoptInit ();
+  bdjvarsInit ();
+  bdjvarsdfloadInit ();
+}
+
+static void
+teardown (void)
+{
+  bdjvarsdfloadCleanup ();
+  bdjvarsCleanup ();
+  bdjoptCleanup ();
+}
+
+START_TEST(bpmdetect_click)
+{
+  int16_t     *pcm;
+  bpmdetect_t result;
+  int         tests [] = { 60, 90, 120, 128, 174, 200 };
+  int         tcount = sizeof (tests) / sizeof (int);
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- bpmdetect_click");
+  mdebugSubTag ("bpmdetect_click");
+
+  pcm = mdmalloc (sizeof (int16_t) * CLICK_COUNT);
+  for (int i = 0; i < tcount; ++i) {
+    makeClickTrack (pcm, CLICK_COUNT, (double) tests [i], 0);
+    bpmdetectPCM (pcm, CLICK_COUNT, BPMDETECT_RATE, 0, 0, &result);
+    ck_assert_int_ge (result.bpm, tests [i] - 1);
+    ck_assert_int_le (result.bpm, tests [i] + 1);
+    ck_assert_int_ge (result.confidence, BPMDETECT_CONF_MIN);
+  }
+  mdfree (pcm);
+}
+END_TEST
+
+START_TEST(bpmdetect_click_noise)
+{
+  int16_t     *pcm;
+  bpmdetect_t result;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- bpmdetect_click_noise");
+  mdebugSubTag ("bpmdetect_click_noise");
+
+  pcm = mdmalloc (sizeof (int16_t) * CLICK_COUNT);
+  makeClickTrack (pcm, CLICK_COUNT, 120.0, 3000);
+  bpmdetectPCM (pcm, CLICK_COUNT, BPMDETECT_RATE, 0, 0, &result);
+  ck_assert_int_ge (result.bpm, 119);
+  ck_assert_int_le (result.bpm, 121);
+  ck_assert_int_ge (result.confidence, BPMDETECT_CONF_MIN);
+  mdfree (pcm);
+}
+END_TEST
+
+START_TEST(bpmdetect_range)
+{
+  int16_t     *pcm;
+  bpmdetect_t result;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- bpmdetect_range");
+  mdebugSubTag ("bpmdetect_range");
+
+  pcm = mdmalloc (sizeof (int16_t) * CLICK_COUNT);
+  /* a fast click-track limited to a slow range is found at half-time */
+  makeClickTrack (pcm, CLICK_COUNT, 180.0, 0);
+  bpmdetectPCM (pcm, CLICK_COUNT, BPMDETECT_RATE, 80, 100, &result);
+  ck_assert_int_ge (result.bpm, 89);
+  ck_assert_int_le (result.bpm, 91);
+  ck_assert_int_ge (result.confidence, BPMDETECT_CONF_MIN);
+  mdfree (pcm);
+}
+END_TEST
+
+START_TEST(bpmdetect_none)
+{
+  int16_t     *pcm;
+  bpmdetect_t result;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- bpmdetect_none");
+  mdebugSubTag ("bpmdetect_none");
+
+  pcm = mdmalloc (sizeof (int16_t) * CLICK_COUNT);
+
+  /* silence */
+  memset (pcm, 0, sizeof (int16_t) * CLICK_COUNT);
+  bpmdetectPCM (pcm, CLICK_COUNT, BPMDETECT_RATE, 0, 0, &result);
+  ck_assert_int_eq (result.bpm, 0);
+  ck_assert_int_eq (result.confidence, 0);
+
+  /* too short */
+  makeClickTrack (pcm, CLICK_COUNT, 120.0, 0);
+  bpmdetectPCM (pcm, BPMDETECT_RATE, BPMDETECT_RATE, 0, 0, &result);
+  ck_assert_int_eq (result.bpm, 0);
+  ck_assert_int_eq (result.confidence, 0);
+
+  /* noise only */
+  srand (1);
+  for (size_t i = 0; i < CLICK_COUNT; ++i) {
+    pcm [i] = (int16_t) ((rand () % 20000) - 10000);
+  }
+  bpmdetectPCM (pcm, CLICK_COUNT, BPMDETECT_RATE, 0, 0, &result);
+  ck_assert_int_lt (result.confidence, BPMDETECT_CONF_MIN);
+
+  mdfree (pcm);
+}
+END_TEST
+
+START_TEST(bpmdetect_dance_range)
+{
+  int         bpmlow;
+  int         bpmhigh;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- bpmdetect_dance_range");
+  mdebugSubTag ("bpmdetect_dance_range");
+
+  bpmdetectDanceRange (-1, &bpmlow, &bpmhigh);
+  ck_assert_int_eq (bpmlow, BPMDETECT_BPM_LOW);
+  ck_assert_int_eq (bpmhigh, BPMDETECT_BPM_HIGH);
+
+  /* argentine tango, 30-32 mpm, 4/4 */
+  bpmdetectDanceRange (0, &bpmlow, &bpmhigh);
+  ck_assert_int_le (bpmlow, 120);
+  ck_assert_int_gt (bpmlow, 100);
+  ck_assert_int_ge (bpmhigh, 128);
+  ck_assert_int_lt (bpmhigh, 150);
+}
+END_TEST
+
+START_TEST(bpmdetect_to_mpm)
+{
+  int16_t     *pcm;
+  bpmdetect_t result;
+  int         bpmlow;
+  int         bpmhigh;
+  int         mpm;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- bpmdetect_to_mpm");
+  mdebugSubTag ("bpmdetect_to_mpm");
+
+  ck_assert_int_eq (bpmdetectToMPM (-1, 120), 120);
+  ck_assert_int_eq (bpmdetectToMPM (0, 0), 0);
+  /* argentine tango, 4/4 */
+  ck_assert_int_eq (bpmdetectToMPM (0, 124), 31);
+  /* samba, 2/4 */
+  ck_assert_int_eq (bpmdetectToMPM (8, 100), 50);
+  /* waltz, 3/4 */
+  ck_assert_int_eq (bpmdetectToMPM (11, 84), 28);
+
+  /* the value stored in the bpm tag for a detected waltz, 29 mpm */
+  pcm = mdmalloc (sizeof (int16_t) * CLICK_COUNT);
+  makeClickTrack (pcm, CLICK_COUNT, 87.0, 0);
+  bpmdetectDanceRange (11, &bpmlow, &bpmhigh);
+  bpmdetectPCM (pcm, CLICK_COUNT, BPMDETECT_RATE, bpmlow, bpmhigh, &result);
+  ck_assert_int_ge (result.confidence, BPMDETECT_CONF_MIN);
+  mpm = bpmdetectToMPM (11, result.bpm);
+  ck_assert_int_eq (mpm, 29);
+  mdfree (pcm);
+}
+END_TEST
+
+Suite *
+bpmdetect_suite (void)
+{
+  Suite     *s;
+  TCase     *tc;
+
+  s = suite_create ("bpmdetect");
+  tc = tcase_create ("bpmdetect");
+  tcase_set_tags (tc, "libbdj4");
+  tcase_add_unchecked_fixture (tc, setup, teardown);
+  tcase_add_test (tc, bpmdetect_click);
+  tcase_add_test (tc, bpmdetect_click_noise);
+  tcase_add_test (tc, bpmdetect_range);
+  tcase_add_test (tc, bpmdetect_none);
+  tcase_add_test (tc, bpmdetect_dance_range);
+  tcase_add_test (tc, bpmdetect_to_mpm);
+  suite_add_tcase (s, tc);
+
+  return s;
+}
+
+/* a short decaying 1kHz burst on each beat */
+static void
+makeClickTrack (int16_t *pcm, size_t count, double bpm, int noise)
+{
+  double    period;
+  size_t    clicklen;
+  double    pos;
+
+  memset (pcm, 0, sizeof (int16_t) * count);
+  period = 60.0 / bpm * (double) BPMDETECT_RATE;
+  clicklen = BPMDETECT_RATE / 100;
+
+  for (pos = 0.0; pos < (double) count; pos += period) {
+    size_t    beg = (size_t) pos;
+
+    for (size_t j = 0; j < clicklen && beg + j < count; ++j) {
+      double  val;
+
+      val = 0.8 * 32767.0 *
+          sin (2.0 * M_PI * 1000.0 * (double) j / (double) BPMDETECT_RATE) *
+          exp (- (double) j / ((double) BPMDETECT_RATE / 400.0));
+      pcm [beg + j] = (int16_t) val;
+    }
+  }
+
+  if (noise > 0) {
+    srand (1);
+    for (size_t i = 0; i < count; ++i) {
+      int   val;
+
+      val = pcm [i] / 2 + (rand () % (noise * 2)) - noise;
+      pcm [i] = (int16_t) val;
+    }
+  }
+}
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
@@ -5,6 +5,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
 #include <sys/types.h>
@@ -32,6 +33,7 @@
 #include "log.h"
 #include "musicdb.h"
 #include "nlist.h"
+#include "osrandom.h"
 #include "slist.h"
 #include "templateutil.h"
 
@@ -39,6 +41,26 @@
 
 enum {
   TM_MAX_DANCE = 20,        // normally 14 or so in the standard template.
+  TM_DIST_COUNT = 6,
+  TM_DIST_SEL = 4000,
+  TM_DIST_SEED = 20240601,
+};
+
+/* recorded from the dancesel before the selection tables were added */
+#define TM_DIST_HASH 18303878225713386473ULL
+
+typedef struct {
+  const char  *dance;
+  int         count;
+} chkdistbase_t;
+
+static chkdistbase_t distbase [TM_DIST_COUNT] = {
+  { "Waltz", 1 },
+  { "Tango", 69 },
+  { "Foxtrot", 72 },
+  { "Rumba", 425 },
+  { "Cha Cha", 3433 },
+  { "Jive", 0 },
 };
 
 static char *dbfn = "data/musicdb.dat";
@@ -579,6 +601,107 @@ START_TEST(dancesel_mix)
 }
 END_TEST
 
+/* the selections using a fixed seed and a fixed history must match */
+/* the selections made by the dancesel before the selection tables */
+/* were added (with glibc's random()) */
+START_TEST(dancesel_distribution)
+{
+  dancesel_t  *ds;
+  nlist_t     *clist = NULL;
+  dance_t     *dances;
+  slist_t     *dlist;
+  ilistidx_t  didxarr [TM_DIST_COUNT];
+  ilistidx_t  seq [TM_DIST_SEL];
+  int         counts [TM_MAX_DANCE];
+  uint64_t    seqhash;
+  ilistidx_t  prevdidx;
+  ilistidx_t  priordidx;
+  int         i;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- dancesel_distribution");
+  mdebugSubTag ("dancesel_distribution");
+#if DANCESEL_DEBUG
+    fprintf (stderr, "-- dancesel_distribution\n");
+#endif
+
+  dances = bdjvarsdfGet (BDJVDF_DANCES);
+  dlist = danceGetDanceList (dances);
+
+  for (i = 0; i < TM_DIST_COUNT; ++i) {
+    didxarr [i] = slistGetNum (dlist, distbase [i].dance);
+    ck_assert_int_ge (didxarr [i], 0);
+  }
+
+  clist = nlistAlloc ("count-list", LIST_ORDERED, NULL);
+  for (i = 0; i < TM_DIST_COUNT; ++i) {
+    nlistSetNum (clist, didxarr [i], 6);
+  }
+  for (i = 0; i < TM_MAX_DANCE; ++i) {
+    counts [i] = 0;
+  }
+
+  /* the history is not changed, and no counts are added, so the */
+  /* weights stay the same for every selection */
+  priordidx = slistGetNum (dlist, "Rumba");
+  prevdidx = slistGetNum (dlist, "Waltz");
+  gprior = 0;
+  saveToQueue (priordidx);
+  saveToQueue (prevdidx);
+
+  ds = danceselAlloc (clist, chkQueue, NULL);
+#if _lib_srandom
+  srandom (TM_DIST_SEED);
+#endif
+  seqhash = 0;
+  for (i = 0; i < TM_DIST_SEL; ++i) {
+    ilistidx_t  didx;
+
+    didx = danceselSelect (ds, gprior);
+    ck_assert_int_ge (didx, 0);
+    ck_assert_int_lt (didx, TM_MAX_DANCE);
+    ++counts [didx];
+    seq [i] = didx;
+    seqhash = seqhash * 31 + (uint64_t) didx;
+  }
+  danceselFree (ds);
+
+  for (i = 0; i < TM_DIST_COUNT; ++i) {
+    ilistidx_t  didx = didxarr [i];
+#if ! defined (__GLIBC__)
+    double      prob;
+    double      range;
+#endif
+
+#if defined (__GLIBC__)
+    ck_assert_int_eq (counts [didx], distbase [i].count);
+#else
+    /* a different random() sequence, the proportions must still match */
+    prob = (double) distbase [i].count / (double) TM_DIST_SEL;
+    range = 5.0 * sqrt (TM_DIST_SEL * prob * (1.0 - prob)) + 5.0;
+    ck_assert_double_le (fabs ((double) counts [didx] - TM_DIST_SEL * prob), range);
+#endif
+  }
+#if defined (__GLIBC__)
+  ck_assert_uint_eq (seqhash, TM_DIST_HASH);
+#endif
+
+#if _lib_srandom
+  /* the same seed produces the same selections */
+  ds = danceselAlloc (clist, chkQueue, NULL);
+  srandom (TM_DIST_SEED);
+  for (i = 0; i < TM_DIST_SEL; ++i) {
+    ck_assert_int_eq (danceselSelect (ds, gprior), seq [i]);
+  }
+  danceselFree (ds);
+  sRandom ();
+#endif
+
+  nlistFree (clist);
+  nlistFree (ghist);
+  ghist = NULL;
+}
+END_TEST
+
 Suite *
 dancesel_suite (void)
 {
@@ -598,6 +721,7 @@ dancesel_suite (void)
   tcase_add_test (tc, dancesel_choose_multi_tag);
   tcase_add_test (tc, dancesel_choose_fast);
   tcase_add_test (tc, dancesel_mix);
+  tcase_add_test (tc, dancesel_distribution);
   suite_add_tcase (s, tc);
   return s;
 }
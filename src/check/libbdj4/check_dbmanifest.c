@@ -0,0 +1,197 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "bdj4.h"
+#include "check_bdj.h"
+#include "dbmanifest.h"
+#include "dirop.h"
+#include "fileop.h"
+#include "log.h"
+#include "mdebug.h"
+#include "sysvars.h"
+
+#define MANIFEST_FN   "tmp/dbmanifest.txt"
+#define MANIFEST_DIR  "tmp/dbman"
+
+static char *chkfiles [] = {
+  MANIFEST_DIR "/a/abc.mp3",
+  MANIFEST_DIR "/a/def.mp3",
+  MANIFEST_DIR "/b/ghi.mp3",
+};
+enum {
+  CHK_FILE_MAX = sizeof (chkfiles) / sizeof (char *),
+};
+
+static void chkWriteFile (const char *fn, const char *data, time_t mtime);
+static void chkCheckAll (const char *musicdir, bool load, bool loaded, dbmanifestrc_t exprc);
+
+static void
+setup (void)
+{
+  time_t    tm;
+
+  diropDeleteDir (MANIFEST_DIR, DIROP_ALL);
+  fileopDelete (MANIFEST_FN);
+  diropMakeDir (MANIFEST_DIR "/a");
+  diropMakeDir (MANIFEST_DIR "/b");
+
+  /* the files and directories must be older than the start of the */
+  /* scan, otherwise they are always checked */
+  tm = time (NULL) - 100;
+  for (int i = 0; i < CHK_FILE_MAX; ++i) {
+    chkWriteFile (chkfiles [i], "abc", tm);
+  }
+  fileopSetModTime (MANIFEST_DIR "/a", tm);
+  fileopSetModTime (MANIFEST_DIR "/b", tm);
+}
+
+static void
+teardown (void)
+{
+  diropDeleteDir (MANIFEST_DIR, DIROP_ALL);
+  fileopDelete (MANIFEST_FN);
+}
+
+START_TEST(dbmanifest_alloc)
+{
+  dbmanifest_t  *dbmanifest;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- dbmanifest_alloc");
+  mdebugSubTag ("dbmanifest_alloc");
+
+  dbmanifest = dbmanifestAlloc (MANIFEST_FN, MANIFEST_DIR, true);
+  ck_assert_ptr_nonnull (dbmanifest);
+  ck_assert_int_eq (dbmanifestIsLoaded (dbmanifest), false);
+  dbmanifestFree (dbmanifest);
+}
+END_TEST
+
+START_TEST(dbmanifest_unchanged)
+{
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- dbmanifest_unchanged");
+  mdebugSubTag ("dbmanifest_unchanged");
+
+  /* no manifest */
+  chkCheckAll (MANIFEST_DIR, true, false, DBMANIFEST_NEW);
+  ck_assert_int_eq (fileopFileExists (MANIFEST_FN), true);
+  chkCheckAll (MANIFEST_DIR, true, true, DBMANIFEST_UNCHANGED);
+  /* the unchanged entries are carried over */
+  chkCheckAll (MANIFEST_DIR, true, true, DBMANIFEST_UNCHANGED);
+  /* the existing manifest is not used */
+  chkCheckAll (MANIFEST_DIR, false, false, DBMANIFEST_NEW);
+  chkCheckAll (MANIFEST_DIR, true, true, DBMANIFEST_UNCHANGED);
+  /* a different music folder invalidates the manifest */
+  chkCheckAll ("tmp/other", true, false, DBMANIFEST_NEW);
+}
+END_TEST
+
+START_TEST(dbmanifest_changed)
+{
+  dbmanifest_t    *dbmanifest;
+  dbmanifestrc_t  rc;
+  time_t          tm;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- dbmanifest_changed");
+  mdebugSubTag ("dbmanifest_changed");
+
+  chkCheckAll (MANIFEST_DIR, true, false, DBMANIFEST_NEW);
+
+  /* a new file changes the directory's modification time */
+  tm = time (NULL) - 50;
+  chkWriteFile (MANIFEST_DIR "/a/jkl.mp3", "abc", tm);
+  chkWriteFile (MANIFEST_DIR "/a/def.mp3", "abcdef", tm);
+
+  dbmanifest = dbmanifestAlloc (MANIFEST_FN, MANIFEST_DIR, true);
+  ck_assert_int_eq (dbmanifestIsLoaded (dbmanifest), true);
+  rc = dbmanifestCheckFile (dbmanifest, MANIFEST_DIR "/a/abc.mp3");
+  ck_assert_int_eq (rc, DBMANIFEST_UNCHANGED);
+  rc = dbmanifestCheckFile (dbmanifest, MANIFEST_DIR "/a/def.mp3");
+  ck_assert_int_eq (rc, DBMANIFEST_CHANGED);
+  rc = dbmanifestCheckFile (dbmanifest, MANIFEST_DIR "/a/jkl.mp3");
+  ck_assert_int_eq (rc, DBMANIFEST_NEW);
+  rc = dbmanifestCheckFile (dbmanifest, MANIFEST_DIR "/b/ghi.mp3");
+  ck_assert_int_eq (rc, DBMANIFEST_UNCHANGED);
+  /* the file is not recorded if it does not exist */
+  rc = dbmanifestCheckFile (dbmanifest, MANIFEST_DIR "/a/none.mp3");
+  ck_assert_int_eq (rc, DBMANIFEST_NEW);
+  dbmanifestSave (dbmanifest);
+  dbmanifestFree (dbmanifest);
+
+  /* the directory was modified after the scan started, */
+  /* and must be checked again. */
+  /* the files in the directory have not changed */
+  dbmanifest = dbmanifestAlloc (MANIFEST_FN, MANIFEST_DIR, true);
+  rc = dbmanifestCheckFile (dbmanifest, MANIFEST_DIR "/a/def.mp3");
+  ck_assert_int_eq (rc, DBMANIFEST_UNCHANGED);
+  rc = dbmanifestCheckFile (dbmanifest, MANIFEST_DIR "/a/jkl.mp3");
+  ck_assert_int_eq (rc, DBMANIFEST_UNCHANGED);
+  dbmanifestFree (dbmanifest);
+}
+END_TEST
+
+Suite *
+dbmanifest_suite (void)
+{
+  Suite     *s;
+  TCase     *tc;
+
+  s = suite_create ("dbmanifest");
+  tc = tcase_create ("dbmanifest");
+  tcase_set_tags (tc, "libbdj4");
+  tcase_add_checked_fixture (tc, setup, teardown);
+  tcase_add_test (tc, dbmanifest_alloc);
+  tcase_add_test (tc, dbmanifest_unchanged);
+  tcase_add_test (tc, dbmanifest_changed);
+  suite_add_tcase (s, tc);
+
+  return s;
+}
+
+static void
+chkWriteFile (const char *fn, const char *data, time_t mtime)
+{
+  FILE    *fh;
+
+  fh = fileopOpen (fn, "w");
+  ck_assert_ptr_nonnull (fh);
+  fputs (data, fh);
+  mdextfclose (fh);
+  fclose (fh);
+  fileopSetModTime (fn, mtime);
+}
+
+static void
+chkCheckAll (const char *musicdir, bool load, bool loaded, dbmanifestrc_t exprc)
+{
+  dbmanifest_t    *dbmanifest;
+  dbmanifestrc_t  rc;
+
+  dbmanifest = dbmanifestAlloc (MANIFEST_FN, musicdir, load);
+  ck_assert_int_eq (dbmanifestIsLoaded (dbmanifest), loaded);
+  for (int i = 0; i < CHK_FILE_MAX; ++i) {
+    rc = dbmanifestCheckFile (dbmanifest, chkfiles [i]);
+    ck_assert_int_eq (rc, exprc);
+  }
+  dbmanifestSave (dbmanifest);
+  dbmanifestFree (dbmanifest);
+}
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
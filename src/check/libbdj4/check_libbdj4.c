@@ -41,6 +41,7 @@ check_libbdj4 (SRunner *sr)
    *  song                  complete
    *  musicdb               complete
    *  songlist              complete 2023-7-18
+   *  songlistidx           complete 2026-10-18
    *  autosel               complete
    *  songfilter            complete
    *  dancesel              complete
@@ -54,7 +55,7 @@ check_libbdj4 (SRunner *sr)
    *  orgutil               partial
    *  dispsel               complete
    *  samesong              complete
-   *  songdb
+   *  songdb                partial 2026-10-18 (batch rename)
    *  msgparse              complete 2022-12-27
    *  audioadjust
    *  templateutil          complete // needed by tests; needs localized tests
@@ -63,6 +64,8 @@ check_libbdj4 (SRunner *sr)
    *  musicq                complete
    *  orgopt                complete
    *  volreg                complete 2022-12-27 (missing lock tests)
+   *  bpmdetect             complete 2026-10-18 (file decode not tested)
+   *  dbmanifest            complete 2026-10-18
    *  m3u
    *  jspf
    *  songlistutil
@@ -117,6 +120,9 @@ check_libbdj4 (SRunner *sr)
   s = songlist_suite();
   srunner_add_suite (sr, s);
 
+  s = songlistidx_suite();
+  srunner_add_suite (sr, s);
+
   s = autosel_suite();
   srunner_add_suite (sr, s);
 
@@ -151,7 +157,8 @@ check_libbdj4 (SRunner *sr)
   s = samesong_suite();
   srunner_add_suite (sr, s);
 
-  /* songdb */
+  s = songdb_suite();
+  srunner_add_suite (sr, s);
 
   s = msgparse_suite();
   srunner_add_suite (sr, s);
@@ -176,6 +183,12 @@ check_libbdj4 (SRunner *sr)
   s = volreg_suite();
   srunner_add_suite (sr, s);
 
+  s = bpmdetect_suite();
+  srunner_add_suite (sr, s);
+
+  s = dbmanifest_suite();
+  srunner_add_suite (sr, s);
+
   /* m3u */
 
   /* jspf */
@@ -36,6 +36,7 @@
 
 static bool updateSSList (nlist_t *tlist, ssize_t ssidx);
 static void ssListGetCounts (nlist_t *tlist, int *ucount, int *totcount);
+static void ssCheckCounts (samesong_t *ss);
 
 static char *dbfn = "data/musicdb.dat";
 static musicdb_t *db = NULL;
@@ -840,6 +841,93 @@ START_TEST(samesong_clear)
 }
 END_TEST
 
+START_TEST(samesong_count)
+{
+  samesong_t    *ss = NULL;
+  dbidx_t       dbidx;
+  song_t        *song = NULL;
+  ssize_t       ssidx;
+  ssize_t       markssidx;
+  int           tcount;
+  dbidx_t       dbiteridx;
+  nlist_t       *tlist = NULL;
+  nlist_t       *ndbidxlist = NULL;
+  nlistidx_t    iteridx;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- samesong_count");
+  mdebugSubTag ("samesong_count");
+
+  ss = samesongAlloc (db);
+  ssCheckCounts (ss);
+  ck_assert_int_eq (samesongGetCount (ss, 0), 0);
+  ck_assert_int_eq (samesongGetCount (ss, -1), 0);
+
+  ndbidxlist = nlistAlloc ("chk-ss-cnt-ndb", LIST_ORDERED, NULL);
+  dbStartIterator (db, &dbiteridx);
+  while ((song = dbIterate (db, &dbidx, &dbiteridx)) != NULL) {
+    ssidx = songGetNum (song, TAG_SAMESONG);
+    if (ssidx <= 0) {
+      nlistSetNum (ndbidxlist, dbidx, 1);
+    }
+  }
+
+  /* zero marks, choose the first 4 from the n-db-list */
+  tlist = nlistAlloc ("chk-ss-cnt-n14", LIST_ORDERED, NULL);
+  tcount = 0;
+  nlistStartIterator (ndbidxlist, &iteridx);
+  while ((dbidx = nlistIterateKey (ndbidxlist, &iteridx)) >= 0) {
+    ++tcount;
+    nlistSetNum (tlist, dbidx, 0);
+    if (tcount > 3) {
+      break;
+    }
+  }
+  samesongSet (ss, tlist);
+  dbidx = nlistGetKeyByIdx (tlist, 0);
+  song = dbGetByIdx (db, dbidx);
+  markssidx = songGetNum (song, TAG_SAMESONG);
+  ck_assert_int_eq (samesongGetCount (ss, markssidx), 4);
+  ssCheckCounts (ss);
+  nlistFree (tlist);
+
+  /* many marks: one song from the new mark and one song */
+  /* with an existing mark */
+  tlist = nlistAlloc ("chk-ss-cnt-many", LIST_ORDERED, NULL);
+  nlistSetNum (tlist, dbidx, 0);
+  dbStartIterator (db, &dbiteridx);
+  while ((song = dbIterate (db, &dbidx, &dbiteridx)) != NULL) {
+    ssidx = songGetNum (song, TAG_SAMESONG);
+    if (ssidx > 0 && ssidx != markssidx) {
+      nlistSetNum (tlist, dbidx, 0);
+      break;
+    }
+  }
+  ck_assert_int_eq (nlistGetCount (tlist), 2);
+  samesongSet (ss, tlist);
+  ck_assert_int_eq (samesongGetCount (ss, markssidx), 3);
+  ssCheckCounts (ss);
+  nlistFree (tlist);
+
+  /* clear the remaining songs with the mark */
+  tlist = nlistAlloc ("chk-ss-cnt-clear", LIST_ORDERED, NULL);
+  dbStartIterator (db, &dbiteridx);
+  while ((song = dbIterate (db, &dbidx, &dbiteridx)) != NULL) {
+    ssidx = songGetNum (song, TAG_SAMESONG);
+    if (ssidx == markssidx) {
+      nlistSetNum (tlist, dbidx, 0);
+    }
+  }
+  ck_assert_int_eq (nlistGetCount (tlist), 3);
+  samesongClear (ss, tlist);
+  ck_assert_int_eq (samesongGetCount (ss, markssidx), 0);
+  ck_assert_ptr_null (samesongGetColorBySSIdx (ss, markssidx));
+  ssCheckCounts (ss);
+  nlistFree (tlist);
+
+  nlistFree (ndbidxlist);
+  samesongFree (ss);
+}
+END_TEST
 
 Suite *
 samesong_suite (void)
@@ -858,6 +946,7 @@ samesong_suite (void)
   tcase_add_test (tc, samesong_set);
   tcase_add_test (tc, samesong_singleton);
   tcase_add_test (tc, samesong_clear);
+  tcase_add_test (tc, samesong_count);
   suite_add_tcase (s, tc);
 
   return s;
@@ -896,5 +985,37 @@ ssListGetCounts (nlist_t *tlist, int *ucount, int *totcount)
   }
 }
 
+/* the counts must match a scan of the database */
+static void
+ssCheckCounts (samesong_t *ss)
+{
+  nlist_t     *tlist;
+  nlistidx_t  iteridx;
+  dbidx_t     dbidx;
+  dbidx_t     dbiteridx;
+  song_t      *song;
+  ssize_t     ssidx;
+
+  tlist = nlistAlloc ("chk-ss-counts", LIST_ORDERED, NULL);
+  dbStartIterator (db, &dbiteridx);
+  while ((song = dbIterate (db, &dbidx, &dbiteridx)) != NULL) {
+    ssidx = songGetNum (song, TAG_SAMESONG);
+    if (ssidx > 0) {
+      updateSSList (tlist, ssidx);
+    }
+  }
+
+  nlistStartIterator (tlist, &iteridx);
+  while ((ssidx = nlistIterateKey (tlist, &iteridx)) > 0) {
+    ck_assert_int_eq (samesongGetCount (ss, ssidx), nlistGetNum (tlist, ssidx));
+    if (nlistGetNum (tlist, ssidx) == 1) {
+      ck_assert_ptr_null (samesongGetColorBySSIdx (ss, ssidx));
+    } else {
+      ck_assert_ptr_nonnull (samesongGetColorBySSIdx (ss, ssidx));
+    }
+  }
+  nlistFree (tlist);
+}
+
 #pragma clang diagnostic pop
 #pragma GCC diagnostic pop
@@ -0,0 +1,260 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "audiosrc.h"
+#include "bdj4.h"
+#include "bdjopt.h"
+#include "bdjvars.h"
+#include "bdjvarsdfload.h"
+#include "check_bdj.h"
+#include "dirop.h"
+#include "filedata.h"
+#include "filemanip.h"
+#include "fileop.h"
+#include "log.h"
+#include "mdebug.h"
+#include "musicdb.h"
+#include "song.h"
+#include "songdb.h"
+#include "songlist.h"
+#include "songlistidx.h"
+#include "tagdef.h"
+#include "templateutil.h"
+
+#define SDB_DBFN      "tmp/chk-songdb.dat"
+#define SDB_MUSIC     "tmp/chk-songdb-music"
+#define SDB_SLA       "chk-songdb-a"
+#define SDB_SLFFNA    "data/chk-songdb-a.songlist"
+#define SDB_SLB       "chk-songdb-b"
+#define SDB_SLFFNB    "data/chk-songdb-b.songlist"
+#define SDB_SLIDX_FFN "data/songlistidx.txt"
+#define SDB_EXISTS    SDB_MUSIC "/Waltz/Exists.mp3"
+
+typedef struct {
+  const char  *uri;
+  const char  *title;
+  const char  *newuri;
+  int32_t     retflag;
+} chksdbsong_t;
+
+/* the organization path is {%DANCE%/}{%TITLE%} */
+static chksdbsong_t songs [] = {
+  /* two songs with the same new name are not renamed */
+  { "chk-songdb-a.mp3", "Same", NULL, SONGDB_RET_REN_FILE_EXISTS },
+  { "chk-songdb-b.mp3", "Same", NULL, SONGDB_RET_REN_FILE_EXISTS },
+  { "chk-songdb-c.mp3", "Other", "Waltz/Other.mp3", SONGDB_RET_RENAME_SUCCESS },
+  /* the new name is an existing file */
+  { "chk-songdb-d.mp3", "Exists", NULL, SONGDB_RET_REN_FILE_EXISTS },
+  { "chk-songdb-e.mp3", "Another", "Waltz/Another.mp3", SONGDB_RET_RENAME_SUCCESS },
+};
+enum {
+  songsz = sizeof (songs) / sizeof (chksdbsong_t),
+};
+
+static void chkSongdbCreateSonglist (musicdb_t *db, const char *name, int *idx, int count);
+
+static void
+setup (void)
+{
+  templateFileCopy ("dancetypes.txt", "dancetypes.txt");
+  templateFileCopy ("dances.txt", "dances.txt");
+  templateFileCopy ("genres.txt", "genres.txt");
+  templateFileCopy ("levels.txt", "levels.txt");
+  templateFileCopy ("ratings.txt", "ratings.txt");
+  filemanipCopy ("test-templates/status.txt", "data/status.txt");
+
+  bdjoptInit ();
+  bdjoptSetStr (OPT_M_DIR_MUSIC, SDB_MUSIC);
+  bdjoptSetStr (OPT_G_ORGPATH, "{%DANCE%/}{%TITLE%}");
+  bdjoptSetNum (OPT_G_AUTOORGANIZE, true);
+  bdjoptSetNum (OPT_G_WRITETAGS, WRITE_TAGS_NONE);
+  bdjvarsInit ();
+  bdjvarsdfloadInit ();
+  audiosrcInit ();
+}
+
+static void
+teardown (void)
+{
+  songlistidxCleanup ();
+  diropDeleteDir (SDB_MUSIC, DIROP_ALL);
+  unlink (SDB_DBFN);
+  unlink (SDB_SLFFNA);
+  unlink (SDB_SLFFNA ".bak.1");
+  unlink (SDB_SLFFNB);
+  unlink (SDB_SLFFNB ".bak.1");
+  unlink (SDB_SLIDX_FFN);
+
+  audiosrcCleanup ();
+  bdjvarsdfloadCleanup ();
+  bdjvarsCleanup ();
+  bdjoptCleanup ();
+}
+
+START_TEST(songdb_batch_rename)
+{
+  musicdb_t     *db;
+  songdb_t      *songdb;
+  song_t        *song;
+  songlist_t    *sl;
+  ilistidx_t    sliter;
+  ilistidx_t    key;
+  FILE          *fh;
+  char          tbuff [1024];
+  char          *data;
+  size_t        len;
+  int           slaidx [] = { 0, 2, 4 };
+  int           slbidx [] = { 3, 1 };
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- songdb_batch_rename");
+  mdebugSubTag ("songdb_batch_rename");
+
+  diropDeleteDir (SDB_MUSIC, DIROP_ALL);
+  diropMakeDir (SDB_MUSIC "/Waltz");
+  unlink (SDB_DBFN);
+  unlink (SDB_SLFFNA ".bak.1");
+  unlink (SDB_SLFFNB ".bak.1");
+
+  fh = fileopOpen (SDB_EXISTS, "w");
+  mdextfclose (fh);
+  fclose (fh);
+
+  db = dbOpen (SDB_DBFN);
+  ck_assert_ptr_nonnull (db);
+  for (int i = 0; i < songsz; ++i) {
+    song = songAlloc ();
+    snprintf (tbuff, sizeof (tbuff),
+        "URI\n..%s\nDANCE\n..Waltz\nTITLE\n..%s\nDURATION\n..180000\n",
+        songs [i].uri, songs [i].title);
+    songParse (song, tbuff, i);
+    songSetNum (song, TAG_RRN, MUSICDB_ENTRY_NEW);
+    songSetNum (song, TAG_DB_FLAGS, MUSICDB_STD);
+    dbWriteSong (db, song);
+    songFree (song);
+
+    snprintf (tbuff, sizeof (tbuff), "%s/%s", SDB_MUSIC, songs [i].uri);
+    fh = fileopOpen (tbuff, "w");
+    mdextfclose (fh);
+    fclose (fh);
+  }
+  dbClose (db);
+
+  db = dbOpen (SDB_DBFN);
+  ck_assert_int_eq (dbCount (db), songsz);
+
+  chkSongdbCreateSonglist (db, SDB_SLA, slaidx, sizeof (slaidx) / sizeof (int));
+  chkSongdbCreateSonglist (db, SDB_SLB, slbidx, sizeof (slbidx) / sizeof (int));
+  songlistidxRebuild ();
+
+  songdb = songdbAlloc (db);
+  songdbStartBatch (songdb);
+  songdbPlanRenames (songdb);
+
+  for (int i = 0; i < songsz; ++i) {
+    int32_t     flags;
+
+    song = dbGetByName (db, songs [i].uri);
+    ck_assert_ptr_nonnull (song);
+    flags = SONGDB_FORCE_WRITE;
+    songdbWriteDBSong (songdb, song, &flags, songGetNum (song, TAG_RRN));
+    ck_assert_int_eq (flags & songs [i].retflag, songs [i].retflag);
+    if (songs [i].newuri == NULL) {
+      ck_assert_str_eq (songGetStr (song, TAG_URI), songs [i].uri);
+      snprintf (tbuff, sizeof (tbuff), "%s/%s", SDB_MUSIC, songs [i].uri);
+      ck_assert_int_eq (fileopFileExists (tbuff), true);
+    } else {
+      ck_assert_str_eq (songGetStr (song, TAG_URI), songs [i].newuri);
+      snprintf (tbuff, sizeof (tbuff), "%s/%s", SDB_MUSIC, songs [i].newuri);
+      ck_assert_int_eq (fileopFileExists (tbuff), true);
+    }
+  }
+
+  /* the song lists are not changed until the end of the batch */
+  ck_assert_int_eq (fileopFileExists (SDB_SLFFNA ".bak.1"), false);
+  songdbEndBatch (songdb);
+  songdbFree (songdb);
+
+  sl = songlistLoad (SDB_SLA);
+  ck_assert_ptr_nonnull (sl);
+  songlistStartIterator (sl, &sliter);
+  while ((key = songlistIterate (sl, &sliter)) >= 0) {
+    chksdbsong_t  *tsong;
+
+    tsong = &songs [slaidx [key]];
+    if (tsong->newuri == NULL) {
+      ck_assert_str_eq (songlistGetStr (sl, key, SONGLIST_URI), tsong->uri);
+    } else {
+      ck_assert_str_eq (songlistGetStr (sl, key, SONGLIST_URI), tsong->newuri);
+    }
+  }
+  songlistFree (sl);
+
+  /* the song list was saved once: the backup is the original, */
+  /* not a copy with only one of the two renames */
+  ck_assert_int_eq (fileopFileExists (SDB_SLFFNA ".bak.1"), true);
+  data = filedataReadAll (SDB_SLFFNA ".bak.1", &len);
+  ck_assert_ptr_nonnull (data);
+  ck_assert_ptr_nonnull (strstr (data, "..chk-songdb-c.mp3\n"));
+  ck_assert_ptr_nonnull (strstr (data, "..chk-songdb-e.mp3\n"));
+  mdfree (data);
+
+  /* no song in the second song list was renamed */
+  ck_assert_int_eq (fileopFileExists (SDB_SLFFNB ".bak.1"), false);
+
+  dbClose (db);
+}
+END_TEST
+
+Suite *
+songdb_suite (void)
+{
+  Suite     *s;
+  TCase     *tc;
+
+  s = suite_create ("songdb");
+  tc = tcase_create ("songdb");
+  tcase_set_tags (tc, "libbdj4");
+  tcase_add_unchecked_fixture (tc, setup, teardown);
+  tcase_add_test (tc, songdb_batch_rename);
+  suite_add_tcase (s, tc);
+  return s;
+}
+
+static void
+chkSongdbCreateSonglist (musicdb_t *db, const char *name, int *idx, int count)
+{
+  songlist_t    *sl;
+  song_t        *song;
+
+  sl = songlistCreate (name);
+  for (int i = 0; i < count; ++i) {
+    song = dbGetByName (db, songs [idx [i]].uri);
+    ck_assert_ptr_nonnull (song);
+    songlistSetStr (sl, i, SONGLIST_URI, songs [idx [i]].uri);
+    songlistSetStr (sl, i, SONGLIST_TITLE, songs [idx [i]].title);
+    songlistSetNum (sl, i, SONGLIST_DANCE, songGetNum (song, TAG_DANCE));
+  }
+  songlistSave (sl, SONGLIST_UPDATE_TIMESTAMP, 1);
+  songlistFree (sl);
+}
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
@@ -0,0 +1,350 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "bdj4.h"
+#include "bdjopt.h"
+#include "bdjvarsdfload.h"
+#include "check_bdj.h"
+#include "dirlist.h"
+#include "filemanip.h"
+#include "fileop.h"
+#include "ilist.h"
+#include "log.h"
+#include "mdebug.h"
+#include "pathinfo.h"
+#include "slist.h"
+#include "songlist.h"
+#include "songlistidx.h"
+#include "templateutil.h"
+#include "tmutil.h"
+
+#define SLIDX_FFN   "data/songlistidx.txt"
+#define SLFNA       "test-sl-a"
+#define SLFNE       "test-sl-e"
+#define SLFFNE      "data/test-sl-e.songlist"
+#define SLFNH       "test-sl-h"
+#define SLFFNH      "data/test-sl-h.songlist"
+#define SLURI_A     "001-chacha.mp3"
+#define SLURI_E     "004-salsa.mp3"
+#define SLURI_NEW   "chk-slidx-new.mp3"
+
+static void chkCompare (void);
+static slist_t *chkScan (const char *uri);
+static void chkCompareUri (const char *uri);
+
+static void
+setup (void)
+{
+  templateFileCopy ("dancetypes.txt", "dancetypes.txt");
+  templateFileCopy ("dances.txt", "dances.txt");
+  templateFileCopy ("genres.txt", "genres.txt");
+  templateFileCopy ("levels.txt", "levels.txt");
+  templateFileCopy ("ratings.txt", "ratings.txt");
+  filemanipCopy ("test-templates/test-sl-a.songlist", "data/test-sl-a.songlist");
+  filemanipCopy ("test-templates/test-sl-e.songlist", SLFFNE);
+  filemanipCopy ("test-templates/test-sl-h.songlist", SLFFNH);
+
+  bdjoptInit ();
+  bdjvarsdfloadInit ();
+
+  unlink (SLIDX_FFN);
+}
+
+static void
+teardown (void)
+{
+  songlistidxCleanup ();
+  filemanipCopy ("test-templates/test-sl-a.songlist", "data/test-sl-a.songlist");
+  unlink (SLFFNE);
+  unlink (SLFFNH);
+  unlink (SLIDX_FFN);
+
+  bdjvarsdfloadCleanup ();
+  bdjoptCleanup ();
+}
+
+START_TEST(songlistidx_rebuild)
+{
+  slist_t   *names;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- songlistidx_rebuild");
+  mdebugSubTag ("songlistidx_rebuild");
+
+  songlistidxRebuild ();
+  ck_assert_int_eq (fileopFileExists (SLIDX_FFN), true);
+
+  names = songlistidxGetSonglists (SLURI_E);
+  ck_assert_int_ge (slistGetIdx (names, SLFNE), 0);
+  ck_assert_int_lt (slistGetIdx (names, SLFNH), 0);
+  slistFree (names);
+
+  names = songlistidxGetSonglists ("no-such-song.mp3");
+  ck_assert_int_eq (slistGetCount (names), 0);
+  slistFree (names);
+
+  chkCompare ();
+}
+END_TEST
+
+START_TEST(songlistidx_bylist)
+{
+  slist_t     *urilist;
+  slist_t     *names;
+  slist_t     *tnames;
+  slistidx_t  iteridx;
+  const char  *name;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- songlistidx_bylist");
+  mdebugSubTag ("songlistidx_bylist");
+
+  songlistidxRebuild ();
+
+  urilist = slistAlloc ("chk-slidx-uris", LIST_ORDERED, NULL);
+  names = songlistidxGetSonglistsByList (urilist);
+  ck_assert_int_eq (slistGetCount (names), 0);
+  slistFree (names);
+
+  slistSetNum (urilist, "no-such-song.mp3", 0);
+  names = songlistidxGetSonglistsByList (urilist);
+  ck_assert_int_eq (slistGetCount (names), 0);
+  slistFree (names);
+
+  /* the result is the union of the look-ups of each uri */
+  slistSetNum (urilist, SLURI_A, 0);
+  slistSetNum (urilist, SLURI_E, 0);
+  names = songlistidxGetSonglistsByList (urilist);
+  ck_assert_int_ge (slistGetIdx (names, SLFNA), 0);
+  ck_assert_int_ge (slistGetIdx (names, SLFNE), 0);
+
+  tnames = songlistidxGetSonglists (SLURI_A);
+  slistStartIterator (tnames, &iteridx);
+  while ((name = slistIterateKey (tnames, &iteridx)) != NULL) {
+    ck_assert_int_ge (slistGetIdx (names, name), 0);
+  }
+  slistFree (tnames);
+  tnames = songlistidxGetSonglists (SLURI_E);
+  slistStartIterator (tnames, &iteridx);
+  while ((name = slistIterateKey (tnames, &iteridx)) != NULL) {
+    ck_assert_int_ge (slistGetIdx (names, name), 0);
+  }
+  slistFree (tnames);
+  ck_assert_int_lt (slistGetIdx (names, SLFNH), 0);
+
+  slistFree (names);
+  slistFree (urilist);
+}
+END_TEST
+
+START_TEST(songlistidx_persist)
+{
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- songlistidx_persist");
+  mdebugSubTag ("songlistidx_persist");
+
+  songlistidxRebuild ();
+  songlistidxCleanup ();
+
+  /* the index is loaded from the file */
+  chkCompare ();
+  songlistidxCleanup ();
+
+  /* a bad index file is re-built */
+  filemanipCopy (SLFFNE, SLIDX_FFN);
+  chkCompare ();
+}
+END_TEST
+
+START_TEST(songlistidx_save)
+{
+  songlist_t    *sl;
+  slist_t       *names;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- songlistidx_save");
+  mdebugSubTag ("songlistidx_save");
+
+  songlistidxRebuild ();
+
+  /* the song list save updates the index */
+  sl = songlistLoad (SLFNH);
+  ck_assert_ptr_nonnull (sl);
+  songlistSetStr (sl, 0, SONGLIST_URI, SLURI_NEW);
+  songlistSetStr (sl, 1, SONGLIST_URI, SLURI_E);
+  songlistSave (sl, SONGLIST_PRESERVE_TIMESTAMP, SONGLIST_USE_DIST_VERSION);
+  songlistFree (sl);
+
+  names = songlistidxGetSonglists (SLURI_NEW);
+  ck_assert_int_eq (slistGetCount (names), 1);
+  ck_assert_int_ge (slistGetIdx (names, SLFNH), 0);
+  slistFree (names);
+
+  names = songlistidxGetSonglists (SLURI_E);
+  ck_assert_int_ge (slistGetIdx (names, SLFNE), 0);
+  ck_assert_int_ge (slistGetIdx (names, SLFNH), 0);
+  slistFree (names);
+
+  chkCompare ();
+
+  /* the change is in the saved index file */
+  songlistidxCleanup ();
+  chkCompareUri (SLURI_NEW);
+  chkCompare ();
+}
+END_TEST
+
+START_TEST(songlistidx_changed)
+{
+  slist_t   *names;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- songlistidx_changed");
+  mdebugSubTag ("songlistidx_changed");
+
+  songlistidxRebuild ();
+
+  /* a song list changed without a save is re-scanned */
+  filemanipCopy ("test-templates/test-sl-e.songlist", SLFFNH);
+  names = songlistidxGetSonglists (SLURI_E);
+  ck_assert_int_ge (slistGetIdx (names, SLFNH), 0);
+  slistFree (names);
+  chkCompare ();
+
+  /* a removed song list is dropped */
+  unlink (SLFFNE);
+  names = songlistidxGetSonglists (SLURI_E);
+  ck_assert_int_lt (slistGetIdx (names, SLFNE), 0);
+  slistFree (names);
+  chkCompare ();
+
+  names = songlistidxGetSonglists (SLURI_A);
+  ck_assert_int_ge (slistGetIdx (names, SLFNA), 0);
+  slistFree (names);
+}
+END_TEST
+
+Suite *
+songlistidx_suite (void)
+{
+  Suite     *s;
+  TCase     *tc;
+
+  s = suite_create ("songlistidx");
+  tc = tcase_create ("songlistidx");
+  tcase_set_tags (tc, "libbdj4");
+  tcase_add_checked_fixture (tc, setup, teardown);
+  tcase_add_test (tc, songlistidx_rebuild);
+  tcase_add_test (tc, songlistidx_bylist);
+  tcase_add_test (tc, songlistidx_persist);
+  tcase_add_test (tc, songlistidx_save);
+  tcase_add_test (tc, songlistidx_changed);
+  suite_add_tcase (s, tc);
+
+  return s;
+}
+
+/* every uri in every song list must match a full scan */
+static void
+chkCompare (void)
+{
+  slist_t     *filelist;
+  slistidx_t  fiteridx;
+  const char  *fn;
+  char        name [BDJ4_PATH_MAX];
+  pathinfo_t  *pi;
+  songlist_t  *sl;
+  ilistidx_t  iteridx;
+  ilistidx_t  key;
+
+  filelist = dirlistBasicDirList ("data", BDJ4_SONGLIST_EXT);
+  slistStartIterator (filelist, &fiteridx);
+  while ((fn = slistIterateKey (filelist, &fiteridx)) != NULL) {
+    pi = pathInfo (fn);
+    snprintf (name, sizeof (name), "%.*s", (int) pi->blen, pi->basename);
+    pathInfoFree (pi);
+
+    sl = songlistLoad (name);
+    songlistStartIterator (sl, &iteridx);
+    while ((key = songlistIterate (sl, &iteridx)) >= 0) {
+      chkCompareUri (songlistGetStr (sl, key, SONGLIST_URI));
+    }
+    songlistFree (sl);
+  }
+  slistFree (filelist);
+}
+
+/* the song lists that contain the uri, using a full scan */
+static slist_t *
+chkScan (const char *uri)
+{
+  slist_t     *filelist;
+  slist_t     *names;
+  slistidx_t  fiteridx;
+  const char  *fn;
+  char        name [BDJ4_PATH_MAX];
+  pathinfo_t  *pi;
+  songlist_t  *sl;
+  ilistidx_t  iteridx;
+  ilistidx_t  key;
+
+  names = slistAlloc ("chk-slidx", LIST_ORDERED, NULL);
+  filelist = dirlistBasicDirList ("data", BDJ4_SONGLIST_EXT);
+  slistStartIterator (filelist, &fiteridx);
+  while ((fn = slistIterateKey (filelist, &fiteridx)) != NULL) {
+    pi = pathInfo (fn);
+    snprintf (name, sizeof (name), "%.*s", (int) pi->blen, pi->basename);
+    pathInfoFree (pi);
+
+    if (strncmp (name, RELOAD_FN, strlen (RELOAD_FN)) == 0) {
+      continue;
+    }
+
+    sl = songlistLoad (name);
+    songlistStartIterator (sl, &iteridx);
+    while ((key = songlistIterate (sl, &iteridx)) >= 0) {
+      if (strcmp (songlistGetStr (sl, key, SONGLIST_URI), uri) == 0) {
+        slistSetNum (names, name, 0);
+        break;
+      }
+    }
+    songlistFree (sl);
+  }
+  slistFree (filelist);
+
+  return names;
+}
+
+static void
+chkCompareUri (const char *uri)
+{
+  slist_t     *names;
+  slist_t     *scan;
+  slistidx_t  iteridx;
+  const char  *name;
+
+  names = songlistidxGetSonglists (uri);
+  scan = chkScan (uri);
+  ck_assert_int_eq (slistGetCount (names), slistGetCount (scan));
+  slistStartIterator (scan, &iteridx);
+  while ((name = slistIterateKey (scan, &iteridx)) != NULL) {
+    ck_assert_int_ge (slistGetIdx (names, name), 0);
+  }
+  slistFree (names);
+  slistFree (scan);
+}
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <sys/types.h>
 #include <time.h>
@@ -103,6 +104,28 @@ START_TEST(bdjstring_string_trim_char)
 }
 END_TEST
 
+START_TEST(bdjstring_string_hash)
+{
+  uint64_t  hash;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- bdjstring_string_hash");
+  mdebugSubTag ("bdjstring_string_hash");
+
+  /* fnv-1a reference values */
+  ck_assert_uint_eq (stringHash64 (""), 0xcbf29ce484222325ULL);
+  ck_assert_uint_eq (stringHash64 (NULL), 0xcbf29ce484222325ULL);
+  ck_assert_uint_eq (stringHash64 ("a"), 0xaf63dc4c8601ec8cULL);
+  ck_assert_uint_eq (stringHash64 ("foobar"), 0x85944171f73967e8ULL);
+
+  /* incremental */
+  hash = stringHash64Data (STRING_HASH64_INIT, "foo", 3);
+  hash = stringHash64Data (hash, "bar", 3);
+  ck_assert_uint_eq (hash, stringHash64 ("foobar"));
+  ck_assert_uint_eq (stringHash64Data (STRING_HASH64_INIT, "foobar", 0),
+      STRING_HASH64_INIT);
+}
+END_TEST
+
 #if 0
 START_TEST(bdjstring_version_compare)
 {
@@ -159,6 +182,7 @@ bdjstring_suite (void)
   tcase_add_test (tc, bdjstring_string_to_upper);
   tcase_add_test (tc, bdjstring_string_trim);
   tcase_add_test (tc, bdjstring_string_trim_char);
+  tcase_add_test (tc, bdjstring_string_hash);
   // tcase_add_test (tc, bdjstring_version_compare);
   suite_add_tcase (s, tc);
   return s;
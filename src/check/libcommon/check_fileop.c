@@ -169,6 +169,38 @@ START_TEST(fileop_setmodtime_a)
 }
 END_TEST
 
+START_TEST(fileop_getinfo_a)
+{
+  FILE          *fh;
+  time_t        ctm;
+  fileopinfo_t  info;
+  bool          rc;
+  char *fn = "tmp/abc.txt";
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- fileop_getinfo_a");
+  mdebugSubTag ("fileop_getinfo_a");
+
+  ctm = time (NULL);
+  fh = fileopOpen (fn, "w");
+  ck_assert_ptr_nonnull (fh);
+  fputs ("abcdef", fh);
+  mdextfclose (fh);
+  fclose (fh);
+  rc = fileopGetInfo (fn, &info);
+  ck_assert_int_eq (rc, true);
+  ck_assert_int_eq (info.size, 6);
+  ck_assert_int_ge (info.mtime, ctm);
+  if (! isWindows ()) {
+    ck_assert_int_ne (info.inode, 0);
+  }
+  unlink (fn);
+
+  rc = fileopGetInfo (fn, &info);
+  ck_assert_int_eq (rc, false);
+  ck_assert_int_eq (info.size, -1);
+}
+END_TEST
+
 START_TEST(fileop_delete_a)
 {
   FILE      *fh;
@@ -429,6 +461,7 @@ fileop_suite (void)
   tcase_add_test (tc, fileop_size_a);
   tcase_add_test (tc, fileop_modtime_a);
   tcase_add_test (tc, fileop_setmodtime_a);
+  tcase_add_test (tc, fileop_getinfo_a);
   tcase_add_test (tc, fileop_delete_a);
   tcase_add_test (tc, fileop_delete_symlink);
   tcase_add_test (tc, fileop_open_u);
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "audiosrc.h"
+#include "bdj4.h"
+#include "check_bdj.h"
+#include "fileop.h"
+#include "gsti.h"
+#include "log.h"
+#include "mdebug.h"
+#include "osenv.h"
+#include "pli.h"
+#include "sysvars.h"
+#include "tmutil.h"
+
+enum {
+  TONE_RATE = 44100,
+  TONE_SECONDS = 2,
+  /* the maximum allowed gap between the songs, in microseconds */
+  GAP_MAX = 10000,
+  WAIT_TIME = 10000,
+};
+
+#define GAPFN_A "tmp/gsti-gap-a.wav"
+#define GAPFN_B "tmp/gsti-gap-b.wav"
+
+static void makeToneFile (const char *fn, double freq);
+static void putLE (FILE *fh, uint32_t val, int bytes);
+static bool waitState (gsti_t *gsti, plistate_t want);
+
+static void
+setup (void)
+{
+  /* no audio device is needed */
+  osSetEnv ("BDJ4_GST_SINK", "fakesink");
+  makeToneFile (GAPFN_A, 440.0);
+  makeToneFile (GAPFN_B, 660.0);
+}
+
+static void
+teardown (void)
+{
+  fileopDelete (GAPFN_A);
+  fileopDelete (GAPFN_B);
+  osSetEnv ("BDJ4_GST_SINK", "");
+}
+
+START_TEST(gsti_preroll_gap)
+{
+  gsti_t      *gsti;
+  char        fna [BDJ4_PATH_MAX];
+  char        fnb [BDJ4_PATH_MAX];
+  int64_t     gap;
+  bool        rc;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- gsti_preroll_gap");
+  mdebugSubTag ("gsti_preroll_gap");
+
+  snprintf (fna, sizeof (fna), "%s/%s",
+      sysvarsGetStr (SV_BDJ4_DIR_DATATOP), GAPFN_A);
+  snprintf (fnb, sizeof (fnb), "%s/%s",
+      sysvarsGetStr (SV_BDJ4_DIR_DATATOP), GAPFN_B);
+
+  gsti = gstiInit ("GStreamer");
+  ck_assert_ptr_nonnull (gsti);
+  ck_assert_int_eq (gstiGetGap (gsti), -1);
+
+  gstiMedia (gsti, fna, AUDIOSRC_TYPE_FILE);
+  gstiPlay (gsti);
+  rc = waitState (gsti, PLI_STATE_PLAYING);
+  ck_assert_int_eq (rc, true);
+
+  gstiPreroll (gsti, fnb, AUDIOSRC_TYPE_FILE);
+
+  /* the first song finishes, the pre-rolled song is started */
+  rc = waitState (gsti, PLI_STATE_STOPPED);
+  ck_assert_int_eq (rc, true);
+
+  /* the player's request for the next song */
+  gstiMedia (gsti, fnb, AUDIOSRC_TYPE_FILE);
+  gstiPlay (gsti);
+  rc = waitState (gsti, PLI_STATE_PLAYING);
+  ck_assert_int_eq (rc, true);
+
+  gap = gstiGetGap (gsti);
+  logMsg (LOG_DBG, LOG_IMPORTANT, "gsti gap: %" PRId64 " usec", gap);
+  ck_assert_int_ge (gap, 0);
+  ck_assert_int_lt (gap, GAP_MAX);
+  /* the second song plays from the beginning */
+  ck_assert_int_lt (gstiGetPosition (gsti), TONE_SECONDS * 1000 / 2);
+
+  gstiStop (gsti);
+  gstiFree (gsti);
+  gstiCleanup ();
+}
+END_TEST
+
+Suite *
+gsti_suite (void)
+{
+  Suite     *s;
+  TCase     *tc;
+
+  s = suite_create ("gsti");
+  tc = tcase_create ("gsti");
+  tcase_set_tags (tc, "libpli");
+  tcase_set_timeout (tc, 30.0);
+  tcase_add_unchecked_fixture (tc, setup, teardown);
+  tcase_add_test (tc, gsti_preroll_gap);
+  suite_add_tcase (s, tc);
+
+  return s;
+}
+
+/* a mono 16-bit wave file with a constant tone */
+static void
+makeToneFile (const char *fn, double freq)
+{
+  FILE      *fh;
+  uint32_t  count;
+  uint32_t  datasz;
+
+  count = TONE_RATE * TONE_SECONDS;
+  datasz = count * sizeof (int16_t);
+
+  fh = fileopOpen (fn, "wb");
+  if (fh == NULL) {
+    return;
+  }
+
+  fwrite ("RIFF", 4, 1, fh);
+  putLE (fh, 36 + datasz, 4);
+  fwrite ("WAVEfmt ", 8, 1, fh);
+  putLE (fh, 16, 4);
+  putLE (fh, 1, 2);                         // pcm
+  putLE (fh, 1, 2);                         // channels
+  putLE (fh, TONE_RATE, 4);
+  putLE (fh, TONE_RATE * sizeof (int16_t), 4);
+  putLE (fh, sizeof (int16_t), 2);
+  putLE (fh, 16, 2);
+  fwrite ("data", 4, 1, fh);
+  putLE (fh, datasz, 4);
+  for (uint32_t i = 0; i < count; ++i) {
+    double    val;
+
+    val = sin (2.0 * M_PI * freq * (double) i / (double) TONE_RATE);
+    putLE (fh, (uint32_t) (uint16_t) (int16_t) (val * 8000.0), 2);
+  }
+  mdextfclose (fh);
+  fclose (fh);
+}
+
+static void
+putLE (FILE *fh, uint32_t val, int bytes)
+{
+  for (int i = 0; i < bytes; ++i) {
+    fputc ((int) ((val >> (i * 8)) & 0xff), fh);
+  }
+}
+
+static bool
+waitState (gsti_t *gsti, plistate_t want)
+{
+  mstime_t    tm;
+
+  mstimeset (&tm, WAIT_TIME);
+  while (gstiState (gsti) != want) {
+    if (mstimeCheck (&tm)) {
+      return false;
+    }
+    mssleep (1);
+  }
+  return true;
+}
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
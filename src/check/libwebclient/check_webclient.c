@@ -11,6 +11,10 @@
 #include <time.h>
 #include <unistd.h>
 
+#if __has_include (<pthread.h>)
+# include <pthread.h>
+#endif
+
 #pragma clang diagnostic push
 #pragma GCC diagnostic push
 #pragma clang diagnostic ignored "-Wformat-extra-args"
@@ -19,22 +23,61 @@
 #include <check.h>
 
 #include "bdjopt.h"
+#include "bdjstring.h"
 #include "check_bdj.h"
 #include "mdebug.h"
 #include "fileop.h"
 #include "mdebug.h"
 #include "webclient.h"
+#include "websrv.h"
 #include "log.h"
+#include "tmutil.h"
 
 static void checkWebclientCB (void *udata, const char *resp, size_t len, time_t tm);
+#if _lib_pthread_create
+static void checkRangeHandler (void *udata, const char *query, const char *uri);
+static void *checkRangeServer (void *arg);
+static void checkRangeFile (const char *fn, char *data, size_t sz);
+static void *checkRangeWorker (void *arg);
+static void checkMultiHandler (void *udata, const char *query, const char *uri);
+static void checkMultiCB (void *udata, int webrc, const char *resp, size_t len, time_t tm);
+static int checkMultiWait (webclientmulti_t *wm);
+#endif
 
 typedef struct {
   const char  *resp;
   size_t      len;
 } checkwc_t;
 
+typedef struct {
+  int         webrc;
+  int         count;
+  char        resp [200];
+} checkwcmulti_t;
+
+typedef struct {
+  const char  *uri;
+  int64_t     offset;
+  int         webrc;
+  int64_t     received;
+} checkwcrange_t;
+
 #define DLFILE "tmp/wc-dl.txt"
 #define UPFILE "tmp/wc-up.txt"
+#define RANGEFILE "tmp/wc-range.dat"
+#define RANGEOUT "tmp/wc-range-out.dat"
+
+enum {
+  RANGE_PORT = 32730,
+  MULTI_PORT = 32733,
+  RANGE_SZ = 3000,
+  RANGE_WORKERS = 3,
+};
+
+#if _lib_pthread_create
+static websrv_t         *gwebsrv = NULL;
+static _Atomic(bool)    gstop = false;
+#endif
 
 static void
 setup (void)
@@ -249,6 +292,247 @@ START_TEST(webclient_upload_gzip)
 }
 END_TEST
 
+#if _lib_pthread_create
+
+START_TEST(webclient_range)
+{
+  webclient_t   *wc;
+  pthread_t     thread;
+  webrange_t    range;
+  char          uri [200];
+  char          data [RANGE_SZ];
+  char          odata [RANGE_SZ];
+  int           rc;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- webclient_range");
+  mdebugSubTag ("webclient_range");
+
+  for (int i = 0; i < RANGE_SZ; ++i) {
+    data [i] = 'a' + i % 26;
+  }
+  checkRangeFile (RANGEFILE, data, sizeof (data));
+  unlink (RANGEOUT);
+
+  gstop = false;
+  gwebsrv = websrvInit (RANGE_PORT, checkRangeHandler, NULL, WEBSRV_TLS_OFF);
+  pthread_create (&thread, NULL, checkRangeServer, NULL);
+
+  snprintf (uri, sizeof (uri), "http://localhost:%d/range", RANGE_PORT);
+  wc = webclientAlloc (NULL, NULL);
+
+  /* the pieces are fetched out of order */
+  range.offset = 1000;
+  range.len = 1000;
+  range.validate = false;
+  rc = webclientDownloadRange (wc, uri, NULL, RANGEOUT, &range);
+  ck_assert_int_eq (rc, WEB_PARTIAL_CONTENT);
+  ck_assert_int_eq (range.offset, 1000);
+  ck_assert_int_eq (range.received, 1000);
+  ck_assert_int_eq (range.total, RANGE_SZ);
+  ck_assert_int_gt (strlen (range.etag), 0);
+
+  /* a post is used for the bdj4 server */
+  range.offset = 2000;
+  range.len = 0;
+  rc = webclientDownloadRange (wc, uri, "uri=abc", RANGEOUT, &range);
+  ck_assert_int_eq (rc, WEB_PARTIAL_CONTENT);
+  ck_assert_int_eq (range.received, 1000);
+  ck_assert_int_eq (range.total, RANGE_SZ);
+
+  range.offset = 0;
+  range.len = 1000;
+  rc = webclientDownloadRange (wc, uri, NULL, RANGEOUT, &range);
+  ck_assert_int_eq (rc, WEB_PARTIAL_CONTENT);
+  ck_assert_int_eq (range.received, 1000);
+
+  ck_assert_int_eq (fileopSize (RANGEOUT), RANGE_SZ);
+  checkRangeFile (RANGEOUT, odata, 0);
+  ck_assert_int_eq (memcmp (data, odata, sizeof (data)), 0);
+
+  /* the file has not changed */
+  range.offset = 0;
+  range.len = 1000;
+  range.validate = true;
+  rc = webclientDownloadRange (wc, uri, "uri=abc", RANGEOUT, &range);
+  ck_assert_int_eq (rc, WEB_NOT_MODIFIED);
+  ck_assert_int_eq (range.received, 0);
+  ck_assert_int_eq (fileopSize (RANGEOUT), RANGE_SZ);
+
+  /* a different etag */
+  stpecpy (range.etag, range.etag + sizeof (range.etag), "\"abc\"");
+  rc = webclientDownloadRange (wc, uri, NULL, RANGEOUT, &range);
+  ck_assert_int_eq (rc, WEB_PARTIAL_CONTENT);
+  ck_assert_int_eq (range.received, 1000);
+  ck_assert_int_gt (strlen (range.etag), 0);
+
+  /* past the end of the file */
+  range.validate = false;
+  range.offset = 0;
+  range.len = RANGE_SZ + 1000;
+  rc = webclientDownloadRange (wc, uri, NULL, RANGEOUT, &range);
+  ck_assert_int_eq (rc, WEB_RANGE_NOT_SAT);
+  ck_assert_int_eq (range.total, RANGE_SZ);
+
+  webclientClose (wc);
+  gstop = true;
+  pthread_join (thread, NULL);
+  websrvFree (gwebsrv);
+  gwebsrv = NULL;
+  unlink (RANGEFILE);
+  unlink (RANGEOUT);
+}
+END_TEST
+
+/* after a restart, the partial file has been removed, and the */
+/* pieces are fetched in parallel.  no piece may truncate another */
+START_TEST(webclient_range_restart)
+{
+  pthread_t       thread;
+  pthread_t       wthreads [RANGE_WORKERS];
+  checkwcrange_t  wr [RANGE_WORKERS];
+  char            uri [200];
+  char            data [RANGE_SZ];
+  char            odata [RANGE_SZ];
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- webclient_range_restart");
+  mdebugSubTag ("webclient_range_restart");
+
+  for (int i = 0; i < RANGE_SZ; ++i) {
+    data [i] = 'z' - i % 26;
+  }
+  checkRangeFile (RANGEFILE, data, sizeof (data));
+  unlink (RANGEOUT);
+
+  gstop = false;
+  gwebsrv = websrvInit (RANGE_PORT, checkRangeHandler, NULL, WEBSRV_TLS_OFF);
+  pthread_create (&thread, NULL, checkRangeServer, NULL);
+
+  snprintf (uri, sizeof (uri), "http://localhost:%d/range", RANGE_PORT);
+
+  /* the pieces are started together, in reverse order */
+  for (int i = RANGE_WORKERS - 1; i >= 0; --i) {
+    wr [i].uri = uri;
+    wr [i].offset = (int64_t) i * (RANGE_SZ / RANGE_WORKERS);
+    wr [i].webrc = 0;
+    wr [i].received = 0;
+    pthread_create (&wthreads [i], NULL, checkRangeWorker, &wr [i]);
+  }
+  for (int i = 0; i < RANGE_WORKERS; ++i) {
+    pthread_join (wthreads [i], NULL);
+  }
+
+  for (int i = 0; i < RANGE_WORKERS; ++i) {
+    ck_assert_int_eq (wr [i].webrc, WEB_PARTIAL_CONTENT);
+    ck_assert_int_eq (wr [i].received, RANGE_SZ / RANGE_WORKERS);
+  }
+  ck_assert_int_eq (fileopSize (RANGEOUT), RANGE_SZ);
+  checkRangeFile (RANGEOUT, odata, 0);
+  ck_assert_int_eq (memcmp (data, odata, sizeof (data)), 0);
+
+  gstop = true;
+  pthread_join (thread, NULL);
+  websrvFree (gwebsrv);
+  gwebsrv = NULL;
+  unlink (RANGEFILE);
+  unlink (RANGEOUT);
+}
+END_TEST
+
+START_TEST(webclient_multi)
+{
+  webclientmulti_t  *wm;
+  pthread_t         thread;
+  checkwcmulti_t    r [4];
+  char              uri [200];
+  int               reqid [4];
+  int               active;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- webclient_multi");
+  mdebugSubTag ("webclient_multi");
+
+  memset (r, 0, sizeof (r));
+
+  gstop = false;
+  gwebsrv = websrvInit (MULTI_PORT, checkMultiHandler, NULL, WEBSRV_TLS_OFF);
+  pthread_create (&thread, NULL, checkRangeServer, NULL);
+
+  wm = webclientMultiAlloc ();
+  ck_assert_int_eq (webclientMultiProcess (wm), 0);
+
+  /* the requests do not block */
+  for (int i = 0; i < 3; ++i) {
+    snprintf (uri, sizeof (uri), "http://localhost:%d/multi/%d", MULTI_PORT, i);
+    reqid [i] = webclientMultiGet (wm, uri, 2000, checkMultiCB, &r [i]);
+    ck_assert_int_gt (reqid [i], 0);
+  }
+  ck_assert_int_ne (reqid [0], reqid [1]);
+  ck_assert_int_ne (reqid [1], reqid [2]);
+  ck_assert_int_eq (r [0].count, 0);
+
+  active = checkMultiWait (wm);
+  ck_assert_int_eq (active, 0);
+  for (int i = 0; i < 3; ++i) {
+    char    tbuff [40];
+
+    snprintf (tbuff, sizeof (tbuff), "/multi/%d", i);
+    ck_assert_int_eq (r [i].count, 1);
+    ck_assert_int_eq (r [i].webrc, WEB_OK);
+    ck_assert_str_eq (r [i].resp, tbuff);
+  }
+
+  /* post */
+  memset (r, 0, sizeof (r));
+  snprintf (uri, sizeof (uri), "http://localhost:%d/post", MULTI_PORT);
+  reqid [0] = webclientMultiPost (wm, uri, "abc=123", 2000, checkMultiCB, &r [0]);
+  ck_assert_int_gt (reqid [0], 0);
+  ck_assert_int_eq (checkMultiWait (wm), 0);
+  ck_assert_int_eq (r [0].count, 1);
+  ck_assert_int_eq (r [0].webrc, WEB_OK);
+  ck_assert_str_eq (r [0].resp, "abc=123");
+
+  /* not found */
+  snprintf (uri, sizeof (uri), "http://localhost:%d/none", MULTI_PORT);
+  reqid [0] = webclientMultiGet (wm, uri, 2000, checkMultiCB, &r [0]);
+  ck_assert_int_eq (checkMultiWait (wm), 0);
+  ck_assert_int_eq (r [0].count, 2);
+  ck_assert_int_eq (r [0].webrc, WEB_NOT_FOUND);
+
+  /* cancel */
+  memset (r, 0, sizeof (r));
+  snprintf (uri, sizeof (uri), "http://localhost:%d/multi/4", MULTI_PORT);
+  reqid [0] = webclientMultiGet (wm, uri, 2000, checkMultiCB, &r [0]);
+  reqid [1] = webclientMultiGet (wm, uri, 2000, checkMultiCB, &r [1]);
+  ck_assert_int_eq (webclientMultiCancel (wm, reqid [0]), true);
+  ck_assert_int_eq (webclientMultiCancel (wm, reqid [0]), false);
+  ck_assert_int_eq (webclientMultiProcess (wm) <= 1, true);
+  ck_assert_int_eq (checkMultiWait (wm), 0);
+  ck_assert_int_eq (r [0].count, 0);
+  ck_assert_int_eq (r [1].count, 1);
+  ck_assert_int_eq (r [1].webrc, WEB_OK);
+
+  /* timeout */
+  memset (r, 0, sizeof (r));
+  snprintf (uri, sizeof (uri), "http://localhost:%d/slow", MULTI_PORT);
+  reqid [0] = webclientMultiGet (wm, uri, 100, checkMultiCB, &r [0]);
+  ck_assert_int_eq (checkMultiWait (wm), 0);
+  ck_assert_int_eq (r [0].count, 1);
+  ck_assert_int_eq (r [0].webrc, 0);
+
+  /* an active request is cancelled when freed */
+  snprintf (uri, sizeof (uri), "http://localhost:%d/multi/5", MULTI_PORT);
+  reqid [0] = webclientMultiGet (wm, uri, 2000, checkMultiCB, &r [0]);
+  ck_assert_int_gt (reqid [0], 0);
+  webclientMultiFree (wm);
+  ck_assert_int_eq (r [0].count, 1);
+
+  gstop = true;
+  pthread_join (thread, NULL);
+  websrvFree (gwebsrv);
+  gwebsrv = NULL;
+}
+END_TEST
+
+#endif
 
 Suite *
 webclient_suite (void)
@@ -267,6 +551,11 @@ webclient_suite (void)
   tcase_add_test (tc, webclient_post);
   tcase_add_test (tc, webclient_upload_plain);
   tcase_add_test (tc, webclient_upload_gzip);
+#if _lib_pthread_create
+  tcase_add_test (tc, webclient_range);
+  tcase_add_test (tc, webclient_range_restart);
+  tcase_add_test (tc, webclient_multi);
+#endif
   suite_add_tcase (s, tc);
 
   return s;
@@ -280,5 +569,105 @@ checkWebclientCB (void *udata, const char *resp, size_t len, time_t tm)
   r->len = len;
 }
 
+#if _lib_pthread_create
+
+static void
+checkRangeHandler (void *udata, const char *query, const char *uri)
+{
+  websrvServeFile (gwebsrv, "", RANGEFILE);
+}
+
+/* the web server runs in its own thread, as the web client blocks */
+static void *
+checkRangeServer (void *arg)
+{
+  while (! gstop) {
+    websrvProcess (gwebsrv);
+  }
+  pthread_exit (NULL);
+  return NULL;
+}
+
+static void
+checkMultiHandler (void *udata, const char *query, const char *uri)
+{
+  if (strcmp (uri, "/post") == 0) {
+    websrvReply (gwebsrv, WEB_OK, "Content-type: text/plain\r\n", query);
+  } else if (strcmp (uri, "/slow") == 0) {
+    mssleep (400);
+    websrvReply (gwebsrv, WEB_OK, "Content-type: text/plain\r\n", "slow");
+  } else if (strncmp (uri, "/multi/", 7) == 0) {
+    websrvReply (gwebsrv, WEB_OK, "Content-type: text/plain\r\n", uri);
+  } else {
+    websrvReply (gwebsrv, WEB_NOT_FOUND, "", "");
+  }
+}
+
+static void
+checkMultiCB (void *udata, int webrc, const char *resp, size_t len, time_t tm)
+{
+  checkwcmulti_t  *r = udata;
+
+  r->webrc = webrc;
+  r->count += 1;
+  *r->resp = '\0';
+  if (resp != NULL) {
+    stpecpy (r->resp, r->resp + sizeof (r->resp), resp);
+  }
+}
+
+/* returns the number of requests still active */
+static int
+checkMultiWait (webclientmulti_t *wm)
+{
+  mstime_t    tm;
+  int         active;
+
+  mstimeset (&tm, 3000);
+  active = webclientMultiWait (wm, 20);
+  while (active > 0 && ! mstimeCheck (&tm)) {
+    active = webclientMultiWait (wm, 20);
+  }
+  return active;
+}
+
+/* each worker has its own connection, as with the bdj4 audio source */
+static void *
+checkRangeWorker (void *arg)
+{
+  checkwcrange_t  *wr = arg;
+  webclient_t     *wc;
+  webrange_t      range;
+
+  wc = webclientAlloc (NULL, NULL);
+  range.offset = wr->offset;
+  range.len = RANGE_SZ / RANGE_WORKERS;
+  range.validate = false;
+  wr->webrc = webclientDownloadRange (wc, wr->uri, "uri=abc", RANGEOUT, &range);
+  wr->received = range.received;
+  webclientClose (wc);
+  pthread_exit (NULL);
+  return NULL;
+}
+
+/* writes the data if sz is set, otherwise reads it */
+static void
+checkRangeFile (const char *fn, char *data, size_t sz)
+{
+  FILE    *fh;
+
+  fh = fileopOpen (fn, sz > 0 ? "wb" : "rb");
+  ck_assert_ptr_nonnull (fh);
+  if (sz > 0) {
+    ck_assert_int_eq (fwrite (data, sz, 1, fh), 1);
+  } else {
+    ck_assert_int_eq (fread (data, RANGE_SZ, 1, fh), 1);
+  }
+  mdextfclose (fh);
+  fclose (fh);
+}
+
+#endif
+
 #pragma clang diagnostic pop
 #pragma GCC diagnostic pop
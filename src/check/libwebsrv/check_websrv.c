@@ -0,0 +1,626 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#if __has_include (<arpa/inet.h>)
+# include <arpa/inet.h>
+#endif
+#if __has_include (<netinet/in.h>)
+# include <netinet/in.h>
+#endif
+#if __has_include (<sys/select.h>)
+# include <sys/select.h>
+#endif
+#if __has_include (<sys/socket.h>)
+# include <sys/socket.h>
+#endif
+#if __has_include (<winsock2.h>)
+# include <winsock2.h>
+#endif
+#if __has_include (<ws2tcpip.h>)
+# include <ws2tcpip.h>
+#endif
+
+#pragma clang diagnostic push
+#pragma GCC diagnostic push
+#pragma clang diagnostic ignored "-Wformat-extra-args"
+#pragma GCC diagnostic ignored "-Wformat-extra-args"
+
+#include <check.h>
+
+#include "bdjstring.h"
+#include "check_bdj.h"
+#include "log.h"
+#include "mdebug.h"
+#include "sock.h"
+#include "tmutil.h"
+#include "websrv.h"
+
+enum {
+  WS_PORT = 32720,
+  WS_CLIENTS = 50,
+  WS_EVENTS = 200,
+  /* these are generous, so that a slow or loaded machine will pass */
+  WS_MAX_LATENCY = 1000,
+  WS_MAX_CPU = 2000,
+  WS_WAIT = 5000,
+};
+
+typedef struct {
+  Sock_t    sock;
+  int       events;
+  int       responses;
+  int       hdrmatch;
+  char      prev;
+} chkclient_t;
+
+#define WS_EVENTS_REQ "GET /events HTTP/1.1\r\nHost: localhost\r\n\r\n"
+/* the batch items are separated by an encoded record separator */
+#define WS_BATCH_SEP_ENC  "%1E"
+#define WS_BATCH_SEP      "\x1e"
+
+static websrv_t         *gwebsrv = NULL;
+static websrvpayload_t  *gpayload = NULL;
+
+static void chkWebsrvHandler (void *udata, const char *query, const char *uri);
+static void chkConnect (chkclient_t *client, uint16_t port, const char *req);
+static void chkSend (chkclient_t *client, const char *req);
+static void chkClose (chkclient_t *client);
+static bool chkRead (chkclient_t *client, char *buff, size_t sz);
+static bool chkWaitEvents (chkclient_t *clients, int count, int events);
+static bool chkWaitResponses (chkclient_t *clients, int count, int responses);
+static void chkReadUntil (chkclient_t *client, char *buff, size_t sz, const char *str);
+static char *chkBatchRequest (char *p, char *end, char pfx);
+
+START_TEST(websrv_stream)
+{
+  chkclient_t   clients [WS_CLIENTS];
+  mstime_t      tm;
+  time_t        latency;
+  clock_t       cbeg;
+  clock_t       cpu;
+  char          tbuff [40];
+  bool          rc;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- websrv_stream");
+  mdebugSubTag ("websrv_stream");
+
+  gwebsrv = websrvInit (WS_PORT, chkWebsrvHandler, NULL, WEBSRV_TLS_OFF);
+  ck_assert_ptr_nonnull (gwebsrv);
+  ck_assert_int_eq (websrvStreamCount (gwebsrv), 0);
+
+  for (int i = 0; i < WS_CLIENTS; ++i) {
+    chkConnect (&clients [i], WS_PORT, WS_EVENTS_REQ);
+  }
+
+  mstimestart (&tm);
+  while (websrvStreamCount (gwebsrv) < WS_CLIENTS &&
+      mstimeend (&tm) < WS_WAIT) {
+    websrvProcess (gwebsrv);
+  }
+  ck_assert_int_eq (websrvStreamCount (gwebsrv), WS_CLIENTS);
+
+  /* the retry setting and the initial data */
+  rc = chkWaitEvents (clients, WS_CLIENTS, 2);
+  ck_assert_int_eq (rc, true);
+
+  /* every client gets the change promptly */
+  mstimestart (&tm);
+  websrvStreamSend (gwebsrv, "chg-0000");
+  rc = chkWaitEvents (clients, WS_CLIENTS, 3);
+  latency = mstimeend (&tm);
+  ck_assert_int_eq (rc, true);
+  ck_assert_int_lt (latency, WS_MAX_LATENCY);
+
+  /* the cost of a broadcast does not depend on the number of requests */
+  cbeg = clock ();
+  for (int j = 1; j <= WS_EVENTS; ++j) {
+    snprintf (tbuff, sizeof (tbuff), "chg-%04d", j);
+    websrvStreamSend (gwebsrv, tbuff);
+    websrvProcess (gwebsrv);
+  }
+  rc = chkWaitEvents (clients, WS_CLIENTS, 3 + WS_EVENTS);
+  cpu = (clock () - cbeg) * 1000 / CLOCKS_PER_SEC;
+  ck_assert_int_eq (rc, true);
+  ck_assert_int_lt (cpu, WS_MAX_CPU);
+
+  /* closed clients are removed */
+  for (int i = 0; i < WS_CLIENTS / 2; ++i) {
+    chkClose (&clients [i]);
+  }
+  mstimestart (&tm);
+  while (websrvStreamCount (gwebsrv) > WS_CLIENTS / 2 &&
+      mstimeend (&tm) < WS_WAIT) {
+    websrvProcess (gwebsrv);
+  }
+  ck_assert_int_eq (websrvStreamCount (gwebsrv), WS_CLIENTS - WS_CLIENTS / 2);
+
+  websrvStreamSend (gwebsrv, "chg-last");
+  rc = chkWaitEvents (clients + WS_CLIENTS / 2, WS_CLIENTS - WS_CLIENTS / 2,
+      4 + WS_EVENTS);
+  ck_assert_int_eq (rc, true);
+
+  for (int i = WS_CLIENTS / 2; i < WS_CLIENTS; ++i) {
+    chkClose (&clients [i]);
+  }
+  websrvFree (gwebsrv);
+  gwebsrv = NULL;
+}
+END_TEST
+
+START_TEST(websrv_stream_data)
+{
+  chkclient_t   client;
+  char          buff [400];
+  mstime_t      tm;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- websrv_stream_data");
+  mdebugSubTag ("websrv_stream_data");
+
+  gwebsrv = websrvInit (WS_PORT + 1, chkWebsrvHandler, NULL, WEBSRV_TLS_OFF);
+  ck_assert_ptr_nonnull (gwebsrv);
+
+  /* nothing to send to */
+  websrvStreamSend (gwebsrv, "none");
+
+  chkConnect (&client, WS_PORT + 1, WS_EVENTS_REQ);
+  mstimestart (&tm);
+  while (websrvStreamCount (gwebsrv) < 1 && mstimeend (&tm) < WS_WAIT) {
+    websrvProcess (gwebsrv);
+  }
+  ck_assert_int_eq (websrvStreamCount (gwebsrv), 1);
+
+  /* each line of the data is prefixed */
+  websrvStreamSend (gwebsrv, "{ \"a\" : \"1\",\n\"b\" : \"2\" }");
+
+  chkReadUntil (&client, buff, sizeof (buff), "\"2\" }\n\n");
+  ck_assert_int_eq (client.events, 3);
+  ck_assert_ptr_nonnull (strstr (buff, "HTTP/1.1 200"));
+  ck_assert_ptr_nonnull (strstr (buff, "text/event-stream"));
+  ck_assert_ptr_nonnull (strstr (buff, "\r\n\r\nretry: 2000\n\n"));
+  ck_assert_ptr_nonnull (strstr (buff, "\n\ndata: init\n\n"));
+  ck_assert_ptr_nonnull (strstr (buff,
+      "\n\ndata: { \"a\" : \"1\",\ndata: \"b\" : \"2\" }\n\n"));
+
+  chkClose (&client);
+  websrvFree (gwebsrv);
+  gwebsrv = NULL;
+}
+END_TEST
+
+START_TEST(websrv_payload)
+{
+  websrvpayload_t *wp;
+  char            etag [40];
+  char            big [2000];
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- websrv_payload");
+  mdebugSubTag ("websrv_payload");
+
+  wp = websrvPayloadAlloc ();
+  ck_assert_ptr_null (websrvPayloadGetData (wp));
+  websrvPayloadSet (wp, "{ \"a\" : \"1\" }", 13);
+  ck_assert_str_eq (websrvPayloadGetData (wp), "{ \"a\" : \"1\" }");
+  stpecpy (etag, etag + sizeof (etag), websrvPayloadGetETag (wp));
+  ck_assert_int_eq (etag [0], '"');
+
+  /* the same data has the same etag */
+  websrvPayloadSet (wp, "{ \"a\" : \"1\" }", 13);
+  ck_assert_str_eq (websrvPayloadGetETag (wp), etag);
+  websrvPayloadSet (wp, "{ \"a\" : \"2\" }", 13);
+  ck_assert_str_ne (websrvPayloadGetETag (wp), etag);
+
+  memset (big, 'a', sizeof (big));
+  big [sizeof (big) - 1] = '\0';
+  websrvPayloadSet (wp, big, strlen (big));
+  ck_assert_int_eq (strlen (websrvPayloadGetData (wp)), sizeof (big) - 1);
+  websrvPayloadFree (wp);
+}
+END_TEST
+
+START_TEST(websrv_payload_reply)
+{
+  chkclient_t   client;
+  char          buff [2000];
+  char          req [300];
+  char          big [1000];
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- websrv_payload_reply");
+  mdebugSubTag ("websrv_payload_reply");
+
+  gwebsrv = websrvInit (WS_PORT + 2, chkWebsrvHandler, NULL, WEBSRV_TLS_OFF);
+  gpayload = websrvPayloadAlloc ();
+  websrvPayloadSet (gpayload, "{ \"a\" : \"1\" }", 13);
+
+  chkConnect (&client, WS_PORT + 2,
+      "GET /data HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  chkReadUntil (&client, buff, sizeof (buff), "\"1\" }");
+  ck_assert_ptr_nonnull (strstr (buff, "HTTP/1.1 200"));
+  ck_assert_ptr_nonnull (strstr (buff, websrvPayloadGetETag (gpayload)));
+  ck_assert_ptr_nonnull (strstr (buff, "\r\n\r\n{ \"a\" : \"1\" }"));
+
+  /* the client already has the data */
+  snprintf (req, sizeof (req),
+      "GET /data HTTP/1.1\r\nHost: localhost\r\nIf-None-Match: %s\r\n\r\n",
+      websrvPayloadGetETag (gpayload));
+  chkSend (&client, req);
+  chkReadUntil (&client, buff, sizeof (buff), "\r\n\r\n");
+  ck_assert_ptr_nonnull (strstr (buff, "HTTP/1.1 304"));
+  ck_assert_ptr_nonnull (strstr (buff, "Content-Length: 0\r\n"));
+
+  /* the data changed */
+  websrvPayloadSet (gpayload, "{ \"a\" : \"2\" }", 13);
+  chkSend (&client, req);
+  chkReadUntil (&client, buff, sizeof (buff), "\"2\" }");
+  ck_assert_ptr_nonnull (strstr (buff, "HTTP/1.1 200"));
+
+  /* large enough to be compressed */
+  memset (big, 'a', sizeof (big));
+  big [sizeof (big) - 1] = '\0';
+  websrvPayloadSet (gpayload, big, strlen (big));
+  chkSend (&client, "GET /data HTTP/1.1\r\nHost: localhost\r\n"
+      "Accept-Encoding: gzip, deflate\r\n\r\n");
+  chkReadUntil (&client, buff, sizeof (buff), "\r\n\r\n");
+  ck_assert_ptr_nonnull (strstr (buff, "HTTP/1.1 200"));
+  ck_assert_ptr_nonnull (strstr (buff, "Content-Encoding: gzip"));
+
+  chkClose (&client);
+  websrvPayloadFree (gpayload);
+  gpayload = NULL;
+  websrvFree (gwebsrv);
+  gwebsrv = NULL;
+}
+END_TEST
+
+START_TEST(websrv_payload_load)
+{
+  chkclient_t   clients [WS_CLIENTS];
+  char          req [300];
+  mstime_t      tm;
+  time_t        elapsed;
+  clock_t       cbeg;
+  clock_t       cpu;
+  bool          rc;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- websrv_payload_load");
+  mdebugSubTag ("websrv_payload_load");
+
+  gwebsrv = websrvInit (WS_PORT + 3, chkWebsrvHandler, NULL, WEBSRV_TLS_OFF);
+  gpayload = websrvPayloadAlloc ();
+  websrvPayloadSet (gpayload, "{ \"a\" : \"1\" }", 13);
+  snprintf (req, sizeof (req),
+      "GET /data HTTP/1.1\r\nHost: localhost\r\nIf-None-Match: %s\r\n\r\n",
+      websrvPayloadGetETag (gpayload));
+
+  for (int i = 0; i < WS_CLIENTS; ++i) {
+    chkConnect (&clients [i], WS_PORT + 3, req);
+  }
+  rc = chkWaitResponses (clients, WS_CLIENTS, 1);
+  ck_assert_int_eq (rc, true);
+
+  /* many clients polling an unchanged payload */
+  mstimestart (&tm);
+  cbeg = clock ();
+  for (int j = 2; j <= WS_EVENTS / 10; ++j) {
+    for (int i = 0; i < WS_CLIENTS; ++i) {
+      chkSend (&clients [i], req);
+    }
+    rc = chkWaitResponses (clients, WS_CLIENTS, j);
+    ck_assert_int_eq (rc, true);
+  }
+  cpu = (clock () - cbeg) * 1000 / CLOCKS_PER_SEC;
+  elapsed = mstimeend (&tm);
+  ck_assert_int_lt (cpu, WS_MAX_CPU);
+  ck_assert_int_lt (elapsed, WS_MAX_LATENCY * WS_EVENTS / 10);
+
+  for (int i = 0; i < WS_CLIENTS; ++i) {
+    chkClose (&clients [i]);
+  }
+  websrvPayloadFree (gpayload);
+  gpayload = NULL;
+  websrvFree (gwebsrv);
+  gwebsrv = NULL;
+}
+END_TEST
+
+START_TEST(websrv_batch)
+{
+  chkclient_t   client;
+  char          buff [8192];
+  char          req [8192];
+  char          *rp;
+  char          *rend;
+  const char    *pa;
+  const char    *pb;
+  int           count;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "--chk-- websrv_batch");
+  mdebugSubTag ("websrv_batch");
+
+  gwebsrv = websrvInit (WS_PORT + 4, chkWebsrvHandler, NULL, WEBSRV_TLS_OFF);
+
+  /* two requests are sent together on the same connection, */
+  /* each with a body larger than the handler's query */
+  rp = req;
+  rend = req + sizeof (req);
+  rp = chkBatchRequest (rp, rend, 'a');
+  rp = chkBatchRequest (rp, rend, 'b');
+  ck_assert_ptr_ne (rp, rend);
+
+  chkConnect (&client, WS_PORT + 4, req);
+  chkReadUntil (&client, buff, sizeof (buff), "b099.mp3\n\r\n0\r\n\r\n");
+
+  count = 0;
+  for (pa = buff; (pa = strstr (pa, "HTTP/1.1 200")) != NULL; ++pa) {
+    ++count;
+  }
+  ck_assert_int_eq (count, 2);
+  ck_assert_ptr_nonnull (strstr (buff, "Transfer-Encoding: chunked\r\n"));
+
+  /* the responses are in order, and each item was decoded */
+  pa = strstr (buff, "a+000.mp3\n");
+  pb = strstr (buff, "b+000.mp3\n");
+  ck_assert_ptr_nonnull (pa);
+  ck_assert_ptr_nonnull (pb);
+  ck_assert_int_lt (pa - buff, pb - buff);
+  pa = strstr (buff, "a099.mp3\n\r\n0\r\n\r\n");
+  ck_assert_ptr_nonnull (pa);
+  ck_assert_int_lt (pa - buff, pb - buff);
+
+  chkClose (&client);
+  websrvFree (gwebsrv);
+  gwebsrv = NULL;
+}
+END_TEST
+
+Suite *
+websrv_suite (void)
+{
+  Suite     *s;
+  TCase     *tc;
+
+  s = suite_create ("websrv");
+  tc = tcase_create ("websrv");
+  tcase_set_tags (tc, "libwebsrv");
+  tcase_set_timeout (tc, 20.0);
+  tcase_add_test (tc, websrv_stream);
+  tcase_add_test (tc, websrv_stream_data);
+  tcase_add_test (tc, websrv_payload);
+  tcase_add_test (tc, websrv_payload_reply);
+  tcase_add_test (tc, websrv_payload_load);
+  tcase_add_test (tc, websrv_batch);
+  suite_add_tcase (s, tc);
+
+  return s;
+}
+
+static void
+chkWebsrvHandler (void *udata, const char *query, const char *uri)
+{
+  if (strcmp (uri, "/events") == 0) {
+    websrvStreamStart (gwebsrv, "init");
+  } else if (strcmp (uri, "/data") == 0) {
+    websrvReplyPayload (gwebsrv,
+        "Content-type: application/json\r\n", gpayload);
+  } else if (strcmp (uri, "/batch") == 0) {
+    char    *body;
+    char    *p;
+    char    *tokstr;
+    char    tbuff [200];
+
+    /* each item is sent back as a separate chunk */
+    body = websrvGetBody (gwebsrv);
+    websrvChunkStart (gwebsrv, "Content-type: text/plain; charset=utf-8\r\n");
+    p = strtok_r (body + strlen ("uri="), WS_BATCH_SEP, &tokstr);
+    while (p != NULL) {
+      snprintf (tbuff, sizeof (tbuff), "%s\n", p);
+      websrvChunkSend (gwebsrv, tbuff, strlen (tbuff));
+      p = strtok_r (NULL, WS_BATCH_SEP, &tokstr);
+    }
+    websrvChunkEnd (gwebsrv);
+    mdfree (body);
+  } else {
+    websrvReply (gwebsrv, WEB_OK,
+        "Content-type: text/plain; charset=utf-8\r\n", "ok");
+  }
+}
+
+/* the web server only listens on ipv4 */
+static void
+chkConnect (chkclient_t *client, uint16_t port, const char *req)
+{
+  struct sockaddr_in  saddr;
+  int                 rc;
+
+  client->events = 0;
+  client->responses = 0;
+  client->hdrmatch = 0;
+  client->prev = '\0';
+  client->sock = socket (AF_INET, SOCK_STREAM, 0);
+  ck_assert_int_eq (socketInvalid (client->sock), false);
+
+  memset (&saddr, 0, sizeof (saddr));
+  saddr.sin_family = AF_INET;
+  saddr.sin_port = htons (port);
+  saddr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  rc = connect (client->sock, (struct sockaddr *) &saddr, sizeof (saddr));
+  ck_assert_int_eq (rc, 0);
+
+  chkSend (client, req);
+}
+
+static void
+chkSend (chkclient_t *client, const char *req)
+{
+  int     rc;
+
+  rc = send (client->sock, req, strlen (req), 0);
+  ck_assert_int_eq (rc, (int) strlen (req));
+}
+
+static void
+chkClose (chkclient_t *client)
+{
+  sockClose (client->sock);
+  client->sock = INVALID_SOCKET;
+}
+
+/* reads whatever is available without waiting, and counts the */
+/* blank lines that end each event, and the ends of the http headers */
+static bool
+chkRead (chkclient_t *client, char *buff, size_t sz)
+{
+  char            tbuff [4096];
+  fd_set          rfds;
+  struct timeval  tv;
+  int             rc;
+
+  if (buff != NULL) {
+    *buff = '\0';
+  }
+
+  FD_ZERO (&rfds);
+  FD_SET (client->sock, &rfds);
+  tv.tv_sec = 0;
+  tv.tv_usec = 0;
+  rc = select (client->sock + 1, &rfds, NULL, NULL, &tv);
+  if (rc <= 0) {
+    return false;
+  }
+
+  rc = recv (client->sock, tbuff, sizeof (tbuff) - 1, 0);
+  if (rc <= 0) {
+    return false;
+  }
+  tbuff [rc] = '\0';
+
+  for (int i = 0; i < rc; ++i) {
+    if (tbuff [i] == '\n' && client->prev == '\n') {
+      ++client->events;
+    }
+    if (tbuff [i] == "\r\n\r\n" [client->hdrmatch]) {
+      ++client->hdrmatch;
+    } else {
+      client->hdrmatch = tbuff [i] == '\r' ? 1 : 0;
+    }
+    if (client->hdrmatch == 4) {
+      ++client->responses;
+      client->hdrmatch = 0;
+    }
+    client->prev = tbuff [i];
+  }
+
+  if (buff != NULL) {
+    snprintf (buff, sz, "%s", tbuff);
+  }
+  return true;
+}
+
+static bool
+chkWaitEvents (chkclient_t *clients, int count, int events)
+{
+  mstime_t  tm;
+  bool      done = false;
+
+  mstimestart (&tm);
+  while (! done && mstimeend (&tm) < WS_WAIT) {
+    websrvProcess (gwebsrv);
+    done = true;
+    for (int i = 0; i < count; ++i) {
+      while (clients [i].events < events && chkRead (&clients [i], NULL, 0)) {
+        ;
+      }
+      if (clients [i].events < events) {
+        done = false;
+      }
+    }
+  }
+
+  return done;
+}
+
+/* the buffer only holds the text up to the first null byte */
+static void
+chkReadUntil (chkclient_t *client, char *buff, size_t sz, const char *str)
+{
+  mstime_t  tm;
+  char      *p;
+
+  p = buff;
+  *p = '\0';
+  mstimestart (&tm);
+  while (strstr (buff, str) == NULL && mstimeend (&tm) < WS_WAIT) {
+    websrvProcess (gwebsrv);
+    chkRead (client, p, sz - (size_t) (p - buff));
+    p = buff + strlen (buff);
+  }
+}
+
+static bool
+chkWaitResponses (chkclient_t *clients, int count, int responses)
+{
+  mstime_t  tm;
+  bool      done = false;
+
+  mstimestart (&tm);
+  while (! done && mstimeend (&tm) < WS_WAIT) {
+    websrvProcess (gwebsrv);
+    done = true;
+    for (int i = 0; i < count; ++i) {
+      while (clients [i].responses < responses &&
+          chkRead (&clients [i], NULL, 0)) {
+        ;
+      }
+      if (clients [i].responses < responses) {
+        done = false;
+      }
+    }
+  }
+
+  return done;
+}
+
+/* the first item has an encoded character */
+static char *
+chkBatchRequest (char *p, char *end, char pfx)
+{
+  char    body [3000];
+  char    *bp;
+  char    *bend;
+  char    tbuff [40];
+
+  bp = body;
+  bend = body + sizeof (body);
+  bp = stpecpy (bp, bend, "uri=");
+  for (int i = 0; i < 100; ++i) {
+    if (i == 0) {
+      snprintf (tbuff, sizeof (tbuff), "%c%%2B%03d.mp3", pfx, i);
+    } else {
+      snprintf (tbuff, sizeof (tbuff), "%s%c%03d.mp3",
+          WS_BATCH_SEP_ENC, pfx, i);
+    }
+    bp = stpecpy (bp, bend, tbuff);
+  }
+  ck_assert_ptr_ne (bp, bend);
+
+  snprintf (tbuff, sizeof (tbuff), "%zu", strlen (body));
+  p = stpecpy (p, end, "POST /batch HTTP/1.1\r\nHost: localhost\r\n");
+  p = stpecpy (p, end, "Content-Length: ");
+  p = stpecpy (p, end, tbuff);
+  p = stpecpy (p, end, "\r\n\r\n");
+  p = stpecpy (p, end, body);
+  return p;
+}
+
+#pragma clang diagnostic pop
+#pragma GCC diagnostic pop
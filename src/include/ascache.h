@@ -0,0 +1,44 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nodiscard.h"
+
+#if defined (__cplusplus) || defined (c_plusplus)
+extern "C" {
+#endif
+
+#define ASCACHE_DIR       "ascache"
+#define ASCACHE_INDEX_FN  "ascache-index"
+#define ASCACHE_MAX_SIZE  ((int64_t) 2 * 1024 * 1024 * 1024)
+
+enum {
+  ASCACHE_VALIDATOR_SZ = 80,
+};
+
+typedef struct ascache ascache_t;
+
+/* the validators are used to check if the remote file has changed */
+typedef struct {
+  int64_t   size;
+  char      etag [ASCACHE_VALIDATOR_SZ];
+  char      lastmod [ASCACHE_VALIDATOR_SZ];
+} ascacheinfo_t;
+
+BDJ_NODISCARD ascache_t *ascacheAlloc (const char *dir, int64_t maxsize);
+void    ascacheFree (ascache_t *ascache);
+bool    ascacheGetInfo (ascache_t *ascache, const char *key, ascacheinfo_t *info);
+bool    ascacheCopy (ascache_t *ascache, const char *key, const char *outfn);
+bool    ascacheAdd (ascache_t *ascache, const char *key, const char *fn, const char *etag, const char *lastmod);
+void    ascacheRemove (ascache_t *ascache, const char *key);
+void    ascacheSave (ascache_t *ascache);
+int32_t ascacheGetCount (ascache_t *ascache);
+int64_t ascacheGetSize (ascache_t *ascache);
+
+#if defined (__cplusplus) || defined (c_plusplus)
+} /* extern C */
+#endif
@@ -20,11 +20,19 @@ enum {
 
 typedef struct aa aa_t;
 
+typedef struct {
+  double    integrated;     // LUFS
+  double    truepeak;       // dBTP
+  double    adjustment;     // suggested volume adjustment percentage
+} aaloudness_t;
+
 BDJ_NODISCARD aa_t * aaAlloc (void);
 void aaFree (aa_t *aa);
 bool aaApplyAdjustments (musicdb_t *musicdb, dbidx_t dbidx, int aaflags);
 void aaAdjust (musicdb_t *musicdb, song_t *song, const char *infn, const char *outfn, long dur, int fadein, int fadeout, int gap);
 int aaSilenceDetect (const char *infn, double *sstart, double *send);
+int aaLoudnessScan (const char *infn, aaloudness_t *loudness);
+void aaLoudnessCalcAdjustment (aaloudness_t *loudness);
 
 #if defined (__cplusplus) || defined (c_plusplus)
 } /* extern C */
@@ -3,6 +3,10 @@
  */
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
 #include "nlist.h"
 #include "song.h"
 #include "tagdef.h"
@@ -16,10 +20,20 @@ typedef struct audioidmb audioidmb_t;
 typedef struct audioidacoustid audioidacoustid_t;
 typedef struct audioidacr audioidacr_t;
 typedef struct audioid_resp audioid_resp_t;
+typedef struct audioidcache audioidcache_t;
+typedef struct audioidrate audioidrate_t;
 
 #define ACRCLOUD_TEMP_FN    "out-acr.json"
 #define ACOUSTID_TEMP_FN    "out-acoustid.xml"
 #define MUSICBRAINZ_TEMP_FN "out-mb.xml"
+#define AUDIOID_CACHE_DIR   "audioid"
+
+enum {
+  /* the number of upcoming songs that may be sent along with */
+  /* a lookup to services that support batched requests */
+  AUDIOID_PREFETCH_MAX = 9,
+  AUDIOID_CACHE_AGE = 30 * 24 * 3600,
+};
 
 /* audioid.c */
 
@@ -29,12 +43,19 @@ bool audioidLookup (audioid_t *audioid, const song_t *song);
 void audioidStartIterator (audioid_t *audioid);
 nlistidx_t audioidIterate (audioid_t *audioid);
 nlist_t * audioidGetList (audioid_t *audioid, int key);
+void audioidPrefetchClear (audioid_t *audioid);
+void audioidPrefetchAdd (audioid_t *audioid, const song_t *song);
+bool audioidPrefetchProcess (audioid_t *audioid);
 
 /* audioidutil.c */
 
 bool audioidSetResponseData (int level, audioid_resp_t *resp, int tagidx, const char *data);
 nlist_t * audioidGetResponseData (audioid_resp_t *resp, int respidx);
 void audioidDumpResult (nlist_t *respdata);
+audioidrate_t *audioidRateAlloc (const char *name, int interval);
+void audioidRateFree (audioidrate_t *rate);
+void audioidRateWait (audioidrate_t *rate);
+bool audioidRateRetry (audioidrate_t *rate, int webrc);
 
 typedef struct audioidparsedata
 {
@@ -88,11 +109,31 @@ enum {
   AUDIOID_TYPE_ARTIST_TYPE = TAG_KEY_MAX + 10,
 };
 
+/* audioidcache.c */
+
+typedef enum {
+  AUDIOID_CACHE_FP,
+  AUDIOID_CACHE_ACOUSTID,
+  AUDIOID_CACHE_MB,
+  AUDIOID_CACHE_ACR,
+  AUDIOID_CACHE_MAX,
+} audioidcachetype_t;
+
+audioidcache_t *audioidCacheAlloc (const char *dir, time_t maxage);
+void audioidCacheFree (audioidcache_t *cache);
+char *audioidCacheGet (audioidcache_t *cache, audioidcachetype_t type, const char *key, size_t *len);
+bool audioidCacheExists (audioidcache_t *cache, audioidcachetype_t type, const char *key);
+bool audioidCacheSet (audioidcache_t *cache, audioidcachetype_t type, const char *key, const char *data, size_t len);
+void audioidCacheFileKey (const char *fn, char *buff, size_t sz);
+
 /* audioidxml.c */
 
+typedef void (*audioidbatchcb_t)(void *udata, int idx, const char *data, size_t len);
+
 void audioidParseXMLInit (void);
 void audioidParseXMLCleanup (void);
 int audioidParseXMLAll (const char *data, size_t datalen, audioidparse_t *xpaths, audioid_resp_t *resp, audioid_id_t ident);
+int audioidParseXMLBatch (const char *data, size_t datalen, audioidbatchcb_t cb, void *udata);
 
 /* audioidjson.c */
 
@@ -100,19 +141,22 @@ int audioidParseJSONAll (const char *data, size_t datalen, audioidparse_t *xpath
 
 /* musicbrainz.c */
 
-audioidmb_t *mbInit (void);
+audioidmb_t *mbInit (audioidcache_t *cache);
 void mbFree (audioidmb_t *mb);
 int mbRecordingIdLookup (audioidmb_t *mb, const char *recid, audioid_resp_t *resp);
 
 /* acoustid.c */
 
-audioidacoustid_t * acoustidInit (void);
+audioidacoustid_t * acoustidInit (audioidcache_t *cache);
 void acoustidFree (audioidacoustid_t *acoustid);
 int acoustidLookup (audioidacoustid_t *acoustid, const song_t *song, audioid_resp_t *resp);
+void acoustidPrefetchClear (audioidacoustid_t *acoustid);
+void acoustidPrefetchAdd (audioidacoustid_t *acoustid, const char *uri, int64_t dur);
+bool acoustidPrefetchProcess (audioidacoustid_t *acoustid);
 
 /* acrcloud.c */
 
-audioidacr_t * acrInit (void);
+audioidacr_t * acrInit (audioidcache_t *cache);
 void acrFree (audioidacr_t *acr);
 int acrLookup (audioidacr_t *acr, const song_t *song, audioid_resp_t *resp);
 
@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "ascache.h"
 #include "slist.h"
 
 #if defined (__cplusplus) || defined (c_plusplus)
@@ -104,6 +105,7 @@ bool asiSongTags (asdata_t *asdata, const char *uri);
 /* audiosrcutil.c */
 void audiosrcutilMakeTempName (const char *ffn, char *tempnm, size_t maxlen);
 bool audiosrcutilPreCacheFile (const char *fn);
+ascache_t *audiosrcutilCacheAlloc (void);
 
 #if defined (__cplusplus) || defined (c_plusplus)
 } /* extern C */
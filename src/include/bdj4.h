@@ -128,6 +128,8 @@ enum {
 #define LOCALE_ORIG_FN      "localeorig"
 #define NEWINST_FN          "newinstall"
 #define READONLY_FN         "readonly"
+/* environment probe cache, written by the starter */
+#define SYSVARS_PROBE_FN    "sysvarsprobe"
 /* gtk css */
 #define GTK_CSS_STATIC_FN   "gtk-static"
 #define GTK_CSS_DARK_FN     "gtk-dark"
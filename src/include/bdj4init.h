@@ -41,6 +41,8 @@ enum {
   BDJ4_ARG_UPD_CONVERT          = (1 << 25),
   BDJ4_ARG_NO_PODCAST_UPD       = (1 << 26),
   BDJ4_INIT_NO_LOG              = (1 << 27),
+  BDJ4_ARG_DB_LOUDNESS          = (1 << 28),
+  BDJ4_ARG_DB_BPM               = (1 << 29),
 };
 
 void bdj4initArgInit (void);
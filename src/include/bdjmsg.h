@@ -177,7 +177,7 @@ typedef enum {
   MSG_DB_WAIT,              // display 'please wait'
   MSG_DB_WAIT_FINISH,       // clear status
   /* to/from bpm counter */
-  MSG_BPM_TIMESIG,          // args: bpm/mpm time-signature(mpm)
+  MSG_BPM_TIMESIG,          // args: time-signature(mpm), bpm-low, bpm-high, audio-file
   MSG_BPM_SET,              // args: bpm
 
   /* test-suite */
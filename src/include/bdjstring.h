@@ -5,6 +5,9 @@
 
 #include "config.h"
 
+#include <stdint.h>
+#include <stddef.h>
+
 #if defined (__cplusplus) || defined (c_plusplus)
 extern "C" {
 #endif
@@ -15,6 +18,11 @@ void      stringTrim (char *s);
 void      stringTrimChar (char *s, unsigned char c);
 int       versionCompare (const char *v1, const char *v2);
 
+/* fnv-1a, 64-bit */
+#define STRING_HASH64_INIT  14695981039346656037ULL
+uint64_t  stringHash64 (const char *str);
+uint64_t  stringHash64Data (uint64_t hash, const void *data, size_t len);
+
 #if defined (__cplusplus) || defined (c_plusplus)
 char * stpecpy (char *dst, char *end, const char *src);
 #else
@@ -0,0 +1,36 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "ilist.h"
+
+#if defined (__cplusplus) || defined (c_plusplus)
+extern "C" {
+#endif
+
+enum {
+  /* the audio is decoded to mono at this sample rate */
+  BPMDETECT_RATE = 11025,
+  /* default range when no dance is known */
+  BPMDETECT_BPM_LOW = 40,
+  BPMDETECT_BPM_HIGH = 250,
+  /* results with a lower confidence should not be used */
+  BPMDETECT_CONF_MIN = 40,
+};
+
+typedef struct {
+  int     bpm;          // 0 if no tempo was found
+  int     confidence;   // 0-100
+} bpmdetect_t;
+
+int   bpmdetectFile (const char *ffn, int bpmlow, int bpmhigh, bpmdetect_t *result);
+void  bpmdetectPCM (const int16_t *pcm, size_t count, int rate, int bpmlow, int bpmhigh, bpmdetect_t *result);
+void  bpmdetectDanceRange (ilistidx_t danceidx, int *bpmlow, int *bpmhigh);
+int   bpmdetectToMPM (ilistidx_t danceidx, int bpm);
+
+#if defined (__cplusplus) || defined (c_plusplus)
+} /* extern C */
+#endif
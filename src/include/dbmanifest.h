@@ -0,0 +1,32 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "nodiscard.h"
+
+#if defined (__cplusplus) || defined (c_plusplus)
+extern "C" {
+#endif
+
+#define DBMANIFEST_FNAME  "musicdb-manifest"
+
+typedef enum {
+  DBMANIFEST_NEW,
+  DBMANIFEST_CHANGED,
+  DBMANIFEST_UNCHANGED,
+} dbmanifestrc_t;
+
+typedef struct dbmanifest dbmanifest_t;
+
+BDJ_NODISCARD dbmanifest_t *dbmanifestAlloc (const char *fname, const char *musicdir, bool load);
+void  dbmanifestFree (dbmanifest_t *dbmanifest);
+bool  dbmanifestIsLoaded (dbmanifest_t *dbmanifest);
+dbmanifestrc_t dbmanifestCheckFile (dbmanifest_t *dbmanifest, const char *ffn);
+void  dbmanifestSave (dbmanifest_t *dbmanifest);
+
+#if defined (__cplusplus) || defined (c_plusplus)
+} /* extern C */
+#endif
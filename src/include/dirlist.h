@@ -3,6 +3,8 @@
  */
 #pragma once
 
+#include <stdint.h>
+
 #include "nodiscard.h"
 #include "slist.h"
 
@@ -18,9 +20,22 @@ enum {
   DIRLIST_LINKS = 0x04,
 };
 
+/* return values for dirlistWalkNext() */
+typedef enum {
+  DIRLIST_WALK_ENTRY,
+  DIRLIST_WALK_WAIT,
+  DIRLIST_WALK_DONE,
+} dirwalkrc_t;
+
+typedef struct dirwalk dirwalk_t;
+
 /* dirlist.c */
 BDJ_NODISCARD slist_t * dirlistBasicDirList (const char *dir, const char *extension);
 BDJ_NODISCARD slist_t * dirlistRecursiveDirList (const char *dir, int flags);
+BDJ_NODISCARD dirwalk_t * dirlistWalkStart (const char *dir, int flags);
+dirwalkrc_t dirlistWalkNext (dirwalk_t *dirwalk, char *buff, size_t sz);
+int32_t dirlistWalkCount (dirwalk_t *dirwalk);
+void dirlistWalkFree (dirwalk_t *dirwalk);
 
 #if defined (__cplusplus) || defined (c_plusplus)
 } /* extern C */
@@ -33,6 +33,22 @@ enum {
   RSS_ITEM_MAX,
 };
 
+enum {
+  RSS_VALIDATOR_SZ = 80,
+  RSS_GUID_SZ = 512,
+};
+
+/* the validators and the guid of the newest item are saved per-feed. */
+/* if the validators are set, a conditional get is done. */
+/* if the guid is set, the parse stops when the item with that guid */
+/* is reached, and only the newer items are returned. */
+typedef struct {
+  char    etag [RSS_VALIDATOR_SZ];      // in/out
+  char    lastmod [RSS_VALIDATOR_SZ];   // in/out
+  char    guid [RSS_GUID_SZ];           // in/out
+  int     webrc;                        // out
+} rssvalid_t;
+
 /* m3u.c */
 void m3uExport (musicdb_t *musicdb, nlist_t *list, const char *fname, const char *slname);
 nlist_t * m3uImport (musicdb_t *musicdb, const char *fname);
@@ -46,8 +62,8 @@ void xspfExport (musicdb_t *musicdb, nlist_t *list, const char *fname, const cha
 BDJ_NODISCARD nlist_t * xspfImport (musicdb_t *musicdb, const char *fname);
 
 /* rss.c */
-time_t rssGetUpdateTime (const char *uri);
-nlist_t * rssImport (const char *uri);
+BDJ_NODISCARD nlist_t * rssImport (const char *uri);
+BDJ_NODISCARD nlist_t * rssImportUpdate (const char *uri, rssvalid_t *valid);
 
 #if defined (__cplusplus) || defined (c_plusplus)
 } /* extern C */
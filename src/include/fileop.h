@@ -12,10 +12,17 @@
 extern "C" {
 #endif
 
+typedef struct {
+  int64_t   size;
+  time_t    mtime;
+  uint64_t  inode;
+} fileopinfo_t;
+
 bool    fileopFileExists (const char *fname);
 ssize_t fileopSize (const char *fname);
 time_t  fileopModTime (const char *fname);
 void    fileopSetModTime (const char *fname, time_t tm);
+bool    fileopGetInfo (const char *fname, fileopinfo_t *info);
 time_t  fileopCreateTime (const char *fname);
 bool    fileopIsDirectory (const char *fname);
 int     fileopDelete (const char *fname);
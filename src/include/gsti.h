@@ -15,6 +15,8 @@ gsti_t *gstiInit (const char *plinm);
 void gstiFree (gsti_t *gsti);
 void gstiCleanup (void);
 void gstiMedia (gsti_t *gsti, const char *fulluri, int sourceType);
+void gstiPreroll (gsti_t *gsti, const char *fulluri, int sourceType);
+int64_t gstiGetGap (gsti_t *gsti);
 int64_t gstiGetDuration (gsti_t *gsti);
 int64_t gstiGetPosition (gsti_t *gsti);
 plistate_t gstiState (gsti_t *gsti);
@@ -34,6 +34,7 @@ void        nlistSetStr (nlist_t *, nlistidx_t lkey, const char *data);
 void        nlistSetNum (nlist_t *, nlistidx_t lkey, nlistnum_t lval);
 void        nlistSetDouble (nlist_t *, nlistidx_t lkey, double dval);
 void        nlistSetList (nlist_t *list, nlistidx_t lkey, nlist_t *data);
+void        nlistDelete (nlist_t *list, nlistidx_t lkey);
 void        nlistIncrement (nlist_t *, nlistidx_t lkey);
 void        nlistDecrement (nlist_t *, nlistidx_t lkey);
 /* get routines */
@@ -38,6 +38,7 @@ enum {
   PLI_SUPPORT_CROSSFADE   = (1 << 3),
   PLI_SUPPORT_STREAM      = (1 << 4),
   PLI_SUPPORT_STREAM_SPD  = (1 << 5),
+  PLI_SUPPORT_PREROLL     = (1 << 6),
 };
 
 typedef enum {
@@ -66,6 +67,7 @@ typedef struct pli pli_t;
 pli_t         *pliInit (const char *plipkg, const char *plinm);
 void          pliFree (pli_t *pli);
 void          pliMediaSetup (pli_t *pli, const char *mediaPath, const char *fullMediaPath, int sourceType);
+void          pliMediaPreroll (pli_t *pli, const char *mediaPath, const char *fullMediaPath, int sourceType);
 void          pliStartPlayback (pli_t *pli, ssize_t dpos, ssize_t speed);
 void          pliCrossFade (pli_t *pli, const char *mediaPath, const char *fullMediaPath, int sourceType);
 void          pliCrossFadeVolume (pli_t *pli, int vol);
@@ -91,6 +93,7 @@ plidata_t     *pliiInit (const char *plinm, const char *playerargs);
 void          pliiFree (plidata_t *pliData);
 void          pliiCleanup (void);
 void          pliiMediaSetup (plidata_t *pliData, const char *mediaPath, const char *fullMediaPath, int sourceType);
+void          pliiMediaPreroll (plidata_t *pliData, const char *mediaPath, const char *fullMediaPath, int sourceType);
 void          pliiStartPlayback (plidata_t *pliData, ssize_t dpos, ssize_t speed);
 void          pliiCrossFade (plidata_t *plidata, const char *mediaPath, const char *fullMediaPath, int sourceType);
 void          pliiCrossFadeVolume (plidata_t *plidata, int vol);
@@ -13,8 +13,11 @@ extern "C" {
 typedef struct podcast podcast_t;
 
 enum {
+  PODCAST_ETAG,
   PODCAST_IMAGE_URI,
   PODCAST_LAST_BLD_DATE,
+  PODCAST_LAST_GUID,
+  PODCAST_LAST_MODIFIED,
   PODCAST_RETAIN,
   PODCAST_TITLE,
   PODCAST_URI,
@@ -11,6 +11,7 @@
 #include "bdjmsg.h"
 #include "conn.h"
 #include "log.h"
+#include "tmutil.h"
 
 #if defined (__cplusplus) || defined (c_plusplus)
 extern "C" {
@@ -29,8 +30,10 @@ enum {
 typedef struct {
   void      *processHandle;
   pid_t     pid;
+  mstime_t  starttm;
   bool      started : 1;
   bool      hasHandle : 1;
+  bool      handshake : 1;
 } procutil_t;
 
 void        procutilInitProcesses (procutil_t *processes [ROUTE_MAX]);
@@ -52,6 +55,8 @@ void        procutilCloseProcess (procutil_t *process, conn_t *conn,
     bdjmsgroute_t route);
 void        procutilForceStop (procutil_t *process, int flags,
     bdjmsgroute_t route);
+void        procutilCheckHandshake (procutil_t *processes [ROUTE_MAX],
+    conn_t *conn);
 
 #if defined (__cplusplus) || defined (c_plusplus)
 } /* extern C */
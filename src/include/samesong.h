@@ -18,6 +18,7 @@ BDJ_NODISCARD samesong_t  *samesongAlloc (musicdb_t *musicdb);
 void        samesongFree (samesong_t *ss);
 const char  * samesongGetColorByDBIdx (samesong_t *ss, dbidx_t dbidx);
 const char  * samesongGetColorBySSIdx (samesong_t *ss, ssize_t ssidx);
+int         samesongGetCount (samesong_t *ss, ssize_t ssidx);
 void        samesongSet (samesong_t *ss, nlist_t *dbidxlist);
 void        samesongClear (samesong_t *ss, nlist_t *dbidxlist);
 
@@ -39,6 +39,9 @@ int32_t songdbWriteDBSong (songdb_t *songdb, song_t *song, int32_t *flags, dbidx
 BDJ_NODISCARD songdb_t *songdbAlloc (musicdb_t *musicdb);
 void  songdbFree (songdb_t *songdb);
 void  songdbSetMusicDB (songdb_t *songdb, musicdb_t *musicdb);
+void  songdbStartBatch (songdb_t *songdb);
+void  songdbPlanRenames (songdb_t *songdb);
+void  songdbEndBatch (songdb_t *songdb);
 
 #if defined (__cplusplus) || defined (c_plusplus)
 } /* extern C */
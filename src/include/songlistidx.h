@@ -0,0 +1,22 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#pragma once
+
+#include "nodiscard.h"
+#include "slist.h"
+#include "songlist.h"
+
+#if defined (__cplusplus) || defined (c_plusplus)
+extern "C" {
+#endif
+
+BDJ_NODISCARD slist_t *songlistidxGetSonglists (const char *uri);
+BDJ_NODISCARD slist_t *songlistidxGetSonglistsByList (slist_t *urilist);
+void songlistidxUpdate (const char *name, songlist_t *sl);
+void songlistidxRebuild (void);
+void songlistidxCleanup (void);
+
+#if defined (__cplusplus) || defined (c_plusplus)
+} /* extern C */
+#endif
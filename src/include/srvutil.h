@@ -0,0 +1,19 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#pragma once
+
+#include "musicdb.h"
+#include "song.h"
+#include "websrv.h"
+
+#if defined (__cplusplus) || defined (c_plusplus)
+extern "C" {
+#endif
+
+char  *srvutilSongTagData (song_t *song, char *rp, char *rend, int *count);
+void  srvutilSongTagsBatch (websrv_t *websrv, musicdb_t *musicdb, char *songlist);
+
+#if defined (__cplusplus) || defined (c_plusplus)
+} /* extern C */
+#endif
@@ -109,6 +109,8 @@ enum {
   SYSVARS_LOCALE_SET,
   SYSVARS_FLAG_BASIC,
   SYSVARS_FLAG_ALL,
+  /* same as flag-all, but always probes and saves the probe cache */
+  SYSVARS_FLAG_PROBE,
 };
 
 typedef struct {
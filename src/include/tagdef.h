@@ -97,6 +97,10 @@ typedef enum {
   TAG_IMAGE_URI,              //
   TAG_KEYWORD,                //
   TAG_LAST_UPDATED,           //  internal
+  TAG_LOUDNESS,               // only in the database
+  TAG_LOUDNESS_ADJ,           // only in the database
+  TAG_LOUDNESS_CHK,           // only in the database
+  TAG_LOUDNESS_PEAK,          // only in the database
   TAG_MOVEMENTCOUNT,          //
   TAG_MOVEMENTNAME,           //
   TAG_MOVEMENTNUM,            //
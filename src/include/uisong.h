@@ -5,6 +5,7 @@
 
 #include <stdint.h>
 
+#include "musicdb.h"
 #include "slist.h"
 #include "song.h"
 
@@ -19,6 +20,13 @@ nlist_t *uisongGetDisplayList (slist_t *dlsellist, slist_t *itemsellist, song_t
 char *uisongGetDisplay (song_t *song, int tagidx, int32_t *num, double *dval);
 char *uisongGetValue (song_t *song, int tagidx, int32_t *num, double *dval);
 
+/* display string cache for the song lists */
+void uisongCacheInit (void);
+void uisongCacheCleanup (void);
+void uisongCacheInvalidate (dbidx_t dbidx);
+void uisongCacheReset (void);
+const char *uisongGetDisplayCached (song_t *song, dbidx_t dbidx, int tagidx);
+
 #if defined (__cplusplus) || defined (c_plusplus)
 } /* extern C */
 #endif
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
 #include <curl/curl.h>
@@ -17,6 +18,40 @@ extern "C" {
 typedef void (*webclientcb_t)(void *userdata, const char *resp, size_t len, time_t tm);
 
 typedef struct webclient webclient_t;
+typedef struct webclientmulti webclientmulti_t;
+
+/* called when an asynchronous request completes. */
+/* webrc is the http response code, zero if there was no response */
+/* (timed out, or the connection failed). */
+typedef void (*webclientasynccb_t)(void *userdata, int webrc, const char *resp, size_t len, time_t tm);
+
+/* a partial download. */
+/* if the server does not support ranges, the entire file is */
+/* downloaded, and offset is reset to zero */
+/* if validate is set, the etag and last-modified are sent, */
+/* and a 304 is returned if the file has not changed */
+typedef struct {
+  int64_t   offset;         // in
+  int64_t   len;            // in, zero for the remainder of the file
+  int64_t   received;       // out
+  int64_t   total;          // out, the size of the file, -1 if unknown
+  char      etag [80];      // in/out
+  char      lastmod [80];   // in/out
+  bool      validate;       // in
+} webrange_t;
+
+/* a conditional get. */
+/* if set, the etag and last-modified are sent, and a 304 is returned */
+/* if the data has not changed.  on a 200 response the validators are */
+/* replaced by the values in the response. */
+typedef struct {
+  char      etag [80];      // in/out
+  char      lastmod [80];   // in/out
+} webvalid_t;
+
+/* the stream callback is called as the data is received. */
+/* return false to stop the transfer */
+typedef bool (*webclientstreamcb_t)(void *userdata, const char *data, size_t len);
 
 enum {
   WEB_RESP_SZ = 512 * 1024,
@@ -25,9 +60,11 @@ enum {
 webclient_t * webclientAlloc (void *userdata, webclientcb_t cb);
 int   webclientHead (webclient_t *webclient, const char *uri);
 int   webclientGet (webclient_t *webclient, const char *uri);
+int   webclientGetStream (webclient_t *webclient, const char *uri, webvalid_t *valid, webclientstreamcb_t cb, void *userdata);
 int   webclientPost (webclient_t *webclient, const char *uri, const char *query);
 int   webclientPostCompressed (webclient_t *webclient, const char *uri, const char *query);
 int   webclientDownload (webclient_t *webclient, const char *uri, const char *outfile);
+int   webclientDownloadRange (webclient_t *webclient, const char *uri, const char *query, const char *outfile, webrange_t *range);
 int   webclientUploadFile (webclient_t *webclient, const char *uri, const char *query [], const char *fn, const char *fnname);
 void  webclientClose (webclient_t *webclient);
 void  webclientSetTimeout (webclient_t *webclient, long timeout);
@@ -37,6 +74,19 @@ void  webclientGetLocalIP (char *ip, size_t sz);
 void  webclientCompressFile (const char *infn, const char *outfn);
 void  webclientSetUserPass (webclient_t *webclient, const char *user, const char *pass);
 
+/* asynchronous requests */
+/* the requests are started by webclientMultiGet/Post, and progressed */
+/* by calling webclientMultiProcess from the process's main loop. */
+/* the requests share the connection and dns caches. */
+/* the timeout is in milliseconds, zero for no timeout. */
+webclientmulti_t * webclientMultiAlloc (void);
+void  webclientMultiFree (webclientmulti_t *wm);
+int   webclientMultiGet (webclientmulti_t *wm, const char *uri, long timeout, webclientasynccb_t cb, void *userdata);
+int   webclientMultiPost (webclientmulti_t *wm, const char *uri, const char *query, long timeout, webclientasynccb_t cb, void *userdata);
+bool  webclientMultiCancel (webclientmulti_t *wm, int reqid);
+int   webclientMultiProcess (webclientmulti_t *wm);
+int   webclientMultiWait (webclientmulti_t *wm, int timeout);
+
 #if defined (__cplusplus) || defined (c_plusplus)
 } /* extern C */
 #endif
@@ -5,6 +5,7 @@
 
 #define WEB_RESP_OK         "OK"
 #define WEB_RESP_NO_CONTENT "No Content"
+#define WEB_RESP_NOT_MOD    "Not Modified"
 #define WEB_RESP_BAD_REQ    "Bad Request"
 #define WEB_RESP_UNAUTH     "Unauthorized"
 #define WEB_RESP_FORBIDDEN  "Forbidden"
@@ -13,9 +14,15 @@
 enum {
   WEB_OK = 200,
   WEB_NO_CONTENT = 204,
+  WEB_PARTIAL_CONTENT = 206,
+  WEB_NOT_MODIFIED = 304,
   WEB_BAD_REQUEST = 400,
   WEB_UNAUTHORIZED = 401,
   WEB_FORBIDDEN = 403,
   WEB_NOT_FOUND = 404,
+  WEB_RANGE_NOT_SAT = 416,
+  WEB_TOO_MANY_REQ = 429,
+  WEB_SERVER_ERROR = 500,
+  WEB_SERVICE_UNAVAIL = 503,
 };
 
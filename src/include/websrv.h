@@ -3,6 +3,7 @@
  */
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "webresp.h"
@@ -17,6 +18,7 @@ enum {
 };
 
 typedef struct websrv websrv_t;
+typedef struct websrvpayload websrvpayload_t;
 typedef void (*websrv_handler_t) (void *userdata, const char *query, const char *uri);
 
 websrv_t *websrvInit (uint16_t listenPort, websrv_handler_t eventHandler, void *userdata, bool tlsflag);
@@ -25,6 +27,19 @@ void websrvProcess (websrv_t *websrv);
 void websrvReply (websrv_t *websrv, int httpcode, const char *headers, const char *msg);
 void websrvServeFile (websrv_t *websrv, const char *dir, const char *path);
 void websrvGetUserPass (websrv_t *websrv, char *user, size_t usersz, char *pass, size_t passsz);
+char *websrvGetBody (websrv_t *websrv);
+void websrvChunkStart (websrv_t *websrv, const char *headers);
+void websrvChunkSend (websrv_t *websrv, const char *data, size_t len);
+void websrvChunkEnd (websrv_t *websrv);
+void websrvStreamStart (websrv_t *websrv, const char *data);
+void websrvStreamSend (websrv_t *websrv, const char *data);
+int  websrvStreamCount (websrv_t *websrv);
+websrvpayload_t *websrvPayloadAlloc (void);
+void websrvPayloadFree (websrvpayload_t *wp);
+void websrvPayloadSet (websrvpayload_t *wp, const char *data, size_t len);
+const char *websrvPayloadGetData (websrvpayload_t *wp);
+const char *websrvPayloadGetETag (websrvpayload_t *wp);
+void websrvReplyPayload (websrv_t *websrv, const char *headers, websrvpayload_t *wp);
 
 #if defined (__cplusplus) || defined (c_plusplus)
 } /* extern C */
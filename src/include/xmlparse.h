@@ -3,6 +3,9 @@
  */
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "nodiscard.h"
 #include "ilist.h"
 
@@ -27,6 +30,14 @@ typedef struct {
 } xmlparseattr_t;
 
 typedef struct xmlparse xmlparse_t;
+typedef struct xmlparsesax xmlparsesax_t;
+
+/* streaming (sax) parser callbacks */
+/* the element names include the namespace prefix (itunes:duration) */
+/* attrs is a null terminated list of name, value pairs */
+typedef void (*xmlparsestartcb_t)(void *udata, const char *name, const char **attrs);
+typedef void (*xmlparseendcb_t)(void *udata, const char *name);
+typedef void (*xmlparsetextcb_t)(void *udata, const char *text, size_t len);
 
 BDJ_NODISCARD xmlparse_t * xmlParseInitFile (const char *fname, int nsflag);
 BDJ_NODISCARD xmlparse_t * xmlParseInitData (const char *data, size_t datalen, int nsflag);
@@ -35,6 +46,13 @@ void xmlParseGetItem (xmlparse_t * xmlparse, const char *xpath, char *buff, size
 BDJ_NODISCARD ilist_t * xmlParseGetList (xmlparse_t * xmlparse, const char *xpath, const xmlparseattr_t attr []);
 int xmlParseIsValid (xmlparse_t * xmlparse);
 
+BDJ_NODISCARD xmlparsesax_t * xmlParseSAXInit (void *udata, xmlparsestartcb_t startcb, xmlparseendcb_t endcb, xmlparsetextcb_t textcb);
+void xmlParseSAXFree (xmlparsesax_t *sax);
+bool xmlParseSAXPush (xmlparsesax_t *sax, const char *data, size_t len);
+bool xmlParseSAXFinish (xmlparsesax_t *sax);
+void xmlParseSAXStop (xmlparsesax_t *sax);
+bool xmlParseSAXIsStopped (xmlparsesax_t *sax);
+
 #if defined (__cplusplus) || defined (c_plusplus)
 } /* extern C */
 #endif
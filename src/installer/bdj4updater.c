@@ -540,7 +540,8 @@ main (int argc, char *argv [])
     /* 4.1.0 2023-1-5 audioadjust.txt */
     updaterCopyIfNotPresent (AUDIOADJ_FN, BDJ4_CONFIG_EXT, NULL);
     /* 4.12.1 2024-9-1 (version number bump) audioadjust.txt */
-    updaterCopyVersionCheck (NULL, AUDIOADJ_FN, BDJ4_CONFIG_EXT, 5);
+    /* 4.18.3 2026-10-18 added loudness-target (version 6) */
+    updaterCopyVersionCheck (NULL, AUDIOADJ_FN, BDJ4_CONFIG_EXT, 6);
   }
 
   {
@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <ctype.h>
 #include <inttypes.h>
 #include <errno.h>
 #include <math.h>
@@ -37,13 +38,30 @@
 
 enum {
   ACOUSTID_BUFF_SZ = 16384,
+  /* the current song and the prefetched songs */
+  ACOUSTID_BATCH_MAX = AUDIOID_PREFETCH_MAX + 1,
 };
 
+/* a fingerprint to be looked up */
+typedef struct {
+  char          *fp;
+  char          *key;
+  double        ddur;
+} acoustidfp_t;
+
 typedef struct audioidacoustid {
   webclient_t   *webclient;
+  audioidcache_t *cache;
+  audioidrate_t *rate;
   const char    *webresponse;
   size_t        webresplen;
-  mstime_t      globalreqtimer;
+  acoustidfp_t  *batch;
+  int           batchcount;
+  char          *curdata;
+  size_t        curlen;
+  char          *pfuri [AUDIOID_PREFETCH_MAX];
+  int64_t       pfdur [AUDIOID_PREFETCH_MAX];
+  int           pfcount;
   int           respcount;
   char          key [100];
 } audioidacoustid_t;
@@ -129,11 +147,16 @@ static audioidparse_t acoustidmainxp [] = {
   { AUDIOID_PARSE_END,  AUDIOID_TYPE_TREE, "end-response", NULL, NULL, NULL },
 };
 
+static bool acoustidFingerprint (audioidacoustid_t *acoustid, const char *fn, int64_t dur, acoustidfp_t *afp, bool runfpcalc);
+static void acoustidFPFree (acoustidfp_t *afp);
+static bool acoustidQuery (audioidacoustid_t *acoustid);
+static void acoustidBatchCallback (void *udata, int idx, const char *data, size_t len);
+static void acoustidPrefetchRemove (audioidacoustid_t *acoustid, int idx);
 static void acoustidWebResponseCallback (void *userdata, const char *respstr, size_t len, time_t tm);
 static void dumpData (audioidacoustid_t *acoustid);
 
 audioidacoustid_t *
-acoustidInit (void)
+acoustidInit (audioidcache_t *cache)
 {
   audioidacoustid_t *acoustid;
   const char        *takey;
@@ -144,12 +167,27 @@ acoustidInit (void)
   /* return an http 503 error on certain queries (oddly specific). */
   /* so spoof a known user-agent instead */
   webclientSpoofUserAgent (acoustid->webclient);
+  acoustid->cache = cache;
+  /* acoustid prefers at most three calls per second */
+  acoustid->rate = audioidRateAlloc ("acoustid", QPS_LIMIT);
   acoustid->webresponse = NULL;
   acoustid->webresplen = 0;
-  mstimeset (&acoustid->globalreqtimer, 0);
+  acoustid->batch = mdmalloc (sizeof (acoustidfp_t) * ACOUSTID_BATCH_MAX);
+  for (int i = 0; i < ACOUSTID_BATCH_MAX; ++i) {
+    acoustid->batch [i].fp = NULL;
+    acoustid->batch [i].key = NULL;
+    acoustid->batch [i].ddur = 0.0;
+  }
+  acoustid->batchcount = 0;
+  acoustid->curdata = NULL;
+  acoustid->curlen = 0;
+  acoustid->pfcount = 0;
   acoustid->respcount = 0;
+  *acoustid->key = '\0';
   takey = bdjoptGetStr (OPT_G_ACOUSTID_KEY);
-  vsencdec (takey, acoustid->key, sizeof (acoustid->key));
+  if (takey != NULL) {
+    vsencdec (takey, acoustid->key, sizeof (acoustid->key));
+  }
 
   return acoustid;
 }
@@ -165,6 +203,13 @@ acoustidFree (audioidacoustid_t *acoustid)
   acoustid->webclient = NULL;
   acoustid->webresponse = NULL;
   acoustid->webresplen = 0;
+  acoustidPrefetchClear (acoustid);
+  for (int i = 0; i < ACOUSTID_BATCH_MAX; ++i) {
+    acoustidFPFree (&acoustid->batch [i]);
+  }
+  dataFree (acoustid->batch);
+  dataFree (acoustid->curdata);
+  audioidRateFree (acoustid->rate);
   mdfree (acoustid);
 }
 
@@ -172,36 +217,164 @@ int
 acoustidLookup (audioidacoustid_t *acoustid, const song_t *song,
     audioid_resp_t *resp)
 {
-  char          infn [BDJ4_PATH_MAX];
-  char          uri [BDJ4_PATH_MAX];
-  char          *query;
-  long          dur;
-  double        ddur;
-  char          *fpdata = NULL;
-  size_t        retsz;
   const char    *fn;
+  acoustidfp_t  *afp;
+  mstime_t      starttm;
+  int           pfidx;
+
+  acoustid->respcount = 0;
+  acoustid->batchcount = 0;
+  dataFree (acoustid->curdata);
+  acoustid->curdata = NULL;
+  acoustid->curlen = 0;
+
+  fn = songGetStr (song, TAG_URI);
+  for (int i = 0; i < acoustid->pfcount; ++i) {
+    if (strcmp (acoustid->pfuri [i], fn) == 0) {
+      acoustidPrefetchRemove (acoustid, i);
+      break;
+    }
+  }
+
+  afp = &acoustid->batch [0];
+  if (! acoustidFingerprint (acoustid, fn, songGetNum (song, TAG_DURATION), afp, true)) {
+    return 0;
+  }
+  acoustid->batchcount = 1;
+  logMsg (LOG_DBG, LOG_AUDIO_ID, "acoustid: duration: %.0f", afp->ddur);
+
+  acoustid->curdata = audioidCacheGet (acoustid->cache,
+      AUDIOID_CACHE_ACOUSTID, afp->key, &acoustid->curlen);
+
+  if (acoustid->curdata == NULL) {
+    /* acoustid accepts multiple fingerprints in a single request. */
+    /* the upcoming songs that have not been looked up yet are sent */
+    /* along with the current song, and their results are cached. */
+    /* only songs that already have a fingerprint are sent, fpcalc */
+    /* is not run here, see acoustidPrefetchProcess() */
+    pfidx = 0;
+    while (pfidx < acoustid->pfcount &&
+        acoustid->batchcount < ACOUSTID_BATCH_MAX) {
+      afp = &acoustid->batch [acoustid->batchcount];
+      if (! acoustidFingerprint (acoustid, acoustid->pfuri [pfidx],
+          acoustid->pfdur [pfidx], afp, false)) {
+        ++pfidx;
+        continue;
+      }
+      if (audioidCacheExists (acoustid->cache,
+          AUDIOID_CACHE_ACOUSTID, afp->key)) {
+        acoustidFPFree (afp);
+      } else {
+        acoustid->batchcount += 1;
+      }
+      acoustidPrefetchRemove (acoustid, pfidx);
+    }
+
+    acoustidQuery (acoustid);
+  }
+
+  if (acoustid->curdata != NULL && acoustid->curlen > 0) {
+    mstimestart (&starttm);
+    acoustid->respcount = audioidParseXMLAll (acoustid->curdata,
+        acoustid->curlen, acoustidmainxp, resp, AUDIOID_ID_ACOUSTID);
+    logMsg (LOG_DBG, LOG_IMPORTANT, "acoustid: parse: %" PRId64 "ms",
+        (int64_t) mstimeend (&starttm));
+  }
+
+  for (int i = 0; i < acoustid->batchcount; ++i) {
+    acoustidFPFree (&acoustid->batch [i]);
+  }
+  acoustid->batchcount = 0;
+  dataFree (acoustid->curdata);
+  acoustid->curdata = NULL;
+  acoustid->curlen = 0;
+
+  return acoustid->respcount;
+}
+
+void
+acoustidPrefetchClear (audioidacoustid_t *acoustid)
+{
+  if (acoustid == NULL) {
+    return;
+  }
+
+  for (int i = 0; i < acoustid->pfcount; ++i) {
+    dataFree (acoustid->pfuri [i]);
+    acoustid->pfuri [i] = NULL;
+  }
+  acoustid->pfcount = 0;
+}
+
+/* the songs are looked up in the order they are added */
+void
+acoustidPrefetchAdd (audioidacoustid_t *acoustid, const char *uri, int64_t dur)
+{
+  if (acoustid == NULL || uri == NULL) {
+    return;
+  }
+  if (acoustid->pfcount >= AUDIOID_PREFETCH_MAX) {
+    return;
+  }
+
+  acoustid->pfuri [acoustid->pfcount] = mdstrdup (uri);
+  acoustid->pfdur [acoustid->pfcount] = dur;
+  acoustid->pfcount += 1;
+}
+
+/* fingerprints the next prefetched song that does not have a */
+/* fingerprint yet, so that it can be sent with a later lookup. */
+/* fpcalc is slow, so this is called when no lookup is active, */
+/* and only one song is processed per call. */
+/* returns true if a song was processed. */
+bool
+acoustidPrefetchProcess (audioidacoustid_t *acoustid)
+{
+  acoustidfp_t  afp;
+
+  if (acoustid == NULL || acoustid->pfcount == 0) {
+    return false;
+  }
+
+  acoustidFingerprint (acoustid, acoustid->pfuri [0],
+      acoustid->pfdur [0], &afp, true);
+  acoustidFPFree (&afp);
+  acoustidPrefetchRemove (acoustid, 0);
+  return true;
+}
+
+/* internal routines */
+
+/* the fingerprint is cached, keyed by the audio file, so that */
+/* fpcalc does not need to be run again for a file that has */
+/* already been processed */
+static bool
+acoustidFingerprint (audioidacoustid_t *acoustid, const char *fn,
+    int64_t dur, acoustidfp_t *afp, bool runfpcalc)
+{
+  char          infn [BDJ4_PATH_MAX];
   char          ffn [BDJ4_PATH_MAX];
+  char          fkey [BDJ4_PATH_MAX + 80];
   const char    *targv [10];
   const char    *fpcalc;
   int           targc = 0;
+  char          *fpdata;
+  size_t        retsz = 0;
+  size_t        len;
   mstime_t      starttm;
 
-  fpcalc = sysvarsGetStr (SV_PATH_FPCALC);
-  if (fpcalc == NULL || ! *fpcalc) {
-    logMsg (LOG_DBG, LOG_IMPORTANT, "acoustid: no fpcalc executable");
-    return 0;
-  }
-
-  fn = songGetStr (song, TAG_URI);
+  afp->fp = NULL;
+  afp->key = NULL;
+  afp->ddur = 0.0;
 
   if (audiosrcGetType (fn) != AUDIOSRC_TYPE_FILE) {
     logMsg (LOG_DBG, LOG_IMPORTANT, "acoustid: not an audio file");
-    return 0;
+    return false;
   }
 
   audiosrcFullPath (fn, ffn, sizeof (ffn), NULL, 0);
   if (! fileopFileExists (ffn)) {
-    return 0;
+    return false;
   }
   snprintf (infn, sizeof (infn), "%s%s",
       ffn, bdjvarsGetStr (BDJV_ORIGINAL_EXT));
@@ -210,46 +383,109 @@ acoustidLookup (audioidacoustid_t *acoustid, const song_t *song,
     stpecpy (infn, infn + sizeof (infn), ffn);
   }
 
-  mstimestart (&starttm);
-  /* acoustid prefers at most three calls per second */
-  while (! mstimeCheck (&acoustid->globalreqtimer)) {
-    mssleep (10);
+  /* acoustid's fpcalc truncates the duration */
+  afp->ddur = floor ((double) dur / 1000.0);
+
+  audioidCacheFileKey (infn, fkey, sizeof (fkey));
+  afp->fp = audioidCacheGet (acoustid->cache, AUDIOID_CACHE_FP, fkey, NULL);
+
+  if (afp->fp == NULL && ! runfpcalc) {
+    return false;
   }
-  mstimeset (&acoustid->globalreqtimer, QPS_LIMIT);
-  logMsg (LOG_DBG, LOG_IMPORTANT, "acoustid: wait time: %" PRId64 "ms",
-      (int64_t) mstimeend (&starttm));
 
-  query = mdmalloc (ACOUSTID_BUFF_SZ);
+  if (afp->fp == NULL) {
+    fpcalc = sysvarsGetStr (SV_PATH_FPCALC);
+    if (fpcalc == NULL || ! *fpcalc) {
+      logMsg (LOG_DBG, LOG_IMPORTANT, "acoustid: no fpcalc executable");
+      return false;
+    }
 
-  dur = songGetNum (song, TAG_DURATION);
-  /* acoustid's fpcalc truncates the duration */
-  ddur = floor ((double) dur / 1000.0);
-  logMsg (LOG_DBG, LOG_AUDIO_ID, "acoustid: duration: %.0f", ddur);
+    fpdata = mdmalloc (ACOUSTID_BUFF_SZ);
+    targv [targc++] = fpcalc;
+    targv [targc++] = infn;
+    targv [targc++] = "-plain";
+    targv [targc++] = NULL;
+    mstimestart (&starttm);
+    osProcessPipe (targv, OS_PROC_WAIT | OS_PROC_NOSTDERR,
+        fpdata, ACOUSTID_BUFF_SZ, &retsz);
+    logMsg (LOG_DBG, LOG_IMPORTANT, "acoustid: fp: %" PRId64 "ms",
+        (int64_t) mstimeend (&starttm));
+
+    if (retsz >= ACOUSTID_BUFF_SZ) {
+      retsz = ACOUSTID_BUFF_SZ - 1;
+    }
+    while (retsz > 0 && isspace ((unsigned char) fpdata [retsz - 1])) {
+      --retsz;
+    }
+    fpdata [retsz] = '\0';
+    if (retsz == 0) {
+      logMsg (LOG_DBG, LOG_IMPORTANT, "acoustid: no fingerprint");
+      mdfree (fpdata);
+      return false;
+    }
 
-  fpdata = mdmalloc (ACOUSTID_BUFF_SZ);
+    audioidCacheSet (acoustid->cache, AUDIOID_CACHE_FP, fkey, fpdata, retsz);
+    afp->fp = fpdata;
+  }
+
+  len = strlen (afp->fp) + 40;
+  afp->key = mdmalloc (len);
+  snprintf (afp->key, len, "%.0f %s", afp->ddur, afp->fp);
+  return true;
+}
+
+static void
+acoustidFPFree (acoustidfp_t *afp)
+{
+  dataFree (afp->fp);
+  afp->fp = NULL;
+  dataFree (afp->key);
+  afp->key = NULL;
+}
+
+/* sends the fingerprints in the batch to acoustid. */
+/* the results for each fingerprint are cached, and the */
+/* results for the current song (batch [0]) are saved in curdata. */
+static bool
+acoustidQuery (audioidacoustid_t *acoustid)
+{
+  char          uri [BDJ4_PATH_MAX];
+  char          tbuff [80];
+  char          *query;
+  char          *p;
+  char          *end;
+  size_t        qlen;
+  int           webrc = WEB_BAD_REQUEST;
+  int           count;
+  mstime_t      starttm;
 
-  targv [targc++] = fpcalc;
-  targv [targc++] = infn;
-  targv [targc++] = "-plain";
-  targv [targc++] = NULL;
-  mstimestart (&starttm);
-  osProcessPipe (targv, OS_PROC_WAIT | OS_PROC_NOSTDERR,
-      fpdata, ACOUSTID_BUFF_SZ, &retsz);
-  logMsg (LOG_DBG, LOG_IMPORTANT, "acoustid: fp: %" PRId64 "ms",
-      (int64_t) mstimeend (&starttm));
+  qlen = 400;
+  for (int i = 0; i < acoustid->batchcount; ++i) {
+    qlen += strlen (acoustid->batch [i].fp) + sizeof (tbuff);
+  }
+  query = mdmalloc (qlen);
+  p = query;
+  end = query + qlen;
 
   stpecpy (uri, uri + sizeof (uri), bdjoptGetStr (OPT_URI_AUID_ACOUSTID));
+  p = stpecpy (p, end, "client=");
+  p = stpecpy (p, end, acoustid->key);
   /* if meta-compress is on the track artists are not generated */
-  snprintf (query, ACOUSTID_BUFF_SZ,
-      "client=%s"
-      "&format=xml"
-      "&meta=recordingids+recordings+releases+tracks+artists"
-      "&duration=%.0f"
-      "&fingerprint=%.*s",
-      acoustid->key,
-      ddur,
-      (int) retsz, fpdata
-      );
+  p = stpecpy (p, end, "&format=xml"
+      "&meta=recordingids+recordings+releases+tracks+artists");
+  if (acoustid->batchcount == 1) {
+    snprintf (tbuff, sizeof (tbuff), "&duration=%.0f&fingerprint=",
+        acoustid->batch [0].ddur);
+    p = stpecpy (p, end, tbuff);
+    p = stpecpy (p, end, acoustid->batch [0].fp);
+  } else {
+    for (int i = 0; i < acoustid->batchcount; ++i) {
+      snprintf (tbuff, sizeof (tbuff), "&duration.%d=%.0f&fingerprint.%d=",
+          i, acoustid->batch [i].ddur, i);
+      p = stpecpy (p, end, tbuff);
+      p = stpecpy (p, end, acoustid->batch [i].fp);
+    }
+  }
 
 #if ACOUSTID_REUSE
   if (fileopFileExists (ACOUSTID_TEMP_FN)) {
@@ -269,36 +505,85 @@ acoustidLookup (audioidacoustid_t *acoustid, const song_t *song,
     tstr [tsize] = '\0';
     acoustid->webresponse = tstr;
     fclose (ifh);
+    webrc = WEB_OK;
   } else
 #endif
   {
-    int           webrc;
-
-    mstimestart (&starttm);
     webclientSetTimeout (acoustid->webclient, 20000);
-    webrc = webclientPostCompressed (acoustid->webclient, uri, query);
-    logMsg (LOG_DBG, LOG_IMPORTANT, "acoustid: web-query: %d %" PRId64 "ms",
-        webrc, (int64_t) mstimeend (&starttm));
-    if (webrc != WEB_OK) {
-      return 0;
-    }
-
-    if (logCheck (LOG_DBG, LOG_AUDIOID_DUMP)) {
+    do {
+      audioidRateWait (acoustid->rate);
+      acoustid->webresponse = NULL;
+      acoustid->webresplen = 0;
+      mstimestart (&starttm);
+      webrc = webclientPostCompressed (acoustid->webclient, uri, query);
+      logMsg (LOG_DBG, LOG_IMPORTANT, "acoustid: web-query: %d (%d) %" PRId64 "ms",
+          webrc, acoustid->batchcount, (int64_t) mstimeend (&starttm));
+    } while (audioidRateRetry (acoustid->rate, webrc));
+
+    if (webrc == WEB_OK && logCheck (LOG_DBG, LOG_AUDIOID_DUMP)) {
       dumpData (acoustid);
     }
   }
 
-  if (acoustid->webresponse != NULL && acoustid->webresplen > 0) {
-    mstimestart (&starttm);
-    acoustid->respcount = audioidParseXMLAll (acoustid->webresponse,
-        acoustid->webresplen, acoustidmainxp, resp, AUDIOID_ID_ACOUSTID);
-    logMsg (LOG_DBG, LOG_IMPORTANT, "acoustid: parse: %" PRId64 "ms",
-        (int64_t) mstimeend (&starttm));
+  dataFree (query);
+
+  if (webrc != WEB_OK ||
+      acoustid->webresponse == NULL || acoustid->webresplen == 0) {
+    return false;
   }
 
-  dataFree (query);
-  dataFree (fpdata);
-  return acoustid->respcount;
+  count = audioidParseXMLBatch (acoustid->webresponse, acoustid->webresplen,
+      acoustidBatchCallback, acoustid);
+  if (count < 0) {
+    logMsg (LOG_DBG, LOG_AUDIO_ID, "acoustid: error response");
+  }
+  if (count == 0 && acoustid->batchcount == 1) {
+    /* not a batch, the response is used as is */
+    audioidCacheSet (acoustid->cache, AUDIOID_CACHE_ACOUSTID,
+        acoustid->batch [0].key, acoustid->webresponse, acoustid->webresplen);
+    acoustid->curdata = mdmalloc (acoustid->webresplen + 1);
+    memcpy (acoustid->curdata, acoustid->webresponse, acoustid->webresplen);
+    acoustid->curdata [acoustid->webresplen] = '\0';
+    acoustid->curlen = acoustid->webresplen;
+  }
+
+  return count >= 0;
+}
+
+static void
+acoustidBatchCallback (void *udata, int idx, const char *data, size_t len)
+{
+  audioidacoustid_t   *acoustid = udata;
+
+  if (idx < 0 || idx >= acoustid->batchcount) {
+    return;
+  }
+
+  audioidCacheSet (acoustid->cache, AUDIOID_CACHE_ACOUSTID,
+      acoustid->batch [idx].key, data, len);
+  if (idx == 0) {
+    dataFree (acoustid->curdata);
+    acoustid->curdata = mdmalloc (len + 1);
+    memcpy (acoustid->curdata, data, len);
+    acoustid->curdata [len] = '\0';
+    acoustid->curlen = len;
+  }
+}
+
+static void
+acoustidPrefetchRemove (audioidacoustid_t *acoustid, int idx)
+{
+  if (idx < 0 || idx >= acoustid->pfcount) {
+    return;
+  }
+
+  dataFree (acoustid->pfuri [idx]);
+  for (int i = idx + 1; i < acoustid->pfcount; ++i) {
+    acoustid->pfuri [i - 1] = acoustid->pfuri [i];
+    acoustid->pfdur [i - 1] = acoustid->pfdur [i];
+  }
+  acoustid->pfcount -= 1;
+  acoustid->pfuri [acoustid->pfcount] = NULL;
 }
 
 static void
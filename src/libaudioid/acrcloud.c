@@ -41,7 +41,8 @@ typedef struct audioidacr {
   char          key [50];
   char          secret [50];
   webclient_t   *webclient;
-  mstime_t      globalreqtimer;
+  audioidcache_t *cache;
+  audioidrate_t *rate;
   int           globalreqcount;
   const char    *webresponse;
   size_t        secretlen;
@@ -58,6 +59,11 @@ enum {
   QPS_LIMIT = 1000 / 2 + 1,
 };
 
+enum {
+  ACR_STATUS_OK = 0,
+  ACR_STATUS_NO_RESULT = 1001,
+};
+
 /* roles: AssociatedPerformer, Composer, Conductor, MainArtist */
 static audioidparsedata_t acrroles [] = {
   { TAG_ARTIST, "AssociatedPerformer" },
@@ -129,11 +135,12 @@ static audioidparse_t acrmainstatusjp [] = {
   { AUDIOID_PARSE_END,    AUDIOID_TYPE_TREE, "end-response", NULL, NULL, NULL },
 };
 
+static bool acrQuery (audioidacr_t *acr, const char *infn);
 static void acrWebResponseCallback (void *userdata, const char *respstr, size_t len, time_t tm);
 static void dumpData (audioidacr_t *acr);
 
 audioidacr_t *
-acrInit (void)
+acrInit (audioidcache_t *cache)
 {
   audioidacr_t    *acr;
   const char      *tver;
@@ -143,7 +150,9 @@ acrInit (void)
   acr->webclient = webclientAlloc (acr, acrWebResponseCallback);
   acr->webresponse = NULL;
   acr->webresplen = 0;
-  mstimeset (&acr->globalreqtimer, 0);
+  acr->cache = cache;
+  /* acrcloud allows at most two calls per second for the free service */
+  acr->rate = audioidRateAlloc ("acrcloud", QPS_LIMIT);
   acr->globalreqcount = 0;
 
   *acr->key = '\0';
@@ -175,6 +184,7 @@ acrFree (audioidacr_t *acr)
   }
 
   webclientClose (acr->webclient);
+  audioidRateFree (acr->rate);
   mdfree (acr);
 }
 
@@ -182,63 +192,30 @@ int
 acrLookup (audioidacr_t *acr, const song_t *song, audioid_resp_t *resp)
 {
   char            infn [BDJ4_PATH_MAX];
-  char            uri [BDJ4_PATH_MAX];
-  char            sig [BDJ4_PATH_MAX];
-  unsigned char   digest [200];
-  size_t          rdlen;
-  time_t          tm;
-  char            *b64sig;
-  gcry_mac_hd_t   gch;
-  size_t          fpsize;
-  char            fpszstr [40];
-  char            ts [40];
-  const char      *query [40];
-  int             qc = 0;
-  const char      *targv [15];
-  const char      *acrextr;
-  int             targc = 0;
-  const char      *fn;
   char            ffn [BDJ4_PATH_MAX];
-  char            fpfn [BDJ4_PATH_MAX];
+  char            ckey [BDJ4_PATH_MAX + 80];
+  const char      *fn;
+  const char      *acrextr;
+  const char      *tstr;
+  char            *data;
+  size_t          datalen = 0;
   mstime_t        starttm;
   int             rc;
-  const char      *tstr;
   nlist_t         *respdata;
 
+  acr->respcount = 0;
+
   if (! *acr->key || ! *acr->secret) {
     logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: not configured");
     return 0;
   }
 
-  acrextr = sysvarsGetStr (SV_PATH_ACRCLOUD);
-  if (acrextr == NULL || ! *acrextr) {
-    logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: no acr_extr executable");
-    return 0;
-  }
-
   fn = songGetStr (song, TAG_URI);
   if (audiosrcGetType (fn) != AUDIOSRC_TYPE_FILE) {
     logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: not an audio file");
     return 0;
   }
 
-  ++acr->globalreqcount;
-  if (acr->globalreqcount > FREE_LIMIT) {
-    logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: request limit reached");
-    return 0;
-  }
-
-  mstimestart (&starttm);
-  /* acrcloud allows at most two calls per second for the free service */
-  while (! mstimeCheck (&acr->globalreqtimer)) {
-    mssleep (10);
-  }
-  mstimeset (&acr->globalreqtimer, QPS_LIMIT);
-  logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: wait time: %" PRId64 "ms",
-      (int64_t) mstimeend (&starttm));
-
-  tm = time (NULL);
-
   audiosrcFullPath (fn, ffn, sizeof (ffn), NULL, 0);
   if (! fileopFileExists (ffn)) {
     return 0;
@@ -250,6 +227,92 @@ acrLookup (audioidacr_t *acr, const song_t *song, audioid_resp_t *resp)
     stpecpy (infn, infn + sizeof (infn), ffn);
   }
 
+  /* a cached response does not count against the request limit */
+  audioidCacheFileKey (infn, ckey, sizeof (ckey));
+  data = audioidCacheGet (acr->cache, AUDIOID_CACHE_ACR, ckey, &datalen);
+
+  if (data != NULL) {
+    acr->webresponse = data;
+    acr->webresplen = datalen;
+  } else {
+    acrextr = sysvarsGetStr (SV_PATH_ACRCLOUD);
+    if (acrextr == NULL || ! *acrextr) {
+      logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: no acr_extr executable");
+      return 0;
+    }
+
+    ++acr->globalreqcount;
+    if (acr->globalreqcount > FREE_LIMIT) {
+      logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: request limit reached");
+      return 0;
+    }
+
+    if (! acrQuery (acr, infn)) {
+      return 0;
+    }
+  }
+
+  if (acr->webresponse == NULL || acr->webresplen == 0) {
+    dataFree (data);
+    return 0;
+  }
+
+  mstimestart (&starttm);
+  audioidParseJSONAll (acr->webresponse, acr->webresplen,
+      acrmainstatusjp, resp, AUDIOID_ID_ACRCLOUD);
+  respdata = audioidGetResponseData (resp, resp->respidx);
+  tstr = nlistGetStr (respdata, AUDIOID_TYPE_STATUS_CODE);
+  rc = -1;
+  if (tstr != NULL) {
+    rc = atoi (tstr);
+  }
+  if (data == NULL &&
+      (rc == ACR_STATUS_OK || rc == ACR_STATUS_NO_RESULT)) {
+    audioidCacheSet (acr->cache, AUDIOID_CACHE_ACR, ckey,
+        acr->webresponse, acr->webresplen);
+  }
+  if (rc == ACR_STATUS_OK) {
+    acr->respcount = audioidParseJSONAll (acr->webresponse, acr->webresplen,
+        acrmainjp, resp, AUDIOID_ID_ACRCLOUD);
+  } else if (rc != -1) {
+    logMsg (LOG_DBG, LOG_AUDIO_ID, "acrcloud: code: %d / %s", rc,
+        nlistGetStr (respdata, AUDIOID_TYPE_STATUS_MSG));
+  } else {
+    logMsg (LOG_DBG, LOG_AUDIO_ID, "acrcloud: parse failed");
+  }
+  logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: parse: %" PRId64 "ms",
+      (int64_t) mstimeend (&starttm));
+
+  acr->webresponse = NULL;
+  acr->webresplen = 0;
+  dataFree (data);
+  return acr->respcount;
+}
+
+/* internal routines */
+
+static bool
+acrQuery (audioidacr_t *acr, const char *infn)
+{
+  char            uri [BDJ4_PATH_MAX];
+  char            sig [BDJ4_PATH_MAX];
+  unsigned char   digest [200];
+  size_t          rdlen;
+  time_t          tm;
+  char            *b64sig;
+  gcry_mac_hd_t   gch;
+  size_t          fpsize;
+  char            fpszstr [40];
+  char            ts [40];
+  const char      *query [40];
+  int             qc = 0;
+  const char      *targv [15];
+  int             targc = 0;
+  char            fpfn [BDJ4_PATH_MAX];
+  mstime_t        starttm;
+  int             rc;
+  int             webrc = WEB_BAD_REQUEST;
+
   pathbldMakePath (fpfn, sizeof (fpfn), "acrcloud-fp", BDJ4_CONFIG_EXT,
       PATHBLD_MP_DREL_TMP);
 
@@ -265,6 +328,9 @@ acrLookup (audioidacr_t *acr, const song_t *song, audioid_resp_t *resp)
   logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: fp: %" PRId64 "ms",
       (int64_t) mstimeend (&starttm));
 
+  audioidRateWait (acr->rate);
+  tm = time (NULL);
+
   snprintf (uri, sizeof (uri), "https://%s/v1/identify",
       bdjoptGetStr (OPT_G_ACRCLOUD_API_HOST));
 
@@ -275,24 +341,27 @@ acrLookup (audioidacr_t *acr, const song_t *song, audioid_resp_t *resp)
   rc = gcry_mac_open (&gch, GCRY_MAC_HMAC_SHA1, 0, NULL);
   if (rc != GPG_ERR_NO_ERROR) {
     logMsg (LOG_DBG, LOG_IMPORTANT, "mac-open error: %s", gcry_strerror (rc));
-    return 0;
+    return false;
   }
   rc = gcry_mac_setkey (gch, acr->secret, acr->secretlen);
   if (rc != GPG_ERR_NO_ERROR) {
     logMsg (LOG_DBG, LOG_IMPORTANT, "mac-setkey error: %s", gcry_strerror (rc));
-    return 0;
+    gcry_mac_close (gch);
+    return false;
   }
   rc = gcry_mac_write (gch, sig, strlen (sig));
   if (rc != GPG_ERR_NO_ERROR) {
     logMsg (LOG_DBG, LOG_IMPORTANT, "mac-write error: %s", gcry_strerror (rc));
-    return 0;
+    gcry_mac_close (gch);
+    return false;
   }
   *digest = '\0';
   rdlen = sizeof (digest);
   rc = gcry_mac_read (gch, digest, &rdlen);
+  gcry_mac_close (gch);
   if (rc != GPG_ERR_NO_ERROR) {
     logMsg (LOG_DBG, LOG_IMPORTANT, "mac-read error: %s", gcry_strerror (rc));
-    return 0;
+    return false;
   }
   b64sig = g_base64_encode (digest, rdlen);
   mdextalloc (b64sig);
@@ -333,52 +402,33 @@ acrLookup (audioidacr_t *acr, const song_t *song, audioid_resp_t *resp)
     tstr [tsize] = '\0';
     acr->webresponse = tstr;
     fclose (ifh);
+    webrc = WEB_OK;
   } else
 #endif
   {
-    int             webrc;
-
-    mstimestart (&starttm);
     webclientSetTimeout (acr->webclient, 20000);
-    webrc = webclientUploadFile (acr->webclient, uri, query, fpfn, "sample");
-    logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: web-query: %d %" PRId64 "ms",
-        webrc, (int64_t) mstimeend (&starttm));
-    if (webrc != WEB_OK) {
-      return 0;
+    while (true) {
+      acr->webresponse = NULL;
+      acr->webresplen = 0;
+      mstimestart (&starttm);
+      webrc = webclientUploadFile (acr->webclient, uri, query, fpfn, "sample");
+      logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: web-query: %d %" PRId64 "ms",
+          webrc, (int64_t) mstimeend (&starttm));
+      if (! audioidRateRetry (acr->rate, webrc)) {
+        break;
+      }
+      audioidRateWait (acr->rate);
     }
 
-    if (logCheck (LOG_DBG, LOG_AUDIOID_DUMP)) {
+    if (webrc == WEB_OK && logCheck (LOG_DBG, LOG_AUDIOID_DUMP)) {
       dumpData (acr);
     }
   }
 
-  gcry_mac_close (gch);
   mdextfree (b64sig);
   free (b64sig);
 
-  mstimestart (&starttm);
-  audioidParseJSONAll (acr->webresponse, acr->webresplen,
-      acrmainstatusjp, resp, AUDIOID_ID_ACRCLOUD);
-  respdata = audioidGetResponseData (resp, resp->respidx);
-  tstr = nlistGetStr (respdata, AUDIOID_TYPE_STATUS_CODE);
-  acr->respcount = 0;
-  rc = -1;
-  if (tstr != NULL) {
-    rc = atoi (tstr);
-  }
-  if (rc == 0) {
-    acr->respcount = audioidParseJSONAll (acr->webresponse, acr->webresplen,
-        acrmainjp, resp, AUDIOID_ID_ACRCLOUD);
-  } else if (rc != -1) {
-    logMsg (LOG_DBG, LOG_AUDIO_ID, "acrcloud: code: %d / %s", rc,
-        nlistGetStr (respdata, AUDIOID_TYPE_STATUS_MSG));
-  } else {
-    logMsg (LOG_DBG, LOG_AUDIO_ID, "acrcloud: parse failed");
-  }
-  logMsg (LOG_DBG, LOG_IMPORTANT, "acrcloud: parse: %" PRId64 "ms",
-      (int64_t) mstimeend (&starttm));
-
-  return acr->respcount;
+  return webrc == WEB_OK;
 }
 
 static void
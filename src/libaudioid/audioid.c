@@ -16,6 +16,7 @@
 #include "bdjstring.h"
 #include "log.h"
 #include "mdebug.h"
+#include "pathbld.h"
 #include "slist.h"
 #include "song.h"
 #include "tagdef.h"
@@ -37,6 +38,7 @@ enum {
 };
 
 typedef struct audioid {
+  audioidcache_t    *cache;
   audioidmb_t       *mb;
   audioidacoustid_t *acoustid;
   audioidacr_t      *acr;
@@ -49,6 +51,7 @@ typedef struct audioid {
   int               respcount [AUDIOID_ID_MAX];
 } audioid_t;
 
+static void audioidServiceInit (audioid_t *audioid);
 static double audioidAdjustScoreNum (audioid_t *audioid, int key, int tagidx, const song_t *song, double score);
 static double audioidAdjustScoreStr (audioid_t *audioid, int key, int tagidx, const song_t *song, double score);
 static audioid_resp_t * audioidResponseAlloc (void);
@@ -60,8 +63,12 @@ audioid_t *
 audioidInit (void)
 {
   audioid_t *audioid;
+  char      dir [BDJ4_PATH_MAX];
 
   audioid = mdmalloc (sizeof (audioid_t));
+  pathbldMakePath (dir, sizeof (dir), AUDIOID_CACHE_DIR, "",
+      PATHBLD_MP_DREL_DATA | PATHBLD_MP_USEIDX);
+  audioid->cache = audioidCacheAlloc (dir, AUDIOID_CACHE_AGE);
   audioid->mb = NULL;
   audioid->acoustid = NULL;
   audioid->acr = NULL;
@@ -104,6 +111,7 @@ audioidFree (audioid_t *audioid)
   mbFree (audioid->mb);
   acoustidFree (audioid->acoustid);
   acrFree (audioid->acr);
+  audioidCacheFree (audioid->cache);
   nlistFree (audioid->dupchklist);
   mdfree (audioid);
 }
@@ -117,16 +125,12 @@ audioidLookup (audioid_t *audioid, const song_t *song)
   mstime_t    starttm;
 
   mstimestart (&starttm);
-  if (audioid->mb == NULL) {
-    audioid->mb = mbInit ();
-    audioid->acoustid = acoustidInit ();
-    audioid->acr = acrInit ();
-  }
-
   if (audioid == NULL || song == NULL) {
     return 0;
   }
 
+  audioidServiceInit (audioid);
+
   if (audioid->state == BDJ4_STATE_OFF ||
       audioid->state == BDJ4_STATE_FINISH) {
     /* audioid_start is set to audioid_id_acoustid unless debugging */
@@ -370,8 +374,56 @@ audioidGetList (audioid_t *audioid, int key)
   return list;
 }
 
+void
+audioidPrefetchClear (audioid_t *audioid)
+{
+  if (audioid == NULL) {
+    return;
+  }
+
+  acoustidPrefetchClear (audioid->acoustid);
+}
+
+/* the upcoming songs are sent along with a later lookup */
+/* to the services that support batched requests, and the results */
+/* are cached.  add the songs in the order they will be processed. */
+void
+audioidPrefetchAdd (audioid_t *audioid, const song_t *song)
+{
+  if (audioid == NULL || song == NULL) {
+    return;
+  }
+
+  audioidServiceInit (audioid);
+  acoustidPrefetchAdd (audioid->acoustid, songGetStr (song, TAG_URI),
+      songGetNum (song, TAG_DURATION));
+}
+
+/* prepares one of the upcoming songs, call when idle */
+bool
+audioidPrefetchProcess (audioid_t *audioid)
+{
+  if (audioid == NULL) {
+    return false;
+  }
+
+  return acoustidPrefetchProcess (audioid->acoustid);
+}
+
 /* internal routines */
 
+static void
+audioidServiceInit (audioid_t *audioid)
+{
+  if (audioid->mb != NULL) {
+    return;
+  }
+
+  audioid->mb = mbInit (audioid->cache);
+  audioid->acoustid = acoustidInit (audioid->cache);
+  audioid->acr = acrInit (audioid->cache);
+}
+
 static double
 audioidAdjustScoreNum (audioid_t *audioid, int key, int tagidx,
     const song_t *song, double score)
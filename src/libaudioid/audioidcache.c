@@ -0,0 +1,265 @@
+/*
+ * Copyright 2023-2026 Brad Lanam Pleasant Hill CA
+ */
+/*
+ * audio identification cache
+ *
+ * The raw responses from the identification services are saved so
+ * that a song that has already been looked up does not require
+ * another query (and rate limit wait).  The fingerprints are also
+ * saved, keyed by the audio file's name, size and modification time,
+ * so that the fingerprint does not need to be re-calculated.
+ *
+ * Each entry is a separate file named by a hash of the type and key.
+ * The key is stored as the first line of the file, and is checked
+ * on retrieval in case of a hash collision.
+ *
+ * Entries older than the maximum age are removed.
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "audioid.h"
+#include "bdj4.h"
+#include "bdjstring.h"
+#include "dirlist.h"
+#include "dirop.h"
+#include "filemanip.h"
+#include "fileop.h"
+#include "log.h"
+#include "mdebug.h"
+#include "slist.h"
+
+#define AUDIOID_CACHE_TMP_EXT ".tmp"
+
+static const char *audioidcachepfx [AUDIOID_CACHE_MAX] = {
+  [AUDIOID_CACHE_FP] = "fp",
+  [AUDIOID_CACHE_ACOUSTID] = "acoustid",
+  [AUDIOID_CACHE_MB] = "mb",
+  [AUDIOID_CACHE_ACR] = "acr",
+};
+
+typedef struct audioidcache {
+  char      *dir;
+  time_t    maxage;
+  int       hits;
+  int       misses;
+} audioidcache_t;
+
+static void audioidCacheClean (audioidcache_t *cache);
+static void audioidCacheFileName (audioidcache_t *cache, audioidcachetype_t type, const char *key, char *buff, size_t sz);
+
+audioidcache_t *
+audioidCacheAlloc (const char *dir, time_t maxage)
+{
+  audioidcache_t  *cache;
+
+  if (dir == NULL) {
+    return NULL;
+  }
+
+  cache = mdmalloc (sizeof (audioidcache_t));
+  cache->dir = mdstrdup (dir);
+  cache->maxage = maxage;
+  cache->hits = 0;
+  cache->misses = 0;
+
+  diropMakeDir (dir);
+  audioidCacheClean (cache);
+
+  return cache;
+}
+
+void
+audioidCacheFree (audioidcache_t *cache)
+{
+  if (cache == NULL) {
+    return;
+  }
+
+  logMsg (LOG_DBG, LOG_AUDIO_ID, "audioid-cache: hits: %d misses: %d",
+      cache->hits, cache->misses);
+  dataFree (cache->dir);
+  mdfree (cache);
+}
+
+/* the returned data must be freed by the caller */
+char *
+audioidCacheGet (audioidcache_t *cache, audioidcachetype_t type,
+    const char *key, size_t *len)
+{
+  char      fn [BDJ4_PATH_MAX];
+  char      *data;
+  char      *p;
+  size_t    klen;
+  ssize_t   fsz;
+  FILE      *fh;
+
+  if (len != NULL) {
+    *len = 0;
+  }
+  if (cache == NULL || key == NULL || type >= AUDIOID_CACHE_MAX) {
+    return NULL;
+  }
+
+  audioidCacheFileName (cache, type, key, fn, sizeof (fn));
+  fsz = fileopSize (fn);
+  if (fsz <= 0) {
+    cache->misses += 1;
+    return NULL;
+  }
+
+  if (fileopModTime (fn) < time (NULL) - cache->maxage) {
+    logMsg (LOG_DBG, LOG_AUDIO_ID, "audioid-cache: expired %s", fn);
+    fileopDelete (fn);
+    cache->misses += 1;
+    return NULL;
+  }
+
+  fh = fileopOpen (fn, "rb");
+  if (fh == NULL) {
+    cache->misses += 1;
+    return NULL;
+  }
+  data = mdmalloc (fsz + 1);
+  if (fread (data, fsz, 1, fh) != 1) {
+    fsz = 0;
+  }
+  mdextfclose (fh);
+  fclose (fh);
+  data [fsz] = '\0';
+
+  /* check the key, the hash may have a collision */
+  klen = strlen (key);
+  p = NULL;
+  if ((size_t) fsz > klen &&
+      strncmp (data, key, klen) == 0 &&
+      data [klen] == '\n') {
+    p = data + klen + 1;
+  }
+  if (p == NULL) {
+    mdfree (data);
+    cache->misses += 1;
+    return NULL;
+  }
+
+  fsz -= p - data;
+  memmove (data, p, fsz + 1);
+  if (len != NULL) {
+    *len = fsz;
+  }
+  cache->hits += 1;
+  logMsg (LOG_DBG, LOG_AUDIO_ID, "audioid-cache: hit %s %s",
+      audioidcachepfx [type], fn);
+  return data;
+}
+
+bool
+audioidCacheExists (audioidcache_t *cache, audioidcachetype_t type,
+    const char *key)
+{
+  char    *data;
+  bool    rc = false;
+
+  data = audioidCacheGet (cache, type, key, NULL);
+  if (data != NULL) {
+    rc = true;
+  }
+  dataFree (data);
+  return rc;
+}
+
+/* the entry is written to a temporary file and then renamed */
+/* so that a partial entry is never read */
+bool
+audioidCacheSet (audioidcache_t *cache, audioidcachetype_t type,
+    const char *key, const char *data, size_t len)
+{
+  char    fn [BDJ4_PATH_MAX];
+  char    tfn [BDJ4_PATH_MAX];
+  FILE    *fh;
+  bool    rc = true;
+
+  if (cache == NULL || key == NULL || data == NULL ||
+      type >= AUDIOID_CACHE_MAX) {
+    return false;
+  }
+
+  audioidCacheFileName (cache, type, key, fn, sizeof (fn));
+  snprintf (tfn, sizeof (tfn), "%s%s", fn, AUDIOID_CACHE_TMP_EXT);
+  fh = fileopOpen (tfn, "wb");
+  if (fh == NULL) {
+    return false;
+  }
+  if (fprintf (fh, "%s\n", key) < 0) {
+    rc = false;
+  }
+  if (rc && len > 0 && fwrite (data, len, 1, fh) != 1) {
+    rc = false;
+  }
+  mdextfclose (fh);
+  fclose (fh);
+
+  if (! rc) {
+    logMsg (LOG_ERR, LOG_IMPORTANT, "ERR: audioid-cache: write failed %s", tfn);
+    fileopDelete (tfn);
+    return false;
+  }
+
+  filemanipMove (tfn, fn);
+  logMsg (LOG_DBG, LOG_AUDIO_ID, "audioid-cache: set %s %s",
+      audioidcachepfx [type], fn);
+  return true;
+}
+
+/* a key that identifies an audio file's content without reading it */
+void
+audioidCacheFileKey (const char *fn, char *buff, size_t sz)
+{
+  snprintf (buff, sz, "%s\t%" PRId64 "\t%" PRId64,
+      fn, (int64_t) fileopSize (fn), (int64_t) fileopModTime (fn));
+}
+
+/* internal routines */
+
+static void
+audioidCacheClean (audioidcache_t *cache)
+{
+  slist_t     *filelist;
+  slistidx_t  iteridx;
+  const char  *fn;
+  char        tbuff [BDJ4_PATH_MAX];
+  time_t      oldest;
+  int         count = 0;
+
+  oldest = time (NULL) - cache->maxage;
+  filelist = dirlistBasicDirList (cache->dir, NULL);
+  slistStartIterator (filelist, &iteridx);
+  while ((fn = slistIterateKey (filelist, &iteridx)) != NULL) {
+    snprintf (tbuff, sizeof (tbuff), "%s/%s", cache->dir, fn);
+    if (fileopModTime (tbuff) < oldest) {
+      fileopDelete (tbuff);
+      ++count;
+    }
+  }
+  slistFree (filelist);
+
+  if (count > 0) {
+    logMsg (LOG_DBG, LOG_AUDIO_ID, "audioid-cache: removed %d expired", count);
+  }
+}
+
+static void
+audioidCacheFileName (audioidcache_t *cache, audioidcachetype_t type,
+    const char *key, char *buff, size_t sz)
+{
+  snprintf (buff, sz, "%s/%s-%016" PRIx64,
+      cache->dir, audioidcachepfx [type], stringHash64 (key));
+}
@@ -16,6 +16,27 @@
 #include "mdebug.h"
 #include "nlist.h"
 #include "tagdef.h"
+#include "tmutil.h"
+#include "webresp.h"
+
+enum {
+  /* the number of times a request is retried when the service */
+  /* indicates that it is busy */
+  AUDIOID_RETRY_MAX = 3,
+  AUDIOID_RATE_MAX_INTERVAL = 16000,
+};
+
+/* the services limit the number of queries per second. */
+/* when a service returns a 429 or 503, the interval between requests */
+/* is increased and the request is retried.  the interval drops back */
+/* towards the base interval as requests succeed. */
+typedef struct audioidrate {
+  const char  *name;
+  mstime_t    reqtimer;
+  int         interval;
+  int         baseinterval;
+  int         retries;
+} audioidrate_t;
 
 bool
 audioidSetResponseData (int level, audioid_resp_t *resp,
@@ -135,3 +156,79 @@ audioidDumpResult (nlist_t *respdata)
   }
 }
 
+audioidrate_t *
+audioidRateAlloc (const char *name, int interval)
+{
+  audioidrate_t   *rate;
+
+  rate = mdmalloc (sizeof (audioidrate_t));
+  rate->name = name;
+  mstimeset (&rate->reqtimer, 0);
+  rate->interval = interval;
+  rate->baseinterval = interval;
+  rate->retries = 0;
+  return rate;
+}
+
+void
+audioidRateFree (audioidrate_t *rate)
+{
+  if (rate == NULL) {
+    return;
+  }
+
+  mdfree (rate);
+}
+
+void
+audioidRateWait (audioidrate_t *rate)
+{
+  mstime_t    starttm;
+
+  if (rate == NULL) {
+    return;
+  }
+
+  mstimestart (&starttm);
+  while (! mstimeCheck (&rate->reqtimer)) {
+    mssleep (10);
+  }
+  mstimeset (&rate->reqtimer, rate->interval);
+  logMsg (LOG_DBG, LOG_IMPORTANT, "%s: wait time: %" PRId64 "ms",
+      rate->name, (int64_t) mstimeend (&starttm));
+}
+
+/* returns true if the request should be retried */
+bool
+audioidRateRetry (audioidrate_t *rate, int webrc)
+{
+  if (rate == NULL) {
+    return false;
+  }
+
+  if (webrc == WEB_TOO_MANY_REQ || webrc == WEB_SERVICE_UNAVAIL) {
+    if (rate->interval < AUDIOID_RATE_MAX_INTERVAL) {
+      rate->interval *= 2;
+    }
+    mstimeset (&rate->reqtimer, rate->interval);
+    if (rate->retries < AUDIOID_RETRY_MAX) {
+      rate->retries += 1;
+      logMsg (LOG_DBG, LOG_IMPORTANT, "%s: busy %d, retry %d interval %d",
+          rate->name, webrc, rate->retries, rate->interval);
+      return true;
+    }
+    logMsg (LOG_DBG, LOG_IMPORTANT, "%s: busy %d, no more retries",
+        rate->name, webrc);
+    rate->retries = 0;
+    return false;
+  }
+
+  rate->retries = 0;
+  if (webrc == WEB_OK && rate->interval > rate->baseinterval) {
+    rate->interval /= 2;
+    if (rate->interval < rate->baseinterval) {
+      rate->interval = rate->baseinterval;
+    }
+  }
+  return false;
+}
@@ -27,6 +27,7 @@
 #include "nlist.h"
 #include "tagdef.h"
 
+static xmlDocPtr audioidXMLLoad (const char *data, size_t datalen);
 static bool audioidParse (xmlXPathContextPtr xpathCtx, audioidparse_t *xpaths, int xpathidx, audioid_resp_t *resp, int level, audioid_id_t ident);
 static bool audioidParseTree (xmlNodeSetPtr nodes, audioidparse_t *xpaths, int parenttagidx, audioid_resp_t *resp, int level, audioid_id_t ident);
 
@@ -48,28 +49,10 @@ audioidParseXMLAll (const char *data, size_t datalen,
 {
   xmlDocPtr           doc;
   xmlXPathContextPtr  xpathCtx;
-  char                *tdata = NULL;
-  char                *p;
   int                 respcount = 0;
   int                 respidx;
 
-  /* libxml2 doesn't have any way to set the default namespace for xpath */
-  /* which makes it a pain to use when a namespace is set */
-  tdata = mdmalloc (datalen + 1);
-  memcpy (tdata, data, datalen);
-  tdata [datalen] = '\0';
-  p = strstr (tdata, "xmlns");
-  if (p != NULL) {
-    char    *pe;
-    size_t  len;
-
-    pe = strstr (p, ">");
-    len = pe - p;
-    memset (p, ' ', len);
-  }
-
-  doc = xmlParseMemory (tdata, datalen);
-  mdextalloc (doc);
+  doc = audioidXMLLoad (data, datalen);
   if (doc == NULL) {
     return 0;
   }
@@ -95,10 +78,152 @@ audioidParseXMLAll (const char *data, size_t datalen,
   xmlXPathFreeContext (xpathCtx);
   mdextfree (doc);
   xmlFreeDoc (doc);
-  mdfree (tdata);
   return respcount;
 }
 
+/* a batched acoustid response has a list of fingerprints, */
+/* each with an index and a list of results. */
+/* each set of results is passed to the callback as a separate */
+/* response document, in the same form as a single lookup response. */
+/* returns -1 if the response status is not ok, otherwise the */
+/* number of fingerprints in the response. */
+int
+audioidParseXMLBatch (const char *data, size_t datalen,
+    audioidbatchcb_t cb, void *udata)
+{
+  xmlDocPtr           doc;
+  xmlXPathContextPtr  xpathCtx;
+  xmlXPathObjectPtr   xpathObj;
+  xmlNodeSetPtr       nodes;
+  xmlChar             *val;
+  xmlBufferPtr        xbuff;
+  int                 count = -1;
+
+  doc = audioidXMLLoad (data, datalen);
+  if (doc == NULL) {
+    return -1;
+  }
+
+  xpathCtx = xmlXPathNewContext (doc);
+  mdextalloc (xpathCtx);
+  if (xpathCtx == NULL) {
+    mdextfree (doc);
+    xmlFreeDoc (doc);
+    return -1;
+  }
+
+  xpathObj = xmlXPathEvalExpression ((xmlChar *) "/response/status", xpathCtx);
+  mdextalloc (xpathObj);
+  if (xpathObj != NULL && ! xmlXPathNodeSetIsEmpty (xpathObj->nodesetval)) {
+    val = xmlNodeGetContent (xpathObj->nodesetval->nodeTab [0]);
+    mdextalloc (val);
+    if (val != NULL && strcmp ((const char *) val, "ok") == 0) {
+      count = 0;
+    }
+    mdextfree (val);
+    xmlFree (val);
+  }
+  mdextfree (xpathObj);
+  xmlXPathFreeObject (xpathObj);
+
+  xpathObj = NULL;
+  if (count == 0) {
+    xpathObj = xmlXPathEvalExpression (
+        (xmlChar *) "/response/fingerprints/fingerprint", xpathCtx);
+    mdextalloc (xpathObj);
+  }
+  if (xpathObj != NULL && ! xmlXPathNodeSetIsEmpty (xpathObj->nodesetval)) {
+    nodes = xpathObj->nodesetval;
+    xbuff = xmlBufferCreate ();
+    mdextalloc (xbuff);
+
+    for (int i = 0; i < nodes->nodeNr; ++i) {
+      xmlNodePtr  cur;
+      xmlNodePtr  results = NULL;
+      int         idx = -1;
+
+      for (cur = nodes->nodeTab [i]->children; cur != NULL; cur = cur->next) {
+        if (cur->type != XML_ELEMENT_NODE) {
+          continue;
+        }
+        if (strcmp ((const char *) cur->name, "index") == 0) {
+          val = xmlNodeGetContent (cur);
+          mdextalloc (val);
+          if (val != NULL) {
+            idx = atoi ((const char *) val);
+          }
+          mdextfree (val);
+          xmlFree (val);
+        }
+        if (strcmp ((const char *) cur->name, "results") == 0) {
+          results = cur;
+        }
+      }
+      if (idx < 0) {
+        continue;
+      }
+
+      xmlBufferEmpty (xbuff);
+      xmlBufferCCat (xbuff, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+          "<response><status>ok</status>");
+      if (results != NULL) {
+        xmlNodeDump (xbuff, doc, results, 0, 0);
+      } else {
+        xmlBufferCCat (xbuff, "<results/>");
+      }
+      xmlBufferCCat (xbuff, "</response>\n");
+      cb (udata, idx, (const char *) xmlBufferContent (xbuff),
+          xmlBufferLength (xbuff));
+      ++count;
+    }
+
+    mdextfree (xbuff);
+    xmlBufferFree (xbuff);
+  }
+  if (xpathObj != NULL) {
+    mdextfree (xpathObj);
+    xmlXPathFreeObject (xpathObj);
+  }
+
+  logMsg (LOG_DBG, LOG_AUDIO_ID, "xml-parse: batch: %d", count);
+
+  mdextfree (xpathCtx);
+  xmlXPathFreeContext (xpathCtx);
+  mdextfree (doc);
+  xmlFreeDoc (doc);
+  return count;
+}
+
+/* internal routines */
+
+static xmlDocPtr
+audioidXMLLoad (const char *data, size_t datalen)
+{
+  xmlDocPtr   doc;
+  char        *tdata = NULL;
+  char        *p;
+
+  /* libxml2 doesn't have any way to set the default namespace for xpath */
+  /* which makes it a pain to use when a namespace is set */
+  tdata = mdmalloc (datalen + 1);
+  memcpy (tdata, data, datalen);
+  tdata [datalen] = '\0';
+  p = strstr (tdata, "xmlns");
+  if (p != NULL) {
+    char    *pe;
+    size_t  len;
+
+    pe = strstr (p, ">");
+    len = pe - p;
+    memset (p, ' ', len);
+  }
+
+  doc = xmlParseMemory (tdata, datalen);
+  mdextalloc (doc);
+  mdfree (tdata);
+  return doc;
+}
+
 static bool
 audioidParse (xmlXPathContextPtr xpathCtx, audioidparse_t *xpaths,
     int xpathidx, audioid_resp_t *resp, int level, audioid_id_t ident)
@@ -26,9 +26,10 @@
 
 typedef struct audioidmb {
   webclient_t   *webclient;
+  audioidcache_t *cache;
+  audioidrate_t *rate;
   const char    *webresponse;
   size_t        webresplen;
-  mstime_t      globalreqtimer;
   int           respcount;
 } audioidmb_t;
 
@@ -108,15 +109,18 @@ static void mbWebResponseCallback (void *userdata, const char *respstr, size_t l
 static void dumpData (audioidmb_t *mb);
 
 audioidmb_t *
-mbInit (void)
+mbInit (audioidcache_t *cache)
 {
   audioidmb_t *mb;
 
   mb = mdmalloc (sizeof (audioidmb_t));
   mb->webclient = webclientAlloc (mb, mbWebResponseCallback);
+  mb->cache = cache;
+  /* musicbrainz prefers only one call per second */
+  mb->rate = audioidRateAlloc ("mb", QPS_LIMIT);
   mb->webresponse = NULL;
   mb->webresplen = 0;
-  mstimeset (&mb->globalreqtimer, 0);
+  mb->respcount = 0;
 
   return mb;
 }
@@ -133,6 +137,7 @@ mbFree (audioidmb_t *mb)
   mb->webresponse = NULL;
   mb->webresplen = 0;
   mb->respcount = 0;
+  audioidRateFree (mb->rate);
   mdfree (mb);
 }
 
@@ -143,64 +148,72 @@ mbRecordingIdLookup (audioidmb_t *mb, const char *recid, audioid_resp_t *resp)
   mstime_t      starttm;
   char          *p = uri;
   char          *end = uri + sizeof (uri);
+  char          *data;
+  size_t        datalen = 0;
 
-  /* musicbrainz prefers only one call per second */
-  mstimestart (&starttm);
-  while (! mstimeCheck (&mb->globalreqtimer)) {
-    mssleep (10);
-  }
-  mstimeset (&mb->globalreqtimer, QPS_LIMIT);
-  logMsg (LOG_DBG, LOG_IMPORTANT, "mb: wait time: %" PRId64 "ms",
-      (int64_t) mstimeend (&starttm));
-
-  p = stpecpy (p, end, bdjoptGetStr (OPT_URI_AUID_MUSICBRAINZ));
-  p = stpecpy (p, end, "/recording/");
-  p = stpecpy (p, end, recid);
-  /* artist-credits retrieves the additional artists for the song */
-  /* media is needed to get the track number and track total */
-  /* work-rels is needed to get the work-id */
-  /* releases is used to get the list of releases for this recording */
-  /*    a match can then possibly be made by album name/track number */
-  /* releases is used to get the list of releases for this recording */
-  /* musicbrainz limits the number of responses to 25, and there appears */
-  /* to be many duplicates.  I could use better filtering. */
-  /* for this reason, musicbrainz is not used as the primary source. */
-  p = stpecpy (p, end, "?inc=artist-credits+work-rels+releases+artists+media+isrcs");
-  logMsg (LOG_DBG, LOG_AUDIO_ID, "audioid: mb: uri: %s", uri);
+  mb->respcount = 0;
+
+  data = audioidCacheGet (mb->cache, AUDIOID_CACHE_MB, recid, &datalen);
+  if (data != NULL) {
+    mb->webresponse = data;
+    mb->webresplen = datalen;
+  } else {
+    p = stpecpy (p, end, bdjoptGetStr (OPT_URI_AUID_MUSICBRAINZ));
+    p = stpecpy (p, end, "/recording/");
+    p = stpecpy (p, end, recid);
+    /* artist-credits retrieves the additional artists for the song */
+    /* media is needed to get the track number and track total */
+    /* work-rels is needed to get the work-id */
+    /* releases is used to get the list of releases for this recording */
+    /*    a match can then possibly be made by album name/track number */
+    /* releases is used to get the list of releases for this recording */
+    /* musicbrainz limits the number of responses to 25, and there appears */
+    /* to be many duplicates.  I could use better filtering. */
+    /* for this reason, musicbrainz is not used as the primary source. */
+    p = stpecpy (p, end, "?inc=artist-credits+work-rels+releases+artists+media+isrcs");
+    logMsg (LOG_DBG, LOG_AUDIO_ID, "audioid: mb: uri: %s", uri);
 
 #if MUSICBRAINZ_REUSE
-  if (fileopFileExists (MUSICBRAINZ_TEMP_FN)) {
-    FILE    *ifh;
-    size_t  tsize;
-    char    *tstr;
-
-    logMsg (LOG_DBG, LOG_IMPORTANT, "musicbrainz: ** re-using web response");
-    /* debugging :  re-use out-mb.xml file as input rather */
-    /*              than making another query */
-    tsize = fileopSize (MUSICBRAINZ_TEMP_FN);
-    ifh = fopen (MUSICBRAINZ_TEMP_FN, "r");
-    mb->webresplen = tsize;
-    /* this will leak */
-    tstr = malloc (tsize + 1);
-    (void) ! fread (tstr, tsize, 1, ifh);
-    tstr [tsize] = '\0';
-    mb->webresponse = tstr;
-    fclose (ifh);
-  } else
+    if (fileopFileExists (MUSICBRAINZ_TEMP_FN)) {
+      FILE    *ifh;
+      size_t  tsize;
+      char    *tstr;
+
+      logMsg (LOG_DBG, LOG_IMPORTANT, "musicbrainz: ** re-using web response");
+      /* debugging :  re-use out-mb.xml file as input rather */
+      /*              than making another query */
+      tsize = fileopSize (MUSICBRAINZ_TEMP_FN);
+      ifh = fopen (MUSICBRAINZ_TEMP_FN, "r");
+      mb->webresplen = tsize;
+      /* this will leak */
+      tstr = malloc (tsize + 1);
+      (void) ! fread (tstr, tsize, 1, ifh);
+      tstr [tsize] = '\0';
+      mb->webresponse = tstr;
+      fclose (ifh);
+    } else
 #endif
-  {
-    int   webrc;
-
-    mstimestart (&starttm);
-    webrc = webclientGet (mb->webclient, uri);
-    logMsg (LOG_DBG, LOG_IMPORTANT, "mb: web-query: %d %" PRId64 "ms",
-        webrc, (int64_t) mstimeend (&starttm));
-    if (webrc != WEB_OK) {
-      return 0;
-    }
-
-    if (logCheck (LOG_DBG, LOG_AUDIOID_DUMP)) {
-      dumpData (mb);
+    {
+      int   webrc;
+
+      do {
+        audioidRateWait (mb->rate);
+        mb->webresponse = NULL;
+        mb->webresplen = 0;
+        mstimestart (&starttm);
+        webrc = webclientGet (mb->webclient, uri);
+        logMsg (LOG_DBG, LOG_IMPORTANT, "mb: web-query: %d %" PRId64 "ms",
+            webrc, (int64_t) mstimeend (&starttm));
+      } while (audioidRateRetry (mb->rate, webrc));
+      if (webrc != WEB_OK) {
+        return 0;
+      }
+
+      if (logCheck (LOG_DBG, LOG_AUDIOID_DUMP)) {
+        dumpData (mb);
+      }
+      audioidCacheSet (mb->cache, AUDIOID_CACHE_MB, recid,
+          mb->webresponse, mb->webresplen);
     }
   }
 
@@ -212,6 +225,9 @@ mbRecordingIdLookup (audioidmb_t *mb, const char *recid, audioid_resp_t *resp)
         (int64_t) mstimeend (&starttm));
   }
 
+  mb->webresponse = NULL;
+  mb->webresplen = 0;
+  dataFree (data);
   return mb->respcount;
 }
 
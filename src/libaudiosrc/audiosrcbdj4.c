@@ -12,6 +12,11 @@
 #include <inttypes.h>
 #include <errno.h>
 
+#if __has_include (<pthread.h>)
+# include <pthread.h>
+#endif
+
+#include "ascache.h"
 #include "asconf.h"
 #include "audiosrc.h"
 #include "bdj4.h"
@@ -38,11 +43,21 @@ enum {
   ASBDJ4_ACT_GET_SONG,
   ASBDJ4_ACT_SONG_EXISTS,
   ASBDJ4_ACT_SONG_TAGS,
+  ASBDJ4_ACT_SONG_TAGS_BATCH,
   ASBDJ4_ACT_MAX,
 };
 
 enum {
   ASBDJ4_WAIT_MAX = 200,
+  /* the number of songs sent in each batch request */
+  ASBDJ4_BATCH_MAX = 100,
+  /* how long the batch results are used */
+  ASBDJ4_CACHE_TIME = 60000,
+  /* audio files are fetched in pieces of this size */
+  ASBDJ4_CHUNK_SZ = 1024 * 1024,
+  ASBDJ4_FETCH_THREADS = 3,
+  ASBDJ4_FETCH_RETRY = 3,
+  ASBDJ4_FETCH_TIMEOUT = 30000,
 };
 
 const char *action_str [ASBDJ4_ACT_MAX] = {
@@ -53,6 +68,7 @@ const char *action_str [ASBDJ4_ACT_MAX] = {
   [ASBDJ4_ACT_GET_SONG] = "songget",
   [ASBDJ4_ACT_SONG_EXISTS] = "songexists",
   [ASBDJ4_ACT_SONG_TAGS] = "songtags",
+  [ASBDJ4_ACT_SONG_TAGS_BATCH] = "songtagsbatch",
 };
 
 enum {
@@ -90,10 +106,38 @@ typedef struct asdata {
   asconf_t        *asconf;
   asclientdata_t  **clientdata;
   ilist_t         *urilist;
+  slist_t         *songcache;
+  slist_t         *fetching;
+  ascache_t       *ascache;
+  mstime_t        cachetm;
   int             clientcount;
   volatile atomic_flag locked;
 } asdata_t;
 
+/* a remote audio file is fetched into a partial file using range */
+/* requests.  the chunk map records the pieces that have been */
+/* received, so that a failed fetch can be resumed. */
+typedef struct {
+  const char        *uri;
+  const char        *query;
+  char              *chunkmap;
+  int64_t           total;
+  int32_t           chunkcount;
+  _Atomic(int32_t)  nextchunk;
+  _Atomic(bool)     failed;
+  char              etag [80];
+  char              partnm [BDJ4_PATH_MAX];
+  char              mapnm [BDJ4_PATH_MAX];
+} asfetch_t;
+
+typedef struct {
+  asfetch_t       *fetch;
+  asclientdata_t  *clientdata;
+#if _lib_pthread_create
+  pthread_t       thread;
+#endif
+} asfetchworker_t;
+
 static void asbdj4WebResponseCallback (void *userdata, const char *respstr, size_t len, time_t tm);
 static bool asbdj4GetPlaylist (asdata_t *asdata, asiterdata_t *asidata, const char *nm, int askey);
 static bool asbdj4SongTags (asdata_t *asdata, asiterdata_t *asidata, const char *songuri);
@@ -104,6 +148,17 @@ static int asbdj4GetClientKey (asdata_t *asdata, int askey);
 static const char * asbdj4StripPrefix (asdata_t *asdata, const char *songuri, int clientidx);
 static void audiosrcClientFree (asdata_t *asdata);
 static int asbdj4ClientInit (asdata_t *asdata, int askey);
+static void asbdj4BatchSongTags (asdata_t *asdata, asclientdata_t *clientdata, slist_t *songlist);
+static bool asbdj4BatchSend (asdata_t *asdata, asclientdata_t *clientdata, const char *query);
+static char *asbdj4Encode (char *p, char *end, const char *str);
+static bool asbdj4CacheLookup (asdata_t *asdata, const char *songuri, slist_t **songtags);
+static void *asbdj4FetchWorker (void *arg);
+static bool asbdj4FetchChunk (asfetch_t *fetch, asclientdata_t *clientdata, int32_t chunk);
+static void asbdj4FetchLoadMap (asfetch_t *fetch);
+static void asbdj4FetchSaveMap (asfetch_t *fetch);
+static bool asbdj4FetchClaim (asdata_t *asdata, const char *partnm, bool claim);
+static void asbdj4Lock (asdata_t *asdata);
+static void asbdj4Unlock (asdata_t *asdata);
 
 void
 asiDesc (const char **ret, int max)
@@ -132,6 +187,10 @@ asiInit (const char *delpfx, const char *origext)
   asdata->asconf = asconfAlloc ();
   asdata->clientdata = NULL;
   asdata->urilist = NULL;
+  asdata->songcache = NULL;
+  asdata->fetching = slistAlloc ("asbdj4-fetching", LIST_ORDERED, NULL);
+  asdata->ascache = NULL;
+  mstimeset (&asdata->cachetm, 0);
   asdata->clientcount = 0;
   atomic_flag_clear (&asdata->locked);
 
@@ -199,6 +258,9 @@ asiFree (asdata_t *asdata)
 
   audiosrcClientFree (asdata);
   asconfFree (asdata->asconf);
+  slistFree (asdata->songcache);
+  slistFree (asdata->fetching);
+  ascacheFree (asdata->ascache);
   mdfree (asdata);
 }
 
@@ -264,6 +326,11 @@ asiExists (asdata_t *asdata, const char *nm)
   char            query [BDJ4_PATH_MAX];
   int             clientkey;
   asclientdata_t  *clientdata;
+  slist_t         *songtags;
+
+  if (asbdj4CacheLookup (asdata, nm, &songtags)) {
+    return songtags != NULL;
+  }
 
   clientkey = asbdj4GetClientKeyByURI (asdata, nm);
   if (clientkey < 0) {
@@ -313,6 +380,13 @@ asiPrep (asdata_t *asdata, const char *sfname, char *tempnm, size_t sz)
   }
 
   mstimestart (&mstm);
+  asbdj4Lock (asdata);
+  if (asdata->ascache == NULL) {
+    /* only a process that plays audio uses the cache */
+    asdata->ascache = audiosrcutilCacheAlloc ();
+  }
+  asbdj4Unlock (asdata);
+
   audiosrcutilMakeTempName (sfname, tempnm, sz);
   fileopDelete (tempnm);
 
@@ -543,12 +617,18 @@ asbdj4GetPlaylist (asdata_t *asdata, asiterdata_t *asidata, const char *nm, int
         slistSetNum (asidata->songlist, tbuff, 1);
         p = strtok_r (NULL, MSG_ARGS_RS_STR, &tokstr);
       }
+      mdfree (tdata);
 
       rc = true;
     }
     clientdata->state = BDJ4_STATE_OFF;
   }
 
+  if (rc) {
+    /* the song tags for the entire playlist will be needed */
+    asbdj4BatchSongTags (asdata, clientdata, asidata->songlist);
+  }
+
   clientdata->inuse = false;
   return rc;
 }
@@ -562,6 +642,25 @@ asbdj4SongTags (asdata_t *asdata, asiterdata_t *asidata, const char *songuri)
   char            query [BDJ4_PATH_MAX];
   int             clientkey;
   asclientdata_t  *clientdata;
+  slist_t         *songtags;
+
+  if (asbdj4CacheLookup (asdata, songuri, &songtags)) {
+    slistidx_t  iteridx;
+    const char  *tag;
+
+    if (songtags == NULL) {
+      return false;
+    }
+
+    slistFree (asidata->songtags);
+    asidata->songtags = slistAlloc ("asplsongs", LIST_UNORDERED, NULL);
+    slistStartIterator (songtags, &iteridx);
+    while ((tag = slistIterateKey (songtags, &iteridx)) != NULL) {
+      slistSetStr (asidata->songtags, tag, slistGetStr (songtags, tag));
+    }
+    slistSetStr (asidata->songtags, "SONGTYPE", "remote");
+    return true;
+  }
 
   clientkey = asbdj4GetClientKeyByURI (asdata, songuri);
   if (clientkey < 0) {
@@ -617,6 +716,7 @@ asbdj4SongTags (asdata_t *asdata, asiterdata_t *asidata, const char *songuri)
         }
         p = strtok_r (NULL, MSG_ARGS_RS_STR, &tokstr);
       }
+      mdfree (tdata);
 
       rc = true;
     }
@@ -695,15 +795,24 @@ asbdj4GetAudioFile (asdata_t *asdata, const char *nm, const char *tempnm)
   char              uri [1024];
   char              query [BDJ4_PATH_MAX];
   int               clientkey;
+  int               workercount;
   asclientdata_t    *clientdata;
+  asfetch_t         fetch;
+  asfetchworker_t   workers [ASBDJ4_FETCH_THREADS];
+  webrange_t        range;
+  ascacheinfo_t     cinfo;
+  uint64_t          hash;
+  bool              claimed;
+  bool              cached;
 
   clientkey = asbdj4GetClientKeyByURI (asdata, nm);
   if (clientkey < 0) {
     return false;
   }
   clientdata = asdata->clientdata [clientkey];
+  clientdata->inuse = true;
   clientdata->action = ASBDJ4_ACT_GET_SONG;
-  clientdata->state = BDJ4_STATE_WAIT;
+  clientdata->state = BDJ4_STATE_OFF;
 
   snprintf (uri, sizeof (uri),
       "%s%s",
@@ -712,28 +821,162 @@ asbdj4GetAudioFile (asdata_t *asdata, const char *nm, const char *tempnm)
       "uri=%s",
       asbdj4StripPrefix (asdata, nm, clientkey));
 
-  clientdata->inuse = true;
-  webclientSetTimeout (clientdata->webclient, 30000);
-  webrc = webclientPost (clientdata->webclient, uri, query);
-  if (webrc != WEB_OK) {
-    clientdata->inuse = false;
-    return rc;
+  /* the partial file name is the same for each attempt, */
+  /* so that the fetch can be resumed */
+  hash = stringHash64 (nm);
+  snprintf (fetch.partnm, sizeof (fetch.partnm),
+      "tmp/%02" PRId64 "-part-%016" PRIx64,
+      sysvarsGetNum (SVL_PROFILE_IDX), hash);
+  claimed = asbdj4FetchClaim (asdata, fetch.partnm, true);
+  if (! claimed) {
+    /* the same song is already being fetched */
+    snprintf (fetch.partnm, sizeof (fetch.partnm), "%s.part", tempnm);
+    fileopDelete (fetch.partnm);
+  }
+  snprintf (fetch.mapnm, sizeof (fetch.mapnm), "%s.map", fetch.partnm);
+
+  fetch.uri = uri;
+  fetch.query = query;
+  fetch.failed = false;
+  fetch.nextchunk = 1;
+  asbdj4FetchLoadMap (&fetch);
+
+  /* the first piece also returns the size and etag of the file */
+  /* if the file is in the cache, the first request is also used */
+  /* to check if the remote file has changed */
+  cached = ascacheGetInfo (asdata->ascache, nm, &cinfo);
+  range.offset = 0;
+  range.len = ASBDJ4_CHUNK_SZ;
+  range.validate = cached;
+  if (cached) {
+    stpecpy (range.etag, range.etag + sizeof (range.etag), cinfo.etag);
+    stpecpy (range.lastmod, range.lastmod + sizeof (range.lastmod),
+        cinfo.lastmod);
+  }
+  webclientSetTimeout (clientdata->webclient, ASBDJ4_FETCH_TIMEOUT);
+  webrc = webclientDownloadRange (clientdata->webclient, uri, query,
+      fetch.partnm, &range);
+  if (webrc == WEB_RANGE_NOT_SAT && range.total >= 0) {
+    /* the file is smaller than the requested range */
+    range.offset = 0;
+    range.len = 0;
+    range.validate = false;
+    webrc = webclientDownloadRange (clientdata->webclient, uri, query,
+        fetch.partnm, &range);
   }
 
-  if (clientdata->state == BDJ4_STATE_PROCESS) {
-    if (clientdata->webresplen > 0) {
-      FILE    *ofh;
+  if (webrc == WEB_NOT_MODIFIED && cached) {
+    rc = ascacheCopy (asdata->ascache, nm, tempnm);
+    if (fetch.chunkmap == NULL) {
+      fileopDelete (fetch.partnm);
+    }
+  } else if (webrc == WEB_OK) {
+    /* an older server that does not support ranges */
+    /* sends the entire file */
+    rc = range.total < 0 || range.received == range.total;
+  } else if (webrc == WEB_PARTIAL_CONTENT && range.total >= 0) {
+    bool    restart = false;
+
+    if (fetch.chunkmap == NULL ||
+        fetch.total != range.total ||
+        strcmp (fetch.etag, range.etag) != 0) {
+      if (fetch.chunkmap != NULL) {
+        /* the remote file has changed, the partial file is discarded */
+        fileopDelete (fetch.partnm);
+        restart = true;
+      }
+      dataFree (fetch.chunkmap);
+      fetch.total = range.total;
+      stpecpy (fetch.etag, fetch.etag + sizeof (fetch.etag), range.etag);
+      fetch.chunkcount = (fetch.total + ASBDJ4_CHUNK_SZ - 1) / ASBDJ4_CHUNK_SZ;
+      fetch.chunkmap = mdmalloc (fetch.chunkcount + 1);
+      memset (fetch.chunkmap, '0', fetch.chunkcount);
+      fetch.chunkmap [fetch.chunkcount] = '\0';
+    }
+    if (restart) {
+      fetch.nextchunk = 0;
+    } else if (fetch.chunkcount > 0) {
+      fetch.chunkmap [0] = '1';
+    }
 
-      ofh = fileopOpen (tempnm, "wb");
-      if (fwrite (clientdata->webresponse, clientdata->webresplen, 1, ofh) == 1) {
-        rc = true;
+    /* the partial file is created once, before the workers start, */
+    /* the workers only open it for update */
+    if (! fileopFileExists (fetch.partnm)) {
+      FILE    *fh;
+
+      fh = fileopOpen (fetch.partnm, "wb");
+      if (fh != NULL) {
+        mdextfclose (fh);
+        fclose (fh);
       }
-      mdextfclose (ofh);
-      fclose (ofh);
     }
-    clientdata->state = BDJ4_STATE_OFF;
+
+    workercount = 0;
+    for (int32_t i = 0; i < fetch.chunkcount; ++i) {
+      if (fetch.chunkmap [i] == '0') {
+        ++workercount;
+      }
+    }
+    if (workercount > ASBDJ4_FETCH_THREADS) {
+      workercount = ASBDJ4_FETCH_THREADS;
+    }
+
+    /* the first worker re-uses the connection that is already open */
+    for (int i = 0; i < workercount; ++i) {
+      workers [i].fetch = &fetch;
+      workers [i].clientdata = clientdata;
+      if (i > 0) {
+        int   tkey;
+
+        tkey = asbdj4GetClientKey (asdata, clientdata->askey);
+        workers [i].clientdata = asdata->clientdata [tkey];
+        workers [i].clientdata->inuse = true;
+      }
+#if _lib_pthread_create
+      pthread_create (&workers [i].thread, NULL, asbdj4FetchWorker, &workers [i]);
+#else
+      asbdj4FetchWorker (&workers [i]);
+#endif
+    }
+    for (int i = 0; i < workercount; ++i) {
+#if _lib_pthread_create
+      pthread_join (workers [i].thread, NULL);
+#endif
+      if (i > 0) {
+        workers [i].clientdata->inuse = false;
+      }
+    }
+
+    rc = strchr (fetch.chunkmap, '0') == NULL &&
+        fileopSize (fetch.partnm) == fetch.total;
+    if (! rc && claimed) {
+      asbdj4FetchSaveMap (&fetch);
+    }
   }
 
+  if (rc && webrc != WEB_NOT_MODIFIED) {
+    rc = filemanipMove (fetch.partnm, tempnm) == 0;
+    fileopDelete (fetch.mapnm);
+    if (rc) {
+      ascacheAdd (asdata->ascache, nm, tempnm, range.etag, range.lastmod);
+    }
+  }
+  if (! rc && cached && (webrc <= 0 || webrc >= WEB_SERVER_ERROR)) {
+    /* the server could not be reached, the cached file is used */
+    logMsg (LOG_DBG, LOG_IMPORTANT, "asbdj4: using cached file %s", nm);
+    rc = ascacheCopy (asdata->ascache, nm, tempnm);
+  }
+  if (! claimed) {
+    fileopDelete (fetch.partnm);
+  }
+
+  logMsg (LOG_DBG, LOG_BASIC, "asbdj4: fetch: rc:%d webrc:%d size:%" PRId64 " chunks:%" PRId32 " %s",
+      rc, webrc, fetch.total, fetch.chunkcount, nm);
+
+  if (claimed) {
+    asbdj4FetchClaim (asdata, fetch.partnm, false);
+  }
+  dataFree (fetch.chunkmap);
   clientdata->inuse = false;
   return rc;
 }
@@ -820,11 +1063,7 @@ asbdj4ClientInit (asdata_t *asdata, int askey)
   int             count;
   int             newclientcount;
 
-  count = 0;
-  while (atomic_flag_test_and_set (&asdata->locked)) {
-    mssleep (30);
-    ++count;
-  }
+  asbdj4Lock (asdata);
 
   idx = asdata->clientcount;
   newclientcount = asdata->clientcount + 1;
@@ -871,6 +1110,383 @@ asbdj4ClientInit (asdata_t *asdata, int askey)
 
   asdata->clientcount = newclientcount;
 
-  atomic_flag_clear (&asdata->locked);
+  asbdj4Unlock (asdata);
   return idx;
 }
+
+/* the song tags for the entire list of songs are fetched with as few */
+/* requests as possible, re-using the client's connection. */
+/* the results are used by asiExists() and the song-tags iterator. */
+/* the cache is only used by the process importing the playlist. */
+static void
+asbdj4BatchSongTags (asdata_t *asdata, asclientdata_t *clientdata,
+    slist_t *songlist)
+{
+  slistidx_t  iteridx;
+  const char  *songuri;
+  char        *query;
+  char        *qp;
+  char        *qend;
+  char        *qstart;
+  size_t      qsz;
+  int         count = 0;
+
+  slistFree (asdata->songcache);
+  asdata->songcache = slistAlloc ("asbdj4-cache", LIST_ORDERED, slistFree);
+  mstimeset (&asdata->cachetm, ASBDJ4_CACHE_TIME);
+
+  qsz = BDJ4_PATH_MAX;
+  query = mdmalloc (qsz);
+  qend = query + qsz;
+  qstart = stpecpy (query, qend, "uri=");
+  qp = qstart;
+
+  slistStartIterator (songlist, &iteridx);
+  while ((songuri = slistIterateKey (songlist, &iteridx)) != NULL) {
+    const char  *tstr;
+    size_t      tlen;
+
+    tstr = asbdj4StripPrefix (asdata, songuri, clientdata->clientkey);
+    /* each encoded character may use three bytes */
+    tlen = (strlen (tstr) + 1) * 3 + 1;
+    if (qp + tlen >= qend) {
+      size_t    offset;
+
+      offset = qp - query;
+      qsz += tlen + BDJ4_PATH_MAX;
+      query = mdrealloc (query, qsz);
+      qend = query + qsz;
+      qstart = query + strlen ("uri=");
+      qp = query + offset;
+    }
+
+    if (count > 0) {
+      qp = asbdj4Encode (qp, qend, MSG_ARGS_RS_STR);
+    }
+    qp = asbdj4Encode (qp, qend, tstr);
+    ++count;
+
+    if (count >= ASBDJ4_BATCH_MAX) {
+      if (! asbdj4BatchSend (asdata, clientdata, query)) {
+        /* an older server does not support the batch request */
+        count = 0;
+        break;
+      }
+      qp = qstart;
+      *qp = '\0';
+      count = 0;
+    }
+  }
+
+  if (count > 0) {
+    asbdj4BatchSend (asdata, clientdata, query);
+  }
+
+  logMsg (LOG_DBG, LOG_AUDIOSRC, "song-tags-batch: cached: %" PRId32,
+      slistGetCount (asdata->songcache));
+  mdfree (query);
+}
+
+static bool
+asbdj4BatchSend (asdata_t *asdata, asclientdata_t *clientdata,
+    const char *query)
+{
+  int     webrc;
+  char    uri [1024];
+  char    *tdata;
+  char    *p;
+  char    *tokstr;
+
+  clientdata->action = ASBDJ4_ACT_SONG_TAGS_BATCH;
+  clientdata->state = BDJ4_STATE_WAIT;
+
+  snprintf (uri, sizeof (uri),
+      "%s%s",
+      clientdata->remoteuri, action_str [clientdata->action]);
+
+  webclientSetTimeout (clientdata->webclient, 10000);
+  webrc = webclientPost (clientdata->webclient, uri, query);
+  if (webrc != WEB_OK) {
+    /* the songs not in the cache are fetched individually */
+    logMsg (LOG_DBG, LOG_AUDIOSRC, "song-tags-batch: webrc: %d", webrc);
+    clientdata->state = BDJ4_STATE_OFF;
+    return false;
+  }
+
+  if (clientdata->state != BDJ4_STATE_PROCESS) {
+    return false;
+  }
+  clientdata->state = BDJ4_STATE_OFF;
+
+  if (clientdata->webresplen == 0) {
+    return true;
+  }
+
+  tdata = mdmalloc (clientdata->webresplen + 1);
+  memcpy (tdata, clientdata->webresponse, clientdata->webresplen);
+  tdata [clientdata->webresplen] = '\0';
+
+  /* uri RS count RS count * (tag RS value RS) */
+  /* a count of -1 indicates the song does not exist */
+  p = strtok_r (tdata, MSG_ARGS_RS_STR, &tokstr);
+  while (p != NULL) {
+    const char  *tcount;
+    int         count;
+    slist_t     *songtags = NULL;
+    char        tbuff [BDJ4_PATH_MAX];
+
+    tcount = strtok_r (NULL, MSG_ARGS_RS_STR, &tokstr);
+    if (tcount == NULL) {
+      break;
+    }
+
+    count = atoi (tcount);
+    if (count >= 0) {
+      songtags = slistAlloc ("asbdj4-tags", LIST_UNORDERED, NULL);
+      for (int i = 0; i < count; ++i) {
+        const char  *tag;
+        const char  *tval;
+
+        tag = strtok_r (NULL, MSG_ARGS_RS_STR, &tokstr);
+        tval = strtok_r (NULL, MSG_ARGS_RS_STR, &tokstr);
+        if (tag == NULL || tval == NULL) {
+          break;
+        }
+        slistSetStr (songtags, tag, tval);
+      }
+    }
+
+    snprintf (tbuff, sizeof (tbuff), "%s%s", clientdata->uri, p);
+    slistSetData (asdata->songcache, tbuff, songtags);
+    p = strtok_r (NULL, MSG_ARGS_RS_STR, &tokstr);
+  }
+
+  mdfree (tdata);
+  return true;
+}
+
+/* the server url-decodes the request body */
+static char *
+asbdj4Encode (char *p, char *end, const char *str)
+{
+  const char          *hex = "0123456789ABCDEF";
+  const unsigned char *sp;
+
+  for (sp = (const unsigned char *) str; *sp && p + 3 < end; ++sp) {
+    if ((*sp >= 'a' && *sp <= 'z') ||
+        (*sp >= 'A' && *sp <= 'Z') ||
+        (*sp >= '0' && *sp <= '9') ||
+        strchr ("-._~/", *sp) != NULL) {
+      *p++ = *sp;
+    } else {
+      *p++ = '%';
+      *p++ = hex [*sp >> 4];
+      *p++ = hex [*sp & 0x0f];
+    }
+  }
+  *p = '\0';
+
+  return p;
+}
+
+/* returns true if the song is in the batch results. */
+/* songtags is set to null if the song does not exist. */
+static bool
+asbdj4CacheLookup (asdata_t *asdata, const char *songuri, slist_t **songtags)
+{
+  slistidx_t  idx;
+
+  *songtags = NULL;
+
+  if (asdata->songcache == NULL) {
+    return false;
+  }
+  if (mstimeCheck (&asdata->cachetm)) {
+    slistFree (asdata->songcache);
+    asdata->songcache = NULL;
+    return false;
+  }
+
+  idx = slistGetIdx (asdata->songcache, songuri);
+  if (idx < 0) {
+    return false;
+  }
+
+  *songtags = slistGetDataByIdx (asdata->songcache, idx);
+  return true;
+}
+
+static void *
+asbdj4FetchWorker (void *arg)
+{
+  asfetchworker_t *worker = arg;
+  asfetch_t       *fetch = worker->fetch;
+  int32_t         chunk;
+
+  while (! fetch->failed) {
+    chunk = atomic_fetch_add (&fetch->nextchunk, 1);
+    if (chunk >= fetch->chunkcount) {
+      break;
+    }
+    if (fetch->chunkmap [chunk] == '1') {
+      continue;
+    }
+    if (! asbdj4FetchChunk (fetch, worker->clientdata, chunk)) {
+      fetch->failed = true;
+      break;
+    }
+    /* each worker has its own chunks, no lock is needed */
+    fetch->chunkmap [chunk] = '1';
+  }
+
+#if _lib_pthread_create
+  pthread_exit (NULL);
+#endif
+  return NULL;
+}
+
+/* a piece that is only partially received is continued from */
+/* where it stopped */
+static bool
+asbdj4FetchChunk (asfetch_t *fetch, asclientdata_t *clientdata, int32_t chunk)
+{
+  webrange_t    range;
+  int64_t       offset;
+  int64_t       len;
+  int           webrc;
+
+  offset = (int64_t) chunk * ASBDJ4_CHUNK_SZ;
+  len = fetch->total - offset;
+  if (len > ASBDJ4_CHUNK_SZ) {
+    len = ASBDJ4_CHUNK_SZ;
+  }
+
+  webclientSetTimeout (clientdata->webclient, ASBDJ4_FETCH_TIMEOUT);
+  for (int retry = 0; retry < ASBDJ4_FETCH_RETRY && len > 0; ++retry) {
+    range.offset = offset;
+    range.len = len;
+    range.validate = false;
+    webrc = webclientDownloadRange (clientdata->webclient, fetch->uri,
+        fetch->query, fetch->partnm, &range);
+    if (range.offset != offset) {
+      /* the server did not honor the range */
+      return false;
+    }
+    if (webrc != WEB_PARTIAL_CONTENT) {
+      logMsg (LOG_DBG, LOG_IMPORTANT, "asbdj4: fetch: chunk %" PRId32 " webrc:%d received:%" PRId64,
+          chunk, webrc, range.received);
+    }
+    offset += range.received;
+    len -= range.received;
+  }
+
+  return len <= 0;
+}
+
+/* the map file has the size, the etag and the chunk map */
+static void
+asbdj4FetchLoadMap (asfetch_t *fetch)
+{
+  FILE    *fh;
+  char    tbuff [200];
+  char    *chunkmap;
+
+  fetch->chunkmap = NULL;
+  fetch->total = -1;
+  fetch->chunkcount = 0;
+  fetch->etag [0] = '\0';
+
+  if (! fileopFileExists (fetch->partnm) ||
+      ! fileopFileExists (fetch->mapnm)) {
+    fileopDelete (fetch->partnm);
+    fileopDelete (fetch->mapnm);
+    return;
+  }
+
+  fh = fileopOpen (fetch->mapnm, "r");
+  if (fh == NULL) {
+    return;
+  }
+
+  if (fgets (tbuff, sizeof (tbuff), fh) != NULL) {
+    stringTrim (tbuff);
+    fetch->total = atoll (tbuff);
+  }
+  if (fgets (tbuff, sizeof (tbuff), fh) != NULL) {
+    stringTrim (tbuff);
+    stpecpy (fetch->etag, fetch->etag + sizeof (fetch->etag), tbuff);
+  }
+  fetch->chunkcount = (fetch->total + ASBDJ4_CHUNK_SZ - 1) / ASBDJ4_CHUNK_SZ;
+  if (fetch->total > 0) {
+    chunkmap = mdmalloc (fetch->chunkcount + 2);
+    if (fgets (chunkmap, fetch->chunkcount + 2, fh) != NULL) {
+      stringTrim (chunkmap);
+    }
+    if ((int32_t) strlen (chunkmap) == fetch->chunkcount) {
+      fetch->chunkmap = chunkmap;
+    } else {
+      mdfree (chunkmap);
+    }
+  }
+  mdextfclose (fh);
+  fclose (fh);
+
+  if (fetch->chunkmap == NULL) {
+    fileopDelete (fetch->partnm);
+    fileopDelete (fetch->mapnm);
+    return;
+  }
+
+  logMsg (LOG_DBG, LOG_BASIC, "asbdj4: fetch: resume %s %s",
+      fetch->partnm, fetch->chunkmap);
+}
+
+static void
+asbdj4FetchSaveMap (asfetch_t *fetch)
+{
+  FILE    *fh;
+
+  fh = fileopOpen (fetch->mapnm, "w");
+  if (fh == NULL) {
+    return;
+  }
+  fprintf (fh, "%" PRId64 "\n%s\n%s\n",
+      fetch->total, fetch->etag, fetch->chunkmap);
+  mdextfclose (fh);
+  fclose (fh);
+}
+
+/* two prep threads may be fetching the same song */
+static bool
+asbdj4FetchClaim (asdata_t *asdata, const char *partnm, bool claim)
+{
+  bool    rc = true;
+
+  asbdj4Lock (asdata);
+  if (claim) {
+    if (slistGetIdx (asdata->fetching, partnm) >= 0) {
+      rc = false;
+    } else {
+      slistSetNum (asdata->fetching, partnm, 1);
+    }
+  } else {
+    slistDelete (asdata->fetching, partnm);
+  }
+  asbdj4Unlock (asdata);
+
+  return rc;
+}
+
+static void
+asbdj4Lock (asdata_t *asdata)
+{
+  while (atomic_flag_test_and_set (&asdata->locked)) {
+    mssleep (30);
+  }
+}
+
+static void
+asbdj4Unlock (asdata_t *asdata)
+{
+  atomic_flag_clear (&asdata->locked);
+}
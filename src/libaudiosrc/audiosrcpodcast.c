@@ -7,10 +7,12 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <inttypes.h>
 #include <errno.h>
 
+#include "ascache.h"
 #include "audiosrc.h"
 #include "bdj4.h"
 #include "bdj4intl.h"
@@ -26,7 +28,9 @@
 #include "nlist.h"
 #include "pathinfo.h"
 #include "playlist.h"
+#include "podcast.h"
 #include "slist.h"
+#include "songlist.h"
 #include "sysvars.h"
 #include "tagdef.h"
 #include "tmutil.h"
@@ -36,6 +40,8 @@ enum {
   ASPODCAST_WAIT_MAX = 200,
   ASPODCAST_CLIENT_MAX = 5,
   ASPODCAST_RECHK_TM = 120,
+  /* the entire episode is fetched with one request */
+  ASPODCAST_PREP_TIMEOUT = 300000,
 };
 
 enum {
@@ -55,27 +61,42 @@ typedef struct asiterdata {
 
 typedef struct {
   webclient_t   *webclient;
-  nlist_t       *rssdata;
-  time_t        rsslastbldtm;
-  time_t        rsslastchktm;
 } asclientdata_t;
 
+/* the feeds are kept by the uri of the feed, as more than one */
+/* feed may be on the same host */
+/* a partial feed only has the items newer than the last update */
+typedef struct {
+  nlist_t       *rssdata;
+  rssvalid_t    valid;
+  time_t        lastchk;
+  bool          partial;
+} asfeed_t;
+
 typedef struct asdata {
   asclientdata_t  *clientdata;
   ilist_t         *client;
+  slist_t         *feeds;
+  ascache_t       *ascache;
   const char      *webresponse;
   size_t          webresplen;
   int             clientcount;
   int             state;
+  volatile atomic_flag locked;
 } asdata_t;
 
 static void aspodcastWebResponseCallback (void *userdata, const char *respstr, size_t len, time_t tm);
 static bool aspodcastGetPlaylistNames (asdata_t *asdata, asiterdata_t *asidata, const char *uri);
-static bool aspodcastGetPlaylist (asdata_t *asdata, asiterdata_t *asidata, const char *uri);
+static bool aspodcastGetPlaylist (asdata_t *asdata, asiterdata_t *asidata, const char *uri, const char *nm);
 static bool aspodcastSongTags (asdata_t *asdata, asiterdata_t *asidata, const char *uri, const char *nm);
-static void aspodcastRSS (asdata_t *asdata, asiterdata_t *asidata, const char *uri);
+static asfeed_t *aspodcastRSS (asdata_t *asdata, const char *uri, const char *nm, bool incremental);
+static void aspodcastLoadValid (const char *nm, rssvalid_t *valid);
+static nlist_t *aspodcastEmptyRSS (void);
+static void aspodcastFeedFree (void *data);
 static int aspodcastGetClientKeyByURI (asdata_t *asdata, const char *uri);
 static void audiosrcClientFree (asdata_t *asdata);
+static void aspodcastLock (asdata_t *asdata);
+static void aspodcastUnlock (asdata_t *asdata);
 
 void
 asiDesc (const char **ret, int max)
@@ -100,10 +121,14 @@ asiInit (const char *delpfx, const char *origext)
 
   asdata->clientdata = NULL;
   asdata->client = ilistAlloc ("client", LIST_ORDERED);
+  asdata->feeds = slistAlloc ("aspodcast-feeds", LIST_ORDERED,
+      aspodcastFeedFree);
+  asdata->ascache = NULL;
   asdata->clientcount = 0;
   asdata->state = BDJ4_STATE_OFF;
   asdata->webresponse = NULL;
   asdata->webresplen = 0;
+  atomic_flag_clear (&asdata->locked);
   return asdata;
 }
 
@@ -115,6 +140,8 @@ asiFree (asdata_t *asdata)
   }
 
   audiosrcClientFree (asdata);
+  slistFree (asdata->feeds);
+  ascacheFree (asdata->ascache);
   mdfree (asdata);
 }
 
@@ -193,13 +220,87 @@ asiExists (asdata_t *asdata, const char *nm)
 }
 
 /* asiPrep is called in a multi-threaded context */
+/* the episode is fetched into the cache, if it cannot be fetched, */
+/* it is streamed */
 bool
 asiPrep (asdata_t *asdata, const char *sfname, char *tempnm, size_t sz)
 {
+  webclient_t   *webclient;
+  webrange_t    range;
+  ascacheinfo_t cinfo;
+  char          tfn [BDJ4_PATH_MAX];
+  bool          cached;
+  bool          rc = false;
+  int           webrc;
+
   stpecpy (tempnm, tempnm + sz, sfname);
+
+  aspodcastLock (asdata);
+  if (asdata->ascache == NULL) {
+    /* only a process that plays audio uses the cache */
+    asdata->ascache = audiosrcutilCacheAlloc ();
+  }
+  aspodcastUnlock (asdata);
+
+  audiosrcutilMakeTempName (sfname, tfn, sizeof (tfn));
+  fileopDelete (tfn);
+
+  cached = ascacheGetInfo (asdata->ascache, sfname, &cinfo);
+  range.offset = 0;
+  range.len = 0;
+  range.validate = cached;
+  if (cached) {
+    stpecpy (range.etag, range.etag + sizeof (range.etag), cinfo.etag);
+    stpecpy (range.lastmod, range.lastmod + sizeof (range.lastmod),
+        cinfo.lastmod);
+  }
+
+  /* the client connections are not used, as they may be in use */
+  /* by another thread */
+  webclient = webclientAlloc (NULL, NULL);
+  webclientSetTimeout (webclient, ASPODCAST_PREP_TIMEOUT);
+  webrc = webclientDownloadRange (webclient, sfname, NULL, tfn, &range);
+  webclientClose (webclient);
+
+  if (webrc == WEB_NOT_MODIFIED && cached) {
+    rc = ascacheCopy (asdata->ascache, sfname, tfn);
+  } else if ((webrc == WEB_OK || webrc == WEB_PARTIAL_CONTENT) &&
+      (range.total < 0 || range.received == range.total)) {
+    rc = true;
+    ascacheAdd (asdata->ascache, sfname, tfn, range.etag, range.lastmod);
+  } else if (cached && (webrc <= 0 || webrc >= WEB_SERVER_ERROR)) {
+    logMsg (LOG_DBG, LOG_IMPORTANT, "aspodcast: using cached file %s", sfname);
+    rc = ascacheCopy (asdata->ascache, sfname, tfn);
+  }
+
+  logMsg (LOG_DBG, LOG_BASIC, "aspodcast: prep: rc:%d webrc:%d %s",
+      rc, webrc, sfname);
+  if (rc) {
+    stpecpy (tempnm, tempnm + sz, tfn);
+  } else {
+    fileopDelete (tfn);
+  }
+
   return true;
 }
 
+void
+asiPrepClean (asdata_t *asdata, const char *tempnm)
+{
+  if (tempnm == NULL) {
+    return;
+  }
+
+  /* a streamed episode has no local file */
+  if (strncmp (tempnm, AS_HTTPS_PFX, AS_HTTPS_PFX_LEN) == 0) {
+    return;
+  }
+
+  if (fileopFileExists (tempnm)) {
+    fileopDelete (tempnm);
+  }
+}
+
 const char *
 asiPrefix (asdata_t *asdata)
 {
@@ -252,11 +353,11 @@ asiStartIterator (asdata_t *asdata, asitertype_t asitertype,
     asidata->iterlist = asidata->plNames;
     slistStartIterator (asidata->iterlist, &asidata->iteridx);
   } else if (asitertype == AS_ITER_PL_DATA) {
-    aspodcastGetPlaylist (asdata, asidata, uri);
+    aspodcastGetPlaylist (asdata, asidata, uri, nm);
     asidata->iterlist = asidata->plData;
     slistStartIterator (asidata->iterlist, &asidata->iteridx);
   } else if (asitertype == AS_ITER_PL) {
-    aspodcastGetPlaylist (asdata, asidata, uri);
+    aspodcastGetPlaylist (asdata, asidata, uri, nm);
     asidata->iterlist = asidata->songlist;
     slistStartIterator (asidata->iterlist, &asidata->iteridx);
   } else if (asitertype == AS_ITER_TAGS) {
@@ -349,16 +450,10 @@ static bool
 aspodcastGetPlaylistNames (asdata_t *asdata, asiterdata_t *asidata,
     const char *uri)
 {
-  int     clientkey;
+  asfeed_t    *feed;
 
-  clientkey = aspodcastGetClientKeyByURI (asdata, uri);
-  if (clientkey < 0) {
-    return false;
-  }
-
-  aspodcastRSS (asdata, asidata, uri);
-
-  if (asdata->clientdata [clientkey].rssdata == NULL) {
+  feed = aspodcastRSS (asdata, uri, NULL, false);
+  if (feed == NULL) {
     return false;
   }
 
@@ -366,47 +461,47 @@ aspodcastGetPlaylistNames (asdata_t *asdata, asiterdata_t *asidata,
   asidata->plNames = slistAlloc ("asplnames", LIST_ORDERED, NULL);
   slistSetSize (asidata->plNames, 1);
   slistSetNum (asidata->plNames,
-      nlistGetStr (asdata->clientdata [clientkey].rssdata, RSS_TITLE), 1);
+      nlistGetStr (feed->rssdata, RSS_TITLE), 1);
 
   return true;
 }
 
+/* the playlist is only used when importing or updating the podcast, */
+/* and only the items newer than the last update are returned. */
+/* the podcast import processes the existing songs */
 static bool
-aspodcastGetPlaylist (asdata_t *asdata, asiterdata_t *asidata, const char *uri)
+aspodcastGetPlaylist (asdata_t *asdata, asiterdata_t *asidata,
+    const char *uri, const char *nm)
 {
+  asfeed_t        *feed;
   ilist_t         *rssitems;
   ilistidx_t      iteridx;
   ilistidx_t      key;
-  int             clientkey;
   nlist_t         *tlist;
   nlistidx_t      titeridx;
   const char      *tstr;
 
-  clientkey = aspodcastGetClientKeyByURI (asdata, uri);
-  if (clientkey < 0) {
-    return false;
-  }
-
-  aspodcastRSS (asdata, asidata, uri);
-  if (asdata->clientdata [clientkey].rssdata == NULL) {
+  feed = aspodcastRSS (asdata, uri, nm, true);
+  if (feed == NULL) {
     return false;
   }
 
   slistFree (asidata->plData);
   asidata->plData = slistAlloc ("aspldata", LIST_UNORDERED, NULL);
   slistSetStr (asidata->plData, "IMAGE_URI",
-      nlistGetStr (asdata->clientdata [clientkey].rssdata, RSS_IMAGE_URI));
+      nlistGetStr (feed->rssdata, RSS_IMAGE_URI));
+  slistSetStr (asidata->plData, "ETAG", feed->valid.etag);
+  slistSetStr (asidata->plData, "LASTMODIFIED", feed->valid.lastmod);
+  slistSetStr (asidata->plData, "LASTGUID", feed->valid.guid);
   slistSort (asidata->plData);
 
   slistFree (asidata->songlist);
   asidata->songlist = slistAlloc ("asplsongs", LIST_UNORDERED, NULL);
-  slistSetSize (asidata->songlist,
-      nlistGetNum (asdata->clientdata [clientkey].rssdata, RSS_COUNT));
+  slistSetSize (asidata->songlist, nlistGetNum (feed->rssdata, RSS_COUNT));
   tlist = nlistAlloc ("tmp-asplsongs", LIST_UNORDERED, NULL);
-  nlistSetSize (tlist,
-      nlistGetNum (asdata->clientdata [clientkey].rssdata, RSS_COUNT));
+  nlistSetSize (tlist, nlistGetNum (feed->rssdata, RSS_COUNT));
 
-  rssitems = nlistGetList (asdata->clientdata [clientkey].rssdata, RSS_ITEMS);
+  rssitems = nlistGetList (feed->rssdata, RSS_ITEMS);
   ilistStartIterator (rssitems, &iteridx);
   while ((key = ilistIterateKey (rssitems, &iteridx)) >= 0) {
     int64_t   val;
@@ -431,31 +526,37 @@ static bool
 aspodcastSongTags (asdata_t *asdata, asiterdata_t *asidata,
     const char *uri, const char *nm)
 {
+  asfeed_t    *feed;
   ilist_t     *rssitems;
   slist_t     *itemidx;
   ilistidx_t  idx = -1;
   const char  *val;
   char        tbuff [40];
-  int         clientkey;
-
-  clientkey = aspodcastGetClientKeyByURI (asdata, uri);
-  if (clientkey < 0) {
-    return false;
-  }
 
-  aspodcastRSS (asdata, asidata, uri);
-  if (asdata->clientdata [clientkey].rssdata == NULL) {
+  /* the tags are usually wanted for the items just returned */
+  /* by the playlist iterator, and a partial feed may be used */
+  feed = aspodcastRSS (asdata, uri, NULL, true);
+  if (feed == NULL) {
     return false;
   }
 
-  rssitems = nlistGetList (asdata->clientdata [clientkey].rssdata, RSS_ITEMS);
-  itemidx = nlistGetList (asdata->clientdata [clientkey].rssdata, RSS_IDX);
+  itemidx = nlistGetList (feed->rssdata, RSS_IDX);
   idx = slistGetNum (itemidx, nm);
+  if (idx < 0 && feed->partial) {
+    feed = aspodcastRSS (asdata, uri, NULL, false);
+    if (feed == NULL) {
+      return false;
+    }
+    itemidx = nlistGetList (feed->rssdata, RSS_IDX);
+    idx = slistGetNum (itemidx, nm);
+  }
 
   if (idx < 0) {
     return false;
   }
 
+  rssitems = nlistGetList (feed->rssdata, RSS_ITEMS);
+
   slistFree (asidata->songtags);
   asidata->songtags = slistAlloc ("assongtags", LIST_UNORDERED, NULL);
   slistSetSize (asidata->songtags, 5);
@@ -494,39 +595,165 @@ aspodcastSongTags (asdata_t *asdata, asiterdata_t *asidata,
   return true;
 }
 
+/* asiStartIterator may be called by more than one thread. */
+/* each feed is only processed by one thread at a time. */
+/* an incremental update returns the items newer than the last update */
+static asfeed_t *
+aspodcastRSS (asdata_t *asdata, const char *uri, const char *nm,
+    bool incremental)
+{
+  asfeed_t    *feed;
+  rssvalid_t  valid;
+  nlist_t     *rssdata;
+  time_t      currtm;
+  bool        stopguid;
+
+  if (uri == NULL || ! *uri) {
+    return NULL;
+  }
+
+  currtm = time (NULL);
+  *valid.etag = '\0';
+  *valid.lastmod = '\0';
+  *valid.guid = '\0';
+  valid.webrc = 0;
+
+  aspodcastLock (asdata);
+  feed = slistGetData (asdata->feeds, uri);
+  if (feed == NULL) {
+    asfeed_t    *tfeed;
+
+    aspodcastUnlock (asdata);
+    if (incremental) {
+      aspodcastLoadValid (nm, &valid);
+    }
+
+    tfeed = mdmalloc (sizeof (asfeed_t));
+    tfeed->rssdata = NULL;
+    tfeed->valid = valid;
+    tfeed->lastchk = 0;
+    tfeed->partial = false;
+
+    aspodcastLock (asdata);
+    /* another thread may have added the feed */
+    feed = slistGetData (asdata->feeds, uri);
+    if (feed == NULL) {
+      feed = tfeed;
+      slistSetData (asdata->feeds, uri, feed);
+    } else {
+      mdfree (tfeed);
+    }
+  }
+
+  if (feed->rssdata != NULL &&
+      (incremental || ! feed->partial) &&
+      currtm < feed->lastchk + ASPODCAST_RECHK_TM) {
+    aspodcastUnlock (asdata);
+    return feed;
+  }
+
+  valid = feed->valid;
+  if (! incremental) {
+    /* the entire feed is wanted */
+    *valid.guid = '\0';
+    if (feed->partial) {
+      *valid.etag = '\0';
+      *valid.lastmod = '\0';
+    }
+  }
+  aspodcastUnlock (asdata);
+
+  stopguid = *valid.guid != '\0';
+  rssdata = rssImportUpdate (uri, &valid);
+  logMsg (LOG_DBG, LOG_IMPORTANT,
+      "aspodcast: rss: webrc:%d incremental:%d count:%" PRId64 " %s",
+      valid.webrc, incremental, (int64_t) nlistGetNum (rssdata, RSS_COUNT), uri);
+
+  aspodcastLock (asdata);
+  if (rssdata != NULL) {
+    nlistFree (feed->rssdata);
+    feed->rssdata = rssdata;
+    feed->partial = stopguid;
+  } else if (valid.webrc == WEB_NOT_MODIFIED && feed->rssdata == NULL) {
+    /* there are no new items, and nothing else is known */
+    feed->rssdata = aspodcastEmptyRSS ();
+    feed->partial = true;
+  }
+  if (rssdata != NULL || valid.webrc == WEB_NOT_MODIFIED) {
+    feed->valid = valid;
+    feed->lastchk = currtm;
+  }
+  if (feed->rssdata == NULL) {
+    feed = NULL;
+  }
+  aspodcastUnlock (asdata);
+
+  return feed;
+}
+
+/* the validators are saved in the podcast file by the import */
 static void
-aspodcastRSS (asdata_t *asdata, asiterdata_t *asidata, const char *uri)
+aspodcastLoadValid (const char *nm, rssvalid_t *valid)
 {
-  time_t    tm = 0;
-  int       clientkey;
+  podcast_t   *podcast;
+  const char  *tstr;
 
-  clientkey = aspodcastGetClientKeyByURI (asdata, uri);
-  if (clientkey < 0) {
+  if (nm == NULL || ! podcastExists (nm)) {
+    return;
+  }
+  /* if the song list is gone, the entire feed must be processed */
+  if (! songlistExists (nm)) {
     return;
   }
 
-  if (asdata->clientdata [clientkey].rssdata != NULL) {
-    time_t    currtm;
-    time_t    lastchk;
+  podcast = podcastLoad (nm);
+  if (podcast == NULL) {
+    return;
+  }
 
-    currtm = time (NULL);
-    lastchk = asdata->clientdata [clientkey].rsslastchktm;
-    tm = asdata->clientdata [clientkey].rsslastbldtm;
-    if (currtm > lastchk + ASPODCAST_RECHK_TM) {
-      tm = rssGetUpdateTime (uri);
-    }
+  tstr = podcastGetStr (podcast, PODCAST_ETAG);
+  if (tstr != NULL) {
+    stpecpy (valid->etag, valid->etag + sizeof (valid->etag), tstr);
   }
-  if (asdata->clientdata [clientkey].rssdata == NULL ||
-      tm > asdata->clientdata [clientkey].rsslastbldtm) {
-    logMsg (LOG_ERR, LOG_IMPORTANT,
-        "do import: rss data null(%d) or time %" PRId64 " > %" PRId64,
-        asdata->clientdata [clientkey].rssdata == NULL,
-        (int64_t) tm, (int64_t) asdata->clientdata [clientkey].rsslastbldtm);
-    asdata->clientdata [clientkey].rssdata = rssImport (uri);
-    asdata->clientdata [clientkey].rsslastbldtm =
-        nlistGetNum (asdata->clientdata [clientkey].rssdata, RSS_BUILD_DATE);
-    asdata->clientdata [clientkey].rsslastchktm = time (NULL);
+  tstr = podcastGetStr (podcast, PODCAST_LAST_MODIFIED);
+  if (tstr != NULL) {
+    stpecpy (valid->lastmod, valid->lastmod + sizeof (valid->lastmod), tstr);
+  }
+  tstr = podcastGetStr (podcast, PODCAST_LAST_GUID);
+  if (tstr != NULL) {
+    stpecpy (valid->guid, valid->guid + sizeof (valid->guid), tstr);
+  }
+  podcastFree (podcast);
+}
+
+static nlist_t *
+aspodcastEmptyRSS (void)
+{
+  nlist_t   *rssdata;
+
+  rssdata = nlistAlloc ("rssimport", LIST_ORDERED, NULL);
+  nlistSetStr (rssdata, RSS_TITLE, "");
+  nlistSetStr (rssdata, RSS_URI, "");
+  nlistSetStr (rssdata, RSS_IMAGE_URI, "");
+  nlistSetNum (rssdata, RSS_BUILD_DATE, 0);
+  nlistSetNum (rssdata, RSS_COUNT, 0);
+  nlistSetList (rssdata, RSS_ITEMS, ilistAlloc ("rssitems", LIST_ORDERED));
+  nlistSetList (rssdata, RSS_IDX,
+      slistAlloc ("rssitemidx", LIST_ORDERED, NULL));
+  return rssdata;
+}
+
+static void
+aspodcastFeedFree (void *data)
+{
+  asfeed_t    *feed = data;
+
+  if (feed == NULL) {
+    return;
   }
+
+  nlistFree (feed->rssdata);
+  mdfree (feed);
 }
 
 static int
@@ -561,8 +788,6 @@ aspodcastGetClientKeyByURI (asdata_t *asdata, const char *uri)
         sizeof (asclientdata_t) * asdata->clientcount);
     asdata->clientdata [clientkey].webclient =
         webclientAlloc (asdata, aspodcastWebResponseCallback);
-    asdata->clientdata [clientkey].rssdata = NULL;
-    asdata->clientdata [clientkey].rsslastbldtm = 0;
     stpecpy (temp, temp + sizeof (temp), uri);
     p = temp;
     p += AS_HTTPS_PFX_LEN;
@@ -586,7 +811,6 @@ audiosrcClientFree (asdata_t *asdata)
   if (asdata->clientdata != NULL) {
     for (int i = 0; i < asdata->clientcount; ++i) {
       webclientClose (asdata->clientdata [i].webclient);
-      nlistFree (asdata->clientdata [i].rssdata);
     }
     mdfree (asdata->clientdata);
   }
@@ -595,3 +819,17 @@ audiosrcClientFree (asdata_t *asdata)
   asdata->client = NULL;
   asdata->clientcount = 0;
 }
+
+static void
+aspodcastLock (asdata_t *asdata)
+{
+  while (atomic_flag_test_and_set (&asdata->locked)) {
+    mssleep (30);
+  }
+}
+
+static void
+aspodcastUnlock (asdata_t *asdata)
+{
+  atomic_flag_clear (&asdata->locked);
+}
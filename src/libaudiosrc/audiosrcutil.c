@@ -12,12 +12,14 @@
 #include <errno.h>
 #include <ctype.h>
 
+#include "ascache.h"
 #include "audiosrc.h"
 #include "bdj4.h"
 #include "fileop.h"
 #include "filemanip.h"
 #include "log.h"
 #include "mdebug.h"
+#include "pathbld.h"
 #include "pathinfo.h"
 #include "sysvars.h"
 
@@ -77,3 +79,14 @@ audiosrcutilPreCacheFile (const char *fn)
   }
   return true;
 }
+
+/* the audio sources that use the network share a single cache */
+ascache_t *
+audiosrcutilCacheAlloc (void)
+{
+  char    dir [BDJ4_PATH_MAX];
+
+  pathbldMakePath (dir, sizeof (dir), ASCACHE_DIR, "",
+      PATHBLD_MP_DREL_DATA | PATHBLD_MP_USEIDX);
+  return ascacheAlloc (dir, ASCACHE_MAX_SIZE);
+}
@@ -13,158 +13,412 @@
 #include <stdbool.h>
 #include <string.h>
 #include <inttypes.h>
+#include <ctype.h>
 
 #include "bdj4.h"
 #include "bdjstring.h"
-#include "fileop.h"
 #include "expimp.h"
-#include "filedata.h"
 #include "ilist.h"
+#include "log.h"
 #include "mdebug.h"
 #include "nlist.h"
-#include "pathdisp.h"
-#include "pathutil.h"
-#include "playlist.h"
 #include "slist.h"
-#include "tagdef.h"
 #include "tmutil.h"
 #include "webclient.h"
 #include "xmlparse.h"
 
-static const char *titlexpath =
-    "/rss/channel/title";
-static const char *linkxpath =
-    "/rss/channel/link";
-static const char *blddatexpath =
-    "/rss/channel/lastBuildDate";
-static const char *imageurixpath =
-    "/rss/channel/image/url";
-static const char *itemxpath =
-    "/rss/channel/item/title|"
-    "/rss/channel/item/pubDate|"
-    "/rss/channel/item/itunes:duration|"
-    "/rss/channel/item/enclosure";
-static const xmlparseattr_t itemattr [] = {
-    { "title", RSS_ITEM_TITLE, NULL },
-    { "pubDate", RSS_ITEM_DATE, NULL },
-    { "duration", RSS_ITEM_DURATION, NULL },
-    { "enclosure", RSS_ITEM_URI, "url" },
-    { "enclosure", RSS_ITEM_TYPE, "type" },
-    { NULL, -1, NULL },
+enum {
+  RSS_PARENT_CHANNEL,
+  RSS_PARENT_IMAGE,
+  RSS_PARENT_ITEM,
 };
 
-typedef struct
-{
-  const char    *webresponse;
-  size_t        webresplen;
-  time_t        webresptime;
-} rssdata_t;
+enum {
+  /* the guid is not stored in the item list */
+  RSS_ITEM_GUID = RSS_ITEM_MAX,
+  RSS_ITEM_VAL_MAX,
+};
 
-static void rssWebResponseCallback (void *userdata, const char *respstr, size_t len, time_t tm);
+typedef struct {
+  const char  *name;
+  int         parent;
+  int         idx;
+} rsselem_t;
 
+/* the text values that are saved */
+static const rsselem_t rsselem [] = {
+  { "title",            RSS_PARENT_CHANNEL, RSS_TITLE },
+  { "link",             RSS_PARENT_CHANNEL, RSS_URI },
+  { "lastBuildDate",    RSS_PARENT_CHANNEL, RSS_BUILD_DATE },
+  { "url",              RSS_PARENT_IMAGE,   RSS_IMAGE_URI },
+  { "title",            RSS_PARENT_ITEM,    RSS_ITEM_TITLE },
+  { "pubDate",          RSS_PARENT_ITEM,    RSS_ITEM_DATE },
+  { "itunes:duration",  RSS_PARENT_ITEM,    RSS_ITEM_DURATION },
+  { "guid",             RSS_PARENT_ITEM,    RSS_ITEM_GUID },
+  { NULL,               -1,                 -1 },
+};
 
-time_t
-rssGetUpdateTime (const char *uri)
-{
-  webclient_t   *webclient;
-  rssdata_t     rssdata;
-  int           webrc;
+typedef struct {
+  xmlparsesax_t *sax;
+  nlist_t       *implist;
+  ilist_t       *itemlist;
+  const char    *stopguid;
+  char          *itemval [RSS_ITEM_VAL_MAX];
+  int           depth;
+  int           channeldepth;
+  int           imagedepth;
+  int           itemdepth;
+  int           target;
+  int           targetparent;
+  ilistidx_t    itemcount;
+  time_t        prevtm;
+  time_t        newesttm;
+  bool          descending;
+  bool          found;
+  char          newestguid [RSS_GUID_SZ];
+  char          text [BDJ4_PATH_MAX];
+  size_t        textlen;
+} rssparse_t;
 
-  webclient = webclientAlloc (&rssdata, rssWebResponseCallback);
-  webclientSetTimeout (webclient, 1000);
-  webrc = webclientHead (webclient, uri);
-  if (webrc != WEB_OK) {
-    return 0;
-  }
-  webclientClose (webclient);
+static bool rssStreamCallback (void *userdata, const char *data, size_t len);
+static void rssStartElement (void *udata, const char *name, const char **attrs);
+static void rssEndElement (void *udata, const char *name);
+static void rssText (void *udata, const char *text, size_t len);
+static void rssEndItem (rssparse_t *rssparse);
+static void rssClearItem (rssparse_t *rssparse);
+static time_t rssParseDate (const char *str);
 
-  return rssdata.webresptime;
+BDJ_NODISCARD
+nlist_t *
+rssImport (const char *uri)
+{
+  return rssImportUpdate (uri, NULL);
 }
 
+/* the feed is parsed as it is received, no document tree is built. */
+/* if the guid of the newest known item is set, both the parse and */
+/* the transfer are stopped when that item is reached. */
+/* returns null if the feed has not changed (valid->webrc is 304) */
+/* or on an error. */
+BDJ_NODISCARD
 nlist_t *
-rssImport (const char *uri)
+rssImportUpdate (const char *uri, rssvalid_t *valid)
 {
-  xmlparse_t    *xmlparse;
-  ilist_t       *itemlist = NULL;
-  slist_t       *itemidx = NULL;
-  nlist_t       *implist;
   webclient_t   *webclient;
-  rssdata_t     rssdata;
+  webvalid_t    webvalid;
+  rssparse_t    rssparse;
+  slist_t       *itemidx;
   int           webrc;
-  char          tbuff [BDJ4_PATH_MAX];
   ilistidx_t    iteridx;
   ilistidx_t    key;
-  time_t        tmval;
+  bool          ok;
 
-  webclient = webclientAlloc (&rssdata, rssWebResponseCallback);
-  webrc = webclientGet (webclient, uri);
-  if (webrc != WEB_OK) {
-    return NULL;
+  rssparse.implist = nlistAlloc ("rssimport", LIST_ORDERED, NULL);
+  nlistSetSize (rssparse.implist, RSS_MAX);
+  nlistSetStr (rssparse.implist, RSS_TITLE, "");
+  nlistSetStr (rssparse.implist, RSS_URI, "");
+  nlistSetStr (rssparse.implist, RSS_IMAGE_URI, "");
+  nlistSetNum (rssparse.implist, RSS_BUILD_DATE, 0);
+  rssparse.itemlist = ilistAlloc ("rssitems", LIST_ORDERED);
+  rssparse.stopguid = NULL;
+  for (int i = 0; i < RSS_ITEM_VAL_MAX; ++i) {
+    rssparse.itemval [i] = NULL;
   }
+  rssparse.depth = 0;
+  rssparse.channeldepth = -1;
+  rssparse.imagedepth = -1;
+  rssparse.itemdepth = -1;
+  rssparse.target = -1;
+  rssparse.targetparent = -1;
+  rssparse.itemcount = 0;
+  rssparse.prevtm = 0;
+  rssparse.newesttm = 0;
+  rssparse.descending = true;
+  rssparse.found = false;
+  *rssparse.newestguid = '\0';
+  *rssparse.text = '\0';
+  rssparse.textlen = 0;
 
-  /* the RSS data has xmlns prefixes defined */
-  /* using the xmlns is required */
-  xmlparse = xmlParseInitData (rssdata.webresponse, rssdata.webresplen,
-      XMLPARSE_USENS);
-  if (xmlParseIsValid (xmlparse) == false) {
-    xmlParseFree (xmlparse);
-    webclientClose (webclient);
-    return NULL;
+  *webvalid.etag = '\0';
+  *webvalid.lastmod = '\0';
+  if (valid != NULL) {
+    stpecpy (webvalid.etag, webvalid.etag + sizeof (webvalid.etag),
+        valid->etag);
+    stpecpy (webvalid.lastmod, webvalid.lastmod + sizeof (webvalid.lastmod),
+        valid->lastmod);
+    if (*valid->guid) {
+      rssparse.stopguid = valid->guid;
+    }
   }
 
-  implist = nlistAlloc ("rssimport", LIST_ORDERED, NULL);
-  nlistSetSize (implist, RSS_MAX);
+  rssparse.sax = xmlParseSAXInit (&rssparse,
+      rssStartElement, rssEndElement, rssText);
 
-  xmlParseGetItem (xmlparse, titlexpath, tbuff, sizeof (tbuff));
-  nlistSetStr (implist, RSS_TITLE, tbuff);
-
-  xmlParseGetItem (xmlparse, linkxpath, tbuff, sizeof (tbuff));
-  nlistSetStr (implist, RSS_URI, tbuff);
+  webclient = webclientAlloc (NULL, NULL);
+  webrc = webclientGetStream (webclient, uri, &webvalid,
+      rssStreamCallback, &rssparse);
+  webclientClose (webclient);
 
-  xmlParseGetItem (xmlparse, imageurixpath, tbuff, sizeof (tbuff));
-  nlistSetStr (implist, RSS_IMAGE_URI, tbuff);
+  if (valid != NULL) {
+    valid->webrc = webrc;
+  }
 
-  xmlParseGetItem (xmlparse, blddatexpath, tbuff, sizeof (tbuff));
-  tmval = tmutilStringToUTC (tbuff, "%a, %d %h %Y %T %z");
-  nlistSetNum (implist, RSS_BUILD_DATE, tmval);
+  ok = false;
+  if (webrc == WEB_OK) {
+    ok = xmlParseSAXFinish (rssparse.sax);
+  }
+  xmlParseSAXFree (rssparse.sax);
+  rssClearItem (&rssparse);
 
-  itemlist = xmlParseGetList (xmlparse, itemxpath, itemattr);
-  nlistSetList (implist, RSS_ITEMS, itemlist);
-  nlistSetNum (implist, RSS_COUNT, ilistGetCount (itemlist));
+  if (! ok) {
+    if (webrc == WEB_OK) {
+      logMsg (LOG_DBG, LOG_IMPORTANT, "rss: unable to parse %s", uri);
+    }
+    ilistFree (rssparse.itemlist);
+    nlistFree (rssparse.implist);
+    return NULL;
+  }
 
-  xmlParseFree (xmlparse);
-  webclientClose (webclient);
+  logMsg (LOG_DBG, LOG_INFO, "rss: %s items: %" PRId32 " stopped: %d",
+      uri, ilistGetCount (rssparse.itemlist), rssparse.found);
 
-  itemidx = slistAlloc ("rssitemidx", LIST_UNORDERED, NULL);
-  slistSetSize (itemidx, ilistGetCount (itemlist));
+  if (valid != NULL) {
+    stpecpy (valid->etag, valid->etag + sizeof (valid->etag), webvalid.etag);
+    stpecpy (valid->lastmod, valid->lastmod + sizeof (valid->lastmod),
+        webvalid.lastmod);
+    if (*rssparse.newestguid) {
+      stpecpy (valid->guid, valid->guid + sizeof (valid->guid),
+          rssparse.newestguid);
+    }
+  }
 
-  ilistStartIterator (itemlist, &iteridx);
-  while ((key = ilistIterateKey (itemlist, &iteridx)) >= 0) {
-    const char  *val;
+  nlistSetList (rssparse.implist, RSS_ITEMS, rssparse.itemlist);
+  nlistSetNum (rssparse.implist, RSS_COUNT, ilistGetCount (rssparse.itemlist));
 
-    val = ilistGetStr (itemlist, key, RSS_ITEM_URI);
-    slistSetNum (itemidx, val, key);
-    val = ilistGetStr (itemlist, key, RSS_ITEM_DATE);
-    /* <pubDate>Wed, 23 Apr 2025 17:00:00 +0000</pubDate> */
-    tmval = tmutilStringToUTC (val, "%a, %d %h %Y %T %z");
-    snprintf (tbuff, sizeof (tbuff), "%zd", (size_t) tmval);
-    ilistSetStr (itemlist, key, RSS_ITEM_DATE, tbuff);
+  itemidx = slistAlloc ("rssitemidx", LIST_UNORDERED, NULL);
+  slistSetSize (itemidx, ilistGetCount (rssparse.itemlist));
+  ilistStartIterator (rssparse.itemlist, &iteridx);
+  while ((key = ilistIterateKey (rssparse.itemlist, &iteridx)) >= 0) {
+    slistSetNum (itemidx,
+        ilistGetStr (rssparse.itemlist, key, RSS_ITEM_URI), key);
   }
   slistSort (itemidx);
-  nlistSetList (implist, RSS_IDX, itemidx);
+  nlistSetList (rssparse.implist, RSS_IDX, itemidx);
 
-  return implist;
+  return rssparse.implist;
 }
 
 /* internal routines */
 
+static bool
+rssStreamCallback (void *userdata, const char *data, size_t len)
+{
+  rssparse_t    *rssparse = userdata;
+
+  /* stops the transfer when the parse is stopped or fails */
+  return xmlParseSAXPush (rssparse->sax, data, len);
+}
+
+static void
+rssStartElement (void *udata, const char *name, const char **attrs)
+{
+  rssparse_t    *rssparse = udata;
+  int           parent = -1;
+
+  rssparse->depth += 1;
+
+  if (rssparse->channeldepth < 0) {
+    if (strcmp (name, "channel") == 0) {
+      rssparse->channeldepth = rssparse->depth;
+    }
+    return;
+  }
+
+  if (rssparse->itemdepth < 0 && rssparse->imagedepth < 0 &&
+      rssparse->depth == rssparse->channeldepth + 1) {
+    if (strcmp (name, "item") == 0) {
+      rssparse->itemdepth = rssparse->depth;
+      rssClearItem (rssparse);
+      return;
+    }
+    if (strcmp (name, "image") == 0) {
+      rssparse->imagedepth = rssparse->depth;
+      return;
+    }
+    parent = RSS_PARENT_CHANNEL;
+  } else if (rssparse->imagedepth > 0 &&
+      rssparse->depth == rssparse->imagedepth + 1) {
+    parent = RSS_PARENT_IMAGE;
+  } else if (rssparse->itemdepth > 0 &&
+      rssparse->depth == rssparse->itemdepth + 1) {
+    parent = RSS_PARENT_ITEM;
+  }
+
+  if (parent < 0) {
+    return;
+  }
+
+  if (parent == RSS_PARENT_ITEM && strcmp (name, "enclosure") == 0) {
+    for (int i = 0; attrs != NULL && attrs [i] != NULL; i += 2) {
+      int   idx = -1;
+
+      if (strcmp (attrs [i], "url") == 0) {
+        idx = RSS_ITEM_URI;
+      }
+      if (strcmp (attrs [i], "type") == 0) {
+        idx = RSS_ITEM_TYPE;
+      }
+      if (idx >= 0 && attrs [i + 1] != NULL) {
+        dataFree (rssparse->itemval [idx]);
+        rssparse->itemval [idx] = mdstrdup (attrs [i + 1]);
+      }
+    }
+    return;
+  }
+
+  for (int i = 0; rsselem [i].name != NULL; ++i) {
+    if (rsselem [i].parent == parent &&
+        strcmp (rsselem [i].name, name) == 0) {
+      rssparse->target = rsselem [i].idx;
+      rssparse->targetparent = parent;
+      *rssparse->text = '\0';
+      rssparse->textlen = 0;
+      break;
+    }
+  }
+}
+
+static void
+rssEndElement (void *udata, const char *name)
+{
+  rssparse_t    *rssparse = udata;
+  char          *p;
+
+  if (rssparse->target >= 0) {
+    /* remove trailing white space */
+    while (rssparse->textlen > 0 &&
+        isspace ((unsigned char) rssparse->text [rssparse->textlen - 1])) {
+      rssparse->textlen -= 1;
+    }
+    rssparse->text [rssparse->textlen] = '\0';
+    p = rssparse->text;
+
+    if (rssparse->targetparent == RSS_PARENT_ITEM) {
+      dataFree (rssparse->itemval [rssparse->target]);
+      rssparse->itemval [rssparse->target] = mdstrdup (p);
+    } else if (rssparse->target == RSS_BUILD_DATE) {
+      nlistSetNum (rssparse->implist, RSS_BUILD_DATE, rssParseDate (p));
+    } else {
+      nlistSetStr (rssparse->implist, rssparse->target, p);
+    }
+    rssparse->target = -1;
+    rssparse->targetparent = -1;
+  }
+
+  if (rssparse->depth == rssparse->itemdepth) {
+    rssEndItem (rssparse);
+    rssparse->itemdepth = -1;
+  }
+  if (rssparse->depth == rssparse->imagedepth) {
+    rssparse->imagedepth = -1;
+  }
+  if (rssparse->depth == rssparse->channeldepth) {
+    rssparse->channeldepth = -1;
+  }
+
+  rssparse->depth -= 1;
+}
+
+static void
+rssText (void *udata, const char *text, size_t len)
+{
+  rssparse_t    *rssparse = udata;
+
+  if (rssparse->target < 0) {
+    return;
+  }
+
+  /* skip leading white space */
+  while (rssparse->textlen == 0 && len > 0 &&
+      isspace ((unsigned char) *text)) {
+    ++text;
+    --len;
+  }
+  if (rssparse->textlen + len >= sizeof (rssparse->text)) {
+    len = sizeof (rssparse->text) - rssparse->textlen - 1;
+  }
+  memcpy (rssparse->text + rssparse->textlen, text, len);
+  rssparse->textlen += len;
+  rssparse->text [rssparse->textlen] = '\0';
+}
+
 static void
-rssWebResponseCallback (void *userdata, const char *respstr, size_t len, time_t tm)
+rssEndItem (rssparse_t *rssparse)
 {
-  rssdata_t    *rssdata = (rssdata_t *) userdata;
+  const char    *guid;
+  ilistidx_t    key;
+  time_t        tmval;
+  char          tbuff [40];
+
+  if (rssparse->itemval [RSS_ITEM_URI] == NULL) {
+    /* not a podcast episode */
+    return;
+  }
+
+  guid = rssparse->itemval [RSS_ITEM_GUID];
+  if (guid == NULL || ! *guid) {
+    guid = rssparse->itemval [RSS_ITEM_URI];
+  }
+
+  /* <pubDate>Wed, 23 Apr 2025 17:00:00 +0000</pubDate> */
+  tmval = rssParseDate (rssparse->itemval [RSS_ITEM_DATE]);
+  if (rssparse->itemcount > 0 && tmval > rssparse->prevtm) {
+    rssparse->descending = false;
+  }
+  rssparse->prevtm = tmval;
+  rssparse->itemcount += 1;
+
+  /* the feeds are normally ordered with the newest item first. */
+  /* if the items are not in descending order, there may be newer */
+  /* items after the known item, and the entire feed must be parsed */
+  if (rssparse->stopguid != NULL &&
+      rssparse->descending &&
+      strcmp (guid, rssparse->stopguid) == 0) {
+    rssparse->found = true;
+    xmlParseSAXStop (rssparse->sax);
+    return;
+  }
+
+  if (! *rssparse->newestguid || tmval > rssparse->newesttm) {
+    stpecpy (rssparse->newestguid,
+        rssparse->newestguid + sizeof (rssparse->newestguid), guid);
+    rssparse->newesttm = tmval;
+  }
 
-  rssdata->webresponse = respstr;
-  rssdata->webresplen = len;
-  rssdata->webresptime = tm;
-  return;
+  key = ilistGetCount (rssparse->itemlist);
+  for (int i = 0; i < RSS_ITEM_MAX; ++i) {
+    if (rssparse->itemval [i] != NULL) {
+      ilistSetStr (rssparse->itemlist, key, i, rssparse->itemval [i]);
+    }
+  }
+  snprintf (tbuff, sizeof (tbuff), "%" PRId64, (int64_t) tmval);
+  ilistSetStr (rssparse->itemlist, key, RSS_ITEM_DATE, tbuff);
+}
+
+static void
+rssClearItem (rssparse_t *rssparse)
+{
+  for (int i = 0; i < RSS_ITEM_VAL_MAX; ++i) {
+    dataFree (rssparse->itemval [i]);
+    rssparse->itemval [i] = NULL;
+  }
+}
+
+static time_t
+rssParseDate (const char *str)
+{
+  if (str == NULL || ! *str) {
+    return 0;
+  }
+  return tmutilStringToUTC (str, "%a, %d %h %Y %T %z");
 }
@@ -0,0 +1,702 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+/*
+ * audio source cache
+ *
+ * A local cache for audio files that are fetched from a remote
+ * audio source.  The cache is keyed by the song's uri, and the
+ * validators (etag, last-modified) are kept so that the audio source
+ * can check if the remote file has changed.
+ *
+ * The cached files are named by a hash of their content, so that the
+ * same file fetched using different uris is only stored once.
+ *
+ * When the cache exceeds the maximum size, the least recently used
+ * entries are removed.  The index is saved in the cache directory.
+ *
+ * The audio sources that use the network share the same cache.
+ * Allocating a cache for a directory that is already in use returns
+ * the same cache.
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#if __has_include (<pthread.h>)
+# include <pthread.h>
+#endif
+
+#include "ascache.h"
+#include "bdj4.h"
+#include "bdjstring.h"
+#include "dirlist.h"
+#include "dirop.h"
+#include "filemanip.h"
+#include "fileop.h"
+#include "log.h"
+#include "mdebug.h"
+#include "nodiscard.h"
+#include "slist.h"
+
+enum {
+  ASCACHE_VERSION = 1,
+  ASCACHE_BUFF_SZ = 256 * 1024,
+  /* a temporary file may be in use by another process */
+  ASCACHE_TMP_AGE = 3600,
+};
+
+#define ASCACHE_NONE    "-"
+#define ASCACHE_TMP_EXT ".tmp"
+
+typedef struct {
+  char      *cfname;
+  char      *etag;
+  char      *lastmod;
+  int64_t   size;
+  int64_t   lastused;
+} ascentry_t;
+
+typedef struct ascache {
+#if _lib_pthread_create
+  pthread_mutex_t lock;
+#endif
+  char            *dir;
+  char            *indexfn;
+  slist_t         *entries;
+  int64_t         maxsize;
+  int64_t         size;
+  int64_t         seq;
+  int             refcount;
+  bool            changed;
+} ascache_t;
+
+/* the audio sources allocate the shared cache from different threads */
+static ascache_t  *ascacheshared = NULL;
+#if _lib_pthread_create
+static pthread_mutex_t ascachesharedlock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void ascacheLoad (ascache_t *ascache);
+static void ascacheClean (ascache_t *ascache);
+static void ascacheEvict (ascache_t *ascache, const char *keepkey);
+static void ascacheRemoveEntry (ascache_t *ascache, const char *key);
+static bool ascacheIsReferenced (ascache_t *ascache, const char *cfname, const char *skipkey);
+static void ascacheCalcSize (ascache_t *ascache);
+static bool ascacheHashCopy (const char *fn, const char *outfn, uint64_t *hash, int64_t *size);
+static ascentry_t *ascacheEntryAlloc (const char *cfname, int64_t size, int64_t lastused, const char *etag, const char *lastmod);
+static void ascacheEntryFree (void *tentry);
+static void ascacheLock (ascache_t *ascache);
+static void ascacheUnlock (ascache_t *ascache);
+
+BDJ_NODISCARD
+ascache_t *
+ascacheAlloc (const char *dir, int64_t maxsize)
+{
+  ascache_t   *ascache;
+  char        tbuff [BDJ4_PATH_MAX];
+
+  if (dir == NULL) {
+    return NULL;
+  }
+
+#if _lib_pthread_create
+  pthread_mutex_lock (&ascachesharedlock);
+#endif
+  if (ascacheshared != NULL && strcmp (ascacheshared->dir, dir) == 0) {
+    ascacheshared->refcount += 1;
+#if _lib_pthread_create
+    pthread_mutex_unlock (&ascachesharedlock);
+#endif
+    return ascacheshared;
+  }
+
+  ascache = mdmalloc (sizeof (ascache_t));
+#if _lib_pthread_create
+  pthread_mutex_init (&ascache->lock, NULL);
+#endif
+  ascache->dir = mdstrdup (dir);
+  snprintf (tbuff, sizeof (tbuff), "%s/%s%s", dir,
+      ASCACHE_INDEX_FN, BDJ4_CONFIG_EXT);
+  ascache->indexfn = mdstrdup (tbuff);
+  ascache->entries = slistAlloc ("ascache", LIST_ORDERED, ascacheEntryFree);
+  ascache->maxsize = maxsize;
+  ascache->size = 0;
+  ascache->seq = 0;
+  ascache->refcount = 1;
+  ascache->changed = false;
+
+  diropMakeDir (dir);
+  ascacheLoad (ascache);
+  ascacheClean (ascache);
+
+  if (ascacheshared == NULL) {
+    ascacheshared = ascache;
+  }
+#if _lib_pthread_create
+  pthread_mutex_unlock (&ascachesharedlock);
+#endif
+
+  return ascache;
+}
+
+void
+ascacheFree (ascache_t *ascache)
+{
+  if (ascache == NULL) {
+    return;
+  }
+
+#if _lib_pthread_create
+  pthread_mutex_lock (&ascachesharedlock);
+#endif
+  ascache->refcount -= 1;
+  if (ascache->refcount > 0) {
+#if _lib_pthread_create
+    pthread_mutex_unlock (&ascachesharedlock);
+#endif
+    return;
+  }
+  if (ascache == ascacheshared) {
+    ascacheshared = NULL;
+  }
+#if _lib_pthread_create
+  pthread_mutex_unlock (&ascachesharedlock);
+#endif
+
+  ascacheSave (ascache);
+  slistFree (ascache->entries);
+  dataFree (ascache->dir);
+  dataFree (ascache->indexfn);
+#if _lib_pthread_create
+  pthread_mutex_destroy (&ascache->lock);
+#endif
+  mdfree (ascache);
+}
+
+/* returns false if the key is not in the cache */
+bool
+ascacheGetInfo (ascache_t *ascache, const char *key, ascacheinfo_t *info)
+{
+  ascentry_t    *entry;
+  bool          rc = false;
+
+  if (ascache == NULL || key == NULL) {
+    return rc;
+  }
+
+  ascacheLock (ascache);
+  entry = slistGetData (ascache->entries, key);
+  if (entry != NULL) {
+    if (info != NULL) {
+      info->size = entry->size;
+      stpecpy (info->etag, info->etag + sizeof (info->etag), entry->etag);
+      stpecpy (info->lastmod, info->lastmod + sizeof (info->lastmod),
+          entry->lastmod);
+    }
+    rc = true;
+  }
+  ascacheUnlock (ascache);
+
+  return rc;
+}
+
+/* a copy is made so that the cached file may be removed */
+/* while the output file is in use */
+bool
+ascacheCopy (ascache_t *ascache, const char *key, const char *outfn)
+{
+  ascentry_t    *entry;
+  char          tbuff [BDJ4_PATH_MAX];
+  bool          rc = false;
+
+  if (ascache == NULL || key == NULL || outfn == NULL) {
+    return rc;
+  }
+
+  ascacheLock (ascache);
+  entry = slistGetData (ascache->entries, key);
+  if (entry != NULL) {
+    snprintf (tbuff, sizeof (tbuff), "%s/%s", ascache->dir, entry->cfname);
+    if (fileopSize (tbuff) != entry->size) {
+      logMsg (LOG_DBG, LOG_IMPORTANT, "ascache: bad entry %s", key);
+      ascacheRemoveEntry (ascache, key);
+    } else {
+      rc = filemanipCopy (tbuff, outfn) == 0;
+      entry->lastused = ++ascache->seq;
+      ascache->changed = true;
+    }
+  }
+  ascacheUnlock (ascache);
+
+  return rc;
+}
+
+/* a copy of the file is added to the cache */
+bool
+ascacheAdd (ascache_t *ascache, const char *key, const char *fn,
+    const char *etag, const char *lastmod)
+{
+  char        tfn [BDJ4_PATH_MAX];
+  char        cfname [80];
+  char        cfn [BDJ4_PATH_MAX];
+  ascentry_t  *entry;
+  ascentry_t  *oldentry;
+  uint64_t    hash;
+  int64_t     size;
+  int64_t     seq;
+
+  if (ascache == NULL || key == NULL || fn == NULL) {
+    return false;
+  }
+  /* any line-ending characters would corrupt the index */
+  if (strpbrk (key, "\r\n") != NULL) {
+    return false;
+  }
+
+  size = fileopSize (fn);
+  if (size <= 0 || size > ascache->maxsize) {
+    return false;
+  }
+
+  ascacheLock (ascache);
+  seq = ++ascache->seq;
+  ascacheUnlock (ascache);
+
+  /* the file is copied outside of the lock */
+  snprintf (tfn, sizeof (tfn), "%s/%" PRId64 "%s",
+      ascache->dir, seq, ASCACHE_TMP_EXT);
+  if (! ascacheHashCopy (fn, tfn, &hash, &size)) {
+    fileopDelete (tfn);
+    return false;
+  }
+  snprintf (cfname, sizeof (cfname), "%016" PRIx64 "-%" PRId64, hash, size);
+  snprintf (cfn, sizeof (cfn), "%s/%s", ascache->dir, cfname);
+
+  ascacheLock (ascache);
+  if (fileopSize (cfn) == size) {
+    /* the same content is already in the cache */
+    fileopDelete (tfn);
+  } else {
+    filemanipMove (tfn, cfn);
+  }
+
+  oldentry = slistGetData (ascache->entries, key);
+  if (oldentry != NULL &&
+      strcmp (oldentry->cfname, cfname) != 0 &&
+      ! ascacheIsReferenced (ascache, oldentry->cfname, key)) {
+    char    tbuff [BDJ4_PATH_MAX];
+
+    snprintf (tbuff, sizeof (tbuff), "%s/%s", ascache->dir, oldentry->cfname);
+    fileopDelete (tbuff);
+  }
+
+  entry = ascacheEntryAlloc (cfname, size, ++ascache->seq, etag, lastmod);
+  slistSetData (ascache->entries, key, entry);
+  ascache->changed = true;
+  ascacheCalcSize (ascache);
+  ascacheEvict (ascache, key);
+  ascacheSave (ascache);
+  ascacheUnlock (ascache);
+
+  logMsg (LOG_DBG, LOG_INFO, "ascache: add %s %s", cfname, key);
+  return true;
+}
+
+void
+ascacheRemove (ascache_t *ascache, const char *key)
+{
+  if (ascache == NULL || key == NULL) {
+    return;
+  }
+
+  ascacheLock (ascache);
+  ascacheRemoveEntry (ascache, key);
+  ascacheUnlock (ascache);
+}
+
+void
+ascacheSave (ascache_t *ascache)
+{
+  FILE        *fh;
+  char        tfname [BDJ4_PATH_MAX];
+  slistidx_t  iteridx;
+  const char  *key;
+  ascentry_t  *entry;
+
+  if (ascache == NULL || ! ascache->changed) {
+    return;
+  }
+
+  snprintf (tfname, sizeof (tfname), "%s%s",
+      ascache->indexfn, ASCACHE_TMP_EXT);
+  fh = fileopOpen (tfname, "w");
+  if (fh == NULL) {
+    logMsg (LOG_DBG, LOG_IMPORTANT, "ERR: unable to save ascache %s", tfname);
+    return;
+  }
+
+  fprintf (fh, "# %s\n", ASCACHE_INDEX_FN);
+  fprintf (fh, "VERSION\t%d\n", ASCACHE_VERSION);
+  fprintf (fh, "SEQ\t%" PRId64 "\n", ascache->seq);
+
+  slistStartIterator (ascache->entries, &iteridx);
+  while ((key = slistIterateKey (ascache->entries, &iteridx)) != NULL) {
+    entry = slistGetData (ascache->entries, key);
+    fprintf (fh, "E\t%s\t%" PRId64 "\t%" PRId64 "\t%s\t%s\t%s\n",
+        entry->cfname, entry->size, entry->lastused,
+        *entry->etag ? entry->etag : ASCACHE_NONE,
+        *entry->lastmod ? entry->lastmod : ASCACHE_NONE,
+        key);
+  }
+  mdextfclose (fh);
+  fclose (fh);
+
+  filemanipMove (tfname, ascache->indexfn);
+  ascache->changed = false;
+}
+
+int32_t
+ascacheGetCount (ascache_t *ascache)
+{
+  if (ascache == NULL) {
+    return 0;
+  }
+
+  return slistGetCount (ascache->entries);
+}
+
+int64_t
+ascacheGetSize (ascache_t *ascache)
+{
+  if (ascache == NULL) {
+    return 0;
+  }
+
+  return ascache->size;
+}
+
+/* internal routines */
+
+static void
+ascacheLoad (ascache_t *ascache)
+{
+  FILE        *fh;
+  char        tbuff [BDJ4_PATH_MAX + 300];
+  char        cfn [BDJ4_PATH_MAX];
+  char        *tokstr;
+  char        *p;
+  int         version = -1;
+
+  fh = fileopOpen (ascache->indexfn, "r");
+  if (fh == NULL) {
+    return;
+  }
+
+  while (fgets (tbuff, sizeof (tbuff), fh) != NULL) {
+    const char  *vals [5];
+    bool        ok = true;
+    ascentry_t  *entry;
+
+    stringTrim (tbuff);
+
+    if (*tbuff == '#' || *tbuff == '\0') {
+      continue;
+    }
+
+    if (strncmp (tbuff, "VERSION\t", 8) == 0) {
+      version = atoi (tbuff + 8);
+      if (version != ASCACHE_VERSION) {
+        break;
+      }
+      continue;
+    }
+
+    if (version != ASCACHE_VERSION) {
+      break;
+    }
+
+    if (strncmp (tbuff, "SEQ\t", 4) == 0) {
+      ascache->seq = strtoll (tbuff + 4, NULL, 10);
+      continue;
+    }
+
+    if (strncmp (tbuff, "E\t", 2) != 0) {
+      continue;
+    }
+
+    /* cfname size lastused etag lastmod key */
+    p = strtok_r (tbuff + 2, "\t", &tokstr);
+    for (int i = 0; i < 5; ++i) {
+      if (p == NULL) {
+        ok = false;
+        break;
+      }
+      vals [i] = p;
+      if (i < 4) {
+        p = strtok_r (NULL, "\t", &tokstr);
+      }
+    }
+    /* the key is the remainder of the line */
+    if (! ok || tokstr == NULL || ! *tokstr) {
+      continue;
+    }
+
+    entry = ascacheEntryAlloc (vals [0], strtoll (vals [1], NULL, 10),
+        strtoll (vals [2], NULL, 10),
+        strcmp (vals [3], ASCACHE_NONE) == 0 ? "" : vals [3],
+        strcmp (vals [4], ASCACHE_NONE) == 0 ? "" : vals [4]);
+
+    /* an entry that is missing its file is dropped */
+    snprintf (cfn, sizeof (cfn), "%s/%s", ascache->dir, entry->cfname);
+    if (fileopSize (cfn) != entry->size) {
+      ascacheEntryFree (entry);
+      continue;
+    }
+    slistSetData (ascache->entries, tokstr, entry);
+  }
+  mdextfclose (fh);
+  fclose (fh);
+
+  ascacheCalcSize (ascache);
+  logMsg (LOG_DBG, LOG_INFO, "ascache: loaded: %" PRId32 " size: %" PRId64,
+      (int32_t) slistGetCount (ascache->entries), ascache->size);
+}
+
+/* any files that are not in the index are removed */
+/* these are left over from an interrupted add or an eviction */
+static void
+ascacheClean (ascache_t *ascache)
+{
+  slist_t     *filelist;
+  slist_t     *cflist;
+  slistidx_t  iteridx;
+  const char  *fn;
+  const char  *indexfn;
+  ascentry_t  *entry;
+  char        tbuff [BDJ4_PATH_MAX];
+
+  cflist = slistAlloc ("ascache-cf", LIST_ORDERED, NULL);
+  slistStartIterator (ascache->entries, &iteridx);
+  while ((entry = slistIterateValueData (ascache->entries, &iteridx)) != NULL) {
+    slistSetNum (cflist, entry->cfname, 1);
+  }
+
+  indexfn = strrchr (ascache->indexfn, '/') + 1;
+  filelist = dirlistBasicDirList (ascache->dir, NULL);
+  slistStartIterator (filelist, &iteridx);
+  while ((fn = slistIterateKey (filelist, &iteridx)) != NULL) {
+    if (strcmp (fn, indexfn) == 0) {
+      continue;
+    }
+    if (slistGetIdx (cflist, fn) >= 0) {
+      continue;
+    }
+    snprintf (tbuff, sizeof (tbuff), "%s/%s", ascache->dir, fn);
+    if (strstr (fn, ASCACHE_TMP_EXT) != NULL &&
+        fileopModTime (tbuff) > time (NULL) - ASCACHE_TMP_AGE) {
+      continue;
+    }
+    fileopDelete (tbuff);
+  }
+  slistFree (filelist);
+  slistFree (cflist);
+}
+
+/* the least recently used entries are removed until the */
+/* cache is within its maximum size */
+static void
+ascacheEvict (ascache_t *ascache, const char *keepkey)
+{
+  slistidx_t  iteridx;
+  const char  *key;
+  const char  *oldkey;
+  ascentry_t  *entry;
+  int64_t     oldest;
+
+  while (ascache->size > ascache->maxsize) {
+    oldkey = NULL;
+    oldest = INT64_MAX;
+    slistStartIterator (ascache->entries, &iteridx);
+    while ((key = slistIterateKey (ascache->entries, &iteridx)) != NULL) {
+      if (keepkey != NULL && strcmp (key, keepkey) == 0) {
+        continue;
+      }
+      entry = slistGetData (ascache->entries, key);
+      if (entry->lastused < oldest) {
+        oldest = entry->lastused;
+        oldkey = key;
+      }
+    }
+    if (oldkey == NULL) {
+      break;
+    }
+    logMsg (LOG_DBG, LOG_INFO, "ascache: evict %s", oldkey);
+    ascacheRemoveEntry (ascache, oldkey);
+  }
+}
+
+/* the file is only removed if no other entry uses it */
+static void
+ascacheRemoveEntry (ascache_t *ascache, const char *key)
+{
+  ascentry_t  *entry;
+  char        tbuff [BDJ4_PATH_MAX];
+
+  entry = slistGetData (ascache->entries, key);
+  if (entry == NULL) {
+    return;
+  }
+
+  if (! ascacheIsReferenced (ascache, entry->cfname, key)) {
+    snprintf (tbuff, sizeof (tbuff), "%s/%s", ascache->dir, entry->cfname);
+    fileopDelete (tbuff);
+  }
+  slistDelete (ascache->entries, key);
+  ascache->changed = true;
+  ascacheCalcSize (ascache);
+}
+
+static bool
+ascacheIsReferenced (ascache_t *ascache, const char *cfname,
+    const char *skipkey)
+{
+  slistidx_t  iteridx;
+  const char  *key;
+  ascentry_t  *entry;
+
+  slistStartIterator (ascache->entries, &iteridx);
+  while ((key = slistIterateKey (ascache->entries, &iteridx)) != NULL) {
+    if (strcmp (key, skipkey) == 0) {
+      continue;
+    }
+    entry = slistGetData (ascache->entries, key);
+    if (strcmp (entry->cfname, cfname) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* a file that is shared by several entries is only counted once */
+static void
+ascacheCalcSize (ascache_t *ascache)
+{
+  slist_t     *cflist;
+  slistidx_t  iteridx;
+  ascentry_t  *entry;
+
+  ascache->size = 0;
+  cflist = slistAlloc ("ascache-cf", LIST_ORDERED, NULL);
+  slistStartIterator (ascache->entries, &iteridx);
+  while ((entry = slistIterateValueData (ascache->entries, &iteridx)) != NULL) {
+    if (slistGetIdx (cflist, entry->cfname) >= 0) {
+      continue;
+    }
+    slistSetNum (cflist, entry->cfname, 1);
+    ascache->size += entry->size;
+  }
+  slistFree (cflist);
+}
+
+/* the file is copied and hashed in a single pass */
+static bool
+ascacheHashCopy (const char *fn, const char *outfn, uint64_t *hash,
+    int64_t *size)
+{
+  FILE      *ifh;
+  FILE      *ofh;
+  char      *buff;
+  size_t    len;
+  bool      rc = true;
+
+  *hash = STRING_HASH64_INIT;
+  *size = 0;
+
+  ifh = fileopOpen (fn, "rb");
+  if (ifh == NULL) {
+    return false;
+  }
+  ofh = fileopOpen (outfn, "wb");
+  if (ofh == NULL) {
+    mdextfclose (ifh);
+    fclose (ifh);
+    return false;
+  }
+
+  buff = mdmalloc (ASCACHE_BUFF_SZ);
+  while ((len = fread (buff, 1, ASCACHE_BUFF_SZ, ifh)) > 0) {
+    *hash = stringHash64Data (*hash, buff, len);
+    if (fwrite (buff, 1, len, ofh) != len) {
+      rc = false;
+      break;
+    }
+    *size += len;
+  }
+  if (ferror (ifh)) {
+    rc = false;
+  }
+  mdfree (buff);
+
+  mdextfclose (ifh);
+  fclose (ifh);
+  mdextfclose (ofh);
+  if (fclose (ofh) != 0) {
+    rc = false;
+  }
+
+  return rc;
+}
+
+static ascentry_t *
+ascacheEntryAlloc (const char *cfname, int64_t size, int64_t lastused,
+    const char *etag, const char *lastmod)
+{
+  ascentry_t  *entry;
+
+  entry = mdmalloc (sizeof (ascentry_t));
+  entry->cfname = mdstrdup (cfname);
+  entry->etag = mdstrdup (etag == NULL ? "" : etag);
+  entry->lastmod = mdstrdup (lastmod == NULL ? "" : lastmod);
+  entry->size = size;
+  entry->lastused = lastused;
+  return entry;
+}
+
+static void
+ascacheEntryFree (void *tentry)
+{
+  ascentry_t  *entry = tentry;
+
+  if (entry == NULL) {
+    return;
+  }
+
+  dataFree (entry->cfname);
+  dataFree (entry->etag);
+  dataFree (entry->lastmod);
+  mdfree (entry);
+}
+
+static void
+ascacheLock (ascache_t *ascache)
+{
+#if _lib_pthread_create
+  pthread_mutex_lock (&ascache->lock);
+#endif
+}
+
+static void
+ascacheUnlock (ascache_t *ascache)
+{
+#if _lib_pthread_create
+  pthread_mutex_unlock (&ascache->lock);
+#endif
+}
@@ -5,6 +5,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
 #include <string.h>
@@ -13,6 +14,11 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <dirent.h>
+
+#if __has_include (<pthread.h>)
+# include <pthread.h>
+#endif
 
 #include "bdj4.h"
 #include "bdjstring.h"
@@ -26,6 +32,48 @@
 #include "pathinfo.h"
 #include "queue.h"
 
+/* the directory walker uses the d_type field from readdir() and */
+/* stats relative to the directory handle where needed */
+#if _lib_fdopendir && _lib_fstatat && defined (DT_DIR)
+# define DIRLIST_WALK_USE_FD 1
+#else
+# define DIRLIST_WALK_USE_FD 0
+#endif
+
+enum {
+  DIRLIST_WALK_THREADS = 4,
+};
+
+typedef enum {
+  DIRLIST_TYPE_NONE,
+  DIRLIST_TYPE_FILE,
+  DIRLIST_TYPE_DIR,
+  DIRLIST_TYPE_LINK,
+} dirlisttype_t;
+
+typedef struct dirwalk {
+#if _lib_pthread_create
+  pthread_t       threads [DIRLIST_WALK_THREADS];
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+#endif
+  queue_t         *dirQueue;
+  queue_t         *outQueue;
+  int             flags;
+  int             threadcount;
+  int             active;
+  int32_t         count;
+  bool            finished;
+  bool            stop;
+} dirwalk_t;
+
+static void dirlistWalkLock (dirwalk_t *dirwalk);
+static void dirlistWalkUnlock (dirwalk_t *dirwalk);
+static void dirlistWalkSignal (dirwalk_t *dirwalk);
+static void *dirlistWalkThread (void *arg);
+static void dirlistWalkDir (dirwalk_t *dirwalk, const char *dir);
+static void dirlistWalkAdd (dirwalk_t *dirwalk, const char *path, dirlisttype_t type);
+
 BDJ_NODISCARD
 slist_t *
 dirlistBasicDirList (const char *dirname, const char *extension)
@@ -148,3 +196,321 @@ dirlistRecursiveDirList (const char *dirname, int flags)
   return fileList;
 }
 
+
+/* the directory walker */
+/* the sub-directories are processed by a small pool of threads, */
+/* and the entries are returned as they are found. */
+/* the entries are not sorted. */
+
+BDJ_NODISCARD
+dirwalk_t *
+dirlistWalkStart (const char *dirname, int flags)
+{
+  dirwalk_t   *dirwalk;
+
+  if (! fileopIsDirectory (dirname)) {
+    return NULL;
+  }
+
+  dirwalk = mdmalloc (sizeof (dirwalk_t));
+  dirwalk->dirQueue = queueAlloc ("walk-dir-q", NULL);
+  dirwalk->outQueue = queueAlloc ("walk-out-q", NULL);
+  dirwalk->flags = flags;
+  dirwalk->threadcount = 0;
+  dirwalk->active = 0;
+  dirwalk->count = 0;
+  dirwalk->finished = false;
+  dirwalk->stop = false;
+
+  queuePush (dirwalk->dirQueue, mdstrdup (dirname));
+
+#if _lib_pthread_create
+  pthread_mutex_init (&dirwalk->lock, NULL);
+  pthread_cond_init (&dirwalk->cond, NULL);
+  for (int i = 0; i < DIRLIST_WALK_THREADS; ++i) {
+    if (pthread_create (&dirwalk->threads [i], NULL,
+        dirlistWalkThread, dirwalk) != 0) {
+      break;
+    }
+    ++dirwalk->threadcount;
+  }
+#endif
+
+  if (dirwalk->threadcount == 0) {
+    /* no threads, do the entire walk now */
+    dirlistWalkThread (dirwalk);
+  }
+
+  return dirwalk;
+}
+
+/* does not block. */
+/* returns DIRLIST_WALK_WAIT if the walk is still in progress */
+/* and no entry is available */
+dirwalkrc_t
+dirlistWalkNext (dirwalk_t *dirwalk, char *buff, size_t sz)
+{
+  dirwalkrc_t rc = DIRLIST_WALK_WAIT;
+  char        *path;
+
+  if (dirwalk == NULL) {
+    return DIRLIST_WALK_DONE;
+  }
+
+  dirlistWalkLock (dirwalk);
+  path = queuePop (dirwalk->outQueue);
+  if (path == NULL && dirwalk->finished) {
+    rc = DIRLIST_WALK_DONE;
+  }
+  dirlistWalkUnlock (dirwalk);
+
+  if (path != NULL) {
+    stpecpy (buff, buff + sz, path);
+    mdfree (path);
+    rc = DIRLIST_WALK_ENTRY;
+  }
+
+  return rc;
+}
+
+/* the number of entries found so far */
+int32_t
+dirlistWalkCount (dirwalk_t *dirwalk)
+{
+  int32_t   count;
+
+  if (dirwalk == NULL) {
+    return 0;
+  }
+
+  dirlistWalkLock (dirwalk);
+  count = dirwalk->count;
+  dirlistWalkUnlock (dirwalk);
+  return count;
+}
+
+void
+dirlistWalkFree (dirwalk_t *dirwalk)
+{
+  char    *path;
+
+  if (dirwalk == NULL) {
+    return;
+  }
+
+  dirlistWalkLock (dirwalk);
+  dirwalk->stop = true;
+  dirlistWalkSignal (dirwalk);
+  dirlistWalkUnlock (dirwalk);
+
+#if _lib_pthread_create
+  for (int i = 0; i < dirwalk->threadcount; ++i) {
+    pthread_join (dirwalk->threads [i], NULL);
+  }
+  pthread_cond_destroy (&dirwalk->cond);
+  pthread_mutex_destroy (&dirwalk->lock);
+#endif
+
+  while ((path = queuePop (dirwalk->dirQueue)) != NULL) {
+    mdfree (path);
+  }
+  while ((path = queuePop (dirwalk->outQueue)) != NULL) {
+    mdfree (path);
+  }
+  queueFree (dirwalk->dirQueue);
+  queueFree (dirwalk->outQueue);
+  mdfree (dirwalk);
+}
+
+/* internal routines */
+
+static void
+dirlistWalkLock (dirwalk_t *dirwalk)
+{
+#if _lib_pthread_create
+  if (dirwalk->threadcount > 0) {
+    pthread_mutex_lock (&dirwalk->lock);
+  }
+#endif
+}
+
+static void
+dirlistWalkUnlock (dirwalk_t *dirwalk)
+{
+#if _lib_pthread_create
+  if (dirwalk->threadcount > 0) {
+    pthread_mutex_unlock (&dirwalk->lock);
+  }
+#endif
+}
+
+static void
+dirlistWalkSignal (dirwalk_t *dirwalk)
+{
+#if _lib_pthread_create
+  if (dirwalk->threadcount > 0) {
+    pthread_cond_broadcast (&dirwalk->cond);
+  }
+#endif
+}
+
+static void *
+dirlistWalkThread (void *arg)
+{
+  dirwalk_t   *dirwalk = arg;
+  char        *dir;
+
+  dirlistWalkLock (dirwalk);
+  while (true) {
+#if _lib_pthread_create
+    while (dirwalk->threadcount > 0 &&
+        queueGetCount (dirwalk->dirQueue) == 0 &&
+        dirwalk->active > 0 &&
+        ! dirwalk->stop) {
+      pthread_cond_wait (&dirwalk->cond, &dirwalk->lock);
+    }
+#endif
+
+    if (dirwalk->stop ||
+        (queueGetCount (dirwalk->dirQueue) == 0 && dirwalk->active == 0)) {
+      dirwalk->finished = true;
+      dirlistWalkSignal (dirwalk);
+      break;
+    }
+
+    dir = queuePop (dirwalk->dirQueue);
+    ++dirwalk->active;
+    dirlistWalkUnlock (dirwalk);
+
+    dirlistWalkDir (dirwalk, dir);
+    mdfree (dir);
+
+    dirlistWalkLock (dirwalk);
+    --dirwalk->active;
+    if (dirwalk->active == 0) {
+      dirlistWalkSignal (dirwalk);
+    }
+  }
+  dirlistWalkUnlock (dirwalk);
+
+  return NULL;
+}
+
+static void
+dirlistWalkDir (dirwalk_t *dirwalk, const char *dir)
+{
+  char            temp [BDJ4_PATH_MAX];
+  dirlisttype_t   type;
+#if DIRLIST_WALK_USE_FD
+  DIR             *dh;
+  struct dirent   *dent;
+  struct stat     statbuf;
+  int             dfd;
+
+  dfd = open (dir, O_RDONLY | O_DIRECTORY);
+  if (dfd < 0) {
+    return;
+  }
+  dh = fdopendir (dfd);
+  if (dh == NULL) {
+    close (dfd);
+    return;
+  }
+
+  while ((dent = readdir (dh)) != NULL) {
+    int     rc;
+
+    if (strcmp (dent->d_name, ".") == 0 ||
+        strcmp (dent->d_name, "..") == 0) {
+      continue;
+    }
+
+    type = DIRLIST_TYPE_NONE;
+    if (dent->d_type == DT_DIR) {
+      type = DIRLIST_TYPE_DIR;
+    } else if (dent->d_type == DT_REG) {
+      type = DIRLIST_TYPE_FILE;
+    } else if (dent->d_type == DT_LNK &&
+        (dirwalk->flags & DIRLIST_LINKS) == DIRLIST_LINKS) {
+      type = DIRLIST_TYPE_LINK;
+    } else {
+      /* unknown type, or a link that must be followed */
+      rc = fstatat (dfd, dent->d_name, &statbuf, AT_SYMLINK_NOFOLLOW);
+      if (rc == 0 && S_ISLNK (statbuf.st_mode) &&
+          (dirwalk->flags & DIRLIST_LINKS) == DIRLIST_LINKS) {
+        type = DIRLIST_TYPE_LINK;
+      } else {
+        if (rc == 0 && S_ISLNK (statbuf.st_mode)) {
+          rc = fstatat (dfd, dent->d_name, &statbuf, 0);
+        }
+        if (rc == 0) {
+          type = S_ISDIR (statbuf.st_mode) ?
+              DIRLIST_TYPE_DIR : DIRLIST_TYPE_FILE;
+        }
+      }
+    }
+
+    snprintf (temp, sizeof (temp), "%s/%s", dir, dent->d_name);
+    dirlistWalkAdd (dirwalk, temp, type);
+  }
+
+  /* closes dfd also */
+  closedir (dh);
+#else
+  dirhandle_t     *dh;
+  char            *fname;
+
+  dh = osDirOpen (dir);
+  while ((fname = osDirIterate (dh)) != NULL) {
+    if (strcmp (fname, ".") == 0 ||
+        strcmp (fname, "..") == 0) {
+      mdfree (fname);
+      continue;
+    }
+
+    snprintf (temp, sizeof (temp), "%s/%s", dir, fname);
+    type = DIRLIST_TYPE_NONE;
+    if ((dirwalk->flags & DIRLIST_LINKS) == DIRLIST_LINKS &&
+        osIsLink (temp)) {
+      type = DIRLIST_TYPE_LINK;
+    } else if (fileopIsDirectory (temp)) {
+      type = DIRLIST_TYPE_DIR;
+    } else if (fileopFileExists (temp)) {
+      type = DIRLIST_TYPE_FILE;
+    }
+    dirlistWalkAdd (dirwalk, temp, type);
+    mdfree (fname);
+  }
+  osDirClose (dh);
+#endif
+}
+
+static void
+dirlistWalkAdd (dirwalk_t *dirwalk, const char *path, dirlisttype_t type)
+{
+  bool    output = false;
+
+  if (type == DIRLIST_TYPE_NONE) {
+    return;
+  }
+
+  if ((type == DIRLIST_TYPE_FILE || type == DIRLIST_TYPE_LINK) &&
+      (dirwalk->flags & DIRLIST_FILES) == DIRLIST_FILES) {
+    output = true;
+  }
+  if (type == DIRLIST_TYPE_DIR &&
+      (dirwalk->flags & DIRLIST_DIRS) == DIRLIST_DIRS) {
+    output = true;
+  }
+
+  dirlistWalkLock (dirwalk);
+  if (type == DIRLIST_TYPE_DIR) {
+    queuePush (dirwalk->dirQueue, mdstrdup (path));
+    dirlistWalkSignal (dirwalk);
+  }
+  if (output) {
+    queuePush (dirwalk->outQueue, mdstrdup (path));
+    ++dirwalk->count;
+  }
+  dirlistWalkUnlock (dirwalk);
+}
@@ -73,8 +73,8 @@ static void     listReplace (list_t *, listidx_t, listitem_t *item);
 static int      listBinarySearch (const list_t *, listkeylookup_t *key, listidx_t *);
 static int      idxCompare (listidx_t, listidx_t);
 static int      listCompare (const list_t *, const listkey_t *a, const listkey_t *b);
-static long     merge (list_t *, listidx_t, listidx_t, listidx_t);
-static long     mergeSort (list_t *, listidx_t, listidx_t);
+static long     merge (list_t *, listitem_t *tmp, listidx_t, listidx_t, listidx_t);
+static long     mergeSort (list_t *, listitem_t *tmp, listidx_t, listidx_t);
 static void     listClearCache (list_t *list);
 static listidx_t listCheckCache (list_t *list, listkeylookup_t *key);
 
@@ -166,7 +166,8 @@ listSort (keytype_t keytype, list_t *list)
 {
   mstime_t      tm;
   time_t        elapsed;
-  long          swaps;
+  long          swaps = 0;
+  listitem_t    *tmp;
 
   if (! listCheckIfValid (list, keytype)) {
     return;
@@ -174,7 +175,12 @@ listSort (keytype_t keytype, list_t *list)
 
   mstimestart (&tm);
   list->ordered = LIST_ORDERED;
-  swaps = mergeSort (list, 0, list->count - 1);
+  if (list->count > 1) {
+    /* the merge needs room for the left half */
+    tmp = mdmalloc (sizeof (listitem_t) * (list->count / 2 + 1));
+    swaps = mergeSort (list, tmp, 0, list->count - 1);
+    mdfree (tmp);
+  }
   elapsed = mstimeend (&tm);
   if (elapsed > 0) {
     logMsg (LOG_DBG, LOG_LIST, "sort of %s took %" PRId64 " ms with %ld swaps", list->name, (int64_t) elapsed, swaps);
@@ -971,58 +977,58 @@ listBinarySearch (const list_t *list, listkeylookup_t *key, listidx_t *loc)
 }
 
 /*
- * in-place merge sort from:
- * https://www.geeksforgeeks.org/in-place-merge-sort/
+ * top-down merge sort using a scratch buffer sized for the left half.
+ * the left half is copied out, then merged back in from the front.
+ * the merge is stable.
+ * the returned count is the number of right half items moved ahead
+ * of the left half, and is only used for logging.
  */
-
 static long
-merge (list_t *list, listidx_t start, listidx_t mid, listidx_t end)
+merge (list_t *list, listitem_t *tmp, listidx_t start, listidx_t mid,
+    listidx_t end)
 {
-  listidx_t   start2 = mid + 1;
-  listitem_t  value;
+  listidx_t   lidx = 0;
+  listidx_t   lcount;
+  listidx_t   ridx = mid + 1;
+  listidx_t   didx = start;
   long        swaps = 0;
+  int         rc;
 
-  int rc = listCompare (list, &list->data [mid].key, &list->data [start2].key);
+  rc = listCompare (list, &list->data [mid].key, &list->data [ridx].key);
   if (rc <= 0) {
     return swaps;
   }
 
-  while (start <= mid && start2 <= end) {
-    rc = listCompare (list, &list->data [start].key, &list->data [start2].key);
+  lcount = mid - start + 1;
+  memcpy (tmp, list->data + start, sizeof (listitem_t) * lcount);
+
+  while (lidx < lcount && ridx <= end) {
+    rc = listCompare (list, &tmp [lidx].key, &list->data [ridx].key);
     if (rc <= 0) {
-      start++;
+      list->data [didx++] = tmp [lidx++];
     } else {
-      listidx_t       index;
-
       ++swaps;
-      value = list->data [start2];
-      index = start2;
-
-      while (index != start) {
-        list->data [index] = list->data [index - 1];
-        index--;
-      }
-      list->data [start] = value;
-
-      start++;
-      mid++;
-      start2++;
+      list->data [didx++] = list->data [ridx++];
     }
   }
+  /* any remaining right half items are already in place */
+  while (lidx < lcount) {
+    list->data [didx++] = tmp [lidx++];
+  }
 
   return swaps;
 }
 
 static long
-mergeSort (list_t *list, listidx_t l, listidx_t r)
+mergeSort (list_t *list, listitem_t *tmp, listidx_t l, listidx_t r)
 {
   long swaps = 0;
 
   if (list->count > 0 && l < r) {
     listidx_t m = l + (r - l) / 2;
-    swaps += mergeSort (list, l, m);
-    swaps += mergeSort (list, m + 1, r);
-    swaps += merge (list, l, m, r);
+    swaps += mergeSort (list, tmp, l, m);
+    swaps += mergeSort (list, tmp, m + 1, r);
+    swaps += merge (list, tmp, l, m, r);
   }
 
   return swaps;
@@ -128,6 +128,22 @@ nlistSetList (nlist_t *list, nlistidx_t lkey, nlist_t *data)
   listSetNumList (LIST_KEY_NUM, list, lkey, data);
 }
 
+void
+nlistDelete (nlist_t *list, nlistidx_t lkey)
+{
+  nlistidx_t      idx;
+
+  if (list == NULL) {
+    return;
+  }
+  if (listGetOrdering (LIST_KEY_NUM, list) == LIST_UNORDERED) {
+    return;
+  }
+
+  idx = listGetIdxNumKey (LIST_KEY_NUM, list, lkey);
+  listDeleteByIdx (LIST_KEY_NUM, list, idx);
+}
+
 void
 nlistIncrement (nlist_t *list, nlistidx_t lkey)
 {
@@ -100,6 +100,8 @@ procutilStart (const char *fn, int profile, loglevel_t loglvl,
   process->pid = 0;
   process->hasHandle = false;
   process->started = false;
+  process->handshake = false;
+  mstimestart (&process->starttm);
 
   logProcBegin ();
   snprintf (sprof, sizeof (sprof), "%d", profile);
@@ -331,6 +333,26 @@ procutilForceStop (procutil_t *process, int flags, bdjmsgroute_t route)
   }
 }
 
+/* logs the time from the process start to the first handshake */
+void
+procutilCheckHandshake (procutil_t *processes [ROUTE_MAX], conn_t *conn)
+{
+  for (bdjmsgroute_t i = ROUTE_NONE; i < ROUTE_MAX; ++i) {
+    procutil_t  *process = processes [i];
+
+    if (process == NULL || ! process->started || process->handshake) {
+      continue;
+    }
+    if (! connHaveHandshake (conn, i)) {
+      continue;
+    }
+
+    process->handshake = true;
+    logMsg (LOG_SESS, LOG_IMPORTANT, "%s launch-to-handshake: %" PRId64 " ms",
+        msgRouteDebugText (i), (int64_t) mstimeend (&process->starttm));
+  }
+}
+
 /* internal routines */
 
 #if _typ_HANDLE
@@ -32,8 +32,24 @@ typedef struct xmlparse {
   int                 isvalid;
 } xmlparse_t;
 
+typedef struct xmlparsesax {
+  xmlSAXHandler       handler;
+  xmlParserCtxtPtr    ctxt;
+  void                *udata;
+  xmlparsestartcb_t   startcb;
+  xmlparseendcb_t     endcb;
+  xmlparsetextcb_t    textcb;
+  bool                isvalid;
+  bool                stopped;
+} xmlparsesax_t;
+
 static void xmlParseXMLErrorHandler (void *udata, xmlErrorPtr xmlerr);
 static void xmlParseRegisterNamespaces (xmlparse_t *xmlparse);
+static void xmlParseSAXStart (void *udata, const xmlChar *localname, const xmlChar *prefix, const xmlChar *uri, int nbns, const xmlChar **ns, int nbattr, int nbdefaulted, const xmlChar **attrs);
+static void xmlParseSAXEnd (void *udata, const xmlChar *localname, const xmlChar *prefix, const xmlChar *uri);
+static void xmlParseSAXName (char *buff, size_t sz, const xmlChar *localname, const xmlChar *prefix);
+static void xmlParseSAXText (void *udata, const xmlChar *text, int len);
+static void xmlParseSAXErrorHandler (void *udata, xmlErrorPtr xmlerr);
 
 BDJ_NODISCARD
 xmlparse_t *
@@ -281,6 +297,135 @@ xmlParseIsValid (xmlparse_t *xmlparse)
   return xmlparse->isvalid;
 }
 
+/* the sax parser is a push parser, the data may be passed in */
+/* as it is received.  no document tree is built. */
+/* the callbacks may call xmlParseSAXStop() to end the parse early. */
+BDJ_NODISCARD
+xmlparsesax_t *
+xmlParseSAXInit (void *udata, xmlparsestartcb_t startcb,
+    xmlparseendcb_t endcb, xmlparsetextcb_t textcb)
+{
+  xmlparsesax_t   *sax;
+
+  sax = mdmalloc (sizeof (xmlparsesax_t));
+  memset (&sax->handler, 0, sizeof (sax->handler));
+  sax->handler.initialized = XML_SAX2_MAGIC;
+  sax->handler.startElementNs = xmlParseSAXStart;
+  sax->handler.endElementNs = xmlParseSAXEnd;
+  sax->handler.characters = xmlParseSAXText;
+  sax->handler.cdataBlock = xmlParseSAXText;
+  sax->handler.serror = xmlParseSAXErrorHandler;
+  sax->ctxt = NULL;
+  sax->udata = udata;
+  sax->startcb = startcb;
+  sax->endcb = endcb;
+  sax->textcb = textcb;
+  sax->isvalid = true;
+  sax->stopped = false;
+
+  /* xmlCleanupParser() is not called, as the sax parser may be */
+  /* in use by more than one thread */
+  xmlInitParser ();
+
+  return sax;
+}
+
+void
+xmlParseSAXFree (xmlparsesax_t *sax)
+{
+  if (sax == NULL) {
+    return;
+  }
+
+  if (sax->ctxt != NULL) {
+    mdextfree (sax->ctxt);
+    xmlFreeParserCtxt (sax->ctxt);
+  }
+  mdfree (sax);
+}
+
+/* returns false if the parse has failed or has been stopped */
+bool
+xmlParseSAXPush (xmlparsesax_t *sax, const char *data, size_t len)
+{
+  size_t    ilen;
+
+  if (sax == NULL) {
+    return false;
+  }
+  if (sax->stopped || ! sax->isvalid) {
+    return false;
+  }
+
+  if (sax->ctxt == NULL) {
+    /* the first bytes are used to determine the encoding */
+    ilen = len < 4 ? len : 4;
+    sax->ctxt = xmlCreatePushParserCtxt (&sax->handler, sax,
+        data, (int) ilen, NULL);
+    if (sax->ctxt == NULL) {
+      sax->isvalid = false;
+      return false;
+    }
+    mdextalloc (sax->ctxt);
+    xmlCtxtUseOptions (sax->ctxt, XML_PARSE_NONET | XML_PARSE_NOWARNING);
+    data += ilen;
+    len -= ilen;
+  }
+
+  while (len > 0 && ! sax->stopped && sax->isvalid) {
+    ilen = len > INT32_MAX ? INT32_MAX : len;
+    if (xmlParseChunk (sax->ctxt, data, (int) ilen, 0) != 0 &&
+        ! sax->stopped) {
+      sax->isvalid = false;
+    }
+    data += ilen;
+    len -= ilen;
+  }
+
+  return sax->isvalid && ! sax->stopped;
+}
+
+/* returns true if the document was parsed without error */
+/* a stopped parse is not an error */
+bool
+xmlParseSAXFinish (xmlparsesax_t *sax)
+{
+  if (sax == NULL || sax->ctxt == NULL) {
+    return false;
+  }
+
+  if (! sax->stopped && sax->isvalid) {
+    if (xmlParseChunk (sax->ctxt, NULL, 0, 1) != 0 && ! sax->stopped) {
+      sax->isvalid = false;
+    }
+  }
+
+  return sax->isvalid;
+}
+
+void
+xmlParseSAXStop (xmlparsesax_t *sax)
+{
+  if (sax == NULL) {
+    return;
+  }
+
+  sax->stopped = true;
+  if (sax->ctxt != NULL) {
+    xmlStopParser (sax->ctxt);
+  }
+}
+
+bool
+xmlParseSAXIsStopped (xmlparsesax_t *sax)
+{
+  if (sax == NULL) {
+    return false;
+  }
+
+  return sax->stopped;
+}
+
 /* internal routines */
 
 static void
@@ -327,3 +472,99 @@ xmlParseXMLErrorHandler (void *udata, xmlErrorPtr xmlerr)
   }
   return;
 }
+
+static void
+xmlParseSAXStart (void *udata, const xmlChar *localname,
+    const xmlChar *prefix, const xmlChar *uri, int nbns, const xmlChar **ns,
+    int nbattr, int nbdefaulted, const xmlChar **attrs)
+{
+  xmlparsesax_t   *sax = udata;
+  char            name [200];
+  const char      **tattrs;
+  int             aidx = 0;
+
+  if (sax->stopped || sax->startcb == NULL) {
+    return;
+  }
+
+  /* the attributes are passed as localname/prefix/uri/value/end, */
+  /* and the value is not null terminated. */
+  /* convert to a null terminated list of name, value pairs */
+  tattrs = mdmalloc (sizeof (char *) * (nbattr * 2 + 1));
+  for (int i = 0; i < nbattr; ++i) {
+    const xmlChar   **attr = attrs + i * 5;
+    size_t          len;
+    char            *val;
+
+    len = attr [4] - attr [3];
+    val = mdmalloc (len + 1);
+    memcpy (val, attr [3], len);
+    val [len] = '\0';
+    tattrs [aidx++] = (const char *) attr [0];
+    tattrs [aidx++] = val;
+  }
+  tattrs [aidx] = NULL;
+
+  xmlParseSAXName (name, sizeof (name), localname, prefix);
+  sax->startcb (sax->udata, name, tattrs);
+
+  for (int i = 1; i < aidx; i += 2) {
+    mdfree ((char *) tattrs [i]);
+  }
+  mdfree (tattrs);
+}
+
+static void
+xmlParseSAXEnd (void *udata, const xmlChar *localname,
+    const xmlChar *prefix, const xmlChar *uri)
+{
+  xmlparsesax_t   *sax = udata;
+  char            name [200];
+
+  if (sax->stopped || sax->endcb == NULL) {
+    return;
+  }
+  xmlParseSAXName (name, sizeof (name), localname, prefix);
+  sax->endcb (sax->udata, name);
+}
+
+static void
+xmlParseSAXText (void *udata, const xmlChar *text, int len)
+{
+  xmlparsesax_t   *sax = udata;
+
+  if (sax->stopped || sax->textcb == NULL) {
+    return;
+  }
+  sax->textcb (sax->udata, (const char *) text, (size_t) len);
+}
+
+static void
+xmlParseSAXErrorHandler (void *udata, xmlErrorPtr xmlerr)
+{
+  xmlparsesax_t   *sax = udata;
+
+  if (xmlerr->level == XML_ERR_WARNING) {
+    return;
+  }
+  logMsg (LOG_DBG, LOG_INFO, "sax: line:%d col:%d err:%d %s",
+      xmlerr->line, xmlerr->int2, xmlerr->code, xmlerr->message);
+  if (sax != NULL && ! sax->stopped) {
+    sax->isvalid = false;
+  }
+}
+
+static void
+xmlParseSAXName (char *buff, size_t sz, const xmlChar *localname,
+    const xmlChar *prefix)
+{
+  char    *p = buff;
+  char    *end = buff + sz;
+
+  *buff = '\0';
+  if (prefix != NULL) {
+    p = stpecpy (p, end, (const char *) prefix);
+    p = stpecpy (p, end, ":");
+  }
+  stpecpy (p, end, (const char *) localname);
+}
@@ -9,6 +9,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include <inttypes.h>
+#include <math.h>
 
 #include "audioadjust.h"
 #include "audiofile.h"
@@ -54,12 +55,14 @@ typedef struct aa {
 } aa_t;
 
 enum {
+  AA_LOUDNESS_TARGET,
   AA_TRIMSILENCE_NOISE,
   AA_TRIMSILENCE_DURATION,
   AA_KEY_MAX,
 };
 
 static datafilekey_t aadfkeys [AA_KEY_MAX] = {
+  { "LOUDNESS_TARGET",        AA_LOUDNESS_TARGET,       VALUE_DOUBLE, NULL, DF_NORM },
   { "TRIMSILENCE_DURATION",   AA_TRIMSILENCE_DURATION,  VALUE_DOUBLE, NULL, DF_NORM },
   { "TRIMSILENCE_NOISE",      AA_TRIMSILENCE_NOISE,     VALUE_NUM,    NULL, DF_NORM },
 };
@@ -68,6 +71,19 @@ static const char * const SILENCE_START_STR = { "silence_start:" };
 static const char * const SILENCE_DUR_STR = { "silence_duration:" };
 #define SILENCE_START_LEN (strlen (SILENCE_START_STR))
 #define SILENCE_DUR_LEN (strlen (SILENCE_DUR_STR))
+static const char * const LOUD_SUMMARY_STR = { "Summary:" };
+static const char * const LOUD_INTEGRATED_STR = { "I:" };
+static const char * const LOUD_PEAK_STR = { "Peak:" };
+#define LOUD_INTEGRATED_LEN (strlen (LOUD_INTEGRATED_STR))
+#define LOUD_PEAK_LEN (strlen (LOUD_PEAK_STR))
+
+/* the default target loudness if the audioadjust.txt file is old */
+#define AA_LOUDNESS_TARGET_DFLT -18.0
+/* the maximum true peak allowed after the adjustment is applied */
+#define AA_LOUDNESS_PEAK_MAX -1.0
+/* limits for the suggested volume adjustment (matches the song editor) */
+#define AA_LOUDNESS_ADJ_MIN -50.0
+#define AA_LOUDNESS_ADJ_MAX 50.0
 
 
 static void aaApplySpeed (song_t *song, const char *infn, const char *outfn, int speed, int gap);
@@ -506,6 +522,137 @@ aaSilenceDetect (const char *infn, double *sstart, double *send)
   return rc;
 }
 
+/* aaLoudnessScan() does not access any of the data files, */
+/* and may be called from a thread. */
+int
+aaLoudnessScan (const char *infn, aaloudness_t *loudness)
+{
+  const char  *targv [40];
+  int         targc = 0;
+  int         rc;
+  mstime_t    etm;
+  char        *resp;
+  char        *p;
+
+  if (infn == NULL || loudness == NULL) {
+    return -1;
+  }
+
+  loudness->integrated = LIST_DOUBLE_INVALID;
+  loudness->truepeak = LIST_DOUBLE_INVALID;
+  loudness->adjustment = 0.0;
+  mstimestart (&etm);
+
+  targv [targc++] = sysvarsGetStr (SV_PATH_FFMPEG);
+  targv [targc++] = "-hide_banner";
+  targv [targc++] = "-nostats";
+  targv [targc++] = "-vn";
+  targv [targc++] = "-dn";
+  targv [targc++] = "-sn";
+
+  targv [targc++] = "-i";
+  targv [targc++] = infn;
+
+  /* the per-frame output is logged at the verbose level, */
+  /* only the summary is wanted */
+  targv [targc++] = "-af";
+  targv [targc++] = "ebur128=peak=true:framelog=verbose";
+
+  targv [targc++] = "-f";
+  targv [targc++] = "null";
+  targv [targc++] = "-";
+  targv [targc++] = NULL;
+
+  resp = mdmalloc (AA_RESP_BUFF_SZ);
+  rc = aaProcess ("aa-loudness", targv, targc, resp);
+
+  if (rc != 0) {
+    dataFree (resp);
+    return rc;
+  }
+
+  /* [Parsed_ebur128_0 @ 0x55b7d1e6c2c0] Summary: */
+  /*   Integrated loudness: */
+  /*     I:         -14.2 LUFS */
+  /*     Threshold: -24.6 LUFS */
+  /*   ... */
+  /*   True peak: */
+  /*     Peak:        0.4 dBFS */
+
+  p = strstr (resp, LOUD_SUMMARY_STR);
+  if (p != NULL) {
+    char    *tp;
+
+    tp = strstr (p, LOUD_INTEGRATED_STR);
+    if (tp != NULL) {
+      loudness->integrated = atof (tp + LOUD_INTEGRATED_LEN);
+    }
+    tp = strstr (p, LOUD_PEAK_STR);
+    if (tp != NULL) {
+      loudness->truepeak = atof (tp + LOUD_PEAK_LEN);
+    }
+  }
+
+  if (loudness->integrated == LIST_DOUBLE_INVALID) {
+    rc = -1;
+  }
+
+  logMsg (LOG_DBG, LOG_INFO, "aa-loudness: elapsed: %ld",
+      (long) mstimeend (&etm));
+  logMsg (LOG_DBG, LOG_INFO, "aa-loudness: %s I: %.1f peak: %.1f",
+      infn, loudness->integrated, loudness->truepeak);
+
+  dataFree (resp);
+  return rc;
+}
+
+/* calculates the suggested volume adjustment percentage */
+/* so that the song will play at the target loudness */
+void
+aaLoudnessCalcAdjustment (aaloudness_t *loudness)
+{
+  aa_t    *aa;
+  double  target = AA_LOUDNESS_TARGET_DFLT;
+  double  gain;
+  double  adj;
+
+  if (loudness == NULL) {
+    return;
+  }
+
+  loudness->adjustment = 0.0;
+  if (loudness->integrated == LIST_DOUBLE_INVALID) {
+    return;
+  }
+
+  aa = bdjvarsdfGet (BDJVDF_AUDIO_ADJUST);
+  if (aa != NULL) {
+    double  tval;
+
+    tval = nlistGetDouble (aa->values, AA_LOUDNESS_TARGET);
+    if (tval != LIST_DOUBLE_INVALID) {
+      target = tval;
+    }
+  }
+
+  gain = target - loudness->integrated;
+  /* do not let the adjustment push the peak into clipping */
+  if (loudness->truepeak != LIST_DOUBLE_INVALID &&
+      loudness->truepeak + gain > AA_LOUDNESS_PEAK_MAX) {
+    gain = AA_LOUDNESS_PEAK_MAX - loudness->truepeak;
+  }
+
+  /* the volume adjustment is a percentage of the current volume */
+  adj = (pow (10.0, gain / 20.0) - 1.0) * 100.0;
+  if (adj < AA_LOUDNESS_ADJ_MIN) {
+    adj = AA_LOUDNESS_ADJ_MIN;
+  }
+  if (adj > AA_LOUDNESS_ADJ_MAX) {
+    adj = AA_LOUDNESS_ADJ_MAX;
+  }
+  loudness->adjustment = round (adj * 10.0) / 10.0;
+}
+
 /* internal routines */
 
 static void
@@ -32,18 +32,47 @@
 #include "log.h"
 #include "musicdb.h"
 #include "pathbld.h"
+#include "songlistidx.h"
 #include "osrandom.h"
 #include "osdirutil.h"
 #include "sysvars.h"
 #include "tagdef.h"
 #include "tmutil.h"
 
+/* startup phases, the time spent in each is logged */
+enum {
+  BDJ4_INIT_PH_SYSVARS,
+  BDJ4_INIT_PH_LOCALE,
+  BDJ4_INIT_PH_LOCK,
+  BDJ4_INIT_PH_BDJOPT,
+  BDJ4_INIT_PH_DATAFILE,
+  BDJ4_INIT_PH_TAGS,
+  BDJ4_INIT_PH_DB,
+  BDJ4_INIT_PH_MAX,
+};
+
+static const char *bdj4initphasedesc [BDJ4_INIT_PH_MAX] = {
+  [BDJ4_INIT_PH_SYSVARS] = "sysvars",
+  [BDJ4_INIT_PH_LOCALE] = "locale",
+  [BDJ4_INIT_PH_LOCK] = "lock",
+  [BDJ4_INIT_PH_BDJOPT] = "bdjopt",
+  [BDJ4_INIT_PH_DATAFILE] = "datafile",
+  [BDJ4_INIT_PH_TAGS] = "tags",
+  [BDJ4_INIT_PH_DB] = "db",
+};
+
+static time_t bdj4initphasetm [BDJ4_INIT_PH_MAX];
+
+static void bdj4initPhaseEnd (int phase, mstime_t *pmt);
+static void bdj4initPhaseLog (void);
+
 loglevel_t
 bdj4startup (int argc, char *argv[], musicdb_t **musicdb,
     char *tag, bdjmsgroute_t route, uint32_t *flags)
 {
   mstime_t    mt;
   mstime_t    dbmt;
+  mstime_t    pmt;
   int         c = 0;
   int         rc = 0;
   int         count = 0;
@@ -102,6 +131,8 @@ bdj4startup (int argc, char *argv[], musicdb_t **musicdb,
     { "rebuild",        no_argument,        NULL,   'R' },
     { "checknew",       no_argument,        NULL,   'C' },
     { "compact",        no_argument,        NULL,   127 },
+    { "loudness",       no_argument,        NULL,   126 },
+    { "bpm",            no_argument,        NULL,   125 },
     { "musicdir",       required_argument,  NULL,   'D' },
     { "reorganize",     no_argument,        NULL,   'O' },
     { "updfromtags",    no_argument,        NULL,   'u' },
@@ -125,11 +156,23 @@ bdj4startup (int argc, char *argv[], musicdb_t **musicdb,
   bdj4arg = bdj4argInit (argc, argv);
 
   mstimestart (&mt);
+  mstimestart (&pmt);
+  for (int i = 0; i < BDJ4_INIT_PH_MAX; ++i) {
+    bdj4initphasetm [i] = 0;
+  }
   sRandom ();
   targ = bdj4argGet (bdj4arg, 0, argv [0]);
-  sysvarsInit (targ, SYSVARS_FLAG_ALL);
+  /* the starter re-probes the environment and saves the probe cache */
+  /* for use by the other processes */
+  if (route == ROUTE_STARTERUI) {
+    sysvarsInit (targ, SYSVARS_FLAG_PROBE);
+  } else {
+    sysvarsInit (targ, SYSVARS_FLAG_ALL);
+  }
+  bdj4initPhaseEnd (BDJ4_INIT_PH_SYSVARS, &pmt);
   localeInit ();
   bdjvarsInit ();
+  bdj4initPhaseEnd (BDJ4_INIT_PH_LOCALE, &pmt);
 
   optind = 0;
   while ((c = getopt_long_only (argc, bdj4argGetArgv (bdj4arg),
@@ -199,6 +242,14 @@ bdj4startup (int argc, char *argv[], musicdb_t **musicdb,
         *flags |= BDJ4_ARG_DB_COMPACT;
         break;
       }
+      case 126: {
+        *flags |= BDJ4_ARG_DB_LOUDNESS;
+        break;
+      }
+      case 125: {
+        *flags |= BDJ4_ARG_DB_BPM;
+        break;
+      }
       case 'P': {
         *flags |= BDJ4_ARG_PROGRESS;
         break;
@@ -323,6 +374,7 @@ bdj4startup (int argc, char *argv[], musicdb_t **musicdb,
 
   bdjvarsUpdateData ();
 
+  mstimestart (&pmt);
   if ((*flags & BDJ4_INIT_NO_LOCK) != BDJ4_INIT_NO_LOCK) {
     rc = lockAcquire (lockName (route), PATHBLD_MP_USEIDX);
     count = 0;
@@ -336,6 +388,7 @@ bdj4startup (int argc, char *argv[], musicdb_t **musicdb,
       rc = lockAcquire (lockName (route), PATHBLD_MP_USEIDX);
     }
   }
+  bdj4initPhaseEnd (BDJ4_INIT_PH_LOCK, &pmt);
 
   if (fileopIsDirectory (sysvarsGetStr (SV_BDJ4_DIR_DATATOP))) {
     if (osChangeDir (sysvarsGetStr (SV_BDJ4_DIR_DATATOP)) < 0) {
@@ -351,6 +404,7 @@ bdj4startup (int argc, char *argv[], musicdb_t **musicdb,
   }
 
   bdjoptInit ();
+  bdj4initPhaseEnd (BDJ4_INIT_PH_BDJOPT, &pmt);
 
   if (! loglevelset) {
     loglevel = bdjoptGetNum (OPT_G_DEBUGLVL);
@@ -373,6 +427,7 @@ bdj4startup (int argc, char *argv[], musicdb_t **musicdb,
     logMsg (LOG_SESS, LOG_IMPORTANT, "locale-system: %s", sysvarsGetStr (SV_LOCALE_SYSTEM));
   }
 
+  mstimestart (&pmt);
   if (fileopIsDirectory (sysvarsGetStr (SV_BDJ4_DIR_DATATOP))) {
     if ((*flags & BDJ4_INIT_NO_DATAFILE_LOAD) != BDJ4_INIT_NO_DATAFILE_LOAD) {
       rc = bdjvarsdfloadInit ();
@@ -384,11 +439,14 @@ bdj4startup (int argc, char *argv[], musicdb_t **musicdb,
     }
   }
 
+  bdj4initPhaseEnd (BDJ4_INIT_PH_DATAFILE, &pmt);
+
   bdjoptSetNum (OPT_G_DEBUGLVL, loglevel);
 
   tagdefInit ();
   audiotagInit ();
   audiosrcInit ();
+  bdj4initPhaseEnd (BDJ4_INIT_PH_TAGS, &pmt);
 
   if ((*flags & BDJ4_INIT_NO_DB_LOAD) != BDJ4_INIT_NO_DB_LOAD &&
       musicdb != NULL) {
@@ -399,6 +457,8 @@ bdj4startup (int argc, char *argv[], musicdb_t **musicdb,
     *musicdb = dbOpen (tbuff);
     logMsg (LOG_SESS, LOG_IMPORTANT, "database read: %" PRId32 " items in %" PRId64 " ms", dbCount(*musicdb), (int64_t) mstimeend (&dbmt));
   }
+  bdj4initPhaseEnd (BDJ4_INIT_PH_DB, &pmt);
+  bdj4initPhaseLog ();
   logMsg (LOG_SESS, LOG_IMPORTANT, "total init time: %" PRId64 " ms", (int64_t) mstimeend (&mt));
 
   bdj4argCleanup (bdj4arg);
@@ -461,6 +521,7 @@ bdj4shutdown (bdjmsgroute_t route, musicdb_t *musicdb)
   audiotagCleanup ();
   bdjvarsCleanup ();
   localeCleanup ();
+  songlistidxCleanup ();
   logMsg (LOG_SESS, LOG_IMPORTANT, "init cleanup time: %" PRId64 " ms", (int64_t) mstimeend (&mt));
   if (route != ROUTE_NONE) {
     lockRelease (lockName (route), PATHBLD_MP_USEIDX);
@@ -468,3 +529,32 @@ bdj4shutdown (bdjmsgroute_t route, musicdb_t *musicdb)
   logProcEnd ("");
 }
 
+
+/* internal routines */
+
+static void
+bdj4initPhaseEnd (int phase, mstime_t *pmt)
+{
+  bdj4initphasetm [phase] += mstimeend (pmt);
+  mstimestart (pmt);
+}
+
+static void
+bdj4initPhaseLog (void)
+{
+  char    tbuff [200];
+  char    *p;
+  char    *end;
+
+  p = tbuff;
+  end = tbuff + sizeof (tbuff);
+  *tbuff = '\0';
+  for (int i = 0; i < BDJ4_INIT_PH_MAX; ++i) {
+    char    tmp [40];
+
+    snprintf (tmp, sizeof (tmp), " %s: %" PRId64,
+        bdj4initphasedesc [i], (int64_t) bdj4initphasetm [i]);
+    p = stpecpy (p, end, tmp);
+  }
+  logMsg (LOG_SESS, LOG_IMPORTANT, "init phases (ms):%s", tbuff);
+}
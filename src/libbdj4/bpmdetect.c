@@ -0,0 +1,366 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+/*
+ * tempo detection
+ *
+ * The audio is decoded to mono 16-bit PCM using ffmpeg.
+ * An onset envelope is built from the rise in the short-term energy,
+ * and the autocorrelation of the envelope is searched for the
+ * strongest beat period within the allowed BPM range.
+ *
+ * The routines do not access any of the data files, and may be
+ * run in a separate thread (excepting bpmdetectDanceRange()).
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "bdj4.h"
+#include "bdjvarsdf.h"
+#include "bpmdetect.h"
+#include "dance.h"
+#include "ilist.h"
+#include "log.h"
+#include "mdebug.h"
+#include "osprocess.h"
+#include "sysvars.h"
+#include "tmutil.h"
+
+enum {
+  /* envelope frames per second */
+  BPMDETECT_FPS = 200,
+  /* only the beginning of the song is analyzed */
+  BPMDETECT_MAX_SECONDS = 120,
+  /* a minimum amount of audio is needed for a useful result */
+  BPMDETECT_MIN_SECONDS = 4,
+};
+
+/* a peak at a shorter period that is nearly as strong as the best */
+/* peak is preferred, otherwise the result is often half-time */
+#define BPMDETECT_PEAK_RATIO 0.85
+/* the dance ranges are nominal, allow some leeway */
+#define BPMDETECT_RANGE_LEEWAY 0.05
+
+static double bpmdetectAutocorr (const double *onset, size_t nframes, int lag);
+
+int
+bpmdetectFile (const char *ffn, int bpmlow, int bpmhigh, bpmdetect_t *result)
+{
+  const char  *targv [30];
+  int         targc = 0;
+  char        tbuff [40];
+  char        rbuff [40];
+  char        *pcm;
+  size_t      sz;
+  size_t      retsz = 0;
+  int         rc;
+  mstime_t    etm;
+
+  if (ffn == NULL || result == NULL) {
+    return -1;
+  }
+
+  result->bpm = 0;
+  result->confidence = 0;
+  mstimestart (&etm);
+
+  snprintf (tbuff, sizeof (tbuff), "%d", BPMDETECT_MAX_SECONDS);
+  snprintf (rbuff, sizeof (rbuff), "%d", BPMDETECT_RATE);
+
+  targv [targc++] = sysvarsGetStr (SV_PATH_FFMPEG);
+  targv [targc++] = "-hide_banner";
+  targv [targc++] = "-nostats";
+  targv [targc++] = "-loglevel";
+  targv [targc++] = "quiet";
+  targv [targc++] = "-vn";
+  targv [targc++] = "-dn";
+  targv [targc++] = "-sn";
+  targv [targc++] = "-i";
+  targv [targc++] = ffn;
+  targv [targc++] = "-t";
+  targv [targc++] = tbuff;
+  targv [targc++] = "-ac";
+  targv [targc++] = "1";
+  targv [targc++] = "-ar";
+  targv [targc++] = rbuff;
+  targv [targc++] = "-f";
+  targv [targc++] = "s16le";
+  targv [targc++] = "-";
+  targv [targc++] = NULL;
+
+  sz = (size_t) BPMDETECT_MAX_SECONDS * BPMDETECT_RATE * sizeof (int16_t);
+  /* room for the null byte added by osProcessPipe() */
+  pcm = mdmalloc (sz + 1);
+  rc = osProcessPipe (targv,
+      OS_PROC_WAIT | OS_PROC_DETACH | OS_PROC_NOSTDERR, pcm, sz + 1, &retsz);
+  if (retsz > sz) {
+    retsz = sz;
+  }
+
+  if (rc != 0 || retsz == 0) {
+    logMsg (LOG_DBG, LOG_IMPORTANT, "bpm-detect: decode failed %s rc:%d", ffn, rc);
+    mdfree (pcm);
+    return -1;
+  }
+
+  bpmdetectPCM ((const int16_t *) pcm, retsz / sizeof (int16_t),
+      BPMDETECT_RATE, bpmlow, bpmhigh, result);
+  mdfree (pcm);
+
+  logMsg (LOG_DBG, LOG_INFO, "bpm-detect: elapsed: %ld",
+      (long) mstimeend (&etm));
+  logMsg (LOG_DBG, LOG_INFO, "bpm-detect: %s bpm: %d conf: %d",
+      ffn, result->bpm, result->confidence);
+
+  if (result->bpm <= 0) {
+    return -1;
+  }
+  return 0;
+}
+
+void
+bpmdetectPCM (const int16_t *pcm, size_t count, int rate,
+    int bpmlow, int bpmhigh, bpmdetect_t *result)
+{
+  size_t    hop;
+  size_t    nframes;
+  double    fps;
+  double    *onset;
+  double    *ac;
+  double    prev;
+  double    mean;
+  double    ac0;
+  double    maxac;
+  double    lagf;
+  double    conf;
+  int       lagmin;
+  int       lagmax;
+  int       best;
+
+  if (result == NULL) {
+    return;
+  }
+
+  result->bpm = 0;
+  result->confidence = 0;
+
+  if (pcm == NULL || rate <= 0) {
+    return;
+  }
+
+  if (bpmlow <= 0) {
+    bpmlow = BPMDETECT_BPM_LOW;
+  }
+  if (bpmhigh <= 0 || bpmhigh < bpmlow) {
+    bpmhigh = BPMDETECT_BPM_HIGH;
+  }
+
+  hop = rate / BPMDETECT_FPS;
+  if (hop < 1) {
+    return;
+  }
+  fps = (double) rate / (double) hop;
+  nframes = count / hop;
+  if (nframes < (size_t) (fps * BPMDETECT_MIN_SECONDS)) {
+    return;
+  }
+
+  /* the onset envelope is the rise in the compressed energy */
+  /* from one frame to the next */
+  onset = mdmalloc (sizeof (double) * nframes);
+  prev = 0.0;
+  mean = 0.0;
+  for (size_t i = 0; i < nframes; ++i) {
+    double    energy = 0.0;
+    double    val;
+    size_t    beg;
+    size_t    end;
+
+    beg = i * hop;
+    end = beg + hop * 2;
+    if (end > count) {
+      end = count;
+    }
+    for (size_t j = beg; j < end; ++j) {
+      val = (double) pcm [j] / 32768.0;
+      energy += val * val;
+    }
+    energy /= (double) (end - beg);
+    val = log1p (1000.0 * energy);
+
+    onset [i] = val - prev;
+    if (onset [i] < 0.0) {
+      onset [i] = 0.0;
+    }
+    prev = val;
+    mean += onset [i];
+  }
+
+  mean /= (double) nframes;
+  for (size_t i = 0; i < nframes; ++i) {
+    onset [i] -= mean;
+  }
+
+  lagmin = (int) floor (60.0 * fps / (double) bpmhigh);
+  lagmax = (int) ceil (60.0 * fps / (double) bpmlow);
+  if (lagmin < 2) {
+    lagmin = 2;
+  }
+  if (lagmax > (int) nframes / 2) {
+    lagmax = (int) nframes / 2;
+  }
+  if (lagmax <= lagmin) {
+    mdfree (onset);
+    return;
+  }
+
+  /* one extra on each side for the interpolation */
+  ac = mdmalloc (sizeof (double) * (lagmax + 2));
+  ac0 = bpmdetectAutocorr (onset, nframes, 0);
+  maxac = -1.0e30;
+  mean = 0.0;
+  for (int lag = lagmin - 1; lag <= lagmax + 1; ++lag) {
+    ac [lag] = bpmdetectAutocorr (onset, nframes, lag);
+    if (lag >= lagmin && lag <= lagmax) {
+      mean += ac [lag];
+      if (ac [lag] > maxac) {
+        maxac = ac [lag];
+      }
+    }
+  }
+  mean /= (double) (lagmax - lagmin + 1);
+
+  if (ac0 <= 0.0 || maxac <= 0.0) {
+    mdfree (ac);
+    mdfree (onset);
+    return;
+  }
+
+  /* choose the shortest period that is a local peak and is nearly */
+  /* as strong as the maximum */
+  best = -1;
+  for (int lag = lagmin; lag <= lagmax; ++lag) {
+    if (ac [lag] >= ac [lag - 1] &&
+        ac [lag] >= ac [lag + 1] &&
+        ac [lag] >= maxac * BPMDETECT_PEAK_RATIO) {
+      best = lag;
+      break;
+    }
+  }
+  if (best < 0) {
+    mdfree (ac);
+    mdfree (onset);
+    return;
+  }
+
+  /* parabolic interpolation for a fractional period */
+  lagf = (double) best;
+  {
+    double    a, b, c;
+    double    denom;
+
+    a = ac [best - 1];
+    b = ac [best];
+    c = ac [best + 1];
+    denom = a - 2.0 * b + c;
+    if (denom < 0.0) {
+      lagf += 0.5 * (a - c) / denom;
+    }
+  }
+
+  result->bpm = (int) round (60.0 * fps / lagf);
+  if (result->bpm < bpmlow) {
+    result->bpm = bpmlow;
+  }
+  if (result->bpm > bpmhigh) {
+    result->bpm = bpmhigh;
+  }
+
+  conf = 0.0;
+  if (ac0 > mean) {
+    conf = (ac [best] - mean) / (ac0 - mean);
+  }
+  if (conf < 0.0) {
+    conf = 0.0;
+  }
+  if (conf > 1.0) {
+    conf = 1.0;
+  }
+  result->confidence = (int) round (conf * 100.0);
+
+  mdfree (ac);
+  mdfree (onset);
+}
+
+/* returns the expected bpm range for the dance. */
+/* if there is no dance, or the dance has no range set, */
+/* the default range is returned */
+void
+bpmdetectDanceRange (ilistidx_t danceidx, int *bpmlow, int *bpmhigh)
+{
+  dance_t     *dances;
+  int         timesig;
+  int         mpmlow;
+  int         mpmhigh;
+
+  *bpmlow = BPMDETECT_BPM_LOW;
+  *bpmhigh = BPMDETECT_BPM_HIGH;
+
+  if (danceidx < 0) {
+    return;
+  }
+
+  dances = bdjvarsdfGet (BDJVDF_DANCES);
+  if (dances == NULL) {
+    return;
+  }
+
+  mpmlow = danceGetNum (dances, danceidx, DANCE_MPM_LOW);
+  mpmhigh = danceGetNum (dances, danceidx, DANCE_MPM_HIGH);
+  if (mpmlow <= 0 || mpmhigh <= 0 || mpmhigh < mpmlow) {
+    return;
+  }
+
+  timesig = danceGetTimeSignature (danceidx);
+  *bpmlow = (int) floor ((double) (mpmlow * danceTimesigValues [timesig]) *
+      (1.0 - BPMDETECT_RANGE_LEEWAY));
+  *bpmhigh = (int) ceil ((double) (mpmhigh * danceTimesigValues [timesig]) *
+      (1.0 + BPMDETECT_RANGE_LEEWAY));
+}
+
+/* internal routines */
+
+static double
+bpmdetectAutocorr (const double *onset, size_t nframes, int lag)
+{
+  double    sum = 0.0;
+  size_t    n;
+
+  n = nframes - lag;
+  for (size_t i = 0; i < n; ++i) {
+    sum += onset [i] * onset [i + lag];
+  }
+
+  return sum / (double) n;
+}
+
+/* the detected tempo is in beats per minute, the bpm tag holds */
+/* measures per minute */
+int
+bpmdetectToMPM (ilistidx_t danceidx, int bpm)
+{
+  int     timesig;
+
+  if (danceidx < 0 || bpm <= 0) {
+    return bpm;
+  }
+
+  timesig = danceGetTimeSignature (danceidx);
+  return (int) ((double) bpm / (double) danceTimesigValues [timesig]);
+}
@@ -30,6 +30,21 @@ typedef struct {
   ilistidx_t    danceIdx;
 } playedDance_t;
 
+/* the per-dance values are computed once when the dancesel is allocated */
+typedef struct {
+  ilistidx_t    didx;
+  nlistidx_t    count;
+  bool          fast;
+  /* windowed */
+  double        winsize;
+  double        wdecrement;
+  bool          winEarlySel;
+  bool          winRetry;
+  /* indexed by the dance index of the previous or prior dance */
+  double        *prevadj;
+  bool          *tagmatch;
+} danceselent_t;
+
 #define DANCESEL_DEBUG 0
 
 typedef struct dancesel {
@@ -40,18 +55,27 @@ typedef struct dancesel {
   void          *userdata;
   /* all methods */
   double        basetotal;
-  nlist_t       *base;
-  nlist_t       *adjustBase;
-  nlist_t       *danceProbTable;
+  danceselent_t *dtab;
+  int           dcount;
+  /* indexed by dance index */
+  ilistidx_t    dmax;
+  bool          *dfast;
+  /* re-used for each selection, indexed by dtab position */
+  double        *tbase;
+  double        *adjust;
+  /* re-used for each selection, indexed by history distance */
+  ilistidx_t    *prior;
+  double        *histadj;
   dbidx_t       selCount;
-  /* windowed probability tables */
-  nlist_t       *winsize;
-  nlist_t       *wdecrement;
-  nlist_t       *winEarlySel;
   /* played */
   queue_t       *playedDances;
   /* autosel variables that will be used */
   nlistidx_t    histDistance;
+  nlistidx_t    begCount;
+  double        begFast;
+  double        fastBoth;
+  double        fastPrior;
+  double        typeMatch;
   double        prevTagMatch;
   double        priorExp;
   double        tagMatch;
@@ -62,15 +86,17 @@ typedef struct dancesel {
 } dancesel_t;
 
 static void   danceselPlayedFree (void *data);
-static bool   danceselProcessPrior (dancesel_t *dancesel,
-                    ilistidx_t didx, ilistidx_t priordidx, ilistidx_t dist,
-                    slist_t *tags, bool match);
+static void   danceselInitTables (dancesel_t *dancesel, nlist_t *countList);
+static double danceselAdjust (dancesel_t *dancesel, danceselent_t *ent,
+                    ilistidx_t pddanceIdx, ilistidx_t priorcount);
 static bool   danceselMatchTag (slist_t *tags, slist_t *otags);
 static bool   danceselGetPriorInfo (dancesel_t *dancesel,
                     ilistidx_t queueCount, ilistidx_t prioridx,
                     ilistidx_t *pddanceIdx);
+static ilistidx_t danceselValidIdx (dancesel_t *dancesel, ilistidx_t didx);
 
 /* windowed */
+static double danceselWindowBase (dancesel_t *dancesel, danceselent_t *ent);
 static void   danceselInitWindowSizes (dancesel_t *dancesel);
 static void   danceselInitDecrement (dancesel_t *dancesel);
 
@@ -81,8 +107,6 @@ danceselAlloc (nlist_t *countList,
     danceselQueueLookup_t queueLookupProc, void *userdata)
 {
   dancesel_t  *dancesel;
-  ilistidx_t  didx;
-  nlistidx_t  iteridx;
 
 
   if (countList == NULL) {
@@ -97,18 +121,18 @@ danceselAlloc (nlist_t *countList,
   dancesel->dances = bdjvarsdfGet (BDJVDF_DANCES);
   dancesel->autosel = bdjvarsdfGet (BDJVDF_AUTO_SEL);
 
-  dancesel->base = nlistAlloc ("dancesel-base", LIST_ORDERED, NULL);
   dancesel->basetotal = 0.0;
-  dancesel->adjustBase = NULL;
-  dancesel->danceProbTable = NULL;
+  dancesel->dtab = NULL;
+  dancesel->dcount = 0;
+  dancesel->dmax = 0;
+  dancesel->dfast = NULL;
+  dancesel->tbase = NULL;
+  dancesel->adjust = NULL;
+  dancesel->prior = NULL;
+  dancesel->histadj = NULL;
   dancesel->queueLookupProc = queueLookupProc;
   dancesel->userdata = userdata;
 
-  /* windowed */
-  dancesel->winsize = nlistAlloc ("dancesel-winsize", LIST_ORDERED, NULL);
-  dancesel->wdecrement = nlistAlloc ("dancesel-w-decrement", LIST_ORDERED, NULL);
-  dancesel->winEarlySel = nlistAlloc ("dancesel-w-early-sel", LIST_ORDERED, NULL);
-
   /* selected */
   dancesel->selCount = 0;
 
@@ -117,6 +141,11 @@ danceselAlloc (nlist_t *countList,
 
   /* autosel variables that will be used */
   dancesel->histDistance = autoselGetNum (dancesel->autosel, AUTOSEL_HIST_DISTANCE);
+  dancesel->begCount = autoselGetNum (dancesel->autosel, AUTOSEL_BEG_COUNT);
+  dancesel->begFast = autoselGetDouble (dancesel->autosel, AUTOSEL_BEG_FAST);
+  dancesel->fastBoth = autoselGetDouble (dancesel->autosel, AUTOSEL_FAST_BOTH);
+  dancesel->fastPrior = autoselGetDouble (dancesel->autosel, AUTOSEL_FAST_PRIOR);
+  dancesel->typeMatch = autoselGetDouble (dancesel->autosel, AUTOSEL_TYPE_MATCH);
   dancesel->prevTagMatch = autoselGetDouble (dancesel->autosel, AUTOSEL_PREV_TAGMATCH);
   dancesel->tagMatch = autoselGetDouble (dancesel->autosel, AUTOSEL_TAGMATCH);
   dancesel->priorExp = autoselGetDouble (dancesel->autosel, AUTOSEL_PRIOR_EXP);
@@ -124,30 +153,16 @@ danceselAlloc (nlist_t *countList,
   dancesel->windowedDiffA = autoselGetDouble (dancesel->autosel, AUTOSEL_WINDOWED_DIFF_A);
   dancesel->windowedDiffB = autoselGetDouble (dancesel->autosel, AUTOSEL_WINDOWED_DIFF_B);
   dancesel->windowedDiffC = autoselGetDouble (dancesel->autosel, AUTOSEL_WINDOWED_DIFF_C);
+  if (dancesel->histDistance < 0) {
+    dancesel->histDistance = 0;
+  }
 
   logMsg (LOG_DBG, LOG_DANCESEL, "countlist: %" PRId32, nlistGetCount (countList));
 #if DANCESEL_DEBUG
   fprintf (stderr, "countlist: %" PRId32 "\n", nlistGetCount (countList));
 #endif
 
-  nlistStartIterator (countList, &iteridx);
-  while ((didx = nlistIterateKey (countList, &iteridx)) >= 0) {
-    nlistidx_t  count;
-
-    count = nlistGetNum (countList, didx);
-    if (count <= 0) {
-      continue;
-    }
-
-    nlistSetNum (dancesel->base, didx, count);
-    dancesel->basetotal += (double) count;
-    logMsg (LOG_DBG, LOG_DANCESEL, "base: %" PRId32 "/%s: %" PRId32, didx,
-        danceGetStr (dancesel->dances, didx, DANCE_DANCE), count);
-#if DANCESEL_DEBUG
-    fprintf (stderr, "base: %" PRId32 "/%s: %" PRId32 "\n", didx,
-        danceGetStr (dancesel->dances, didx, DANCE_DANCE), count);
-#endif
-  }
+  danceselInitTables (dancesel, countList);
 
   if (dancesel->method == DANCESEL_METHOD_WINDOWED) {
     danceselInitWindowSizes (dancesel);
@@ -163,14 +178,17 @@ danceselFree (dancesel_t *dancesel)
 {
   logProcBegin ();
   if (dancesel != NULL) {
-    nlistFree (dancesel->base);
-    nlistFree (dancesel->adjustBase);
-    nlistFree (dancesel->danceProbTable);
+    for (int i = 0; i < dancesel->dcount; ++i) {
+      dataFree (dancesel->dtab [i].prevadj);
+      dataFree (dancesel->dtab [i].tagmatch);
+    }
+    dataFree (dancesel->dtab);
+    dataFree (dancesel->dfast);
+    dataFree (dancesel->tbase);
+    dataFree (dancesel->adjust);
+    dataFree (dancesel->prior);
+    dataFree (dancesel->histadj);
     queueFree (dancesel->playedDances);
-    /* windowed */
-    nlistFree (dancesel->winsize);
-    nlistFree (dancesel->wdecrement);
-    nlistFree (dancesel->winEarlySel);
     mdfree (dancesel);
   }
   logProcEnd ("");
@@ -180,16 +198,26 @@ danceselFree (dancesel_t *dancesel)
 void
 danceselDecrementBase (dancesel_t *dancesel, ilistidx_t danceIdx)
 {
+  danceselent_t *ent = NULL;
+
   if (danceIdx < 0 || dancesel == NULL || dancesel->playedDances == NULL) {
     return;
   }
 
   /* all methods */
-  nlistDecrement (dancesel->base, danceIdx);
+  for (int i = 0; i < dancesel->dcount; ++i) {
+    if (dancesel->dtab [i].didx == danceIdx) {
+      ent = &dancesel->dtab [i];
+      break;
+    }
+  }
+  if (ent != NULL) {
+    ent->count -= 1;
+  }
   dancesel->basetotal -= 1.0;
-  logMsg (LOG_DBG, LOG_DANCESEL, "decrement %" PRId32 "/%s now %" PRId64 " total %.0f",
+  logMsg (LOG_DBG, LOG_DANCESEL, "decrement %" PRId32 "/%s now %" PRId32 " total %.0f",
       danceIdx, danceGetStr (dancesel->dances, danceIdx, DANCE_DANCE),
-      nlistGetNum (dancesel->base, danceIdx), dancesel->basetotal);
+      ent == NULL ? 0 : ent->count, dancesel->basetotal);
 
   /* base and basetotal are already decremented */
   if (dancesel->method == DANCESEL_METHOD_WINDOWED) {
@@ -207,27 +235,21 @@ danceselAddCount (dancesel_t *dancesel, ilistidx_t danceIdx)
   ++dancesel->selCount;
 
   if (dancesel->method == DANCESEL_METHOD_WINDOWED) {
-    nlistidx_t    iteridx;
-    ilistidx_t    didx;
-
     /* the selected dance decrement is increased */
     /* any dance with a positive decrement is increased */
 
-    nlistStartIterator (dancesel->base, &iteridx);
-    while ((didx = nlistIterateKey (dancesel->base, &iteridx)) >= 0) {
-      double    dval;
+    for (int i = 0; i < dancesel->dcount; ++i) {
+      danceselent_t   *ent = &dancesel->dtab [i];
 
-      dval = nlistGetDouble (dancesel->wdecrement, didx);
-      if (dval > 0.0 || didx == danceIdx) {
-        dval += 1.0;
-        nlistSetDouble (dancesel->wdecrement, didx, dval);
+      if (ent->wdecrement > 0.0 || ent->didx == danceIdx) {
+        ent->wdecrement += 1.0;
         logMsg (LOG_DBG, LOG_DANCESEL, "win: decrement %" PRId32 "/%s %.2f",
-            didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE),
-            nlistGetDouble (dancesel->wdecrement, didx));
+            ent->didx, danceGetStr (dancesel->dances, ent->didx, DANCE_DANCE),
+            ent->wdecrement);
 #if DANCESEL_DEBUG
         fprintf (stderr, "win: decrement %" PRId32 "/%s %.2f\n",
-            didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE),
-            nlistGetDouble (dancesel->wdecrement, didx));
+            ent->didx, danceGetStr (dancesel->dances, ent->didx, DANCE_DANCE),
+            ent->wdecrement);
 #endif
       }
     }
@@ -258,48 +280,25 @@ ilistidx_t
 danceselSelect (dancesel_t *dancesel, ilistidx_t queueCount)
 {
   ilistidx_t    didx;
-  double        tbase;
-  double        tprob;
-  double        abase;
-  nlistidx_t    iteridx;
-  int           countAvailable;
-  int           countTries;
-  /* current dance values */
-  slist_t       *tags = NULL;
-  int           speed;
-  int           type;
-  /* previous dance data */
   ilistidx_t    pddanceIdx;
-  slist_t       *pdtags = NULL;
-  int           pdspeed = 0;
-  int           pdtype = 0;
-  /* queued dances */
   ilistidx_t    queueIdx;
-  ilistidx_t    priordidx;        // prior dance index
   ilistidx_t    queueDist;
-  ilistidx_t    chkdist;
-  bool          priorLookupDone;
-  /* probability calculation */
-  double        adjTotal;
+  ilistidx_t    priorcount;
+  double        total;
+  double        tprob;
   double        tval;
 
 
   logProcBegin ();
-  nlistFree (dancesel->adjustBase);
-  nlistFree (dancesel->danceProbTable);
-  dancesel->adjustBase = nlistAlloc ("dancesel-adjust-base", LIST_ORDERED, NULL);
-  dancesel->danceProbTable = nlistAlloc ("dancesel-prob-table", LIST_ORDERED, NULL);
 
   /* data from the previous dance */
 
   danceselGetPriorInfo (dancesel, queueCount, queueCount - 1, &pddanceIdx);
+  pddanceIdx = danceselValidIdx (dancesel, pddanceIdx);
 
   if (pddanceIdx >= 0) {
     logMsg (LOG_DBG, LOG_DANCESEL, "found previous dance %" PRId32 "/%s", pddanceIdx,
         danceGetStr (dancesel->dances, pddanceIdx, DANCE_DANCE));
-    pdspeed = danceGetNum (dancesel->dances, pddanceIdx, DANCE_SPEED);
-    pdtags = danceGetList (dancesel->dances, pddanceIdx, DANCE_TAGS);
-    pdtype = danceGetNum (dancesel->dances, pddanceIdx, DANCE_TYPE);
 #if DANCESEL_DEBUG
     fprintf (stderr, "  get previous dance: %" PRId32 "/%s\n", pddanceIdx,
         danceGetStr (dancesel->dances, pddanceIdx, DANCE_DANCE));
@@ -308,257 +307,113 @@ danceselSelect (dancesel_t *dancesel, ilistidx_t queueCount)
     logMsg (LOG_DBG, LOG_DANCESEL, "  no previous dance");
   }
 
-  countAvailable = 0;
-  /* countTries is used to adjust the percentages to prevent starvation, */
-  /* and it is also used to prevent an infinite loop. */
-  countTries = 0;
-  while (countAvailable == 0 && countTries < 200) {
-    nlistStartIterator (dancesel->base, &iteridx);
-    while ((didx = nlistIterateKey (dancesel->base, &iteridx)) >= 0) {
-
-      /* if re-trying, give all dances a small chance, and */
-      /* raise the chance as the number of tries goes up. */
-      /* the prevents starvation when the possibilities become low */
-      tbase = countTries * 0.1;
-
-      /* at this time, only the 'windowed' method is implemented. */
-      /* there was a (more complicated) 'expected-count' method, */
-      /* but it has been removed. */
-
-      /* 'windowed' is a re-write of 'expected-count' that removed */
-      /* a lot of complexity. */
-
-      if (dancesel->method == DANCESEL_METHOD_WINDOWED) {
-        double    twinsz;
-        double    diff;
-        double    dec;
-
-        twinsz = nlistGetDouble (dancesel->winsize, didx);
-        if (twinsz <= 0.0) {
-          continue;
-        }
-
-        dec = nlistGetDouble (dancesel->wdecrement, didx);
-        diff = twinsz - dec;
-
-        nlistSetNum (dancesel->winEarlySel, didx, false);
-
-        /* base value for the dance */
-        /* determine which dances are allowed to be selected */
-        /* always 1.0 unless the dance is outside the window */
-        /* if outside the window, use the diff* values to give */
-        /* the dance a small chance of being selected */
-
-        /* wsz   dec   diff   tbase */
-        /* 3.4 - 0.0 :  3.4 : 1.0 */
-        /* 3.4 - 1.0 :  2.4 : 0.1 */
-        /* 3.4 - 2.0 :  1.4 : 0.25 */
-        /* 3.4 - 3.0 :  0.4 : 0.5 */
-        /* 3.4 - 4.0 : -0.4 : 1.0, reset decrement */
-        if (diff <= 0.0) {
-          tbase = 1.0;
-          nlistSetDouble (dancesel->wdecrement, didx, 0.0);
-          nlistSetNum (dancesel->winEarlySel, didx, false);
-        } else if (diff >= twinsz) {
-          /* decrement is zero */
-          tbase = 1.0;
-        } else {
-          if (diff > 0.0) {
-            tbase = countTries * 0.1;
-            if (! nlistGetNum (dancesel->winEarlySel, didx)) {
-              /* these allow the dance to be selected a bit early in the window */
-              /* this helps prevent situations where no dance can be selected */
-              /* in these cases, if the dance is selected, make sure the dance */
-              /* is not re-selected until the decrement is reset */
-              if (diff <= 3.0) {
-                tbase = dancesel->windowedDiffC;
-                nlistSetNum (dancesel->winEarlySel, didx, true);
-              }
-              if (diff <= 2.0) {
-                tbase = dancesel->windowedDiffB;
-                nlistSetNum (dancesel->winEarlySel, didx, true);
-              }
-            }
-            /* on the edge between windows, 50% chance */
-            if (diff <= 1.0) {
-              tbase = dancesel->windowedDiffA;
-            }
-          }
-        }
-
-        logMsg (LOG_DBG, LOG_DANCESEL, "win:  didx:%" PRId32 "/%s",
-            didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE));
-        logMsg (LOG_DBG, LOG_DANCESEL, "win:    winsz:%.2f decr:%.2f diff:%.2f",
-            twinsz, dec, diff);
-        logMsg (LOG_DBG, LOG_DANCESEL, "win:    base-prob:%.2f count-tries:%d",
-            tbase, countTries);
-#if DANCESEL_DEBUG
-        fprintf (stderr, "win:  didx:%" PRId32 "/%s\n",
-            didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE));
-        fprintf (stderr, "win:    winsz:%.2f decr:%.2f diff:%.2f\n",
-            twinsz, dec, diff);
-        fprintf (stderr, "win:    base-prob:%.2f count-tries:%d\n",
-            tbase, countTries);
-#endif
-
-        if (tbase == 0.0) {
-          continue;
-        }
-      } /* method = windowed */
-
-      abase = tbase;
-      logMsg (LOG_DBG, LOG_DANCESEL, "  didx:%" PRId32 "/%s base:%.0f",
-          didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE), tbase);
-#if DANCESEL_DEBUG
-      fprintf (stderr, "  didx:%" PRId32 "/%s base:%.0f\n",
-          didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE), tbase);
-#endif
+  /* the prior dances are the same for every dance, look them up once */
+  /* the previous dance (dist == 1) is handled by the previous dance table */
 
-      speed = danceGetNum (dancesel->dances, didx, DANCE_SPEED);
+  priorcount = 0;
+  queueDist = 2;
+  queueIdx = queueCount - queueDist;
+  while (queueDist < dancesel->histDistance) {
+    ilistidx_t  priordidx = -1;
 
-      nlistSetDouble (dancesel->adjustBase, didx, abase);
-
-      /* if this selection is at the beginning of the playlist */
-
-      if (dancesel->selCount < autoselGetNum (dancesel->autosel, AUTOSEL_BEG_COUNT)) {
-        /* if this dance is a fast dance ( / 1000) */
-        if (speed == DANCE_SPEED_FAST) {
-          abase = abase / autoselGetDouble (dancesel->autosel, AUTOSEL_BEG_FAST);
-          logMsg (LOG_DBG, LOG_DANCESEL, "   fast / begin of playlist: abase: %.6f", abase);
-#if DANCESEL_DEBUG
-          fprintf (stderr, "   fast / begin of playlist: abase: %.6f\n", abase);
-          fprintf (stderr, "     selcount: %" PRId32 "\n", dancesel->selCount);
-#endif
-        }
-      }
+    if (danceselGetPriorInfo (dancesel, queueCount, queueIdx, &priordidx)) {
+      break;
+    }
+    dancesel->prior [queueDist] = danceselValidIdx (dancesel, priordidx);
+    priorcount = queueDist + 1;
+    --queueIdx;
+    ++queueDist;
+  }
 
-      /* if this dance and the previous dance were both fast ( / 1000) */
+  /* the base value for each dance, and the adjustments due to the */
+  /* previous and prior dances */
 
-      if (speed == DANCE_SPEED_FAST &&
-          pddanceIdx >= 0 && pdspeed == speed) {
-        abase = abase / autoselGetDouble (dancesel->autosel, AUTOSEL_FAST_BOTH);
-        logMsg (LOG_DBG, LOG_DANCESEL, "   speed is fast and same as previous: abase: %.6f", abase);
-#if DANCESEL_DEBUG
-        fprintf (stderr, "   speed is fast and same as previous: abase: %.6f\n", abase);
-#endif
-      }
+  total = 0.0;
+  for (int i = 0; i < dancesel->dcount; ++i) {
+    danceselent_t   *ent = &dancesel->dtab [i];
 
-      /* if this dance and the previous dance have matching types ( / 600 ) */
+    /* at this time, only the 'windowed' method is implemented. */
+    /* there was a (more complicated) 'expected-count' method, */
+    /* but it has been removed. */
 
-      type = danceGetNum (dancesel->dances, didx, DANCE_TYPE);
-      if (pddanceIdx >= 0 && pdtype == type) {
-        abase = abase / autoselGetDouble (dancesel->autosel, AUTOSEL_TYPE_MATCH);
-        logMsg (LOG_DBG, LOG_DANCESEL, "   matched type with previous: abase: %.6f", abase);
-#if DANCESEL_DEBUG
-        fprintf (stderr, "   matched type with previous: abase: %.6f\n", abase);
-#endif
-      }
+    /* 'windowed' is a re-write of 'expected-count' that removed */
+    /* a lot of complexity. */
 
-      /* if there is a tag match between the previous dance and this one */
-      /* ( / 600 ) */
+    dancesel->tbase [i] = 1.0;
+    if (dancesel->method == DANCESEL_METHOD_WINDOWED) {
+      dancesel->tbase [i] = danceselWindowBase (dancesel, ent);
+    }
+    dancesel->adjust [i] = danceselAdjust (dancesel, ent, pddanceIdx, priorcount);
+    total += dancesel->tbase [i] / dancesel->adjust [i];
+  }
 
-      tags = danceGetList (dancesel->dances, didx, DANCE_TAGS);
-      if (pddanceIdx >= 0 && danceselMatchTag (tags, pdtags)) {
-        abase = abase / dancesel->prevTagMatch;
-        logMsg (LOG_DBG, LOG_DANCESEL, "   matched tags with previous: abase: %.6f", abase);
+  if (total <= 0.0 && dancesel->method == DANCESEL_METHOD_WINDOWED) {
+    /* the windowed method can end up with no selections available, */
+    /* as the window for every dance can be active, especially near */
+    /* the 'basetotal'. */
+    /* give the dances within their window a small chance. */
+    /* the prevents starvation when the possibilities become low */
+    logMsg (LOG_DBG, LOG_DANCESEL, "--- no available selections");
 #if DANCESEL_DEBUG
-        fprintf (stderr, "   matched tags with previous: abase: %.6f\n", abase);
+    fprintf (stderr, "--- no available selections\n");
 #endif
+    total = 0.0;
+    for (int i = 0; i < dancesel->dcount; ++i) {
+      if (dancesel->dtab [i].winRetry) {
+        dancesel->tbase [i] = 0.1;
       }
-
-      /* process prior checks, save abase */
-
-      nlistSetDouble (dancesel->adjustBase, didx, abase);
-
-      /* the previous dance (dist == 1) has already been checked */
-      queueDist = 2;
-      queueIdx = queueCount - queueDist;
-      priorLookupDone = false;
-      priordidx = -1;
-      chkdist = dancesel->histDistance;
-
-      while (! priorLookupDone && queueDist < chkdist) {
-        bool  match = false;
-
-        priorLookupDone = danceselGetPriorInfo (dancesel, queueCount, queueIdx, &priordidx);
-        /* priordidx will be -1 if there is no prior dance*/
-        if (! priorLookupDone && priordidx != -1) {
-          logMsg (LOG_DBG, LOG_DANCESEL, "   prior dist:%d", queueDist);
-          /* process prior is only done for matching dance indexes */
-          match = danceselProcessPrior (dancesel, didx, priordidx, queueDist, tags, match);
-        }
-        --queueIdx;
-        ++queueDist;
-      } /* for prior queue/played entries */
-    } /* for each dance in the base list */
-
-    countAvailable = nlistGetCount (dancesel->adjustBase);
-    countTries += 1;
-    if (countAvailable == 0) {
-      /* the windowed method can end up with no selections available, */
-      /* as the window for every dance can be active, especially near */
-      /* the 'basetotal'. */
-      logMsg (LOG_DBG, LOG_DANCESEL, "--- no available selections");
-#if DANCESEL_DEBUG
-      fprintf (stderr, "--- no available selections\n");
-#endif
+      total += dancesel->tbase [i] / dancesel->adjust [i];
     }
-  } /* outside loop to make sure something is available to be selected */
-
-  /* get the total for the adjusted base values */
+  }
 
-  adjTotal = 0.0;
-  nlistStartIterator (dancesel->adjustBase, &iteridx);
-  while ((didx = nlistIterateKey (dancesel->adjustBase, &iteridx)) >= 0) {
-    abase = nlistGetDouble (dancesel->adjustBase, didx);
-    if (abase > 0.0) {
-      logMsg (LOG_DBG, LOG_DANCESEL, "    pre-final:%" PRId32 "/%s %.6f", didx,
-            danceGetStr (dancesel->dances, didx, DANCE_DANCE), abase);
-#if DANCESEL_DEBUG
-      fprintf (stderr, "    pre-final:%" PRId32 "/%s %.6f\n", didx,
-          danceGetStr (dancesel->dances, didx, DANCE_DANCE), abase);
-#endif
-    }
-    adjTotal += abase;
+  if (total <= 0.0) {
+    logProcEnd ("none-available");
+    return -1;
   }
 
-  /* create a probability table of running totals */
+  /* and pick a dance */
 
+  tval = dRandom ();
   tprob = 0.0;
-  nlistStartIterator (dancesel->adjustBase, &iteridx);
-  while ((didx = nlistIterateKey (dancesel->adjustBase, &iteridx)) >= 0) {
-    abase = nlistGetDouble (dancesel->adjustBase, didx);
-    tval = 0.0;
-    if (adjTotal > 0.0) {
-      tval = abase / adjTotal;
+  didx = -1;
+  for (int i = 0; i < dancesel->dcount; ++i) {
+    danceselent_t   *ent = &dancesel->dtab [i];
+    double          abase;
+
+    if (dancesel->tbase [i] <= 0.0) {
+      continue;
     }
-    tprob += tval;
+
+    abase = dancesel->tbase [i] / dancesel->adjust [i];
+    tprob += abase;
     logMsg (LOG_DBG, LOG_DANCESEL, "  final prob: %" PRId32 "/%s: %.6f",
-        didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE), tprob);
+        ent->didx, danceGetStr (dancesel->dances, ent->didx, DANCE_DANCE),
+        tprob / total);
 #if DANCESEL_DEBUG
     fprintf (stderr, "     final prob: %" PRId32 "/%s: %.6f\n",
-        didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE), tprob);
+        ent->didx, danceGetStr (dancesel->dances, ent->didx, DANCE_DANCE),
+        tprob / total);
 #endif
-    nlistSetDouble (dancesel->danceProbTable, didx, tprob);
+    /* the last available dance is used if there is any rounding error */
+    didx = ent->didx;
+    if (tval * total <= tprob) {
+      if (dancesel->method == DANCESEL_METHOD_WINDOWED) {
+        /* if the dance was an early selection, reset the decrement */
+        if (ent->winEarlySel) {
+          ent->wdecrement = 0.0;
+          ent->winEarlySel = false;
+        }
+      } /* method = windowed */
+      break;
+    }
   }
 
-  /* and pick a dance */
-
-  tval = dRandom ();
-  didx = nlistSearchProbTable (dancesel->danceProbTable, tval);
   logMsg (LOG_DBG, LOG_BASIC, "== select %.6f %" PRId32 "/%s",
         tval, didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE));
 #if DANCESEL_DEBUG
   fprintf (stderr, "== select %.6f %" PRId32 "/%s\n",
       tval, didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE));
 #endif
-  if (dancesel->method == DANCESEL_METHOD_WINDOWED) {
-    /* if the dance was an early selection, reset the decrement */
-    if (nlistGetNum (dancesel->winEarlySel, didx)) {
-      nlistSetDouble (dancesel->wdecrement, didx, 0.0);
-      nlistSetNum (dancesel->winEarlySel, didx, false);
-    }
-  } /* method = windowed */
 
   logProcEnd ("");
   return didx;
@@ -574,88 +429,154 @@ danceselPlayedFree (void *data)
   dataFree (pd);
 }
 
-static bool
-danceselProcessPrior (dancesel_t *dancesel, ilistidx_t didx,
-    ilistidx_t priordidx, ilistidx_t priordist, slist_t *tags, bool match)
+/* the dance attributes do not change while the dancesel is in use. */
+/* the adjustment for each possible previous dance is computed once. */
+static void
+danceselInitTables (dancesel_t *dancesel, nlist_t *countList)
 {
-  slist_t       *priortags = NULL;
-  double        abase;
-  int           matchrc = false;
+  nlistidx_t    iteridx;
+  slistidx_t    diteridx;
+  ilistidx_t    didx;
+  ilistidx_t    odidx;
+  int           idx;
+
+  dancesel->dmax = 0;
+  danceStartIterator (dancesel->dances, &diteridx);
+  while ((didx = danceIterate (dancesel->dances, &diteridx)) >= 0) {
+    if (didx >= dancesel->dmax) {
+      dancesel->dmax = didx + 1;
+    }
+  }
 
-  logProcBegin ();
+  dancesel->dfast = mdmalloc (sizeof (bool) * (dancesel->dmax + 1));
+  for (didx = 0; didx < dancesel->dmax; ++didx) {
+    dancesel->dfast [didx] = false;
+  }
+  danceStartIterator (dancesel->dances, &diteridx);
+  while ((didx = danceIterate (dancesel->dances, &diteridx)) >= 0) {
+    dancesel->dfast [didx] =
+        danceGetNum (dancesel->dances, didx, DANCE_SPEED) == DANCE_SPEED_FAST;
+  }
 
-  /* only the first hist-distance songs are checked */
+  dancesel->dtab = mdmalloc (sizeof (danceselent_t) * (nlistGetCount (countList) + 1));
+  dancesel->tbase = mdmalloc (sizeof (double) * (nlistGetCount (countList) + 1));
+  dancesel->adjust = mdmalloc (sizeof (double) * (nlistGetCount (countList) + 1));
 
-  if (priordist > dancesel->histDistance) {
-    logProcEnd ("past-distance");
-    return false;
-  }
+  idx = 0;
+  nlistStartIterator (countList, &iteridx);
+  while ((didx = nlistIterateKey (countList, &iteridx)) >= 0) {
+    danceselent_t *ent;
+    nlistidx_t    count;
+    slist_t       *tags;
+    int           type;
 
-  abase = nlistGetDouble (dancesel->adjustBase, didx);
-  if (abase == 0.0) {
-    logProcEnd ("at-zero");
-    return false;
-  }
+    count = nlistGetNum (countList, didx);
+    if (count <= 0 || didx >= dancesel->dmax) {
+      continue;
+    }
 
-  /* the previous dance's tags have already been adjusted */
+    ent = &dancesel->dtab [idx];
+    ent->didx = didx;
+    ent->count = count;
+    ent->fast = dancesel->dfast [didx];
+    ent->winsize = 0.0;
+    ent->wdecrement = 0.0;
+    ent->winEarlySel = false;
+    ent->winRetry = false;
+    ent->prevadj = mdmalloc (sizeof (double) * dancesel->dmax);
+    ent->tagmatch = mdmalloc (sizeof (bool) * dancesel->dmax);
+    for (odidx = 0; odidx < dancesel->dmax; ++odidx) {
+      ent->prevadj [odidx] = 1.0;
+      ent->tagmatch [odidx] = false;
+    }
 
-  if (priordist > 0) {
-    logMsg (LOG_DBG, LOG_DANCESEL, "     process prior didx:%" PRId32 "/%s prior:%" PRId32 "/%s",
-        didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE),
-        priordidx, danceGetStr (dancesel->dances, priordidx, DANCE_DANCE));
-  }
+    tags = danceGetList (dancesel->dances, didx, DANCE_TAGS);
+    type = danceGetNum (dancesel->dances, didx, DANCE_TYPE);
 
-  /* check the speed of the previous dance if the priordist == 2 */
+    danceStartIterator (dancesel->dances, &diteridx);
+    while ((odidx = danceIterate (dancesel->dances, &diteridx)) >= 0) {
+      double  adj = 1.0;
 
-  if (! match && priordist == 2) {
-    int     pspeed;
-    int     speed;
+      ent->tagmatch [odidx] = danceselMatchTag (tags,
+          danceGetList (dancesel->dances, odidx, DANCE_TAGS));
 
-    pspeed = danceGetNum (dancesel->dances, priordidx, DANCE_SPEED);
-    speed = danceGetNum (dancesel->dances, didx, DANCE_SPEED);
-    if (speed == DANCE_SPEED_FAST && pspeed == speed) {
-      double  tmp;
+      /* if this dance and the previous dance were both fast ( / 1000) */
+      if (ent->fast && dancesel->dfast [odidx]) {
+        adj *= dancesel->fastBoth;
+      }
+      /* if this dance and the previous dance have matching types ( / 600 ) */
+      if (danceGetNum (dancesel->dances, odidx, DANCE_TYPE) == type) {
+        adj *= dancesel->typeMatch;
+      }
+      /* if there is a tag match between the previous dance and this one */
+      /* ( / 600 ) */
+      if (ent->tagmatch [odidx]) {
+        adj *= dancesel->prevTagMatch;
+      }
+      ent->prevadj [odidx] = adj;
+    }
 
-      tmp = autoselGetDouble (dancesel->autosel, AUTOSEL_FAST_PRIOR);
-      logMsg (LOG_DBG, LOG_DANCESEL, "     fastmatch adj: %.6f old-abase: %.6f", tmp, abase);
-      abase = abase / autoselGetDouble (dancesel->autosel, AUTOSEL_FAST_PRIOR);
-      logMsg (LOG_DBG, LOG_DANCESEL, "     fastmatch abase: %.6f", abase);
+    dancesel->basetotal += (double) count;
+    logMsg (LOG_DBG, LOG_DANCESEL, "base: %" PRId32 "/%s: %" PRId32, didx,
+        danceGetStr (dancesel->dances, didx, DANCE_DANCE), count);
 #if DANCESEL_DEBUG
-      fprintf (stderr, "     prior: %d fastmatch abase: %.6f\n", priordist, abase);
+    fprintf (stderr, "base: %" PRId32 "/%s: %" PRId32 "\n", didx,
+        danceGetStr (dancesel->dances, didx, DANCE_DANCE), count);
 #endif
-      matchrc = true;
+    ++idx;
+  }
+  dancesel->dcount = idx;
+
+  /* a tag match with a prior dance: */
+  /* further distance, smaller value, minimum no change */
+  dancesel->prior = mdmalloc (sizeof (ilistidx_t) * (dancesel->histDistance + 1));
+  dancesel->histadj = mdmalloc (sizeof (double) * (dancesel->histDistance + 1));
+  for (int i = 0; i <= dancesel->histDistance; ++i) {
+    dancesel->prior [i] = -1;
+    dancesel->histadj [i] = 1.0;
+    if (i > 0) {
+      dancesel->histadj [i] = fmax (1.0,
+          (dancesel->tagMatch / pow (i, dancesel->priorExp)));
     }
   }
+}
 
-  /* the tags of the first few dances in the history are checked */
-  /* when matching, don't process another match if one has already been found */
+/* returns the divisor for the dance's base value */
+static double
+danceselAdjust (dancesel_t *dancesel, danceselent_t *ent,
+    ilistidx_t pddanceIdx, ilistidx_t priorcount)
+{
+  double    adj = 1.0;
 
-  if (! match && priordist > 0 && priordist < dancesel->histDistance) {
-    double    tmp;
+  /* if this selection is at the beginning of the playlist */
+  /* and this dance is a fast dance ( / 1000) */
+  if (dancesel->selCount < dancesel->begCount && ent->fast) {
+    adj *= dancesel->begFast;
+  }
 
-    priortags = danceGetList (dancesel->dances, priordidx, DANCE_TAGS);
+  if (pddanceIdx >= 0) {
+    adj *= ent->prevadj [pddanceIdx];
+  }
 
-    if (danceselMatchTag (tags, priortags)) {
-      /* further distance, smaller value, minimum no change */
-      tmp = fmax (1.0, (dancesel->tagMatch / pow (priordist, dancesel->priorExp)));
-      logMsg (LOG_DBG, LOG_DANCESEL, "     tagmatch adj: %.6f old-abase: %.6f", tmp, abase);
-      abase = abase / tmp;
-      nlistSetDouble (dancesel->adjustBase, didx, abase);
-      logMsg (LOG_DBG, LOG_DANCESEL, "     tagmatch tags: abase: %.6f", abase);
-#if DANCESEL_DEBUG
-      fprintf (stderr, "      prior: %d tagmatch adj: %.6f abase: %.6f\n", priordist, tmp, abase);
-#endif
-      matchrc = true;
+  /* the tags of the first few dances in the history are checked */
+  for (ilistidx_t dist = 2; dist < priorcount; ++dist) {
+    ilistidx_t    priordidx = dancesel->prior [dist];
+
+    if (priordidx < 0) {
+      continue;
+    }
+    /* check the speed of the prior dance if the dist == 2 */
+    if (dist == 2 && ent->fast && dancesel->dfast [priordidx]) {
+      adj *= dancesel->fastPrior;
+    }
+    if (ent->tagmatch [priordidx]) {
+      adj *= dancesel->histadj [dist];
     }
   }
 
-  nlistSetDouble (dancesel->adjustBase, didx, abase);
-
-  logProcEnd ("");
-  return matchrc;
+  return adj;
 }
 
-
 static bool
 danceselMatchTag (slist_t *tags, slist_t *otags)
 {
@@ -714,38 +635,108 @@ danceselGetPriorInfo (dancesel_t *dancesel, ilistidx_t queueCount,
   return rc;
 }
 
+/* a dance index that is not in the tables is treated as no dance */
+static ilistidx_t
+danceselValidIdx (dancesel_t *dancesel, ilistidx_t didx)
+{
+  if (didx < 0 || didx >= dancesel->dmax) {
+    return -1;
+  }
+  return didx;
+}
+
 /* windowed */
-static void
-danceselInitWindowSizes (dancesel_t *dancesel)
+static double
+danceselWindowBase (dancesel_t *dancesel, danceselent_t *ent)
 {
-  nlistidx_t    iteridx;
-  ilistidx_t    didx;
+  double    tbase = 0.0;
+  double    diff;
 
-  nlistStartIterator (dancesel->base, &iteridx);
-  while ((didx = nlistIterateKey (dancesel->base, &iteridx)) >= 0) {
-    long    count;
-    double  dval;
+  ent->winEarlySel = false;
+  ent->winRetry = false;
 
-    count = nlistGetNum (dancesel->base, didx);
+  if (ent->winsize <= 0.0) {
+    return 0.0;
+  }
+
+  diff = ent->winsize - ent->wdecrement;
+
+  /* base value for the dance */
+  /* determine which dances are allowed to be selected */
+  /* always 1.0 unless the dance is outside the window */
+  /* if outside the window, use the diff* values to give */
+  /* the dance a small chance of being selected */
+
+  /* wsz   dec   diff   tbase */
+  /* 3.4 - 0.0 :  3.4 : 1.0 */
+  /* 3.4 - 1.0 :  2.4 : 0.1 */
+  /* 3.4 - 2.0 :  1.4 : 0.25 */
+  /* 3.4 - 3.0 :  0.4 : 0.5 */
+  /* 3.4 - 4.0 : -0.4 : 1.0, reset decrement */
+  if (diff <= 0.0) {
+    tbase = 1.0;
+    ent->wdecrement = 0.0;
+  } else if (diff >= ent->winsize) {
+    /* decrement is zero */
+    tbase = 1.0;
+  } else {
+    /* these allow the dance to be selected a bit early in the window */
+    /* this helps prevent situations where no dance can be selected */
+    /* in these cases, if the dance is selected, make sure the dance */
+    /* is not re-selected until the decrement is reset */
+    if (diff <= 3.0) {
+      tbase = dancesel->windowedDiffC;
+      ent->winEarlySel = true;
+    }
+    if (diff <= 2.0) {
+      tbase = dancesel->windowedDiffB;
+    }
+    /* on the edge between windows, 50% chance */
+    if (diff <= 1.0) {
+      tbase = dancesel->windowedDiffA;
+    }
+    if (diff > 3.0) {
+      /* only available if nothing else can be selected */
+      ent->winRetry = true;
+    }
+  }
+
+  logMsg (LOG_DBG, LOG_DANCESEL, "win:  didx:%" PRId32 " winsz:%.2f decr:%.2f diff:%.2f base-prob:%.2f",
+      ent->didx, ent->winsize, ent->wdecrement, diff, tbase);
+#if DANCESEL_DEBUG
+  fprintf (stderr, "win:  didx:%" PRId32 " winsz:%.2f decr:%.2f diff:%.2f base-prob:%.2f\n",
+      ent->didx, ent->winsize, ent->wdecrement, diff, tbase);
+#endif
+
+  return tbase;
+}
+
+/* windowed */
+static void
+danceselInitWindowSizes (dancesel_t *dancesel)
+{
+  for (int i = 0; i < dancesel->dcount; ++i) {
+    danceselent_t   *ent = &dancesel->dtab [i];
+    double          dval;
 
     /* windowed */
     /* this sets the window size for the dance */
-    if (count == 0) {
+    if (ent->count == 0) {
       dval = 0.0;
     } else {
-      dval = (double) dancesel->basetotal / (double) count;
+      dval = (double) dancesel->basetotal / (double) ent->count;
       /* reduce the window size slightly. */
       /* this helps prevent starvation near the 'basetotal' */
       dval -= 0.3;
     }
-    nlistSetDouble (dancesel->winsize, didx, dval);
+    ent->winsize = dval;
     if (dval > 0.0) {
       logMsg (LOG_DBG, LOG_DANCESEL, "win: winsize: %" PRId32 "/%s %.2f",
-          didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE),
+          ent->didx, danceGetStr (dancesel->dances, ent->didx, DANCE_DANCE),
           dval);
 #if DANCESEL_DEBUG
       fprintf (stderr, "win: winsize: %" PRId32 "/%s %.2f\n",
-          didx, danceGetStr (dancesel->dances, didx, DANCE_DANCE),
+          ent->didx, danceGetStr (dancesel->dances, ent->didx, DANCE_DANCE),
           dval);
 #endif
     }
@@ -756,12 +747,8 @@ danceselInitWindowSizes (dancesel_t *dancesel)
 static void
 danceselInitDecrement (dancesel_t *dancesel)
 {
-  nlistidx_t    iteridx;
-  ilistidx_t    didx;
-
-  nlistStartIterator (dancesel->base, &iteridx);
-  while ((didx = nlistIterateKey (dancesel->base, &iteridx)) >= 0) {
-    nlistSetDouble (dancesel->wdecrement, didx, 0.0);
-    nlistSetNum (dancesel->winEarlySel, didx, false);
+  for (int i = 0; i < dancesel->dcount; ++i) {
+    dancesel->dtab [i].wdecrement = 0.0;
+    dancesel->dtab [i].winEarlySel = false;
   }
 }
@@ -0,0 +1,414 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+/*
+ * database update manifest
+ *
+ * The manifest holds the modification time of each directory in the
+ * music folder, and the size, modification time and inode of each file
+ * that was seen by the last complete scan.
+ *
+ * A directory's modification time changes when a file is added,
+ * removed or renamed.  If the directory has not changed, the files in
+ * the directory are not checked, and the directory's entries are
+ * carried over to the new manifest.  Files in a changed directory are
+ * checked individually.
+ *
+ * Any directory or file that was modified after the scan started
+ * is recorded with a zero modification time so that it will be
+ * checked again on the next scan.
+ *
+ * The manifest is not thread-safe.
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "bdj4.h"
+#include "bdjstring.h"
+#include "dbmanifest.h"
+#include "filemanip.h"
+#include "fileop.h"
+#include "log.h"
+#include "mdebug.h"
+#include "slist.h"
+
+enum {
+  DBMANIFEST_VERSION = 1,
+};
+
+#define DBMANIFEST_TMP_EXT ".tmp"
+
+typedef struct {
+  int64_t     size;
+  time_t      mtime;
+  uint64_t    inode;
+} dbmanfile_t;
+
+typedef struct {
+  time_t      mtime;
+  slist_t     *files;
+  bool        unchanged;
+} dbmandir_t;
+
+typedef struct dbmanifest {
+  char        *fname;
+  char        *musicdir;
+  slist_t     *olddirs;
+  slist_t     *dirs;
+  time_t      scanstart;
+  bool        loaded;
+} dbmanifest_t;
+
+static void dbmanifestLoad (dbmanifest_t *dbmanifest);
+static dbmandir_t *dbmanifestDirAlloc (time_t mtime, bool unchanged);
+static void dbmanifestDirFree (void *tdir);
+static void dbmanifestFileFree (void *tfile);
+static time_t dbmanifestCheckTime (dbmanifest_t *dbmanifest, time_t mtime);
+
+/* if load is false, the existing manifest is not used */
+/* and every file is reported as new */
+BDJ_NODISCARD
+dbmanifest_t *
+dbmanifestAlloc (const char *fname, const char *musicdir, bool load)
+{
+  dbmanifest_t  *dbmanifest;
+
+  dbmanifest = mdmalloc (sizeof (dbmanifest_t));
+  dbmanifest->fname = mdstrdup (fname);
+  dbmanifest->musicdir = mdstrdup (musicdir);
+  dbmanifest->olddirs = slistAlloc ("dbman-old", LIST_ORDERED,
+      dbmanifestDirFree);
+  dbmanifest->dirs = slistAlloc ("dbman-dirs", LIST_ORDERED,
+      dbmanifestDirFree);
+  dbmanifest->scanstart = time (NULL);
+  dbmanifest->loaded = false;
+
+  if (load) {
+    dbmanifestLoad (dbmanifest);
+  }
+
+  return dbmanifest;
+}
+
+void
+dbmanifestFree (dbmanifest_t *dbmanifest)
+{
+  if (dbmanifest == NULL) {
+    return;
+  }
+
+  slistFree (dbmanifest->olddirs);
+  slistFree (dbmanifest->dirs);
+  dataFree (dbmanifest->fname);
+  dataFree (dbmanifest->musicdir);
+  mdfree (dbmanifest);
+}
+
+bool
+dbmanifestIsLoaded (dbmanifest_t *dbmanifest)
+{
+  if (dbmanifest == NULL) {
+    return false;
+  }
+
+  return dbmanifest->loaded;
+}
+
+/* ffn is the full path to the file */
+/* the file is recorded in the new manifest */
+dbmanifestrc_t
+dbmanifestCheckFile (dbmanifest_t *dbmanifest, const char *ffn)
+{
+  char          dir [BDJ4_PATH_MAX];
+  const char    *fname;
+  const char    *p;
+  dbmandir_t    *mandir;
+  dbmandir_t    *olddir;
+  dbmanfile_t   *manfile;
+  dbmanfile_t   *oldfile = NULL;
+  fileopinfo_t  info;
+
+  if (dbmanifest == NULL || ffn == NULL) {
+    return DBMANIFEST_NEW;
+  }
+
+  p = strrchr (ffn, '/');
+  if (p == NULL) {
+    return DBMANIFEST_NEW;
+  }
+  fname = p + 1;
+  if ((size_t) (p - ffn) >= sizeof (dir)) {
+    return DBMANIFEST_NEW;
+  }
+  memcpy (dir, ffn, p - ffn);
+  dir [p - ffn] = '\0';
+
+  olddir = slistGetData (dbmanifest->olddirs, dir);
+  mandir = slistGetData (dbmanifest->dirs, dir);
+
+  if (mandir == NULL) {
+    if (! fileopGetInfo (dir, &info)) {
+      return DBMANIFEST_NEW;
+    }
+
+    if (olddir != NULL && olddir->files != NULL &&
+        olddir->mtime != 0 &&
+        olddir->mtime == info.mtime) {
+      /* the directory has not changed, the old entries are */
+      /* moved to the new manifest */
+      mandir = dbmanifestDirAlloc (olddir->mtime, true);
+      mandir->files = olddir->files;
+      olddir->files = NULL;
+    } else {
+      mandir = dbmanifestDirAlloc (
+          dbmanifestCheckTime (dbmanifest, info.mtime), false);
+      mandir->files = slistAlloc ("dbman-files", LIST_ORDERED,
+          dbmanifestFileFree);
+    }
+    slistSetData (dbmanifest->dirs, dir, mandir);
+  }
+
+  if (mandir->unchanged) {
+    return DBMANIFEST_UNCHANGED;
+  }
+
+  if (! fileopGetInfo (ffn, &info)) {
+    return DBMANIFEST_NEW;
+  }
+
+  /* any line-ending characters would corrupt the manifest */
+  if (strpbrk (fname, "\r\n") != NULL) {
+    return DBMANIFEST_NEW;
+  }
+
+  manfile = mdmalloc (sizeof (dbmanfile_t));
+  manfile->size = info.size;
+  manfile->mtime = dbmanifestCheckTime (dbmanifest, info.mtime);
+  manfile->inode = info.inode;
+  slistSetData (mandir->files, fname, manfile);
+
+  if (olddir != NULL && olddir->files != NULL) {
+    oldfile = slistGetData (olddir->files, fname);
+  }
+  if (oldfile == NULL) {
+    return DBMANIFEST_NEW;
+  }
+
+  if (oldfile->mtime != 0 &&
+      oldfile->size == info.size &&
+      oldfile->mtime == info.mtime &&
+      oldfile->inode == info.inode) {
+    return DBMANIFEST_UNCHANGED;
+  }
+
+  return DBMANIFEST_CHANGED;
+}
+
+void
+dbmanifestSave (dbmanifest_t *dbmanifest)
+{
+  FILE        *fh;
+  char        tfname [BDJ4_PATH_MAX];
+  slistidx_t  diter;
+  slistidx_t  fiter;
+  const char  *dir;
+  const char  *fname;
+  dbmandir_t  *mandir;
+  dbmanfile_t *manfile;
+
+  if (dbmanifest == NULL) {
+    return;
+  }
+
+  snprintf (tfname, sizeof (tfname), "%s%s",
+      dbmanifest->fname, DBMANIFEST_TMP_EXT);
+  fh = fileopOpen (tfname, "w");
+  if (fh == NULL) {
+    logMsg (LOG_DBG, LOG_IMPORTANT, "ERR: unable to save manifest %s", tfname);
+    return;
+  }
+
+  fprintf (fh, "# %s\n", DBMANIFEST_FNAME);
+  fprintf (fh, "VERSION\t%d\n", DBMANIFEST_VERSION);
+  fprintf (fh, "MUSICDIR\t%s\n", dbmanifest->musicdir);
+
+  slistStartIterator (dbmanifest->dirs, &diter);
+  while ((dir = slistIterateKey (dbmanifest->dirs, &diter)) != NULL) {
+    mandir = slistGetData (dbmanifest->dirs, dir);
+    if (strpbrk (dir, "\r\n") != NULL) {
+      continue;
+    }
+
+    fprintf (fh, "D\t%" PRId64 "\t%s\n", (int64_t) mandir->mtime, dir);
+    slistStartIterator (mandir->files, &fiter);
+    while ((fname = slistIterateKey (mandir->files, &fiter)) != NULL) {
+      manfile = slistGetData (mandir->files, fname);
+      fprintf (fh, "F\t%" PRId64 "\t%" PRId64 "\t%" PRIu64 "\t%s\n",
+          manfile->size, (int64_t) manfile->mtime, manfile->inode, fname);
+    }
+  }
+  mdextfclose (fh);
+  fclose (fh);
+
+  filemanipMove (tfname, dbmanifest->fname);
+  logMsg (LOG_DBG, LOG_INFO, "manifest saved: dirs: %" PRId32,
+      (int32_t) slistGetCount (dbmanifest->dirs));
+}
+
+/* internal routines */
+
+static void
+dbmanifestLoad (dbmanifest_t *dbmanifest)
+{
+  FILE        *fh;
+  char        tbuff [BDJ4_PATH_MAX + 100];
+  char        *p;
+  char        *tokstr;
+  dbmandir_t  *mandir = NULL;
+  int         version = -1;
+  bool        ok = false;
+
+  fh = fileopOpen (dbmanifest->fname, "r");
+  if (fh == NULL) {
+    logMsg (LOG_DBG, LOG_INFO, "manifest: not found");
+    return;
+  }
+
+  while (fgets (tbuff, sizeof (tbuff), fh) != NULL) {
+    stringTrim (tbuff);
+
+    if (*tbuff == '#' || *tbuff == '\0') {
+      continue;
+    }
+
+    if (strncmp (tbuff, "VERSION\t", 8) == 0) {
+      version = atoi (tbuff + 8);
+      if (version != DBMANIFEST_VERSION) {
+        break;
+      }
+      continue;
+    }
+
+    if (strncmp (tbuff, "MUSICDIR\t", 9) == 0) {
+      /* if the music folder has changed, the manifest is not valid */
+      if (version != DBMANIFEST_VERSION ||
+          strcmp (tbuff + 9, dbmanifest->musicdir) != 0) {
+        break;
+      }
+      ok = true;
+      continue;
+    }
+
+    if (! ok) {
+      break;
+    }
+
+    if (strncmp (tbuff, "D\t", 2) == 0) {
+      p = strtok_r (tbuff + 2, "\t", &tokstr);
+      if (p == NULL || tokstr == NULL || ! *tokstr) {
+        mandir = NULL;
+        continue;
+      }
+      mandir = dbmanifestDirAlloc ((time_t) strtoll (p, NULL, 10), false);
+      mandir->files = slistAlloc ("dbman-files", LIST_ORDERED,
+          dbmanifestFileFree);
+      slistSetData (dbmanifest->olddirs, tokstr, mandir);
+      continue;
+    }
+
+    if (strncmp (tbuff, "F\t", 2) == 0 && mandir != NULL) {
+      dbmanfile_t   *manfile;
+      int64_t       size;
+      time_t        mtime;
+      uint64_t      inode;
+
+      p = strtok_r (tbuff + 2, "\t", &tokstr);
+      if (p == NULL) {
+        continue;
+      }
+      size = strtoll (p, NULL, 10);
+      p = strtok_r (NULL, "\t", &tokstr);
+      if (p == NULL) {
+        continue;
+      }
+      mtime = (time_t) strtoll (p, NULL, 10);
+      p = strtok_r (NULL, "\t", &tokstr);
+      if (p == NULL || tokstr == NULL || ! *tokstr) {
+        continue;
+      }
+      inode = strtoull (p, NULL, 10);
+
+      manfile = mdmalloc (sizeof (dbmanfile_t));
+      manfile->size = size;
+      manfile->mtime = mtime;
+      manfile->inode = inode;
+      slistSetData (mandir->files, tokstr, manfile);
+    }
+  }
+  mdextfclose (fh);
+  fclose (fh);
+
+  if (! ok) {
+    /* the entire manifest is discarded, and a full scan is done */
+    logMsg (LOG_DBG, LOG_IMPORTANT, "manifest: not valid");
+    slistFree (dbmanifest->olddirs);
+    dbmanifest->olddirs = slistAlloc ("dbman-old", LIST_ORDERED,
+        dbmanifestDirFree);
+    return;
+  }
+
+  dbmanifest->loaded = true;
+  logMsg (LOG_DBG, LOG_INFO, "manifest loaded: dirs: %" PRId32,
+      (int32_t) slistGetCount (dbmanifest->olddirs));
+}
+
+static dbmandir_t *
+dbmanifestDirAlloc (time_t mtime, bool unchanged)
+{
+  dbmandir_t  *mandir;
+
+  mandir = mdmalloc (sizeof (dbmandir_t));
+  mandir->mtime = mtime;
+  mandir->files = NULL;
+  mandir->unchanged = unchanged;
+  return mandir;
+}
+
+static void
+dbmanifestDirFree (void *tdir)
+{
+  dbmandir_t  *mandir = tdir;
+
+  if (mandir == NULL) {
+    return;
+  }
+
+  if (mandir->files != NULL) {
+    slistFree (mandir->files);
+  }
+  mdfree (mandir);
+}
+
+static void
+dbmanifestFileFree (void *tfile)
+{
+  dataFree (tfile);
+}
+
+/* a modification during the scan may not have been seen */
+/* the check must be done again on the next scan */
+static time_t
+dbmanifestCheckTime (dbmanifest_t *dbmanifest, time_t mtime)
+{
+  if (mtime >= dbmanifest->scanstart - 1) {
+    mtime = 0;
+  }
+  return mtime;
+}
@@ -378,9 +378,20 @@ impplFinalize (imppl_t *imppl)
 
       tval = audiosrcIterateValue (pldataiter, podtag);
       /* someday this should be redone to table driven */
-      if (strcmp (podtag, "IMAGE_URI") == 0) {
+      /* if the feed has not changed, the image-uri and guid are empty */
+      if (strcmp (podtag, "IMAGE_URI") == 0 && tval != NULL && *tval) {
         podcastSetStr (podcast, PODCAST_IMAGE_URI, tval);
       }
+      /* the validators are used to check for changes to the feed */
+      if (strcmp (podtag, "ETAG") == 0) {
+        podcastSetStr (podcast, PODCAST_ETAG, tval);
+      }
+      if (strcmp (podtag, "LASTMODIFIED") == 0) {
+        podcastSetStr (podcast, PODCAST_LAST_MODIFIED, tval);
+      }
+      if (strcmp (podtag, "LASTGUID") == 0 && tval != NULL && *tval) {
+        podcastSetStr (podcast, PODCAST_LAST_GUID, tval);
+      }
     }
     if (podcastexists == false) {
       podcastSetNum (podcast, PODCAST_RETAIN, 0);
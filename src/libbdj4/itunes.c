@@ -33,23 +33,6 @@
 #include "tmutil.h"
 #include "xmlparse.h"
 
-static const char * datamainxpath =
-      "/plist/dict/dict/key";
-static const char * dataxpath =
-      "/plist/dict/dict/dict/key|"
-      "/plist/dict/dict/dict/integer|"
-      "/plist/dict/dict/dict/string|"
-      "/plist/dict/dict/dict/date|"
-      "/plist/dict/dict/dict/true|"
-      "/plist/dict/dict/dict/false";
-static const char * plmainxpath =
-      "/plist/dict/array/dict/key";
-static const char * plxpath =
-      "/plist/dict/array/dict/key|"
-      "/plist/dict/array/dict/integer|"
-      "/plist/dict/array/dict/string|"
-      "/plist/dict/array/dict/array/dict/key|"
-      "/plist/dict/array/dict/array/dict/integer";
 static const char *ITUNES_LOCALHOST = "file://localhost";
 static const char *ITUNES_LOCAL = "file://";
 
@@ -68,6 +51,89 @@ typedef struct itunes {
   slistidx_t    pliteridx;
 } itunes_t;
 
+/* the itunes xml file is a plist, and everything is dumped into */
+/* dict structures.  the file is streamed through the sax parser, */
+/* and each track and playlist is processed as its dict ends. */
+/*   /plist/dict/key(Tracks)/dict/dict/...      track */
+/*   /plist/dict/key(Playlists)/array/dict/...  playlist */
+/*   .../array/dict/array/dict/...              playlist items */
+
+enum {
+  ITUNES_EL_PLIST,
+  ITUNES_EL_DICT,
+  ITUNES_EL_ARRAY,
+  ITUNES_EL_KEY,
+  ITUNES_EL_INTEGER,
+  ITUNES_EL_STRING,
+  ITUNES_EL_DATE,
+  ITUNES_EL_TRUE,
+  ITUNES_EL_FALSE,
+  ITUNES_EL_OTHER,
+};
+
+enum {
+  ITUNES_SECT_NONE,
+  ITUNES_SECT_TRACKS,
+  ITUNES_SECT_PLAYLISTS,
+};
+
+enum {
+  ITUNES_MAX_DEPTH = 10,
+  ITUNES_KEY_SZ = 50,
+  ITUNES_PL_NAME_SZ = 1000,
+  ITUNES_READ_SZ = 128 * 1024,
+  ITUNES_SONG_ALLOC = 1000,
+  /* depths of the record dicts */
+  ITUNES_DEPTH_REC = 4,
+  ITUNES_DEPTH_ITEM = 6,
+};
+
+typedef struct {
+  itunes_t      *itunes;
+  nlist_t       *songbyidx;
+  slist_t       *songbyname;
+  slist_t       *playlists;
+  nlistidx_t    songalloc;
+  int           path [ITUNES_MAX_DEPTH];
+  int           depth;
+  int           section;
+  char          topkey [ITUNES_KEY_SZ];
+  char          lastkey [ITUNES_KEY_SZ];
+  char          *text;
+  size_t        textlen;
+  size_t        textalloc;
+  /* track */
+  nlist_t       *entry;
+  nlistidx_t    trackid;
+  /* playlist */
+  char          plname [ITUNES_PL_NAME_SZ];
+  nlist_t       *ids;
+  bool          intext;
+  bool          valset;
+  bool          ratingset;
+  bool          skip;
+} itunesparse_t;
+
+typedef struct {
+  const char    *name;
+  int           type;
+} itunesel_t;
+
+static itunesel_t itunesels [] = {
+  { "array",    ITUNES_EL_ARRAY },
+  { "date",     ITUNES_EL_DATE },
+  { "dict",     ITUNES_EL_DICT },
+  { "false",    ITUNES_EL_FALSE },
+  { "integer",  ITUNES_EL_INTEGER },
+  { "key",      ITUNES_EL_KEY },
+  { "plist",    ITUNES_EL_PLIST },
+  { "string",   ITUNES_EL_STRING },
+  { "true",     ITUNES_EL_TRUE },
+};
+enum {
+  ITUNES_EL_COUNT = sizeof (itunesels) / sizeof (itunesel_t),
+};
+
 /* must be sorted in ascii order */
 static datafilekey_t starsdfkeys [ITUNES_STARS_MAX] = {
   { "10",   ITUNES_STARS_10,      VALUE_NUM,  ratingConv, DF_NORM },
@@ -82,9 +148,21 @@ static datafilekey_t starsdfkeys [ITUNES_STARS_MAX] = {
   { "90",   ITUNES_STARS_90,      VALUE_NUM,  ratingConv, DF_NORM },
 };
 
-static bool itunesParseData (itunes_t *itunes, xmlparse_t *xmlparse, const char *xpathExpr);
-static bool itunesParsePlaylists (itunes_t *itunes, xmlparse_t *xmlparse, const char *xpathExpr);
-static bool itunesParseXPath (xmlparse_t *xmlparse, const char *xpathExpr, slist_t *rawdata, const char *mainxpath);
+static void itunesParseStart (void *udata, const char *name, const char **attrs);
+static void itunesParseEnd (void *udata, const char *name);
+static void itunesParseText (void *udata, const char *text, size_t len);
+static int  itunesParseElementType (const char *name);
+static bool itunesParseIsValue (itunesparse_t *ip, int type);
+static void itunesParseKey (itunesparse_t *ip, const char *key);
+static void itunesParseValue (itunesparse_t *ip, const char *val);
+static void itunesParseFlushKey (itunesparse_t *ip);
+static void itunesTrackStart (itunesparse_t *ip);
+static void itunesTrackValue (itunesparse_t *ip, const char *key, const char *val);
+static void itunesTrackEnd (itunesparse_t *ip);
+static void itunesPlaylistStart (itunesparse_t *ip);
+static void itunesPlaylistValue (itunesparse_t *ip, const char *key, const char *val);
+static void itunesPlaylistEnd (itunesparse_t *ip);
+static void itunesParseCleanup (itunesparse_t *ip);
 
 bool
 itunesConfigured (void)
@@ -301,9 +379,15 @@ itunesIterateAvailFields (itunes_t *itunes, int *val)
 bool
 itunesParse (itunes_t *itunes)
 {
-  xmlparse_t          *xmlparse;
+  itunesparse_t       ip;
+  xmlparsesax_t       *sax;
+  FILE                *fh;
+  char                *buff;
+  size_t              len;
   const char          *fn;
   time_t              xmlts;
+  mstime_t            tm;
+  bool                rc = true;
 
   if (! itunesConfigured ()) {
     logMsg (LOG_DBG, LOG_INFO, "itunesParse: itunes not configured");
@@ -316,17 +400,78 @@ itunesParse (itunes_t *itunes)
     return true;
   }
 
-  xmlparse = xmlParseInitFile (fn, XMLPARSE_NONS);
-
-  if (! itunesParseData (itunes, xmlparse, dataxpath)) {
+  fh = fileopOpen (fn, "rb");
+  if (fh == NULL) {
+    logMsg (LOG_DBG, LOG_IMPORTANT, "itunesParse: unable to open %s", fn);
     return false;
   }
-  if (! itunesParsePlaylists (itunes, xmlparse, plxpath)) {
+
+  mstimestart (&tm);
+
+  ip.itunes = itunes;
+  /* the song lists are sorted when the tracks section ends */
+  ip.songbyidx = nlistAlloc ("itunes-songs-by-idx", LIST_UNORDERED, NULL);
+  ip.songbyname = slistAlloc ("itunes-song-by-name", LIST_UNORDERED, NULL);
+  ip.playlists = slistAlloc ("itunes-playlists", LIST_ORDERED, NULL);
+  ip.songalloc = 0;
+  ip.depth = 0;
+  ip.section = ITUNES_SECT_NONE;
+  *ip.topkey = '\0';
+  *ip.lastkey = '\0';
+  ip.text = NULL;
+  ip.textlen = 0;
+  ip.textalloc = 0;
+  ip.entry = NULL;
+  ip.trackid = -1;
+  *ip.plname = '\0';
+  ip.ids = NULL;
+  ip.intext = false;
+  ip.valset = true;
+  ip.ratingset = false;
+  ip.skip = false;
+
+  sax = xmlParseSAXInit (&ip, itunesParseStart, itunesParseEnd, itunesParseText);
+  buff = mdmalloc (ITUNES_READ_SZ);
+  while ((len = fread (buff, 1, ITUNES_READ_SZ, fh)) > 0) {
+    if (! xmlParseSAXPush (sax, buff, len)) {
+      rc = false;
+      break;
+    }
+  }
+  if (rc) {
+    rc = xmlParseSAXFinish (sax);
+  }
+  mdfree (buff);
+  xmlParseSAXFree (sax);
+  mdextfclose (fh);
+  fclose (fh);
+
+  itunesParseCleanup (&ip);
+  if (! rc) {
+    logMsg (LOG_DBG, LOG_IMPORTANT, "itunesParse: parse failed %s", fn);
+    nlistFree (ip.songbyidx);
+    slistFree (ip.songbyname);
+    slistFree (ip.playlists);
     return false;
   }
 
-  xmlParseFree (xmlparse);
+  /* in case there was no tracks section */
+  if (nlistGetOrdering (ip.songbyidx) != LIST_ORDERED) {
+    nlistSort (ip.songbyidx);
+    slistSort (ip.songbyname);
+  }
+
+  nlistFree (itunes->songbyidx);
+  slistFree (itunes->songbyname);
+  slistFree (itunes->playlists);
+  itunes->songbyidx = ip.songbyidx;
+  itunes->songbyname = ip.songbyname;
+  itunes->playlists = ip.playlists;
   itunes->lastparse = xmlts;
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "itunes: songs: %" PRId32 " playlists: %" PRId32 " %" PRId64 " ms",
+      nlistGetCount (itunes->songbyidx), slistGetCount (itunes->playlists),
+      (int64_t) mstimeend (&tm));
   return true;
 }
 
@@ -394,332 +539,433 @@ itunesIteratePlaylists (itunes_t *itunes)
 
 /* internal routines */
 
-static bool
-itunesParseData (itunes_t *itunes, xmlparse_t *xmlparse,
-    const char *xpathExpr)
+static void
+itunesParseStart (void *udata, const char *name, const char **attrs)
 {
-  slist_t     *rawdata;
-  slistidx_t  iteridx;
-  const char  *key;
-  const char  *val;
-  nlistidx_t  lastval = -1;
-  nlist_t     *entry = NULL;
-  bool        ratingset = false;
-  bool        skip = false;
-
-  rawdata = slistAlloc ("itunes-data-raw", LIST_UNORDERED, NULL);
-  if (! itunesParseXPath (xmlparse, xpathExpr, rawdata, datamainxpath)) {
-    slistFree (rawdata);
-    return false;
-  }
+  itunesparse_t   *ip = udata;
+  int             type;
 
-  slistFree (itunes->songbyidx);
-  slistFree (itunes->songbyname);
-  itunes->songbyidx = nlistAlloc ("itunes-songs-by-idx", LIST_ORDERED, NULL);
-  itunes->songbyname = slistAlloc ("itunes-song-by-name", LIST_ORDERED, NULL);
+  type = itunesParseElementType (name);
+  if (ip->depth < ITUNES_MAX_DEPTH) {
+    ip->path [ip->depth] = type;
+  }
+  ip->depth += 1;
+  ip->intext = false;
+
+  if (ip->depth == 3 &&
+      ip->path [0] == ITUNES_EL_PLIST &&
+      ip->path [1] == ITUNES_EL_DICT) {
+    if (type == ITUNES_EL_DICT && strcmp (ip->topkey, "Tracks") == 0) {
+      ip->section = ITUNES_SECT_TRACKS;
+    }
+    if (type == ITUNES_EL_ARRAY && strcmp (ip->topkey, "Playlists") == 0) {
+      ip->section = ITUNES_SECT_PLAYLISTS;
+    }
+  }
 
-  slistStartIterator (rawdata, &iteridx);
-  while ((key = slistIterateKey (rawdata, &iteridx)) != NULL) {
-    val = slistGetStr (rawdata, key);
-    if (val == NULL) {
-      continue;
+  if (ip->depth == ITUNES_DEPTH_REC && type == ITUNES_EL_DICT) {
+    if (ip->section == ITUNES_SECT_TRACKS) {
+      itunesTrackStart (ip);
+    }
+    if (ip->section == ITUNES_SECT_PLAYLISTS) {
+      itunesPlaylistStart (ip);
     }
+  }
 
-    if (strcmp (key, "") == 0) {
-    } else if (strcmp (key, "Track ID") == 0) {
-      if (skip) {
-        nlistFree (entry);
-      }
-      if (! skip && lastval >= 0) {
-        const char  *tval;
+  if (type != ITUNES_EL_TRUE && itunesParseIsValue (ip, type)) {
+    ip->intext = true;
+    ip->textlen = 0;
+  }
+}
 
-        tval = nlistGetStr (entry, TAG_URI);
-        if (tval != NULL) {
-          nlistSetList (itunes->songbyidx, lastval, entry);
-          slistSetNum (itunes->songbyname, tval, lastval);
-        } else {
-          nlistFree (entry);
-        }
-      }
-      entry = nlistAlloc ("itunes-entry", LIST_ORDERED, NULL);
-      lastval = atol (val);
-      ratingset = false;
-      skip = false;
-      continue;
+static void
+itunesParseEnd (void *udata, const char *name)
+{
+  itunesparse_t   *ip = udata;
+  int             type;
+
+  type = itunesParseElementType (name);
+
+  if (ip->intext) {
+    if (ip->text == NULL) {
+      /* empty element */
+      ip->textalloc = ITUNES_KEY_SZ;
+      ip->text = mdmalloc (ip->textalloc);
     }
-    if (skip) {
-      continue;
+    ip->text [ip->textlen] = '\0';
+    if (ip->depth == 3) {
+      stpecpy (ip->topkey, ip->topkey + sizeof (ip->topkey), ip->text);
+    } else if (type == ITUNES_EL_KEY) {
+      itunesParseKey (ip, ip->text);
+    } else {
+      itunesParseValue (ip, ip->text);
     }
+    ip->intext = false;
+  } else if (type == ITUNES_EL_TRUE && itunesParseIsValue (ip, type)) {
+    itunesParseValue (ip, "1");
+  }
 
-    if (strcmp (key, "Movie") == 0 ||
-        strcmp (key, "Has Video") == 0) {
-      skip = true;
-      logMsg (LOG_DBG, LOG_ITUNES, "song: skip-video");
-      continue;
+  if (ip->depth == ITUNES_DEPTH_REC && type == ITUNES_EL_DICT) {
+    if (ip->section == ITUNES_SECT_TRACKS) {
+      itunesTrackEnd (ip);
+    }
+    if (ip->section == ITUNES_SECT_PLAYLISTS) {
+      itunesPlaylistEnd (ip);
     }
+  }
 
-    if (strcmp (key, "Rating Computed") == 0) {
-      if (atoi (val) == 1) {
-        /* set the dance rating to unrated */
-        nlistSetNum (entry, TAG_DANCERATING, 0);
-        logMsg (LOG_DBG, LOG_ITUNES, "song: unrated");
-        ratingset = true;
-      }
-    } else if (strcmp (key, "Loved") == 0 ||
-        strcmp (key, "Disliked") == 0) {
-      if (atoi (val) == 1) {
-        datafileconv_t  conv;
-
-        conv.invt = VALUE_STR;
-        if (strcmp (key, "Loved") == 0) {
-          conv.str = "pinkheart";
-        }
-        if (strcmp (key, "Disliked") == 0) {
-          conv.str = "brokenheart";
-        }
-        songFavoriteConv (&conv);
-        nlistSetNum (entry, TAG_FAVORITE, conv.num);
-        logMsg (LOG_DBG, LOG_ITUNES, "song: %s %" PRId64 "",
-            tagdefs [TAG_FAVORITE].tag, conv.num);
-      }
-    } else {
-      int   tagidx;
+  if (ip->depth == 3 && ip->section != ITUNES_SECT_NONE) {
+    if (ip->section == ITUNES_SECT_TRACKS) {
+      /* the playlist processing needs to look up the songs */
+      nlistSort (ip->songbyidx);
+      slistSort (ip->songbyname);
+    }
+    ip->section = ITUNES_SECT_NONE;
+  }
 
-      /* if the key is in the list and has an associated tag */
-      tagidx = slistGetNum (itunes->itunesAvailFields, key);
-      if (tagidx < 0) {
-        continue;
-      }
+  ip->depth -= 1;
+}
 
-      if (tagidx == TAG_URI) {
-        bool    ok = false;
-        int     offset = 0;
+static void
+itunesParseText (void *udata, const char *text, size_t len)
+{
+  itunesparse_t   *ip = udata;
 
-        if (strncmp (val, ITUNES_LOCALHOST, strlen (ITUNES_LOCALHOST)) == 0) {
-          offset = strlen (ITUNES_LOCALHOST);
-          ok = true;
-        } else if (strncmp (val, ITUNES_LOCAL, strlen (ITUNES_LOCAL)) == 0) {
-          offset = strlen (ITUNES_LOCAL);
-          ok = true;
-        } else {
-          skip = true;
-        }
+  if (! ip->intext) {
+    return;
+  }
 
-        if (ok) {
-          char        *nstr;
+  if (ip->textlen + len + 1 > ip->textalloc) {
+    ip->textalloc = ip->textlen + len + 1;
+    if (ip->textalloc < ITUNES_KEY_SZ) {
+      ip->textalloc = ITUNES_KEY_SZ;
+    }
+    ip->textalloc *= 2;
+    ip->text = mdrealloc (ip->text, ip->textalloc);
+  }
+  memcpy (ip->text + ip->textlen, text, len);
+  ip->textlen += len;
+}
 
-          val += offset;
-          /* not sure that the string is decomposed */
-          nstr = g_uri_unescape_string (val, NULL);
-          mdextalloc (nstr);
+static int
+itunesParseElementType (const char *name)
+{
+  for (int i = 0; i < ITUNES_EL_COUNT; ++i) {
+    if (strcmp (name, itunesels [i].name) == 0) {
+      return itunesels [i].type;
+    }
+  }
 
-          val = audiosrcRelativePath (nstr, 0);
-          nlistSetStr (entry, tagidx, val);
-          logMsg (LOG_DBG, LOG_ITUNES, "song: %s %s", tagdefs [tagidx].tag, val);
-          mdfree (nstr);    // allocated by glib
-        }
-      } else if (tagidx == TAG_DBADDDATE) {
-        time_t    tmval;
-
-        /* 2023-01-03T18:34:58Z */
-        tmval = tmutilStringToUTC (val, "%FT%TZ");
-        nlistSetNum (entry, tagidx, tmval);
-        logMsg (LOG_DBG, LOG_ITUNES, "song: %s %" PRIu64, tagdefs [tagidx].tag, (uint64_t) tmval);
-      } else if (tagidx == TAG_DANCERATING) {
-        int   ratingidx;
-        int   tval;
-
-        if (ratingset) {
-          continue;
-        }
+  return ITUNES_EL_OTHER;
+}
 
-        tval = atoi (val);
-        tval = tval / 10 - 1;
-        ratingidx = nlistGetNum (itunes->stars, tval);
-        nlistSetNum (entry, tagidx, ratingidx);
-        logMsg (LOG_DBG, LOG_ITUNES, "song: %s %" PRId32, tagdefs [tagidx].tag, ratingidx);
-      } else if (tagidx == TAG_GENRE) {
-        datafileconv_t  conv;
-
-        conv.invt = VALUE_STR;
-        conv.str = val;
-        genreConv (&conv);
-        nlistSetNum (entry, tagidx, conv.num);
-        logMsg (LOG_DBG, LOG_ITUNES, "song: %s %" PRId64, tagdefs [tagidx].tag, conv.num);
-      } else {
-        /* start time and stop time are already in the correct format (ms) */
-        if (tagdefs [tagidx].valueType == VALUE_NUM) {
-          nlistSetNum (entry, tagidx, atoll (val));
-        }
-        if (tagdefs [tagidx].valueType == VALUE_STR) {
-          nlistSetStr (entry, tagidx, val);
-        }
-        logMsg (LOG_DBG, LOG_ITUNES, "song: %s %s", tagdefs [tagidx].tag, val);
-      }
+/* only the elements that were previously selected by xpath are values */
+/*   /plist/dict/dict/dict/{key|integer|string|date|true|false} */
+/*   /plist/dict/array/dict/{key|integer|string} */
+/*   /plist/dict/array/dict/array/dict/{key|integer} */
+static bool
+itunesParseIsValue (itunesparse_t *ip, int type)
+{
+  if (ip->depth == 3) {
+    return type == ITUNES_EL_KEY;
+  }
+
+  if (ip->depth == ITUNES_DEPTH_REC + 1 &&
+      ip->path [ITUNES_DEPTH_REC - 1] == ITUNES_EL_DICT) {
+    if (ip->section == ITUNES_SECT_TRACKS) {
+      return type == ITUNES_EL_KEY ||
+          type == ITUNES_EL_INTEGER ||
+          type == ITUNES_EL_STRING ||
+          type == ITUNES_EL_DATE ||
+          type == ITUNES_EL_TRUE;
+    }
+    if (ip->section == ITUNES_SECT_PLAYLISTS) {
+      return type == ITUNES_EL_KEY ||
+          type == ITUNES_EL_INTEGER ||
+          type == ITUNES_EL_STRING;
     }
   }
 
-  if (skip) {
-    nlistFree (entry);
+  if (ip->section == ITUNES_SECT_PLAYLISTS &&
+      ip->depth == ITUNES_DEPTH_ITEM + 1 &&
+      ip->path [ITUNES_DEPTH_REC] == ITUNES_EL_ARRAY &&
+      ip->path [ITUNES_DEPTH_ITEM - 1] == ITUNES_EL_DICT) {
+    return type == ITUNES_EL_KEY ||
+        type == ITUNES_EL_INTEGER;
   }
 
-  if (! skip) {
-    const char  *tval;
+  return false;
+}
 
-    tval = nlistGetStr (entry, TAG_URI);
-    if (tval != NULL) {
-      nlistSetList (itunes->songbyidx, lastval, entry);
-      slistSetNum (itunes->songbyname, tval, lastval);
-    } else {
-      nlistFree (entry);
-    }
+static void
+itunesParseKey (itunesparse_t *ip, const char *key)
+{
+  logMsg (LOG_DBG, LOG_ITUNES, "xml: key: %s", key);
+  /* a key with no value (false, array, data) is set to 0 */
+  itunesParseFlushKey (ip);
+  stpecpy (ip->lastkey, ip->lastkey + sizeof (ip->lastkey), key);
+  ip->valset = false;
+}
 
-    /* the itunes xml file does not appear to save the show-movement flag */
-    /* use our own setting to determine whether to use work/movement */
-    songutilTitleFromWorkMovement (entry);
+static void
+itunesParseValue (itunesparse_t *ip, const char *val)
+{
+  logMsg (LOG_DBG, LOG_ITUNES, "xml: val: %s %s", ip->lastkey, val);
+  if (ip->section == ITUNES_SECT_TRACKS) {
+    itunesTrackValue (ip, ip->lastkey, val);
   }
+  if (ip->section == ITUNES_SECT_PLAYLISTS) {
+    itunesPlaylistValue (ip, ip->lastkey, val);
+  }
+  ip->valset = true;
+}
 
-  slistFree (rawdata);
-  return true;
+static void
+itunesParseFlushKey (itunesparse_t *ip)
+{
+  if (! ip->valset) {
+    itunesParseValue (ip, "0");
+  }
 }
 
-static bool
-itunesParsePlaylists (itunes_t *itunes, xmlparse_t *xmlparse,
-    const char *xpathExpr)
+static void
+itunesTrackStart (itunesparse_t *ip)
 {
-  slist_t     *rawdata = NULL;
-  slistidx_t  iteridx;
-  const char  *key;
-  const char  *val;
-  char        keepname [1000];
-  nlist_t     *ids = NULL;
-  bool        skip = false;
-  bool        ismaster = false;
-
-  rawdata = slistAlloc ("itunes-pl-raw", LIST_UNORDERED, NULL);
-  if (! itunesParseXPath (xmlparse, xpathExpr, rawdata, plmainxpath)) {
-    slistFree (rawdata);
-    return false;
+  nlistFree (ip->entry);
+  ip->entry = nlistAlloc ("itunes-entry", LIST_ORDERED, NULL);
+  ip->trackid = -1;
+  ip->ratingset = false;
+  ip->skip = false;
+  ip->valset = true;
+  *ip->lastkey = '\0';
+}
+
+static void
+itunesTrackValue (itunesparse_t *ip, const char *key, const char *val)
+{
+  itunes_t    *itunes = ip->itunes;
+  nlist_t     *entry = ip->entry;
+
+  if (entry == NULL) {
+    return;
   }
 
-  *keepname = '\0';
-  slistFree (itunes->playlists);
-  itunes->playlists = slistAlloc ("itunes-playlists", LIST_ORDERED, NULL);
+  if (strcmp (key, "") == 0) {
+    return;
+  }
+  if (strcmp (key, "Track ID") == 0) {
+    ip->trackid = atol (val);
+    return;
+  }
+  if (ip->skip) {
+    return;
+  }
 
-  slistStartIterator (rawdata, &iteridx);
-  while ((key = slistIterateKey (rawdata, &iteridx)) != NULL) {
-    val = slistGetStr (rawdata, key);
+  if (strcmp (key, "Movie") == 0 ||
+      strcmp (key, "Has Video") == 0) {
+    ip->skip = true;
+    logMsg (LOG_DBG, LOG_ITUNES, "song: skip-video");
+    return;
+  }
 
-    if (strcmp (key, "Master") == 0) {
-      ismaster = true;
-      continue;
+  if (strcmp (key, "Rating Computed") == 0) {
+    if (atoi (val) == 1) {
+      /* set the dance rating to unrated */
+      nlistSetNum (entry, TAG_DANCERATING, 0);
+      logMsg (LOG_DBG, LOG_ITUNES, "song: unrated");
+      ip->ratingset = true;
     }
-    if (strcmp (key, "Playlist ID") == 0) {
-      if (! skip && ids != NULL && nlistGetCount (ids) == 0) {
-        slistFree (ids);
-        ids = NULL;
-      }
-      if (skip == false && *keepname && ids != NULL) {
-        slistSetList (itunes->playlists, keepname, ids);
-        /* it is possible for a playlist to not have an item list */
-        ids = NULL;
-      }
-      skip = false;
-      if (ismaster) {
-        skip = true;
-        ismaster = false;
+  } else if (strcmp (key, "Loved") == 0 ||
+      strcmp (key, "Disliked") == 0) {
+    if (atoi (val) == 1) {
+      datafileconv_t  conv;
+
+      conv.invt = VALUE_STR;
+      if (strcmp (key, "Loved") == 0) {
+        conv.str = "pinkheart";
       }
-      continue;
-    }
-    if (strcmp (key, "Playlist Items") == 0) {
-      ids = NULL;
-      if (! skip) {
-        ids = nlistAlloc ("itunes-pl-ids", LIST_UNORDERED, NULL);
-        skip = false;
+      if (strcmp (key, "Disliked") == 0) {
+        conv.str = "brokenheart";
       }
-      continue;
+      songFavoriteConv (&conv);
+      nlistSetNum (entry, TAG_FAVORITE, conv.num);
+      logMsg (LOG_DBG, LOG_ITUNES, "song: %s %" PRId64 "",
+          tagdefs [TAG_FAVORITE].tag, conv.num);
     }
-    if (skip) {
-      continue;
+  } else {
+    int   tagidx;
+
+    /* if the key is in the list and has an associated tag */
+    tagidx = slistGetNum (itunes->itunesAvailFields, key);
+    if (tagidx < 0) {
+      return;
     }
 
-    if (strcmp (key, "Distinguished Kind") == 0 ||
-        strcmp (key, "Smart Info") == 0) {
-      logMsg (LOG_DBG, LOG_ITUNES, "pl: skip");
-      skip = true;
-    } else if (strcmp (key, "Name") == 0) {
-      stpecpy (keepname, keepname + sizeof (keepname), val);
-      logMsg (LOG_DBG, LOG_ITUNES, "pl-name: %s", keepname);
-    } else if (strcmp (key, "Track ID") == 0) {
-      slist_t   *entry;
-      int32_t   tval;
-
-      tval = atoll (val);
-      entry = nlistGetList (itunes->songbyidx, tval);
-      if (entry != NULL) {
-        nlistSetNum (ids, tval, 1);
-        logMsg (LOG_DBG, LOG_ITUNES, "pl: %s %" PRId32, keepname, tval);
+    if (tagidx == TAG_URI) {
+      bool    ok = false;
+      int     offset = 0;
+
+      if (strncmp (val, ITUNES_LOCALHOST, strlen (ITUNES_LOCALHOST)) == 0) {
+        offset = strlen (ITUNES_LOCALHOST);
+        ok = true;
+      } else if (strncmp (val, ITUNES_LOCAL, strlen (ITUNES_LOCAL)) == 0) {
+        offset = strlen (ITUNES_LOCAL);
+        ok = true;
+      } else {
+        ip->skip = true;
+      }
+
+      if (ok) {
+        char        *nstr;
+
+        val += offset;
+        /* not sure that the string is decomposed */
+        nstr = g_uri_unescape_string (val, NULL);
+        mdextalloc (nstr);
+
+        val = audiosrcRelativePath (nstr, 0);
+        nlistSetStr (entry, tagidx, val);
+        logMsg (LOG_DBG, LOG_ITUNES, "song: %s %s", tagdefs [tagidx].tag, val);
+        mdfree (nstr);    // allocated by glib
+      }
+    } else if (tagidx == TAG_DBADDDATE) {
+      time_t    tmval;
+
+      /* 2023-01-03T18:34:58Z */
+      tmval = tmutilStringToUTC (val, "%FT%TZ");
+      nlistSetNum (entry, tagidx, tmval);
+      logMsg (LOG_DBG, LOG_ITUNES, "song: %s %" PRIu64, tagdefs [tagidx].tag, (uint64_t) tmval);
+    } else if (tagidx == TAG_DANCERATING) {
+      int   ratingidx;
+      int   tval;
+
+      if (ip->ratingset) {
+        return;
+      }
+
+      tval = atoi (val);
+      tval = tval / 10 - 1;
+      ratingidx = nlistGetNum (itunes->stars, tval);
+      nlistSetNum (entry, tagidx, ratingidx);
+      logMsg (LOG_DBG, LOG_ITUNES, "song: %s %" PRId32, tagdefs [tagidx].tag, ratingidx);
+    } else if (tagidx == TAG_GENRE) {
+      datafileconv_t  conv;
+
+      conv.invt = VALUE_STR;
+      conv.str = val;
+      genreConv (&conv);
+      nlistSetNum (entry, tagidx, conv.num);
+      logMsg (LOG_DBG, LOG_ITUNES, "song: %s %" PRId64, tagdefs [tagidx].tag, conv.num);
+    } else {
+      /* start time and stop time are already in the correct format (ms) */
+      if (tagdefs [tagidx].valueType == VALUE_NUM) {
+        nlistSetNum (entry, tagidx, atoll (val));
       }
+      if (tagdefs [tagidx].valueType == VALUE_STR) {
+        nlistSetStr (entry, tagidx, val);
+      }
+      logMsg (LOG_DBG, LOG_ITUNES, "song: %s %s", tagdefs [tagidx].tag, val);
     }
   }
+}
+
+static void
+itunesTrackEnd (itunesparse_t *ip)
+{
+  const char  *tval = NULL;
+
+  itunesParseFlushKey (ip);
 
-  if (! skip && ids != NULL && nlistGetCount (ids) == 0) {
-    slistFree (ids);
-    ids = NULL;
+  if (ip->entry != NULL) {
+    tval = nlistGetStr (ip->entry, TAG_URI);
   }
-  if (skip == false && *keepname && ids != NULL) {
-    slistSetList (itunes->playlists, keepname, ids);
+  if (! ip->skip && ip->trackid >= 0 && tval != NULL) {
+    /* the itunes xml file does not appear to save the show-movement flag */
+    /* use our own setting to determine whether to use work/movement */
+    songutilTitleFromWorkMovement (ip->entry);
+    if (nlistGetCount (ip->songbyidx) >= ip->songalloc) {
+      /* the song count is not known ahead of time */
+      ip->songalloc += ip->songalloc > 0 ? ip->songalloc : ITUNES_SONG_ALLOC;
+      nlistSetSize (ip->songbyidx, ip->songalloc);
+      slistSetSize (ip->songbyname, ip->songalloc);
+    }
+    nlistSetList (ip->songbyidx, ip->trackid, ip->entry);
+    slistSetNum (ip->songbyname, tval, ip->trackid);
+  } else {
+    nlistFree (ip->entry);
   }
+  ip->entry = NULL;
+}
 
-  slistFree (rawdata);
-  return true;
+static void
+itunesPlaylistStart (itunesparse_t *ip)
+{
+  nlistFree (ip->ids);
+  ip->ids = NULL;
+  *ip->plname = '\0';
+  ip->skip = false;
+  ip->valset = true;
+  *ip->lastkey = '\0';
 }
 
-static bool
-itunesParseXPath (xmlparse_t *xmlparse, const char *xpathExpr,
-    slist_t *rawdata, const char *mainxpath)
-{
-  char          lastkey [50];
-  bool          valset = true;
-  ilist_t       *tlist;
-  ilistidx_t    iteridx;
-  ilistidx_t    key;
-
-  tlist = xmlParseGetList (xmlparse, xpathExpr, NULL);
-
-  /* itunes just dumps everything into a dict structure. */
-  /* poor use of xml */
-  ilistStartIterator (tlist, &iteridx);
-  while ((key = ilistIterateKey (tlist, &iteridx)) >= 0) {
-    const char *val;
-    const char *nm;
-
-    val = ilistGetStr (tlist, key, XMLPARSE_VAL);
-    nm = ilistGetStr (tlist, key, XMLPARSE_NM);
-    logMsg (LOG_DBG, LOG_ITUNES, "xml: raw: %s %s", nm, val);
-    // fprintf (stderr, "i: %s %s\n", nm, val);
-    if (strcmp (nm, "key") == 0) {
-      if (! valset) {
-        slistSetStr (rawdata, lastkey, "0");
-        // fprintf (stderr, "  0: %s 0\n", lastkey);
-      }
-      stpecpy (lastkey, lastkey + sizeof (lastkey), val);
-      valset = false;
-    }
-    if (strcmp (nm, "integer") == 0 ||
-        strcmp (nm, "string") == 0 ||
-        strcmp (nm, "date") == 0) {
-      slistSetStr (rawdata, lastkey, (const char *) val);
-      // fprintf (stderr, "  s: %s\n", val);
-      valset = true;
+static void
+itunesPlaylistValue (itunesparse_t *ip, const char *key, const char *val)
+{
+  if (strcmp (key, "Master") == 0) {
+    ip->skip = true;
+    return;
+  }
+  if (strcmp (key, "Playlist Items") == 0) {
+    if (! ip->skip && ip->ids == NULL) {
+      ip->ids = nlistAlloc ("itunes-pl-ids", LIST_UNORDERED, NULL);
     }
-    if (strcmp (nm, "true") == 0) {
-      slistSetStr (rawdata, lastkey, (const char *) "1");
-      // fprintf (stderr, "  b: %s\n", "1");
-      valset = true;
+    return;
+  }
+  if (ip->skip) {
+    return;
+  }
+
+  if (strcmp (key, "Distinguished Kind") == 0 ||
+      strcmp (key, "Smart Info") == 0) {
+    logMsg (LOG_DBG, LOG_ITUNES, "pl: skip");
+    ip->skip = true;
+  } else if (strcmp (key, "Name") == 0) {
+    stpecpy (ip->plname, ip->plname + sizeof (ip->plname), val);
+    logMsg (LOG_DBG, LOG_ITUNES, "pl-name: %s", ip->plname);
+  } else if (strcmp (key, "Track ID") == 0 && ip->ids != NULL) {
+    int32_t   tval;
+
+    /* itunes writes the tracks before the playlists */
+    tval = atoll (val);
+    if (nlistGetList (ip->songbyidx, tval) != NULL) {
+      nlistSetNum (ip->ids, tval, 1);
+      logMsg (LOG_DBG, LOG_ITUNES, "pl: %s %" PRId32, ip->plname, tval);
     }
   }
+}
 
-  ilistFree (tlist);
-  return true;
+static void
+itunesPlaylistEnd (itunesparse_t *ip)
+{
+  itunesParseFlushKey (ip);
+
+  /* it is possible for a playlist to not have an item list */
+  if (! ip->skip && *ip->plname && ip->ids != NULL &&
+      nlistGetCount (ip->ids) > 0) {
+    slistSetList (ip->playlists, ip->plname, ip->ids);
+    ip->ids = NULL;
+  }
+  nlistFree (ip->ids);
+  ip->ids = NULL;
+}
+
+static void
+itunesParseCleanup (itunesparse_t *ip)
+{
+  dataFree (ip->text);
+  ip->text = NULL;
+  nlistFree (ip->entry);
+  ip->entry = NULL;
+  nlistFree (ip->ids);
+  ip->ids = NULL;
 }
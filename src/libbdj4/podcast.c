@@ -34,8 +34,11 @@ typedef struct podcast {
 
 /* must be sorted in ascii order */
 static datafilekey_t podcastdfkeys [PODCAST_KEY_MAX] = {
+  { "ETAG",           PODCAST_ETAG,           VALUE_STR, NULL, DF_NORM },
   { "IMAGE_URI",      PODCAST_IMAGE_URI,      VALUE_STR, NULL, DF_NORM },
   { "LASTBLDDATE",    PODCAST_LAST_BLD_DATE,  VALUE_STR, NULL, DF_NORM },
+  { "LASTGUID",       PODCAST_LAST_GUID,      VALUE_STR, NULL, DF_NORM },
+  { "LASTMODIFIED",   PODCAST_LAST_MODIFIED,  VALUE_STR, NULL, DF_NORM },
   { "RETAIN",         PODCAST_RETAIN,         VALUE_NUM, NULL, DF_NORM },
   { "TITLE",          PODCAST_TITLE,          VALUE_STR, NULL, DF_NORM },
   { "URI",            PODCAST_URI,            VALUE_STR, NULL, DF_NORM },
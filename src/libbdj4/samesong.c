@@ -19,15 +19,20 @@
 #include "song.h"
 #include "tagdef.h"
 
+/* the members of each same-song mark are kept, so that setting */
+/* and clearing a mark only touches the songs that change. */
+/* the dbidx -> mark look-up is the song's same-song tag */
 typedef struct samesong {
   musicdb_t *musicdb;
   nlist_t   *sscolors;
-  nlist_t   *sscounts;
+  nlist_t   *ssmembers;
   ssize_t   nextssidx;
 } samesong_t;
 
 static ssize_t  samesongGetSSIdx (samesong_t *ss, dbidx_t dbidx);
-static void     samesongCleanSingletons (samesong_t *ss);
+static void     samesongAddMember (samesong_t *ss, ssize_t ssidx, dbidx_t dbidx);
+static void     samesongRemoveMember (samesong_t *ss, ssize_t ssidx, dbidx_t dbidx, nlist_t *changed);
+static void     samesongCheckSingletons (samesong_t *ss, nlist_t *changed);
 
 BDJ_NODISCARD
 samesong_t *
@@ -35,12 +40,11 @@ samesongAlloc (musicdb_t *musicdb)
 {
   samesong_t  *ss;
   slistidx_t  dbiteridx;
+  nlistidx_t  iteridx;
   dbidx_t     dbidx;
   song_t      *song;
   ssize_t     ssidx;
-  const char  *sscolor;
   char        tbuff [80];
-  int         val;
 
 
   ss = mdmalloc (sizeof (samesong_t));
@@ -48,31 +52,28 @@ samesongAlloc (musicdb_t *musicdb)
   ss->nextssidx = 1;
   ss->musicdb = musicdb;
   ss->sscolors = nlistAlloc ("samesong-colors", LIST_ORDERED, NULL);
-  ss->sscounts = nlistAlloc ("samesong-count", LIST_ORDERED, NULL);
+  ss->ssmembers = nlistAlloc ("samesong-members", LIST_ORDERED, NULL);
 
   dbStartIterator (musicdb, &dbiteridx);
   while ((song = dbIterate (musicdb, &dbidx, &dbiteridx)) != NULL) {
     ssidx = songGetNum (song, TAG_SAMESONG);
     if (ssidx > 0) {
-      sscolor = nlistGetStr (ss->sscolors, ssidx);
-      if (sscolor == NULL) {
-        createRandomColor (tbuff, sizeof (tbuff));
-        nlistSetStr (ss->sscolors, ssidx, tbuff);
-        val = 1;
-      } else {
-        val = nlistGetNum (ss->sscounts, ssidx);
-        ++val;
-      }
-      nlistSetNum (ss->sscounts, ssidx, val);
+      samesongAddMember (ss, ssidx, dbidx);
       if (ssidx >= ss->nextssidx) {
         ss->nextssidx = ssidx + 1;
       }
     }
   }
 
-  /* clean up singletons for display purposes */
+  /* singletons are not colored, for display purposes */
   /* the real clean-up of the database will go elsewhere */
-  samesongCleanSingletons (ss);
+  nlistStartIterator (ss->ssmembers, &iteridx);
+  while ((ssidx = nlistIterateKey (ss->ssmembers, &iteridx)) >= 0) {
+    if (nlistGetCount (nlistGetList (ss->ssmembers, ssidx)) > 1) {
+      createRandomColor (tbuff, sizeof (tbuff));
+      nlistSetStr (ss->sscolors, ssidx, tbuff);
+    }
+  }
 
   return ss;
 }
@@ -83,8 +84,8 @@ samesongFree (samesong_t *ss)
   if (ss != NULL) {
     nlistFree (ss->sscolors);
     ss->sscolors = NULL;
-    nlistFree (ss->sscounts);
-    ss->sscounts = NULL;
+    nlistFree (ss->ssmembers);
+    ss->ssmembers = NULL;
     mdfree (ss);
   }
 }
@@ -114,6 +115,17 @@ samesongGetColorBySSIdx  (samesong_t *ss, ssize_t ssidx)
   return sscolor;
 }
 
+/* returns the number of songs with the same-song mark */
+int
+samesongGetCount (samesong_t *ss, ssize_t ssidx)
+{
+  if (ss == NULL || ss->ssmembers == NULL || ssidx <= 0) {
+    return 0;
+  }
+
+  return nlistGetCount (nlistGetList (ss->ssmembers, ssidx));
+}
+
 void
 samesongSet (samesong_t *ss, nlist_t *dbidxlist)
 {
@@ -126,6 +138,7 @@ samesongSet (samesong_t *ss, nlist_t *dbidxlist)
   ssize_t     lastssidx;
   ssize_t     usessidx = -1;
   ssize_t     ssidx;
+  nlist_t     *changed;
 
   /* this is more complicated than it might seem */
   /* using the following process makes the same-song */
@@ -165,24 +178,6 @@ samesongSet (samesong_t *ss, nlist_t *dbidxlist)
     }
   }
 
-  /* more than one different mark */
-  /* or a single mark with no unset marks */
-  /* adjust the current counts for the entire target list */
-  if (count > 1 ||
-     (count == 1 && ! hasunset)) {
-    int   val;
-
-    nlistStartIterator (dbidxlist, &iteridx);
-    while ((dbidx = nlistIterateKey (dbidxlist, &iteridx)) >= 0) {
-      ssidx = samesongGetSSIdx (ss, dbidx);
-      if (ssidx > 0) {
-        val = nlistGetNum (ss->sscounts, ssidx);
-        --val;
-        nlistSetNum (ss->sscounts, ssidx, val);
-      }
-    }
-  }
-
   *tbuff = '\0';
 
   /* more than one different mark or zero marks */
@@ -199,13 +194,19 @@ samesongSet (samesong_t *ss, nlist_t *dbidxlist)
   /* only one mark found in the target list */
   /* and there are unset marks */
   if (count == 1 && hasunset) {
-    sscolor = nlistGetStr (ss->sscolors, lastssidx);
     usessidx = lastssidx;
+    sscolor = nlistGetStr (ss->sscolors, usessidx);
+    if (sscolor == NULL) {
+      /* the mark was a singleton, and has no color */
+      createRandomColor (tbuff, sizeof (tbuff));
+      nlistSetStr (ss->sscolors, usessidx, tbuff);
+    }
   }
 
+  /* only the marks that lose a song need to be checked afterwards */
+  changed = nlistAlloc ("samesong-changed", LIST_ORDERED, NULL);
   nlistStartIterator (dbidxlist, &iteridx);
   while ((dbidx = nlistIterateKey (dbidxlist, &iteridx)) >= 0) {
-    int     val;
     ssize_t oldssidx;
     song_t  *song;
 
@@ -215,31 +216,29 @@ samesongSet (samesong_t *ss, nlist_t *dbidxlist)
     }
 
     oldssidx = songGetNum (song, TAG_SAMESONG);
-    songSetNum (song, TAG_SAMESONG, usessidx);
-    val = nlistGetNum (ss->sscounts, usessidx);
-    if (val < 0) {
-      val = 1;
-    } else {
-      /* if not already set or changed */
-      if (oldssidx != usessidx) {
-        ++val;
-      }
+    if (oldssidx == usessidx) {
+      continue;
     }
-    nlistSetNum (ss->sscounts, usessidx, val);
+    samesongRemoveMember (ss, oldssidx, dbidx, changed);
+    songSetNum (song, TAG_SAMESONG, usessidx);
+    samesongAddMember (ss, usessidx, dbidx);
   }
+  nlistSetNum (changed, usessidx, 0);
 
-  samesongCleanSingletons (ss);
+  samesongCheckSingletons (ss, changed);
+  nlistFree (changed);
 }
 
 void
 samesongClear (samesong_t *ss, nlist_t *dbidxlist)
 {
-  int           val;
   dbidx_t       dbidx;
   nlistidx_t    iteridx;
   ssize_t       ssidx;
   song_t        *song;
+  nlist_t       *changed;
 
+  changed = nlistAlloc ("samesong-changed", LIST_ORDERED, NULL);
   nlistStartIterator (dbidxlist, &iteridx);
   while ((dbidx = nlistIterateKey (dbidxlist, &iteridx)) >= 0) {
     song = dbGetByIdx (ss->musicdb, dbidx);
@@ -247,14 +246,13 @@ samesongClear (samesong_t *ss, nlist_t *dbidxlist)
       continue;
     }
 
+    ssidx = songGetNum (song, TAG_SAMESONG);
+    samesongRemoveMember (ss, ssidx, dbidx, changed);
     songSetNum (song, TAG_SAMESONG, LIST_VALUE_INVALID);
-    ssidx = samesongGetSSIdx (ss, dbidx);
-    val = nlistGetNum (ss->sscounts, ssidx);
-    --val;
-    nlistSetNum (ss->sscounts, ssidx, val);
   }
 
-  samesongCleanSingletons (ss);
+  samesongCheckSingletons (ss, changed);
+  nlistFree (changed);
 }
 
 /* internal routines */
@@ -275,19 +273,49 @@ samesongGetSSIdx (samesong_t *ss, dbidx_t dbidx)
 }
 
 static void
-samesongCleanSingletons (samesong_t *ss)
+samesongAddMember (samesong_t *ss, ssize_t ssidx, dbidx_t dbidx)
+{
+  nlist_t   *members;
+
+  members = nlistGetList (ss->ssmembers, ssidx);
+  if (members == NULL) {
+    members = nlistAlloc ("samesong-mark", LIST_ORDERED, NULL);
+    nlistSetList (ss->ssmembers, ssidx, members);
+  }
+  nlistSetNum (members, dbidx, 0);
+}
+
+static void
+samesongRemoveMember (samesong_t *ss, ssize_t ssidx, dbidx_t dbidx,
+    nlist_t *changed)
+{
+  nlist_t   *members;
+
+  if (ssidx <= 0) {
+    return;
+  }
+
+  members = nlistGetList (ss->ssmembers, ssidx);
+  nlistDelete (members, dbidx);
+  nlistSetNum (changed, ssidx, 0);
+}
+
+/* a mark with a single song is not displayed */
+static void
+samesongCheckSingletons (samesong_t *ss, nlist_t *changed)
 {
   nlistidx_t  iteridx;
   ssize_t     ssidx;
-  int         val;
+  int         count;
 
-  nlistStartIterator (ss->sscounts, &iteridx);
-  while ((ssidx = nlistIterateKey (ss->sscounts, &iteridx)) >= 0) {
-    val = nlistGetNum (ss->sscounts, ssidx);
-    if (val == 1) {
+  nlistStartIterator (changed, &iteridx);
+  while ((ssidx = nlistIterateKey (changed, &iteridx)) >= 0) {
+    count = samesongGetCount (ss, ssidx);
+    if (count <= 1) {
       nlistSetStr (ss->sscolors, ssidx, NULL);
     }
+    if (count == 0) {
+      nlistDelete (ss->ssmembers, ssidx);
+    }
   }
 }
-
-
@@ -87,6 +87,10 @@ static datafilekey_t songdfkeys [] = {
   { "GROUPING",             TAG_GROUPING,             VALUE_STR, NULL, DF_NORM },
   { "KEYWORD",              TAG_KEYWORD,              VALUE_STR, NULL, DF_NORM },
   { "LASTUPDATED",          TAG_LAST_UPDATED,         VALUE_NUM, NULL, DF_NORM },
+  { "LOUDNESS",             TAG_LOUDNESS,             VALUE_DOUBLE, NULL, DF_NORM },
+  { "LOUDNESSADJ",          TAG_LOUDNESS_ADJ,         VALUE_DOUBLE, NULL, DF_NORM },
+  { "LOUDNESSCHK",          TAG_LOUDNESS_CHK,         VALUE_STR, NULL, DF_NORM },
+  { "LOUDNESSPEAK",         TAG_LOUDNESS_PEAK,        VALUE_DOUBLE, NULL, DF_NORM },
   { "MOVEMENTCOUNT",        TAG_MOVEMENTCOUNT,        VALUE_NUM, NULL, DF_NORM },
   { "MOVEMENTNAME",         TAG_MOVEMENTNAME,         VALUE_STR, NULL, DF_NORM },
   { "MOVEMENTNUM",          TAG_MOVEMENTNUM,          VALUE_NUM, NULL, DF_NORM },
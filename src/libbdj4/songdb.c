@@ -9,6 +9,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <inttypes.h>
 
 #include "bdj4.h"
 #include "audiofile.h"
@@ -26,27 +27,43 @@
 #include "musicdb.h"
 #include "orgutil.h"
 #include "pathinfo.h"
-#include "playlist.h"
 #include "slist.h"
 #include "song.h"
 #include "songdb.h"
 #include "songlist.h"
+#include "songlistidx.h"
 #include "tagdef.h"
+#include "tmutil.h"
 
 enum {
   SONGDB_IDENT = 0xaa006264676e6f73,
 };
 
+/* a pending song list change, keyed by the song's uri before the change */
+typedef struct {
+  char        *newuri;
+  char        *title;
+  ilistidx_t  dance;
+} songdbslupd_t;
+
 typedef struct songdb {
   uint64_t  ident;
   musicdb_t *musicdb;
   org_t     *org;
   org_t     *orgold;
+  slist_t   *plan;
+  slist_t   *collisions;
+  slist_t   *slupd;
+  bool      inbatch;
 } songdb_t;
 
 static bool songdbNewName (songdb_t *songdb, song_t *song, char *newuri, size_t sz);
 static void songdbWriteAudioTags (song_t *song, int forceflag);
 static void songdbUpdateAllSonglists (song_t *song, const char *olduri);
+static void songdbSonglistChange (slist_t *slupd, song_t *song, const char *olduri);
+static void songdbUpdateSonglists (slist_t *slupd);
+static void songdbSonglistUpdFree (void *data);
+static void songdbBatchFree (songdb_t *songdb);
 
 BDJ_NODISCARD
 songdb_t *
@@ -62,6 +79,10 @@ songdbAlloc (musicdb_t *musicdb)
   torgpath = bdjoptGetStr (OPT_G_ORGPATH);
   songdb->org = orgAlloc (torgpath);
   songdb->orgold = NULL;
+  songdb->plan = NULL;
+  songdb->collisions = NULL;
+  songdb->slupd = NULL;
+  songdb->inbatch = false;
   if (strstr (torgpath, "BYPASS") != NULL) {
     songdb->orgold = orgAlloc (bdjoptGetStr (OPT_G_OLDORGPATH));
   }
@@ -80,6 +101,7 @@ songdbFree (songdb_t *songdb)
   orgFree (songdb->org);
   songdb->org = NULL;
   orgFree (songdb->orgold);
+  songdbBatchFree (songdb);
   mdfree (songdb);
 }
 
@@ -93,6 +115,113 @@ songdbSetMusicDB (songdb_t *songdb, musicdb_t *musicdb)
   songdb->musicdb = musicdb;
 }
 
+/* while in a batch, the song list changes are saved, and all of the */
+/* song lists are updated once by songdbEndBatch() */
+void
+songdbStartBatch (songdb_t *songdb)
+{
+  if (songdb == NULL || songdb->ident != SONGDB_IDENT) {
+    return;
+  }
+  if (songdb->inbatch) {
+    return;
+  }
+
+  songdb->inbatch = true;
+  songdb->slupd = slistAlloc ("songdb-sl-upd", LIST_ORDERED,
+      songdbSonglistUpdFree);
+}
+
+/* builds the new names for all of the songs in the database before */
+/* any file is moved.  songs with the same new name, or whose new */
+/* name is an existing file, are not renamed. */
+/* the plan is only valid until the end of the batch */
+void
+songdbPlanRenames (songdb_t *songdb)
+{
+  slist_t     *targets;
+  slistidx_t  iteridx;
+  song_t      *song;
+  dbidx_t     dbidx;
+  const char  *uri;
+  const char  *prevffn;
+  char        newuri [BDJ4_PATH_MAX];
+  char        newffn [BDJ4_PATH_MAX];
+  mstime_t    tm;
+
+  if (songdb == NULL || songdb->ident != SONGDB_IDENT ||
+      songdb->musicdb == NULL || ! songdb->inbatch) {
+    return;
+  }
+
+  mstimestart (&tm);
+  slistFree (songdb->plan);
+  slistFree (songdb->collisions);
+  songdb->plan = slistAlloc ("songdb-plan", LIST_UNORDERED, NULL);
+  slistSetSize (songdb->plan, dbCount (songdb->musicdb));
+  songdb->collisions = slistAlloc ("songdb-collisions", LIST_ORDERED, NULL);
+  targets = slistAlloc ("songdb-targets", LIST_UNORDERED, NULL);
+
+  dbStartIterator (songdb->musicdb, &iteridx);
+  while ((song = dbIterate (songdb->musicdb, &dbidx, &iteridx)) != NULL) {
+    uri = songGetStr (song, TAG_URI);
+    if (uri == NULL) {
+      continue;
+    }
+
+    *newuri = '\0';
+    if (songdbNewName (songdb, song, newuri, sizeof (newuri))) {
+      audiosrcFullPath (newuri, newffn, sizeof (newffn), uri,
+          songGetNum (song, TAG_PREFIX_LEN));
+      slistSetNum (targets, newffn, 0);
+      if (fileopFileExists (newffn)) {
+        slistSetNum (songdb->collisions, newffn, 0);
+      }
+    }
+    /* the songs that do not need to be moved are in the plan also, */
+    /* so that their new names are not built again */
+    slistSetStr (songdb->plan, uri, newuri);
+  }
+  slistSort (songdb->plan);
+  slistSort (targets);
+
+  /* after the sort, any duplicate names are next to each other */
+  prevffn = NULL;
+  slistStartIterator (targets, &iteridx);
+  while ((uri = slistIterateKey (targets, &iteridx)) != NULL) {
+    if (prevffn != NULL && strcmp (uri, prevffn) == 0) {
+      slistSetNum (songdb->collisions, uri, 0);
+    }
+    prevffn = uri;
+  }
+
+  logMsg (LOG_DBG, LOG_IMPORTANT, "songdb: plan: %" PRId32 " renames %" PRId32 " collisions %" PRId64 " ms",
+      slistGetCount (targets), slistGetCount (songdb->collisions),
+      (int64_t) mstimeend (&tm));
+  slistFree (targets);
+}
+
+void
+songdbEndBatch (songdb_t *songdb)
+{
+  mstime_t    tm;
+
+  if (songdb == NULL || songdb->ident != SONGDB_IDENT) {
+    return;
+  }
+  if (! songdb->inbatch) {
+    return;
+  }
+
+  mstimestart (&tm);
+  if (slistGetCount (songdb->slupd) > 0) {
+    songdbUpdateSonglists (songdb->slupd);
+  }
+  logMsg (LOG_DBG, LOG_IMPORTANT, "songdb: batch: %" PRId32 " song list changes %" PRId64 " ms",
+      slistGetCount (songdb->slupd), (int64_t) mstimeend (&tm));
+  songdbBatchFree (songdb);
+}
+
 void
 songdbWriteDB (songdb_t *songdb, dbidx_t dbidx, int forceflag)
 {
@@ -159,7 +288,17 @@ songdbWriteDBSong (songdb_t *songdb, song_t *song, int *flags, dbidx_t rrn)
   *newuri = '\0';
 
   if (renameallow) {
-    if (songdbNewName (songdb, song, newuri, sizeof (newuri))) {
+    const char  *planned = NULL;
+
+    if (songdb->plan != NULL) {
+      planned = slistGetStr (songdb->plan, olduri);
+    }
+    if (planned != NULL) {
+      if (*planned) {
+        stpecpy (newuri, newuri + sizeof (newuri), planned);
+        dorename = true;
+      }
+    } else if (songdbNewName (songdb, song, newuri, sizeof (newuri))) {
       dorename = true;
     }
   }
@@ -183,6 +322,12 @@ songdbWriteDBSong (songdb_t *songdb, song_t *song, int *flags, dbidx_t rrn)
       *flags |= SONGDB_RET_REN_FILE_EXISTS;
       dorename = false;
     }
+    if (dorename && songdb->collisions != NULL &&
+        slistGetIdx (songdb->collisions, newffn) >= 0) {
+      /* another song in the batch has the same new name */
+      *flags |= SONGDB_RET_REN_FILE_EXISTS;
+      dorename = false;
+    }
 
     if (dorename) {
       pi = pathInfo (newffn);
@@ -287,7 +432,11 @@ songdbWriteDBSong (songdb_t *songdb, song_t *song, int *flags, dbidx_t rrn)
 
   if (songHasSonglistChange (song) || renamesuccess) {
     /* need to update all songlists if file/title/dance changed. */
-    songdbUpdateAllSonglists (song, olduri);
+    if (songdb->inbatch) {
+      songdbSonglistChange (songdb->slupd, song, olduri);
+    } else {
+      songdbUpdateAllSonglists (song, olduri);
+    }
   }
   songClearChanged (song);
 
@@ -381,22 +530,44 @@ songdbWriteAudioTags (song_t *song, int32_t flags)
 static void
 songdbUpdateAllSonglists (song_t *song, const char *olduri)
 {
-  slist_t     *filelist;
-  slistidx_t  fiteridx;
-  const char  *slfn;
-  const char  *songuri;
-  const char  *newuri = NULL;
-  songlist_t  *songlist;
-  ilistidx_t  sliter;
-
-  if (olduri != NULL) {
-    songuri = olduri;
-    newuri = songGetStr (song, TAG_URI);
-  } else {
-    songuri = songGetStr (song, TAG_URI);
+  slist_t     *slupd;
+
+  slupd = slistAlloc ("songdb-sl-upd", LIST_ORDERED, songdbSonglistUpdFree);
+  songdbSonglistChange (slupd, song, olduri);
+  songdbUpdateSonglists (slupd);
+  slistFree (slupd);
+}
+
+static void
+songdbSonglistChange (slist_t *slupd, song_t *song, const char *olduri)
+{
+  songdbslupd_t *upd;
+  const char    *title;
+
+  upd = mdmalloc (sizeof (songdbslupd_t));
+  upd->newuri = mdstrdup (songGetStr (song, TAG_URI));
+  upd->title = NULL;
+  title = songGetStr (song, TAG_TITLE);
+  if (title != NULL) {
+    upd->title = mdstrdup (title);
   }
+  upd->dance = songGetNum (song, TAG_DANCE);
+  slistSetData (slupd, olduri, upd);
+}
 
-  filelist = playlistGetPlaylistNames (PL_LIST_SONGLIST, NULL);
+/* each song list that contains any of the changed songs is loaded */
+/* and saved once */
+static void
+songdbUpdateSonglists (slist_t *slupd)
+{
+  slist_t       *filelist;
+  slistidx_t    fiteridx;
+  const char    *slfn;
+  songlist_t    *songlist;
+  ilistidx_t    sliter;
+  songdbslupd_t *upd;
+
+  filelist = songlistidxGetSonglistsByList (slupd);
   slistStartIterator (filelist, &fiteridx);
   while ((slfn = slistIterateKey (filelist, &fiteridx)) != NULL) {
     ilistidx_t  key;
@@ -411,16 +582,14 @@ songdbUpdateAllSonglists (song_t *song, const char *olduri)
       if (tfn == NULL) {
         continue;
       }
-      if (strcmp (tfn, songuri) == 0) {
-        if (newuri != NULL) {
-          songlistSetStr (songlist, key, SONGLIST_URI, newuri);
-        }
-        songlistSetStr (songlist, key, SONGLIST_TITLE,
-            songGetStr (song, TAG_TITLE));
-        songlistSetNum (songlist, key, SONGLIST_DANCE,
-            songGetNum (song, TAG_DANCE));
-        chg = true;
+      upd = slistGetData (slupd, tfn);
+      if (upd == NULL) {
+        continue;
       }
+      songlistSetStr (songlist, key, SONGLIST_URI, upd->newuri);
+      songlistSetStr (songlist, key, SONGLIST_TITLE, upd->title);
+      songlistSetNum (songlist, key, SONGLIST_DANCE, upd->dance);
+      chg = true;
     }
     if (chg) {
       songlistSave (songlist, SONGLIST_PRESERVE_TIMESTAMP, SONGLIST_USE_DIST_VERSION);
@@ -429,3 +598,28 @@ songdbUpdateAllSonglists (song_t *song, const char *olduri)
   }
   slistFree (filelist);
 }
+
+static void
+songdbSonglistUpdFree (void *data)
+{
+  songdbslupd_t *upd = data;
+
+  if (upd == NULL) {
+    return;
+  }
+  dataFree (upd->newuri);
+  dataFree (upd->title);
+  mdfree (upd);
+}
+
+static void
+songdbBatchFree (songdb_t *songdb)
+{
+  slistFree (songdb->plan);
+  songdb->plan = NULL;
+  slistFree (songdb->collisions);
+  songdb->collisions = NULL;
+  slistFree (songdb->slupd);
+  songdb->slupd = NULL;
+  songdb->inbatch = false;
+}
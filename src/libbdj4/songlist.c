@@ -21,6 +21,7 @@
 #include "pathbld.h"
 #include "pathinfo.h"
 #include "songlist.h"
+#include "songlistidx.h"
 
 enum {
   SONGLIST_VERSION = 1,
@@ -219,6 +220,7 @@ void
 songlistSave (songlist_t *sl, int tmflag, int distvers)
 {
   time_t    origtm = 0;
+  char      tfn [BDJ4_PATH_MAX];
 
   if (sl == NULL || sl->ident != SONGLIST_IDENT || sl->songlist == NULL) {
     return;
@@ -238,6 +240,13 @@ songlistSave (songlist_t *sl, int tmflag, int distvers)
   if (tmflag == SONGLIST_PRESERVE_TIMESTAMP) {
     fileopSetModTime (sl->path, origtm);
   }
+
+  /* only the song lists in the data directory are indexed */
+  pathbldMakePath (tfn, sizeof (tfn), sl->fname,
+      BDJ4_SONGLIST_EXT, PATHBLD_MP_DREL_DATA);
+  if (strcmp (tfn, sl->path) == 0) {
+    songlistidxUpdate (sl->fname, sl);
+  }
 }
 
 int
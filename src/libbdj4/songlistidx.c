@@ -0,0 +1,522 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+/*
+ * song list index
+ *
+ * For each song list, the set of song uris it contains is saved,
+ * so that a song rename only needs to load and save the song lists
+ * that contain the song.
+ *
+ * Each song list's modification time and size are saved with its
+ * entry.  Before a look-up, the song lists in the data directory are
+ * checked, and any song list that is new or has changed is re-scanned.
+ * Removed song lists are dropped from the index.
+ *
+ * The index is updated by songlistSave().
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "bdj4.h"
+#include "bdjstring.h"
+#include "dirlist.h"
+#include "filemanip.h"
+#include "fileop.h"
+#include "log.h"
+#include "mdebug.h"
+#include "nodiscard.h"
+#include "pathbld.h"
+#include "pathinfo.h"
+#include "slist.h"
+#include "songlist.h"
+#include "songlistidx.h"
+#include "tmutil.h"
+
+#define SLIDX_FN          "songlistidx"
+#define SLIDX_VERSION     "# songlistidx 1"
+#define SLIDX_END         "end"
+#define SLIDX_TMP_EXT     ".tmp"
+
+typedef struct {
+  time_t    mtime;
+  int64_t   size;
+  slist_t   *uris;
+} slidxentry_t;
+
+typedef struct {
+  slist_t   *songlists;
+  time_t    mtime;
+  int64_t   size;
+} songlistidx_t;
+
+static songlistidx_t  *songlistidx = NULL;
+
+static void songlistidxLoad (void);
+static bool songlistidxValidate (void);
+static void songlistidxWrite (void);
+static slist_t *songlistidxScan (const char *name);
+static void songlistidxSet (const char *name, time_t mtime, int64_t size, slist_t *uris);
+static void songlistidxFreeEntry (void *data);
+static void songlistidxFilename (char *buff, size_t sz);
+static bool songlistidxSkip (const char *name);
+static slist_t *songlistidxFind (slist_t *urilist, const char *uri);
+static bool songlistidxHasAny (slist_t *uris, slist_t *urilist);
+
+/* returns the names of the song lists that contain the uri */
+BDJ_NODISCARD
+slist_t *
+songlistidxGetSonglists (const char *uri)
+{
+  return songlistidxFind (NULL, uri);
+}
+
+/* returns the names of the song lists that contain any of the uris */
+/* in the keys of urilist */
+BDJ_NODISCARD
+slist_t *
+songlistidxGetSonglistsByList (slist_t *urilist)
+{
+  return songlistidxFind (urilist, NULL);
+}
+
+/* called after a song list has been saved */
+void
+songlistidxUpdate (const char *name, songlist_t *sl)
+{
+  char          tfn [BDJ4_PATH_MAX];
+  slist_t       *uris;
+  ilistidx_t    iteridx;
+  ilistidx_t    key;
+  const char    *uri;
+
+  if (name == NULL || sl == NULL || songlistidxSkip (name)) {
+    return;
+  }
+
+  songlistidxLoad ();
+
+  uris = slistAlloc ("songlistidx-uris", LIST_ORDERED, NULL);
+  songlistStartIterator (sl, &iteridx);
+  while ((key = songlistIterate (sl, &iteridx)) >= 0) {
+    uri = songlistGetStr (sl, key, SONGLIST_URI);
+    if (uri != NULL) {
+      slistSetNum (uris, uri, 0);
+    }
+  }
+
+  pathbldMakePath (tfn, sizeof (tfn), name,
+      BDJ4_SONGLIST_EXT, PATHBLD_MP_DREL_DATA);
+  songlistidxSet (name, fileopModTime (tfn), fileopSize (tfn), uris);
+  songlistidxWrite ();
+}
+
+/* re-scans all of the song lists */
+void
+songlistidxRebuild (void)
+{
+  mstime_t    tm;
+
+  mstimestart (&tm);
+  songlistidxCleanup ();
+
+  songlistidx = mdmalloc (sizeof (songlistidx_t));
+  songlistidx->songlists = slistAlloc ("songlistidx", LIST_ORDERED,
+      songlistidxFreeEntry);
+  songlistidx->mtime = 0;
+  songlistidx->size = -1;
+
+  songlistidxValidate ();
+  songlistidxWrite ();
+  logMsg (LOG_DBG, LOG_IMPORTANT, "songlistidx: rebuild: %" PRId32 " song lists %" PRId64 " ms",
+      slistGetCount (songlistidx->songlists), (int64_t) mstimeend (&tm));
+}
+
+void
+songlistidxCleanup (void)
+{
+  if (songlistidx == NULL) {
+    return;
+  }
+
+  slistFree (songlistidx->songlists);
+  mdfree (songlistidx);
+  songlistidx = NULL;
+}
+
+/* internal routines */
+
+/* loads the index file if it has not been loaded, */
+/* or if it has been changed by another process */
+static void
+songlistidxLoad (void)
+{
+  FILE          *fh;
+  char          fn [BDJ4_PATH_MAX];
+  char          tbuff [BDJ4_PATH_MAX * 2];
+  char          name [BDJ4_PATH_MAX];
+  slist_t       *uris = NULL;
+  time_t        mtime = 0;
+  int64_t       size = 0;
+  fileopinfo_t  info;
+  char          *p;
+  char          *tokstr;
+  bool          valid = true;
+  bool          rc = false;
+
+  songlistidxFilename (fn, sizeof (fn));
+  if (! fileopGetInfo (fn, &info)) {
+    info.mtime = 0;
+    info.size = -1;
+  }
+
+  if (songlistidx != NULL) {
+    if (songlistidx->mtime == info.mtime && songlistidx->size == info.size) {
+      return;
+    }
+    songlistidxCleanup ();
+  }
+
+  songlistidx = mdmalloc (sizeof (songlistidx_t));
+  songlistidx->songlists = slistAlloc ("songlistidx", LIST_ORDERED,
+      songlistidxFreeEntry);
+  songlistidx->mtime = info.mtime;
+  songlistidx->size = info.size;
+
+  if (info.size < 0) {
+    return;
+  }
+  fh = fileopOpen (fn, "r");
+  if (fh == NULL) {
+    return;
+  }
+
+  *tbuff = '\0';
+  (void) ! fgets (tbuff, sizeof (tbuff), fh);
+  stringTrim (tbuff);
+  if (strcmp (tbuff, SLIDX_VERSION) != 0) {
+    valid = false;
+  }
+
+  *name = '\0';
+  while (valid && fgets (tbuff, sizeof (tbuff), fh) != NULL) {
+    stringTrim (tbuff);
+    if (strcmp (tbuff, SLIDX_END) == 0) {
+      /* a partially written file will not have the end marker */
+      rc = true;
+      break;
+    }
+
+    p = strchr (tbuff, '\t');
+    if (p == NULL) {
+      valid = false;
+      break;
+    }
+    *p++ = '\0';
+
+    if (strcmp (tbuff, "uri") == 0 && uris != NULL) {
+      slistSetNum (uris, p, 0);
+      continue;
+    }
+    if (strcmp (tbuff, "sl") == 0) {
+      /* sl <tab> name <tab> mtime <tab> size */
+      if (uris != NULL) {
+        songlistidxSet (name, mtime, size, uris);
+      }
+      uris = NULL;
+      p = strtok_r (p, "\t", &tokstr);
+      if (p == NULL) {
+        valid = false;
+        break;
+      }
+      stpecpy (name, name + sizeof (name), p);
+      p = strtok_r (NULL, "\t", &tokstr);
+      if (p == NULL) {
+        valid = false;
+        break;
+      }
+      mtime = strtoll (p, NULL, 10);
+      p = strtok_r (NULL, "\t", &tokstr);
+      if (p == NULL) {
+        valid = false;
+        break;
+      }
+      size = strtoll (p, NULL, 10);
+      uris = slistAlloc ("songlistidx-uris", LIST_ORDERED, NULL);
+      continue;
+    }
+
+    valid = false;
+  }
+  mdextfclose (fh);
+  fclose (fh);
+
+  if (rc && valid && uris != NULL) {
+    songlistidxSet (name, mtime, size, uris);
+    uris = NULL;
+  }
+  slistFree (uris);
+
+  if (! rc || ! valid) {
+    /* the validation will re-scan all of the song lists */
+    logMsg (LOG_DBG, LOG_IMPORTANT, "songlistidx: bad index file");
+    slistFree (songlistidx->songlists);
+    songlistidx->songlists = slistAlloc ("songlistidx", LIST_ORDERED,
+        songlistidxFreeEntry);
+  }
+}
+
+/* checks the song lists in the data directory against the index */
+/* returns true if the index was changed */
+static bool
+songlistidxValidate (void)
+{
+  char          tfn [BDJ4_PATH_MAX];
+  char          name [BDJ4_PATH_MAX];
+  slist_t       *filelist;
+  slist_t       *current;
+  slist_t       *removed;
+  slistidx_t    iteridx;
+  const char    *fn;
+  slidxentry_t  *entry;
+  fileopinfo_t  info;
+  pathinfo_t    *pi;
+  int           count = 0;
+
+  pathbldMakePath (tfn, sizeof (tfn), "", "", PATHBLD_MP_DREL_DATA);
+  filelist = dirlistBasicDirList (tfn, BDJ4_SONGLIST_EXT);
+  current = slistAlloc ("songlistidx-curr", LIST_ORDERED, NULL);
+
+  slistStartIterator (filelist, &iteridx);
+  while ((fn = slistIterateKey (filelist, &iteridx)) != NULL) {
+    pi = pathInfo (fn);
+    snprintf (name, sizeof (name), "%.*s", (int) pi->blen, pi->basename);
+    pathInfoFree (pi);
+
+    if (songlistidxSkip (name)) {
+      continue;
+    }
+    slistSetNum (current, name, 0);
+
+    pathbldMakePath (tfn, sizeof (tfn), name,
+        BDJ4_SONGLIST_EXT, PATHBLD_MP_DREL_DATA);
+    if (! fileopGetInfo (tfn, &info)) {
+      continue;
+    }
+    entry = slistGetData (songlistidx->songlists, name);
+    if (entry != NULL &&
+        entry->mtime == info.mtime &&
+        entry->size == info.size) {
+      continue;
+    }
+
+    songlistidxSet (name, info.mtime, info.size, songlistidxScan (name));
+    ++count;
+  }
+  slistFree (filelist);
+
+  removed = slistAlloc ("songlistidx-rm", LIST_UNORDERED, NULL);
+  slistStartIterator (songlistidx->songlists, &iteridx);
+  while ((fn = slistIterateKey (songlistidx->songlists, &iteridx)) != NULL) {
+    if (slistGetIdx (current, fn) < 0) {
+      slistSetNum (removed, fn, 0);
+    }
+  }
+  slistStartIterator (removed, &iteridx);
+  while ((fn = slistIterateKey (removed, &iteridx)) != NULL) {
+    slistDelete (songlistidx->songlists, fn);
+    ++count;
+  }
+  slistFree (removed);
+  slistFree (current);
+
+  if (count > 0) {
+    logMsg (LOG_DBG, LOG_BASIC, "songlistidx: %d song lists changed", count);
+  }
+  return count > 0;
+}
+
+/* the index is written to a temporary file and then renamed */
+static void
+songlistidxWrite (void)
+{
+  FILE          *fh;
+  char          fn [BDJ4_PATH_MAX];
+  char          tfn [BDJ4_PATH_MAX];
+  slistidx_t    iteridx;
+  slistidx_t    uiteridx;
+  const char    *name;
+  const char    *uri;
+  slidxentry_t  *entry;
+  fileopinfo_t  info;
+
+  songlistidxFilename (fn, sizeof (fn));
+  snprintf (tfn, sizeof (tfn), "%s%s", fn, SLIDX_TMP_EXT);
+  fh = fileopOpen (tfn, "w");
+  if (fh == NULL) {
+    return;
+  }
+
+  fprintf (fh, "%s\n", SLIDX_VERSION);
+  slistStartIterator (songlistidx->songlists, &iteridx);
+  while ((name = slistIterateKey (songlistidx->songlists, &iteridx)) != NULL) {
+    entry = slistGetData (songlistidx->songlists, name);
+    fprintf (fh, "sl\t%s\t%" PRId64 "\t%" PRId64 "\n",
+        name, (int64_t) entry->mtime, entry->size);
+    slistStartIterator (entry->uris, &uiteridx);
+    while ((uri = slistIterateKey (entry->uris, &uiteridx)) != NULL) {
+      fprintf (fh, "uri\t%s\n", uri);
+    }
+  }
+  fprintf (fh, "%s\n", SLIDX_END);
+  mdextfclose (fh);
+  fclose (fh);
+
+  filemanipMove (tfn, fn);
+
+  /* so that the file is not re-loaded by this process */
+  if (fileopGetInfo (fn, &info)) {
+    songlistidx->mtime = info.mtime;
+    songlistidx->size = info.size;
+  }
+}
+
+static slist_t *
+songlistidxScan (const char *name)
+{
+  songlist_t    *sl;
+  slist_t       *uris;
+  ilistidx_t    iteridx;
+  ilistidx_t    key;
+  const char    *uri;
+
+  uris = slistAlloc ("songlistidx-uris", LIST_ORDERED, NULL);
+  sl = songlistLoad (name);
+  if (sl == NULL) {
+    return uris;
+  }
+
+  songlistStartIterator (sl, &iteridx);
+  while ((key = songlistIterate (sl, &iteridx)) >= 0) {
+    uri = songlistGetStr (sl, key, SONGLIST_URI);
+    if (uri != NULL) {
+      slistSetNum (uris, uri, 0);
+    }
+  }
+  songlistFree (sl);
+
+  return uris;
+}
+
+/* takes ownership of the uris list */
+static void
+songlistidxSet (const char *name, time_t mtime, int64_t size, slist_t *uris)
+{
+  slidxentry_t  *entry;
+
+  entry = slistGetData (songlistidx->songlists, name);
+  if (entry == NULL) {
+    entry = mdmalloc (sizeof (slidxentry_t));
+    entry->uris = NULL;
+    slistSetData (songlistidx->songlists, name, entry);
+  }
+
+  slistFree (entry->uris);
+  entry->mtime = mtime;
+  entry->size = size;
+  entry->uris = uris;
+}
+
+static void
+songlistidxFreeEntry (void *data)
+{
+  slidxentry_t  *entry = data;
+
+  if (entry == NULL) {
+    return;
+  }
+
+  slistFree (entry->uris);
+  mdfree (entry);
+}
+
+static void
+songlistidxFilename (char *buff, size_t sz)
+{
+  pathbldMakePath (buff, sz, SLIDX_FN,
+      BDJ4_CONFIG_EXT, PATHBLD_MP_DREL_DATA);
+}
+
+/* the reload song lists are not indexed */
+static bool
+songlistidxSkip (const char *name)
+{
+  return strncmp (name, RELOAD_FN, strlen (RELOAD_FN)) == 0;
+}
+
+static slist_t *
+songlistidxFind (slist_t *urilist, const char *uri)
+{
+  slist_t       *names;
+  slistidx_t    iteridx;
+  const char    *name;
+  slidxentry_t  *entry;
+  bool          found;
+
+  songlistidxLoad ();
+  if (songlistidxValidate ()) {
+    songlistidxWrite ();
+  }
+
+  names = slistAlloc ("songlistidx-names", LIST_ORDERED, NULL);
+  if (uri == NULL && urilist == NULL) {
+    return names;
+  }
+
+  slistStartIterator (songlistidx->songlists, &iteridx);
+  while ((name = slistIterateKey (songlistidx->songlists, &iteridx)) != NULL) {
+    entry = slistGetData (songlistidx->songlists, name);
+    if (uri != NULL) {
+      found = slistGetIdx (entry->uris, uri) >= 0;
+    } else {
+      found = songlistidxHasAny (entry->uris, urilist);
+    }
+    if (found) {
+      slistSetNum (names, name, 0);
+    }
+  }
+
+  return names;
+}
+
+/* the smaller list is iterated, and the keys are looked up in the other */
+static bool
+songlistidxHasAny (slist_t *uris, slist_t *urilist)
+{
+  slist_t     *small;
+  slist_t     *large;
+  slistidx_t  iteridx;
+  const char  *uri;
+
+  small = uris;
+  large = urilist;
+  if (slistGetCount (urilist) < slistGetCount (uris)) {
+    small = urilist;
+    large = uris;
+  }
+
+  slistStartIterator (small, &iteridx);
+  while ((uri = slistIterateKey (small, &iteridx)) != NULL) {
+    if (slistGetIdx (large, uri) >= 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
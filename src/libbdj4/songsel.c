@@ -76,6 +76,8 @@ typedef struct songsel {
   sssongdata_t        *lastSelection;
   musicdb_t           *musicdb;
   slist_t             *tagList;
+  /* same-song mark -> the dances that have a song with the mark */
+  nlist_t             *ssDanceList;
   int                 tagWeight;
   bool                processed;
 } songsel_t;
@@ -133,6 +135,7 @@ songselAlloc (musicdb_t *musicdb, nlist_t *dancelist)
   logProcBegin ();
   songsel = mdmalloc (sizeof (songsel_t));
   songsel->tagList = NULL;
+  songsel->ssDanceList = nlistAlloc ("songsel-ss-dance", LIST_ORDERED, NULL);
   songsel->tagWeight = BDJ4_DFLT_TAG_WEIGHT;
   songsel->processed = false;
 
@@ -180,6 +183,7 @@ songselFree (songsel_t *songsel)
   }
 
   nlistFree (songsel->danceSelList);
+  nlistFree (songsel->ssDanceList);
   mdfree (songsel);
   logProcEnd ("");
   return;
@@ -384,6 +388,16 @@ songselAllocAddSong (songsel_t *songsel, dbidx_t dbidx, song_t *song)
   ss = songGetNum (song, TAG_SAMESONG);
 
   logMsg (LOG_DBG, LOG_SONGSEL, "add-song: dbidx:%" PRId32 " ss:%" PRId32, dbidx, ss);
+  if (ss > 0) {
+    nlist_t   *ssdances;
+
+    ssdances = nlistGetList (songsel->ssDanceList, ss);
+    if (ssdances == NULL) {
+      ssdances = nlistAlloc ("songsel-ss-dances", LIST_ORDERED, NULL);
+      nlistSetList (songsel->ssDanceList, ss, ssdances);
+    }
+    nlistSetNum (ssdances, danceIdx, 0);
+  }
 
   rating = songGetNum (song, TAG_DANCERATING);
   weight = ratingGetWeight (ratings, rating);
@@ -455,6 +469,8 @@ songselRemoveSong (songsel_t *songsel,
   qidx_t          qiteridx;
   nlistidx_t      diteridx;
   nlistidx_t      ssidx = -1;
+  nlistidx_t      ssdanceidx;
+  nlist_t         *ssdances = NULL;
   ssdance_t       *ss_songseldance;
 
   logProcBegin ();
@@ -506,12 +522,21 @@ songselRemoveSong (songsel_t *songsel,
   /* the same-song index must be processed for all dances! */
   /* if the same-song mark was set, remove _all_ songs with the */
   /* matching same-song mark. */
+  /* only the dances that have a song with the mark are checked */
 
-  nlistStartIterator (songsel->danceSelList, &diteridx);
-  while (ssidx > 0 && (ss_songseldance =
-      nlistIterateValueData (songsel->danceSelList, &diteridx)) != NULL) {
+  if (ssidx > 0) {
+    ssdances = nlistGetList (songsel->ssDanceList, ssidx);
+  }
+  nlistStartIterator (ssdances, &diteridx);
+  while (ssdances != NULL &&
+      (ssdanceidx = nlistIterateKey (ssdances, &diteridx)) >= 0) {
     qidx_t          origcount;
 
+    ss_songseldance = nlistGetData (songsel->danceSelList, ssdanceidx);
+    if (ss_songseldance == NULL) {
+      continue;
+    }
+
     origcount = queueGetCount (ss_songseldance->currentIndexes);
     queueStartIterator (ss_songseldance->currentIndexes, &qiteridx);
 
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+/*
+ * song data replies for the bdj4 server
+ *
+ * These are used by bdj4server, and by the tests, so that the
+ * bdj4 audio source can be tested against the same replies.
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "audiosrc.h"
+#include "bdj4.h"
+#include "bdjmsg.h"
+#include "bdjstring.h"
+#include "log.h"
+#include "mdebug.h"
+#include "musicdb.h"
+#include "slist.h"
+#include "song.h"
+#include "srvutil.h"
+#include "tagdef.h"
+#include "websrv.h"
+
+/* appends the tag/value pairs for the song to the buffer. */
+/* returns the end of the data, as with stpecpy() */
+char *
+srvutilSongTagData (song_t *song, char *rp, char *rend, int *count)
+{
+  slist_t     *songtags;
+  slistidx_t  iteridx;
+  const char  *tag;
+  char        tbuff [BDJ4_PATH_MAX];
+  int         tcount = 0;
+
+  songtags = songTagList (song);
+  slistStartIterator (songtags, &iteridx);
+  while ((tag = slistIterateKey (songtags, &iteridx)) != NULL) {
+    const char  *value;
+
+    if (strcmp (tag, tagdefs [TAG_URI].tag) == 0) {
+      /* this will be re-set by the caller */
+      continue;
+    }
+    if (strcmp (tag, tagdefs [TAG_PREFIX_LEN].tag) == 0) {
+      continue;
+    }
+    if (strcmp (tag, tagdefs [TAG_SAMESONG].tag) == 0) {
+      /* same-song is specific to the database, do not copy over */
+      continue;
+    }
+
+    value = slistGetStr (songtags, tag);
+    if (value != NULL && *value) {
+      snprintf (tbuff, sizeof (tbuff), "%s%c%s%c",
+          tag, MSG_ARGS_RS, value, MSG_ARGS_RS);
+      rp = stpecpy (rp, rend, tbuff);
+      ++tcount;
+    }
+  }
+  slistFree (songtags);
+
+  if (count != NULL) {
+    *count = tcount;
+  }
+  return rp;
+}
+
+/* the song list has song uris separated by MSG_ARGS_RS, and is modified. */
+/* the response is sent one song at a time, so that its size is */
+/* not limited. */
+/*   uri RS count RS count * (tag RS value RS) */
+/*   a count of -1 indicates the song was not found */
+void
+srvutilSongTagsBatch (websrv_t *websrv, musicdb_t *musicdb, char *songlist)
+{
+  char        *tagdata;
+  char        *p;
+  char        *tokstr;
+  char        tbuff [BDJ4_PATH_MAX];
+  int         count = 0;
+
+  tagdata = mdmalloc (BDJMSG_MAX);
+
+  websrvChunkStart (websrv,
+      "Content-type: text/plain; charset=utf-8\r\n"
+      "Cache-Control: max-age=0\r\n");
+
+  p = strtok_r (songlist, MSG_ARGS_RS_STR, &tokstr);
+  while (p != NULL) {
+    song_t    *song = NULL;
+    int       tcount = -1;
+
+    *tagdata = '\0';
+    if (audiosrcExists (p)) {
+      song = dbGetByName (musicdb, p);
+    }
+    if (song != NULL) {
+      srvutilSongTagData (song, tagdata, tagdata + BDJMSG_MAX, &tcount);
+    }
+
+    snprintf (tbuff, sizeof (tbuff), "%s%c%d%c",
+        p, MSG_ARGS_RS, tcount, MSG_ARGS_RS);
+    websrvChunkSend (websrv, tbuff, strlen (tbuff));
+    websrvChunkSend (websrv, tagdata, strlen (tagdata));
+
+    ++count;
+    p = strtok_r (NULL, MSG_ARGS_RS_STR, &tokstr);
+  }
+
+  websrvChunkEnd (websrv);
+  logMsg (LOG_DBG, LOG_INFO, "srv: song-tags-batch: count: %d", count);
+
+  mdfree (tagdata);
+}
@@ -4,6 +4,7 @@
 #include "config.h"
 
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <errno.h>
@@ -80,6 +81,31 @@ stringTrimChar (char *s, unsigned char c)
   return;
 }
 
+uint64_t
+stringHash64 (const char *str)
+{
+  if (str == NULL) {
+    return STRING_HASH64_INIT;
+  }
+
+  return stringHash64Data (STRING_HASH64_INIT, str, strlen (str));
+}
+
+/* the hash may be built up over several calls, */
+/* starting with STRING_HASH64_INIT */
+uint64_t
+stringHash64Data (uint64_t hash, const void *data, size_t len)
+{
+  const unsigned char *p = data;
+
+  for (size_t i = 0; i < len; ++i) {
+    hash ^= p [i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
 #if 0
 int
 versionCompare (const char *v1, const char *v2) /* UNUSED */
@@ -131,6 +131,46 @@ fileopModTime (const char *fname)
   return mtime;
 }
 
+/* the size, modification time and inode in a single stat */
+/* returns false if the file does not exist */
+bool
+fileopGetInfo (const char *fname, fileopinfo_t *info)
+{
+  int     rc;
+
+  info->size = -1;
+  info->mtime = 0;
+  info->inode = 0;
+
+#if _lib__wstat64
+  {
+    struct __stat64  statbuf;
+    wchar_t       *tfname = NULL;
+
+    tfname = osToWideChar (fname);
+    rc = _wstat64 (tfname, &statbuf);
+    if (rc == 0) {
+      info->size = statbuf.st_size;
+      info->mtime = statbuf.st_mtime;
+      /* windows does not have inode numbers */
+    }
+    mdfree (tfname);
+  }
+#else
+  {
+    struct stat statbuf;
+
+    rc = stat (fname, &statbuf);
+    if (rc == 0) {
+      info->size = statbuf.st_size;
+      info->mtime = statbuf.st_mtime;
+      info->inode = statbuf.st_ino;
+    }
+  }
+#endif
+  return rc == 0;
+}
+
 void
 fileopSetModTime (const char *fname, time_t mtime)
 {
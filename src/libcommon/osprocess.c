@@ -20,6 +20,9 @@
 #if __has_include (<sys/wait.h>)
 # include <sys/wait.h>
 #endif
+#if __has_include (<spawn.h>)
+# include <spawn.h>
+#endif
 
 #include "bdj4.h"
 #include "bdjstring.h"
@@ -40,6 +43,14 @@ static int osProcessWaitStatus (int wstatus);
 
 #endif
 
+#if _lib_posix_spawn && defined (POSIX_SPAWN_SETSID)
+
+extern char **environ;
+
+static pid_t osProcessSpawn (const char *targv[], int flags);
+
+#endif
+
 /* identical on linux and mac os */
 #if _lib_fork
 
@@ -63,8 +74,19 @@ osProcessStart (const char *targv[], int flags, void **handle, char *outfname)
     }
 #endif
 
-  /* this may be slower, but it works; speed is not a major issue */
-  tpid = fork ();
+  tpid = -1;
+#if _lib_posix_spawn && defined (POSIX_SPAWN_SETSID)
+  /* fork() shares the pages copy-on-write, but must still copy the */
+  /* page tables of the ui processes' large address space. */
+  /* posix_spawn() uses a vfork-style start and copies nothing */
+  if (outfname == NULL) {
+    tpid = osProcessSpawn (targv, flags);
+  }
+#endif
+
+  if (tpid < 0) {
+    tpid = fork ();
+  }
   if (tpid < 0) {
     fprintf (stderr, "ERR: fork: %d %s\n", errno, strerror (errno));
     return tpid;
@@ -287,3 +309,33 @@ osProcessWaitStatus (int wstatus)
 }
 
 #endif
+
+#if _lib_posix_spawn && defined (POSIX_SPAWN_SETSID)
+
+/* returns -1 on failure */
+static pid_t
+osProcessSpawn (const char *targv[], int flags)
+{
+  pid_t             pid;
+  posix_spawnattr_t attr;
+  int               rc;
+
+  if (posix_spawnattr_init (&attr) != 0) {
+    return -1;
+  }
+  if ((flags & OS_PROC_DETACH) == OS_PROC_DETACH) {
+    posix_spawnattr_setflags (&attr, POSIX_SPAWN_SETSID);
+  }
+
+  rc = posix_spawn (&pid, targv [0], NULL, &attr,
+      (char * const *) targv, environ);
+  posix_spawnattr_destroy (&attr);
+  if (rc != 0) {
+    /* the caller will fall back to fork, which reports any error */
+    return -1;
+  }
+
+  return pid;
+}
+
+#endif
@@ -148,6 +148,41 @@ enum {
   SV_MAX_SZ = 1024,
 };
 
+/* the values determined by searching the path and running external */
+/* programs.  these are saved in the probe cache by the starter, */
+/* and re-used by the other processes. */
+static const int sysvarsprobe [] = {
+  SV_FONT_DEFAULT,
+  SV_OS_BUILD,
+  SV_OS_DISP,
+  SV_OS_VERS,
+  SV_PATH_ACRCLOUD,
+  SV_PATH_CRONTAB,
+  SV_PATH_FFMPEG,
+  SV_PATH_FPCALC,
+  SV_PATH_GSETTINGS,
+  SV_PATH_ICONDIR,
+  SV_PATH_URI_OPEN,
+  SV_PATH_VLC,
+  SV_PATH_VLC_LIB,
+  SV_PATH_XDGUSERDIR,
+  SV_TEMP_A,
+  SV_THEME_DEFAULT,
+};
+enum {
+  SV_PROBE_COUNT = (sizeof (sysvarsprobe) / sizeof (int)),
+};
+
+static const int sysvarslprobe [] = {
+  SVL_VLC_VERSION,
+};
+enum {
+  SVL_PROBE_COUNT = (sizeof (sysvarslprobe) / sizeof (int)),
+};
+
+#define SV_PROBE_VERSION  "# sysvars-probe 1"
+#define SV_PROBE_END      "end"
+
 static char       sysvars [SV_MAX][SV_MAX_SZ];
 static int64_t    lsysvars [SVL_MAX];
 
@@ -175,6 +210,10 @@ static void svGetSystemFont (void);
 static sysdistinfo_t *sysvarsParseDistFile (const char *path);
 static void sysvarsParseDistFileFree (sysdistinfo_t *distinfo);
 static void sysvarsBuildVLCLibPath (char *tbuff, char *lbuff, size_t sz, const char *libnm);
+static void sysvarsProbeFilename (char *buff, size_t sz);
+static bool sysvarsProbeLoad (void);
+static void sysvarsProbeSave (void);
+static uint64_t sysvarsProbePathHash (void);
 
 void
 sysvarsInit (const char *argv0, int flags)
@@ -187,6 +226,7 @@ sysvarsInit (const char *argv0, int flags)
   char          *end;
   size_t        dlen;
   bool          alternatepath = false;
+  bool          probecached = false;
   sysversinfo_t *versinfo;
   sysdistinfo_t *distinfo;
 #if _lib_uname
@@ -705,9 +745,16 @@ sysvarsInit (const char *argv0, int flags)
       sysvars [SV_BDJ4_DREL_DATA], LOCALE_FN, BDJ4_CONFIG_EXT);
   sysvarsLoadLocale (buff);
 
-  sysvarsCheckPaths (NULL);
+  /* searching the path and running the external programs is slow, */
+  /* use the probe cache if it is valid */
+  if (flags == SYSVARS_FLAG_ALL) {
+    probecached = sysvarsProbeLoad ();
+  }
+  if (! probecached) {
+    sysvarsCheckPaths (NULL);
+  }
 
-  if (flags == SYSVARS_FLAG_ALL &&
+  if (! probecached && flags != SYSVARS_FLAG_BASIC &&
       strcmp (sysvars [SV_OS_NAME], "darwin") == 0) {
     char  *data;
     char  *tdata;
@@ -748,7 +795,9 @@ sysvarsInit (const char *argv0, int flags)
   }
 
   /* set the default theme */
-  sysvarsSetStr (SV_THEME_DEFAULT, "Adwaita:dark");
+  if (! probecached) {
+    sysvarsSetStr (SV_THEME_DEFAULT, "Adwaita:dark");
+  }
 
   if (strcmp (sysvars [SV_OS_NAME], "linux") == 0) {
     static char *fna = "/etc/lsb-release";
@@ -758,7 +807,8 @@ sysvarsInit (const char *argv0, int flags)
       svGetLinuxOSInfo (fnb);
     }
 
-    if (flags == SYSVARS_FLAG_ALL && *sysvars [SV_PATH_GSETTINGS]) {
+    if (! probecached && flags != SYSVARS_FLAG_BASIC &&
+        *sysvars [SV_PATH_GSETTINGS]) {
       /* override the default theme with what the user has set */
       svGetLinuxDefaultTheme ();
     }
@@ -797,9 +847,12 @@ sysvarsInit (const char *argv0, int flags)
 #endif
   }
 
-  if (flags == SYSVARS_FLAG_ALL) {
+  if (! probecached && flags != SYSVARS_FLAG_BASIC) {
     svGetSystemFont ();
   }
+  if (flags == SYSVARS_FLAG_PROBE) {
+    sysvarsProbeSave ();
+  }
 
   lsysvars [SVL_ALTIDX] = 0;
   lsysvars [SVL_PROFILE_IDX] = 0;
@@ -1372,3 +1425,192 @@ sysvarsBuildVLCLibPath (char *tbuff, char *lbuff, size_t sz, const char *libnm)
   p = stpecpy (p, lbuff + sz, libnm);
 }
 
+
+static void
+sysvarsProbeFilename (char *buff, size_t sz)
+{
+  snprintf (buff, sz, "%s/%s/%s%s", sysvars [SV_BDJ4_DIR_DATATOP],
+      sysvars [SV_BDJ4_DREL_TMP], SYSVARS_PROBE_FN, BDJ4_CONFIG_EXT);
+}
+
+/* the probe cache is only valid if the path has not changed, and the */
+/* directories in the path and the programs that were found have */
+/* not been modified. */
+static bool
+sysvarsProbeLoad (void)
+{
+  FILE      *fh;
+  char      fn [BDJ4_PATH_MAX];
+  char      tbuff [SV_MAX_SZ * 2];
+  char      saved [SV_PROBE_COUNT][SV_MAX_SZ];
+  int64_t   lsaved [SVL_PROBE_COUNT];
+  char      *key;
+  char      *val;
+  bool      rc = false;
+  bool      valid = true;
+
+  sysvarsProbeFilename (fn, sizeof (fn));
+  if (! fileopFileExists (fn)) {
+    return false;
+  }
+  fh = fileopOpen (fn, "r");
+  if (fh == NULL) {
+    return false;
+  }
+
+  for (size_t i = 0; i < SV_PROBE_COUNT; ++i) {
+    stpecpy (saved [i], saved [i] + SV_MAX_SZ, sysvars [sysvarsprobe [i]]);
+  }
+  for (size_t i = 0; i < SVL_PROBE_COUNT; ++i) {
+    lsaved [i] = lsysvars [sysvarslprobe [i]];
+  }
+
+  *tbuff = '\0';
+  (void) ! fgets (tbuff, sizeof (tbuff), fh);
+  stringTrim (tbuff);
+  if (strcmp (tbuff, SV_PROBE_VERSION) != 0) {
+    valid = false;
+  }
+
+  while (valid && fgets (tbuff, sizeof (tbuff), fh) != NULL) {
+    stringTrim (tbuff);
+    if (strcmp (tbuff, SV_PROBE_END) == 0) {
+      /* a partially written file will not have the end marker */
+      rc = true;
+      break;
+    }
+
+    /* type <tab> key <tab> value, the value may be empty */
+    key = strchr (tbuff, '\t');
+    if (key == NULL) {
+      valid = false;
+      break;
+    }
+    *key++ = '\0';
+    val = strchr (key, '\t');
+    if (val == NULL) {
+      valid = false;
+      break;
+    }
+    *val++ = '\0';
+
+    if (strcmp (tbuff, "path") == 0) {
+      if (strtoull (val, NULL, 16) != sysvarsProbePathHash ()) {
+        valid = false;
+      }
+    } else if (strcmp (tbuff, "mtime") == 0) {
+      if ((int64_t) fileopModTime (key) != strtoll (val, NULL, 10)) {
+        valid = false;
+      }
+    } else if (strcmp (tbuff, "sv") == 0) {
+      for (size_t i = 0; i < SV_PROBE_COUNT; ++i) {
+        if (strcmp (key, sysvarsdesc [sysvarsprobe [i]]) == 0) {
+          sysvarsSetStr (sysvarsprobe [i], val);
+          break;
+        }
+      }
+    } else if (strcmp (tbuff, "svl") == 0) {
+      for (size_t i = 0; i < SVL_PROBE_COUNT; ++i) {
+        if (strcmp (key, sysvarsldesc [sysvarslprobe [i]]) == 0) {
+          lsysvars [sysvarslprobe [i]] = strtoll (val, NULL, 10);
+          break;
+        }
+      }
+    }
+  }
+  mdextfclose (fh);
+  fclose (fh);
+
+  if (! valid) {
+    rc = false;
+  }
+
+  if (! rc) {
+    /* restore any values that were loaded from a bad file */
+    for (size_t i = 0; i < SV_PROBE_COUNT; ++i) {
+      sysvarsSetStr (sysvarsprobe [i], saved [i]);
+    }
+    for (size_t i = 0; i < SVL_PROBE_COUNT; ++i) {
+      lsysvars [sysvarslprobe [i]] = lsaved [i];
+    }
+    return rc;
+  }
+
+  if (*sysvars [SV_PATH_VLC] == '\0') {
+    /* vlc may have been installed since the probe was done */
+    sysvarsCheckVLCPath ();
+  }
+
+  return rc;
+}
+
+static void
+sysvarsProbeSave (void)
+{
+  FILE        *fh;
+  char        fn [BDJ4_PATH_MAX];
+  char        tbuff [BDJ4_PATH_MAX];
+  char        tpath [16384];
+  char        *p;
+  char        *tsep;
+  char        *tokstr;
+
+  sysvarsProbeFilename (fn, sizeof (fn));
+  fh = fileopOpen (fn, "w");
+  if (fh == NULL) {
+    return;
+  }
+
+  fprintf (fh, "%s\n", SV_PROBE_VERSION);
+  fprintf (fh, "path\t\t%016" PRIx64 "\n", sysvarsProbePathHash ());
+
+  tsep = ":";
+  if (isWindows ()) {
+    tsep = ";";
+  }
+  osGetEnv ("PATH", tpath, sizeof (tpath));
+  p = strtok_r (tpath, tsep, &tokstr);
+  while (p != NULL) {
+    stpecpy (tbuff, tbuff + sizeof (tbuff), p);
+    pathNormalizePath (tbuff, sizeof (tbuff));
+    stringTrimChar (tbuff, '/');
+    if (*tbuff) {
+      fprintf (fh, "mtime\t%s\t%" PRId64 "\n",
+          tbuff, (int64_t) fileopModTime (tbuff));
+    }
+    p = strtok_r (NULL, tsep, &tokstr);
+  }
+
+  for (size_t i = 0; i < SV_PROBE_COUNT; ++i) {
+    int     idx = sysvarsprobe [i];
+
+    if (strncmp (sysvarsdesc [idx], "PATH_", 5) == 0 &&
+        idx != SV_PATH_ICONDIR &&
+        *sysvars [idx]) {
+      fprintf (fh, "mtime\t%s\t%" PRId64 "\n",
+          sysvars [idx], (int64_t) fileopModTime (sysvars [idx]));
+    }
+  }
+
+  for (size_t i = 0; i < SV_PROBE_COUNT; ++i) {
+    fprintf (fh, "sv\t%s\t%s\n",
+        sysvarsdesc [sysvarsprobe [i]], sysvars [sysvarsprobe [i]]);
+  }
+  for (size_t i = 0; i < SVL_PROBE_COUNT; ++i) {
+    fprintf (fh, "svl\t%s\t%" PRId64 "\n",
+        sysvarsldesc [sysvarslprobe [i]], lsysvars [sysvarslprobe [i]]);
+  }
+  fprintf (fh, "%s\n", SV_PROBE_END);
+
+  mdextfclose (fh);
+  fclose (fh);
+}
+
+static uint64_t
+sysvarsProbePathHash (void)
+{
+  char        tpath [16384];
+
+  osGetEnv ("PATH", tpath, sizeof (tpath));
+  return stringHash64 (tpath);
+}
@@ -78,6 +78,7 @@
 #include "log.h"
 #include "mdebug.h"
 #include "gsti.h"
+#include "osenv.h"
 #include "pli.h"
 #include "tmutil.h"
 
@@ -134,6 +135,12 @@ typedef struct gstiidx {
   int           idx;
 } gstiidx_t;
 
+/* gapless playback: */
+/* the next song is pre-rolled (paused) in the spare pipeline. */
+/* when the current pipeline reaches end-of-stream, the bus sync-handler */
+/* (running in the streaming thread) starts the spare pipeline playing. */
+/* the main thread then finishes the switch-over. */
+/* the preroll fields are protected by the preroll lock. */
 typedef struct gsti {
   uint64_t          ident;
   GMainContext      *mainctx;
@@ -142,12 +149,26 @@ typedef struct gsti {
   int               curr;
   GstState          gststate;
   plistate_t        state;
+  GRecMutex         prerolllock;
+  char              *prerolluri;
+  int               prerollidx;
+  gint64            eostime;
+  gint64            switchtime;
   bool              isstopping;
   bool              inCrossFade;
+  bool              prerollready;
+  bool              prerollhold;
+  bool              gaplessswitch;
+  bool              gaplessswitched;
+  bool              gaplessstart;
 } gsti_t;
 
 static void gstiRunOnce (gsti_t *gsti);
 static gboolean gstiBusCallback (GstBus * bus, GstMessage * message, void *udata);
+static GstBusSyncReply gstiBusSyncHandler (GstBus *bus, GstMessage *message, void *udata);
+static void gstiMakeURI (char *tbuff, size_t sz, const char *fulluri, int sourceType);
+static void gstiGaplessSwitch (gsti_t *gsti);
+static void gstiPrerollCancel (gsti_t *gsti);
 static void gstiProcessState (gsti_t *gsti, GstState state);
 static void gstiWaitState (gsti_t *gsti, GstState want);
 #if GSTI_DEBUG_DOT
@@ -160,11 +181,18 @@ gstiInit (const char *plinm)
   gsti_t            *gsti;
   GstBus            *bus = NULL;
   GstPlayFlags      flags;
+  char              sinknm [80];
 
 #if GSTI_DEBUG_DOT
   diropMakeDir ("tmp/gst");
 #endif
 
+  /* the audio sink may be replaced (e.g. fakesink) for testing */
+  osGetEnv ("BDJ4_GST_SINK", sinknm, sizeof (sinknm));
+  if (! *sinknm) {
+    stpecpy (sinknm, sinknm + sizeof (sinknm), "autoaudiosink");
+  }
+
   gst_init (NULL, 0);
 
   gsti = mdmalloc (sizeof (gsti_t));
@@ -183,6 +211,16 @@ gstiInit (const char *plinm)
   gsti->curr = 0;
   gsti->isstopping = false;
   gsti->inCrossFade = false;
+  g_rec_mutex_init (&gsti->prerolllock);
+  gsti->prerolluri = NULL;
+  gsti->prerollidx = -1;
+  gsti->eostime = 0;
+  gsti->switchtime = 0;
+  gsti->prerollready = false;
+  gsti->prerollhold = false;
+  gsti->gaplessswitch = false;
+  gsti->gaplessswitched = false;
+  gsti->gaplessstart = false;
 
   gsti->mainctx = g_main_context_default ();
   gstiRunOnce (gsti);
@@ -207,6 +245,7 @@ gstiInit (const char *plinm)
 
     bus = gst_pipeline_get_bus (GST_PIPELINE (gsti->pipeline [i]));
     gsti->gstiidx [i].busId = gst_bus_add_watch (bus, gstiBusCallback, &gsti->gstiidx [i]);
+    gst_bus_set_sync_handler (bus, gstiBusSyncHandler, &gsti->gstiidx [i], NULL);
     g_object_unref (bus);
     gstiRunOnce (gsti);
 
@@ -230,10 +269,14 @@ gstiInit (const char *plinm)
     g_object_set (G_OBJECT (resample), "quality", 8, NULL);
 
     snprintf (tmp, sizeof (tmp), "audiosink_%d", i);
-    audiosink = gst_element_factory_make ("autoaudiosink", tmp);
+    audiosink = gst_element_factory_make (sinknm, tmp);
     if (audiosink == NULL) {
       fprintf (stderr, "ERR: unable to instantiate audiosink\n");
     }
+    if (strcmp (sinknm, "fakesink") == 0) {
+      /* play in real-time */
+      g_object_set (G_OBJECT (audiosink), "sync", TRUE, NULL);
+    }
 
     snprintf (tmp, sizeof (tmp), "sinkbin_%d", i);
     sinkbin = gst_bin_new (tmp);
@@ -306,6 +349,7 @@ gstiFree (gsti_t *gsti)
   }
 
   gsti->isstopping = true;
+  gstiPrerollCancel (gsti);
   gstiRunOnce (gsti);
 
   for (int i = 0; i < PLI_MAX_SOURCE; ++i) {
@@ -327,11 +371,17 @@ gstiFree (gsti_t *gsti)
   }
 
   for (int i = 0; i < PLI_MAX_SOURCE; ++i) {
+    GstBus    *bus;
+
+    bus = gst_pipeline_get_bus (GST_PIPELINE (gsti->pipeline [i]));
+    gst_bus_set_sync_handler (bus, NULL, NULL, NULL);
+    g_object_unref (bus);
     mdextfree (gsti->pipeline [i]);
     gst_object_unref (gsti->pipeline [i]);
   }
 
   gstiRunOnce (gsti);
+  g_rec_mutex_clear (&gsti->prerolllock);
 
   gsti->ident = BDJ4_IDENT_FREE;
   mdfree (gsti);
@@ -354,11 +404,41 @@ gstiMedia (gsti_t *gsti, const char *fulluri, int sourceType)
 
   gstiRunOnce (gsti);
 
-  if (sourceType == AUDIOSRC_TYPE_FILE) {
-    snprintf (tbuff, sizeof (tbuff), "%s%s", AS_FILE_PFX, fulluri);
-  } else {
-    stpecpy (tbuff, tbuff + sizeof (tbuff), fulluri);
+  gstiMakeURI (tbuff, sizeof (tbuff), fulluri, sourceType);
+
+  gsti->gaplessstart = false;
+  g_rec_mutex_lock (&gsti->prerolllock);
+  if (gsti->prerolluri != NULL && strcmp (tbuff, gsti->prerolluri) == 0) {
+    if (gsti->gaplessswitched) {
+      /* the song is already playing */
+      if (gsti->switchtime > 0) {
+        logMsg (LOG_DBG, LOG_BASIC, "gapless: gap: %" PRId64 " usec",
+            (int64_t) (gsti->switchtime - gsti->eostime));
+      }
+      gsti->gaplessswitched = false;
+      gsti->gaplessstart = true;
+    } else if (gsti->prerollready) {
+      /* the current song was stopped before the end-of-stream, */
+      /* start from the pre-rolled pipeline */
+      logMsg (LOG_DBG, LOG_BASIC, "gapless: use pre-roll");
+      gsti->curr = gsti->prerollidx;
+      gsti->state = PLI_STATE_OPENING;
+      gsti->gaplessstart = true;
+    }
+    if (gsti->gaplessstart) {
+      dataFree (gsti->prerolluri);
+      gsti->prerolluri = NULL;
+      gsti->prerollidx = -1;
+      gsti->prerollready = false;
+      g_rec_mutex_unlock (&gsti->prerolllock);
+      gstiRunOnce (gsti);
+      return;
+    }
   }
+  g_rec_mutex_unlock (&gsti->prerolllock);
+
+  /* not the pre-rolled song */
+  gstiPrerollCancel (gsti);
 
   gsti->gstiidx [gsti->curr].rate = 1.0;
   g_object_set (G_OBJECT (gsti->pipeline [gsti->curr]), "uri", tbuff, NULL);
@@ -377,6 +457,63 @@ gstiMedia (gsti_t *gsti, const char *fulluri, int sourceType)
   return;
 }
 
+/* sets up the next song in the spare pipeline and pre-rolls it, */
+/* a null uri cancels any pre-roll */
+void
+gstiPreroll (gsti_t *gsti, const char *fulluri, int sourceType)
+{
+  char    tbuff [BDJ4_PATH_MAX];
+  int     idx;
+
+  if (gsti == NULL || gsti->ident != GSTI_IDENT || gsti->mainctx == NULL) {
+    return;
+  }
+
+  gstiRunOnce (gsti);
+  gstiPrerollCancel (gsti);
+
+  if (fulluri == NULL || gsti->inCrossFade) {
+    return;
+  }
+
+  gstiMakeURI (tbuff, sizeof (tbuff), fulluri, sourceType);
+  idx = (PLI_MAX_SOURCE - 1) - gsti->curr;
+
+  g_rec_mutex_lock (&gsti->prerolllock);
+  gsti->prerolluri = mdstrdup (tbuff);
+  gsti->prerollidx = idx;
+  gsti->prerollready = false;
+  gsti->gstiidx [idx].rate = 1.0;
+  g_rec_mutex_unlock (&gsti->prerolllock);
+
+  g_object_set (G_OBJECT (gsti->pipeline [idx]), "volume", 1.0, NULL);
+  g_object_set (G_OBJECT (gsti->pipeline [idx]), "uri", tbuff, NULL);
+  if (! gst_element_set_state (GST_ELEMENT (gsti->pipeline [idx]), GST_STATE_PAUSED)) {
+    fprintf (stderr, "ERR: unable to set state (preroll) %d\n", idx);
+  }
+  logMsg (LOG_DBG, LOG_BASIC, "gapless: pre-roll %d %s", idx, tbuff);
+  gstiRunOnce (gsti);
+}
+
+/* the time from the end-of-stream to the pre-rolled pipeline */
+/* playing for the last gapless switch, in microseconds, or -1 */
+int64_t
+gstiGetGap (gsti_t *gsti)
+{
+  int64_t     gap = -1;
+
+  if (gsti == NULL || gsti->ident != GSTI_IDENT) {
+    return gap;
+  }
+
+  g_rec_mutex_lock (&gsti->prerolllock);
+  if (gsti->eostime > 0 && gsti->switchtime > 0) {
+    gap = (int64_t) (gsti->switchtime - gsti->eostime);
+  }
+  g_rec_mutex_unlock (&gsti->prerolllock);
+  return gap;
+}
+
 int64_t
 gstiGetDuration (gsti_t *gsti)
 {
@@ -428,6 +565,12 @@ gstiState (gsti_t *gsti)
   gst_element_get_state (GST_ELEMENT (gsti->pipeline [gsti->curr]), &state, &pending, 1);
   gstiProcessState (gsti, state);
 
+  /* the prior song has finished, the player must see the stop */
+  /* before the next song is started */
+  if (gsti->gaplessswitched) {
+    gsti->state = PLI_STATE_STOPPED;
+  }
+
 #if GSTI_DEBUG_DOT
   if (gsti->state != dbgstate) {
     char    tmp [40];
@@ -488,6 +631,19 @@ gstiStop (gsti_t *gsti)
   }
 
   gsti->isstopping = true;
+
+  /* the pre-roll must not be started by the end-of-stream */
+  /* from the stop, but it is retained for use by gstiMedia() */
+  g_rec_mutex_lock (&gsti->prerolllock);
+  gsti->prerollhold = true;
+  g_rec_mutex_unlock (&gsti->prerolllock);
+  gstiRunOnce (gsti);
+
+  /* a stop after the gapless switch stops the next song also */
+  if (gsti->gaplessswitched) {
+    gstiPrerollCancel (gsti);
+  }
+
   g_object_set (G_OBJECT (gsti->pipeline [gsti->curr]), "volume", 0.0, NULL);
   gstiRunOnce (gsti);
 
@@ -500,6 +656,10 @@ gstiStop (gsti_t *gsti)
   g_object_set (G_OBJECT (gsti->pipeline [gsti->curr]), "volume", 1.0, NULL);
   gstiRunOnce (gsti);
 
+  g_rec_mutex_lock (&gsti->prerolllock);
+  gsti->prerollhold = false;
+  g_rec_mutex_unlock (&gsti->prerolllock);
+
 #if GSTI_DEBUG_DOT
   gstiDebugDot (gsti, NULL, "stop");
 #endif
@@ -519,6 +679,15 @@ gstiSetPosition (gsti_t *gsti, int64_t pos)
     return false;
   }
 
+  /* the gapless song is already playing from the beginning */
+  if (gsti->gaplessstart) {
+    gsti->gaplessstart = false;
+    if (pos == 0) {
+      gstiRunOnce (gsti);
+      return true;
+    }
+  }
+
   if (gsti->state == PLI_STATE_PAUSED ||
       gsti->state == PLI_STATE_PLAYING) {
     gpos = pos;
@@ -550,6 +719,12 @@ gstiSetRate (gsti_t *gsti, double rate)
     return false;
   }
 
+  /* a seek would interrupt the gapless transition */
+  if (gsti->gaplessstart && rate == gsti->gstiidx [gsti->curr].rate) {
+    gstiRunOnce (gsti);
+    return true;
+  }
+
   if (gsti->state == PLI_STATE_PAUSED ||
       gsti->state == PLI_STATE_PLAYING) {
     gint64    pos;
@@ -590,6 +765,7 @@ gstiCrossFade (gsti_t *gsti, const char *fn, int sourceType)
     return 1;
   }
 
+  gstiPrerollCancel (gsti);
   gsti->curr = (PLI_MAX_SOURCE - 1) - gsti->curr;
   gsti->inCrossFade = true;
   gstiMedia (gsti, fn, sourceType);
@@ -642,6 +818,7 @@ gstiRunOnce (gsti_t *gsti)
   while (g_main_context_iteration (gsti->mainctx, FALSE)) {
     ;
   }
+  gstiGaplessSwitch (gsti);
 }
 
 static gboolean
@@ -652,6 +829,31 @@ gstiBusCallback (GstBus * bus, GstMessage * message, void *udata)
 
   // fprintf (stderr, "message %s\n", GST_MESSAGE_TYPE_NAME (message));
 
+  if (gstiidx->idx != gsti->curr && ! gsti->inCrossFade) {
+    /* the pre-rolled or the finished pipeline */
+    if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_STATE_CHANGED &&
+        GST_MESSAGE_SRC (message) == GST_OBJECT (gsti->pipeline [gstiidx->idx])) {
+      GstState old_state, new_state, pending_state;
+
+      gst_message_parse_state_changed (message, &old_state, &new_state, &pending_state);
+      g_rec_mutex_lock (&gsti->prerolllock);
+      if (gsti->prerollidx == gstiidx->idx &&
+          new_state == GST_STATE_PAUSED) {
+        gsti->prerollready = true;
+#if GSTI_DEBUG
+        fprintf (stderr, "preroll-ready: %d\n", gstiidx->idx);
+#endif
+      }
+      g_rec_mutex_unlock (&gsti->prerolllock);
+    }
+    if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_STATE_CHANGED ||
+        GST_MESSAGE_TYPE (message) == GST_MESSAGE_BUFFERING ||
+        GST_MESSAGE_TYPE (message) == GST_MESSAGE_DURATION_CHANGED ||
+        GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS) {
+      return G_SOURCE_CONTINUE;
+    }
+  }
+
   switch (GST_MESSAGE_TYPE (message)) {
     case GST_MESSAGE_INFO:
     case GST_MESSAGE_ERROR:
@@ -708,6 +910,125 @@ gstiBusCallback (GstBus * bus, GstMessage * message, void *udata)
   return G_SOURCE_CONTINUE;
 }
 
+/* runs in the streaming thread, the main context must not be used. */
+/* the pre-rolled pipeline is started at the exact end-of-stream */
+/* of the current pipeline */
+static GstBusSyncReply
+gstiBusSyncHandler (GstBus *bus, GstMessage *message, void *udata)
+{
+  gstiidx_t   *gstiidx = udata;
+  gsti_t      *gsti = gstiidx->gsti;
+
+  if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_EOS &&
+      GST_MESSAGE_TYPE (message) != GST_MESSAGE_STATE_CHANGED) {
+    return GST_BUS_PASS;
+  }
+
+  g_rec_mutex_lock (&gsti->prerolllock);
+
+  if (gsti->prerollidx < 0) {
+    g_rec_mutex_unlock (&gsti->prerolllock);
+    return GST_BUS_PASS;
+  }
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS &&
+      gstiidx->idx != gsti->prerollidx &&
+      gsti->prerollready &&
+      ! gsti->prerollhold) {
+    gsti->eostime = g_get_monotonic_time ();
+    gsti->switchtime = 0;
+    gsti->prerollready = false;
+    gsti->gaplessswitch = true;
+    /* a different pipeline, so the state may be changed from here */
+    gst_element_set_state (GST_ELEMENT (gsti->pipeline [gsti->prerollidx]), GST_STATE_PLAYING);
+  }
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_STATE_CHANGED &&
+      gstiidx->idx == gsti->prerollidx &&
+      (gsti->gaplessswitch || gsti->gaplessswitched) &&
+      gsti->switchtime == 0 &&
+      GST_MESSAGE_SRC (message) == GST_OBJECT (gsti->pipeline [gstiidx->idx])) {
+    GstState old_state, new_state, pending_state;
+
+    gst_message_parse_state_changed (message, &old_state, &new_state, &pending_state);
+    if (new_state == GST_STATE_PLAYING) {
+      gsti->switchtime = g_get_monotonic_time ();
+    }
+  }
+
+  g_rec_mutex_unlock (&gsti->prerolllock);
+  return GST_BUS_PASS;
+}
+
+static void
+gstiMakeURI (char *tbuff, size_t sz, const char *fulluri, int sourceType)
+{
+  if (sourceType == AUDIOSRC_TYPE_FILE) {
+    snprintf (tbuff, sz, "%s%s", AS_FILE_PFX, fulluri);
+  } else {
+    stpecpy (tbuff, tbuff + sz, fulluri);
+  }
+}
+
+/* finish the switch-over to the pre-rolled pipeline after */
+/* the end-of-stream has been processed by the sync-handler */
+static void
+gstiGaplessSwitch (gsti_t *gsti)
+{
+  int     previdx;
+
+  g_rec_mutex_lock (&gsti->prerolllock);
+  if (! gsti->gaplessswitch) {
+    g_rec_mutex_unlock (&gsti->prerolllock);
+    return;
+  }
+
+  gsti->gaplessswitch = false;
+  gsti->gaplessswitched = true;
+  previdx = gsti->curr;
+  gsti->curr = gsti->prerollidx;
+  g_rec_mutex_unlock (&gsti->prerolllock);
+
+  if (! gst_element_set_state (GST_ELEMENT (gsti->pipeline [previdx]), GST_STATE_READY)) {
+    fprintf (stderr, "ERR: unable to set state (gapless) %d\n", previdx);
+  }
+  gsti->state = PLI_STATE_STOPPED;
+  logMsg (LOG_DBG, LOG_BASIC, "gapless: switch %d to %d", previdx, gsti->curr);
+}
+
+static void
+gstiPrerollCancel (gsti_t *gsti)
+{
+  int     idx;
+  bool    switched;
+
+  g_rec_mutex_lock (&gsti->prerolllock);
+  idx = gsti->prerollidx;
+  switched = gsti->gaplessswitch || gsti->gaplessswitched;
+  gsti->prerollidx = -1;
+  gsti->prerollready = false;
+  gsti->gaplessswitch = false;
+  gsti->gaplessswitched = false;
+  dataFree (gsti->prerolluri);
+  gsti->prerolluri = NULL;
+  g_rec_mutex_unlock (&gsti->prerolllock);
+
+  if (idx < 0) {
+    return;
+  }
+
+  if (! gst_element_set_state (GST_ELEMENT (gsti->pipeline [idx]), GST_STATE_READY)) {
+    fprintf (stderr, "ERR: unable to set state (preroll-cancel) %d\n", idx);
+  }
+  if (switched) {
+    /* the next song had already been started, */
+    /* the end-of-stream of the prior song still stands */
+    logMsg (LOG_DBG, LOG_BASIC, "gapless: cancel after switch");
+    gsti->state = PLI_STATE_STOPPED;
+  }
+  logMsg (LOG_DBG, LOG_BASIC, "gapless: pre-roll cancel %d", idx);
+}
+
 /* while stopping states get messed up */
 static void
 gstiProcessState (gsti_t *gsti, GstState state)
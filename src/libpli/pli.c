@@ -42,6 +42,7 @@ typedef struct pli {
   plidata_t         *(*pliiInit) (const char *plinm, const char *playerargs);
   void              (*pliiFree) (plidata_t *plidata);
   void              (*pliiMediaSetup) (plidata_t *plidata, const char *mediaPath, const char *fullMediaPath, int sourceType);
+  void              (*pliiMediaPreroll) (plidata_t *plidata, const char *mediaPath, const char *fullMediaPath, int sourceType);
   void              (*pliiCrossFade) (plidata_t *plidata, const char *mediaPath, const char *fullMediaPath, int sourceType);
   void              (*pliiStartPlayback) (plidata_t *plidata, ssize_t pos, ssize_t speed);
   void              (*pliiCrossFadeVolume) (plidata_t *plidata, int vol);
@@ -73,6 +74,7 @@ pliInit (const char *plipkg, const char *plinm)
   pli->pliiInit = NULL;
   pli->pliiFree = NULL;
   pli->pliiMediaSetup = NULL;
+  pli->pliiMediaPreroll = NULL;
   pli->pliiCrossFade = NULL;
   pli->pliiStartPlayback = NULL;
   pli->pliiCrossFadeVolume = NULL;
@@ -105,6 +107,7 @@ pliInit (const char *plipkg, const char *plinm)
   pli->pliiInit = dylibLookup (pli->dlHandle, "pliiInit");
   pli->pliiFree = dylibLookup (pli->dlHandle, "pliiFree");
   pli->pliiMediaSetup = dylibLookup (pli->dlHandle, "pliiMediaSetup");
+  pli->pliiMediaPreroll = dylibLookup (pli->dlHandle, "pliiMediaPreroll");
   pli->pliiCrossFade = dylibLookup (pli->dlHandle, "pliiCrossFade");
   pli->pliiStartPlayback = dylibLookup (pli->dlHandle, "pliiStartPlayback");
   pli->pliiCrossFadeVolume = dylibLookup (pli->dlHandle, "pliiCrossFadeVolume");
@@ -155,6 +158,17 @@ pliMediaSetup (pli_t *pli, const char *mediaPath,
   }
 }
 
+/* only available if the interface supports PLI_SUPPORT_PREROLL */
+/* a null media-path cancels the pre-roll */
+void
+pliMediaPreroll (pli_t *pli, const char *mediaPath,
+    const char *fullMediaPath, int sourceType)
+{
+  if (pli != NULL && pli->pliiMediaPreroll != NULL) {
+    pli->pliiMediaPreroll (pli->plidata, mediaPath, fullMediaPath, sourceType);
+  }
+}
+
 void
 pliStartPlayback (pli_t *pli, ssize_t pos, ssize_t speed)
 {
@@ -51,7 +51,8 @@ pliiInit (const char *plinm, const char *playerargs)
       PLI_SUPPORT_SPEED |
       PLI_SUPPORT_STREAM |
       PLI_SUPPORT_STREAM_SPD |
-      PLI_SUPPORT_CROSSFADE;
+      PLI_SUPPORT_CROSSFADE |
+      PLI_SUPPORT_PREROLL;
 
   return plidata;
 }
@@ -81,6 +82,21 @@ pliiMediaSetup (plidata_t *plidata, const char *mediaPath,
   plidata->state = PLI_STATE_STOPPED;
 }
 
+void
+pliiMediaPreroll (plidata_t *plidata, const char *mediaPath,
+    const char *fullMediaPath, int sourceType)
+{
+  if (plidata == NULL) {
+    return;
+  }
+
+  if (mediaPath == NULL) {
+    gstiPreroll (plidata->gsti, NULL, sourceType);
+    return;
+  }
+  gstiPreroll (plidata->gsti, fullMediaPath, sourceType);
+}
+
 void
 pliiCleanup (void)
 {
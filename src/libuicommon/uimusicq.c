@@ -32,6 +32,7 @@
 #include "uiexppl.h"
 #include "callback.h"
 #include "uimusicq.h"
+#include "uisong.h"
 
 uimusicq_t *
 uimusicqInit (const char *tag, conn_t *conn, musicdb_t *musicdb,
@@ -97,6 +98,7 @@ void
 uimusicqSetDatabase (uimusicq_t *uimusicq, musicdb_t *musicdb)
 {
   uimusicq->musicdb = musicdb;
+  uisongCacheReset ();
 }
 
 void
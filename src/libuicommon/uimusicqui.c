@@ -147,6 +147,7 @@ uimusicqUIInit (uimusicq_t *uimusicq)
   }
 
   uiutilsAddFavoriteClasses ();
+  uisongCacheInit ();
 }
 
 void
@@ -169,6 +170,7 @@ uimusicqUIFree (uimusicq_t *uimusicq)
       mdfree (mqint);
     }
   }
+  uisongCacheCleanup ();
 }
 
 uiwcont_t *
@@ -1204,7 +1206,6 @@ uimusicqFillRow (void *udata, uivirtlist_t *vl, int32_t rownum)
   mp_musicqupditem_t  *musicqupditem;
   song_t              *song;
   uiwcont_t           *pauseimg = NULL;
-  nlist_t             *tdlist;
   slistidx_t          seliteridx;
   char                tmp [40];
 
@@ -1241,17 +1242,13 @@ uimusicqFillRow (void *udata, uivirtlist_t *vl, int32_t rownum)
   uivlSetRowColumnImage (mqint->uivl, rownum, UIMUSICQ_COL_PAUSEIND,
       pauseimg, 20);
 
-  tdlist = uisongGetDisplayList (mqint->sellist, NULL, song);
   slistStartIterator (mqint->sellist, &seliteridx);
   for (int colidx = UIMUSICQ_COL_MAX; colidx < mqint->colcount; ++colidx) {
     int         tagidx;
     const char  *str;
 
     tagidx = slistIterateValueNum (mqint->sellist, &seliteridx);
-    str = nlistGetStr (tdlist, tagidx);
-    if (str == NULL) {
-      str = "";
-    }
+    str = uisongGetDisplayCached (song, musicqupditem->dbidx, tagidx);
     uivlSetRowColumnStr (mqint->uivl, rownum, colidx, str);
 
     if (tagidx == TAG_FAVORITE) {
@@ -1267,7 +1264,6 @@ uimusicqFillRow (void *udata, uivirtlist_t *vl, int32_t rownum)
       uivlSetRowColumnClass (mqint->uivl, rownum, colidx, name);
     }
   }
-  nlistFree (tdlist);
 
   mqint->inchange = false;
 }
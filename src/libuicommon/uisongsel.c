@@ -21,6 +21,7 @@
 #include "mdebug.h"
 #include "samesong.h"
 #include "uimusicq.h"
+#include "uisong.h"
 #include "uisongsel.h"
 #include "ui.h"
 #include "callback.h"
@@ -84,6 +85,7 @@ void
 uisongselSetDatabase (uisongsel_t *uisongsel, musicdb_t *musicdb)
 {
   uisongsel->musicdb = musicdb;
+  uisongCacheReset ();
 }
 
 void
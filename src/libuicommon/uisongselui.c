@@ -150,6 +150,7 @@ uisongselUIInit (uisongsel_t *uisongsel)
   uisongsel->ssInternalData = ssint;
 
   uiutilsAddFavoriteClasses ();
+  uisongCacheInit ();
 
   logProcEnd ("");
 }
@@ -179,6 +180,7 @@ uisongselUIFree (uisongsel_t *uisongsel)
   uivlFree (ssint->uivl);
   mdfree (ssint);
   uisongsel->ssInternalData = NULL;
+  uisongCacheCleanup ();
   logProcEnd ("");
 }
 
@@ -975,7 +977,6 @@ uisongselFillRow (void *udata, uivirtlist_t *vl, int32_t rownum)
   ss_internal_t       *ssint = udata;
   uisongsel_t         *uisongsel = ssint->uisongsel;
   song_t              *song;
-  nlist_t             *tdlist;
   slistidx_t          seliteridx;
   dbidx_t             dbidx;
   int                 dbflags;
@@ -994,17 +995,13 @@ uisongselFillRow (void *udata, uivirtlist_t *vl, int32_t rownum)
 
   ssint->inchange = true;
 
-  tdlist = uisongGetDisplayList (ssint->sellist, NULL, song);
   slistStartIterator (ssint->sellist, &seliteridx);
   for (int colidx = SONGSEL_COL_MAX; colidx < ssint->colcount; ++colidx) {
     int         tagidx;
     const char  *str;
 
     tagidx = slistIterateValueNum (ssint->sellist, &seliteridx);
-    str = nlistGetStr (tdlist, tagidx);
-    if (str == NULL) {
-      str = "";
-    }
+    str = uisongGetDisplayCached (song, dbidx, tagidx);
     uivlSetRowColumnStr (ssint->uivl, rownum, colidx, str);
 
     if (tagidx == TAG_FAVORITE) {
@@ -1022,7 +1019,6 @@ uisongselFillRow (void *udata, uivirtlist_t *vl, int32_t rownum)
       uivlSetRowColumnClass (ssint->uivl, rownum, colidx, ERROR_CLASS);
     }
   }
-  nlistFree (tdlist);
 
   uisongselFillMark (uisongsel, ssint, dbidx, rownum);
 
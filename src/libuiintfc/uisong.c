@@ -13,6 +13,7 @@
 #include <math.h>
 
 #include "mdebug.h"
+#include "musicdb.h"
 #include "slist.h"
 #include "songutil.h"
 #include "tagdef.h"
@@ -20,7 +21,37 @@
 #include "uisong.h"
 #include "uivirtlist.h"
 
+/* the display strings for the song lists are cached so that */
+/* re-filling a row (scrolling) does not need to re-build the strings. */
+/* the cache is direct-mapped by dbidx, and only the tags that */
+/* are displayed are stored. */
+/* the cached strings are valid until the entry is invalidated, or */
+/* the cache is reset (database reload, display changes). */
+enum {
+  UISONG_CACHE_SZ = 1024,
+  UISONG_CACHE_TAG_MAX = 24,
+};
+
+typedef struct {
+  dbidx_t   dbidx;
+  uint32_t  gen;
+  char      *str [UISONG_CACHE_TAG_MAX];
+} uisongcacheent_t;
+
+typedef struct {
+  uisongcacheent_t  *ents;
+  char              *tmp;
+  int               refcount;
+  uint32_t          gen;
+  int               tagcount;
+  int8_t            tagslot [TAG_KEY_MAX];
+} uisongcache_t;
+
+static uisongcache_t  uisongcache = { NULL, NULL, 0, 1, 0, { 0 } };
+
 static valuetype_t uisongDetermineValueType (int tagidx);
+static char *uisongGetDisplayStr (song_t *song, int tagidx);
+static void uisongCacheClearTags (void);
 
 nlist_t *
 uisongGetDisplayList (slist_t *sellistA, slist_t *sellistB, song_t *song)
@@ -29,8 +60,6 @@ uisongGetDisplayList (slist_t *sellistA, slist_t *sellistB, song_t *song)
   int           tagidx;
   char          *str = NULL;
   nlist_t       *dlist;
-  int32_t       num;
-  double        dval;
 
   dlist = nlistAlloc ("song-disp", LIST_UNORDERED, NULL);
   nlistSetSize (dlist, slistGetCount (sellistA));
@@ -41,21 +70,15 @@ uisongGetDisplayList (slist_t *sellistA, slist_t *sellistB, song_t *song)
       nlistSetStr (dlist, tagidx, "");
       continue;
     }
-    if (song != NULL) {
-      str = uisongGetDisplay (song, tagidx, &num, &dval);
-    } else {
+    if (song == NULL) {
       nlistSetStr (dlist, tagidx, "");
-      num = LIST_VALUE_INVALID;
+      continue;
     }
 
+    str = uisongGetDisplayStr (song, tagidx);
     if (str != NULL) {
       nlistSetStr (dlist, tagidx, str);
       mdfree (str);
-    } else if (num != LIST_VALUE_INVALID) {
-      char  tmp [40];
-
-      snprintf (tmp, sizeof (tmp), "%" PRId32, num);
-      nlistSetStr (dlist, tagidx, tmp);
     }
   } /* for each tagidx in the display selection list */
 
@@ -66,21 +89,15 @@ uisongGetDisplayList (slist_t *sellistA, slist_t *sellistB, song_t *song)
     /* this is a bit inefficient, as there are many duplicates */
     slistStartIterator (sellistB, &seliteridx);
     while ((tagidx = slistIterateValueNum (sellistB, &seliteridx)) >= 0) {
-      if (song != NULL) {
-        str = uisongGetDisplay (song, tagidx, &num, &dval);
-      } else {
+      if (song == NULL) {
         nlistSetStr (dlist, tagidx, "");
-        num = LIST_VALUE_INVALID;
+        continue;
       }
 
+      str = uisongGetDisplayStr (song, tagidx);
       if (str != NULL) {
         nlistSetStr (dlist, tagidx, str);
         mdfree (str);
-      } else if (num != LIST_VALUE_INVALID) {
-        char  tmp [40];
-
-        snprintf (tmp, sizeof (tmp), "%" PRId32, num);
-        nlistSetStr (dlist, tagidx, tmp);
       }
     }
   }
@@ -143,6 +160,133 @@ uisongGetValue (song_t *song, int tagidx, int32_t *num, double *dval)
   return str;
 }
 
+/* the cache is shared by the song lists in the process */
+void
+uisongCacheInit (void)
+{
+  uisongcache.refcount += 1;
+  if (uisongcache.ents != NULL) {
+    return;
+  }
+
+  uisongcache.ents = mdmalloc (sizeof (uisongcacheent_t) * UISONG_CACHE_SZ);
+  for (int i = 0; i < UISONG_CACHE_SZ; ++i) {
+    uisongcache.ents [i].dbidx = -1;
+    uisongcache.ents [i].gen = 0;
+    for (int j = 0; j < UISONG_CACHE_TAG_MAX; ++j) {
+      uisongcache.ents [i].str [j] = NULL;
+    }
+  }
+  uisongcache.tmp = NULL;
+  uisongCacheClearTags ();
+}
+
+void
+uisongCacheCleanup (void)
+{
+  uisongcache.refcount -= 1;
+  if (uisongcache.refcount > 0 || uisongcache.ents == NULL) {
+    return;
+  }
+
+  for (int i = 0; i < UISONG_CACHE_SZ; ++i) {
+    for (int j = 0; j < UISONG_CACHE_TAG_MAX; ++j) {
+      dataFree (uisongcache.ents [i].str [j]);
+    }
+  }
+  mdfree (uisongcache.ents);
+  uisongcache.ents = NULL;
+  dataFree (uisongcache.tmp);
+  uisongcache.tmp = NULL;
+  uisongcache.refcount = 0;
+}
+
+/* the song has changed */
+void
+uisongCacheInvalidate (dbidx_t dbidx)
+{
+  uisongcacheent_t  *ent;
+
+  if (uisongcache.ents == NULL || dbidx < 0) {
+    return;
+  }
+
+  ent = &uisongcache.ents [dbidx % UISONG_CACHE_SZ];
+  if (ent->dbidx == dbidx) {
+    ent->gen = 0;
+  }
+}
+
+/* the database has been re-loaded, or the display has changed */
+/* the entries are released as they are re-used */
+void
+uisongCacheReset (void)
+{
+  if (uisongcache.ents == NULL) {
+    return;
+  }
+
+  uisongcache.gen += 1;
+  if (uisongcache.gen == 0) {
+    uisongcache.gen = 1;
+  }
+  uisongCacheClearTags ();
+}
+
+/* the returned string is owned by the cache, and is valid until */
+/* the next call */
+const char *
+uisongGetDisplayCached (song_t *song, dbidx_t dbidx, int tagidx)
+{
+  uisongcacheent_t  *ent;
+  int               slot;
+
+  if (song == NULL || tagidx < 0 || tagidx >= TAG_KEY_MAX) {
+    return "";
+  }
+  if (tagidx == TAG_AUDIOID_IDENT || tagidx == TAG_AUDIOID_SCORE) {
+    return "";
+  }
+
+  slot = -1;
+  if (uisongcache.ents != NULL && dbidx >= 0) {
+    slot = uisongcache.tagslot [tagidx];
+    if (slot < 0 && uisongcache.tagcount < UISONG_CACHE_TAG_MAX) {
+      slot = uisongcache.tagcount;
+      uisongcache.tagslot [tagidx] = slot;
+      uisongcache.tagcount += 1;
+    }
+  }
+
+  if (slot < 0) {
+    /* not cached */
+    dataFree (uisongcache.tmp);
+    uisongcache.tmp = uisongGetDisplayStr (song, tagidx);
+    if (uisongcache.tmp == NULL) {
+      return "";
+    }
+    return uisongcache.tmp;
+  }
+
+  ent = &uisongcache.ents [dbidx % UISONG_CACHE_SZ];
+  if (ent->dbidx != dbidx || ent->gen != uisongcache.gen) {
+    for (int j = 0; j < UISONG_CACHE_TAG_MAX; ++j) {
+      dataFree (ent->str [j]);
+      ent->str [j] = NULL;
+    }
+    ent->dbidx = dbidx;
+    ent->gen = uisongcache.gen;
+  }
+
+  if (ent->str [slot] == NULL) {
+    ent->str [slot] = uisongGetDisplayStr (song, tagidx);
+    if (ent->str [slot] == NULL) {
+      ent->str [slot] = mdstrdup ("");
+    }
+  }
+
+  return ent->str [slot];
+}
 
 /* internal routines */
 
@@ -170,3 +314,30 @@ uisongDetermineValueType (int tagidx)
   return vt;
 }
 
+/* returns null if there is no value to display */
+static char *
+uisongGetDisplayStr (song_t *song, int tagidx)
+{
+  char      *str;
+  int32_t   num;
+  double    dval;
+
+  str = uisongGetDisplay (song, tagidx, &num, &dval);
+  if (str == NULL && num != LIST_VALUE_INVALID) {
+    char  tmp [40];
+
+    snprintf (tmp, sizeof (tmp), "%" PRId32, num);
+    str = mdstrdup (tmp);
+  }
+
+  return str;
+}
+
+static void
+uisongCacheClearTags (void)
+{
+  for (int i = 0; i < TAG_KEY_MAX; ++i) {
+    uisongcache.tagslot [i] = -1;
+  }
+  uisongcache.tagcount = 0;
+}
@@ -46,6 +46,7 @@ enum {
   VL_ROW_NO_LOCK = -1,
   VL_UNK_ROW = -1,
   VL_REUSE_HEIGHT = -2,
+  VL_SEL_INCR = 16,
 };
 
 
@@ -93,6 +94,21 @@ typedef struct uivlcol uivlcol_t;
 typedef struct uivlcoldata uivlcoldata_t;
 typedef struct uivlrow uivlrow_t;
 
+/* the selection is kept as a sorted list of disjoint row ranges */
+/* (inclusive), so that large selections (select-all, shift-click) */
+/* take very little memory and time. */
+typedef struct {
+  int32_t       beg;
+  int32_t       end;
+} uivlselrange_t;
+
+typedef struct {
+  uivlselrange_t  *ranges;
+  int32_t         count;        // number of ranges
+  int32_t         alloccount;
+  int32_t         rowcount;     // number of selected rows
+} uivlsel_t;
+
 typedef struct {
   uivirtlist_t    *vl;
   int             dispidx;
@@ -202,7 +218,7 @@ typedef struct uivirtlist {
   int32_t       rowoffset;
   int32_t       lastSelection;    // used for shift-click
   int32_t       currSelection;
-  nlist_t       *selected;
+  uivlsel_t     selected;
   int           lockcount;
   int           initialized;
   /* user callbacks */
@@ -242,6 +258,16 @@ static void uivlSetDisplaySelections (uivirtlist_t *vl);
 static void uivlClearAllSelections (uivirtlist_t *vl);
 static void uivlClearSelection (uivirtlist_t *vl, int32_t rownum);
 static void uivlAddSelection (uivirtlist_t *vl, uint32_t rownum);
+static void uivlSelInit (uivlsel_t *sel);
+static void uivlSelFree (uivlsel_t *sel);
+static void uivlSelSetSize (uivlsel_t *sel, int32_t count);
+static void uivlSelAddRange (uivlsel_t *sel, int32_t beg, int32_t end);
+static void uivlSelRemove (uivlsel_t *sel, int32_t rownum);
+static bool uivlSelIsSelected (uivlsel_t *sel, int32_t rownum);
+static int32_t uivlSelFind (uivlsel_t *sel, int32_t rownum);
+static int32_t uivlSelNext (uivlsel_t *sel, int32_t rownum);
+static int32_t uivlSelPrevious (uivlsel_t *sel, int32_t rownum);
+static void uivlSelCopy (uivlsel_t *sela, uivlsel_t *selb);
 static void uivlProcessScroll (uivirtlist_t *vl, int32_t start, int sctype);
 static bool uivlVertSizeChg (void *udata, int32_t width, int32_t height);
 static bool uivlHeadingSizeChg (void *udata, int32_t width, int32_t height);
@@ -330,9 +356,9 @@ uivlCreate (const char *tag, uiwcont_t *parentwin, uiwcont_t *boxp,
   vl->numrows = 0;
   vl->rowoffset = 0;
   vl->currSelection = 0;
-  vl->selected = nlistAlloc ("vl-selected", LIST_ORDERED, NULL);
+  uivlSelInit (&vl->selected);
   /* default selection */
-  nlistSetNum (vl->selected, 0, true);
+  uivlSelAddRange (&vl->selected, 0, 0);
   vl->initialized = VL_INIT_NONE;
 
   for (int i = 0; i < VL_W_MAX; ++i) {
@@ -451,7 +477,7 @@ uivlFree (uivirtlist_t *vl)
   }
   dataFree (vl->coldata);
 
-  nlistFree (vl->selected);
+  uivlSelFree (&vl->selected);
 
   for (int i = 0; i < VL_W_MAX; ++i) {
     uiwcontFree (vl->wcont [i]);
@@ -1348,7 +1374,8 @@ uivlStartSelectionIterator (uivirtlist_t *vl, nlistidx_t *iteridx)
     return;
   }
 
-  nlistStartIterator (vl->selected, iteridx);
+  /* the iterator is the last row number returned */
+  *iteridx = -1;
   logProcEnd ("");
 }
 
@@ -1363,7 +1390,9 @@ uivlIterateSelection (uivirtlist_t *vl, nlistidx_t *iteridx)
     return key;
   }
 
-  key = nlistIterateKey (vl->selected, iteridx);
+  key = uivlSelNext (&vl->selected, *iteridx);
+  /* at the end of the list, the iterator is reset, as with an nlist */
+  *iteridx = key;
   logProcEnd ("");
   return key;
 }
@@ -1379,7 +1408,11 @@ uivlIterateSelectionPrevious (uivirtlist_t *vl, nlistidx_t *iteridx)
     return key;
   }
 
-  key = nlistIterateKeyPrevious (vl->selected, iteridx);
+  key = -1;
+  if (*iteridx >= 0) {
+    key = uivlSelPrevious (&vl->selected, *iteridx);
+  }
+  *iteridx = key;
   logProcEnd ("");
   return key;
 }
@@ -1394,7 +1427,7 @@ uivlSelectionCount (uivirtlist_t *vl)
   }
 
   logProcEnd ("");
-  return nlistGetCount (vl->selected);
+  return vl->selected.rowcount;
 }
 
 int32_t
@@ -1406,7 +1439,7 @@ uivlGetCurrSelection (uivirtlist_t *vl)
     return 0;
   }
 
-  if (nlistGetCount (vl->selected) == 0) {
+  if (vl->selected.rowcount == 0) {
     logProcEnd ("no-sel");
     return VL_UNK_ROW;
   }
@@ -1444,7 +1477,7 @@ uivlAppendSelection (uivirtlist_t *vl, int32_t rownum)
   rownum = uivlRownumLimit (vl, rownum);
   uivlAddSelection (vl, rownum);
   uivlSetDisplaySelections (vl);
-  if (nlistGetCount (vl->selected) == 1) {
+  if (vl->selected.rowcount == 1) {
     vl->lastSelection = vl->currSelection;
   }
   logProcEnd ("");
@@ -1479,9 +1512,6 @@ uivlMoveSelection (uivirtlist_t *vl, int dir)
 void
 uivlCopySelectList (uivirtlist_t *vl_a, uivirtlist_t *vl_b)
 {
-  nlistidx_t    iter_a;
-  int32_t       rowidx;
-
   logProcBegin ();
   if (vl_a == NULL || vl_b == NULL) {
     logProcEnd ("bad-vl");
@@ -1490,12 +1520,22 @@ uivlCopySelectList (uivirtlist_t *vl_a, uivirtlist_t *vl_b)
 
   /* copy the selected list to vl_b */
   logMsg (LOG_DBG, LOG_VIRTLIST, "vl: copy sel from %s to %s", vl_a->tag, vl_b->tag);
+  /* the select-change callback only needs to see the first selected */
+  /* row on its own and the final selection, not every row */
   uivlClearAllSelections (vl_b);
-  nlistStartIterator (vl_a->selected, &iter_a);
-  while ((rowidx = nlistIterateKey (vl_a->selected, &iter_a)) >= 0) {
+  if (vl_a->selected.count > 0) {
+    int32_t   rowidx;
+
+    rowidx = vl_a->selected.ranges [0].beg;
     uivlAddSelection (vl_b, rowidx);
     uivlSelectChgHandler (vl_b, rowidx, VL_COL_UNKNOWN);
   }
+  uivlSelCopy (&vl_a->selected, &vl_b->selected);
+  /* the current selection is the last selected row */
+  if (vl_b->selected.rowcount > 1) {
+    vl_b->currSelection = vl_b->selected.ranges [vl_b->selected.count - 1].end;
+    uivlSelectChgHandler (vl_b, vl_b->currSelection, VL_COL_UNKNOWN);
+  }
   uivlClearDisplaySelections (vl_b);
   uivlSetDisplaySelections (vl_b);
   uivlCopyPosition (vl_a, vl_b);
@@ -2100,7 +2140,7 @@ uivlKeyEvent (void *udata)
       dir = - dir;
     }
 
-    if (nlistGetCount (vl->selected) == 1) {
+    if (vl->selected.rowcount == 1) {
       nsel = vl->currSelection + dir;
       nsel = uivlRownumLimit (vl, nsel);
       /* use the keyboard scroll update mode */
@@ -2287,12 +2327,15 @@ uivlClearDisplaySelections (uivirtlist_t *vl)
 static void
 uivlSetDisplaySelections (uivirtlist_t *vl)
 {
-  nlistidx_t    iter;
-  nlistidx_t    rownum;
+  int32_t       rownum;
+  int32_t       lastrow;
 
   logProcBegin ();
-  nlistStartIterator (vl->selected, &iter);
-  while ((rownum = nlistIterateKey (vl->selected, &iter)) >= 0) {
+  /* only the selected rows that are displayed need to be processed */
+  lastrow = vl->rowoffset + (vl->dispsize - vl->headingoffset);
+  rownum = vl->rowoffset - 1;
+  while ((rownum = uivlSelNext (&vl->selected, rownum)) >= 0 &&
+      rownum < lastrow) {
     uivlrow_t   *row;
 
     row = uivlGetRow (vl, rownum);
@@ -2329,32 +2372,23 @@ static void
 uivlClearAllSelections (uivirtlist_t *vl)
 {
   logProcBegin ();
-  nlistFree (vl->selected);
-  vl->selected = nlistAlloc ("vl-selected", LIST_ORDERED, NULL);
+  vl->selected.count = 0;
+  vl->selected.rowcount = 0;
   logProcEnd ("");
 }
 
 static void
 uivlClearSelection (uivirtlist_t *vl, int32_t rownum)
 {
-  nlist_t     *newsel;
-  nlistidx_t  iteridx;
-  nlistidx_t  key;
+  int32_t     count;
 
   logProcBegin ();
-  newsel = nlistAlloc ("vl-selected", LIST_UNORDERED, NULL);
-  nlistSetSize (newsel, nlistGetCount (vl->selected));
-  nlistStartIterator (vl->selected, &iteridx);
-  while ((key = nlistIterateKey (vl->selected, &iteridx)) >= 0) {
-    if (key == rownum) {
-      continue;
-    }
-    nlistSetNum (newsel, key, true);
-    vl->currSelection = key;
+  uivlSelRemove (&vl->selected, rownum);
+  /* the current selection is the last selected row */
+  count = vl->selected.count;
+  if (count > 0) {
+    vl->currSelection = vl->selected.ranges [count - 1].end;
   }
-  nlistSort (newsel);
-  nlistFree (vl->selected);
-  vl->selected = newsel;
   logProcEnd ("");
 }
 
@@ -2362,7 +2396,7 @@ static void
 uivlAddSelection (uivirtlist_t *vl, uint32_t rownum)
 {
   logProcBegin ();
-  nlistSetNum (vl->selected, rownum, true);
+  uivlSelAddRange (&vl->selected, rownum, rownum);
   vl->currSelection = rownum;
   logProcEnd ("");
 }
@@ -2385,7 +2419,7 @@ uivlProcessScroll (uivirtlist_t *vl, int32_t start, int sctype)
   /* if this is a keyboard movement, and there's only one selection */
   /* and the desired row-number is on-screen */
   if (sctype == VL_SCROLL_KEY &&
-      nlistGetCount (vl->selected) == 1 &&
+      vl->selected.rowcount == 1 &&
       wantrow >= vl->rowoffset &&
       wantrow < vl->rowoffset + (vl->dispsize - vl->headingoffset)) {
     if (wantrow < vl->currSelection) {
@@ -2414,7 +2448,7 @@ uivlProcessScroll (uivirtlist_t *vl, int32_t start, int sctype)
   /* if this is a normal selection, and there's only one selection */
   /* and the desired row-number is on-screen */
   if (sctype == VL_SCROLL_NORM &&
-      nlistGetCount (vl->selected) == 1 &&
+      vl->selected.rowcount == 1 &&
       wantrow >= vl->rowoffset &&
       wantrow < vl->rowoffset + (vl->dispsize - vl->headingoffset)) {
     start = vl->rowoffset;
@@ -2614,13 +2648,11 @@ uivlUpdateSelections (uivirtlist_t *vl, int32_t rownum)
       min = rownum;
       max = vl->lastSelection;
     }
-    for (int32_t trownum = min; trownum <= max; ++trownum) {
-      uivlAddSelection (vl, trownum);
-    }
+    uivlSelAddRange (&vl->selected, min, max);
   }
 
   if (vl->allowmultiple == true && controlpressed) {
-    if (nlistGetNum (vl->selected, rownum) == true) {
+    if (uivlSelIsSelected (&vl->selected, rownum)) {
       already = true;
     }
   }
@@ -2634,7 +2666,7 @@ uivlUpdateSelections (uivirtlist_t *vl, int32_t rownum)
 
   uivlClearDisplaySelections (vl);
   uivlSetDisplaySelections (vl);
-  if (nlistGetCount (vl->selected) == 1) {
+  if (vl->selected.rowcount == 1) {
     vl->lastSelection = vl->currSelection;
   }
   logProcEnd ("");
@@ -3086,3 +3118,195 @@ uivlRemoveLastHighlight (uivirtlist_t *vl)
     vl->lastdisphighlight = VL_UNK_ROW;
   }
 }
+
+/* selection ranges */
+
+static void
+uivlSelInit (uivlsel_t *sel)
+{
+  sel->ranges = NULL;
+  sel->count = 0;
+  sel->alloccount = 0;
+  sel->rowcount = 0;
+}
+
+static void
+uivlSelFree (uivlsel_t *sel)
+{
+  dataFree (sel->ranges);
+  uivlSelInit (sel);
+}
+
+static void
+uivlSelSetSize (uivlsel_t *sel, int32_t count)
+{
+  if (count <= sel->alloccount) {
+    return;
+  }
+
+  sel->alloccount = count + VL_SEL_INCR;
+  sel->ranges = mdrealloc (sel->ranges,
+      sizeof (uivlselrange_t) * sel->alloccount);
+}
+
+/* adjacent and overlapping ranges are merged */
+static void
+uivlSelAddRange (uivlsel_t *sel, int32_t beg, int32_t end)
+{
+  int32_t   idx;
+  int32_t   eidx;
+
+  if (beg > end) {
+    int32_t   tval;
+
+    tval = beg;
+    beg = end;
+    end = tval;
+  }
+  if (beg < 0) {
+    return;
+  }
+
+  idx = uivlSelFind (sel, beg - 1);
+  eidx = idx;
+  while (eidx < sel->count && sel->ranges [eidx].beg <= end + 1) {
+    if (sel->ranges [eidx].beg < beg) {
+      beg = sel->ranges [eidx].beg;
+    }
+    if (sel->ranges [eidx].end > end) {
+      end = sel->ranges [eidx].end;
+    }
+    sel->rowcount -= sel->ranges [eidx].end - sel->ranges [eidx].beg + 1;
+    ++eidx;
+  }
+
+  /* ranges idx to eidx-1 are replaced by the new range */
+  if (eidx == idx) {
+    uivlSelSetSize (sel, sel->count + 1);
+    memmove (&sel->ranges [idx + 1], &sel->ranges [idx],
+        sizeof (uivlselrange_t) * (sel->count - idx));
+    sel->count += 1;
+  } else if (eidx > idx + 1) {
+    memmove (&sel->ranges [idx + 1], &sel->ranges [eidx],
+        sizeof (uivlselrange_t) * (sel->count - eidx));
+    sel->count -= eidx - idx - 1;
+  }
+
+  sel->ranges [idx].beg = beg;
+  sel->ranges [idx].end = end;
+  sel->rowcount += end - beg + 1;
+}
+
+static void
+uivlSelRemove (uivlsel_t *sel, int32_t rownum)
+{
+  int32_t         idx;
+  uivlselrange_t  *range;
+
+  idx = uivlSelFind (sel, rownum);
+  if (idx >= sel->count || sel->ranges [idx].beg > rownum) {
+    return;
+  }
+
+  range = &sel->ranges [idx];
+  if (range->beg == range->end) {
+    memmove (&sel->ranges [idx], &sel->ranges [idx + 1],
+        sizeof (uivlselrange_t) * (sel->count - idx - 1));
+    sel->count -= 1;
+  } else if (rownum == range->beg) {
+    range->beg += 1;
+  } else if (rownum == range->end) {
+    range->end -= 1;
+  } else {
+    /* split the range */
+    uivlSelSetSize (sel, sel->count + 1);
+    memmove (&sel->ranges [idx + 1], &sel->ranges [idx],
+        sizeof (uivlselrange_t) * (sel->count - idx));
+    sel->count += 1;
+    sel->ranges [idx].end = rownum - 1;
+    sel->ranges [idx + 1].beg = rownum + 1;
+  }
+  sel->rowcount -= 1;
+}
+
+static bool
+uivlSelIsSelected (uivlsel_t *sel, int32_t rownum)
+{
+  int32_t   idx;
+
+  idx = uivlSelFind (sel, rownum);
+  if (idx < sel->count && sel->ranges [idx].beg <= rownum) {
+    return true;
+  }
+  return false;
+}
+
+/* returns the index of the first range that ends at or after rownum */
+static int32_t
+uivlSelFind (uivlsel_t *sel, int32_t rownum)
+{
+  int32_t   l = 0;
+  int32_t   r = sel->count;
+
+  while (l < r) {
+    int32_t   m;
+
+    m = l + (r - l) / 2;
+    if (sel->ranges [m].end < rownum) {
+      l = m + 1;
+    } else {
+      r = m;
+    }
+  }
+
+  return l;
+}
+
+/* returns the first selected row after rownum, or -1 */
+static int32_t
+uivlSelNext (uivlsel_t *sel, int32_t rownum)
+{
+  int32_t   idx;
+
+  ++rownum;
+  idx = uivlSelFind (sel, rownum);
+  if (idx >= sel->count) {
+    return -1;
+  }
+  if (sel->ranges [idx].beg > rownum) {
+    rownum = sel->ranges [idx].beg;
+  }
+  return rownum;
+}
+
+/* returns the last selected row before rownum, or -1 */
+static int32_t
+uivlSelPrevious (uivlsel_t *sel, int32_t rownum)
+{
+  int32_t   idx;
+
+  --rownum;
+  if (rownum < 0) {
+    return -1;
+  }
+  idx = uivlSelFind (sel, rownum);
+  if (idx < sel->count && sel->ranges [idx].beg <= rownum) {
+    return rownum;
+  }
+  if (idx > 0) {
+    return sel->ranges [idx - 1].end;
+  }
+  return -1;
+}
+
+static void
+uivlSelCopy (uivlsel_t *sela, uivlsel_t *selb)
+{
+  uivlSelSetSize (selb, sela->count);
+  if (sela->count > 0) {
+    memcpy (selb->ranges, sela->ranges,
+        sizeof (uivlselrange_t) * sela->count);
+  }
+  selb->count = sela->count;
+  selb->rowcount = sela->rowcount;
+}
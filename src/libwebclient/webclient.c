@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <inttypes.h>
 #include <errno.h>
@@ -31,6 +32,9 @@
 enum {
   SUPPORT_BUFF_SZ = (10*1024*1024),
   SMALL_BUFF_SZ = (1*1024*1024),
+  WEB_MULTI_POOL_SZ = 4,
+  WEB_MULTI_REQ_INCR = 8,
+  WEB_MULTI_HOST_CONN = 6,
 };
 
 typedef struct webclient {
@@ -41,6 +45,11 @@ typedef struct webclient {
   size_t          dlChunks;
   mstime_t        dlStart;
   FILE            *dlFH;
+  webrange_t      *range;
+  int             rangecode;
+  webclientstreamcb_t streamcb;
+  void            *streamudata;
+  bool            streamstop;
   char            *resp;
   size_t          respAllocated;
   size_t          respSize;
@@ -48,19 +57,46 @@ typedef struct webclient {
   char            errstr [CURL_ERROR_SIZE];
 } webclient_t;
 
+typedef struct {
+  webclient_t         *webclient;
+  webclientasynccb_t  cb;
+  void                *userdata;
+  int                 reqid;
+} webclientreq_t;
+
+/* the multi handle maintains the connection and dns caches */
+/* for all of its requests, so that keep-alive connections are re-used. */
+/* the finished webclients are kept in a pool for re-use. */
+typedef struct webclientmulti {
+  CURLM           *multi;
+  webclientreq_t  **reqs;
+  webclient_t     *pool [WEB_MULTI_POOL_SZ];
+  int             reqalloc;
+  int             poolcount;
+  int             active;
+  int             nextid;
+} webclientmulti_t;
+
 static void   webclientInit (webclient_t *webclient);
 static void   webclientInitResp (webclient_t *webclient);
 static size_t webclientCallback (char *ptr, size_t size, size_t nmemb, void *userdata);
 static size_t webclientNullCallback (char *ptr, size_t size, size_t nmemb, void *userdata);
 static size_t webclientDownloadCallback (char *ptr, size_t size, size_t nmemb, void *userdata);
+static size_t webclientStreamCallback (char *ptr, size_t size, size_t nmemb, void *userdata);
+static size_t webclientRangeHeaderCallback (char *ptr, size_t size, size_t nmemb, void *userdata);
 static int webclientDebugCallback (CURL *curl, curl_infotype type, char *data, size_t size, void *userptr);
 static void webclientSetUserAgent (CURL *curl);
 static z_stream * webclientGzipInit (char *out, int outsz);
 static void     webclientGzip (z_stream *zs, const char* in, int insz);
 static size_t   webclientGzipEnd (z_stream *zs);
 static void     webclientCleanup (void);
+static int      webclientMultiRequest (webclientmulti_t *wm, const char *uri, const char *query, long timeout, webclientasynccb_t cb, void *userdata);
+static void     webclientMultiDone (webclientmulti_t *wm, CURL *curl, CURLcode res);
+static void     webclientMultiRemove (webclientmulti_t *wm, int idx);
+static void     webclientMultiRelease (webclientmulti_t *wm, webclient_t *webclient);
 
-static int initialized = 0;
+/* webclients may be allocated by more than one thread */
+static _Atomic(int) initialized = 0;
 
 webclient_t *
 webclientAlloc (void *userdata, webclientcb_t callback)
@@ -74,16 +110,20 @@ webclientAlloc (void *userdata, webclientcb_t callback)
   webclient->dlSize = 0;
   webclient->dlChunks = 0;
   webclient->dlFH = NULL;
+  webclient->range = NULL;
+  webclient->rangecode = 0;
+  webclient->streamcb = NULL;
+  webclient->streamudata = NULL;
+  webclient->streamstop = false;
   webclient->resp = NULL;
   webclient->respAllocated = 0;
   webclient->respSize = 0;
   webclient->respTime = 0;
 
-  if (initialized == 0) {
+  if (atomic_fetch_add (&initialized, 1) == 0) {
     curl_global_init (CURL_GLOBAL_ALL);
     atexit (webclientCleanup);
   }
-  ++initialized;
   webclientInit (webclient);
   return webclient;
 }
@@ -158,6 +198,74 @@ webclientGet (webclient_t *webclient, const char *uri)
   return (int) respcode;
 }
 
+int
+webclientGetStream (webclient_t *webclient, const char *uri,
+    webvalid_t *valid, webclientstreamcb_t cb, void *userdata)
+{
+  struct curl_slist *list = NULL;
+  webrange_t        range;
+  char              tbuff [200];
+  long              respcode;
+  CURLcode          res;
+
+  if (valid != NULL && *valid->etag) {
+    snprintf (tbuff, sizeof (tbuff), "If-None-Match: %s", valid->etag);
+    list = curl_slist_append (list, tbuff);
+  }
+  if (valid != NULL && *valid->lastmod) {
+    snprintf (tbuff, sizeof (tbuff), "If-Modified-Since: %s", valid->lastmod);
+    list = curl_slist_append (list, tbuff);
+  }
+
+  /* the range header callback is used to fetch the validators */
+  range.offset = 0;
+  range.len = 0;
+  range.received = 0;
+  range.total = -1;
+  range.etag [0] = '\0';
+  range.lastmod [0] = '\0';
+  range.validate = false;
+
+  webclient->range = &range;
+  webclient->rangecode = 0;
+  webclient->streamcb = cb;
+  webclient->streamudata = userdata;
+  webclient->streamstop = false;
+  curl_easy_setopt (webclient->curl, CURLOPT_URL, uri);
+  curl_easy_setopt (webclient->curl, CURLOPT_HTTPGET, 1L);
+  curl_easy_setopt (webclient->curl, CURLOPT_HTTPHEADER, list);
+  curl_easy_setopt (webclient->curl, CURLOPT_HEADERFUNCTION, webclientRangeHeaderCallback);
+  curl_easy_setopt (webclient->curl, CURLOPT_HEADERDATA, webclient);
+  curl_easy_setopt (webclient->curl, CURLOPT_WRITEFUNCTION, webclientStreamCallback);
+  curl_easy_setopt (webclient->curl, CURLOPT_ERRORBUFFER, webclient->errstr);
+  res = curl_easy_perform (webclient->curl);
+  if (res != CURLE_OK && ! webclient->streamstop) {
+    logMsg (LOG_DBG, LOG_IMPORTANT, "ERR: get-stream: %s uri: %s", webclient->errstr, uri);
+  }
+
+  curl_easy_getinfo (webclient->curl, CURLINFO_RESPONSE_CODE, &respcode);
+  if (res != CURLE_OK && ! webclient->streamstop && respcode == WEB_OK) {
+    /* the transfer did not complete */
+    respcode = WEB_BAD_REQUEST;
+  }
+  if (respcode == WEB_OK && valid != NULL) {
+    stpecpy (valid->etag, valid->etag + sizeof (valid->etag), range.etag);
+    stpecpy (valid->lastmod, valid->lastmod + sizeof (valid->lastmod),
+        range.lastmod);
+  }
+
+  webclient->range = NULL;
+  webclient->streamcb = NULL;
+  webclient->streamudata = NULL;
+  curl_easy_setopt (webclient->curl, CURLOPT_HTTPHEADER, NULL);
+  curl_easy_setopt (webclient->curl, CURLOPT_HEADERFUNCTION, NULL);
+  curl_easy_setopt (webclient->curl, CURLOPT_HEADERDATA, NULL);
+  curl_easy_setopt (webclient->curl, CURLOPT_WRITEFUNCTION, webclientCallback);
+  curl_slist_free_all (list);
+
+  return (int) respcode;
+}
+
 int
 webclientPost (webclient_t *webclient, const char *uri, const char *query)
 {
@@ -275,6 +383,105 @@ webclientDownload (webclient_t *webclient, const char *uri, const char *outfile)
   return (int) respcode;
 }
 
+/* downloads part of a file into the output file at the same offset. */
+/* the output file is created if it does not exist. */
+/* if query is set, a post is used. */
+/* returns the http response code, 206 for a partial download */
+int
+webclientDownloadRange (webclient_t *webclient, const char *uri,
+    const char *query, const char *outfile, webrange_t *range)
+{
+  struct curl_slist *list = NULL;
+  FILE              *fh;
+  char              tbuff [200];
+  long              respcode;
+  CURLcode          res;
+
+  range->received = 0;
+  range->total = -1;
+
+  /* other range requests may be writing to the same file, */
+  /* the file is created if needed, but is never truncated */
+  if (! fileopFileExists (outfile)) {
+    fh = fileopOpen (outfile, "ab");
+    if (fh != NULL) {
+      mdextfclose (fh);
+      fclose (fh);
+    }
+  }
+  fh = fileopOpen (outfile, "r+b");
+  if (fh == NULL) {
+    logMsg (LOG_DBG, LOG_IMPORTANT, "download-range: unable to open %s %d %s",
+        outfile, errno, strerror (errno));
+    return WEB_BAD_REQUEST;
+  }
+  fileopSeek (fh, range->offset, SEEK_SET);
+
+  /* curl's range option sends a content-range header */
+  /* for anything other than a get */
+  if (range->len > 0) {
+    snprintf (tbuff, sizeof (tbuff), "Range: bytes=%" PRId64 "-%" PRId64,
+        range->offset, range->offset + range->len - 1);
+  } else {
+    snprintf (tbuff, sizeof (tbuff), "Range: bytes=%" PRId64 "-",
+        range->offset);
+  }
+  list = curl_slist_append (list, tbuff);
+  if (range->validate && *range->etag) {
+    snprintf (tbuff, sizeof (tbuff), "If-None-Match: %s", range->etag);
+    list = curl_slist_append (list, tbuff);
+  }
+  if (range->validate && *range->lastmod) {
+    snprintf (tbuff, sizeof (tbuff), "If-Modified-Since: %s", range->lastmod);
+    list = curl_slist_append (list, tbuff);
+  }
+  /* the validators are replaced by the values in the response */
+  range->etag [0] = '\0';
+  range->lastmod [0] = '\0';
+
+  webclient->dlSize = 0;
+  webclient->dlChunks = 0;
+  webclient->dlFH = fh;
+  webclient->range = range;
+  webclient->rangecode = 0;
+  curl_easy_setopt (webclient->curl, CURLOPT_URL, uri);
+  if (query != NULL) {
+    curl_easy_setopt (webclient->curl, CURLOPT_POST, 1L);
+    curl_easy_setopt (webclient->curl, CURLOPT_POSTFIELDS, query);
+  } else {
+    curl_easy_setopt (webclient->curl, CURLOPT_HTTPGET, 1L);
+  }
+  curl_easy_setopt (webclient->curl, CURLOPT_HTTPHEADER, list);
+  curl_easy_setopt (webclient->curl, CURLOPT_HEADERFUNCTION, webclientRangeHeaderCallback);
+  curl_easy_setopt (webclient->curl, CURLOPT_HEADERDATA, webclient);
+  curl_easy_setopt (webclient->curl, CURLOPT_WRITEFUNCTION, webclientDownloadCallback);
+  curl_easy_setopt (webclient->curl, CURLOPT_ERRORBUFFER, webclient->errstr);
+  res = curl_easy_perform (webclient->curl);
+  if (res != CURLE_OK) {
+    logMsg (LOG_DBG, LOG_IMPORTANT, "ERR: download-range: %s uri: %s", webclient->errstr, uri);
+  }
+
+  curl_easy_getinfo (webclient->curl, CURLINFO_RESPONSE_CODE, &respcode);
+  if (res != CURLE_OK && respcode == WEB_PARTIAL_CONTENT) {
+    /* the data received so far is kept, but the caller must */
+    /* know that the range is not complete */
+    respcode = WEB_BAD_REQUEST;
+  }
+  mdextfclose (fh);
+  fclose (fh);
+  range->received = webclient->dlSize;
+  webclient->dlFH = NULL;
+  webclient->range = NULL;
+
+  curl_easy_setopt (webclient->curl, CURLOPT_HTTPHEADER, NULL);
+  curl_easy_setopt (webclient->curl, CURLOPT_HEADERFUNCTION, NULL);
+  curl_easy_setopt (webclient->curl, CURLOPT_HEADERDATA, NULL);
+  curl_easy_setopt (webclient->curl, CURLOPT_WRITEFUNCTION, webclientCallback);
+  curl_slist_free_all (list);
+
+  return (int) respcode;
+}
+
 /* can be used without passing a file, set fn to null */
 int
 webclientUploadFile (webclient_t *webclient, const char *uri,
@@ -368,7 +575,7 @@ webclientClose (webclient_t *webclient)
     curl_easy_cleanup (webclient->curl);
   }
   webclient->curl = NULL;
-  --initialized;
+  atomic_fetch_sub (&initialized, 1);
   mdfree (webclient);
 }
 
@@ -493,6 +700,133 @@ webclientSetUserPass (webclient_t *webclient, const char *user,
   curl_easy_setopt (webclient->curl, CURLOPT_PASSWORD, pass);
 }
 
+webclientmulti_t *
+webclientMultiAlloc (void)
+{
+  webclientmulti_t  *wm;
+
+  if (atomic_fetch_add (&initialized, 1) == 0) {
+    curl_global_init (CURL_GLOBAL_ALL);
+    atexit (webclientCleanup);
+  }
+
+  wm = mdmalloc (sizeof (webclientmulti_t));
+  wm->multi = curl_multi_init ();
+  mdextalloc (wm->multi);
+  curl_multi_setopt (wm->multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+      (long) WEB_MULTI_HOST_CONN);
+  wm->reqs = NULL;
+  wm->reqalloc = 0;
+  wm->poolcount = 0;
+  wm->active = 0;
+  wm->nextid = 1;
+  return wm;
+}
+
+/* any active requests are cancelled */
+void
+webclientMultiFree (webclientmulti_t *wm)
+{
+  if (wm == NULL) {
+    return;
+  }
+
+  for (int i = 0; i < wm->reqalloc; ++i) {
+    if (wm->reqs [i] != NULL) {
+      webclientMultiRemove (wm, i);
+    }
+  }
+  for (int i = 0; i < wm->poolcount; ++i) {
+    webclientClose (wm->pool [i]);
+  }
+  dataFree (wm->reqs);
+  if (wm->multi != NULL) {
+    mdextfree (wm->multi);
+    curl_multi_cleanup (wm->multi);
+  }
+  atomic_fetch_sub (&initialized, 1);
+  mdfree (wm);
+}
+
+/* returns the request id, or -1 on failure */
+int
+webclientMultiGet (webclientmulti_t *wm, const char *uri, long timeout,
+    webclientasynccb_t cb, void *userdata)
+{
+  return webclientMultiRequest (wm, uri, NULL, timeout, cb, userdata);
+}
+
+/* the query is copied */
+int
+webclientMultiPost (webclientmulti_t *wm, const char *uri, const char *query,
+    long timeout, webclientasynccb_t cb, void *userdata)
+{
+  if (query == NULL) {
+    query = "";
+  }
+  return webclientMultiRequest (wm, uri, query, timeout, cb, userdata);
+}
+
+/* the callback is not called for a cancelled request */
+bool
+webclientMultiCancel (webclientmulti_t *wm, int reqid)
+{
+  if (wm == NULL || reqid < 0) {
+    return false;
+  }
+
+  for (int i = 0; i < wm->reqalloc; ++i) {
+    if (wm->reqs [i] != NULL && wm->reqs [i]->reqid == reqid) {
+      logMsg (LOG_DBG, LOG_WEBCLIENT, "multi: cancel %d", reqid);
+      webclientMultiRemove (wm, i);
+      return true;
+    }
+  }
+  return false;
+}
+
+/* does not block.  the callbacks for any finished requests are called. */
+/* returns the number of active requests */
+int
+webclientMultiProcess (webclientmulti_t *wm)
+{
+  CURLMsg   *msg;
+  int       running;
+  int       count;
+
+  if (wm == NULL) {
+    return 0;
+  }
+  if (wm->active == 0) {
+    return 0;
+  }
+
+  curl_multi_perform (wm->multi, &running);
+  while ((msg = curl_multi_info_read (wm->multi, &count)) != NULL) {
+    if (msg->msg == CURLMSG_DONE) {
+      /* the message is not valid after the handle is removed */
+      webclientMultiDone (wm, msg->easy_handle, msg->data.result);
+    }
+  }
+
+  return wm->active;
+}
+
+/* waits up to timeout milliseconds for activity on the active requests */
+/* for use by processes and threads that have nothing else to do */
+int
+webclientMultiWait (webclientmulti_t *wm, int timeout)
+{
+  if (wm == NULL) {
+    return 0;
+  }
+
+  if (wm->active > 0) {
+    curl_multi_poll (wm->multi, NULL, 0, timeout, NULL);
+  }
+  return webclientMultiProcess (wm);
+}
+
 /* internal routines */
 
 static void
@@ -562,6 +896,90 @@ webclientDownloadCallback (char *ptr, size_t size, size_t nmemb, void *userdata)
   return w;
 }
 
+static size_t
+webclientStreamCallback (char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+  webclient_t   *webclient = userdata;
+  size_t        nsz = size * nmemb;
+
+  if (webclient->streamcb == NULL) {
+    return nsz;
+  }
+  /* the body of an error response is not passed on */
+  if (webclient->rangecode != WEB_OK) {
+    return nsz;
+  }
+  if (! webclient->streamcb (webclient->streamudata, ptr, nsz)) {
+    webclient->streamstop = true;
+    /* returning a short count stops the transfer */
+    return 0;
+  }
+  return nsz;
+}
+
+/* the header lines are not null terminated */
+static size_t
+webclientRangeHeaderCallback (char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+  webclient_t   *webclient = userdata;
+  webrange_t    *range = webclient->range;
+  size_t        nsz = size * nmemb;
+  char          tbuff [200];
+  char          *p;
+  size_t        len;
+
+  if (range == NULL) {
+    return nsz;
+  }
+
+  len = nsz;
+  if (len >= sizeof (tbuff)) {
+    len = sizeof (tbuff) - 1;
+  }
+  memcpy (tbuff, ptr, len);
+  tbuff [len] = '\0';
+  stringTrim (tbuff);
+
+  if (strncmp (tbuff, "HTTP/", 5) == 0) {
+    p = strchr (tbuff, ' ');
+    if (p != NULL) {
+      webclient->rangecode = atoi (p + 1);
+    }
+    /* a redirect may have sent validators for a different resource */
+    range->etag [0] = '\0';
+    range->lastmod [0] = '\0';
+    if (webclient->rangecode == WEB_OK && range->offset != 0) {
+      /* the server ignored the range, and is sending the entire file */
+      range->offset = 0;
+      fileopSeek (webclient->dlFH, 0, SEEK_SET);
+    }
+  } else if (strncasecmp (tbuff, "Content-Range:", 14) == 0) {
+    /* Content-Range: bytes 0-99/1234 */
+    p = strchr (tbuff, '/');
+    if (p != NULL && p [1] != '*') {
+      range->total = atoll (p + 1);
+    }
+  } else if (strncasecmp (tbuff, "Content-Length:", 15) == 0) {
+    if (webclient->rangecode == WEB_OK) {
+      range->total = atoll (tbuff + 15);
+    }
+  } else if (strncasecmp (tbuff, "ETag:", 5) == 0) {
+    p = tbuff + 5;
+    while (*p == ' ') {
+      ++p;
+    }
+    stpecpy (range->etag, range->etag + sizeof (range->etag), p);
+  } else if (strncasecmp (tbuff, "Last-Modified:", 14) == 0) {
+    p = tbuff + 14;
+    while (*p == ' ') {
+      ++p;
+    }
+    stpecpy (range->lastmod, range->lastmod + sizeof (range->lastmod), p);
+  }
+
+  return nsz;
+}
+
 static int
 webclientDebugCallback (CURL *curl, curl_infotype type, char *data,
     size_t size, void *userptr)
@@ -679,6 +1097,153 @@ webclientGzipEnd (z_stream *zs)
   return olen;
 }
 
+static int
+webclientMultiRequest (webclientmulti_t *wm, const char *uri,
+    const char *query, long timeout, webclientasynccb_t cb, void *userdata)
+{
+  webclientreq_t  *req;
+  webclient_t     *webclient;
+  CURL            *curl;
+  int             idx = -1;
+
+  if (wm == NULL || uri == NULL) {
+    return -1;
+  }
+
+  if (wm->poolcount > 0) {
+    wm->poolcount -= 1;
+    webclient = wm->pool [wm->poolcount];
+  } else {
+    webclient = webclientAlloc (NULL, NULL);
+  }
+
+  req = mdmalloc (sizeof (webclientreq_t));
+  req->webclient = webclient;
+  req->cb = cb;
+  req->userdata = userdata;
+  req->reqid = wm->nextid;
+
+  curl = webclient->curl;
+  webclientInitResp (webclient);
+  *webclient->errstr = '\0';
+  curl_easy_setopt (curl, CURLOPT_URL, uri);
+  if (query != NULL) {
+    curl_easy_setopt (curl, CURLOPT_POST, 1L);
+    curl_easy_setopt (curl, CURLOPT_COPYPOSTFIELDS, query);
+  } else {
+    curl_easy_setopt (curl, CURLOPT_HTTPGET, 1L);
+  }
+  curl_easy_setopt (curl, CURLOPT_FILETIME, 1L);
+  curl_easy_setopt (curl, CURLOPT_TIMEOUT_MS, timeout);
+  curl_easy_setopt (curl, CURLOPT_ERRORBUFFER, webclient->errstr);
+  curl_easy_setopt (curl, CURLOPT_PRIVATE, req);
+
+  if (curl_multi_add_handle (wm->multi, curl) != CURLM_OK) {
+    logMsg (LOG_DBG, LOG_IMPORTANT, "ERR: multi: unable to add uri: %s", uri);
+    webclientClose (webclient);
+    mdfree (req);
+    return -1;
+  }
+
+  for (int i = 0; i < wm->reqalloc; ++i) {
+    if (wm->reqs [i] == NULL) {
+      idx = i;
+      break;
+    }
+  }
+  if (idx < 0) {
+    idx = wm->reqalloc;
+    wm->reqalloc += WEB_MULTI_REQ_INCR;
+    wm->reqs = mdrealloc (wm->reqs, sizeof (webclientreq_t *) * wm->reqalloc);
+    for (int i = idx; i < wm->reqalloc; ++i) {
+      wm->reqs [i] = NULL;
+    }
+  }
+  wm->reqs [idx] = req;
+  wm->active += 1;
+  wm->nextid += 1;
+
+  logMsg (LOG_DBG, LOG_WEBCLIENT, "multi: start %d %s", req->reqid, uri);
+  return req->reqid;
+}
+
+static void
+webclientMultiDone (webclientmulti_t *wm, CURL *curl, CURLcode res)
+{
+  webclientreq_t  *req = NULL;
+  webclient_t     *webclient;
+  long            respcode = 0;
+  curl_off_t      tm = 0;
+  int             idx = -1;
+
+  curl_easy_getinfo (curl, CURLINFO_PRIVATE, (char **) &req);
+  for (int i = 0; i < wm->reqalloc; ++i) {
+    if (wm->reqs [i] != NULL && wm->reqs [i] == req) {
+      idx = i;
+      break;
+    }
+  }
+  if (idx < 0) {
+    return;
+  }
+
+  webclient = req->webclient;
+  curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &respcode);
+  curl_easy_getinfo (curl, CURLINFO_FILETIME_T, &tm);
+  if (res != CURLE_OK) {
+    if (*webclient->errstr == '\0') {
+      stpecpy (webclient->errstr, webclient->errstr + sizeof (webclient->errstr),
+          curl_easy_strerror (res));
+    }
+    logMsg (LOG_DBG, LOG_IMPORTANT, "ERR: multi: %d %s", req->reqid, webclient->errstr);
+    if (webclient->resp != NULL) {
+      snprintf (webclient->resp, webclient->respAllocated, "%s", webclient->errstr);
+      webclient->respSize = strlen (webclient->resp);
+    }
+    /* the transfer did not complete */
+    respcode = 0;
+  }
+  logMsg (LOG_DBG, LOG_WEBCLIENT, "multi: done %d %ld", req->reqid, respcode);
+
+  /* the request is removed before the callback is called, */
+  /* the callback may start another request */
+  curl_multi_remove_handle (wm->multi, curl);
+  wm->reqs [idx] = NULL;
+  wm->active -= 1;
+
+  if (req->cb != NULL) {
+    req->cb (req->userdata, (int) respcode, webclient->resp,
+        webclient->respSize, tm);
+  }
+
+  webclientMultiRelease (wm, webclient);
+  mdfree (req);
+}
+
+static void
+webclientMultiRemove (webclientmulti_t *wm, int idx)
+{
+  webclientreq_t  *req;
+
+  req = wm->reqs [idx];
+  curl_multi_remove_handle (wm->multi, req->webclient->curl);
+  wm->reqs [idx] = NULL;
+  wm->active -= 1;
+  webclientMultiRelease (wm, req->webclient);
+  mdfree (req);
+}
+
+static void
+webclientMultiRelease (webclientmulti_t *wm, webclient_t *webclient)
+{
+  if (wm->poolcount < WEB_MULTI_POOL_SZ) {
+    wm->pool [wm->poolcount] = webclient;
+    wm->poolcount += 1;
+  } else {
+    webclientClose (webclient);
+  }
+}
+
 static void
 webclientCleanup (void)
 {
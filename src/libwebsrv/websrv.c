@@ -16,12 +16,26 @@
 
 #include <unistd.h>
 
+#include <zlib.h>
+
 #include "mongoose.h"
 
+#include "bdjstring.h"
 #include "log.h"
 #include "mdebug.h"
+#include "tmutil.h"
 #include "websrv.h"
 
+enum {
+  /* the connection mark stored in the mongoose connection data */
+  WEBSRV_STREAM_MARK = 'S',
+  /* a stream client that has this much unsent data is dropped */
+  WEBSRV_STREAM_MAX_PENDING = 65536,
+  WEBSRV_STREAM_KEEPALIVE = 15000,
+  /* small payloads are not worth compressing */
+  WEBSRV_GZIP_MIN = 256,
+};
+
 typedef struct websrvint websrvint_t;
 
 typedef struct websrv {
@@ -32,10 +46,23 @@ typedef struct websrv {
   struct mg_http_message  *httpmsg;   // temporary
   struct mg_str           cdata;
   struct mg_str           kdata;
+  mstime_t                keepaliveTimer;
+  int                     streamcount;
   bool                    tlsflag;
 } websrv_t;
 
+typedef struct websrvpayload {
+  char      *data;
+  size_t    len;
+  char      *gzdata;
+  size_t    gzlen;
+  char      etag [24];
+} websrvpayload_t;
+
 static void websrvEventHandler (struct mg_connection *c, int ev, void *ev_data);
+static void websrvStreamBroadcast (websrv_t *websrv, const char *buff, size_t len);
+static bool websrvHeaderHas (websrv_t *websrv, const char *name, const char *val);
+static void websrvPayloadCompress (websrvpayload_t *wp);
 static void websrvLog (char c, void *userdata);
 
 websrv_t *
@@ -62,6 +89,8 @@ websrvInit (uint16_t listenPort, websrv_handler_t eventHandler,
   websrv->cdata.len = 0;
   websrv->kdata.buf = NULL;
   websrv->kdata.len = 0;
+  websrv->streamcount = 0;
+  mstimeset (&websrv->keepaliveTimer, WEBSRV_STREAM_KEEPALIVE);
 
   if (tlsflag == WEBSRV_TLS_OFF) {
     snprintf (tbuff, sizeof (tbuff), "http://0.0.0.0:%" PRIu16, listenPort);
@@ -102,6 +131,14 @@ websrvProcess (websrv_t *websrv)
   }
 
   mg_mgr_poll (&websrv->mgr, 10);
+
+  if (websrv->streamcount > 0 && mstimeCheck (&websrv->keepaliveTimer)) {
+    const char  *ka = ": keepalive\n\n";
+
+    /* a comment line keeps idle proxies from closing the stream */
+    websrvStreamBroadcast (websrv, ka, strlen (ka));
+    mstimeset (&websrv->keepaliveTimer, WEBSRV_STREAM_KEEPALIVE);
+  }
 }
 
 void
@@ -122,6 +159,8 @@ websrvServeFile (websrv_t *websrv, const char *dir, const char *path)
 
   memset (&opts, '\0', sizeof (struct mg_http_serve_opts));
   opts.root_dir = dir;
+  /* mongoose handles range requests, let the client know */
+  opts.extra_headers = "Accept-Ranges: bytes\r\n";
 
   turi = mg_str (path);
   origuri = websrv->httpmsg->uri;
@@ -143,8 +182,311 @@ websrvGetUserPass (websrv_t *websrv, char *user, size_t usersz, char *pass, size
   mg_http_creds (websrv->httpmsg, user, usersz, pass, passsz);
 }
 
+/* the query passed to the handler is limited in size. */
+/* returns the entire url-decoded request body, which must be freed */
+/* by the caller */
+char *
+websrvGetBody (websrv_t *websrv)
+{
+  struct mg_http_message  *hm;
+  char                    *body;
+
+  if (websrv == NULL || websrv->httpmsg == NULL) {
+    return NULL;
+  }
+
+  hm = websrv->httpmsg;
+  body = mdmalloc (hm->body.len + 1);
+  if (mg_url_decode (hm->body.buf, hm->body.len, body, hm->body.len + 1, 1) < 0) {
+    *body = '\0';
+  }
+  return body;
+}
+
+/* starts a chunked response, for replies that are built piece by piece */
+/* and whose size is not known in advance. */
+/* the response must be finished with websrvChunkEnd() */
+void
+websrvChunkStart (websrv_t *websrv, const char *headers)
+{
+  if (websrv == NULL || websrv->conn == NULL) {
+    return;
+  }
+  if (headers == NULL) {
+    headers = "";
+  }
+
+  mg_printf (websrv->conn,
+      "HTTP/1.1 %d %s\r\n"
+      "%s"
+      "Transfer-Encoding: chunked\r\n"
+      "\r\n",
+      WEB_OK, WEB_RESP_OK, headers);
+}
+
+void
+websrvChunkSend (websrv_t *websrv, const char *data, size_t len)
+{
+  if (websrv == NULL || websrv->conn == NULL || len == 0) {
+    return;
+  }
+
+  mg_http_write_chunk (websrv->conn, data, len);
+}
+
+void
+websrvChunkEnd (websrv_t *websrv)
+{
+  if (websrv == NULL || websrv->conn == NULL) {
+    return;
+  }
+
+  /* a zero length chunk ends the response */
+  mg_http_write_chunk (websrv->conn, "", 0);
+  websrv->conn->is_resp = 0;
+}
+
+/* converts the current request into a server-sent events stream. */
+/* the connection stays open, and receives all further data */
+/* sent with websrvStreamSend(). */
+void
+websrvStreamStart (websrv_t *websrv, const char *data)
+{
+  struct mg_connection  *c;
+
+  c = websrv->conn;
+  if (c == NULL) {
+    return;
+  }
+
+  mg_printf (c, "%s",
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/event-stream\r\n"
+      "Cache-Control: no-cache\r\n"
+      "\r\n"
+      "retry: 2000\n\n");
+  c->data [0] = WEBSRV_STREAM_MARK;
+  ++websrv->streamcount;
+  logMsg (LOG_DBG, LOG_WEBSRV, "stream: start %lu count:%d",
+      c->id, websrv->streamcount);
+
+  if (data != NULL && *data) {
+    mg_printf (c, "data: %s\n\n", data);
+  }
+}
+
+/* the data is encoded once, and the same event is queued */
+/* on every stream connection */
+void
+websrvStreamSend (websrv_t *websrv, const char *data)
+{
+  char        *buff;
+  char        *bp;
+  const char  *dp;
+  size_t      len;
+  size_t      nlcount;
+
+  if (websrv == NULL || data == NULL || websrv->streamcount == 0) {
+    return;
+  }
+
+  /* each line of the data must have its own data: prefix */
+  nlcount = 1;
+  for (dp = data; *dp; ++dp) {
+    if (*dp == '\n') {
+      ++nlcount;
+    }
+  }
+  len = strlen (data) + nlcount * 7 + 2;
+  buff = mdmalloc (len);
+
+  bp = buff;
+  dp = data;
+  while (true) {
+    const char  *ep;
+    size_t      llen;
+
+    ep = strchr (dp, '\n');
+    llen = ep == NULL ? strlen (dp) : (size_t) (ep - dp);
+    memcpy (bp, "data: ", 6);
+    bp += 6;
+    memcpy (bp, dp, llen);
+    bp += llen;
+    *bp++ = '\n';
+    if (ep == NULL) {
+      break;
+    }
+    dp = ep + 1;
+  }
+  *bp++ = '\n';
+
+  websrvStreamBroadcast (websrv, buff, (size_t) (bp - buff));
+  mdfree (buff);
+  mstimeset (&websrv->keepaliveTimer, WEBSRV_STREAM_KEEPALIVE);
+}
+
+int
+websrvStreamCount (websrv_t *websrv)
+{
+  if (websrv == NULL) {
+    return 0;
+  }
+
+  return websrv->streamcount;
+}
+
+/* a payload holds a response that is sent many times. */
+/* the etag and the compressed data are only built when the data changes. */
+websrvpayload_t *
+websrvPayloadAlloc (void)
+{
+  websrvpayload_t   *wp;
+
+  wp = mdmalloc (sizeof (websrvpayload_t));
+  wp->data = NULL;
+  wp->len = 0;
+  wp->gzdata = NULL;
+  wp->gzlen = 0;
+  *wp->etag = '\0';
+  return wp;
+}
+
+void
+websrvPayloadFree (websrvpayload_t *wp)
+{
+  if (wp == NULL) {
+    return;
+  }
+
+  dataFree (wp->data);
+  dataFree (wp->gzdata);
+  mdfree (wp);
+}
+
+void
+websrvPayloadSet (websrvpayload_t *wp, const char *data, size_t len)
+{
+  uint64_t    hash;
+
+  if (wp == NULL || data == NULL) {
+    return;
+  }
+
+  dataFree (wp->data);
+  dataFree (wp->gzdata);
+  wp->gzdata = NULL;
+  wp->gzlen = 0;
+
+  wp->data = mdmalloc (len + 1);
+  memcpy (wp->data, data, len);
+  wp->data [len] = '\0';
+  wp->len = len;
+
+  hash = stringHash64Data (STRING_HASH64_INIT, data, len);
+  snprintf (wp->etag, sizeof (wp->etag), "\"%016" PRIx64 "\"", hash);
+
+  websrvPayloadCompress (wp);
+}
+
+const char *
+websrvPayloadGetData (websrvpayload_t *wp)
+{
+  if (wp == NULL) {
+    return NULL;
+  }
+
+  return wp->data;
+}
+
+const char *
+websrvPayloadGetETag (websrvpayload_t *wp)
+{
+  if (wp == NULL) {
+    return NULL;
+  }
+
+  return wp->etag;
+}
+
+/* replies with not-modified if the client already has this payload, */
+/* otherwise sends the compressed data if the client accepts it */
+void
+websrvReplyPayload (websrv_t *websrv, const char *headers, websrvpayload_t *wp)
+{
+  struct mg_connection  *c;
+  const char            *data;
+  size_t                len;
+  const char            *enc = "";
+
+  c = websrv->conn;
+  if (c == NULL || websrv->httpmsg == NULL) {
+    return;
+  }
+  if (headers == NULL) {
+    headers = "";
+  }
+
+  if (wp == NULL || wp->data == NULL) {
+    mg_http_reply (c, WEB_NO_CONTENT, headers, "");
+    return;
+  }
+
+  if (websrvHeaderHas (websrv, "If-None-Match", wp->etag)) {
+    mg_printf (c,
+        "HTTP/1.1 %d %s\r\n"
+        "%s"
+        "ETag: %s\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n",
+        WEB_NOT_MODIFIED, WEB_RESP_NOT_MOD,
+        headers, wp->etag);
+    c->is_resp = 0;
+    return;
+  }
+
+  data = wp->data;
+  len = wp->len;
+  if (wp->gzdata != NULL && websrvHeaderHas (websrv, "Accept-Encoding", "gzip")) {
+    data = wp->gzdata;
+    len = wp->gzlen;
+    enc = "Content-Encoding: gzip\r\n";
+  }
+
+  mg_printf (c,
+      "HTTP/1.1 %d %s\r\n"
+      "%s"
+      "ETag: %s\r\n"
+      "Vary: Accept-Encoding\r\n"
+      "%s"
+      "Content-Length: %lu\r\n"
+      "\r\n",
+      WEB_OK, WEB_RESP_OK,
+      headers, wp->etag, enc, (unsigned long) len);
+  mg_send (c, data, len);
+  c->is_resp = 0;
+}
+
 /* internal routines */
 
+static void
+websrvStreamBroadcast (websrv_t *websrv, const char *buff, size_t len)
+{
+  struct mg_connection  *c;
+
+  for (c = websrv->mgr.conns; c != NULL; c = c->next) {
+    if (c->data [0] != WEBSRV_STREAM_MARK || c->is_closing) {
+      continue;
+    }
+    if (c->send.len > WEBSRV_STREAM_MAX_PENDING) {
+      /* the client is not reading, do not let the data pile up */
+      logMsg (LOG_DBG, LOG_WEBSRV, "stream: drop slow client %lu", c->id);
+      c->is_closing = 1;
+      continue;
+    }
+    mg_send (c, buff, len);
+  }
+}
+
 static void
 websrvEventHandler (struct mg_connection *c, int ev, void *ev_data)
 {
@@ -161,6 +503,17 @@ websrvEventHandler (struct mg_connection *c, int ev, void *ev_data)
   websrv = c->fn_data;
   websrv->conn = c;
 
+  if (ev == MG_EV_CLOSE) {
+    if (c->data [0] == WEBSRV_STREAM_MARK) {
+      c->data [0] = '\0';
+      --websrv->streamcount;
+      logMsg (LOG_DBG, LOG_WEBSRV, "stream: end %lu count:%d",
+          c->id, websrv->streamcount);
+    }
+    websrv->conn = NULL;
+    return;
+  }
+
   if (websrv->tlsflag == WEBSRV_TLS_ON && ev == MG_EV_ACCEPT) {
     struct mg_tls_opts opts;
 
@@ -204,6 +557,65 @@ websrvEventHandler (struct mg_connection *c, int ev, void *ev_data)
   }
 }
 
+/* the header values used here are all simple tokens, */
+/* a substring match is sufficient */
+static bool
+websrvHeaderHas (websrv_t *websrv, const char *name, const char *val)
+{
+  struct mg_str   *hdr;
+  size_t          vlen;
+
+  hdr = mg_http_get_header (websrv->httpmsg, name);
+  if (hdr == NULL) {
+    return false;
+  }
+
+  vlen = strlen (val);
+  for (size_t i = 0; i + vlen <= hdr->len; ++i) {
+    if (strncmp (hdr->buf + i, val, vlen) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void
+websrvPayloadCompress (websrvpayload_t *wp)
+{
+  z_stream    zs;
+  size_t      sz;
+  int         rc;
+
+  if (wp->len < WEBSRV_GZIP_MIN) {
+    return;
+  }
+
+  memset (&zs, 0, sizeof (zs));
+  /* 15 + 16 : gzip format */
+  rc = deflateInit2 (&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16,
+      8, Z_DEFAULT_STRATEGY);
+  if (rc != Z_OK) {
+    return;
+  }
+
+  sz = deflateBound (&zs, wp->len);
+  wp->gzdata = mdmalloc (sz);
+  zs.next_in = (unsigned char *) wp->data;
+  zs.avail_in = wp->len;
+  zs.next_out = (unsigned char *) wp->gzdata;
+  zs.avail_out = sz;
+  rc = deflate (&zs, Z_FINISH);
+  wp->gzlen = sz - zs.avail_out;
+  deflateEnd (&zs);
+
+  if (rc != Z_STREAM_END || wp->gzlen >= wp->len) {
+    dataFree (wp->gzdata);
+    wp->gzdata = NULL;
+    wp->gzlen = 0;
+  }
+}
+
 static void
 websrvLog (char c, void *userdata)
 {
@@ -13,12 +13,18 @@
 #include <math.h>
 #include <time.h>
 
+#if __has_include (<pthread.h>)
+# include <pthread.h>
+#endif
+
 #include "bdj4.h"
 #include "bdj4init.h"
 #include "bdj4intl.h"
 #include "bdjmsg.h"
 #include "bdjopt.h"
+#include "bdjstring.h"
 #include "bdjvars.h"
+#include "bpmdetect.h"
 #include "callback.h"
 #include "conn.h"
 #include "dance.h"
@@ -40,6 +46,7 @@ enum {
   BPMCOUNT_CB_SAVE,
   BPMCOUNT_CB_RESET,
   BPMCOUNT_CB_CLICK,
+  BPMCOUNT_CB_DETECT,
   BPMCOUNT_CB_MAX,
 };
 
@@ -53,9 +60,11 @@ enum {
 
 enum {
   BPM_W_BUTTON_CLOSE,
+  BPM_W_BUTTON_DETECT,
   BPM_W_BUTTON_RESET,
   BPM_W_BUTTON_SAVE,
   BPM_W_BUTTON_BLUEBOX,
+  BPM_W_STATUS_MSG,
   BPM_W_WINDOW,
   BPM_W_MAX,
 };
@@ -74,6 +83,20 @@ typedef struct {
   int             count;
   time_t          begtime;
   int             timesig;
+  /* automatic detection */
+  int             bpmlow;
+  int             bpmhigh;
+  char            ffn [BDJ4_PATH_MAX];
+#if _lib_pthread_create
+  pthread_t       thread;
+#endif
+  /* the detection thread uses its own copy of the file name and range */
+  char            detectffn [BDJ4_PATH_MAX];
+  int             detectlow;
+  int             detecthigh;
+  bpmdetect_t     detect;
+  _Atomic(bool)   detectfinished;
+  bool            detectactive;
   /* options */
   datafile_t      *optiondf;
   nlist_t         *options;
@@ -110,6 +133,13 @@ static bool     bpmcounterProcessSave (void *udata);
 static bool     bpmcounterProcessReset (void *udata);
 static bool     bpmcounterProcessClick (void *udata);
 static void     bpmcounterProcessTimesig (bpmcounter_t *bpmcounter, char *args);
+static bool     bpmcounterProcessDetect (void *udata);
+static void     bpmcounterDetectCheck (bpmcounter_t *bpmcounter, bool wait);
+static void     bpmcounterDetectDisplay (bpmcounter_t *bpmcounter);
+static void     bpmcounterSetValues (bpmcounter_t *bpmcounter, int bpm);
+#if _lib_pthread_create
+static void     * bpmcounterDetectThread (void *arg);
+#endif
 
 static int gKillReceived = 0;
 
@@ -139,6 +169,13 @@ main (int argc, char *argv[])
   bpmcounter.count = 0;
   bpmcounter.begtime = 0;
   bpmcounter.timesig = DANCE_TIMESIG_44;
+  bpmcounter.bpmlow = BPMDETECT_BPM_LOW;
+  bpmcounter.bpmhigh = BPMDETECT_BPM_HIGH;
+  *bpmcounter.ffn = '\0';
+  bpmcounter.detect.bpm = 0;
+  bpmcounter.detect.confidence = 0;
+  bpmcounter.detectfinished = false;
+  bpmcounter.detectactive = false;
   for (int i = 0; i < BPMCOUNT_DISP_MAX; ++i) {
     bpmcounter.values [i] = 0;
     bpmcounter.dispvalue [i] = NULL;
@@ -288,6 +325,7 @@ bpmcounterClosingCallback (void *udata, programstate_t programState)
   bpmcounter_t   *bpmcounter = udata;
 
   logProcBegin ();
+  bpmcounterDetectCheck (bpmcounter, true);
   uiCloseWindow (bpmcounter->wcont [BPM_W_WINDOW]);
   uiCleanup ();
   for (int i = 0; i < BPM_W_MAX; ++i) {
@@ -427,6 +465,10 @@ bpmcounterBuildUI (bpmcounter_t  *bpmcounter)
   hbox = uiCreateHorizBox ();
   uiBoxPackStart (vboxmain, hbox);
 
+  uiwidgetp = uiCreateLabel ("");
+  uiBoxPackStart (hbox, uiwidgetp);
+  bpmcounter->wcont [BPM_W_STATUS_MSG] = uiwidgetp;
+
   bpmcounter->callbacks [BPMCOUNT_CB_SAVE] = callbackInit (
       bpmcounterProcessSave, bpmcounter, NULL);
   uiwidgetp = uiCreateButton ("bpmc-save",
@@ -455,6 +497,17 @@ bpmcounterBuildUI (bpmcounter_t  *bpmcounter)
   uiWidgetSetMarginTop (uiwidgetp, 2);
   bpmcounter->wcont [BPM_W_BUTTON_CLOSE] = uiwidgetp;
 
+  bpmcounter->callbacks [BPMCOUNT_CB_DETECT] = callbackInit (
+      bpmcounterProcessDetect, bpmcounter, NULL);
+  uiwidgetp = uiCreateButton ("bpmc-detect",
+      bpmcounter->callbacks [BPMCOUNT_CB_DETECT],
+      /* CONTEXT: bpm counter: detect button: automatically detect the bpm */
+      _("Detect"), NULL);
+  uiBoxPackEnd (hbox, uiwidgetp);
+  uiWidgetSetMarginTop (uiwidgetp, 2);
+  uiWidgetSetState (uiwidgetp, UIWIDGET_DISABLE);
+  bpmcounter->wcont [BPM_W_BUTTON_DETECT] = uiwidgetp;
+
   x = nlistGetNum (bpmcounter->options, BPMCOUNTER_POSITION_X);
   y = nlistGetNum (bpmcounter->options, BPMCOUNTER_POSITION_Y);
   uiWindowMove (bpmcounter->wcont [BPM_W_WINDOW], x, y, -1);
@@ -498,6 +551,8 @@ bpmcounterMainLoop (void *tbpmcounter)
 
   connProcessUnconnected (bpmcounter->conn);
 
+  bpmcounterDetectCheck (bpmcounter, false);
+
   if (gKillReceived) {
     logMsg (LOG_SESS, LOG_IMPORTANT, "got kill signal");
     progstateShutdownProcess (bpmcounter->progstate);
@@ -611,6 +666,7 @@ bpmcounterProcessReset (void *udata)
   }
   bpmcounter->count = 0;
   bpmcounter->begtime = 0;
+  uiLabelSetText (bpmcounter->wcont [BPM_W_STATUS_MSG], "");
 
   return UICB_CONT;
 }
@@ -650,15 +706,7 @@ bpmcounterProcessClick (void *udata)
     dval *= 1000.0;
     dval = round (dval * 60.0);
 
-    bpmcounter->values [BPMCOUNT_DISP_BPM] = (int) dval;
-    snprintf (tbuff, sizeof (tbuff), "%d", (int) dval);
-    uiLabelSetText (bpmcounter->dispvalue [BPMCOUNT_DISP_BPM], tbuff);
-
-    bpmcounter->values [BPMCOUNT_DISP_MPM] =
-        (int) (dval / (double) danceTimesigValues [bpmcounter->timesig]);
-    snprintf (tbuff, sizeof (tbuff), "%d",
-        bpmcounter->values [BPMCOUNT_DISP_MPM]);
-    uiLabelSetText (bpmcounter->dispvalue [BPMCOUNT_DISP_MPM], tbuff);
+    bpmcounterSetValues (bpmcounter, (int) dval);
   }
 
   /* these are always displayed */
@@ -674,14 +722,157 @@ static void
 bpmcounterProcessTimesig (bpmcounter_t *bpmcounter, char *args)
 {
   int     timesig = DANCE_TIMESIG_44;
+  char    *p;
+  char    *tokstr = NULL;
 
+  p = NULL;
   if (args != NULL && *args) {
-    timesig = atoi (args);
+    p = strtok_r (args, MSG_ARGS_RS_STR, &tokstr);
+  }
+  if (p != NULL) {
+    timesig = atoi (p);
   }
   if (timesig < 0) {
     timesig = DANCE_TIMESIG_44;
   }
 
   bpmcounter->timesig = timesig;
+
+  bpmcounter->bpmlow = BPMDETECT_BPM_LOW;
+  bpmcounter->bpmhigh = BPMDETECT_BPM_HIGH;
+  *bpmcounter->ffn = '\0';
+
+  if (p != NULL) {
+    p = strtok_r (NULL, MSG_ARGS_RS_STR, &tokstr);
+  }
+  if (p != NULL) {
+    bpmcounter->bpmlow = atoi (p);
+    p = strtok_r (NULL, MSG_ARGS_RS_STR, &tokstr);
+  }
+  if (p != NULL) {
+    bpmcounter->bpmhigh = atoi (p);
+    p = strtok_r (NULL, MSG_ARGS_RS_STR, &tokstr);
+  }
+  if (p != NULL) {
+    stpecpy (bpmcounter->ffn, bpmcounter->ffn + sizeof (bpmcounter->ffn), p);
+  }
+
+  if (*bpmcounter->ffn && ! bpmcounter->detectactive) {
+    uiWidgetSetState (bpmcounter->wcont [BPM_W_BUTTON_DETECT], UIWIDGET_ENABLE);
+  } else {
+    uiWidgetSetState (bpmcounter->wcont [BPM_W_BUTTON_DETECT], UIWIDGET_DISABLE);
+  }
+}
+
+static bool
+bpmcounterProcessDetect (void *udata)
+{
+  bpmcounter_t  *bpmcounter = udata;
+
+  if (bpmcounter->detectactive || ! *bpmcounter->ffn) {
+    return UICB_CONT;
+  }
+
+  bpmcounterProcessReset (bpmcounter);
+  uiWidgetSetState (bpmcounter->wcont [BPM_W_BUTTON_DETECT], UIWIDGET_DISABLE);
+  uiLabelSetText (bpmcounter->wcont [BPM_W_STATUS_MSG],
+      /* CONTEXT: bpm counter: status message: the bpm is being detected */
+      _("Detecting..."));
+  uiUIProcessEvents ();
+
+  bpmcounter->detectactive = true;
+  bpmcounter->detectfinished = false;
+  bpmcounter->detect.bpm = 0;
+  bpmcounter->detect.confidence = 0;
+  stpecpy (bpmcounter->detectffn,
+      bpmcounter->detectffn + sizeof (bpmcounter->detectffn), bpmcounter->ffn);
+  bpmcounter->detectlow = bpmcounter->bpmlow;
+  bpmcounter->detecthigh = bpmcounter->bpmhigh;
+
+#if _lib_pthread_create
+  pthread_create (&bpmcounter->thread, NULL, bpmcounterDetectThread, bpmcounter);
+#else
+  bpmdetectFile (bpmcounter->detectffn, bpmcounter->detectlow,
+      bpmcounter->detecthigh, &bpmcounter->detect);
+  bpmcounter->detectfinished = true;
+  bpmcounterDetectCheck (bpmcounter, false);
+#endif
+
+  return UICB_CONT;
 }
 
+static void
+bpmcounterDetectCheck (bpmcounter_t *bpmcounter, bool wait)
+{
+  if (! bpmcounter->detectactive) {
+    return;
+  }
+  if (! wait && ! bpmcounter->detectfinished) {
+    return;
+  }
+
+#if _lib_pthread_create
+  pthread_join (bpmcounter->thread, NULL);
+#endif
+  bpmcounter->detectactive = false;
+
+  if (! wait) {
+    bpmcounterDetectDisplay (bpmcounter);
+  }
+}
+
+static void
+bpmcounterDetectDisplay (bpmcounter_t *bpmcounter)
+{
+  char    tbuff [100];
+
+  if (*bpmcounter->ffn) {
+    uiWidgetSetState (bpmcounter->wcont [BPM_W_BUTTON_DETECT], UIWIDGET_ENABLE);
+  }
+
+  if (bpmcounter->detect.bpm <= 0) {
+    uiLabelSetText (bpmcounter->wcont [BPM_W_STATUS_MSG],
+        /* CONTEXT: bpm counter: status message: the bpm could not be detected */
+        _("Unable to detect the BPM."));
+    return;
+  }
+
+  bpmcounterSetValues (bpmcounter, bpmcounter->detect.bpm);
+
+  snprintf (tbuff, sizeof (tbuff), "%s%s%d%%",
+      /* CONTEXT: bpm counter: status message: how reliable the detected bpm is */
+      _("Confidence"), _(": "), bpmcounter->detect.confidence);
+  uiLabelSetText (bpmcounter->wcont [BPM_W_STATUS_MSG], tbuff);
+}
+
+static void
+bpmcounterSetValues (bpmcounter_t *bpmcounter, int bpm)
+{
+  char    tbuff [40];
+
+  bpmcounter->values [BPMCOUNT_DISP_BPM] = bpm;
+  snprintf (tbuff, sizeof (tbuff), "%d", bpm);
+  uiLabelSetText (bpmcounter->dispvalue [BPMCOUNT_DISP_BPM], tbuff);
+
+  bpmcounter->values [BPMCOUNT_DISP_MPM] =
+      (int) ((double) bpm / (double) danceTimesigValues [bpmcounter->timesig]);
+  snprintf (tbuff, sizeof (tbuff), "%d",
+      bpmcounter->values [BPMCOUNT_DISP_MPM]);
+  uiLabelSetText (bpmcounter->dispvalue [BPMCOUNT_DISP_MPM], tbuff);
+}
+
+#if _lib_pthread_create
+
+static void *
+bpmcounterDetectThread (void *arg)
+{
+  bpmcounter_t  *bpmcounter = arg;
+
+  bpmdetectFile (bpmcounter->detectffn, bpmcounter->detectlow,
+      bpmcounter->detecthigh, &bpmcounter->detect);
+  bpmcounter->detectfinished = true;
+  pthread_exit (NULL);
+  return NULL;
+}
+
+#endif
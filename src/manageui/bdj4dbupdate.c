@@ -9,6 +9,8 @@
  *      rebuild and replace the database in its entirety.
  *    - check for new
  *      check for new files and changes and add them.
+ *      a manifest of the directories and files is kept so that
+ *      unchanged directories and files can be skipped.
  *    - update from tags
  *      update db from tags in audio files.
  *      this is the same as checknew, except that all audio files tags
@@ -26,6 +28,17 @@
  *      use the organization settings to reorganize the files.
  *    - update from itunes
  *      update the database data from the data found in itunes.
+ *    - loudness
+ *      scan the audio files for the integrated loudness and true peak
+ *      and store the results and a suggested volume adjustment in
+ *      the database.  the scans are run in multiple threads.
+ *      files that have not changed since the last scan are skipped,
+ *      so a stopped scan may be restarted.
+ *    - bpm
+ *      detect the tempo of the audio files that do not have a bpm set.
+ *      the detection is limited to the dance's mpm range, and only
+ *      results with a reasonable confidence are stored.
+ *      the scans are run in multiple threads.
  *
  */
 
@@ -40,12 +53,18 @@
 #include <errno.h>
 #include <signal.h>
 
+#if __has_include (<pthread.h>)
+# include <pthread.h>
+#endif
+
+#include "audioadjust.h"
 #include "audiofile.h"
 #include "audiosrc.h"
 #include "audiotag.h"
 #include "bdj4.h"
 #include "bdj4init.h"
 #include "bdj4intl.h"
+#include "bpmdetect.h"
 #include "bdjmsg.h"
 #include "bdjopt.h"
 #include "bdjregex.h"
@@ -54,6 +73,8 @@
 #include "bdjvars.h"
 #include "conn.h"
 #include "dance.h"
+#include "dbmanifest.h"
+#include "dirlist.h"
 #include "fileop.h"
 #include "filemanip.h"
 #include "itunes.h"
@@ -114,6 +135,26 @@ typedef struct {
   char        *relfn;
 } tagdataitem_t;
 
+enum {
+  DBUPD_MAX_THREADS = 8,
+};
+
+typedef struct {
+#if _lib_pthread_create
+  pthread_t       thread;
+#endif
+  tagdataitem_t   *tdi;
+  aaloudness_t    loudness;
+  bpmdetect_t     bpm;
+  int             bpmlow;
+  int             bpmhigh;
+  int             rc;
+  int             bpmrc;
+  bool            doloudness;
+  bool            dobpm;
+  _Atomic(bool)   finished;
+} dbupdthread_t;
+
 typedef struct {
   progstate_t       *progstate;
   procutil_t        *processes [ROUTE_MAX];
@@ -131,7 +172,9 @@ typedef struct {
   mstime_t          outputTimer;
   org_t             *org;
   org_t             *orgold;
-  asiter_t          *asiter;
+  dirwalk_t         *dirwalk;
+  dbmanifest_t      *dbmanifest;
+  char              walkfn [BDJ4_PATH_MAX];
   slistidx_t        dbiter;
   bdjregex_t        *badfnregex;
   dbidx_t           counts [C_MAX];
@@ -140,9 +183,14 @@ typedef struct {
   const char        *olddirlist;
   itunes_t          *itunes;
   queue_t           *tagdataq;
+  dbupdthread_t     *threads [DBUPD_MAX_THREADS];
+  int               maxthreads;
+  int               activethreads;
   /* base database operations */
+  bool              bpm;
   bool              checknew;
   bool              compact;
+  bool              loudness;
   bool              rebuild;
   bool              reorganize;
   bool              updfromitunes;
@@ -151,12 +199,14 @@ typedef struct {
   /* database handling */
   bool              cleandatabase;
   /* other stuff */
+  bool              analyze;
   bool              autoorg;
   bool              cli;
   bool              dancefromgenre;
   bool              haveolddirlist;
   bool              iterfromaudiosrc;
   bool              iterfromdb;
+  bool              iterpending;
   bool              progress;
   bool              stoprequest;
   bool              usingmusicdir;
@@ -183,6 +233,17 @@ static void     dbupdateProcessFile (dbupdate_t *dbupdate, tagdataitem_t *tdi);
 static void     dbupdateWriteTags (dbupdate_t *dbupdate, tagdataitem_t *tdi, slist_t *tagdata);
 static void     dbupdateFromiTunes (dbupdate_t *dbupdate, tagdataitem_t *tdi);
 static void     dbupdateReorganize (dbupdate_t *dbupdate, tagdataitem_t *tdi, int songdbdefault);
+static bool     dbupdateAnalyzeSkip (dbupdate_t *dbupdate, song_t *song, const char *ffn);
+static bool     dbupdateLoudnessSkip (song_t *song, const char *ffn);
+static void     dbupdateLoudnessCheckKey (const char *ffn, char *buff, size_t sz);
+static bool     dbupdateBPMSkip (song_t *song);
+static void     dbupdateAnalyzeStart (dbupdate_t *dbupdate, tagdataitem_t *tdi);
+static void     dbupdateAnalyzeCheckThreads (dbupdate_t *dbupdate, bool wait);
+static void     dbupdateAnalyze (dbupdthread_t *dbthread);
+static void     dbupdateAnalyzeFinish (dbupdate_t *dbupdate, dbupdthread_t *dbthread);
+#if _lib_pthread_create
+static void     * dbupdateAnalyzeThread (void *arg);
+#endif
 static void     dbupdateSigHandler (int sig);
 static void     dbupdateOutputProgress (dbupdate_t *dbupdate);
 static bool     checkOldDirList (dbupdate_t *dbupdate, const char *fn);
@@ -209,7 +270,9 @@ main (int argc, char *argv[])
   dbupdate.state = DB_UPD_INIT;
   dbupdate.musicdb = NULL;
   dbupdate.newmusicdb = NULL;
-  dbupdate.asiter = NULL;
+  dbupdate.dirwalk = NULL;
+  dbupdate.dbmanifest = NULL;
+  dbupdate.walkfn [0] = '\0';
   dbupdate.dbiter = -1;
   for (int i = 0; i < C_MAX; ++i) {
     dbupdate.counts [i] = 0;
@@ -217,19 +280,28 @@ main (int argc, char *argv[])
   dbupdate.stopwaitcount = 0;
   dbupdate.itunes = NULL;
   dbupdate.tagdataq = queueAlloc ("tagdata-q", dbupdateTagDataFree);
+  for (int i = 0; i < DBUPD_MAX_THREADS; ++i) {
+    dbupdate.threads [i] = NULL;
+  }
+  dbupdate.maxthreads = 1;
+  dbupdate.activethreads = 0;
   dbupdate.org = NULL;
   dbupdate.orgold = NULL;
+  dbupdate.bpm = false;
   dbupdate.checknew = false;
   dbupdate.compact = false;
+  dbupdate.loudness = false;
   dbupdate.rebuild = false;
   dbupdate.reorganize = false;
   dbupdate.updfromitunes = false;
   dbupdate.updfromtags = false;
   dbupdate.writetags = false;
   dbupdate.cleandatabase = false;
+  dbupdate.analyze = false;
   dbupdate.cli = false;
   dbupdate.haveolddirlist = false;
   dbupdate.iterfromaudiosrc = false;
+  dbupdate.iterpending = false;
   dbupdate.iterfromdb = false;
   dbupdate.olddirlist = NULL;
   dbupdate.progress = false;
@@ -321,6 +393,30 @@ main (int argc, char *argv[])
     dbupdate.iterfromdb = true;
     logMsg (LOG_DBG, LOG_IMPORTANT, "== reorganize");
   }
+  if ((dbupdate.startflags & BDJ4_ARG_DB_LOUDNESS) == BDJ4_ARG_DB_LOUDNESS) {
+    dbupdate.loudness = true;
+    dbupdate.iterfromdb = true;
+    dbupdate.analyze = true;
+    logMsg (LOG_DBG, LOG_IMPORTANT, "== loudness");
+  }
+  if ((dbupdate.startflags & BDJ4_ARG_DB_BPM) == BDJ4_ARG_DB_BPM) {
+    dbupdate.bpm = true;
+    dbupdate.iterfromdb = true;
+    dbupdate.analyze = true;
+    logMsg (LOG_DBG, LOG_IMPORTANT, "== bpm");
+  }
+  if (dbupdate.analyze) {
+#if _lib_pthread_create
+    dbupdate.maxthreads = sysvarsGetNum (SVL_NUM_PROC);
+    if (dbupdate.maxthreads > DBUPD_MAX_THREADS) {
+      dbupdate.maxthreads = DBUPD_MAX_THREADS;
+    }
+    if (dbupdate.maxthreads < 1) {
+      dbupdate.maxthreads = 1;
+    }
+#endif
+    logMsg (LOG_DBG, LOG_IMPORTANT, "== analyze (threads: %d)", dbupdate.maxthreads);
+  }
   if ((dbupdate.startflags & BDJ4_ARG_PROGRESS) == BDJ4_ARG_PROGRESS) {
     dbupdate.progress = true;
   }
@@ -452,6 +548,12 @@ dbupdateProcessing (void *udata)
 
     logMsg (LOG_DBG, LOG_BASIC, "existing db count: %" PRId32, dbCount (dbupdate->musicdb));
     dbStartBatch (dbupdate->musicdb);
+    /* the song lists are updated once, when the update is finished */
+    songdbStartBatch (dbupdate->songdb);
+    if (dbupdate->loudness && ! dbupdate->bpm) {
+      /* the loudness scan does not change any of the song's data */
+      dbDisableLastUpdateTime (dbupdate->musicdb);
+    }
 
     dbupdate->state = DB_UPD_PREP;
   }
@@ -484,17 +586,35 @@ dbupdateProcessing (void *udata)
     if (dbupdate->iterfromaudiosrc) {
       logMsg (LOG_DBG, LOG_BASIC, "processmusicdir %s", dbupdate->processmusicdir);
 
-      dbupdate->asiter = audiosrcStartIterator (AUDIOSRC_TYPE_FILE,
-          AS_ITER_DIR, dbupdate->processmusicdir, NULL, -1);
-
-      if (dbupdate->asiter != NULL) {
-        dbupdate->counts [C_FILE_COUNT] = audiosrcIterCount (dbupdate->asiter);
-        logMsg (LOG_DBG, LOG_IMPORTANT, "read directory %s: %" PRId64 " ms",
-            dbupdate->processmusicdir, (int64_t) mstimeend (&dbupdate->starttm));
-        logMsg (LOG_DBG, LOG_IMPORTANT, "  %" PRId32 " files found", dbupdate->counts [C_FILE_COUNT]);
+      /* the directory walk runs in the background, and the */
+      /* filenames are processed as they are found. */
+      /* the file count is updated as the walk progresses */
+      dbupdate->dirwalk = dirlistWalkStart (dbupdate->processmusicdir,
+          DIRLIST_FILES);
+
+      /* the manifest is only kept for the main music folder */
+      /* a rebuild does not use the existing manifest, but creates */
+      /* a new one */
+      if (dbupdate->usingmusicdir && ! dbupdate->iterfromdb) {
+        char    fn [BDJ4_PATH_MAX];
+
+        pathbldMakePath (fn, sizeof (fn),
+            DBMANIFEST_FNAME, BDJ4_CONFIG_EXT, PATHBLD_MP_DREL_DATA);
+        dbupdate->dbmanifest = dbmanifestAlloc (fn,
+            dbupdate->processmusicdir, dbupdate->checknew);
+        if (dbupdate->checknew &&
+            ! dbmanifestIsLoaded (dbupdate->dbmanifest)) {
+          logMsg (LOG_DBG, LOG_IMPORTANT, "no manifest, full scan");
+        }
       }
     }
 
+    if (dbupdate->reorganize) {
+      /* all of the new names are checked for collisions before */
+      /* any file is moved */
+      songdbPlanRenames (dbupdate->songdb);
+    }
+
     if (dbupdate->iterfromdb) {
       dbStartIterator (dbupdate->musicdb, &dbupdate->dbiter);
       dbupdate->counts [C_FILE_COUNT] = dbCount (dbupdate->musicdb);
@@ -503,11 +623,13 @@ dbupdateProcessing (void *udata)
       logMsg (LOG_DBG, LOG_IMPORTANT, "  %" PRId32 " files found", dbupdate->counts [C_FILE_COUNT]);
     }
 
-    /* message to manageui */
-    snprintf (tmp, sizeof (tmp), "%" PRId32, dbupdate->counts [C_FILE_COUNT]);
-    /* CONTEXT: database update: status message (count) */
-    snprintf (tbuff, sizeof (tbuff), _("%s files found"), tmp);
-    connSendMessage (dbupdate->conn, ROUTE_MANAGEUI, MSG_DB_STATUS_MSG, tbuff);
+    if (dbupdate->iterfromdb) {
+      /* message to manageui */
+      snprintf (tmp, sizeof (tmp), "%" PRId32, dbupdate->counts [C_FILE_COUNT]);
+      /* CONTEXT: database update: status message (count) */
+      snprintf (tbuff, sizeof (tbuff), _("%s files found"), tmp);
+      connSendMessage (dbupdate->conn, ROUTE_MANAGEUI, MSG_DB_STATUS_MSG, tbuff);
+    }
 
     dbupdate->state = DB_UPD_PROC_FN;
   }
@@ -525,6 +647,7 @@ dbupdateProcessing (void *udata)
       char        ffn [BDJ4_PATH_MAX];
       const char  *tsongfn;     // the db entry filename
       const char  *relfn;       // the relative path name
+      bool        changed = false;
 
       /* if the filename is from the audio-source iterator, */
       /*    it is a full path */
@@ -549,6 +672,25 @@ dbupdateProcessing (void *udata)
       // fprintf (stderr, " relfn-a: %s\n", relfn);     //
       // fprintf (stderr, "    type: %d\n", audiosrcGetType (fn));
 
+      if (dbupdate->dbmanifest != NULL) {
+        dbmanifestrc_t  mrc;
+
+        /* the manifest is only loaded for check-new, */
+        /* otherwise all files are new */
+        mrc = dbmanifestCheckFile (dbupdate->dbmanifest, fn);
+        /* a file that is not in the database must still be processed */
+        if (mrc == DBMANIFEST_UNCHANGED && song != NULL) {
+          dbupdateIncCount (dbupdate, C_IN_DB);
+          dbupdateIncCount (dbupdate, C_FILE_SKIPPED);
+          logMsg (LOG_DBG, LOG_DBUPDATE, "  unchanged");
+          continue;
+        }
+        if (mrc == DBMANIFEST_CHANGED) {
+          logMsg (LOG_DBG, LOG_DBUPDATE, "  changed");
+          changed = true;
+        }
+      }
+
       if (dbupdate->iterfromaudiosrc) {
         pi = pathInfo (fn);
         /* fast skip of some known file extensions that might show up */
@@ -622,9 +764,10 @@ dbupdateProcessing (void *udata)
           logMsg (LOG_DBG, LOG_DBUPDATE, "  in-database (%" PRId32 ") ", dbupdate->counts [C_IN_DB]);
 
           /* if doing a checknew, no need for further processing */
+          /* unless the audio file has changed */
           /* if doing a compact, the information must be written to */
           /* the new database. */
-          if (dbupdate->checknew || dbupdate->compact) {
+          if ((dbupdate->checknew && ! changed) || dbupdate->compact) {
             if (dbupdate->checknew && ! dbupdate->compact) {
               dbupdateIncCount (dbupdate, C_FILE_SKIPPED);
             }
@@ -649,6 +792,14 @@ dbupdateProcessing (void *udata)
         }
       }
 
+      if (dbupdate->analyze &&
+          dbupdateAnalyzeSkip (dbupdate, song, ffn)) {
+        dbupdateIncCount (dbupdate, C_FILE_SKIPPED);
+        logMsg (LOG_DBG, LOG_DBUPDATE, "  analyze-current");
+        dbupdateOutputProgress (dbupdate);
+        continue;
+      }
+
       if (regexMatch (dbupdate->badfnregex, fn)) {
         dbupdateIncCount (dbupdate, C_FILE_SKIPPED);
         dbupdateIncCount (dbupdate, C_SKIP_BAD);
@@ -664,7 +815,26 @@ dbupdateProcessing (void *udata)
       }
     }
 
-    if (fn == NULL) {
+    if (dbupdate->iterfromaudiosrc) {
+      dbupdate->counts [C_FILE_COUNT] = dirlistWalkCount (dbupdate->dirwalk);
+    }
+
+    if (fn == NULL && ! dbupdate->iterpending) {
+      if (dbupdate->iterfromaudiosrc) {
+        char  tmp [40];
+        char  tbuff [200];
+
+        logMsg (LOG_DBG, LOG_IMPORTANT, "read directory %s: %" PRId64 " ms",
+            dbupdate->processmusicdir, (int64_t) mstimeend (&dbupdate->starttm));
+        logMsg (LOG_DBG, LOG_IMPORTANT, "  %" PRId32 " files found", dbupdate->counts [C_FILE_COUNT]);
+
+        /* message to manageui */
+        snprintf (tmp, sizeof (tmp), "%" PRId32, dbupdate->counts [C_FILE_COUNT]);
+        /* CONTEXT: database update: status message (count) */
+        snprintf (tbuff, sizeof (tbuff), _("%s files found"), tmp);
+        connSendMessage (dbupdate->conn, ROUTE_MANAGEUI, MSG_DB_STATUS_MSG, tbuff);
+      }
+
       logMsg (LOG_DBG, LOG_IMPORTANT, "-- skipped (%" PRId32 ")", dbupdate->counts [C_FILE_SKIPPED]);
       logMsg (LOG_DBG, LOG_IMPORTANT, "-- all filenames sent (%" PRId32 "): %" PRId64 " ms",
           dbupdate->counts [C_FILE_QUEUED], (int64_t) mstimeend (&dbupdate->starttm));
@@ -683,7 +853,10 @@ dbupdateProcessing (void *udata)
         dbupdate->counts [C_FILE_PROC] + dbupdate->counts [C_FILE_SKIPPED],
         dbupdate->counts [C_FILE_COUNT]);
 
-    if (dbupdate->counts [C_FILE_PROC] + dbupdate->counts [C_FILE_SKIPPED] >=
+    /* while the directory walk is in progress, the file count */
+    /* is not yet final */
+    if (dbupdate->state == DB_UPD_PROCESS &&
+        dbupdate->counts [C_FILE_PROC] + dbupdate->counts [C_FILE_SKIPPED] >=
         dbupdate->counts [C_FILE_COUNT]) {
       logMsg (LOG_DBG, LOG_DBUPDATE, "  done");
       dbupdate->state = DB_UPD_FINISH;
@@ -725,8 +898,19 @@ dbupdateProcessing (void *udata)
     pathbldMakePath (dbfname, sizeof (dbfname),
         MUSICDB_FNAME, MUSICDB_EXT, PATHBLD_MP_DREL_DATA);
 
+    /* any scans that are still running must finish before */
+    /* the database is closed */
+    dbupdateAnalyzeCheckThreads (dbupdate, true);
+
+    songdbEndBatch (dbupdate->songdb);
     dbEndBatch (dbupdate->musicdb);
 
+    /* a partial scan is not saved, the next scan will use */
+    /* the prior manifest */
+    if (! dbupdate->stoprequest) {
+      dbmanifestSave (dbupdate->dbmanifest);
+    }
+
     if (dbupdate->cleandatabase) {
       dbEndBatch (dbupdate->newmusicdb);
       dbClose (dbupdate->newmusicdb);
@@ -751,7 +935,7 @@ dbupdateProcessing (void *udata)
     /* CONTEXT: database update: status message: new files saved to the database */
     dbupdateSendStatusCount (dbupdate, C_NEW, _("New Files"));
 
-    if (! dbupdate->rebuild && ! dbupdate->writetags) {
+    if (! dbupdate->rebuild && ! dbupdate->writetags && ! dbupdate->analyze) {
       /* CONTEXT: database update: status message: number of files updated in the database */
       dbupdateSendStatusCount (dbupdate, C_UPDATED, _("Updated"));
     }
@@ -767,6 +951,11 @@ dbupdateProcessing (void *udata)
       }
     }
 
+    if (dbupdate->analyze) {
+      /* CONTEXT: database update: status message: number of files updated in the database */
+      dbupdateSendStatusCount (dbupdate, C_UPDATED, _("Updated"));
+    }
+
     if (dbupdate->writetags) {
       /* re-use the 'Updated' label for write-tags */
       /* CONTEXT: database update: status message: number of files updated */
@@ -909,8 +1098,12 @@ dbupdateClosingCallback (void *tdbupdate, programstate_t programState)
 
   logProcBegin ();
 
-  audiosrcCleanIterator (dbupdate->asiter);
+  dirlistWalkFree (dbupdate->dirwalk);
+  dbmanifestFree (dbupdate->dbmanifest);
 
+  dbupdateAnalyzeCheckThreads (dbupdate, true);
+  /* the song lists must be updated for any files that were renamed */
+  songdbEndBatch (dbupdate->songdb);
   bdj4shutdown (ROUTE_DBUPDATE, dbupdate->musicdb);
   dbClose (dbupdate->newmusicdb);
 
@@ -972,11 +1165,25 @@ dbupdateProcessFileQueue (dbupdate_t *dbupdate)
 {
   tagdataitem_t *tdi;
 
+  if (dbupdate->analyze) {
+    dbupdateAnalyzeCheckThreads (dbupdate, false);
+    if (dbupdate->activethreads >= dbupdate->maxthreads) {
+      return;
+    }
+  }
+
   if (queueGetCount (dbupdate->tagdataq) <= 0) {
     return;
   }
 
   tdi = queuePop (dbupdate->tagdataq);
+
+  /* the loudness and bpm scans have their own processing */
+  if (dbupdate->analyze) {
+    dbupdateAnalyzeStart (dbupdate, tdi);
+    return;
+  }
+
   // fprintf (stderr, "  pop: %s\n", tdi->ffn);
   dbupdateProcessFile (dbupdate, tdi);
   dbupdateTagDataFree (tdi);
@@ -1289,6 +1496,245 @@ dbupdateReorganize (dbupdate_t *dbupdate, tagdataitem_t *tdi,
   dbupdateIncCount (dbupdate, C_FILE_PROC);
 }
 
+/* returns true if the song does not need to be scanned */
+static bool
+dbupdateAnalyzeSkip (dbupdate_t *dbupdate, song_t *song, const char *ffn)
+{
+  bool    skip = true;
+
+  if (dbupdate->loudness && ! dbupdateLoudnessSkip (song, ffn)) {
+    skip = false;
+  }
+  if (dbupdate->bpm && ! dbupdateBPMSkip (song)) {
+    skip = false;
+  }
+
+  return skip;
+}
+
+static bool
+dbupdateLoudnessSkip (song_t *song, const char *ffn)
+{
+  const char  *chk;
+  char        tbuff [100];
+
+  if (song == NULL) {
+    return true;
+  }
+
+  /* only local files can be scanned */
+  if (audiosrcGetType (songGetStr (song, TAG_URI)) != AUDIOSRC_TYPE_FILE) {
+    return true;
+  }
+
+  chk = songGetStr (song, TAG_LOUDNESS_CHK);
+  if (chk == NULL || ! *chk) {
+    return false;
+  }
+
+  /* if the audio file has not changed since the last scan, */
+  /* the stored results are still valid */
+  dbupdateLoudnessCheckKey (ffn, tbuff, sizeof (tbuff));
+  if (strcmp (chk, tbuff) == 0) {
+    return true;
+  }
+
+  return false;
+}
+
+static void
+dbupdateLoudnessCheckKey (const char *ffn, char *buff, size_t sz)
+{
+  snprintf (buff, sz, "%" PRId64 "/%" PRId64,
+      (int64_t) fileopSize (ffn), (int64_t) fileopModTime (ffn));
+}
+
+static bool
+dbupdateBPMSkip (song_t *song)
+{
+  if (song == NULL) {
+    return true;
+  }
+
+  /* only local files can be scanned */
+  if (audiosrcGetType (songGetStr (song, TAG_URI)) != AUDIOSRC_TYPE_FILE) {
+    return true;
+  }
+
+  /* a bpm set by the user is never replaced */
+  if (songGetNum (song, TAG_BPM) > 0) {
+    return true;
+  }
+
+  return false;
+}
+
+static void
+dbupdateAnalyzeStart (dbupdate_t *dbupdate, tagdataitem_t *tdi)
+{
+  dbupdthread_t   *dbthread;
+  song_t          *song;
+  int             idx = -1;
+
+  for (int i = 0; i < dbupdate->maxthreads; ++i) {
+    if (dbupdate->threads [i] == NULL) {
+      idx = i;
+      break;
+    }
+  }
+
+  song = dbGetByName (dbupdate->musicdb, tdi->songfn);
+
+  dbthread = mdmalloc (sizeof (dbupdthread_t));
+  dbthread->tdi = tdi;
+  dbthread->rc = -1;
+  dbthread->bpmrc = -1;
+  dbthread->doloudness = dbupdate->loudness &&
+      ! dbupdateLoudnessSkip (song, tdi->ffn);
+  dbthread->dobpm = dbupdate->bpm && ! dbupdateBPMSkip (song);
+  dbthread->bpmlow = BPMDETECT_BPM_LOW;
+  dbthread->bpmhigh = BPMDETECT_BPM_HIGH;
+  if (dbthread->dobpm) {
+    /* the dance data may not be accessed from the thread */
+    bpmdetectDanceRange (songGetNum (song, TAG_DANCE),
+        &dbthread->bpmlow, &dbthread->bpmhigh);
+  }
+  dbthread->finished = false;
+
+  logMsg (LOG_DBG, LOG_DBUPDATE, "analyze: start %d %s", idx, tdi->ffn);
+
+#if _lib_pthread_create
+  if (idx >= 0) {
+    dbupdate->threads [idx] = dbthread;
+    ++dbupdate->activethreads;
+    pthread_create (&dbthread->thread, NULL, dbupdateAnalyzeThread, dbthread);
+    return;
+  }
+#endif
+
+  /* no threads available, process it directly */
+  dbupdateAnalyze (dbthread);
+  dbupdateAnalyzeFinish (dbupdate, dbthread);
+}
+
+static void
+dbupdateAnalyzeCheckThreads (dbupdate_t *dbupdate, bool wait)
+{
+#if _lib_pthread_create
+  for (int i = 0; i < dbupdate->maxthreads; ++i) {
+    dbupdthread_t   *dbthread;
+
+    dbthread = dbupdate->threads [i];
+    if (dbthread == NULL) {
+      continue;
+    }
+
+    if (! wait && dbthread->finished == false) {
+      continue;
+    }
+
+    pthread_join (dbthread->thread, NULL);
+    dbupdate->threads [i] = NULL;
+    --dbupdate->activethreads;
+    dbupdateAnalyzeFinish (dbupdate, dbthread);
+  }
+#endif
+}
+
+/* runs in the thread */
+static void
+dbupdateAnalyze (dbupdthread_t *dbthread)
+{
+  if (dbthread->doloudness) {
+    dbthread->rc = aaLoudnessScan (dbthread->tdi->ffn, &dbthread->loudness);
+  }
+  if (dbthread->dobpm) {
+    dbthread->bpmrc = bpmdetectFile (dbthread->tdi->ffn,
+        dbthread->bpmlow, dbthread->bpmhigh, &dbthread->bpm);
+  }
+}
+
+/* frees the thread data */
+static void
+dbupdateAnalyzeFinish (dbupdate_t *dbupdate, dbupdthread_t *dbthread)
+{
+  tagdataitem_t   *tdi = dbthread->tdi;
+  song_t          *song;
+  bool            updated = false;
+  bool            failed = false;
+
+  song = dbGetByName (dbupdate->musicdb, tdi->songfn);
+
+  if (dbthread->doloudness) {
+    if (dbthread->rc == 0 && song != NULL) {
+      char    tbuff [100];
+
+      aaLoudnessCalcAdjustment (&dbthread->loudness);
+      dbupdateLoudnessCheckKey (tdi->ffn, tbuff, sizeof (tbuff));
+      songSetDouble (song, TAG_LOUDNESS, dbthread->loudness.integrated);
+      songSetDouble (song, TAG_LOUDNESS_PEAK, dbthread->loudness.truepeak);
+      songSetDouble (song, TAG_LOUDNESS_ADJ, dbthread->loudness.adjustment);
+      songSetStr (song, TAG_LOUDNESS_CHK, tbuff);
+      /* the audio file is not modified, dbWriteSong() is ok */
+      dbWriteSong (dbupdate->musicdb, song);
+      updated = true;
+      logMsg (LOG_DBG, LOG_DBUPDATE, "loudness: %s %.1f %.1f %.1f%%",
+          tdi->songfn, dbthread->loudness.integrated,
+          dbthread->loudness.truepeak, dbthread->loudness.adjustment);
+    } else {
+      failed = true;
+      logMsg (LOG_DBG, LOG_DBUPDATE, "loudness: fail %s", tdi->songfn);
+    }
+  }
+
+  if (dbthread->dobpm) {
+    if (dbthread->bpmrc == 0 && song != NULL &&
+        dbthread->bpm.confidence >= BPMDETECT_CONF_MIN) {
+      int32_t   songdbflags = SONGDB_NONE;
+
+      /* the bpm is a tag, and may be written to the audio file */
+      /* the tag holds measures per minute */
+      songSetNum (song, TAG_BPM, bpmdetectToMPM (
+          songGetNum (song, TAG_DANCE), dbthread->bpm.bpm));
+      dbupdateSetCurrentDB (dbupdate);
+      dbupdateWriteSong (dbupdate, song, &songdbflags, songGetNum (song, TAG_RRN));
+      updated = true;
+      logMsg (LOG_DBG, LOG_DBUPDATE, "bpm: %s %d (%d-%d) conf: %d",
+          tdi->songfn, dbthread->bpm.bpm, dbthread->bpmlow,
+          dbthread->bpmhigh, dbthread->bpm.confidence);
+    } else {
+      failed = true;
+      logMsg (LOG_DBG, LOG_DBUPDATE, "bpm: fail %s %d conf: %d",
+          tdi->songfn, dbthread->bpm.bpm, dbthread->bpm.confidence);
+    }
+  }
+
+  if (updated) {
+    dbupdateIncCount (dbupdate, C_UPDATED);
+  } else if (failed) {
+    dbupdateIncCount (dbupdate, C_SKIP_BAD);
+  }
+
+  dbupdateIncCount (dbupdate, C_FILE_PROC);
+  dbupdateTagDataFree (tdi);
+  mdfree (dbthread);
+}
+
+#if _lib_pthread_create
+
+static void *
+dbupdateAnalyzeThread (void *arg)
+{
+  dbupdthread_t   *dbthread = arg;
+
+  dbupdateAnalyze (dbthread);
+  dbthread->finished = true;
+  pthread_exit (NULL);
+  return NULL;
+}
+
+#endif
+
 static void
 dbupdateSigHandler (int sig)
 {
@@ -1407,7 +1853,18 @@ dbupdateIterate (dbupdate_t *dbupdate)
   song_t      *song;
 
   if (dbupdate->iterfromaudiosrc) {
-    fn = audiosrcIterate (dbupdate->asiter);
+    dirwalkrc_t   rc;
+
+    dbupdate->iterpending = false;
+    rc = dirlistWalkNext (dbupdate->dirwalk, dbupdate->walkfn,
+        sizeof (dbupdate->walkfn));
+    if (rc == DIRLIST_WALK_ENTRY) {
+      fn = dbupdate->walkfn;
+    }
+    if (rc == DIRLIST_WALK_WAIT) {
+      /* the walk is still running, try again on the next pass */
+      dbupdate->iterpending = true;
+    }
   }
   if (dbupdate->iterfromdb) {
     song = dbIterate (dbupdate->musicdb, &dbidx, &dbupdate->dbiter);
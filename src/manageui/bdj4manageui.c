@@ -26,6 +26,7 @@
 #include "bdjstring.h"
 #include "bdjvars.h"
 #include "bdjvarsdf.h"
+#include "bpmdetect.h"
 #include "callback.h"
 #include "conn.h"
 #include "continst.h"
@@ -78,6 +79,7 @@
 #include "uiplayer.h"
 #include "uiplaylist.h"
 #include "uiselectfile.h"
+#include "uisong.h"
 #include "uisongedit.h"
 #include "uisongfilter.h"
 #include "uisongsel.h"
@@ -283,6 +285,9 @@ typedef struct {
   manageaudioid_t   *manageaudioid;
   /* bpm counter */
   int               currtimesig;
+  int               currbpmlow;
+  int               currbpmhigh;
+  char              currffn [BDJ4_PATH_MAX];
   /* song editor */
   uict_t            *uict;
   int               ctstate;
@@ -566,6 +571,9 @@ main (int argc, char *argv[])
   manage.managedb = NULL;   /* allocated within buildui */
   manage.manageaudioid = NULL;
   manage.currtimesig = DANCE_TIMESIG_44;
+  manage.currbpmlow = BPMDETECT_BPM_LOW;
+  manage.currbpmhigh = BPMDETECT_BPM_HIGH;
+  *manage.currffn = '\0';
   manage.cfpl = NULL;
   manage.lastinsertlocation = QUEUE_LOC_LAST;
   manage.bpmcounterstarted = false;
@@ -2036,6 +2044,8 @@ static void
 manageRePopulateData (manageui_t *manage)
 {
   /* re-populate the song selection displays to display the updated info */
+  /* the song that changed is not known here */
+  uisongCacheReset ();
   manage->selbypass = true;
   uisongselPopulateData (manage->slsongsel);
   uisongselPopulateData (manage->slsbssongsel);
@@ -2203,7 +2213,10 @@ manageEditAllApply (void *udata)
   if (! manage->ineditall) {
     return UICB_STOP;
   }
+  /* the song lists are updated once for all of the changed songs */
+  songdbStartBatch (manage->songdb);
   uisongeditEditAllApply (manage->mmsongedit);
+  songdbEndBatch (manage->songdb);
   uisongeditEditAllSetFields (manage->mmsongedit, UISONGEDIT_EDITALL_OFF);
   manage->ineditall = false;
 
@@ -4162,11 +4175,18 @@ manageSetBPMCounter (manageui_t *manage, song_t *song)
 
   logProcBegin ();
 
+  /* the bpm counter's automatic detection needs the audio file */
+  *manage->currffn = '\0';
+  if (audiosrcGetType (songGetStr (song, TAG_URI)) == AUDIOSRC_TYPE_FILE) {
+    audiosrcFullPath (songGetStr (song, TAG_URI), manage->currffn,
+        sizeof (manage->currffn), NULL, 0);
+  }
+
   danceIdx = songGetNum (song, TAG_DANCE);
-  if (danceIdx < 0) {
-    return;
+  if (danceIdx >= 0) {
+    manage->currtimesig = danceGetTimeSignature (danceIdx);
   }
-  manage->currtimesig = danceGetTimeSignature (danceIdx);
+  bpmdetectDanceRange (danceIdx, &manage->currbpmlow, &manage->currbpmhigh);
 
   manageSendBPMCounter (manage);
   logProcEnd ("");
@@ -4175,7 +4195,7 @@ manageSetBPMCounter (manageui_t *manage, song_t *song)
 static void
 manageSendBPMCounter (manageui_t *manage)
 {
-  char        tbuff [60];
+  char        tbuff [BDJ4_PATH_MAX + 60];
 
   logProcBegin ();
   if (! manage->bpmcounterstarted) {
@@ -4183,7 +4203,11 @@ manageSendBPMCounter (manageui_t *manage)
     return;
   }
 
-  snprintf (tbuff, sizeof (tbuff), "%d", manage->currtimesig);
+  snprintf (tbuff, sizeof (tbuff), "%d%c%d%c%d%c%s",
+      manage->currtimesig, MSG_ARGS_RS,
+      manage->currbpmlow, MSG_ARGS_RS,
+      manage->currbpmhigh, MSG_ARGS_RS,
+      manage->currffn);
   connSendMessage (manage->conn, ROUTE_BPM_COUNTER, MSG_BPM_TIMESIG, tbuff);
   logProcEnd ("");
 }
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <errno.h>
 #include <getopt.h>
@@ -13,6 +14,10 @@
 #include <math.h>
 #include <time.h>
 
+#if __has_include (<pthread.h>)
+# include <pthread.h>
+#endif
+
 #include "asconf.h"
 #include "audiosrc.h"
 #include "bdj4.h"
@@ -31,23 +36,38 @@
 #include "tagdef.h"
 #include "tmutil.h"
 
+enum {
+  PODCASTUPD_THREADS = 4,
+};
+
 typedef struct {
   char      *plname;
+  char      *uri;
   slist_t   *songidxlist;
+  imppl_t   *imppl;
 } pcupditem_t;
 
 typedef struct {
-  pcupditem_t *itemlist;
-  musicdb_t   *musicdb;
-  int         idx;
-  int         count;
-  int         askey;
-  bool        dbchanged;
+  pcupditem_t   *itemlist;
+  musicdb_t     *musicdb;
+  int           count;
+  int           askey;
+  _Atomic(int)  nextidx;
+  bool          dbchanged;
 } pcupd_t;
 
+typedef struct {
+  pcupd_t         *pcupd;
+#if _lib_pthread_create
+  pthread_t       thread;
+#endif
+} pcupdworker_t;
+
 static int podcastupdGetASKey (void);
 static void podcastupdProcess (pcupd_t *pcupd);
-static bool podcastupdProcessPodcast (pcupd_t *pcupd, const char *plname);
+static void podcastupdFetch (pcupd_t *pcupd);
+static void *podcastupdFetchWorker (void *arg);
+static bool podcastupdProcessPodcast (pcupd_t *pcupd, int idx);
 static void podcastupdCreateSonglists (pcupd_t *pcupd);
 
 int
@@ -64,7 +84,7 @@ main (int argc, char *argv[])
   pcupd.itemlist = NULL;
   pcupd.musicdb = NULL;
   pcupd.count = 0;
-  pcupd.idx = 0;
+  pcupd.nextidx = 0;
   pcupd.askey = -1;
   pcupd.dbchanged = false;
 
@@ -83,7 +103,9 @@ main (int argc, char *argv[])
     pcupd.itemlist = mdmalloc (sizeof (pcupditem_t) * pcupd.count);
     for (int idx = 0; idx < pcupd.count; ++idx) {
       pcupd.itemlist [idx].plname = NULL;
+      pcupd.itemlist [idx].uri = NULL;
       pcupd.itemlist [idx].songidxlist = NULL;
+      pcupd.itemlist [idx].imppl = NULL;
     }
 
     logEnd ();
@@ -97,8 +119,10 @@ main (int argc, char *argv[])
     bdj4shutdown (ROUTE_PODCASTUPD, pcupd.musicdb);
 
     for (int idx = 0; idx < pcupd.count; ++idx) {
+      impplFree (pcupd.itemlist [idx].imppl);
       slistFree (pcupd.itemlist [idx].songidxlist);
-      mdfree (pcupd.itemlist [idx].plname);
+      dataFree (pcupd.itemlist [idx].plname);
+      dataFree (pcupd.itemlist [idx].uri);
     }
     mdfree (pcupd.itemlist);
   }
@@ -143,56 +167,122 @@ podcastupdProcess (pcupd_t *pcupd)
   slist_t     *filelist;
   slistidx_t  iteridx;
   const char  *nm;
+  int         idx = 0;
 
   filelist = playlistGetPlaylistNames (PL_LIST_PODCAST, NULL);
   slistStartIterator (filelist, &iteridx);
   while ((nm = slistIterateKey (filelist, &iteridx)) != NULL) {
-    pcupd->dbchanged |= podcastupdProcessPodcast (pcupd, nm);
-    pcupd->idx += 1;
+    podcast_t   *podcast;
+
+    if (idx >= pcupd->count) {
+      break;
+    }
+
+    podcast = podcastLoad (nm);
+    if (podcast != NULL) {
+      pcupd->itemlist [idx].plname = mdstrdup (nm);
+      pcupd->itemlist [idx].uri =
+          mdstrdup (podcastGetStr (podcast, PODCAST_URI));
+      pcupd->itemlist [idx].songidxlist =
+          slistAlloc ("podu-imppl-song-idx", LIST_UNORDERED, NULL);
+    }
+    podcastFree (podcast);
+    idx += 1;
   }
   slistFree (filelist);
 
+  podcastupdFetch (pcupd);
+
+  for (idx = 0; idx < pcupd->count; ++idx) {
+    pcupd->dbchanged |= podcastupdProcessPodcast (pcupd, idx);
+  }
+
   podcastupdCreateSonglists (pcupd);
 }
 
+/* the feeds are fetched and parsed in parallel. */
+/* the database updates are done afterwards, one podcast at a time */
+static void
+podcastupdFetch (pcupd_t *pcupd)
+{
+  pcupdworker_t   workers [PODCASTUPD_THREADS];
+  int             workercount;
+
+  workercount = pcupd->count;
+  if (workercount > PODCASTUPD_THREADS) {
+    workercount = PODCASTUPD_THREADS;
+  }
+
+  pcupd->nextidx = 0;
+  for (int i = 0; i < workercount; ++i) {
+    workers [i].pcupd = pcupd;
+#if _lib_pthread_create
+    pthread_create (&workers [i].thread, NULL, podcastupdFetchWorker, &workers [i]);
+#else
+    podcastupdFetchWorker (&workers [i]);
+#endif
+  }
+  for (int i = 0; i < workercount; ++i) {
+#if _lib_pthread_create
+    pthread_join (workers [i].thread, NULL);
+#endif
+  }
+}
+
+static void *
+podcastupdFetchWorker (void *arg)
+{
+  pcupdworker_t   *worker = arg;
+  pcupd_t         *pcupd = worker->pcupd;
+  pcupditem_t     *item;
+  int             idx;
+
+  while ((idx = atomic_fetch_add (&pcupd->nextidx, 1)) < pcupd->count) {
+    item = &pcupd->itemlist [idx];
+    if (item->uri == NULL) {
+      continue;
+    }
+
+    logMsg (LOG_DBG, LOG_INFO, "fetch %s", item->plname);
+    /* starting the playlist iterator fetches and parses the feed */
+    item->imppl = impplInit (item->songidxlist, AUDIOSRC_TYPE_PODCAST,
+        item->uri, item->plname, item->plname, pcupd->askey);
+  }
+
+#if _lib_pthread_create
+  pthread_exit (NULL);
+#endif
+  return NULL;
+}
+
 static bool
-podcastupdProcessPodcast (pcupd_t *pcupd, const char *plname)
+podcastupdProcessPodcast (pcupd_t *pcupd, int idx)
 {
-  podcast_t   *podcast;
-  int         retain;
-  imppl_t     *imppl;
+  pcupditem_t *item;
   bool        dbchanged;
 
-  logMsg (LOG_DBG, LOG_INFO, "process %s", plname);
-
-  podcast = podcastLoad (plname);
-  if (podcast == NULL) {
+  item = &pcupd->itemlist [idx];
+  if (item->imppl == NULL) {
     return false;
   }
 
-  retain = podcastGetNum (podcast, PODCAST_RETAIN);
+  logMsg (LOG_DBG, LOG_INFO, "process %s", item->plname);
 
-  pcupd->itemlist [pcupd->idx].plname = mdstrdup (plname);
-  pcupd->itemlist [pcupd->idx].songidxlist =
-      slistAlloc ("podu-imppl-song-idx", LIST_UNORDERED, NULL);
-  imppl = impplInit (pcupd->itemlist [pcupd->idx].songidxlist,
-      AUDIOSRC_TYPE_PODCAST,
-      podcastGetStr (podcast, PODCAST_URI), plname, plname, pcupd->askey);
-  impplSetDB (imppl, pcupd->musicdb);
-  while (impplProcess (imppl) == false) {
+  impplSetDB (item->imppl, pcupd->musicdb);
+  while (impplProcess (item->imppl) == false) {
     ;
   }
 
-  dbchanged = impplIsDBChanged (imppl);
+  dbchanged = impplIsDBChanged (item->imppl);
   if (dbchanged) {
     pcupd->musicdb = bdj4ReloadDatabase (pcupd->musicdb);
-    impplSetDB (imppl, pcupd->musicdb);
+    impplSetDB (item->imppl, pcupd->musicdb);
   }
 
-  impplFinalize (imppl);
+  impplFinalize (item->imppl);
 
-  podcastFree (podcast);
-  impplFree (imppl);
+  impplFree (item->imppl);
+  item->imppl = NULL;
 
   return dbchanged;
 }
@@ -205,6 +295,10 @@ podcastupdCreateSonglists (pcupd_t *pcupd)
     const char  *songuri;
     slistidx_t  iteridx;
 
+    if (pcupd->itemlist [idx].songidxlist == NULL) {
+      continue;
+    }
+
     dbidxlist = nlistAlloc ("tmp-pcupd-dbidx", LIST_UNORDERED, NULL);
     nlistSetSize (dbidxlist, slistGetCount (pcupd->itemlist [idx].songidxlist));
 
@@ -16,7 +16,9 @@
 #include "log.h"
 #include "manageui.h"
 #include "mdebug.h"
+#include "musicdb.h"
 #include "nlist.h"
+#include "songfilter.h"
 #include "ui.h"
 #include "uiaudioid.h"
 #include "uisongsel.h"
@@ -32,6 +34,8 @@ typedef struct manageaudioid {
   int               state;
 } manageaudioid_t;
 
+static void manageAudioIdPrefetch (manageaudioid_t *maudioid, dbidx_t dbidx);
+
 manageaudioid_t *
 manageAudioIdAlloc (manageinfo_t *minfo)
 {
@@ -114,6 +118,9 @@ manageAudioIdMainLoop (manageaudioid_t *maudioid)
 
   switch (maudioid->state) {
     case BDJ4_STATE_OFF: {
+      /* the upcoming songs are fingerprinted after the current */
+      /* lookup has finished */
+      audioidPrefetchProcess (maudioid->audioid);
       break;
     }
     case BDJ4_STATE_START: {
@@ -165,6 +172,7 @@ manageAudioIdLoad (manageaudioid_t *maudioid, song_t *song, dbidx_t dbidx)
   maudioid->song = song;
   if (! uiaudioidInSave (maudioid->uiaudioid)) {
     maudioid->state = BDJ4_STATE_START;
+    manageAudioIdPrefetch (maudioid, dbidx);
   }
 }
 
@@ -184,3 +192,35 @@ manageAudioIdSavePosition (manageaudioid_t *maudioid)
   uiaudioidSavePanePosition (maudioid->uiaudioid);
 }
 
+/* internal routines */
+
+/* the songs following the selected song are likely to be */
+/* identified next */
+static void
+manageAudioIdPrefetch (manageaudioid_t *maudioid, dbidx_t dbidx)
+{
+  nlistidx_t    nidx;
+  dbidx_t       count;
+  songfilter_t  *sf;
+
+  audioidPrefetchClear (maudioid->audioid);
+
+  if (maudioid->uisongsel == NULL) {
+    return;
+  }
+
+  sf = maudioid->uisongsel->songfilter;
+  nidx = uisongselGetSelectLocation (maudioid->uisongsel);
+  if (nidx < 0 || songfilterGetByIdx (sf, nidx) != dbidx) {
+    return;
+  }
+
+  count = songfilterGetCount (sf);
+  for (int i = 1; i <= AUDIOID_PREFETCH_MAX && nidx + i < count; ++i) {
+    song_t    *song;
+
+    song = dbGetByIdx (maudioid->minfo->musicdb,
+        songfilterGetByIdx (sf, nidx + i));
+    audioidPrefetchAdd (maudioid->audioid, song);
+  }
+}
@@ -35,6 +35,8 @@ enum {
   MANAGE_DB_REORGANIZE,
   MANAGE_DB_UPD_FROM_TAGS,
   MANAGE_DB_WRITE_TAGS,
+  MANAGE_DB_LOUDNESS,
+  MANAGE_DB_BPM,
   MANAGE_DB_UPD_FROM_ITUNES,
   MANAGE_DB_REBUILD,
 };
@@ -136,6 +138,18 @@ manageDbAlloc (manageinfo_t *minfo, conn_t *conn, procutil_t **processes)
       /* CONTEXT: database update: write tags to audio files: help text */
       _("Writes the audio file tags using the information from the BallroomDJ database."));
 
+  /* CONTEXT: database update: scans the audio files for loudness */
+  nlistSetStr (tlist, MANAGE_DB_LOUDNESS, _("Loudness Scan"));
+  nlistSetStr (hlist, MANAGE_DB_LOUDNESS,
+      /* CONTEXT: database update: loudness scan: help text */
+      _("Scans the audio files and calculates a volume adjustment so that all songs play at a similar loudness."));
+
+  /* CONTEXT: database update: detects the BPM of the audio files */
+  nlistSetStr (tlist, MANAGE_DB_BPM, _("Detect BPM"));
+  nlistSetStr (hlist, MANAGE_DB_BPM,
+      /* CONTEXT: database update: detect bpm: help text */
+      _("Scans the audio files that do not have a BPM set and stores the detected BPM."));
+
   /* CONTEXT: database update: update from itunes */
   snprintf (tbuff, sizeof (tbuff), _("Update from %s"), ITUNES_NAME);
   nlistSetStr (tlist, MANAGE_DB_UPD_FROM_ITUNES, tbuff);
@@ -478,6 +492,14 @@ manageDbStart (void *udata)
       targv [targc++] = "--writetags";
       break;
     }
+    case MANAGE_DB_LOUDNESS: {
+      targv [targc++] = "--loudness";
+      break;
+    }
+    case MANAGE_DB_BPM: {
+      targv [targc++] = "--bpm";
+      break;
+    }
     case MANAGE_DB_REBUILD: {
       targv [targc++] = "--rebuild";
       break;
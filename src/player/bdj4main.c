@@ -78,6 +78,9 @@ enum {
 enum {
   MAIN_PREP_SIZE = 5,
   MAIN_NOT_SET = -1,
+  /* the maximum time spent filling a music queue before the main */
+  /* loop gets a chance to process messages */
+  MAIN_FILL_TIME = 10,
   MAIN_TS_DEBUG_MAX = 6,
 };
 
@@ -110,6 +113,7 @@ typedef struct {
   int               songplaysentcount;        // for testsuite
   int               musicqChanged [MUSICQ_MAX];
   bool              changeSuspend [MUSICQ_MAX];
+  bool              fillPending [MUSICQ_MAX];
   time_t            stopTime [MUSICQ_MAX];
   time_t            nStopTime [MUSICQ_MAX];
   mstime_t          startWaitCheck;
@@ -246,6 +250,7 @@ main (int argc, char *argv[])
     mainData.playlistQueue [i] = NULL;
     mainData.musicqChanged [i] = MAIN_CHG_CLEAR;
     mainData.changeSuspend [i] = false;
+    mainData.fillPending [i] = false;
     mainData.stopTime [i] = 0;
     mainData.nStopTime [i] = 0;
   }
@@ -695,6 +700,15 @@ mainProcessing (void *udata)
   }
 
   connProcessUnconnected (mainData->conn);
+  procutilCheckHandshake (mainData->processes, mainData->conn);
+
+  /* continue filling any music queue that ran out of time */
+  for (int i = 0; i < MUSICQ_MAX; ++i) {
+    if (mainData->fillPending [i]) {
+      mainMusicQueueFill (mainData, i);
+      mainMusicQueuePrep (mainData, i);
+    }
+  }
 
   for (int i = 0; i < MUSICQ_MAX; ++i) {
     if (mainData->changeSuspend [i] == false &&
@@ -844,6 +858,7 @@ mainHandshakeCallback (void *tmaindata, programstate_t programState)
   logProcBegin ();
 
   connProcessUnconnected (mainData->conn);
+  procutilCheckHandshake (mainData->processes, mainData->conn);
 
   if (connHaveHandshake (mainData->conn, ROUTE_STARTERUI)) {
     ++conn;
@@ -1443,9 +1458,15 @@ mainMusicQueueFill (maindata_t *mainData, int mqidx)
   int             editmode = EDIT_FALSE;
   time_t          stopTime = 0;
   time_t          nStopTime = 0;
+  mstime_t        fillCheck;
 
   logProcBegin ();
 
+  /* long queues are filled a portion at a time so that messages */
+  /* are not held up.  the main loop continues the fill. */
+  mainData->fillPending [mqidx] = false;
+  mstimeset (&fillCheck, MAIN_FILL_TIME);
+
   plitem = queueGetFirst (mainData->playlistQueue [mqidx]);
   playlist = NULL;
   if (plitem != NULL) {
@@ -1530,6 +1551,15 @@ mainMusicQueueFill (maindata_t *mainData, int mqidx)
       }
       continue;
     }
+
+    /* the songs to be prepped are always added in the first pass, */
+    /* a short queue may be taken as the end of the queue */
+    if (playlist != NULL && currlen > MAIN_PREP_SIZE &&
+        currlen <= playerqLen && mstimeCheck (&fillCheck)) {
+      logMsg (LOG_DBG, LOG_BASIC, "fill: pending %d < %d", currlen, playerqLen);
+      mainData->fillPending [mqidx] = true;
+      break;
+    }
   }
 
   logProcEnd ("");
@@ -1662,6 +1692,16 @@ mainPrepSong (maindata_t *mainData, int prepflag, int mqidx,
   if (voladjperc == LIST_DOUBLE_INVALID) {
     voladjperc = 0.0;
   }
+  if (voladjperc == 0.0) {
+    double    loudadj;
+
+    /* if the user has not set a volume adjustment, use the */
+    /* adjustment calculated by the loudness scan */
+    loudadj = songGetDouble (song, TAG_LOUDNESS_ADJ);
+    if (! isnan (loudadj) && loudadj != LIST_DOUBLE_INVALID) {
+      voladjperc = loudadj;
+    }
+  }
 
   songstart = songGetNum (song, TAG_SONGSTART);
   if (songstart < 0) { songstart = 0; }
@@ -32,10 +32,9 @@
 #include "webclient.h"
 #include "websrv.h"
 
-typedef struct {
-  const char    *webresponse;
-  size_t        webresplen;
-} mobmqwebresp_t;
+enum {
+  MOBMQ_WEB_TIMEOUT = 1000,
+};
 
 typedef struct {
   conn_t          *conn;
@@ -43,11 +42,12 @@ typedef struct {
   int             stopwaitcount;
   char            *title;
   websrv_t        *websrv;
-  webclient_t     *webclient;
+  websrvpayload_t *payload;
+  webclientmulti_t *webmulti;
   char            *marqueeData;
   const char      *tag;
   const char      *key;
-  mobmqwebresp_t  mobmqwebresp;
+  int             webreqid;
   char            tdata [800];
   uint16_t        port;
   int             type;
@@ -66,7 +66,8 @@ static int      mobmqProcessing (void *udata);
 static void     mobmqSigHandler (int sig);
 static void mobmqInternetProcess (mobmqdata_t *mobmqdata);
 static const char *mobmqBuildResponse (mobmqdata_t *mobmqdata);
-static void mobmqWebResponseCallback (void *userdata, const char *resp, size_t len, time_t tm);
+static void mobmqUpdatePayload (mobmqdata_t *mobmqdata);
+static void mobmqWebResponseCallback (void *userdata, int webrc, const char *resp, size_t len, time_t tm);
 
 static int  gKillReceived = 0;
 
@@ -118,7 +119,9 @@ main (int argc, char *argv[])
   mobmqdata.port = bdjoptGetNum (OPT_P_MOBMQ_PORT);
 
   mobmqdata.websrv = NULL;
-  mobmqdata.webclient = NULL;
+  mobmqdata.payload = NULL;
+  mobmqdata.webmulti = NULL;
+  mobmqdata.webreqid = -1;
   mobmqdata.marqueeData = NULL;
   mobmqdata.stopwaitcount = 0;
   mobmqdata.finished = false;
@@ -126,10 +129,11 @@ main (int argc, char *argv[])
   if (mobmqdata.type == MOBMQ_TYPE_LOCAL) {
     mobmqdata.websrv = websrvInit (mobmqdata.port, mobmqEventHandler,
         &mobmqdata, WEBSRV_TLS_OFF);
+    mobmqdata.payload = websrvPayloadAlloc ();
+    mobmqUpdatePayload (&mobmqdata);
   }
   if (mobmqdata.type == MOBMQ_TYPE_INTERNET) {
-    mobmqdata.webclient = webclientAlloc (&mobmqdata.mobmqwebresp, mobmqWebResponseCallback);
-    webclientSetTimeout (mobmqdata.webclient, 1000);
+    mobmqdata.webmulti = webclientMultiAlloc ();
   }
 
   listenPort = bdjvarsGetNum (BDJVL_PORT_MOBILEMQ);
@@ -173,7 +177,8 @@ mobmqClosingCallback (void *tmmdata, programstate_t programState)
   bdj4shutdown (ROUTE_MOBILEMQ, NULL);
 
   websrvFree (mobmqdata->websrv);
-  webclientClose (mobmqdata->webclient);
+  websrvPayloadFree (mobmqdata->payload);
+  webclientMultiFree (mobmqdata->webmulti);
   dataFree (mobmqdata->title);
   dataFree (mobmqdata->marqueeData);
 
@@ -186,11 +191,13 @@ mobmqEventHandler (void *userdata, const char *query, const char *uri)
   mobmqdata_t   *mobmqdata = userdata;
 
   if (strcmp (uri, "/mmupdate") == 0) {
-    const char *data = NULL;
-
-    data = mobmqBuildResponse (mobmqdata);
-    websrvReply (mobmqdata->websrv, WEB_OK,
-        "Content-Type: application/json\r\n", data);
+    /* the payload is only re-built when the marquee changes */
+    websrvReplyPayload (mobmqdata->websrv,
+        "Content-Type: application/json\r\n"
+        "Cache-Control: no-cache\r\n", mobmqdata->payload);
+  } else if (strcmp (uri, "/mmevents") == 0) {
+    websrvStreamStart (mobmqdata->websrv,
+        websrvPayloadGetData (mobmqdata->payload));
   } else {
     char          path [BDJ4_PATH_MAX];
     const char    *turi = uri;
@@ -198,9 +205,13 @@ mobmqEventHandler (void *userdata, const char *query, const char *uri)
     if (*uri == '/') {
       ++uri;
     }
-    pathbldMakePath (path, sizeof (path), uri, "", PATHBLD_MP_DREL_HTTP);
-    if (! fileopFileExists (path)) {
+    if (*uri == '\0') {
       turi = "/mobilemq.html";
+    } else {
+      pathbldMakePath (path, sizeof (path), uri, "", PATHBLD_MP_DREL_HTTP);
+      if (! fileopFileExists (path)) {
+        turi = "/mobilemq.html";
+      }
     }
 
     logMsg (LOG_DBG, LOG_IMPORTANT, "serve: %s", turi);
@@ -238,10 +249,12 @@ mobmqProcessMsg (bdjmsgroute_t routefrom, bdjmsgroute_t route,
           if (mobmqdata->type == MOBMQ_TYPE_INTERNET) {
             mobmqInternetProcess (mobmqdata);
           }
+          mobmqUpdatePayload (mobmqdata);
           break;
         }
         case MSG_FINISHED: {
           mobmqdata->finished = true;
+          mobmqUpdatePayload (mobmqdata);
           break;
         }
         default: {
@@ -281,6 +294,7 @@ mobmqProcessing (void *udata)
   connProcessUnconnected (mobmqdata->conn);
 
   websrvProcess (websrv);
+  webclientMultiProcess (mobmqdata->webmulti);
 
   if (gKillReceived) {
     progstateShutdownProcess (mobmqdata->progstate);
@@ -348,7 +362,12 @@ mobmqInternetProcess (mobmqdata_t *mobmqdata)
       mobmqdata->tag,
       mobmqdata->key,
       data);
-  webclientPost (mobmqdata->webclient, uri, tbuff);
+
+  /* the post does not block the main loop. */
+  /* a post that has not finished is superseded by the new data */
+  webclientMultiCancel (mobmqdata->webmulti, mobmqdata->webreqid);
+  mobmqdata->webreqid = webclientMultiPost (mobmqdata->webmulti, uri, tbuff,
+      MOBMQ_WEB_TIMEOUT, mobmqWebResponseCallback, mobmqdata);
 }
 
 static const char *
@@ -385,13 +404,38 @@ mobmqBuildResponse (mobmqdata_t *mobmqdata)
   return data;
 }
 
+/* the local response is encoded once, and pushed to the */
+/* clients that are listening for events */
+static void
+mobmqUpdatePayload (mobmqdata_t *mobmqdata)
+{
+  const char  *data;
+  const char  *odata;
+
+  if (mobmqdata->payload == NULL) {
+    return;
+  }
+
+  data = mobmqBuildResponse (mobmqdata);
+  odata = websrvPayloadGetData (mobmqdata->payload);
+  if (odata != NULL && strcmp (odata, data) == 0) {
+    return;
+  }
+
+  websrvPayloadSet (mobmqdata->payload, data, strlen (data));
+  websrvStreamSend (mobmqdata->websrv, data);
+}
+
 static void
-mobmqWebResponseCallback (void *userdata, const char *resp, size_t len, time_t tm)
+mobmqWebResponseCallback (void *userdata, int webrc, const char *resp,
+    size_t len, time_t tm)
 {
-  mobmqwebresp_t *mobmqwebresp = userdata;
+  mobmqdata_t   *mobmqdata = userdata;
 
-  mobmqwebresp->webresponse = resp;
-  mobmqwebresp->webresplen = len;
+  mobmqdata->webreqid = -1;
+  if (webrc != WEB_OK) {
+    logMsg (LOG_DBG, LOG_IMPORTANT, "mobmq: post failed: %d", webrc);
+  }
   return;
 }
 
@@ -86,6 +86,11 @@ enum {
   PREP_RETRY_COUNT = 2,
 #endif
   PREP_RETRY_COUNT_BASE = 2,
+  /* gapless: the next song is pre-rolled this long before the end */
+  PLAYER_PREROLL_TIME = 5000,
+  /* gapless: the end-of-stream is the signal to switch songs, */
+  /* the end check timer is only a backup */
+  PLAYER_PREROLL_GRACE = 2000,
 };
 
 enum {
@@ -170,6 +175,7 @@ typedef struct {
   mstime_t        playTimeCheck;
   mstime_t        playEndCheck;
   mstime_t        fadeTimeCheck;      // both standard fade and cross fade
+  mstime_t        prerollTimeCheck;
   mstime_t        volumeTimeCheck;
   int             newSpeed;
   long            priorGap;           // used for announcements
@@ -187,6 +193,7 @@ typedef struct {
   int             stopwaitcount;
   int             maxthreadidx;
   int             artificialdelay;
+  int32_t         prerollUniqueidx;
   bool            inFade;
   bool            inFadeIn;
   bool            inFadeOut;
@@ -195,6 +202,7 @@ typedef struct {
   bool            mute;
   bool            newsong;      // used in the player status msg
   bool            pauseAtEnd;
+  bool            prerolled;
   bool            repeat;
   bool            speedWaitChg;
   bool            stopPlaying;
@@ -240,6 +248,9 @@ static double   calcFadeIndex (playerdata_t *playerData, int fadeType);
 static void     playerStartFadeOut (playerdata_t *playerData);
 static void     playerStartCrossFade (playerdata_t *playerData);
 static void     playerSetCheckTimes (playerdata_t *playerData, prepqueue_t *pq);
+static int      playerMediaPath (prepqueue_t *pq, char *tempffn, size_t sz);
+static void     playerPreroll (playerdata_t *playerData);
+static void     playerPrerollCancel (playerdata_t *playerData);
 static void     playerSetPlayerState (playerdata_t *playerData, playerstate_t pstate);
 static void     playerSendStatus (playerdata_t *playerData, bool forceFlag);
 static int      playerLimitVolume (int vol);
@@ -299,6 +310,8 @@ main (int argc, char *argv[])
   playerData.stopwaitcount = 0;
   playerData.artificialdelay = 0;
   playerData.maxthreadidx = 0;
+  playerData.prerollUniqueidx = -1;
+  mstimeset (&playerData.prerollTimeCheck, TM_TIMER_OFF);
   for (int i = 0; i < PLAYER_MAX_PREP; ++i) {
     playerData.prepthread [i] = NULL;
   }
@@ -311,6 +324,7 @@ main (int argc, char *argv[])
   playerData.mute = false;
   playerData.newsong = false;
   playerData.pauseAtEnd = false;
+  playerData.prerolled = false;
   playerData.repeat = false;
   playerData.speedWaitChg = false;
   playerData.stopPlaying = false;
@@ -524,6 +538,7 @@ playerProcessMsg (bdjmsgroute_t routefrom, bdjmsgroute_t route,
         case MSG_PLAY_REPEAT: {
           logMsg (LOG_DBG, LOG_MSGS, "got: repeat");
           playerData->repeat = playerData->repeat ? false : true;
+          playerPrerollCancel (playerData);
           playerSendStatus (playerData, STATUS_FORCE);
           break;
         }
@@ -559,6 +574,7 @@ playerProcessMsg (bdjmsgroute_t routefrom, bdjmsgroute_t route,
         }
         case MSG_PLAY_STOP: {
           logMsg (LOG_DBG, LOG_MSGS, "got: stop");
+          playerPrerollCancel (playerData);
           playerStop (playerData);
           playerData->pauseAtEnd = false;
           playerSendPauseAtEndState (playerData);
@@ -705,7 +721,6 @@ playerProcessing (void *udata)
     int           tspeed;
     int           taudiosrc;
 
-
     temprepeat = playerData->repeat;
 
     pq = playerData->currentSong;
@@ -772,25 +787,16 @@ playerProcessing (void *udata)
       logMsg (LOG_DBG, LOG_VOLUME, "no fade-in set volume: %d", playerData->realVolume);
     }
 
-    /* duplicate the media path */
-    stpecpy (tempffn, tempffn + sizeof (tempffn), pq->tempname);
-
-    /* only need to know if this is a file-type */
-    if (pq->audiosrc == AUDIOSRC_TYPE_FILE) {
-      /* some pli need the full path */
-      pathbldMakePath (tempffn, sizeof (tempffn), pq->tempname, "",
-          PATHBLD_MP_DIR_DATATOP);
-    }
-
-    taudiosrc = pq->audiosrc;
-    if (taudiosrc == AUDIOSRC_TYPE_BDJ4) {
-      taudiosrc = AUDIOSRC_TYPE_FILE;
-    }
+    taudiosrc = playerMediaPath (pq, tempffn, sizeof (tempffn));
     if (playerData->playerState == PL_STATE_IN_CROSSFADE) {
       pliCrossFade (playerData->pli, pq->tempname, tempffn, taudiosrc);
     } else {
+      /* if this song was pre-rolled, the pli will use the */
+      /* pre-rolled source (which may already be playing) */
       pliMediaSetup (playerData->pli, pq->tempname, tempffn, taudiosrc);
     }
+    playerData->prerolled = false;
+    playerData->prerollUniqueidx = -1;
     /* pq->songstart is normalized */
 
     tspeed = pq->speed;
@@ -883,6 +889,13 @@ playerProcessing (void *udata)
       }
     }
 
+    if (playerData->playerState == PL_STATE_PLAYING &&
+        ! playerData->prerolled &&
+        mstimeCheck (&playerData->prerollTimeCheck)) {
+      mstimeset (&playerData->prerollTimeCheck, TM_TIMER_OFF);
+      playerPreroll (playerData);
+    }
+
     if (playerData->stopPlaying ||
         mstimeCheck (&playerData->playTimeCheck)) {
       int32_t     plitm;
@@ -902,10 +915,11 @@ playerProcessing (void *udata)
       /* timestamp and the real duration, not adjusted values. */
       /* pq->dur is adjusted for the speed. */
       /* pli-time cannot be used in conjunction with pq->dur */
+      /* if the next song is pre-rolled, wait for the pli to stop */
       if (plistate == PLI_STATE_STOPPED ||
           plistate == PLI_STATE_ERROR ||
           playerData->stopPlaying ||
-          plitm >= pq->plidur ||
+          (! playerData->prerolled && plitm >= pq->plidur) ||
           mstimeCheck (&playerData->playEndCheck)) {
         char  nsflag [20];
 
@@ -1178,6 +1192,10 @@ playerSongClearPrep (playerdata_t *playerData, char *args)
     return;
   }
 
+  if (playerData->prerolled && uniqueidx == playerData->prerollUniqueidx) {
+    playerPrerollCancel (playerData);
+  }
+
   tpq = playerLocatePreppedSong (playerData, uniqueidx, p, true);
   if (tpq != NULL) {
     tpq = queueIterateRemoveNode (playerData->prepQueue, &playerData->prepiteridx);
@@ -1451,6 +1469,7 @@ playerPause (playerdata_t *playerData)
     return;
   }
 
+  playerPrerollCancel (playerData);
   plistate = pliState (playerData->pli);
 
   if (playerData->inFadeOut) {
@@ -1511,6 +1530,7 @@ playerNextSong (playerdata_t *playerData)
 
   logProcBegin ();
 
+  playerPrerollCancel (playerData);
   playerData->repeat = false;
   playerData->priorGap = playerData->gap;
   playerData->gap = 0;
@@ -1567,6 +1587,7 @@ playerPauseAtEnd (playerdata_t *playerData)
   logProcBegin ();
 
   playerData->pauseAtEnd = playerData->pauseAtEnd ? false : true;
+  playerPrerollCancel (playerData);
   playerSendPauseAtEndState (playerData);
   logProcEnd ("");
 }
@@ -1609,6 +1630,7 @@ playerFade (playerdata_t *playerData)
     return;
   }
 
+  playerPrerollCancel (playerData);
   if (playerData->fadeoutTime == 0) {
     playerCheckSystemVolume (playerData);
     playerData->stopPlaying = true;
@@ -1659,6 +1681,7 @@ playerSpeed (playerdata_t *playerData, char *trate)
 static void
 playerChangeSpeed (playerdata_t *playerData, int speed)
 {
+  playerPrerollCancel (playerData);
   pliRate (playerData->pli, (ssize_t) speed);
   playerData->currentSpeed = (ssize_t) speed;
   playerData->speedWaitChg = false;
@@ -1695,6 +1718,7 @@ playerSeek (playerdata_t *playerData, int64_t reqpos, int32_t interval)
   seekpos = reqpos;
   seekpos = songutilNormalizePosition (seekpos, pq->speed);
   seekpos += pq->songstart;
+  playerPrerollCancel (playerData);
   pliSeek (playerData->pli, seekpos);
   playerData->playTimePlayed = reqpos;
   playerSetCheckTimes (playerData, pq);
@@ -2126,6 +2150,11 @@ playerSetCheckTimes (playerdata_t *playerData, prepqueue_t *pq)
   if (pq->announce == PREP_SONG && playerData->fadeoutTime > 0) {
     mstimeset (&playerData->fadeTimeCheck, newdur - playerData->fadeoutTime);
   }
+  mstimeset (&playerData->prerollTimeCheck, TM_TIMER_OFF);
+  if (pq->announce == PREP_SONG &&
+      pliCheckSupport (playerData->pliSupported, PLI_SUPPORT_PREROLL)) {
+    mstimeset (&playerData->prerollTimeCheck, newdur - PLAYER_PREROLL_TIME);
+  }
   logMsg (LOG_DBG, LOG_INFO, "pq->dur: %" PRId32, pq->dur);
   logMsg (LOG_DBG, LOG_INFO, "newdur: %" PRId32, newdur);
   logMsg (LOG_DBG, LOG_INFO, "playTimeStart: %" PRId64, (int64_t) mstimeend (&playerData->playTimeStart));
@@ -2135,6 +2164,111 @@ playerSetCheckTimes (playerdata_t *playerData, prepqueue_t *pq)
   logProcEnd ("");
 }
 
+/* returns the audio-source type to pass to the pli */
+static int
+playerMediaPath (prepqueue_t *pq, char *tempffn, size_t sz)
+{
+  int     taudiosrc;
+
+  /* duplicate the media path */
+  stpecpy (tempffn, tempffn + sz, pq->tempname);
+
+  /* only need to know if this is a file-type */
+  if (pq->audiosrc == AUDIOSRC_TYPE_FILE) {
+    /* some pli need the full path */
+    pathbldMakePath (tempffn, sz, pq->tempname, "",
+        PATHBLD_MP_DIR_DATATOP);
+  }
+
+  taudiosrc = pq->audiosrc;
+  if (taudiosrc == AUDIOSRC_TYPE_BDJ4) {
+    taudiosrc = AUDIOSRC_TYPE_FILE;
+  }
+
+  return taudiosrc;
+}
+
+/* gapless playback */
+/* if the current song plays through to its end, and the next song */
+/* will start immediately with no gap or fades, the next song is */
+/* pre-rolled in the pli, and the pli switches to it at the end */
+/* of the current song. */
+/* the next song is the first song in the prep queue. */
+/* main sends the play request as usual when the current song finishes, */
+/* if it is not the pre-rolled song, the pli discards the pre-roll. */
+static void
+playerPreroll (playerdata_t *playerData)
+{
+  prepqueue_t   *pq = playerData->currentSong;
+  prepqueue_t   *npq = NULL;
+  prepqueue_t   *tpq;
+  qidx_t        iteridx;
+  char          tempffn [BDJ4_PATH_MAX];
+  int           taudiosrc;
+  int32_t       tdur;
+
+  if (pq == NULL || pq->announce != PREP_SONG) {
+    return;
+  }
+
+  if (playerData->gap > 0 ||
+      playerData->fadeinTime > 0 ||
+      playerData->fadeoutTime > 0 ||
+      playerData->crossFadeTime > 0 ||
+      playerData->inFade ||
+      playerData->pauseAtEnd ||
+      playerData->repeat ||
+      playerData->stopPlaying ||
+      playerData->currentSpeed != 100) {
+    return;
+  }
+
+  /* the song must play through to the end of the audio */
+  tdur = pliGetDuration (playerData->pli);
+  if (tdur <= 0 || pq->songstart + pq->dur < tdur - PLAYER_PREROLL_GRACE) {
+    return;
+  }
+
+  /* if announcements are in use, the next item to be played */
+  /* is not known */
+  queueStartIterator (playerData->prepQueue, &iteridx);
+  while ((tpq = queueIterateData (playerData->prepQueue, &iteridx)) != NULL) {
+    if (tpq->announce == PREP_ANNOUNCE) {
+      return;
+    }
+    if (npq == NULL) {
+      npq = tpq;
+    }
+  }
+
+  if (npq == NULL || npq->songstart > 0 || npq->speed != 100) {
+    return;
+  }
+
+  taudiosrc = playerMediaPath (npq, tempffn, sizeof (tempffn));
+  logMsg (LOG_DBG, LOG_BASIC, "pre-roll: %" PRId32 " %s", npq->uniqueidx, npq->songname);
+  pliMediaPreroll (playerData->pli, npq->tempname, tempffn, taudiosrc);
+  playerData->prerolled = true;
+  playerData->prerollUniqueidx = npq->uniqueidx;
+
+  /* the pli will report the stop at the end-of-stream */
+  mstimeset (&playerData->playEndCheck,
+      - mstimeend (&playerData->playEndCheck) + PLAYER_PREROLL_GRACE);
+}
+
+static void
+playerPrerollCancel (playerdata_t *playerData)
+{
+  if (! playerData->prerolled) {
+    return;
+  }
+
+  logMsg (LOG_DBG, LOG_BASIC, "pre-roll cancel: %" PRId32, playerData->prerollUniqueidx);
+  pliMediaPreroll (playerData->pli, NULL, NULL, AUDIOSRC_TYPE_FILE);
+  playerData->prerolled = false;
+  playerData->prerollUniqueidx = -1;
+}
+
 static void
 playerSetPlayerState (playerdata_t *playerData, playerstate_t pstate)
 {
@@ -2407,6 +2541,7 @@ playerChkClearPrepQ (playerdata_t *playerData)
   int         activecount;
   int         count;
 
+  playerPrerollCancel (playerData);
   queueClear (playerData->prepQueue, 0);
   count = 0;
   activecount = playerCheckPrepThreads (playerData);
@@ -47,6 +47,7 @@ typedef struct {
   char            *playlistNames;
   char            *playerStatus;
   char            *currSong;
+  char            *statusData;
   websrv_t        *websrv;
   bool            enabled;
 } remctrl_t;
@@ -63,6 +64,7 @@ static int      remctrlProcessMsg (bdjmsgroute_t routefrom, bdjmsgroute_t route,
 static int      remctrlProcessing (void *udata);
 static void     remctrlProcessDanceList (remctrl_t *remctrl, char *danceList);
 static void     remctrlProcessPlaylistNames (remctrl_t *remctrl, char *playlistNames);
+static void     remctrlUpdateStatus (remctrl_t *remctrl);
 static void     remctrlSigHandler (int sig);
 
 static int  gKillReceived = 0;
@@ -95,6 +97,7 @@ main (int argc, char *argv[])
   remctrl.pass = mdstrdup (bdjoptGetStr (OPT_P_REMCONTROLPASS));
   remctrl.playerStatus = NULL;
   remctrl.currSong = NULL;
+  remctrl.statusData = NULL;
   remctrl.playlistNames = "";
   mstimeset (&remctrl.playlistNamesTimer, 0);
   remctrl.port = bdjoptGetNum (OPT_P_REMCONTROLPORT);
@@ -167,6 +170,7 @@ remctrlClosingCallback (void *udata, programstate_t programState)
   dataFree (remctrl->pass);
   dataFree (remctrl->playerStatus);
   dataFree (remctrl->currSong);
+  dataFree (remctrl->statusData);
   if (*remctrl->danceList) {
     dataFree (remctrl->danceList);
   }
@@ -199,29 +203,20 @@ remctrlEventHandler (void *userdata, const char *query, const char *uri)
         "WWW-Authenticate: Basic realm=BDJ4 Remote\r\n",
         WEB_RESP_UNAUTH);
   } else if (strcmp (uri, "/getstatus") == 0) {
-    if (remctrl->playerStatus == NULL || remctrl->currSong == NULL) {
+    if (remctrl->statusData == NULL) {
       websrvReply (remctrl->websrv, WEB_NO_CONTENT,
           "Content-type: text/plain; charset=utf-8\r\n"
           "Cache-Control: max-age=0\r\n",
           WEB_RESP_NO_CONTENT);
     } else {
-      char    *jsbuff;
-      char    *jp;
-      char    *jend;
-
-      jsbuff = mdmalloc (BDJMSG_MAX);
-      *jsbuff = '\0';
-      jp = jsbuff;
-      jend = jsbuff + BDJMSG_MAX;
-
-      jp = stpecpy (jp, jend, remctrl->playerStatus);
-      jp = stpecpy (jp, jend, remctrl->currSong);
-
       websrvReply (remctrl->websrv, WEB_OK,
           "Content-type: text/plain; charset=utf-8\r\n"
-          "Cache-Control: max-age=0\r\n", jsbuff);
-      dataFree (jsbuff);
+          "Cache-Control: max-age=0\r\n",
+          remctrl->statusData);
     }
+  } else if (strcmp (uri, "/getevents") == 0) {
+    /* the status is pushed to the client whenever it changes */
+    websrvStreamStart (remctrl->websrv, remctrl->statusData);
   } else if (strcmp (uri, "/getcurrsong") == 0) {
     if (remctrl->currSong == NULL) {
       websrvReply (remctrl->websrv, WEB_NO_CONTENT,
@@ -401,11 +396,13 @@ remctrlProcessMsg (bdjmsgroute_t routefrom, bdjmsgroute_t route,
         case MSG_PLAYER_STATUS_DATA: {
           dataFree (remctrl->playerStatus);
           remctrl->playerStatus = mdstrdup (args);
+          remctrlUpdateStatus (remctrl);
           break;
         }
         case MSG_CURR_SONG_DATA: {
           dataFree (remctrl->currSong);
           remctrl->currSong = mdstrdup (args);
+          remctrlUpdateStatus (remctrl);
           break;
         }
         default: {
@@ -579,6 +576,40 @@ remctrlProcessPlaylistNames (remctrl_t *remctrl, char *playlistNames)
   remctrl->playlistNames = mdstrdup (obuff);
 }
 
+/* the status is put together once when either piece changes, */
+/* and is only pushed to the stream clients if it is different */
+static void
+remctrlUpdateStatus (remctrl_t *remctrl)
+{
+  char    *jsbuff;
+  char    *jp;
+  char    *jend;
+
+  if (remctrl->playerStatus == NULL || remctrl->currSong == NULL) {
+    return;
+  }
+
+  jsbuff = mdmalloc (BDJMSG_MAX);
+  *jsbuff = '\0';
+  jp = jsbuff;
+  jend = jsbuff + BDJMSG_MAX;
+
+  jp = stpecpy (jp, jend, remctrl->playerStatus);
+  jp = stpecpy (jp, jend, remctrl->currSong);
+
+  if (remctrl->statusData != NULL &&
+      strcmp (remctrl->statusData, jsbuff) == 0) {
+    mdfree (jsbuff);
+    return;
+  }
+
+  dataFree (remctrl->statusData);
+  remctrl->statusData = mdstrdup (jsbuff);
+  mdfree (jsbuff);
+
+  websrvStreamSend (remctrl->websrv, remctrl->statusData);
+}
+
 
 static void
 remctrlSigHandler (int sig)
@@ -59,6 +59,7 @@
 #include "uiquickedit.h"
 #include "uiexppl.h"
 #include "uiextreq.h"
+#include "uisong.h"
 #include "uisongfilter.h"
 #include "uisongsel.h"
 #include "uiutils.h"
@@ -1132,6 +1133,7 @@ pluiProcessMsg (bdjmsgroute_t routefrom, bdjmsgroute_t route,
 
           msgparseDBEntryUpdate (args, &dbidx);
           dbLoadEntry (plui->musicdb, dbidx);
+          uisongCacheInvalidate (dbidx);
           /* the grouping must be re-built when a song is saved */
           groupingRebuild (plui->grouping, plui->musicdb);
           uisongselPopulateData (plui->uisongsel);
@@ -1807,6 +1809,7 @@ pluiSongSaveCallback (void *udata, int32_t dbidx)
   }
 
   songdbWriteDB (plui->songdb, dbidx, false);
+  uisongCacheInvalidate (dbidx);
 
   /* the database has been updated, tell the other processes to reload  */
   /* this particular entry */
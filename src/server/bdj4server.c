@@ -38,6 +38,7 @@
 #include "sock.h"
 #include "sockh.h"
 #include "songlist.h"
+#include "srvutil.h"
 #include "sysvars.h"
 #include "tagdef.h"
 #include "tmutil.h"
@@ -46,8 +47,20 @@
 #define SRV_URI_TEXT  "uri="
 enum {
   SRV_URI_LEN = strlen (SRV_URI_TEXT),
+  /* the cache is cleared when it gets this large */
+  SRV_CACHE_MAX = 1000,
 };
 
+/* a cached response is valid while its source file (if any) */
+/* and the database are unchanged */
+typedef struct {
+  websrvpayload_t *payload;
+  int64_t         size;
+  time_t          mtime;
+  int32_t         dbgen;
+  bool            valid;
+} bdjsrvcache_t;
+
 typedef struct {
   musicdb_t       *musicdb;
   conn_t          *conn;
@@ -58,9 +71,11 @@ typedef struct {
   const char      *pass;
   websrv_t        *websrv;
   slist_t         *plNames;
+  slist_t         *respcache;
   char            srvuri [BDJ4_PATH_MAX];
   size_t          srvurilen;
   int             stopwaitcount;
+  int32_t         dbgen;
   uint16_t        port;
   bool            bdj4enabled;
 } bdjsrv_t;
@@ -75,6 +90,10 @@ static int  bdjsrvProcessing (void *udata);
 static void bdjsrvSigHandler (int sig);
 static void bdjsrvGetPlaylistNames (bdjsrv_t *bdjsrv);
 static const char * bdjsrvStrip (bdjsrv_t *bdjsrv, const char *query);
+static bdjsrvcache_t *bdjsrvCacheGet (bdjsrv_t *bdjsrv, const char *uri, const char *arg, const char *fn);
+static void bdjsrvCacheReply (bdjsrv_t *bdjsrv, bdjsrvcache_t *cache, const char *data);
+static void bdjsrvCacheFree (void *data);
+static void bdjsrvBatch (bdjsrv_t *bdjsrv);
 
 static int  gKillReceived = 0;
 
@@ -120,6 +139,8 @@ main (int argc, char *argv[])
 
   bdjsrv.progstate = progstateInit ("bdjsrv");
   bdjsrv.plNames = NULL;
+  bdjsrv.respcache = slistAlloc ("srv-resp-cache", LIST_ORDERED, bdjsrvCacheFree);
+  bdjsrv.dbgen = 0;
   bdjsrv.websrv = NULL;
   bdjsrv.stopwaitcount = 0;
 
@@ -177,6 +198,7 @@ bdjsrvClosingCallback (void *udata, programstate_t programState)
 
   bdj4shutdown (ROUTE_SERVER, bdjsrv->musicdb);
   slistFree (bdjsrv->plNames);
+  slistFree (bdjsrv->respcache);
   websrvFree (bdjsrv->websrv);
 
   return STATE_FINISHED;
@@ -213,12 +235,22 @@ bdjsrvEventHandler (void *userdata, const char *query, const char *uri)
         "Cache-Control: max-age=0\r\n",
         "");
   } else if (strcmp (uri, "/plnames") == 0) {
-    const char  *plnm = NULL;
-    char        tbuff [200];
-    char        *rbuff;
-    char        *rp;
-    char        *rend;
-    slistidx_t  iteridx;
+    const char    *plnm = NULL;
+    char          tbuff [200];
+    char          tfn [BDJ4_PATH_MAX];
+    char          *rbuff;
+    char          *rp;
+    char          *rend;
+    slistidx_t    iteridx;
+    bdjsrvcache_t *cache;
+
+    /* a playlist being added or removed changes the directory */
+    pathbldMakePath (tfn, sizeof (tfn), "", "", PATHBLD_MP_DREL_DATA);
+    cache = bdjsrvCacheGet (bdjsrv, uri, "", tfn);
+    if (cache->valid) {
+      bdjsrvCacheReply (bdjsrv, cache, NULL);
+      return;
+    }
 
     bdjsrvGetPlaylistNames (bdjsrv);
 
@@ -237,21 +269,19 @@ bdjsrvEventHandler (void *userdata, const char *query, const char *uri)
       rp = stpecpy (rp, rend, tbuff);
     }
 
-    websrvReply (bdjsrv->websrv, WEB_OK,
-        "Content-type: text/plain; charset=utf-8\r\n"
-        "Cache-Control: max-age=0\r\n",
-        rbuff);
+    bdjsrvCacheReply (bdjsrv, cache, rbuff);
     dataFree (rbuff);
   } else if (strcmp (uri, "/plget") == 0) {
-    bool        ok = false;
-    const char  *plnm = NULL;
-    songlist_t  *sl;
-    char        tbuff [BDJ4_PATH_MAX];
-    char        *rbuff;
-    char        *rp;
-    char        *rend;
-    ilistidx_t  iteridx;
-    ilistidx_t  idx;
+    bool          ok = false;
+    const char    *plnm = NULL;
+    songlist_t    *sl;
+    char          tbuff [BDJ4_PATH_MAX];
+    char          *rbuff;
+    char          *rp;
+    char          *rend;
+    ilistidx_t    iteridx;
+    ilistidx_t    idx;
+    bdjsrvcache_t *cache;
 
     plnm = bdjsrvStrip (bdjsrv, query);
     ok = playlistExists (plnm);
@@ -265,6 +295,14 @@ bdjsrvEventHandler (void *userdata, const char *query, const char *uri)
       return;
     }
 
+    pathbldMakePath (tbuff, sizeof (tbuff), plnm,
+        BDJ4_SONGLIST_EXT, PATHBLD_MP_DREL_DATA);
+    cache = bdjsrvCacheGet (bdjsrv, uri, plnm, tbuff);
+    if (cache->valid) {
+      bdjsrvCacheReply (bdjsrv, cache, NULL);
+      return;
+    }
+
     rbuff = mdmalloc (BDJMSG_MAX);
     rbuff [0] = '\0';
     rp = rbuff;
@@ -281,10 +319,8 @@ bdjsrvEventHandler (void *userdata, const char *query, const char *uri)
       rp = stpecpy (rp, rend, tbuff);
     }
 
-    websrvReply (bdjsrv->websrv, WEB_OK,
-        "Content-type: text/plain; charset=utf-8\r\n"
-        "Cache-Control: max-age=0\r\n",
-        rbuff);
+    bdjsrvCacheReply (bdjsrv, cache, rbuff);
+    dataFree (rbuff);
     songlistFree (sl);
   } else if (strcmp (uri, "/songexists") == 0) {
     bool        ok = false;
@@ -328,15 +364,18 @@ bdjsrvEventHandler (void *userdata, const char *query, const char *uri)
     bool        ok;
     const char  *songuri;
     song_t      *song = NULL;
-    slist_t     *songtags;
-    slistidx_t  iteridx;
-    const char  *tag;
-    char        tbuff [BDJ4_PATH_MAX];
     char        *rbuff;
-    char        *rp;
-    char        *rend;
+    bdjsrvcache_t *cache;
 
     songuri = bdjsrvStrip (bdjsrv, query);
+
+    /* the song tags only change with the database */
+    cache = bdjsrvCacheGet (bdjsrv, uri, songuri, NULL);
+    if (cache->valid) {
+      bdjsrvCacheReply (bdjsrv, cache, NULL);
+      return;
+    }
+
     ok = audiosrcExists (songuri);
 
     if (ok) {
@@ -354,41 +393,13 @@ bdjsrvEventHandler (void *userdata, const char *query, const char *uri)
 
     rbuff = mdmalloc (BDJMSG_MAX);
     rbuff [0] = '\0';
-    rp = rbuff;
-    rend = rbuff + BDJMSG_MAX;
-
-    songtags = songTagList (song);
-    slistStartIterator (songtags, &iteridx);
-    while ((tag = slistIterateKey (songtags, &iteridx)) != NULL) {
-      const char  *value;
-
-      if (strcmp (tag, tagdefs [TAG_URI].tag) == 0) {
-        /* this will be re-set by the caller */
-        continue;
-      }
-      if (strcmp (tag, tagdefs [TAG_PREFIX_LEN].tag) == 0) {
-        continue;
-      }
-      if (strcmp (tag, tagdefs [TAG_SAMESONG].tag) == 0) {
-        /* same-song is specific to the database, do not copy over */
-        continue;
-      }
+    srvutilSongTagData (song, rbuff, rbuff + BDJMSG_MAX, NULL);
 
-      value = slistGetStr (songtags, tag);
-      // logMsg (LOG_DBG, LOG_INFO, "song-tags: add %s %s", tag, value);
-      if (value != NULL && *value) {
-        snprintf (tbuff, sizeof (tbuff), "%s%c%s%c",
-            tag, MSG_ARGS_RS, value, MSG_ARGS_RS);
-        rp = stpecpy (rp, rend, tbuff);
-      }
-    }
-
-    websrvReply (bdjsrv->websrv, WEB_OK,
-        "Content-type: text/plain; charset=utf-8\r\n"
-        "Cache-Control: max-age=0\r\n",
-        rbuff);
-    slistFree (songtags);
+    bdjsrvCacheReply (bdjsrv, cache, rbuff);
+    dataFree (rbuff);
     return;
+  } else if (strcmp (uri, "/songtagsbatch") == 0) {
+    bdjsrvBatch (bdjsrv);
   } else {
     char          path [BDJ4_PATH_MAX];
     const char    *turi = uri;
@@ -437,18 +448,22 @@ bdjsrvProcessMsg (bdjmsgroute_t routefrom, bdjmsgroute_t route,
 
           msgparseDBEntryUpdate (args, &dbidx);
           dbLoadEntry (bdjsrv->musicdb, dbidx);
+          ++bdjsrv->dbgen;
           break;
         }
         case MSG_DB_ENTRY_REMOVE: {
           dbMarkEntryRemoved (bdjsrv->musicdb, atoll (args));
+          ++bdjsrv->dbgen;
           break;
         }
         case MSG_DB_ENTRY_UNREMOVE: {
           dbClearEntryRemoved (bdjsrv->musicdb, atoll (args));
+          ++bdjsrv->dbgen;
           break;
         }
         case MSG_DB_RELOAD: {
           bdjsrv->musicdb = bdj4ReloadDatabase (bdjsrv->musicdb);
+          ++bdjsrv->dbgen;
           break;
         }
         default: {
@@ -531,3 +546,99 @@ bdjsrvStrip (bdjsrv_t *bdjsrv, const char *query)
   }
   return songuri;
 }
+
+/* returns the cache entry for the request, creating it if needed. */
+/* the entry is marked invalid if the file or the database has changed */
+/* since the response was built. */
+static bdjsrvcache_t *
+bdjsrvCacheGet (bdjsrv_t *bdjsrv, const char *uri, const char *arg,
+    const char *fn)
+{
+  bdjsrvcache_t *cache;
+  fileopinfo_t  info;
+  char          key [BDJ4_PATH_MAX];
+
+  snprintf (key, sizeof (key), "%s%c%s", uri, MSG_ARGS_RS, arg);
+
+  info.size = 0;
+  info.mtime = 0;
+  if (fn != NULL) {
+    fileopGetInfo (fn, &info);
+  }
+
+  cache = slistGetData (bdjsrv->respcache, key);
+  if (cache == NULL) {
+    if (slistGetCount (bdjsrv->respcache) >= SRV_CACHE_MAX) {
+      slistFree (bdjsrv->respcache);
+      bdjsrv->respcache = slistAlloc ("srv-resp-cache",
+          LIST_ORDERED, bdjsrvCacheFree);
+    }
+    cache = mdmalloc (sizeof (bdjsrvcache_t));
+    cache->payload = websrvPayloadAlloc ();
+    cache->valid = false;
+    slistSetData (bdjsrv->respcache, key, cache);
+  }
+
+  if (cache->valid &&
+      (cache->size != info.size ||
+      cache->mtime != info.mtime ||
+      cache->dbgen != bdjsrv->dbgen)) {
+    cache->valid = false;
+  }
+
+  if (! cache->valid) {
+    cache->size = info.size;
+    cache->mtime = info.mtime;
+    cache->dbgen = bdjsrv->dbgen;
+  }
+
+  return cache;
+}
+
+/* if data is set, the response is stored first */
+static void
+bdjsrvCacheReply (bdjsrv_t *bdjsrv, bdjsrvcache_t *cache, const char *data)
+{
+  if (data != NULL) {
+    websrvPayloadSet (cache->payload, data, strlen (data));
+    /* a file modified within the last second may change again */
+    /* without a change to its modification time */
+    cache->valid = cache->mtime < time (NULL) - 1;
+  }
+
+  websrvReplyPayload (bdjsrv->websrv,
+      "Content-type: text/plain; charset=utf-8\r\n"
+      "Cache-Control: no-cache\r\n",
+      cache->payload);
+}
+
+static void
+bdjsrvCacheFree (void *data)
+{
+  bdjsrvcache_t *cache = data;
+
+  if (cache == NULL) {
+    return;
+  }
+
+  websrvPayloadFree (cache->payload);
+  mdfree (cache);
+}
+
+/* the batch request has a list of song uris separated by MSG_ARGS_RS. */
+/* a missing song is reported in the reply, so the batch also serves */
+/* as the existence check. */
+static void
+bdjsrvBatch (bdjsrv_t *bdjsrv)
+{
+  char        *body;
+
+  body = websrvGetBody (bdjsrv->websrv);
+  if (body == NULL) {
+    return;
+  }
+
+  srvutilSongTagsBatch (bdjsrv->websrv, bdjsrv->musicdb,
+      (char *) bdjsrvStrip (bdjsrv, body));
+  mdfree (body);
+}
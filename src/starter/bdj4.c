@@ -113,8 +113,10 @@ main (int argc, char * argv[])
     { "pli",            required_argument,  NULL,   'P' },
     { "wait",           no_argument,        NULL,   'w' },
     /* dbupdate options */
+    { "bpm",            no_argument,        NULL,   0 },
     { "checknew",       no_argument,        NULL,   0 },
     { "compact",        no_argument,        NULL,   0 },
+    { "loudness",       no_argument,        NULL,   0 },
     { "musicdir",       required_argument,  NULL,   0 },
     { "rebuild",        no_argument,        NULL,   0 },
     { "reorganize",     no_argument,        NULL,   0 },
@@ -846,6 +846,7 @@ starterMainLoop (void *tstarter)
 
   /* will connect to any process from which handshakes have been received */
   connProcessUnconnected (starter->conn);
+  procutilCheckHandshake (starter->processes, starter->conn);
 
   /* try to connect if not connected */
   for (int route = 0; route < ROUTE_MAX; ++route) {
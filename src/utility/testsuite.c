@@ -82,6 +82,7 @@ typedef struct {
   slist_t     *routetxtlist;
   slist_t     *msgtxtlist;
   long        responseTimeout;
+  long        chkTimeout;
   mstime_t    responseStart;
   mstime_t    responseTimeoutCheck;
   bdjmsgroute_t waitRoute;
@@ -213,6 +214,7 @@ main (int argc, char *argv [])
   testsuite.chkexpect = NULL;
   mstimeset (&testsuite.responseStart, 0);
   testsuite.responseTimeout = 8000;
+  testsuite.chkTimeout = TS_CHK_TIMEOUT;
   mstimeset (&testsuite.responseTimeoutCheck, TS_CHK_TIMEOUT);
   *testsuite.sectionnum = '\0';
   *testsuite.sectionname = '\0';
@@ -706,6 +708,11 @@ tsProcessScript (testsuite_t *testsuite)
       ok = TS_OK;
       disp = true;
     }
+    if (strncmp (tcmd, "chktimeout", 10) == 0) {
+      testsuite->chkTimeout = atol (tcmd + 11);
+      ok = TS_OK;
+      disp = true;
+    }
     if (strncmp (tcmd, "msg", 3) == 0) {
       ok = tsScriptMsg (testsuite, tcmd);
       disp = true;
@@ -715,7 +722,8 @@ tsProcessScript (testsuite_t *testsuite)
       disp = true;
     }
     /* chk, chk-or, chk-lt, chk-gt, chk-not */
-    if (strncmp (tcmd, "chk", 3) == 0) {
+    if (strncmp (tcmd, "chk", 3) == 0 &&
+        strncmp (tcmd, "chktimeout", 10) != 0) {
       ok = tsScriptChk (testsuite, tcmd);
       disp = true;
     }
@@ -981,8 +989,8 @@ tsScriptChk (testsuite_t *testsuite, const char *tcmd)
   }
   testsuite->chkwait = true;
   ++testsuite->results.chkcount;
-  logMsg (LOG_DBG, LOG_BASIC, "[%d] start response timer %d", testsuite->lineno, TS_CHK_TIMEOUT);
-  mstimeset (&testsuite->responseTimeoutCheck, TS_CHK_TIMEOUT);
+  logMsg (LOG_DBG, LOG_BASIC, "[%d] start response timer %ld", testsuite->lineno, testsuite->chkTimeout);
+  mstimeset (&testsuite->responseTimeoutCheck, testsuite->chkTimeout);
   mstimeset (&testsuite->responseStart, 0);
   return TS_OK;
 }
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "audiosrc.h"
+#include "bdj4.h"
+#include "bdj4arg.h"
+#include "bdjopt.h"
+#include "bdjvars.h"
+#include "bdjvarsdfload.h"
+#include "fileop.h"
+#include "itunes.h"
+#include "localeutil.h"
+#include "log.h"
+#include "mdebug.h"
+#include "sysvars.h"
+#include "tagdef.h"
+#include "tmutil.h"
+
+#define ITBENCH_FN  "tmp/titunesbench.xml"
+
+enum {
+  ITBENCH_PL_SIZE = 40,
+};
+
+static const char *itbenchgenres [] = {
+  "Waltz", "Tango", "Foxtrot", "Quickstep", "Rumba", "Cha Cha", "Jive",
+};
+enum {
+  ITBENCH_GENRE_MAX = sizeof (itbenchgenres) / sizeof (const char *),
+};
+
+static bool itbenchGenerate (const char *fn, int tracks, int playlists);
+
+/* generates an itunes xml file with the specified number of tracks */
+/* and playlists, and measures the time taken to parse it. */
+/* e.g. titunesbench --bdj4 100000 500 */
+int
+main (int argc, char *argv [])
+{
+  itunes_t      *itunes;
+  bool          isbdj4 = false;
+  bool          keep = false;
+  int           tracks = 0;
+  int           playlists = 0;
+  int           argcount = 0;
+  int           songcount = 0;
+  int           plcount = 0;
+  int           c;
+  int           option_index;
+  int           rc = 0;
+  mstime_t      tm;
+  time_t        elapsed;
+  ssize_t       sz;
+  bdj4arg_t     *bdj4arg;
+  const char    *targ;
+
+  static struct option bdj_options [] = {
+    { "bdj4",         no_argument,      NULL,   'B' },
+    { "titunesbench", no_argument,      NULL,   0 },
+    { "keep",         no_argument,      NULL,   'K' },
+    { "debugself",    no_argument,      NULL,   0 },
+    { "wait",         no_argument,      NULL,   0, },
+    { "pli",          required_argument, NULL,   0, },
+    { "nodetach",     no_argument,      NULL,   0, },
+    { "verbose",      no_argument,      NULL,   'V', },
+    { "origcwd",      required_argument,  NULL,   0 },
+  };
+
+#if BDJ4_MEM_DEBUG
+  mdebugInit ("titb");
+#endif
+
+  bdj4arg = bdj4argInit (argc, argv);
+
+  while ((c = getopt_long_only (argc, bdj4argGetArgv (bdj4arg),
+      "BKV", bdj_options, &option_index)) != -1) {
+    switch (c) {
+      case 'B': {
+        isbdj4 = true;
+        break;
+      }
+      case 'K': {
+        keep = true;
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+  }
+
+  if (! isbdj4) {
+    fprintf (stderr, "not started with launcher\n");
+    bdj4argCleanup (bdj4arg);
+    return 1;
+  }
+
+  targ = bdj4argGet (bdj4arg, 0, argv [0]);
+  sysvarsInit (targ, SYSVARS_FLAG_ALL);
+  localeInit ();
+  bdjoptInit ();
+
+  for (int i = optind; i < argc; ++i) {
+    targ = bdj4argGet (bdj4arg, i, argv [i]);
+    if (argcount == 0) {
+      tracks = atoi (targ);
+    }
+    if (argcount == 1) {
+      playlists = atoi (targ);
+    }
+    argcount++;
+  }
+
+  if (argcount < 1 || tracks <= 0) {
+    fprintf (stderr, "Usage: titunesbench [--keep] <tracks> [<playlists>]\n");
+    bdjoptCleanup ();
+    localeCleanup ();
+    bdj4argCleanup (bdj4arg);
+    return 1;
+  }
+
+  logStart ("titunesbench", "titb", LOG_IMPORTANT | LOG_BASIC);
+
+  bdjvarsInit ();
+  tagdefInit ();
+  bdjvarsdfloadInit ();
+  audiosrcInit ();
+
+  if (! itbenchGenerate (ITBENCH_FN, tracks, playlists)) {
+    fprintf (stderr, "unable to create %s\n", ITBENCH_FN);
+    rc = 1;
+  }
+
+  if (rc == 0) {
+    bdjoptSetStr (OPT_M_DIR_ITUNES_MEDIA, "tmp");
+    bdjoptSetStr (OPT_M_ITUNES_XML_FILE, ITBENCH_FN);
+    sz = fileopSize (ITBENCH_FN);
+
+    itunes = itunesAlloc ();
+
+    mstimestart (&tm);
+    if (! itunesParse (itunes)) {
+      fprintf (stderr, "parse failed\n");
+      rc = 1;
+    }
+    elapsed = mstimeend (&tm);
+    if (elapsed <= 0) {
+      elapsed = 1;
+    }
+
+    for (int i = 0; i < tracks; ++i) {
+      if (itunesGetSongData (itunes, i + 1) != NULL) {
+        ++songcount;
+      }
+    }
+    itunesStartIteratePlaylists (itunes);
+    while (itunesIteratePlaylists (itunes) != NULL) {
+      ++plcount;
+    }
+
+    fprintf (stdout, "size: %zd bytes songs: %d playlists: %d\n",
+        sz, songcount, plcount);
+    fprintf (stdout, "time: %ld ms MB/sec: %.1f\n",
+        (long) elapsed,
+        (double) sz / (1024.0 * 1024.0) * 1000.0 / (double) elapsed);
+
+    itunesFree (itunes);
+  }
+
+  if (! keep) {
+    fileopDelete (ITBENCH_FN);
+  }
+
+  audiosrcCleanup ();
+  bdjvarsdfloadCleanup ();
+  tagdefCleanup ();
+  bdjvarsCleanup ();
+  logEnd ();
+  bdjoptCleanup ();
+  localeCleanup ();
+  bdj4argCleanup (bdj4arg);
+#if BDJ4_MEM_DEBUG
+  mdebugReport ();
+  mdebugCleanup ();
+#endif
+  return rc;
+}
+
+/* the layout matches the itunes library xml file */
+static bool
+itbenchGenerate (const char *fn, int tracks, int playlists)
+{
+  FILE    *fh;
+
+  fh = fileopOpen (fn, "w");
+  if (fh == NULL) {
+    return false;
+  }
+
+  fprintf (fh, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  fprintf (fh, "<!DOCTYPE plist PUBLIC \"-//Apple Computer//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n");
+  fprintf (fh, "<plist version=\"1.0\">\n<dict>\n");
+  fprintf (fh, "\t<key>Major Version</key><integer>1</integer>\n");
+  fprintf (fh, "\t<key>Minor Version</key><integer>1</integer>\n");
+  fprintf (fh, "\t<key>Application Version</key><string>12.9.5.5</string>\n");
+  fprintf (fh, "\t<key>Show Content Ratings</key><true/>\n");
+  fprintf (fh, "\t<key>Music Folder</key><string>file://localhost/music/</string>\n");
+  fprintf (fh, "\t<key>Tracks</key>\n\t<dict>\n");
+
+  for (int i = 1; i <= tracks; ++i) {
+    fprintf (fh, "\t\t<key>%d</key>\n\t\t<dict>\n", i);
+    fprintf (fh, "\t\t\t<key>Track ID</key><integer>%d</integer>\n", i);
+    fprintf (fh, "\t\t\t<key>Size</key><integer>%d</integer>\n", 3000000 + i);
+    fprintf (fh, "\t\t\t<key>Total Time</key><integer>%d</integer>\n", 180000 + i % 60000);
+    fprintf (fh, "\t\t\t<key>Disc Number</key><integer>1</integer>\n");
+    fprintf (fh, "\t\t\t<key>Track Number</key><integer>%d</integer>\n", i % 20 + 1);
+    fprintf (fh, "\t\t\t<key>Year</key><integer>%d</integer>\n", 1950 + i % 70);
+    fprintf (fh, "\t\t\t<key>BPM</key><integer>%d</integer>\n", 28 + i % 30);
+    fprintf (fh, "\t\t\t<key>Date Modified</key><date>2023-01-03T18:34:58Z</date>\n");
+    fprintf (fh, "\t\t\t<key>Date Added</key><date>2023-01-03T18:34:58Z</date>\n");
+    fprintf (fh, "\t\t\t<key>Bit Rate</key><integer>320</integer>\n");
+    fprintf (fh, "\t\t\t<key>Sample Rate</key><integer>44100</integer>\n");
+    if (i % 3 == 0) {
+      fprintf (fh, "\t\t\t<key>Rating</key><integer>%d</integer>\n", (i % 10 + 1) * 10);
+    }
+    if (i % 7 == 0) {
+      fprintf (fh, "\t\t\t<key>Loved</key><true/>\n");
+    }
+    fprintf (fh, "\t\t\t<key>Persistent ID</key><string>%016X</string>\n", i);
+    fprintf (fh, "\t\t\t<key>Track Type</key><string>File</string>\n");
+    fprintf (fh, "\t\t\t<key>Name</key><string>Title &amp; %d</string>\n", i);
+    fprintf (fh, "\t\t\t<key>Artist</key><string>Artist %d</string>\n", i % 500);
+    fprintf (fh, "\t\t\t<key>Album</key><string>Album %d</string>\n", i / 20);
+    fprintf (fh, "\t\t\t<key>Genre</key><string>%s</string>\n",
+        itbenchgenres [i % ITBENCH_GENRE_MAX]);
+    fprintf (fh, "\t\t\t<key>Kind</key><string>MPEG audio file</string>\n");
+    fprintf (fh, "\t\t\t<key>Location</key><string>file://localhost/music/Artist%%20%d/Album%%20%d/%02d%%20Title%%20%d.mp3</string>\n",
+        i % 500, i / 20, i % 20 + 1, i);
+    fprintf (fh, "\t\t\t<key>File Folder Count</key><integer>5</integer>\n");
+    fprintf (fh, "\t\t\t<key>Library Folder Count</key><integer>1</integer>\n");
+    fprintf (fh, "\t\t</dict>\n");
+  }
+  fprintf (fh, "\t</dict>\n");
+
+  fprintf (fh, "\t<key>Playlists</key>\n\t<array>\n");
+  for (int i = 0; i <= playlists; ++i) {
+    int     count;
+    int     start;
+
+    fprintf (fh, "\t\t<dict>\n");
+    if (i == 0) {
+      fprintf (fh, "\t\t\t<key>Master</key><true/>\n");
+    }
+    fprintf (fh, "\t\t\t<key>Playlist ID</key><integer>%d</integer>\n", tracks + i + 1);
+    fprintf (fh, "\t\t\t<key>Playlist Persistent ID</key><string>%016X</string>\n", tracks + i + 1);
+    fprintf (fh, "\t\t\t<key>All Items</key><true/>\n");
+    if (i == 0) {
+      fprintf (fh, "\t\t\t<key>Visible</key><false/>\n");
+      fprintf (fh, "\t\t\t<key>Name</key><string>Library</string>\n");
+      count = tracks;
+      start = 1;
+    } else {
+      fprintf (fh, "\t\t\t<key>Name</key><string>Playlist %d</string>\n", i);
+      count = ITBENCH_PL_SIZE;
+      start = (i * 97) % tracks + 1;
+    }
+    fprintf (fh, "\t\t\t<key>Playlist Items</key>\n\t\t\t<array>\n");
+    for (int j = 0; j < count; ++j) {
+      fprintf (fh, "\t\t\t\t<dict>\n");
+      fprintf (fh, "\t\t\t\t\t<key>Track ID</key><integer>%d</integer>\n",
+          (start - 1 + j) % tracks + 1);
+      fprintf (fh, "\t\t\t\t</dict>\n");
+    }
+    fprintf (fh, "\t\t\t</array>\n");
+    fprintf (fh, "\t\t</dict>\n");
+  }
+  fprintf (fh, "\t</array>\n");
+  fprintf (fh, "</dict>\n</plist>\n");
+
+  mdextfclose (fh);
+  fclose (fh);
+  return true;
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2021-2026 Brad Lanam Pleasant Hill CA
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "bdj4.h"
+#include "bdj4arg.h"
+#include "bdjopt.h"
+#include "localeutil.h"
+#include "log.h"
+#include "mdebug.h"
+#include "sysvars.h"
+#include "tmutil.h"
+#include "webclient.h"
+
+typedef struct {
+  size_t    bytes;
+  int       count;
+} srvbench_t;
+
+static void srvbenchCallback (void *userdata, const char *resp, size_t len, time_t tm);
+
+/* measures the requests per second that a bdj4 server can handle */
+/* for a single uri. */
+/* e.g. tsrvbench --bdj4 https://localhost:9011/plnames 1000 user pass */
+int
+main (int argc, char *argv [])
+{
+  webclient_t   *webclient;
+  srvbench_t    sb;
+  bool          isbdj4 = false;
+  const char    *uri = NULL;
+  const char    *user = NULL;
+  const char    *pass = NULL;
+  int           maxcount = 0;
+  int           argcount = 0;
+  int           errcount = 0;
+  int           c;
+  int           option_index;
+  int           rc;
+  mstime_t      tm;
+  time_t        elapsed;
+  bdj4arg_t     *bdj4arg;
+  const char    *targ;
+
+  static struct option bdj_options [] = {
+    { "bdj4",         no_argument,      NULL,   'B' },
+    { "tsrvbench",    no_argument,      NULL,   0 },
+    { "debugself",    no_argument,      NULL,   0 },
+    { "wait",         no_argument,      NULL,   0, },
+    { "pli",          required_argument, NULL,   0, },
+    { "nodetach",     no_argument,      NULL,   0, },
+    { "verbose",      no_argument,      NULL,   'V', },
+    { "origcwd",      required_argument,  NULL,   0 },
+  };
+
+#if BDJ4_MEM_DEBUG
+  mdebugInit ("tsrvb");
+#endif
+
+  bdj4arg = bdj4argInit (argc, argv);
+
+  while ((c = getopt_long_only (argc, bdj4argGetArgv (bdj4arg),
+      "BV", bdj_options, &option_index)) != -1) {
+    switch (c) {
+      case 'B': {
+        isbdj4 = true;
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+  }
+
+  if (! isbdj4) {
+    fprintf (stderr, "not started with launcher\n");
+    bdj4argCleanup (bdj4arg);
+    return 1;
+  }
+
+  targ = bdj4argGet (bdj4arg, 0, argv [0]);
+  sysvarsInit (targ, SYSVARS_FLAG_ALL);
+  localeInit ();
+  bdjoptInit ();
+
+  for (int i = optind; i < argc; ++i) {
+    targ = bdj4argGet (bdj4arg, i, argv [i]);
+    if (argcount == 0) {
+      uri = targ;
+    }
+    if (argcount == 1) {
+      maxcount = atoi (targ);
+    }
+    if (argcount == 2) {
+      user = targ;
+    }
+    if (argcount == 3) {
+      pass = targ;
+    }
+    argcount++;
+  }
+
+  if (argcount < 2 || maxcount <= 0) {
+    fprintf (stderr, "Usage: tsrvbench <uri> <count> [<user> <pass>]\n");
+    bdjoptCleanup ();
+    localeCleanup ();
+    bdj4argCleanup (bdj4arg);
+    return 1;
+  }
+
+  logStart ("tsrvbench", "tsrvb", LOG_IMPORTANT | LOG_BASIC);
+
+  sb.bytes = 0;
+  sb.count = 0;
+  webclient = webclientAlloc (&sb, srvbenchCallback);
+  webclientIgnoreCertErr (webclient);
+  if (user != NULL && pass != NULL) {
+    webclientSetUserPass (webclient, user, pass);
+  }
+
+  mstimestart (&tm);
+  for (int i = 0; i < maxcount; ++i) {
+    rc = webclientGet (webclient, uri);
+    if (rc != 200) {
+      ++errcount;
+    }
+  }
+  elapsed = mstimeend (&tm);
+  if (elapsed <= 0) {
+    elapsed = 1;
+  }
+
+  fprintf (stdout, "requests: %d errors: %d bytes: %zu\n",
+      sb.count, errcount, sb.bytes);
+  fprintf (stdout, "time: %ld ms requests/sec: %.1f\n",
+      (long) elapsed, (double) sb.count * 1000.0 / (double) elapsed);
+
+  webclientClose (webclient);
+  logEnd ();
+  bdjoptCleanup ();
+  localeCleanup ();
+  bdj4argCleanup (bdj4arg);
+#if BDJ4_MEM_DEBUG
+  mdebugReport ();
+  mdebugCleanup ();
+#endif
+  return errcount == 0 ? 0 : 1;
+}
+
+static void
+srvbenchCallback (void *userdata, const char *resp, size_t len, time_t tm)
+{
+  srvbench_t    *sb = userdata;
+
+  sb->bytes += len;
+  ++sb->count;
+}
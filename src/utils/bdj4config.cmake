@@ -543,8 +543,10 @@ unset (CMAKE_REQUIRED_INCLUDES)
 check_symbol_exists (backtrace execinfo.h _lib_backtrace)
 check_symbol_exists (epoll_create1 sys/epoll.h _lib_epoll_create1)
 check_symbol_exists (fcntl fcntl.h _lib_fcntl)
+check_symbol_exists (fdopendir dirent.h _lib_fdopendir)
 check_symbol_exists (fork unistd.h _lib_fork)
 check_symbol_exists (fseeko stdio.h _lib_fseeko)
+check_symbol_exists (fstatat sys/stat.h _lib_fstatat)
 check_symbol_exists (fsync unistd.h _lib_fsync)
 check_symbol_exists (ftello stdio.h _lib_ftello)
 check_symbol_exists (getuid unistd.h _lib_getuid)
@@ -554,6 +556,7 @@ check_symbol_exists (epoll_create1 sys/epoll.h _lib_epoll_create1)
 check_symbol_exists (localtime_r time.h _lib_localtime_r)
 check_symbol_exists (mkdir sys/stat.h _lib_mkdir)
 check_symbol_exists (nanosleep time.h _lib_nanosleep)
+check_symbol_exists (posix_spawn spawn.h _lib_posix_spawn)
 check_symbol_exists (random stdlib.h _lib_random)
 check_symbol_exists (realpath stdlib.h _lib_realpath)
 check_symbol_exists (removexattr sys/xattr.h _lib_removexattr)